@@ -30,6 +30,9 @@
 // Enable UDP listening on demand in the WeaveDeviceManager
 #define WEAVE_CONFIG_DEVICE_MGR_DEMAND_ENABLE_UDP 1
 
+// Precompute the next epoch's message encryption application keys, as measured by TestMsgEnc
+#define WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS 1
+
 // Configure WDM for event offload
 #define WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD 1
 
@@ -39,6 +42,21 @@
 
 #define WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT 1
 
+// Let multi-threaded tools and tests log events through per-thread staging rings
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING 1
+
+// Build in the compact event header encoding; tools and tests enable it at run time
+#define WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING 1
+
+// Back event buffers with memory-mapped files where the tools ask for it
+#define WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE 1
+
+// Share encoded event lists between subscriptions fetching from the same event
+#define WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE 1
+
+// Summarize the event buffers so that event queries can skip over them
+#define WEAVE_CONFIG_EVENT_LOGGING_QUERY 1
+
 #define WDM_UPDATE_MAX_ITEMS_IN_TRAIT_DIRTY_PATH_STORE 300
 
 // Uncomment this for a large Tunnel MTU.
@@ -47,6 +65,22 @@
 // Max number of Bindings per WeaveExchangeManager
 #define WEAVE_CONFIG_MAX_BINDINGS 8
 
+// Build in support for Bindings to the same peer sharing a TCP connection and its session.
+// It stays off at run time unless enabled, as only TestSharedConnection and TestBinding --share-connection do.
+#define WEAVE_CONFIG_MAX_SHARED_CONNECTIONS 2
+
+// Build in support for deriving WRMP retransmission timeouts from the round trip time
+// measured to each peer. It stays off at run time unless enabled, as only TestWRMP -T 17 does.
+#define WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT 1
+
+// Build in support for acknowledging messages on several exchanges with the same peer in a
+// single WRMP message. It stays off at run time unless enabled, as only TestWRMP does.
+#define WEAVE_CONFIG_WRMP_ACK_AGGREGATION 1
+
+// Build in support for limiting unacknowledged WRMP messages to each peer to a congestion
+// window. It stays off at run time unless enabled, as only TestWRMP -T 19 does.
+#define WEAVE_CONFIG_WRMP_CONGESTION_CONTROL 1
+
 // Enable support functions for parsing command-line arguments
 #define WEAVE_CONFIG_ENABLE_ARG_PARSER 1
 
@@ -39,6 +39,7 @@
 #include <Weave/DeviceLayer/internal/EchoServer.h>
 #include <Weave/DeviceLayer/internal/EventLogging.h>
 #include <Weave/DeviceLayer/internal/BLEManager.h>
+#include <Weave/Support/PersistedStorageWriteBehind.h>
 #include <new>
 
 namespace nl {
@@ -83,6 +84,12 @@ WEAVE_ERROR GenericPlatformManagerImpl<ImplClass>::_InitWeaveStack(void)
     }
     SuccessOrExit(err);
 
+#if WEAVE_CONFIG_PERSISTED_STORAGE_ENABLE_WRITE_BEHIND
+    // Batch persisted counter writes before any counters are initialized.
+    err = PersistedStorageWriteBehind::GetInstance().Init(&SystemLayer, WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_INTERVAL_MSEC);
+    SuccessOrExit(err);
+#endif // WEAVE_CONFIG_PERSISTED_STORAGE_ENABLE_WRITE_BEHIND
+
     // Initialize the Weave Inet layer.
     new (&InetLayer) Inet::InetLayer();
     err = InetLayer.Init(SystemLayer, NULL);
@@ -279,7 +279,7 @@ void AsyncDNSResolverSockets::Resolve(DNSResolver &resolver)
     resolver.InitAddrInfoHints(gaiHints);
 
     // Call getaddrinfo() to perform the name resolution.
-    gaiReturnCode = getaddrinfo(resolver.asyncHostNameBuf, NULL, &gaiHints, &gaiResults);
+    gaiReturnCode = DNSResolver::GetAddrInfo(resolver.asyncHostNameBuf, gaiHints, &gaiResults);
 
     // Mutex protects the read and write operation on resolver->mState
     AsyncMutexLock();
@@ -0,0 +1,485 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements the cache of host name resolution results
+ *      consulted by InetLayer::ResolveHostAddress.
+ *
+ */
+
+#include <InetLayer/DNSCache.h>
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#include <string.h>
+#include <strings.h>
+
+#include <Weave/Support/CodeUtils.h>
+
+#include <InetLayer/InetLayer.h>
+
+namespace nl {
+namespace Inet {
+
+DNSCache::DNSCache(void)
+{
+    mInet              = NULL;
+    mTTL               = INET_CONFIG_DNS_CACHE_TTL_MSEC;
+    mNegativeTTL       = INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC;
+    mRefreshTime       = INET_CONFIG_DNS_CACHE_REFRESH_MSEC;
+    mRefreshInProgress = false;
+    memset(&mStats, 0, sizeof(mStats));
+    memset(mEntries, 0, sizeof(mEntries));
+}
+
+/**
+ * @brief   Prepare an empty cache for use by an InetLayer.
+ *
+ * @param[in]   inet    The InetLayer whose requests the cache serves.
+ */
+void DNSCache::Init(InetLayer & inet)
+{
+    mInet = &inet;
+    Shutdown();
+    ResetStats();
+}
+
+/**
+ * @brief   Forget every entry.
+ *
+ * @details
+ *  The owning InetLayer calls this method once its asynchronous resolver threads
+ *  have stopped. The requests waiting for a lookup are released without being
+ *  called back. The lookups themselves are marked canceled and left to be
+ *  released by their pending completion, which then finds no entry to update.
+ */
+void DNSCache::Shutdown(void)
+{
+    for (size_t i = 0; i < INET_CONFIG_DNS_CACHE_SIZE; i++)
+    {
+        Entry & entry = mEntries[i];
+        DNSResolver * waiter;
+        DNSResolver * next;
+
+        for (waiter = entry.Waiters; waiter != NULL; waiter = next)
+        {
+            next = waiter->pNextAsyncDNSResolver;
+            waiter->Release();
+        }
+
+        if (entry.Lookup != NULL)
+        {
+            entry.Lookup->OnComplete = NULL;
+            entry.Lookup->AppState   = NULL;
+            entry.Lookup->mState     = DNSResolver::kState_Canceled;
+        }
+    }
+
+    memset(mEntries, 0, sizeof(mEntries));
+    mRefreshInProgress = false;
+}
+
+/**
+ * @brief   Change how long results are kept and when they are refreshed.
+ *
+ * @param[in]   ttlMS           The time, in milliseconds, for which addresses are kept.
+ * @param[in]   negativeTTLMS   The time, in milliseconds, for which a host name that was not found
+ *                              is remembered, or 0 to not remember it.
+ * @param[in]   refreshMS       How long, in milliseconds, before the expiry of its addresses a
+ *                              requested host name is resolved again in the background, or 0 to
+ *                              disable background refresh.
+ *
+ * @details
+ *  The new times apply to results stored from then on.
+ */
+void DNSCache::SetTimeouts(uint32_t ttlMS, uint32_t negativeTTLMS, uint32_t refreshMS)
+{
+    mTTL         = ttlMS;
+    mNegativeTTL = negativeTTLMS;
+    mRefreshTime = refreshMS;
+}
+
+/**
+ * @brief   Discard every cached result, so that subsequent requests perform a lookup.
+ *
+ * @details
+ *  Lookups already in progress are left to complete the requests waiting for them.
+ */
+void DNSCache::Flush(void)
+{
+    for (size_t i = 0; i < INET_CONFIG_DNS_CACHE_SIZE; i++)
+    {
+        Entry & entry = mEntries[i];
+
+        if (entry.Lookup != NULL)
+        {
+            entry.Flags &= ~kFlag_HasResult;
+        }
+        else
+        {
+            entry.HostNameLen = 0;
+            entry.Flags       = 0;
+        }
+    }
+}
+
+/**
+ * @brief   Reset the counters returned by GetStats().
+ */
+void DNSCache::ResetStats(void)
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+/**
+ * @brief   Serve a prepared asynchronous resolution request from the cache.
+ *
+ * @param[in]   resolver    A resolver prepared by AsyncDNSResolverSockets::PrepareDNSResolver().
+ *
+ * @return  \c true if the cache took charge of the request, which then completes either
+ *          on the next turn of the event loop or with the lookup it waits for; \c false if
+ *          the caller must enqueue the request itself.
+ */
+bool DNSCache::Resolve(DNSResolver & resolver)
+{
+    const uint64_t now       = Weave::System::Layer::GetClock_MonotonicMS();
+    const uint16_t nameLen   = static_cast<uint16_t>(strlen(resolver.asyncHostNameBuf));
+    Entry * entry            = FindEntry(resolver.asyncHostNameBuf, nameLen, resolver.DNSOptions);
+    DNSResolver ** waiterRef;
+
+    if (entry != NULL && (entry->Flags & kFlag_HasResult) && now < entry->ExpiryTimeMS)
+    {
+        // Complete the request with the cached result once the caller has returned, as if
+        // the lookup had been performed.
+        VerifyOrExit(resolver.SystemLayer().ScheduleWork(HandleCachedResult, &resolver) == WEAVE_SYSTEM_NO_ERROR, );
+
+        CompleteRequest(entry->Error, entry->Addrs, entry->NumAddrs, resolver);
+        entry->LastUsedTimeMS = now;
+
+        if (entry->Error == INET_NO_ERROR)
+        {
+            mStats.Hits++;
+        }
+        else
+        {
+            mStats.NegativeHits++;
+        }
+
+        if (entry->Error == INET_NO_ERROR && entry->Lookup == NULL && !mRefreshInProgress &&
+            entry->ExpiryTimeMS - now <= mRefreshTime && StartLookup(*entry, mRefreshAddrs) == INET_NO_ERROR)
+        {
+            entry->Flags |= kFlag_Refreshing;
+            mRefreshInProgress = true;
+            mStats.Refreshes++;
+        }
+
+        return true;
+    }
+
+    if (entry == NULL)
+    {
+        entry = AllocEntry(now);
+        VerifyOrExit(entry != NULL, );
+
+        memcpy(entry->HostName, resolver.asyncHostNameBuf, nameLen + 1);
+        entry->HostNameLen = nameLen;
+        entry->Options     = resolver.DNSOptions;
+        entry->Flags       = 0;
+        entry->NumAddrs    = 0;
+        entry->Error       = INET_NO_ERROR;
+        entry->Waiters     = NULL;
+    }
+
+    if (entry->Lookup != NULL)
+    {
+        mStats.Coalesced++;
+    }
+    else
+    {
+        // The entry holds no result, or an expired one that no request reads any longer,
+        // so the lookup may resolve directly into it.
+        entry->Flags &= ~kFlag_HasResult;
+
+        if (StartLookup(*entry, entry->Addrs) != INET_NO_ERROR)
+        {
+            entry->HostNameLen = 0;
+            ExitNow();
+        }
+
+        mStats.Misses++;
+    }
+
+    // Queue the request behind any others waiting for the lookup.
+    for (waiterRef = &entry->Waiters; *waiterRef != NULL; waiterRef = &(*waiterRef)->pNextAsyncDNSResolver)
+        ;
+    resolver.pNextAsyncDNSResolver = NULL;
+    *waiterRef                     = &resolver;
+
+    entry->LastUsedTimeMS = now;
+
+    return true;
+
+exit:
+    mStats.Bypassed++;
+    return false;
+}
+
+DNSCache::Entry * DNSCache::FindEntry(const char * hostName, uint16_t hostNameLen, uint8_t options)
+{
+    for (size_t i = 0; i < INET_CONFIG_DNS_CACHE_SIZE; i++)
+    {
+        Entry & entry = mEntries[i];
+
+        if (entry.HostNameLen == hostNameLen && entry.Options == options && hostNameLen != 0 &&
+            strncasecmp(entry.HostName, hostName, hostNameLen) == 0)
+        {
+            return &entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Find an entry for a new host name: an unused one if possible, otherwise the
+ * least recently used entry with no lookup in progress, preferring expired ones.
+ */
+DNSCache::Entry * DNSCache::AllocEntry(uint64_t now)
+{
+    Entry * victim = NULL;
+
+    for (size_t i = 0; i < INET_CONFIG_DNS_CACHE_SIZE; i++)
+    {
+        Entry & entry = mEntries[i];
+        bool expired;
+
+        if (entry.HostNameLen == 0)
+        {
+            return &entry;
+        }
+
+        if (entry.Lookup != NULL)
+        {
+            continue;
+        }
+
+        expired = !(entry.Flags & kFlag_HasResult) || now >= entry.ExpiryTimeMS;
+
+        if (victim == NULL)
+        {
+            victim = &entry;
+            continue;
+        }
+
+        const bool victimExpired = !(victim->Flags & kFlag_HasResult) || now >= victim->ExpiryTimeMS;
+
+        if ((expired && !victimExpired) || (expired == victimExpired && entry.LastUsedTimeMS < victim->LastUsedTimeMS))
+        {
+            victim = &entry;
+        }
+    }
+
+    if (victim != NULL && (victim->Flags & kFlag_HasResult) && now < victim->ExpiryTimeMS)
+    {
+        mStats.Evictions++;
+    }
+
+    return victim;
+}
+
+/**
+ * Start a lookup of an entry's host name, resolving into the given array of
+ * #INET_CONFIG_DNS_CACHE_MAX_ADDRS addresses.
+ */
+INET_ERROR DNSCache::StartLookup(Entry & entry, IPAddress * addrArray)
+{
+    INET_ERROR err = INET_NO_ERROR;
+    DNSResolver * lookup;
+
+    lookup = DNSResolver::sPool.TryCreate(*mInet->SystemLayer());
+    VerifyOrExit(lookup != NULL, err = INET_ERROR_NO_MEMORY);
+
+    lookup->InitInetLayerBasis(*mInet);
+
+    err = mInet->mAsyncDNSResolver.PrepareDNSResolver(*lookup, entry.HostName, entry.HostNameLen, entry.Options,
+                                                      INET_CONFIG_DNS_CACHE_MAX_ADDRS, addrArray, HandleLookupComplete, this);
+    if (err != INET_NO_ERROR)
+    {
+        lookup->Release();
+        ExitNow();
+    }
+
+    entry.Lookup = lookup;
+
+    mInet->mAsyncDNSResolver.EnqueueRequest(*lookup);
+
+exit:
+    return err;
+}
+
+/**
+ * Store a result in a request, unless it has been canceled, leaving it ready for
+ * DNSResolver::HandleAsyncResolveComplete().
+ */
+void DNSCache::CompleteRequest(INET_ERROR err, const IPAddress * addrs, uint8_t numAddrs, DNSResolver & resolver)
+{
+    if (resolver.OnComplete == NULL || resolver.mState == DNSResolver::kState_Canceled)
+    {
+        return;
+    }
+
+    resolver.asyncDNSResolveResult = err;
+    resolver.NumAddrs              = 0;
+
+    if (err == INET_NO_ERROR)
+    {
+        CopyAddresses(addrs, numAddrs, resolver);
+    }
+
+    resolver.mState = DNSResolver::kState_Complete;
+}
+
+void DNSCache::CopyAddresses(const IPAddress * addrs, uint8_t numAddrs, DNSResolver & resolver)
+{
+    uint8_t count = (numAddrs < resolver.MaxAddrs) ? numAddrs : resolver.MaxAddrs;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        resolver.AddrArray[i] = addrs[i];
+    }
+
+#if INET_CONFIG_ENABLE_IPV4
+    // As DNSResolver::ProcessGetAddrInfoResult() does, keep at least one address of the
+    // secondary family when truncating a list ordered by family preference.
+    const uint8_t addrFamilyOption = (resolver.DNSOptions & kDNSOption_AddrFamily_Mask);
+
+    if ((addrFamilyOption == kDNSOption_AddrFamily_IPv4Preferred || addrFamilyOption == kDNSOption_AddrFamily_IPv6Preferred) &&
+        count > 1 && count < numAddrs && addrs[count - 1].Type() == addrs[0].Type())
+    {
+        for (uint8_t i = count; i < numAddrs; i++)
+        {
+            if (addrs[i].Type() != addrs[0].Type())
+            {
+                resolver.AddrArray[count - 1] = addrs[i];
+                break;
+            }
+        }
+    }
+#endif // INET_CONFIG_ENABLE_IPV4
+
+    resolver.NumAddrs = count;
+}
+
+void DNSCache::HandleLookupComplete(void * appState, INET_ERROR err, uint8_t addrCount, IPAddress * addrArray)
+{
+    DNSCache * cache    = static_cast<DNSCache *>(appState);
+    const uint64_t now  = Weave::System::Layer::GetClock_MonotonicMS();
+    Entry * entry       = NULL;
+    bool refreshed;
+    DNSResolver * waiters;
+    DNSResolver * waiter;
+    DNSResolver * next;
+
+    for (size_t i = 0; i < INET_CONFIG_DNS_CACHE_SIZE && entry == NULL; i++)
+    {
+        Entry & candidate = cache->mEntries[i];
+
+        if (candidate.Lookup == NULL)
+            continue;
+
+        if (candidate.Flags & kFlag_Refreshing)
+        {
+            if (addrArray == cache->mRefreshAddrs)
+                entry = &candidate;
+            continue;
+        }
+
+        if (addrArray == candidate.Addrs)
+            entry = &candidate;
+    }
+
+    VerifyOrExit(entry != NULL, );
+
+    waiters        = entry->Waiters;
+    entry->Waiters = NULL;
+    entry->Lookup  = NULL;
+    refreshed      = (entry->Flags & kFlag_Refreshing) != 0;
+
+    if (refreshed)
+    {
+        entry->Flags &= ~kFlag_Refreshing;
+        cache->mRefreshInProgress = false;
+
+        if (err == INET_NO_ERROR)
+        {
+            memcpy(entry->Addrs, cache->mRefreshAddrs, addrCount * sizeof(IPAddress));
+        }
+    }
+
+    if (err == INET_NO_ERROR)
+    {
+        entry->NumAddrs     = addrCount;
+        entry->Error        = INET_NO_ERROR;
+        entry->ExpiryTimeMS = now + cache->mTTL;
+        entry->Flags |= kFlag_HasResult;
+    }
+    // A failed refresh, even one that found no host, leaves the current addresses in place
+    // until they expire.
+    else if (err == INET_ERROR_HOST_NOT_FOUND && cache->mNegativeTTL > 0 && !refreshed)
+    {
+        entry->NumAddrs     = 0;
+        entry->Error        = err;
+        entry->ExpiryTimeMS = now + cache->mNegativeTTL;
+        entry->Flags |= kFlag_HasResult;
+    }
+
+    // Transient errors are not cached.
+    if (!(entry->Flags & kFlag_HasResult))
+    {
+        entry->HostNameLen = 0;
+    }
+
+    // Hand the result of the lookup to every waiting request before calling any of them
+    // back, since a callback may issue new requests that change the entry.
+    for (waiter = waiters; waiter != NULL; waiter = waiter->pNextAsyncDNSResolver)
+    {
+        CompleteRequest(err, entry->Addrs, (err == INET_NO_ERROR) ? addrCount : 0, *waiter);
+    }
+
+    for (waiter = waiters; waiter != NULL; waiter = next)
+    {
+        next = waiter->pNextAsyncDNSResolver;
+        waiter->HandleAsyncResolveComplete();
+    }
+
+exit:
+    return;
+}
+
+void DNSCache::HandleCachedResult(Weave::System::Layer * aLayer, void * aAppState, Weave::System::Error aError)
+{
+    DNSResolver * resolver = static_cast<DNSResolver *>(aAppState);
+
+    resolver->HandleAsyncResolveComplete();
+}
+
+} // namespace Inet
+} // namespace nl
+
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
@@ -0,0 +1,160 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines DNSCache, a bounded table of recent host name
+ *      resolution results that lets InetLayer answer repeated requests
+ *      without queuing them behind the asynchronous resolver threads.
+ *
+ */
+
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include <stdint.h>
+
+#include <InetLayer/InetConfig.h>
+#include <InetLayer/InetError.h>
+#include <InetLayer/IPAddress.h>
+#include <InetLayer/DNSResolver.h>
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#if !WEAVE_SYSTEM_CONFIG_USE_SOCKETS || !INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
+#error "INET_CONFIG_ENABLE_DNS_CACHE requires asynchronous DNS resolution on a sockets-based system"
+#endif
+
+namespace nl {
+namespace Inet {
+
+class InetLayer;
+
+/**
+ * @brief   Cache of host name resolution results, keyed by host name and DNS options.
+ *
+ * @details
+ *  A request for a host name whose result is in the cache and has not expired
+ *  completes with that result, on the next turn of the event loop, without
+ *  performing a lookup. This applies both to addresses and, for a shorter time,
+ *  to names that were not found.
+ *
+ *  Otherwise the cache starts a lookup of its own, with room for
+ *  #INET_CONFIG_DNS_CACHE_MAX_ADDRS addresses, and the request waits for it.
+ *  Further requests for the same name and options made while the lookup is in
+ *  progress wait for the same lookup rather than starting their own. When the
+ *  lookup completes, its result is stored and every waiting request is
+ *  completed with it, truncated to the number of addresses the request asked for.
+ *
+ *  A request that finds a result within #INET_CONFIG_DNS_CACHE_REFRESH_MSEC of
+ *  its expiry also starts a background lookup, whose result replaces the cached
+ *  one if it succeeds.
+ *
+ *  The times to live and the refresh time default to the configured values and
+ *  may be changed at run time with SetTimeouts().
+ *
+ *  Methods on this class are not thread-safe and must be called from the thread
+ *  that drives the owning InetLayer's event loop.
+ */
+class NL_DLL_EXPORT DNSCache
+{
+public:
+    /**
+     * @brief   Counters of how requests were served by the cache.
+     */
+    struct Stats
+    {
+        uint32_t Hits;          /**< Requests completed from cached addresses. */
+        uint32_t NegativeHits;  /**< Requests completed from a cached "host not found" result. */
+        uint32_t Misses;        /**< Requests that started a lookup. */
+        uint32_t Coalesced;     /**< Requests that waited for a lookup already in progress. */
+        uint32_t Refreshes;     /**< Background lookups started ahead of an entry's expiry. */
+        uint32_t Evictions;     /**< Unexpired entries replaced to make room for another host name. */
+        uint32_t Bypassed;      /**< Requests passed to the resolver uncached, for want of an entry or resolver. */
+    };
+
+    DNSCache(void);
+
+    void Init(InetLayer & inet);
+    void Shutdown(void);
+
+    void SetTimeouts(uint32_t ttlMS, uint32_t negativeTTLMS, uint32_t refreshMS);
+    void Flush(void);
+
+    const Stats & GetStats(void) const;
+    void ResetStats(void);
+
+private:
+    friend class InetLayer;
+
+    enum
+    {
+        kFlag_HasResult     = 0x01, /**< The entry holds a result, which may have expired. */
+        kFlag_Refreshing    = 0x02  /**< The lookup in progress was started ahead of expiry and resolves into mRefreshAddrs. */
+    };
+
+    struct Entry
+    {
+        char HostName[NL_DNS_HOSTNAME_MAX_LEN + 1];
+        uint16_t HostNameLen;
+        uint8_t Options;
+        uint8_t Flags;
+        uint8_t NumAddrs;
+        INET_ERROR Error;
+        uint64_t ExpiryTimeMS;
+        uint64_t LastUsedTimeMS;
+        DNSResolver * Lookup;           /**< The lookup in progress for this entry, if any. */
+        DNSResolver * Waiters;          /**< Requests waiting for the lookup, linked through pNextAsyncDNSResolver. */
+        IPAddress Addrs[INET_CONFIG_DNS_CACHE_MAX_ADDRS];
+    };
+
+    InetLayer * mInet;
+    Stats mStats;
+    uint32_t mTTL;
+    uint32_t mNegativeTTL;
+    uint32_t mRefreshTime;
+    bool mRefreshInProgress;
+    Entry mEntries[INET_CONFIG_DNS_CACHE_SIZE];
+    IPAddress mRefreshAddrs[INET_CONFIG_DNS_CACHE_MAX_ADDRS];
+
+    bool Resolve(DNSResolver & resolver);
+
+    Entry * FindEntry(const char * hostName, uint16_t hostNameLen, uint8_t options);
+    Entry * AllocEntry(uint64_t now);
+    INET_ERROR StartLookup(Entry & entry, IPAddress * addrArray);
+
+    static void CompleteRequest(INET_ERROR err, const IPAddress * addrs, uint8_t numAddrs, DNSResolver & resolver);
+    static void CopyAddresses(const IPAddress * addrs, uint8_t numAddrs, DNSResolver & resolver);
+    static void HandleLookupComplete(void * appState, INET_ERROR err, uint8_t addrCount, IPAddress * addrArray);
+    static void HandleCachedResult(Weave::System::Layer * aLayer, void * aAppState, Weave::System::Error aError);
+};
+
+/**
+ * @brief   Returns the counters of how requests were served since the last reset.
+ */
+inline const DNSCache::Stats & DNSCache::GetStats(void) const
+{
+    return mStats;
+}
+
+} // namespace Inet
+} // namespace nl
+
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#endif /* DNSCACHE_H */
@@ -219,7 +219,7 @@ INET_ERROR DNSResolver::Resolve(const char *hostName, uint16_t hostNameLen, uint
     InitAddrInfoHints(gaiHints);
 
     // Call getaddrinfo() to perform the name resolution.
-    gaiReturnCode = getaddrinfo(hostNameBuf, NULL, &gaiHints, &gaiResults);
+    gaiReturnCode = GetAddrInfo(hostNameBuf, gaiHints, &gaiResults);
 
     // Process the return code and results list returned by getaddrinfo(). If the call
     // was successful this will copy the resultant addresses into the caller's array.
@@ -349,6 +349,20 @@ void DNSResolver::LwIPHandleResolveComplete(const char *name, ip_addr_t *ipaddr,
 
 #if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 
+#if INET_CONFIG_TEST
+DNSResolver::GetAddrInfoFunct DNSResolver::sGetAddrInfo = NULL;
+#endif // INET_CONFIG_TEST
+
+int DNSResolver::GetAddrInfo(const char *hostName, const struct addrinfo & hints, struct addrinfo **results)
+{
+#if INET_CONFIG_TEST
+    if (sGetAddrInfo != NULL)
+        return sGetAddrInfo(hostName, NULL, &hints, results);
+#endif // INET_CONFIG_TEST
+
+    return getaddrinfo(hostName, NULL, &hints, results);
+}
+
 void DNSResolver::InitAddrInfoHints(struct addrinfo & hints)
 {
     uint8_t addrFamilyOption = (DNSOptions & kDNSOption_AddrFamily_Mask);
@@ -80,6 +80,9 @@ private:
 #if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 #if INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
     friend class AsyncDNSResolverSockets;
+#if INET_CONFIG_ENABLE_DNS_CACHE
+    friend class DNSCache;
+#endif // INET_CONFIG_ENABLE_DNS_CACHE
 
     /// States of the DNSResolver object with respect to hostname resolution.
     typedef enum DNSResolverState
@@ -135,6 +138,17 @@ private:
 
 #if WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 
+#if INET_CONFIG_TEST
+    /**
+     * @brief   Type of a function performing host name lookups in place of getaddrinfo().
+     */
+    typedef int (*GetAddrInfoFunct)(const char *hostName, const char *service, const struct addrinfo *hints,
+                                    struct addrinfo **results);
+
+    static GetAddrInfoFunct sGetAddrInfo;
+#endif // INET_CONFIG_TEST
+
+    static int GetAddrInfo(const char *hostName, const struct addrinfo & hints, struct addrinfo **results);
     void InitAddrInfoHints(struct addrinfo & hints);
     INET_ERROR ProcessGetAddrInfoResult(int returnCode, struct addrinfo * results);
     void CopyAddresses(int family, uint8_t maxAddrs, const struct addrinfo * addrs);
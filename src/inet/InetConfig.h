@@ -618,6 +618,97 @@
 #define INET_CONFIG_DNS_ASYNC_MAX_THREAD_COUNT             2
 #endif // INET_CONFIG_DNS_ASYNC_MAX_THREAD_COUNT
 
+/**
+ *  @def INET_CONFIG_ENABLE_DNS_CACHE
+ *
+ *  @brief
+ *    Defines whether (1) or not (0) the InetLayer caches the results
+ *    of host name resolution.
+ *
+ *  @details
+ *    Successful lookups are kept for #INET_CONFIG_DNS_CACHE_TTL_MSEC
+ *    and lookups that found no host for
+ *    #INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC. Concurrent requests for
+ *    the same host name share a single lookup.
+ *
+ *    Each lookup in progress occupies one object from the
+ *    #INET_CONFIG_NUM_DNS_RESOLVERS pool, in addition to the objects
+ *    of the requests waiting for it. When none is available, requests
+ *    bypass the cache.
+ *
+ *    This is only supported on sockets-based systems using
+ *    asynchronous resolution (#INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS).
+ */
+#ifndef INET_CONFIG_ENABLE_DNS_CACHE
+#define INET_CONFIG_ENABLE_DNS_CACHE                       0
+#endif // INET_CONFIG_ENABLE_DNS_CACHE
+
+/**
+ *  @def INET_CONFIG_DNS_CACHE_SIZE
+ *
+ *  @brief
+ *    The number of host names whose results are held by the DNS
+ *    cache. When the cache is full, the least recently used entry
+ *    that has no lookup in progress is replaced.
+ */
+#ifndef INET_CONFIG_DNS_CACHE_SIZE
+#define INET_CONFIG_DNS_CACHE_SIZE                         8
+#endif // INET_CONFIG_DNS_CACHE_SIZE
+
+/**
+ *  @def INET_CONFIG_DNS_CACHE_MAX_ADDRS
+ *
+ *  @brief
+ *    The maximum number of addresses held by the DNS cache for each
+ *    host name. Requests for more addresses than this are given at
+ *    most this many.
+ */
+#ifndef INET_CONFIG_DNS_CACHE_MAX_ADDRS
+#define INET_CONFIG_DNS_CACHE_MAX_ADDRS                    8
+#endif // INET_CONFIG_DNS_CACHE_MAX_ADDRS
+
+/**
+ *  @def INET_CONFIG_DNS_CACHE_TTL_MSEC
+ *
+ *  @brief
+ *    The time, in milliseconds, for which the DNS cache keeps the
+ *    addresses of a host name.
+ *
+ *  @note
+ *    getaddrinfo() does not report the time to live of the records
+ *    it returns, so this value should not exceed the smallest time
+ *    to live of the names the application resolves.
+ */
+#ifndef INET_CONFIG_DNS_CACHE_TTL_MSEC
+#define INET_CONFIG_DNS_CACHE_TTL_MSEC                     (60 * 1000)
+#endif // INET_CONFIG_DNS_CACHE_TTL_MSEC
+
+/**
+ *  @def INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC
+ *
+ *  @brief
+ *    The time, in milliseconds, for which the DNS cache remembers that
+ *    a host name was not found. Other resolution errors are never
+ *    cached.
+ */
+#ifndef INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC
+#define INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC            (5 * 1000)
+#endif // INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC
+
+/**
+ *  @def INET_CONFIG_DNS_CACHE_REFRESH_MSEC
+ *
+ *  @brief
+ *    When a host name is requested less than this many milliseconds
+ *    before its cached addresses expire, the DNS cache resolves it
+ *    again in the background so that later requests keep finding it
+ *    in the cache. At most one such refresh is in progress at a time.
+ *    A value of 0 disables background refresh.
+ */
+#ifndef INET_CONFIG_DNS_CACHE_REFRESH_MSEC
+#define INET_CONFIG_DNS_CACHE_REFRESH_MSEC                 (10 * 1000)
+#endif // INET_CONFIG_DNS_CACHE_REFRESH_MSEC
+
 /**
  *  @def INET_CONFIG_OVERRIDE_SYSTEM_TCP_USER_TIMEOUT
  *
@@ -744,6 +835,57 @@
 #ifndef INET_CONFIG_TCP_CONN_REPAIR_SUPPORTED
 #define INET_CONFIG_TCP_CONN_REPAIR_SUPPORTED              (0)
 #endif // INET_CONFIG_TCP_CONN_REPAIR_SUPPORTED
+
+/**
+ *  @def INET_CONFIG_ENABLE_INTERFACE_CACHE
+ *
+ *  @brief
+ *    Defines whether (1) or not (0) the InetLayer keeps a cached
+ *    table of the system network interfaces and their addresses.
+ *
+ *  @details
+ *    The table is refreshed when the kernel reports a link or
+ *    address change on an rtnetlink socket polled by the
+ *    InetLayer, so that multicast sends over all interfaces and
+ *    local address lookups need not query the system. When the
+ *    table is unavailable, the InterfaceIterator and
+ *    InterfaceAddressIterator classes are used instead.
+ *
+ *    This is only supported on Linux sockets-based systems.
+ */
+#ifndef INET_CONFIG_ENABLE_INTERFACE_CACHE
+#if WEAVE_SYSTEM_CONFIG_USE_SOCKETS && defined(__linux__)
+#define INET_CONFIG_ENABLE_INTERFACE_CACHE                 1
+#else
+#define INET_CONFIG_ENABLE_INTERFACE_CACHE                 0
+#endif
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
+/**
+ *  @def INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES
+ *
+ *  @brief
+ *    The maximum number of network interfaces held by the
+ *    interface cache. If the system has more, the cache is
+ *    disabled until the next change brings the count back
+ *    within this limit.
+ */
+#ifndef INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES
+#define INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES         16
+#endif // INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES
+
+/**
+ *  @def INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES
+ *
+ *  @brief
+ *    The maximum number of interface addresses held by the
+ *    interface cache. If the system has more, the cache is
+ *    disabled until the next change brings the count back
+ *    within this limit.
+ */
+#ifndef INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES
+#define INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES          48
+#endif // INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES
 // clang-format on
 
 #endif /* INETCONFIG_H */
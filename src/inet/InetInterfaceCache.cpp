@@ -0,0 +1,273 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a snapshot of the system network interfaces
+ *      and their addresses, refreshed on rtnetlink change notifications.
+ *
+ */
+
+#include <InetLayer/InetInterfaceCache.h>
+
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include <Weave/Support/CodeUtils.h>
+#include <Weave/Support/logging/WeaveLogging.h>
+
+#include <InetLayer/InetLayer.h>
+#include <InetLayer/IPPrefix.h>
+
+namespace nl {
+namespace Inet {
+
+InterfaceCache::InterfaceCache(void)
+{
+    mNotifySocket = INET_INVALID_SOCKET_FD;
+    mIsValid = false;
+    mNumInterfaces = 0;
+    mNumAddresses = 0;
+    mGeneration = 0;
+}
+
+/**
+ * @brief   Open the change notification socket and populate the table.
+ *
+ * @retval  INET_NO_ERROR           the cache is valid.
+ * @retval  INET_ERROR_NO_MEMORY    the system has more interfaces or addresses
+ *                                  than the cache can hold.
+ * @retval  other                   the notification socket could not be opened.
+ *
+ * @details
+ *     The socket is subscribed to link and address changes before the table is
+ *     first populated, so that no change can be missed between the two. On
+ *     failure the cache remains invalid and callers use the iterators instead.
+ */
+INET_ERROR InterfaceCache::Init(void)
+{
+    INET_ERROR err = INET_NO_ERROR;
+    struct sockaddr_nl sa;
+    int s;
+
+    VerifyOrExit(mNotifySocket == INET_INVALID_SOCKET_FD, err = INET_ERROR_INCORRECT_STATE);
+
+    s = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+    VerifyOrExit(s >= 0, err = Weave::System::MapErrorPOSIX(errno));
+    fcntl(s, F_SETFD, FD_CLOEXEC);
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+    if (bind(s, (struct sockaddr *) &sa, sizeof(sa)) != 0)
+    {
+        err = Weave::System::MapErrorPOSIX(errno);
+        close(s);
+        ExitNow();
+    }
+
+    mNotifySocket = s;
+
+    err = Refresh();
+
+exit:
+    if (err != INET_NO_ERROR)
+    {
+        WeaveLogError(Inet, "Interface cache unavailable: %s", nl::ErrorStr(err));
+    }
+    return err;
+}
+
+/**
+ * @brief   Close the change notification socket and invalidate the cache.
+ */
+void InterfaceCache::Shutdown(void)
+{
+    if (mNotifySocket != INET_INVALID_SOCKET_FD)
+    {
+        close(mNotifySocket);
+        mNotifySocket = INET_INVALID_SOCKET_FD;
+    }
+
+    mIsValid = false;
+    mNumInterfaces = 0;
+    mNumAddresses = 0;
+}
+
+/**
+ * @brief   Repopulate the table from the system interface and address lists.
+ *
+ * @details
+ *     The cache is only valid after a successful refresh while the change
+ *     notification socket is open; without the socket, nothing would tell
+ *     the cache that it had gone stale.
+ */
+INET_ERROR InterfaceCache::Refresh(void)
+{
+    INET_ERROR err = INET_NO_ERROR;
+
+    mIsValid = false;
+    mNumInterfaces = 0;
+    mNumAddresses = 0;
+    mGeneration++;
+
+    VerifyOrExit(mNotifySocket != INET_INVALID_SOCKET_FD, err = INET_ERROR_INCORRECT_STATE);
+
+    for (InterfaceIterator intfIter; intfIter.HasCurrent(); intfIter.Next())
+    {
+        VerifyOrExit(mNumInterfaces < INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES, err = INET_ERROR_NO_MEMORY);
+
+        Interface & intf = mInterfaces[mNumInterfaces];
+
+        intf.Id = intfIter.GetInterfaceId();
+        intf.Flags = (intfIter.IsUp() ? kFlag_Up : 0) |
+                     (intfIter.SupportsMulticast() ? kFlag_SupportsMulticast : 0) |
+                     (intfIter.HasBroadcastAddress() ? kFlag_HasBroadcast : 0);
+        mNumInterfaces++;
+    }
+
+    for (InterfaceAddressIterator addrIter; addrIter.HasCurrent(); addrIter.Next())
+    {
+        VerifyOrExit(mNumAddresses < INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES, err = INET_ERROR_NO_MEMORY);
+
+        Address & addr = mAddresses[mNumAddresses];
+
+        addr.Addr = addrIter.GetAddress();
+        addr.IntfId = addrIter.GetInterfaceId();
+        addr.PrefixLength = addrIter.GetPrefixLength();
+        addr.Flags = (addrIter.IsUp() ? kFlag_Up : 0) |
+                     (addrIter.SupportsMulticast() ? kFlag_SupportsMulticast : 0) |
+                     (addrIter.HasBroadcastAddress() ? kFlag_HasBroadcast : 0);
+        mNumAddresses++;
+    }
+
+    mIsValid = true;
+
+exit:
+    if (!mIsValid)
+    {
+        mNumInterfaces = 0;
+        mNumAddresses = 0;
+    }
+    return err;
+}
+
+/**
+ * @brief   Look up the interface to which an address is assigned.
+ *
+ * @return  \c true if the address was found, in which case \c intfId is set;
+ *          \c false otherwise.
+ */
+bool InterfaceCache::GetInterfaceFromAddr(const IPAddress & addr, InterfaceId & intfId) const
+{
+    for (uint16_t i = 0; i < mNumAddresses; i++)
+    {
+        if (mAddresses[i].Addr == addr)
+        {
+            intfId = mAddresses[i].IntfId;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Check whether an IPv6 address lies on the subnet of any cached,
+ *          non-link-local IPv6 interface address.
+ */
+bool InterfaceCache::MatchLocalIPv6Subnet(const IPAddress & addr) const
+{
+    for (uint16_t i = 0; i < mNumAddresses; i++)
+    {
+        IPPrefix addrPrefix;
+
+        addrPrefix.IPAddr = mAddresses[i].Addr;
+#if INET_CONFIG_ENABLE_IPV4
+        if (addrPrefix.IPAddr.IsIPv4())
+            continue;
+#endif // INET_CONFIG_ENABLE_IPV4
+        if (addrPrefix.IPAddr.IsIPv6LinkLocal())
+            continue;
+        addrPrefix.Length = mAddresses[i].PrefixLength;
+        if (addrPrefix.MatchAddress(addr))
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief   Add the change notification socket to the set of polled file descriptors.
+ */
+void InterfaceCache::PrepareSelect(struct pollfd * pollFDs, int & numPollFDs)
+{
+    SocketEvents events;
+
+    events.SetRead();
+    events.SetFDs(mNotifySocket, pollFDs, numPollFDs);
+}
+
+/**
+ * @brief   Refresh the table if the kernel has reported a link or address change.
+ *
+ * @details
+ *     Notifications are not parsed; any message, or an overrun of the socket's
+ *     receive queue, simply triggers a full refresh. Changes normally arrive in
+ *     bursts, and a single refresh covers every notification drained here.
+ */
+void InterfaceCache::HandleSelectResult(const struct pollfd * pollFDs, int numPollFDs)
+{
+    SocketEvents events = SocketEvents::FromFDs(mNotifySocket, pollFDs, numPollFDs);
+
+    if (events.IsReadable() || events.IsError())
+    {
+        DrainNotifications();
+        Refresh();
+    }
+}
+
+void InterfaceCache::DrainNotifications(void)
+{
+    uint8_t buf[4096];
+
+    while (true)
+    {
+        ssize_t rcvLen = recv(mNotifySocket, buf, sizeof(buf), MSG_DONTWAIT);
+
+        if (rcvLen > 0 || (rcvLen < 0 && (errno == EINTR || errno == ENOBUFS)))
+            continue;
+
+        break;
+    }
+}
+
+} // namespace Inet
+} // namespace nl
+
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
@@ -0,0 +1,160 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines a snapshot of the system network interfaces and
+ *      their addresses, kept current by rtnetlink change notifications, so
+ *      that interface and address lookups on hot paths need not query the
+ *      kernel.
+ *
+ */
+
+#ifndef INETINTERFACECACHE_H
+#define INETINTERFACECACHE_H
+
+#include <stdint.h>
+
+#include <InetLayer/InetConfig.h>
+#include <InetLayer/InetError.h>
+#include <InetLayer/IPAddress.h>
+#include <InetLayer/InetInterface.h>
+
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+
+struct pollfd;
+
+namespace nl {
+namespace Inet {
+
+/**
+ * @brief   Cached table of system network interfaces and interface addresses.
+ *
+ * @details
+ *  The table is populated with the InterfaceIterator and InterfaceAddressIterator
+ *  classes when the cache is initialized, and again whenever the kernel reports a
+ *  link or address change on the cache's rtnetlink socket, which the owning
+ *  InetLayer polls along with its endpoints.
+ *
+ *  The cache is only usable while IsValid() returns \c true; that is, while the
+ *  change notification socket is open and the most recent refresh fit within
+ *  #INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES and
+ *  #INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES. Otherwise, callers must fall back
+ *  to the iterators.
+ *
+ *  Methods on this class are not thread-safe and must be called from the thread
+ *  that drives the owning InetLayer's event loop.
+ */
+class NL_DLL_EXPORT InterfaceCache
+{
+public:
+    enum
+    {
+        kFlag_Up                = 0x01,
+        kFlag_SupportsMulticast = 0x02,
+        kFlag_HasBroadcast      = 0x04
+    };
+
+    struct Interface
+    {
+        InterfaceId Id;
+        uint8_t Flags;
+    };
+
+    struct Address
+    {
+        IPAddress Addr;
+        InterfaceId IntfId;
+        uint8_t PrefixLength;
+        uint8_t Flags;
+    };
+
+    InterfaceCache(void);
+
+    INET_ERROR Init(void);
+    void Shutdown(void);
+    INET_ERROR Refresh(void);
+
+    bool IsValid(void) const;
+    uint32_t GetGeneration(void) const;
+
+    uint16_t NumInterfaces(void) const;
+    const Interface & GetInterface(uint16_t index) const;
+    uint16_t NumAddresses(void) const;
+    const Address & GetAddress(uint16_t index) const;
+
+    bool GetInterfaceFromAddr(const IPAddress & addr, InterfaceId & intfId) const;
+    bool MatchLocalIPv6Subnet(const IPAddress & addr) const;
+
+    void PrepareSelect(struct pollfd * pollFDs, int & numPollFDs);
+    void HandleSelectResult(const struct pollfd * pollFDs, int numPollFDs);
+
+private:
+    int mNotifySocket;
+    bool mIsValid;
+    uint16_t mNumInterfaces;
+    uint16_t mNumAddresses;
+    uint32_t mGeneration;
+    Interface mInterfaces[INET_CONFIG_INTERFACE_CACHE_MAX_INTERFACES];
+    Address mAddresses[INET_CONFIG_INTERFACE_CACHE_MAX_ADDRESSES];
+
+    void DrainNotifications(void);
+};
+
+/**
+ * @brief   Returns whether the cached table may be used in place of the iterators.
+ */
+inline bool InterfaceCache::IsValid(void) const
+{
+    return mIsValid;
+}
+
+/**
+ * @brief   Returns a counter that advances each time the table is refreshed.
+ */
+inline uint32_t InterfaceCache::GetGeneration(void) const
+{
+    return mGeneration;
+}
+
+inline uint16_t InterfaceCache::NumInterfaces(void) const
+{
+    return mNumInterfaces;
+}
+
+inline const InterfaceCache::Interface & InterfaceCache::GetInterface(uint16_t index) const
+{
+    return mInterfaces[index];
+}
+
+inline uint16_t InterfaceCache::NumAddresses(void) const
+{
+    return mNumAddresses;
+}
+
+inline const InterfaceCache::Address & InterfaceCache::GetAddress(uint16_t index) const
+{
+    return mAddresses[index];
+}
+
+} // namespace Inet
+} // namespace nl
+
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
+#endif /* INETINTERFACECACHE_H */
@@ -312,6 +312,16 @@ INET_ERROR InetLayer::Init(Weave::System::Layer& aSystemLayer, void *aContext)
     SuccessOrExit(err);
 
 #endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+    mDNSCache.Init(*this);
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    // Failure to set up the interface cache is not fatal; lookups fall back
+    // to querying the system.
+    mInterfaceCache.Init();
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
 #endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 
  exit:
@@ -359,6 +369,10 @@ INET_ERROR InetLayer::Shutdown(void)
         err = mAsyncDNSResolver.Shutdown();
 
 #endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS && INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
+
+#if INET_CONFIG_ENABLE_DNS_CACHE
+        mDNSCache.Shutdown();
+#endif // INET_CONFIG_ENABLE_DNS_CACHE
 #endif // INET_CONFIG_ENABLE_DNS_RESOLVER
 
 #if INET_CONFIG_ENABLE_RAW_ENDPOINT
@@ -397,6 +411,10 @@ INET_ERROR InetLayer::Shutdown(void)
         }
 #endif // INET_CONFIG_ENABLE_UDP_ENDPOINT
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+        mInterfaceCache.Shutdown();
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
 #if INET_CONFIG_PROVIDE_OBSOLESCENT_INTERFACES
         if (mSystemLayer == &mImplicitSystemLayer)
         {
@@ -919,6 +937,7 @@ INET_ERROR InetLayer::ResolveHostAddress(const char *hostName, uint16_t hostName
 
     // After this point, the resolver will be released by:
     // - mAsyncDNSResolver (in case of ASYNC_DNS_SOCKETS)
+    // - mDNSCache, when the request is completed from, or waits on, the cache
     // - resolver->Resolve() (in case of synchronous resolving)
     // - the event handlers (in case of LwIP)
 
@@ -928,6 +947,13 @@ INET_ERROR InetLayer::ResolveHostAddress(const char *hostName, uint16_t hostName
                                                maxAddrs, addrArray, onComplete, appState);
     SuccessOrExit(err);
 
+#if INET_CONFIG_ENABLE_DNS_CACHE
+    // Complete the request from the cache, or have it wait for a lookup started by the cache,
+    // unless the cache has no room for it.
+    if (mDNSCache.Resolve(*resolver))
+        ExitNow();
+#endif // INET_CONFIG_ENABLE_DNS_CACHE
+
     mAsyncDNSResolver.EnqueueRequest(*resolver);
 
 #endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS && INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
@@ -1109,6 +1135,17 @@ void InetLayer::CancelTimer(TimerCompleteFunct aComplete, void* aAppState)
  */
 INET_ERROR InetLayer::GetInterfaceFromAddr(const IPAddress& addr, InterfaceId& intfId)
 {
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    const InterfaceCache* intfCache = GetInterfaceCache();
+
+    if (intfCache != NULL)
+    {
+        if (!intfCache->GetInterfaceFromAddr(addr, intfId))
+            intfId = INET_NULL_INTERFACEID;
+        return INET_NO_ERROR;
+    }
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
     InterfaceAddressIterator addrIter;
 
     for (; addrIter.HasCurrent(); addrIter.Next())
@@ -1140,6 +1177,13 @@ bool InetLayer::MatchLocalIPv6Subnet(const IPAddress& addr)
     if (addr.IsIPv6LinkLocal())
         return true;
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    const InterfaceCache* intfCache = GetInterfaceCache();
+
+    if (intfCache != NULL)
+        return intfCache->MatchLocalIPv6Subnet(addr);
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
     InterfaceAddressIterator ifAddrIter;
     for ( ; ifAddrIter.HasCurrent(); ifAddrIter.Next())
     {
@@ -1457,6 +1501,10 @@ void InetLayer::PrepareSelect(struct pollfd * pollFDs, int& numPollFDs, int& tim
     }
 #endif // INET_CONFIG_ENABLE_TUN_ENDPOINT
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    mInterfaceCache.PrepareSelect(pollFDs, numPollFDs);
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
 #if INET_CONFIG_PROVIDE_OBSOLESCENT_INTERFACES
     if (mSystemLayer == &mImplicitSystemLayer)
     {
@@ -1490,6 +1538,12 @@ void InetLayer::HandleSelectResult(const struct pollfd * pollFDs, int numPollFDs
     if (State != kState_Initialized)
         return;
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+        // Bring the interface cache up to date before any endpoint handles its I/O, so that
+        // lookups made from endpoint callbacks see the current interfaces and addresses.
+        mInterfaceCache.HandleSelectResult(pollFDs, numPollFDs);
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
         // Set the pending I/O field for each active endpoint based on the value returned by select.
 #if INET_CONFIG_ENABLE_RAW_ENDPOINT
         for (size_t i = 0; i < RawEndPoint::sPool.Size(); i++)
@@ -62,11 +62,13 @@
 #include <InetLayer/IPAddress.h>
 #include <InetLayer/IPPrefix.h>
 #include <InetLayer/InetInterface.h>
+#include <InetLayer/InetInterfaceCache.h>
 #include <InetLayer/InetLayerBasis.h>
 #include <InetLayer/InetLayerEvents.h>
 
 #if INET_CONFIG_ENABLE_DNS_RESOLVER
 #include <InetLayer/DNSResolver.h>
+#include <InetLayer/DNSCache.h>
 #endif // INET_CONFIG_ENABLE_DNS_RESOLVER
 
 #if INET_CONFIG_ENABLE_RAW_ENDPOINT
@@ -243,6 +245,16 @@ class NL_DLL_EXPORT InetLayer
             DNSResolveCompleteFunct onComplete, void *appState);
     void CancelResolveHostAddress(DNSResolveCompleteFunct onComplete, void *appState);
 
+#if INET_CONFIG_ENABLE_DNS_CACHE
+    DNSCache& GetDNSCache(void);
+#endif // INET_CONFIG_ENABLE_DNS_CACHE
+
+#if INET_CONFIG_TEST && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+    typedef DNSResolver::GetAddrInfoFunct DNSGetAddrInfoFunct;
+
+    static void SetDNSGetAddrInfoFunct(DNSGetAddrInfoFunct aGetAddrInfo);
+#endif // INET_CONFIG_TEST && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
 #endif // INET_CONFIG_ENABLE_DNS_RESOLVER
 
     INET_ERROR GetInterfaceFromAddr(const IPAddress& addr, InterfaceId& intfId);
@@ -250,6 +262,10 @@ class NL_DLL_EXPORT InetLayer
     INET_ERROR GetLinkLocalAddr(InterfaceId link, IPAddress *llAddr);
     bool MatchLocalIPv6Subnet(const IPAddress& addr);
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    const InterfaceCache* GetInterfaceCache(void) const;
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
 #if INET_CONFIG_PROVIDE_OBSOLESCENT_INTERFACES
     /**
      *  @brief
@@ -372,6 +388,15 @@ private:
     AsyncDNSResolverSockets mAsyncDNSResolver;
 #endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_ASYNC_DNS_SOCKETS
 
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+    DNSCache                mDNSCache;
+
+    friend class DNSCache;
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    InterfaceCache          mInterfaceCache;
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
 
 #endif // WEAVE_SYSTEM_CONFIG_USE_SOCKETS
 
@@ -399,6 +424,45 @@ inline Weave::System::Layer* InetLayer::SystemLayer(void) const
     return mSystemLayer;
 }
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+/**
+ *  Get the cached table of network interfaces and addresses.
+ *
+ *  @return A pointer to the table, or NULL if the table is currently
+ *          unavailable, in which case the caller should use the
+ *          InterfaceIterator and InterfaceAddressIterator classes.
+ */
+inline const InterfaceCache* InetLayer::GetInterfaceCache(void) const
+{
+    return (State == kState_Initialized && mInterfaceCache.IsValid()) ? &mInterfaceCache : NULL;
+}
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+/**
+ *  Get the cache of host name resolution results consulted by
+ *  ResolveHostAddress(), for its statistics or to flush it.
+ */
+inline DNSCache& InetLayer::GetDNSCache(void)
+{
+    return mDNSCache;
+}
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_TEST && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+/**
+ *  Have host name resolution call a stub function in place of
+ *  getaddrinfo(), for testing.
+ *
+ *  @param[in]  aGetAddrInfo    The function to call, or NULL to
+ *                              restore the use of getaddrinfo().
+ */
+inline void InetLayer::SetDNSGetAddrInfoFunct(DNSGetAddrInfoFunct aGetAddrInfo)
+{
+    DNSResolver::sGetAddrInfo = aGetAddrInfo;
+}
+#endif // INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_TEST && WEAVE_SYSTEM_CONFIG_USE_SOCKETS
+
 #if INET_CONFIG_PROVIDE_OBSOLESCENT_INTERFACES
 inline INET_ERROR InetLayer::Init(void* aContext)
 {
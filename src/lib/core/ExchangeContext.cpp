@@ -67,6 +67,8 @@ enum {
     kFlagAutoReleaseConnection  = 0x0200, /// Automatically release the associated WeaveConnection when the exchange context is freed.
     kFlagUseEphemeralUDPPort    = 0x0400, /// When set, use the local ephemeral UDP port as the source port for outbound messages.
     kFlagCaptureSentMessage     = 0x0800, /// Capture the sent message after encoded with Weave headers.
+    kFlagFixedRetransTimeout    = 0x1000, /// When set, use the configured retransmit timeouts rather than ones derived from the peer's round trip time.
+    kFlagPeerAcceptsAckLists    = 0x2000, /// When set, the peer has advertised that it accepts WRMP Ack List messages.
 };
 
 /**
@@ -236,10 +238,32 @@ static inline bool IsWRMPControlMessage(uint32_t profileId, uint8_t msgType)
 {
     return (profileId == nl::Weave::Profiles::kWeaveProfile_Common &&
             (msgType == nl::Weave::Profiles::Common::kMsgType_WRMP_Throttle_Flow ||
-             msgType == nl::Weave::Profiles::Common::kMsgType_WRMP_Delayed_Delivery));
+             msgType == nl::Weave::Profiles::Common::kMsgType_WRMP_Delayed_Delivery ||
+             msgType == nl::Weave::Profiles::Common::kMsgType_WRMP_Ack_List));
 }
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+/**
+ *  Determine whether the peer has advertised that it accepts acknowledgments
+ *  for several exchanges in a single WRMP Ack List message.
+ *
+ *  @return Returns 'true' if the peer accepts Ack List messages, else 'false'.
+ *
+ */
+bool ExchangeContext::PeerAcceptsAckLists(void) const
+{
+    return GetFlag(mFlags, static_cast<uint16_t>(kFlagPeerAcceptsAckLists));
+}
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
 
+static inline bool IsWRMPAckMessage(uint32_t profileId, uint8_t msgType)
+{
+    return (profileId == nl::Weave::Profiles::kWeaveProfile_Common &&
+            (msgType == nl::Weave::Profiles::Common::kMsgType_Null ||
+             msgType == nl::Weave::Profiles::Common::kMsgType_WRMP_Ack_List));
+}
+
 /**
  *  Set whether a response is expected on this exchange.
  *
@@ -436,6 +460,9 @@ WEAVE_ERROR ExchangeContext::SendMessage(uint32_t profileId, uint8_t msgType, Pa
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     WeaveExchangeManager::RetransTableEntry *entry = NULL;
 #endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    bool wasAckPending = IsAckPending();
+#endif
 
 #if WEAVE_RETAIN_LOGGING
     uint16_t payloadLen = msgBuf->DataLength();
@@ -611,15 +638,43 @@ WEAVE_ERROR ExchangeContext::SendMessage(uint32_t profileId, uint8_t msgType, Pa
             // Copy msg to a right-sized buffer if applicable
             msgBuf = PacketBuffer::RightSize(msgBuf);
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            bool canSend = ExchangeMgr->WRMPCanSendToPeer(PeerNodeId);
+#endif
+
             //Add to Table for subsequent sending
             err = ExchangeMgr->AddToRetransTable(this, msgBuf, msgInfo->MessageId, msgCtxt, &entry);
             SuccessOrExit(err);
             msgBuf = NULL;
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            if (!canSend)
+            {
+                // The peer's congestion window is full; leave the message in the table to be
+                // sent once acknowledgments make room for it.
+                WeaveLogDetail(ExchangeManager, "Holding MsgId:%08" PRIX32 " to %016" PRIX64 " until congestion window opens",
+                               msgInfo->MessageId, PeerNodeId);
+
+                // The ack piggybacked on the held message will not reach the peer in time; send it on its own.
+                if (wasAckPending)
+                {
+                    SetAckPending(true);
+                    ExchangeMgr->WRMPStartTimer();
+                }
+
+                ExitNow();
+            }
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
             err = ExchangeMgr->SendFromRetransTable(entry);
             sendCalled = true;
             SuccessOrExit(err);
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            // The timer skipped the entry while it was unsent; arm it for the retransmission.
+            ExchangeMgr->WRMPStartTimer();
+#endif
+
             WEAVE_FAULT_INJECT(FaultInjection::kFault_WRMDoubleTx,
                                entry->nextRetransTime = 0;
                                ExchangeMgr->WRMPStartTimer()
@@ -657,6 +712,15 @@ exit:
                        "sent", profileId, msgType, (int)payloadLen, msgInfo->DestNodeId,
                        (Con ? Con->LogId() : 0), ExchangeId, (long)err, msgInfo->MessageId);
     }
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    // Send the acks pending on other exchanges with the peer right behind this message, provided
+    // that one Ack List replaces at least two solitary acks. With message coalescing enabled both
+    // messages go out in the same datagram.
+    if (err == WEAVE_NO_ERROR && sendCalled && !IsWRMPAckMessage(profileId, msgType))
+    {
+        ExchangeMgr->WRMPSendAckList(this, 2);
+    }
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
     if (err != WEAVE_NO_ERROR && IsResponseExpected())
     {
         CancelResponseTimer();
@@ -706,6 +770,13 @@ WEAVE_ERROR ExchangeContext::SendCommonNullMessage(void)
                       kSendFlag_NoAutoRequestAck);
     msgBuf = NULL;
 
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    if (err == WEAVE_NO_ERROR)
+    {
+        ExchangeMgr->mWRMPAckStats.SolitaryAcksSent++;
+    }
+#endif
+
 exit:
     if (WeaveMessageLayer::IsSendErrorNonCritical(err))
     {
@@ -772,6 +843,11 @@ WEAVE_ERROR ExchangeContext::EncodeExchHeader(WeaveExchangeHeader *exchangeHeade
             exchangeHeader->Flags |= kWeaveExchangeFlag_AckId;
             exchangeHeader->AckMsgId = mPendingPeerAckId;
 
+            if (IsAckPending() && !IsWRMPAckMessage(profileId, msgType))
+            {
+                ExchangeMgr->mWRMPAckStats.PiggybackedAcksSent++;
+            }
+
             //Set AckPending flag to false after setting the Ack flag;
             SetAckPending(false);
 
@@ -789,6 +865,14 @@ WEAVE_ERROR ExchangeContext::EncodeExchHeader(WeaveExchangeHeader *exchangeHeade
         {
             exchangeHeader->Flags |= kWeaveExchangeFlag_NeedsAck;
         }
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+        //Advertise that acks for this node may be aggregated into Ack List messages;
+        if (ExchangeMgr->AckAggregationEnabled())
+        {
+            exchangeHeader->Flags |= kWeaveExchangeFlag_AckListSupported;
+        }
+#endif
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     }
 
@@ -926,9 +1010,8 @@ void ExchangeContext::Release(void)
 
         DoClose(false);
         mRefCount = 0;
-        ExchangeMgr = NULL;
+        em->FreeContext(this);
 
-        em->mContextsInUse--;
         em->MessageLayer->SignalMessageLayerActivityChanged();
 #if defined(WEAVE_EXCHANGE_CONTEXT_DETAIL_LOGGING)
         WeaveLogProgress(ExchangeManager, "ec-- id: %d [%04" PRIX16 "], inUse: %d, addr: 0x%x", EXCHANGE_CONTEXT_ID(this - em->ContextPool), tmpid,  em->mContextsInUse, this);
@@ -1195,6 +1278,26 @@ bool ExchangeContext::WRMPCheckAndRemRetransTable(uint32_t ackMsgId, void **rCtx
             //Return context value
             *rCtxt = ExchangeMgr->RetransTable[i].msgCtxt;
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+            // Only a message that was sent once yields an unambiguous round trip
+            // time; the ack of a retransmitted message may answer any of its copies.
+            if (ExchangeMgr->AdaptiveRetransTimeoutEnabled() && ExchangeMgr->RetransTable[i].sendCount != 0 &&
+                !ExchangeMgr->RetransTable[i].retransmitted)
+            {
+                uint32_t rtt = static_cast<uint32_t>(System::Timer::GetCurrentEpoch()) - ExchangeMgr->RetransTable[i].sendTime;
+
+                ExchangeMgr->FabricState->UpdatePeerRoundTripTime(PeerNodeId, rtt);
+            }
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            // Every acknowledgment opens the peer's congestion window a little.
+            if (ExchangeMgr->CongestionControlEnabled())
+            {
+                ExchangeMgr->FabricState->GrowPeerCongestionWindow(PeerNodeId);
+            }
+#endif
+
             //Clear the entry from the retransmision table.
             ExchangeMgr->ClearRetransmitTable(ExchangeMgr->RetransTable[i]);
 
@@ -1241,14 +1344,58 @@ WEAVE_ERROR ExchangeContext::WRMPFlushAcks(void)
  *  the active retransmit timeout based on whether the ExchangeContext has
  *  an active message exchange going with its peer.
  *
+ *  When adaptive retransmit timeouts are enabled (see
+ *  WeaveExchangeManager::SetAdaptiveRetransTimeoutEnabled()), the timeout
+ *  is instead derived from the round trip times measured to the peer, once
+ *  there are any, and is backed off while messages to the peer go
+ *  unacknowledged; see WeaveFabricState::GetPeerRetransTimeout().
+ *
  *  @return the current retransmit time.
  */
 uint32_t ExchangeContext::GetCurrentRetransmitTimeout(void)
 {
-  return (HasRcvdMsgFromPeer() ? mWRMPConfig.mActiveRetransTimeout :
-                                 mWRMPConfig.mInitialRetransTimeout);
+    uint32_t timeout = (HasRcvdMsgFromPeer() ? mWRMPConfig.mActiveRetransTimeout :
+                                               mWRMPConfig.mInitialRetransTimeout);
+
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    if (ExchangeMgr->AdaptiveRetransTimeoutEnabled() && !UseFixedRetransTimeout())
+    {
+        timeout = ExchangeMgr->FabricState->GetPeerRetransTimeout(PeerNodeId, timeout);
+    }
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+    return timeout;
 }
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+/**
+ *  Set whether the exchange retransmits after the configured initial and
+ *  active retransmit timeouts, rather than after timeouts derived from the
+ *  round trip times measured to its peer.
+ *
+ *  @param[in]  inFixedRetransTimeout  A Boolean indicating whether (true) or
+ *                                     not (false) the configured retransmit
+ *                                     timeouts are used.
+ *
+ */
+void ExchangeContext::SetUseFixedRetransTimeout(bool inFixedRetransTimeout)
+{
+    SetFlag(mFlags, static_cast<uint16_t>(kFlagFixedRetransTimeout), inFixedRetransTimeout);
+}
+
+/**
+ *  Determine whether the exchange retransmits after the configured initial
+ *  and active retransmit timeouts.
+ *
+ *  @return Returns 'true' if the configured timeouts are used, else 'false'.
+ *
+ */
+bool ExchangeContext::UseFixedRetransTimeout(void) const
+{
+    return GetFlag(mFlags, static_cast<uint16_t>(kFlagFixedRetransTimeout));
+}
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
 /**
  *  Send a Throttle Flow message to the peer node requesting it to throttle its sending of messages.
  *
@@ -1400,6 +1547,11 @@ WEAVE_ERROR ExchangeContext::WRMPHandleRcvdAck(const WeaveExchangeHeader *exchHe
             WeaveLogDetail(ExchangeManager,
                            "No App Handler for Ack");
         }
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+        // Send messages that were waiting for the room this ack made in the congestion window.
+        ExchangeMgr->WRMPSendQueuedMessages();
+#endif
 #if defined(DEBUG)
         WeaveLogProgress(ExchangeManager, "Removed Weave MsgId:%08" PRIX32 " from RetransTable",
                          exchHeader->AckMsgId);
@@ -1483,6 +1635,13 @@ WEAVE_ERROR ExchangeContext::HandleThrottleFlow(uint32_t PauseTimeMillis)
     {
         mWRMPThrottleTimeout = ExchangeMgr->GetTickCounterFromTimeDelta((System::Timer::GetCurrentEpoch() + PauseTimeMillis),
                                                                         ExchangeMgr->mWRMPTimeStampBase);
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+        // A peer that asks for the flow to be throttled is congested; slow down like for a loss.
+        if (ExchangeMgr->CongestionControlEnabled())
+        {
+            ExchangeMgr->FabricState->ShrinkPeerCongestionWindow(PeerNodeId);
+        }
+#endif
     }
     else
     {
@@ -1574,6 +1733,10 @@ WEAVE_ERROR ExchangeContext::HandleMessage(WeaveMessageInfo *msgInfo, const Weav
     if (msgInfo->MessageVersion == kWeaveMessageVersion_V2)
     {
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+        SetFlag(mFlags, static_cast<uint16_t>(kFlagPeerAcceptsAckLists),
+                (exchHeader->Flags & kWeaveExchangeFlag_AckListSupported) != 0);
+#endif
         if (exchHeader->Flags & kWeaveExchangeFlag_AckId)
         {
             err = WRMPHandleRcvdAck(exchHeader, msgInfo);
@@ -1612,9 +1775,8 @@ WEAVE_ERROR ExchangeContext::HandleMessage(WeaveMessageInfo *msgInfo, const Weav
         ExitNow(err = WEAVE_NO_ERROR);
 #endif
     }
-    //Return and not pass this to Application if Common::Null Msg Type
-    else if ((exchHeader->ProfileId == nl::Weave::Profiles::kWeaveProfile_Common) &&
-        (exchHeader->MessageType == nl::Weave::Profiles::Common::kMsgType_Null))
+    //Return and not pass this to Application if Common::Null or Common::WRMP Ack List Msg Type
+    else if (IsWRMPAckMessage(exchHeader->ProfileId, exchHeader->MessageType))
     {
         ExitNow(err = WEAVE_NO_ERROR);
     }
@@ -372,6 +372,16 @@ void Binding::DoReset(State newState)
         mExchangeManager->MessageLayer->Inet->CancelResolveHostAddress(OnResolveComplete, this);
     }
 
+#endif
+
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+    // If the connection is shared with other bindings, give up this binding's use of it.
+    if (GetFlag(kFlag_ShareConnection) && GetFlag(kFlag_ConnectionReferenced))
+    {
+        LeaveSharedConnection();
+    }
+
 #endif
 
     // Release the reference to the connection object, if held.  Block any callback to our
@@ -657,6 +667,22 @@ void Binding::PrepareTransport()
     // If the application has requested TCP, and no existing connection has been supplied...
     if (mTransportOption == kTransport_TCP && mCon == NULL)
     {
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+        // If the application has asked to share connections, and another binding has established
+        // or is establishing a suitable one, use that connection.
+        if (GetFlag(kFlag_ShareConnection))
+        {
+            SharedConnection * sharedCon = FindSharedConnection();
+            if (sharedCon != NULL)
+            {
+                JoinSharedConnection(*sharedCon);
+                ExitNow();
+            }
+        }
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
         // Construct a new WeaveConnection object.  This method implicitly establishes a reference
         // to the connection object, which will be owned by the Binding until it is closed or fails.
         mCon = mExchangeManager->MessageLayer->NewConnection();
@@ -678,6 +704,16 @@ void Binding::PrepareTransport()
         // would result in a double release.  Thus we suppress that here.
         mCon->OnConnectionClosed = NULL;
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+        // Offer the new connection to other bindings that ask to share one.
+        if (GetFlag(kFlag_ShareConnection))
+        {
+            AddSharedConnection();
+        }
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
         mState = kState_PreparingTransport_TCPConnect;
 
         // Initiate a connection to the peer.
@@ -875,6 +911,9 @@ void Binding::HandleBindingReady()
 {
     InEventParam inParam;
     OutEventParam outParam;
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    WeaveConnection *publishedCon = NULL;
+#endif
 
     // Should never be called in anything other than a preparing state.
     VerifyOrDie(IsPreparing());
@@ -882,6 +921,16 @@ void Binding::HandleBindingReady()
     // Transition to the Ready state.
     mState = kState_Ready;
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+    // If this binding has established a shared connection, mark it ready for use by other bindings.
+    if (GetFlag(kFlag_ShareConnection) && PublishSharedConnection())
+    {
+        publishedCon = mCon;
+    }
+
+#endif
+
 #if WEAVE_DETAIL_LOGGING
     {
         char peerDesc[kGetPeerDescription_MaxLength];
@@ -936,6 +985,16 @@ void Binding::HandleBindingReady()
         mProtocolLayerCallback(mProtocolLayerState, kEvent_BindingReady, inParam, outParam);
     }
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+    // Let any bindings that were waiting for the shared connection proceed.
+    if (publishedCon != NULL)
+    {
+        NotifySharedConnectionReady(mExchangeManager, publishedCon);
+    }
+
+#endif
+
     Release();
 }
 
@@ -1178,6 +1237,291 @@ void Binding::OnSecurityManagerAvailable()
     }
 }
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+/**
+ * Determine whether a shared connection was established for the peer, address and security
+ * configuration of the binding.
+ */
+bool Binding::MatchesSharedConnection(const SharedConnection & sharedCon) const
+{
+    return sharedCon.Con != NULL &&
+           sharedCon.PeerNodeId == mPeerNodeId &&
+           sharedCon.PeerAddr == mPeerAddress &&
+           sharedCon.PeerPort == mPeerPort &&
+           sharedCon.PeerInterfaceId == mInterfaceId &&
+           sharedCon.SecurityOption == mSecurityOption &&
+           sharedCon.AuthMode == mAuthMode &&
+           (mSecurityOption != kSecurityOption_SpecificKey || sharedCon.KeyId == mKeyId);
+}
+
+/**
+ * Find a shared connection that the binding can use, either established or being established.
+ */
+Binding::SharedConnection * Binding::FindSharedConnection(void) const
+{
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        SharedConnection & sharedCon = mExchangeManager->SharedConnectionPool[i];
+
+        if (MatchesSharedConnection(sharedCon) &&
+            (!sharedCon.IsReady || sharedCon.Con->State == WeaveConnection::kState_Connected))
+        {
+            return &sharedCon;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Find the shared connection entry, if any, for a given connection.
+ */
+Binding::SharedConnection * Binding::LookupSharedConnection(WeaveExchangeManager *exchangeMgr, const WeaveConnection *con)
+{
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        if (con != NULL && exchangeMgr->SharedConnectionPool[i].Con == con)
+        {
+            return &exchangeMgr->SharedConnectionPool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Offer the connection that the binding is about to establish for use by other bindings.
+ *
+ * If the pool of shared connections is full, the binding simply uses the connection on its own.
+ */
+void Binding::AddSharedConnection(void)
+{
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        SharedConnection & sharedCon = mExchangeManager->SharedConnectionPool[i];
+
+        if (sharedCon.Con == NULL)
+        {
+            sharedCon.Con = mCon;
+            sharedCon.ExchangeMgr = mExchangeManager;
+            sharedCon.PeerNodeId = mPeerNodeId;
+            sharedCon.PeerAddr = mPeerAddress;
+            sharedCon.PeerInterfaceId = mInterfaceId;
+            sharedCon.PeerPort = mPeerPort;
+            sharedCon.KeyId = static_cast<uint16_t>(mKeyId);
+            sharedCon.SecurityOption = mSecurityOption;
+            sharedCon.EncType = mEncType;
+            sharedCon.AuthMode = mAuthMode;
+            sharedCon.UserCount = 1;
+            sharedCon.IsReady = false;
+
+            // The entry holds a reference of its own, so that the connection can remain open
+            // after the bindings using it have closed.
+            mCon->AddRef();
+
+            WeaveLogDetail(ExchangeManager, "Binding[%" PRIu8 "] (%" PRIu16 "): Sharing con (%04" PRIX16 ")",
+                    GetLogId(), mRefCount, mCon->LogId());
+            return;
+        }
+    }
+
+    WeaveLogDetail(ExchangeManager, "Binding[%" PRIu8 "] (%" PRIu16 "): No free shared con entry",
+            GetLogId(), mRefCount);
+}
+
+/**
+ * Use a shared connection found by FindSharedConnection().
+ *
+ * If the connection is ready, the binding takes a reference to it and a reservation on its
+ * session key, and becomes ready itself.  Otherwise the binding waits, in the TCPConnect state
+ * but without a connection, until the binding establishing the connection either makes it
+ * ready or gives up.
+ */
+void Binding::JoinSharedConnection(SharedConnection & sharedCon)
+{
+    if (!sharedCon.IsReady)
+    {
+        WeaveLogDetail(ExchangeManager, "Binding[%" PRIu8 "] (%" PRIu16 "): Waiting for shared con (%04" PRIX16 ")",
+                GetLogId(), mRefCount, sharedCon.Con->LogId());
+
+        mState = kState_PreparingTransport_TCPConnect;
+        return;
+    }
+
+    // If the connection was idle, stop the timer that would close it.
+    if (sharedCon.UserCount == 0)
+    {
+        mExchangeManager->MessageLayer->SystemLayer->CancelTimer(HandleSharedConnectionIdle, &sharedCon);
+    }
+
+    sharedCon.UserCount++;
+
+    mCon = sharedCon.Con;
+    mCon->AddRef();
+    SetFlag(kFlag_ConnectionReferenced);
+
+    mKeyId = sharedCon.KeyId;
+    mEncType = sharedCon.EncType;
+    if (mSecurityOption != kSecurityOption_None)
+    {
+        mExchangeManager->MessageLayer->SecurityMgr->ReserveKey(mPeerNodeId, mKeyId);
+        SetFlag(kFlag_KeyReserved);
+    }
+
+    WeaveLogDetail(ExchangeManager, "Binding[%" PRIu8 "] (%" PRIu16 "): Using shared con (%04" PRIX16 "), %" PRIu8 " users",
+            GetLogId(), mRefCount, mCon->LogId(), sharedCon.UserCount);
+
+    HandleBindingReady();
+}
+
+/**
+ * Give up the binding's use of a shared connection, when the binding is reset.
+ *
+ * A connection that is ready remains open for #WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT
+ * milliseconds after its last user leaves.  A connection that is still being established is
+ * abandoned with the binding that was establishing it.
+ */
+void Binding::LeaveSharedConnection(void)
+{
+    SharedConnection * sharedCon = LookupSharedConnection(mExchangeManager, mCon);
+
+    if (sharedCon == NULL)
+    {
+        return;
+    }
+
+    sharedCon->UserCount--;
+
+    if (!sharedCon->IsReady)
+    {
+        RemoveSharedConnection(*sharedCon, true);
+    }
+    else if (sharedCon->UserCount == 0)
+    {
+#if WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT > 0
+        if (mExchangeManager->MessageLayer->SystemLayer->StartTimer(WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT,
+                HandleSharedConnectionIdle, sharedCon) == WEAVE_SYSTEM_NO_ERROR)
+        {
+            return;
+        }
+#endif
+        RemoveSharedConnection(*sharedCon, false);
+    }
+}
+
+/**
+ * Mark the shared connection established by the binding as ready for use by other bindings.
+ *
+ * @return  true if the binding established a shared connection that was not already ready.
+ */
+bool Binding::PublishSharedConnection(void)
+{
+    SharedConnection * sharedCon = LookupSharedConnection(mExchangeManager, mCon);
+
+    if (sharedCon == NULL || sharedCon->IsReady)
+    {
+        return false;
+    }
+
+    sharedCon->KeyId = static_cast<uint16_t>(mKeyId);
+    sharedCon->EncType = mEncType;
+    sharedCon->IsReady = true;
+
+    // Hold a reservation on the session key on behalf of the entry, so that the session can
+    // outlive the binding that established it.
+    if (mSecurityOption != kSecurityOption_None)
+    {
+        mExchangeManager->MessageLayer->SecurityMgr->ReserveKey(mPeerNodeId, mKeyId);
+    }
+
+    return true;
+}
+
+/**
+ * Stop sharing a connection, releasing the references held by its entry.
+ *
+ * @param[in] sharedCon         The entry for the connection.
+ * @param[in] restartWaiters    If the connection was still being established, restart the
+ *                              preparation of the bindings waiting for it.  The first of these
+ *                              establishes a new shared connection, for which the others wait.
+ */
+void Binding::RemoveSharedConnection(SharedConnection & sharedCon, bool restartWaiters)
+{
+    WeaveExchangeManager *exchangeMgr = sharedCon.ExchangeMgr;
+    WeaveSecurityManager *sm = exchangeMgr->MessageLayer->SecurityMgr;
+    const SharedConnection removed = sharedCon;
+
+    exchangeMgr->MessageLayer->SystemLayer->CancelTimer(HandleSharedConnectionIdle, &sharedCon);
+
+    // Free the entry before releasing its references, so that nothing done as a result of
+    // closing the connection finds it.
+    sharedCon.Con = NULL;
+
+    if (removed.IsReady && removed.SecurityOption != kSecurityOption_None && sm != NULL)
+    {
+        sm->ReleaseKey(removed.PeerNodeId, removed.KeyId);
+    }
+
+    WeaveLogDetail(ExchangeManager, "Stopped sharing con (%04" PRIX16 ")", removed.Con->LogId());
+
+    removed.Con->Release();
+
+    if (restartWaiters && !removed.IsReady)
+    {
+        for (int i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; i++)
+        {
+            Binding & binding = exchangeMgr->BindingPool[i];
+
+            if (binding.mState == kState_PreparingTransport_TCPConnect && binding.mCon == NULL &&
+                binding.GetFlag(kFlag_ShareConnection) && binding.MatchesSharedConnection(removed))
+            {
+                binding.PrepareTransport();
+            }
+        }
+    }
+}
+
+/**
+ * Complete the preparation of the bindings waiting for a shared connection that has become ready.
+ */
+void Binding::NotifySharedConnectionReady(WeaveExchangeManager *exchangeMgr, const WeaveConnection *con)
+{
+    for (int i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; i++)
+    {
+        // Look the entry up afresh each time, since it may have been removed as a result of a
+        // previous binding's ready event.
+        SharedConnection * sharedCon = LookupSharedConnection(exchangeMgr, con);
+        Binding & binding = exchangeMgr->BindingPool[i];
+
+        if (sharedCon == NULL || !sharedCon->IsReady)
+        {
+            break;
+        }
+
+        if (binding.mState == kState_PreparingTransport_TCPConnect && binding.mCon == NULL &&
+            binding.GetFlag(kFlag_ShareConnection) && binding.MatchesSharedConnection(*sharedCon))
+        {
+            binding.JoinSharedConnection(*sharedCon);
+        }
+    }
+}
+
+/**
+ * Invoked when a shared connection has gone unused for the idle timeout.
+ */
+void Binding::HandleSharedConnectionIdle(System::Layer* aSystemLayer, void* aAppState, System::Error aError)
+{
+    SharedConnection * sharedCon = static_cast<SharedConnection *>(aAppState);
+
+    if (sharedCon->Con != NULL && sharedCon->UserCount == 0)
+    {
+        RemoveSharedConnection(*sharedCon, false);
+    }
+}
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
 /**
  * Re-configure an existing Exchange Context to adjust the response timeout.
  *
@@ -1630,6 +1974,41 @@ Binding::Configuration& Binding::Configuration::TargetAddress_WeaveFabric(uint16
 Binding::Configuration& Binding::Configuration::Transport_TCP()
 {
     mBinding.mTransportOption = kTransport_TCP;
+    mBinding.ClearFlag(kFlag_ShareConnection);
+    return *this;
+}
+
+/**
+ * Use TCP to communicate with the peer, sharing the connection with other bindings.
+ *
+ * When the binding is prepared, if another binding configured this way has established, or
+ * is establishing, a connection to the same peer node, address and port, with the same
+ * security configuration, the binding uses that connection and its session key rather than
+ * setting up its own.  Otherwise the binding establishes a connection as with Transport_TCP()
+ * and offers it to other bindings.
+ *
+ * A shared connection is closed #WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT milliseconds after
+ * the last binding using it closes or fails, unless another binding uses it in the meantime.
+ *
+ * Only the binding that establishes a shared connection receives the ConnectionEstablished
+ * event, and the PASE and TAKE parameters events.  Applications should not close a shared
+ * connection directly, since doing so fails every binding that uses it.
+ *
+ * If sharing is disabled (#WEAVE_CONFIG_MAX_SHARED_CONNECTIONS is 0, or sharing has not been
+ * enabled with WeaveExchangeManager::SetConnectionSharingEnabled()), this is equivalent to
+ * Transport_TCP().
+ *
+ * @return                              A reference to the binding object.
+ */
+Binding::Configuration& Binding::Configuration::Transport_SharedTCP()
+{
+    Transport_TCP();
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    if (mBinding.mExchangeManager->ConnectionSharingEnabled())
+    {
+        mBinding.SetFlag(kFlag_ShareConnection);
+    }
+#endif
     return *this;
 }
 
@@ -1641,6 +2020,7 @@ Binding::Configuration& Binding::Configuration::Transport_TCP()
 Binding::Configuration& Binding::Configuration::Transport_UDP()
 {
     mBinding.mTransportOption = kTransport_UDP;
+    mBinding.ClearFlag(kFlag_ShareConnection);
     return *this;
 }
 
@@ -1653,6 +2033,7 @@ Binding::Configuration& Binding::Configuration::Transport_UDP_WRM()
 {
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     mBinding.mTransportOption = kTransport_UDP_WRM;
+    mBinding.ClearFlag(kFlag_ShareConnection);
 #else // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     mError = WEAVE_ERROR_NOT_IMPLEMENTED;
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
@@ -1706,6 +2087,7 @@ Binding::Configuration& Binding::Configuration::Transport_ExistingConnection(Wea
 {
     mBinding.mTransportOption = kTransport_ExistingConnection;
     mBinding.mCon = con;
+    mBinding.ClearFlag(kFlag_ShareConnection);
     return *this;
 }
 
@@ -269,16 +269,46 @@ private:
         kFlag_KeyReserved                           = 0x1,
         kFlag_ConnectionReferenced                  = 0x2,
         kFlag_CaptureTxMessage                      = 0x4,
+        kFlag_ShareConnection                       = 0x8,
     };
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+    /**
+     * A TCP connection, and the session key established over it, available for use by any Binding
+     * configured with Transport_SharedTCP() for the same peer, address and security settings.
+     *
+     * The entry holds its own reference to the connection and, once ready, its own reservation
+     * on the session key, so that both outlive the Bindings using them by the shared connection
+     * idle timeout.
+     */
+    struct SharedConnection
+    {
+        WeaveConnection *Con;                       ///< The shared connection, or NULL if the entry is free.
+        WeaveExchangeManager *ExchangeMgr;
+        uint64_t PeerNodeId;
+        nl::Inet::IPAddress PeerAddr;
+        InterfaceId PeerInterfaceId;
+        uint16_t PeerPort;
+        uint16_t KeyId;
+        uint8_t SecurityOption;
+        uint8_t EncType;
+        WeaveAuthMode AuthMode;
+        uint8_t UserCount;                          ///< Number of Bindings holding a reference to the connection through the entry.
+        bool IsReady;                               ///< True once the connection and any session are established.
+    };
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
     WeaveExchangeManager * mExchangeManager;
+    Binding * mNextFree;                        ///< Next binding on the exchange manager's free list (only valid while free).
 
     uint8_t mRefCount;
     State mState : 4;
     SecurityOption mSecurityOption : 3;
     AddressingOption mAddressingOption : 3;
     TransportOption mTransportOption : 3;
-    unsigned mFlags : 3;
+    unsigned mFlags : 4;
 #if WEAVE_CONFIG_ENABLE_DNS_RESOLVER
     uint8_t mDNSOptions;
 #endif
@@ -339,6 +369,20 @@ private:
 
     static void OnResolveComplete(void *appState, INET_ERROR err, uint8_t addrCount, IPAddress *addrArray);
     static void OnConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr);
+
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    bool MatchesSharedConnection(const SharedConnection & sharedCon) const;
+    SharedConnection * FindSharedConnection(void) const;
+    void AddSharedConnection(void);
+    void JoinSharedConnection(SharedConnection & sharedCon);
+    void LeaveSharedConnection(void);
+    bool PublishSharedConnection(void);
+
+    static SharedConnection * LookupSharedConnection(WeaveExchangeManager *exchangeMgr, const WeaveConnection *con);
+    static void RemoveSharedConnection(SharedConnection & sharedCon, bool restartWaiters);
+    static void NotifySharedConnectionReady(WeaveExchangeManager *exchangeMgr, const WeaveConnection *con);
+    static void HandleSharedConnectionIdle(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
 };
 
 /**
@@ -371,6 +415,7 @@ public:
     Configuration& DNS_Options(uint8_t dnsOptions);
 
     Configuration& Transport_TCP(void);
+    Configuration& Transport_SharedTCP(void);
     Configuration& Transport_UDP(void);
     Configuration& Transport_UDP_WRM(void);
     Configuration& Transport_UDP_PathMTU(uint32_t aPathMTU);
@@ -833,6 +833,7 @@
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
  *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS
+ *      * #WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
  *
  *    Note that these options are mutually exclusive and only one of
  *    these options should be set.
@@ -902,6 +903,23 @@
 #define WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS            0
 #endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS
 
+/**
+ *  @def WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+ *
+ *  @brief
+ *    Enable (1) or disable (0) support for a Weave-provided
+ *    implementation of the Weave SHA1 and SHA256 hash functions
+ *    using Intel SHA extensions and AVX2 intrinsics.  Processor
+ *    support is detected at run time, with a portable fallback.
+ *
+ *  @note This configuration is mutual exclusive with other
+ *        WEAVE_CONFIG_HASH_IMPLEMENTATION options.
+ *
+ */
+#ifndef WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+#define WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI              0
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
 /**
  *  @}
  */
@@ -909,7 +927,8 @@
 #if ((WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM + \
       WEAVE_CONFIG_HASH_IMPLEMENTATION_MINCRYPT + \
       WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL  + \
-      WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS) != 1)
+      WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS  + \
+      WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI) != 1)
 #error "Please assert exactly one WEAVE_CONFIG_HASH_IMPLEMENTATION_... option."
 #endif
 
@@ -1132,6 +1151,7 @@
  *    It might be a good idea to allocate few more entries in the key
  *    cache for the corner cases, where application group is having
  *    simultaneous conversations using an 'old' and a 'new' epoch key.
+ *    When the cache is full the least-recently used key is replaced.
  *
  *  @note This configuration is only relevant when
  *        #WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC is set and
@@ -1146,6 +1166,33 @@
 #error "Please set WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS to a value greater than zero and smaller than 256."
 #endif // !(WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS > 0 && WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS < 256)
 
+/**
+ *  @def WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+ *
+ *  @brief
+ *    Enable (1) or disable (0) precomputing of the next epoch's
+ *    message encryption application key.
+ *    When a rotating application key is derived, the key for the same
+ *    group and the epoch key that follows it is derived as well, so that
+ *    messages sent after the epoch key rotation do not stall the receive
+ *    path on a key derivation. Precomputed keys only occupy free key cache
+ *    entries and are the first to be replaced when the cache fills up.
+ *    When the cache has no free entry, precomputing is skipped and the
+ *    key is derived on demand after the rotation; received keys are
+ *    evicted in least-recently used order as before.
+ *
+ *    Precomputing costs an extra key lookup and derivation on each cache
+ *    miss, so it is disabled by default.
+ *
+ *  @note This configuration is only relevant when
+ *        #WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC is set and
+ *        ignored otherwise.
+ *
+ */
+#ifndef WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+#define WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS  0
+#endif // WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+
 /**
  *  @name Weave Encrypted Passcode Configuration
  *
@@ -1282,6 +1329,40 @@
 #define WEAVE_CONFIG_MAX_BINDINGS                           6
 #endif // WEAVE_CONFIG_MAX_BINDINGS
 
+/**
+ *  @def WEAVE_CONFIG_MAX_SHARED_CONNECTIONS
+ *
+ *  @brief
+ *    Maximum number of TCP connections, with their session keys, that a
+ *    WeaveExchangeManager tracks for sharing between Bindings configured
+ *    with Binding::Configuration::Transport_SharedTCP().
+ *
+ *    Bindings that find no free entry use a connection of their own.
+ *    Connection sharing is disabled by default (0). When it is built in,
+ *    it is still off at run time until enabled with
+ *    WeaveExchangeManager::SetConnectionSharingEnabled().
+ *
+ */
+#ifndef WEAVE_CONFIG_MAX_SHARED_CONNECTIONS
+#define WEAVE_CONFIG_MAX_SHARED_CONNECTIONS                 0
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS
+
+/**
+ *  @def WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT
+ *
+ *  @brief
+ *    Time in milliseconds that a shared connection, and its session key,
+ *    are kept open after the last Binding using them is closed, so that a
+ *    Binding prepared shortly afterwards can use them without setting up
+ *    a new connection and session.
+ *
+ *    Set to (0) to close a shared connection as soon as it is unused.
+ *
+ */
+#ifndef WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT
+#define WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT         10000
+#endif // WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT
+
 /**
  *  @def WEAVE_CONFIG_CONNECT_IP_ADDRS
  *
@@ -1294,6 +1375,41 @@
 #define WEAVE_CONFIG_CONNECT_IP_ADDRS                       4
 #endif // WEAVE_CONFIG_CONNECT_IP_ADDRS
 
+/**
+ *  @def WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS
+ *
+ *  @brief
+ *    Maximum number of TCP connection attempts that a WeaveConnection
+ *    keeps in progress at once to different addresses of the same peer.
+ *
+ *    When set to (1), each address is only tried after the attempt to
+ *    the previous one has failed or timed out.  When greater than (1),
+ *    a new attempt is started every
+ *    #WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY milliseconds, or as soon as an
+ *    earlier attempt fails, in the manner of RFC 8305; the first attempt
+ *    to complete is kept and the others are abandoned.
+ *
+ *    The value must be no greater than #WEAVE_CONFIG_CONNECT_IP_ADDRS.
+ *
+ */
+#ifndef WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS
+#define WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS          1
+#endif // WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS
+
+/**
+ *  @def WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY
+ *
+ *  @brief
+ *    Time in milliseconds that a WeaveConnection waits for a TCP
+ *    connection attempt to complete before starting a parallel attempt
+ *    to the next address of the peer, when
+ *    #WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS is greater than (1).
+ *
+ */
+#ifndef WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY
+#define WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY                  250
+#endif // WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY
+
 /**
  *  @def WEAVE_CONFIG_DEFAULT_UDP_MTU_SIZE
  *
@@ -1309,6 +1425,70 @@
 #define WEAVE_CONFIG_DEFAULT_UDP_MTU_SIZE                   1280
 #endif // WEAVE_CONFIG_DEFAULT_UDP_MTU_SIZE
 
+/**
+ *  @def WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+ *
+ *  @brief
+ *    Enable (1) or disable (0) support for carrying several Weave messages
+ *    in a single UDP datagram.
+ *
+ *    When enabled, the message layer accepts coalesced datagrams from
+ *    any peer.  It only sends them when the application has called
+ *    WeaveMessageLayer::SetMessageCoalescingEnabled(), and then only to
+ *    peers known to accept them: those added with
+ *    WeaveMessageLayer::AddCoalescingPeer() and those from which a
+ *    coalesced datagram carrying an authenticated message has been
+ *    received.  A peer is forgotten when a coalesced datagram cannot be
+ *    sent to it or when WRMP gives up retransmitting a message to it.
+ *
+ */
+#ifndef WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+#define WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING              0
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+/**
+ *  @def WEAVE_CONFIG_MAX_COALESCING_PEERS
+ *
+ *  @brief
+ *    The number of peer addresses the message layer remembers as
+ *    accepting coalesced datagrams, when
+ *    #WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING is enabled.  When the table
+ *    is full, the least recently added peer is forgotten.
+ *
+ */
+#ifndef WEAVE_CONFIG_MAX_COALESCING_PEERS
+#define WEAVE_CONFIG_MAX_COALESCING_PEERS                   8
+#endif // WEAVE_CONFIG_MAX_COALESCING_PEERS
+
+/**
+ *  @def WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS
+ *
+ *  @brief
+ *    The number of coalesced datagrams, each for a different destination,
+ *    that the message layer may be filling at once, when
+ *    #WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING is enabled.  Messages for
+ *    further destinations are sent immediately in datagrams of their own.
+ *
+ */
+#ifndef WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS
+#define WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS                4
+#endif // WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS
+
+/**
+ *  @def WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE
+ *
+ *  @brief
+ *    The maximum size, in bytes, of the UDP payload of a coalesced
+ *    datagram, when #WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING is enabled.
+ *
+ *    The default keeps coalesced datagrams within the guaranteed minimum
+ *    IPv6 MTU, so that they are never fragmented.
+ *
+ */
+#ifndef WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE
+#define WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE            (WEAVE_CONFIG_DEFAULT_UDP_MTU_SIZE - INET_CONFIG_MAX_IP_AND_UDP_HEADER_SIZE)
+#endif // WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE
+
 /**
  *  @def WEAVE_HEADER_RESERVE_SIZE
  *
@@ -1592,6 +1772,37 @@
 #endif
 #endif // WEAVE_CONFIG_DEFAULT_CASE_CURVE_ID
 
+/**
+ *  @def WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+ *
+ *  @brief
+ *    Enable support for the AES-128-CCM message encryption type
+ *    (#kWeaveEncryptionType_AES128CCM).
+ *
+ *    AES-128-CCM authenticates and encrypts a message using only the
+ *    AES block cipher and a single session key.
+ *
+ */
+#ifndef WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+#define WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM              1
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+/**
+ *  @def WEAVE_CONFIG_DEFAULT_SESSION_ENCRYPTION_TYPE
+ *
+ *  @brief
+ *    Default message encryption type proposed when initiating a CASE or
+ *    PASE session, if not overridden by the application.
+ *
+ *  @note When a CASE or PASE responder rejects a proposed encryption type other
+ *    than #kWeaveEncryptionType_AES128CTRSHA1, the initiator retries the
+ *    session using #kWeaveEncryptionType_AES128CTRSHA1.
+ *
+ */
+#ifndef WEAVE_CONFIG_DEFAULT_SESSION_ENCRYPTION_TYPE
+#define WEAVE_CONFIG_DEFAULT_SESSION_ENCRYPTION_TYPE        (nl::Weave::kWeaveEncryptionType_AES128CTRSHA1)
+#endif // WEAVE_CONFIG_DEFAULT_SESSION_ENCRYPTION_TYPE
+
 /**
  *  @def WEAVE_CONFIG_DEFAULT_CASE_ALLOWED_CURVES
  *
@@ -1950,6 +2161,55 @@
 #define WEAVE_CONFIG_SERVICE_DIR_CONNECT_TIMEOUT_MSECS      (10000)
 #endif // WEAVE_CONFIG_SERVICE_DIR_CONNECT_TIMEOUT_MSECS
 
+/**
+ *  @def WEAVE_CONFIG_SERVICE_DIR_INDEX_SIZE
+ *
+ *  @brief
+ *    The maximum number of directory entries the service manager
+ *    indexes by service endpoint id when a directory is cached.
+ *
+ *  @note
+ *    Lookups in a directory with more entries than this fall back
+ *    to scanning the packed cache.
+ *
+ */
+#ifndef WEAVE_CONFIG_SERVICE_DIR_INDEX_SIZE
+#define WEAVE_CONFIG_SERVICE_DIR_INDEX_SIZE                 (16)
+#endif // WEAVE_CONFIG_SERVICE_DIR_INDEX_SIZE
+
+/**
+ *  @def WEAVE_CONFIG_SERVICE_DIR_CACHE_LIFETIME_MSECS
+ *
+ *  @brief
+ *    The default lifetime, in milliseconds, of a resolved service
+ *    directory.  A value of (0) disables expiry and background
+ *    refresh.
+ *
+ *  @note
+ *    When non-zero, the service manager re-queries the directory
+ *    service in the background once three quarters of the lifetime
+ *    have elapsed, so that connect() keeps being served from the
+ *    cache.  If no fresh directory has been obtained by the end of
+ *    the lifetime, the cache is unresolved and the next connect()
+ *    waits for a directory query as usual.
+ *
+ */
+#ifndef WEAVE_CONFIG_SERVICE_DIR_CACHE_LIFETIME_MSECS
+#define WEAVE_CONFIG_SERVICE_DIR_CACHE_LIFETIME_MSECS       (0)
+#endif // WEAVE_CONFIG_SERVICE_DIR_CACHE_LIFETIME_MSECS
+
+/**
+ *  @def WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS
+ *
+ *  @brief
+ *    The time, in milliseconds, the service manager waits before
+ *    retrying a background directory refresh that failed.
+ *
+ */
+#ifndef WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS
+#define WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS        (5000)
+#endif // WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS
+
 /**
  *  @def WEAVE_CONFIG_DEFAULT_INCOMING_CONNECTION_IDLE_TIMEOUT
  *
@@ -2258,6 +2518,56 @@
 #define WEAVE_CONFIG_PERSISTED_COUNTER_DEBUG_LOGGING 0
 #endif
 
+/**
+ * @def WEAVE_CONFIG_PERSISTED_STORAGE_ENABLE_WRITE_BEHIND
+ *
+ * @brief Enable (1) or disable (0) write-behind batching of
+ *   PersistedCounter updates.
+ *
+ * When enabled, the Weave Device Layer initializes the
+ * PersistedStorageWriteBehind cache, which coalesces the start values
+ * persisted by PersistedCounter objects into one batched write every
+ * #WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_INTERVAL_MSEC, rather than
+ * writing synchronously each time a counter crosses an epoch.  Counters
+ * then keep an extra epoch of headroom in persistent storage, so up to two
+ * epochs of values may be skipped across a reboot.
+ */
+#ifndef WEAVE_CONFIG_PERSISTED_STORAGE_ENABLE_WRITE_BEHIND
+#define WEAVE_CONFIG_PERSISTED_STORAGE_ENABLE_WRITE_BEHIND 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_INTERVAL_MSEC
+ *
+ * @brief The interval, in milliseconds, at which pending write-behind
+ *   values are written to persistent storage.
+ */
+#ifndef WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_INTERVAL_MSEC
+#define WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_INTERVAL_MSEC 1000
+#endif
+
+/**
+ * @def WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS
+ *
+ * @brief The maximum number of distinct keys with a pending value in the
+ *   write-behind cache.  A write to a further key flushes the cache first.
+ */
+#ifndef WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS
+#define WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS 8
+#endif
+
+/**
+ * @def WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+ *
+ * @brief Assert (1) if the platform provides
+ *   nl::Weave::Platform::PersistedStorage::WriteMultiple(), which the
+ *   write-behind cache then uses to write each batch as a single update.
+ *   Otherwise (0), each value in a batch is written with Write().
+ */
+#ifndef WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+#define WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE 0
+#endif
+
 /**
  * @def WEAVE_CONFIG_EVENT_LOGGING_VERBOSE_DEBUG_LOGS
  *
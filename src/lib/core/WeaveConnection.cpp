@@ -82,8 +82,7 @@ void WeaveConnection::Release()
         DoClose(WEAVE_NO_ERROR, kDoCloseFlag_SuppressCallback);
     }
 
-    VerifyOrDie(mRefCount != 0);
-    mRefCount--;
+    DecrementRefCount();
 }
 
 WEAVE_ERROR WeaveConnection::StartConnectToAddressLiteral(const char *peerAddr, size_t peerAddrLen)
@@ -219,6 +218,81 @@ exit:
     return err;
 }
 
+/**
+ *  Connect to a Weave node using a node identifier and a list of candidate IP addresses.
+ *
+ *  @note
+ *    The addresses are tried in order, in the same way as the addresses that result from resolving a host
+ *    name.  If #WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS is greater than 1, attempts to later addresses are
+ *    started while earlier ones are still in progress, and the first to complete is kept.  Addresses beyond
+ *    the first #WEAVE_CONFIG_CONNECT_IP_ADDRS are ignored.
+ *
+ *  @param[in]    peerNodeId    The node identifier of the peer, kNodeIdNotSpecified or 0 if
+ *                              not known.
+ *
+ *  @param[in]    authMode      The desired authenticate mode for the peer. Only CASE, PASE and Unauthenticated
+ *                              modes are supported.
+ *
+ *  @param[in]    peerAddrs     An array of IP addresses of the peer.
+ *
+ *  @param[in]    peerAddrCount The number of addresses in peerAddrs.
+ *
+ *  @param[in]    peerPort      The optional port of the peer, default to #WEAVE_PORT.
+ *
+ *  @param[in]    intf          The optional interface to use to connect to the peer node,
+ *                              default to #INET_NULL_INTERFACEID.
+ *
+ *  @retval #WEAVE_NO_ERROR                      on successful initiation of the connection to the peer.
+ *  @retval #WEAVE_ERROR_INCORRECT_STATE         if the WeaveConnection state is incorrect.
+ *
+ *  @retval #WEAVE_ERROR_UNSUPPORTED_AUTH_MODE   if the requested authentication mode is not supported.
+ *
+ *  @retval #WEAVE_ERROR_INVALID_ARGUMENT        if no peer address was given.
+ *
+ *  @retval other Inet layer errors generated by the TCPEndPoint connect operations.
+ *
+ */
+WEAVE_ERROR WeaveConnection::Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const IPAddress *peerAddrs, uint8_t peerAddrCount,
+                                     uint16_t peerPort, InterfaceId intf)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(State == kState_ReadyToConnect, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    VerifyOrExit(peerAddrs != NULL && peerAddrCount > 0, err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    VerifyOrExit(authMode == kWeaveAuthMode_Unauthenticated || IsCASEAuthMode(authMode) || IsPASEAuthMode(authMode), err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // Can't request authentication if the security manager is not initialized.
+    VerifyOrExit(authMode == kWeaveAuthMode_Unauthenticated || MessageLayer->SecurityMgr != NULL, err = WEAVE_ERROR_UNSUPPORTED_AUTH_MODE);
+
+    // Application has made this an IP-based WeaveConnection.
+    NetworkType = kNetworkType_IP;
+
+    // Load the list of peer addresses to be tried.
+    memset(mPeerAddrs, 0, sizeof(mPeerAddrs));
+    for (uint8_t i = 0; i < peerAddrCount && i < WEAVE_CONFIG_CONNECT_IP_ADDRS; i++)
+        mPeerAddrs[i] = peerAddrs[i];
+
+    PeerNodeId = peerNodeId;
+    PeerPort = (peerPort != 0) ? peerPort : WEAVE_PORT;
+    mTargetInterface = intf;
+    AuthMode = authMode;
+
+    // Bump the reference count when we start the connection process. The corresponding decrement happens when the
+    // DoClose() method is called. This ensures the object stays live while there's the possibility of a callback
+    // happening from an underlying layer (e.g. TCPEndPoint or DNS resolution).
+    mRefCount++;
+
+    WeaveLogProgress(MessageLayer, "Con start %04X %016llX %04X", LogId(), peerNodeId, authMode);
+
+    err = TryNextPeerAddress(WEAVE_ERROR_INVALID_ADDRESS);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
 /**
  *  Connect to a Weave node using a node identifier and/or a string host name.  If supplied, peerAddr can
  *  be any of:
@@ -821,8 +895,7 @@ WEAVE_ERROR WeaveConnection::Close(bool suppressCloseLog)
 
     // Decrement the ref count that was added when the WeaveConnection object
     // was allocated (in WeaveMessageLayer::NewConnection()).
-    VerifyOrDie(mRefCount != 0);
-    mRefCount--;
+    DecrementRefCount();
 
     return WEAVE_NO_ERROR;
 }
@@ -853,8 +926,7 @@ void WeaveConnection::Abort()
 
     // Decrement the ref count that was added when the WeaveConnection object
     // was allocated (in WeaveMessageLayer::NewConnection()).
-    VerifyOrDie(mRefCount != 0);
-    mRefCount--;
+    DecrementRefCount();
 }
 
 /**
@@ -1111,6 +1183,11 @@ void WeaveConnection::DoClose(WEAVE_ERROR err, uint8_t flags)
                 mTcpEndPoint = NULL;
             }
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+            // Abandon any connection attempts still in progress.
+            AbortConnectAttempts();
+#endif
+
 #if WEAVE_CONFIG_ENABLE_DNS_RESOLVER
             // Cancel any outstanding DNS query that may still be active.  (This situation can
             // arise if the application initiates a connection to a peer using a DNS name and
@@ -1148,8 +1225,7 @@ void WeaveConnection::DoClose(WEAVE_ERROR err, uint8_t flags)
         // Decrement the ref count that was added when the connection started.
         if (oldState != kState_ReadyToConnect && oldState != kState_Closed)
         {
-            VerifyOrDie(mRefCount != 0);
-            mRefCount--;
+            DecrementRefCount();
         }
     }
 }
@@ -1165,6 +1241,12 @@ void WeaveConnection::HandleResolveComplete(void *appState, INET_ERROR dnsRes, u
 
     WeaveLogProgress(MessageLayer, "Con DNS complete %04X %ld", con->LogId(), (long)dnsRes);
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    // Alternate between address families so that the parallel attempts are not all made over the same one.
+    if (dnsRes == INET_NO_ERROR)
+        con->InterleavePeerAddressFamilies();
+
+#endif
     // Attempt to connect to the first resolved address (if any).
     con->TryNextPeerAddress(dnsRes);
 }
@@ -1173,6 +1255,11 @@ WEAVE_ERROR WeaveConnection::TryNextPeerAddress(WEAVE_ERROR lastErr)
 {
     WEAVE_ERROR err = lastErr; // If there are no more addresses to try, lastErr will become the error returned to the user.
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    // If as many attempts as allowed are already in progress, wait for one of them to complete.
+    VerifyOrExit(FindConnectAttempt(NULL) >= 0, err = WEAVE_NO_ERROR);
+#endif
+
     // Search the list of peer addresses for one we haven't tried yet...
     for (int i = 0; i < WEAVE_CONFIG_CONNECT_IP_ADDRS; i++)
         if (mPeerAddrs[i] != IPAddress::Any)
@@ -1183,9 +1270,29 @@ WEAVE_ERROR WeaveConnection::TryNextPeerAddress(WEAVE_ERROR lastErr)
 
             // Initiate a connection to the new address.
             err = StartConnect();
+
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+            // If the attempt could not be started, move straight on to the next address.
+            if (err != WEAVE_NO_ERROR)
+                continue;
+
+            // If the attempt is still in progress, give it a head start before racing an attempt to the next
+            // address against it.
+            if (State == kState_Connecting)
+                MessageLayer->SystemLayer->StartTimer(WEAVE_CONFIG_CONNECT_ATTEMPT_DELAY, HandleConnectAttemptDelay, this);
+#endif
+
             ExitNow();
         }
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    MessageLayer->SystemLayer->CancelTimer(HandleConnectAttemptDelay, this);
+
+    // Wait for the attempts already in progress to complete before moving on to the next host.
+    for (int i = 0; i < WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS; i++)
+        VerifyOrExit(mConnectAttempts[i] == NULL, err = WEAVE_NO_ERROR);
+#endif
+
     // If Connect() was called with a host/port list and there are additional entries in the list, then...
     if (!mPeerHostPortList.IsEmpty())
     {
@@ -1350,6 +1457,10 @@ exit:
 WEAVE_ERROR WeaveConnection::StartConnect()
 {
     WEAVE_ERROR err;
+    TCPEndPoint *endPoint = NULL;
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    int attempt;
+#endif
 
     // TODO: this is wrong. PeerNodeId should only be set once we have a successful connection (including security).
 
@@ -1359,10 +1470,21 @@ WEAVE_ERROR WeaveConnection::StartConnect()
         return err;
 
     // Allocate a new TCP end point.
-    err = MessageLayer->Inet->NewTCPEndPoint(&mTcpEndPoint);
+    err = MessageLayer->Inet->NewTCPEndPoint(&endPoint);
     if (err != WEAVE_NO_ERROR)
         return err;
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    // Track the end point as one of the attempts in progress.  The connection takes it over only if it is the
+    // first to complete.
+    attempt = FindConnectAttempt(NULL);
+    VerifyOrDie(attempt >= 0);
+    mConnectAttempts[attempt] = endPoint;
+    mConnectAttemptAddrs[attempt] = PeerAddr;
+#else
+    mTcpEndPoint = endPoint;
+#endif
+
     // If the peer address is not a ULA, or if the interface identifier portion of the peer address does not match
     // the peer node id, then force the destination node identifier field to be encoded in all sent messages.
     if (!PeerAddr.IsIPv6ULA() || IPv6InterfaceIdToWeaveNodeId(PeerAddr.InterfaceId()) != PeerNodeId)
@@ -1382,17 +1504,16 @@ WEAVE_ERROR WeaveConnection::StartConnect()
     if (MessageLayer->FabricState->ListenIPv6Addr != IPAddress::Any)
 #endif // !INET_CONFIG_ENABLE_IPV4
     {
-        err = mTcpEndPoint->Bind(kIPAddressType_IPv6, MessageLayer->FabricState->ListenIPv6Addr, 0, true);
-        if (err != WEAVE_NO_ERROR)
-            return err;
+        err = endPoint->Bind(kIPAddressType_IPv6, MessageLayer->FabricState->ListenIPv6Addr, 0, true);
+        SuccessOrExit(err);
     }
 #endif
 
     State = kState_Connecting;
 
-    mTcpEndPoint->AppState = this;
-    mTcpEndPoint->OnConnectComplete = HandleConnectComplete;
-    mTcpEndPoint->SetConnectTimeout(mConnectTimeout);
+    endPoint->AppState = this;
+    endPoint->OnConnectComplete = HandleConnectComplete;
+    endPoint->SetConnectTimeout(mConnectTimeout);
 
 #if WEAVE_PROGRESS_LOGGING
     {
@@ -1402,7 +1523,20 @@ WEAVE_ERROR WeaveConnection::StartConnect()
     }
 #endif
     // Initiate the TCP connection.
-    return mTcpEndPoint->Connect(PeerAddr, PeerPort, mTargetInterface);
+    err = endPoint->Connect(PeerAddr, PeerPort, mTargetInterface);
+    SuccessOrExit(err);
+
+exit:
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    // Release the end point of an attempt that could not be started, freeing its slot for an attempt to the
+    // next address.
+    if (err != WEAVE_NO_ERROR && mConnectAttempts[attempt] == endPoint)
+    {
+        endPoint->Free();
+        mConnectAttempts[attempt] = NULL;
+    }
+#endif
+    return err;
 }
 
 void WeaveConnection::HandleConnectComplete(TCPEndPoint *endPoint, INET_ERROR conRes)
@@ -1411,6 +1545,10 @@ void WeaveConnection::HandleConnectComplete(TCPEndPoint *endPoint, INET_ERROR co
 
     WeaveLogProgress(MessageLayer, "TCP con complete %04X %ld", con->LogId(), (long)conRes);
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    con->FinishConnectAttempt(endPoint, conRes);
+
+#endif
     // If the connection was successful...
     if (conRes == INET_NO_ERROR)
     {
@@ -1476,6 +1614,103 @@ void WeaveConnection::HandleConnectComplete(TCPEndPoint *endPoint, INET_ERROR co
     }
 }
 
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+
+// Return the index of the given connection attempt end point, or of a free attempt slot if endPoint is NULL, or
+// -1 if there is no such slot.
+int WeaveConnection::FindConnectAttempt(const TCPEndPoint *endPoint) const
+{
+    for (int i = 0; i < WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS; i++)
+        if (mConnectAttempts[i] == endPoint)
+            return i;
+
+    return -1;
+}
+
+void WeaveConnection::FinishConnectAttempt(TCPEndPoint *endPoint, INET_ERROR conRes)
+{
+    int attempt = FindConnectAttempt(endPoint);
+
+    // Ignore end points that were not started as connection attempts (e.g. that of a repaired connection).
+    if (attempt < 0)
+        return;
+
+    mConnectAttempts[attempt] = NULL;
+
+    // If the attempt succeeded, it is the first to do so.  Adopt its end point and address, and abandon the
+    // other attempts.
+    if (conRes == INET_NO_ERROR)
+    {
+        mTcpEndPoint = endPoint;
+        PeerAddr = mConnectAttemptAddrs[attempt];
+
+        AbortConnectAttempts();
+    }
+}
+
+void WeaveConnection::AbortConnectAttempts(void)
+{
+    MessageLayer->SystemLayer->CancelTimer(HandleConnectAttemptDelay, this);
+
+    for (int i = 0; i < WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS; i++)
+        if (mConnectAttempts[i] != NULL)
+        {
+            mConnectAttempts[i]->Abort();
+            mConnectAttempts[i]->Free();
+            mConnectAttempts[i] = NULL;
+        }
+}
+
+// Reorder the resolved peer addresses so that IPv6 and IPv4 addresses alternate, starting with the family of the
+// first address, as recommended by RFC 8305.  Addresses of the same family keep their relative order.
+void WeaveConnection::InterleavePeerAddressFamilies(void)
+{
+#if INET_CONFIG_ENABLE_IPV4
+    IPAddress sortedAddrs[WEAVE_CONFIG_CONNECT_IP_ADDRS];
+    bool wantIPv4 = mPeerAddrs[0].IsIPv4();
+    int sortedCount = 0;
+
+    while (sortedCount < WEAVE_CONFIG_CONNECT_IP_ADDRS)
+    {
+        int next = -1;
+
+        // Take the first remaining address of the wanted family, or else the first remaining address.
+        for (int i = 0; i < WEAVE_CONFIG_CONNECT_IP_ADDRS; i++)
+            if (mPeerAddrs[i] != IPAddress::Any)
+            {
+                if (next < 0)
+                    next = i;
+                if (mPeerAddrs[i].IsIPv4() == wantIPv4)
+                {
+                    next = i;
+                    break;
+                }
+            }
+
+        if (next < 0)
+            break;
+
+        sortedAddrs[sortedCount] = mPeerAddrs[next];
+        mPeerAddrs[next] = IPAddress::Any;
+        wantIPv4 = !sortedAddrs[sortedCount].IsIPv4();
+        sortedCount++;
+    }
+
+    for (int i = 0; i < sortedCount; i++)
+        mPeerAddrs[i] = sortedAddrs[i];
+#endif // INET_CONFIG_ENABLE_IPV4
+}
+
+void WeaveConnection::HandleConnectAttemptDelay(System::Layer* aSystemLayer, void* aAppState, System::Error aError)
+{
+    WeaveConnection *con = static_cast<WeaveConnection *>(aAppState);
+
+    // No attempt has completed within the delay, so start an attempt to the next address alongside them.
+    con->TryNextPeerAddress(WEAVE_NO_ERROR);
+}
+
+#endif // WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+
 void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *data)
 {
     WEAVE_ERROR err;
@@ -1513,7 +1748,8 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
         // the incoming message...
         if (err == WEAVE_ERROR_MESSAGE_TOO_LONG)
         {
-            // The Weave message decoding logic expects message data to be in contiguous memory.
+            // Although message decoding can work on a chain of buffers, received messages are
+            // delivered to the exchange layer and the profiles in a single contiguous buffer.
             // Therefore, if the packet buffer containing the initial portion of the message is
             // not big enough to hold the entirety of the message, the data must be moved into
             // a new buffer that is big enough.
@@ -1597,18 +1833,42 @@ void WeaveConnection::HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *da
                 payloadBuf->SetDataLength(payloadLen);
             }
 
-            // Otherwise we need to keep the buffer so we can parse the remaining data, so copy the
-            // payload data into a new buffer and arrange to pass the new buffer to the application.
+            // Otherwise we need to keep the data that follows the message so we can parse it. If that
+            // data is shorter than the payload, move it into a new buffer at the head of the receive
+            // queue and give the original buffer to the application layer. Otherwise copy the payload
+            // data into a new buffer and arrange to pass the new buffer to the application.
             else
             {
-                payloadBuf = PacketBuffer::New(0);
-                if (payloadBuf != NULL)
+                PacketBuffer *newBuf = NULL;
+
+                if (data->DataLength() < payloadLen)
+                    newBuf = PacketBuffer::New(0);
+
+                if (newBuf != NULL)
                 {
-                    memcpy(payloadBuf->Start(), payload, payloadLen);
+                    memcpy(newBuf->Start(), data->Start(), data->DataLength());
+                    newBuf->SetDataLength(data->DataLength());
+
+                    payloadBuf = data;
+                    data = data->DetachTail();
+                    if (data != NULL)
+                        newBuf->AddToEnd(data);
+                    data = newBuf;
+
+                    payloadBuf->SetStart(payload);
                     payloadBuf->SetDataLength(payloadLen);
                 }
                 else
-                    err = WEAVE_ERROR_NO_MEMORY;
+                {
+                    payloadBuf = PacketBuffer::New(0);
+                    if (payloadBuf != NULL)
+                    {
+                        memcpy(payloadBuf->Start(), payload, payloadLen);
+                        payloadBuf->SetDataLength(payloadLen);
+                    }
+                    else
+                        err = WEAVE_ERROR_NO_MEMORY;
+                }
             }
         }
 
@@ -1766,6 +2026,9 @@ void WeaveConnection::Init(WeaveMessageLayer *msgLayer)
     OnReceiveError = NULL;
     memset(&mPeerAddrs, 0, sizeof(mPeerAddrs));
     mTcpEndPoint = NULL;
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    memset(&mConnectAttempts, 0, sizeof(mConnectAttempts));
+#endif
 #if CONFIG_NETWORK_LAYER_BLE
     mBleEndPoint = NULL;
 #endif
@@ -1785,6 +2048,19 @@ void WeaveConnection::Init(WeaveMessageLayer *msgLayer)
     mFlags = 0;
 }
 
+// Drop a reference to the connection object, returning the object to the message layer's pool
+// when the last reference goes away.
+void WeaveConnection::DecrementRefCount(void)
+{
+    VerifyOrDie(mRefCount != 0);
+    mRefCount--;
+
+    if (mRefCount == 0)
+    {
+        MessageLayer->FreeConnection(this);
+    }
+}
+
 // Default OnConnectionClosed handler.
 //
 // This handler is installed in the OnConnectionClosed callback of all new WeaveConnection objects.
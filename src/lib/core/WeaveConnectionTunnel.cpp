@@ -104,6 +104,7 @@ void WeaveConnectionTunnel::Shutdown()
         OnShutdown = NULL;
     }
 
+    mMessageLayer->FreeConnectionTunnel(this);
     mMessageLayer = NULL;
 }
 
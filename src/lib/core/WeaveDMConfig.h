@@ -397,7 +397,7 @@
  *  @brief
  *    Determines the maximum number of dirty items that can be stored in the granular trait data
  *    dirty/delete stores. This is a function of the peak # of handles across all trait instances that can be made dirty
- *    within any given evaluation cycle.
+ *    before the slowest subscription to those trait instances has been notified of them.
  */
 #ifndef WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE
 #define WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE  10
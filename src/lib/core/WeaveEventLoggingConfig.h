@@ -176,4 +176,169 @@
 #define WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT 0
 #endif
 
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_STAGING
+ *
+ * @brief
+ *   Enable or disable per-thread staging rings, through which
+ *   application threads may log events without taking the event
+ *   logging critical section.  Staged events are merged into the
+ *   event buffers in batches on the Weave thread.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_STAGING
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS
+ *
+ * @brief
+ *   The number of staging rings, and so the number of threads that
+ *   may stage events at any one time.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS 8
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES
+ *
+ * @brief
+ *   The number of events each staging ring holds before the
+ *   producing thread has to merge them itself.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES 32
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_STAGING_MAX_EVENT_SIZE
+ *
+ * @brief
+ *   The largest encoded event data, in bytes, that may be staged.
+ *   Larger events must be logged directly.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_STAGING_MAX_EVENT_SIZE
+#define WEAVE_CONFIG_EVENT_LOGGING_STAGING_MAX_EVENT_SIZE 256
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+ *
+ * @brief
+ *   Enable or disable support for a compact in-buffer event encoding,
+ *   in which the profile ID and event type of an event are replaced by
+ *   a one-byte reference into a dictionary of recurring headers.
+ *   Events are expanded back to the standard encoding when they are
+ *   fetched.  When enabled, the encoding is still off until turned on
+ *   with LoggingManagement::SetCompactEncoding().
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+#define WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE
+ *
+ * @brief
+ *   The number of distinct profile ID and event type pairs the compact
+ *   encoding can refer to.  Events of other types are stored in the
+ *   standard encoding.  Must not exceed 256.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE
+#define WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE 32
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+ *
+ * @brief
+ *   Enable or disable support for event buffers that live in
+ *   memory-mapped files (see LoggingManagement::MapEventBuffer()).
+ *   The state of a mapped buffer is kept current in the file as
+ *   events are logged, so buffered events survive a restart or crash
+ *   without a SerializeEvents() / LoadEvents() pass.  Requires POSIX
+ *   mmap().
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+#define WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+ *
+ * @brief
+ *   Enable or disable a cache of event lists encoded by
+ *   LoggingManagement::FetchEventsSince().  Runs of events are
+ *   encoded once per starting event ID and importance, and copied
+ *   as-is to every subscription fetching from the same point in the
+ *   log, rather than being re-read from the event buffers and
+ *   re-encoded for each one.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+#define WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES
+ *
+ * @brief
+ *   The number of encoded event lists held by the event batch cache.
+ *   The least recently used list is replaced when the cache is full.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES
+#define WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES 4
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_SIZE
+ *
+ * @brief
+ *   The size, in bytes, of each encoded event list in the event batch
+ *   cache.  This is best set to about the space available for events
+ *   in a single NotifyRequest; events larger than this are never
+ *   cached.  Must not exceed 65535.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_SIZE
+#define WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_SIZE 1024
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS
+ *
+ * @brief
+ *   The largest number of events held in each encoded event list in
+ *   the event batch cache.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS
+#define WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS 64
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_QUERY
+ *
+ * @brief
+ *   Enable or disable LoggingManagement::FetchMatchingEvents(), which
+ *   fetches only the events of a given profile and time range.  The
+ *   event buffers are summarized in blocks of consecutive events, so
+ *   that a query can pass over blocks holding no matching events
+ *   without decoding them.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_QUERY
+#define WEAVE_CONFIG_EVENT_LOGGING_QUERY 0
+#endif
+
+/**
+ * @def WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS
+ *
+ * @brief
+ *   The number of summary blocks kept for each event buffer.  Each
+ *   block covers about an equal share of the buffer; more blocks let
+ *   queries pass over the log in finer steps, at the cost of about
+ *   80 bytes per block per importance level.
+ */
+#ifndef WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS
+#define WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS 8
+#endif
+
 #endif /* WEAVEEVENTLOGGINGCONFIG_H */
@@ -61,6 +61,12 @@ using namespace nl::Weave::Encoding;
 WeaveExchangeManager::WeaveExchangeManager()
 {
     State = kState_NotInitialized;
+
+    // Thread the pools onto their free lists here as well as in Init(), so that, as with the linear
+    // scans the free lists replaced, bindings can be allocated from a manager that has not yet been
+    // initialized (the TDM and WDM unit tests rely on this).
+    InitContextPool();
+    InitBindingPool();
 }
 
 /**
@@ -86,9 +92,7 @@ WEAVE_ERROR WeaveExchangeManager::Init(WeaveMessageLayer *msgLayer)
 
     NextExchangeId = GetRandU16();
 
-    memset(ContextPool, 0, sizeof(ContextPool));
-    mContextsInUse = 0;
-
+    InitContextPool();
     InitBindingPool();
 
     memset(UMHandlerPool, 0, sizeof(UMHandlerPool));
@@ -106,6 +110,18 @@ WEAVE_ERROR WeaveExchangeManager::Init(WeaveMessageLayer *msgLayer)
     mWRMPTimeStampBase = System::Timer::GetCurrentEpoch();
 
     mWRMPCurrentTimerExpiry = 0;
+
+    memset(&mWRMPAckStats, 0, sizeof(mWRMPAckStats));
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    mAdaptiveRetransTimeoutEnabled = false;
+#endif
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    mAckAggregationEnabled = false;
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    mCongestionControlEnabled = false;
+    mWRMPNextQueueSeq = 0;
+#endif
 #endif
 
     State = kState_Initialized;
@@ -136,6 +152,17 @@ WEAVE_ERROR WeaveExchangeManager::Shutdown()
             MessageLayer->OnMessageReceived = NULL;
             MessageLayer->OnAcceptError = NULL;
         }
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+        // Release any connections held open for sharing between bindings.
+        for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+        {
+            if (SharedConnectionPool[i].Con != NULL)
+            {
+                Binding::RemoveSharedConnection(SharedConnectionPool[i], false);
+            }
+        }
+#endif
+
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
         WRMPStopTimer();
 
@@ -233,11 +260,6 @@ ExchangeContext *WeaveExchangeManager::NewContext(const uint64_t &peerNodeId, co
         ec->mWRMPThrottleTimeout = 0;
         //Internal and for Debug Only; When set, Exchange Layer does not send Ack.
         ec->SetDropAck(false);
-        //Initialize the App callbacks to NULL
-        ec->OnThrottleRcvd = NULL;
-        ec->OnDDRcvd = NULL;
-        ec->OnAckRcvd = NULL;
-        ec->OnSendError = NULL;
 #endif
 #if WEAVE_CONFIG_ENABLE_EPHEMERAL_UDP_PORT
         ec->SetUseEphemeralUDPPort(MessageLayer->EphemeralUDPPortEnabled());
@@ -498,6 +520,17 @@ void WeaveExchangeManager::HandleConnectionReceived(WeaveConnection *con)
 
 void WeaveExchangeManager::HandleConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr)
 {
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    // Stop offering the connection for sharing before failing the bindings that use it.
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        if (SharedConnectionPool[i].Con == con)
+        {
+            Binding::RemoveSharedConnection(SharedConnectionPool[i], true);
+        }
+    }
+#endif
+
     for (int i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; i++)
     {
         BindingPool[i].OnConnectionClosed(con, conErr);
@@ -547,30 +580,100 @@ size_t WeaveExchangeManager::ExpireExchangeTimers(void)
 }
 #endif
 
+/**
+ *  Initialize the pool of ExchangeContexts and thread all of its entries onto the free list.
+ *
+ */
+void WeaveExchangeManager::InitContextPool(void)
+{
+    memset(ContextPool, 0, sizeof(ContextPool));
+
+    mFreeContextList = NULL;
+    for (int i = WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS - 1; i >= 0; i--)
+    {
+        ContextPool[i].mNextFree = mFreeContextList;
+        mFreeContextList = &ContextPool[i];
+    }
+
+    mContextsInUse = 0;
+}
+
 ExchangeContext *WeaveExchangeManager::AllocContext()
 {
-    ExchangeContext *ec = (ExchangeContext *) ContextPool;
+    ExchangeContext *ec;
 
     WEAVE_FAULT_INJECT(FaultInjection::kFault_AllocExchangeContext,
                        return NULL);
 
-    for (int i = 0; i < WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS; i++, ec++)
-        if (ec->ExchangeMgr == NULL)
-        {
-            *ec = ExchangeContext();
-            ec->ExchangeMgr = this;
-            ec->mRefCount = 1;
-            mContextsInUse++;
-            MessageLayer->SignalMessageLayerActivityChanged();
+    ec = mFreeContextList;
+    if (ec == NULL)
+    {
+        WeaveLogError(ExchangeManager, "Alloc ctxt FAILED");
+        return NULL;
+    }
+    mFreeContextList = ec->mNextFree;
+    ec->mNextFree = NULL;
+
+    // Reset the state of the context.  Both the callers of this method (NewContext() and
+    // DispatchMessage()) assign ExchangeId, PeerNodeId, mMsgProtocolVersion and the WRMP
+    // timing state unconditionally, so only the remaining fields are cleared here.
+    //
+    // NOTE: Please keep these in declared order to make it easier to keep them in sync.
+    ec->ExchangeMgr = this;
+    ec->Con = NULL;
+    ec->PeerAddr = IPAddress::Any;
+    ec->PeerIntf = INET_NULL_INTERFACEID;
+    ec->PeerPort = 0;
+    ec->AppState = NULL;
+    ec->AllowDuplicateMsgs = false;
+    ec->EncryptionType = kWeaveEncryptionType_None;
+    ec->KeyId = WeaveKeyId::kNone;
+    ec->RetransInterval = 0;
+    ec->ResponseTimeout = 0;
+    ec->OnMessageReceived = NULL;
+    ec->OnResponseTimeout = NULL;
+    ec->OnRetransmissionTimeout = NULL;
+    ec->OnConnectionClosed = NULL;
+    ec->OnKeyError = NULL;
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    ec->OnThrottleRcvd = NULL;
+    ec->OnDDRcvd = NULL;
+    ec->OnSendError = NULL;
+    ec->OnAckRcvd = NULL;
+#endif
+    ec->msg = NULL;
+    ec->backoff = 0;
+    ec->currentBcastMsgID = 0;
+    ec->msgsReceived = 0;
+    ec->rebroadcastThreshold = 0;
+    ec->mFlags = 0;
+    ec->mPendingPeerAckId = 0;
+    ec->mRefCount = 1;
+
+    mContextsInUse++;
+    MessageLayer->SignalMessageLayerActivityChanged();
 #if defined(WEAVE_EXCHANGE_CONTEXT_DETAIL_LOGGING)
-            WeaveLogProgress(ExchangeManager, "ec++ id: %d, inUse: %d, addr: 0x%x", EXCHANGE_CONTEXT_ID(ec - ContextPool), mContextsInUse, ec);
+    WeaveLogProgress(ExchangeManager, "ec++ id: %d, inUse: %d, addr: 0x%x", EXCHANGE_CONTEXT_ID(ec - ContextPool), mContextsInUse, ec);
 #endif
-            SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kExchangeMgr_NumContexts);
+    SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kExchangeMgr_NumContexts);
 
-            return ec;
-        }
-    WeaveLogError(ExchangeManager, "Alloc ctxt FAILED");
-    return NULL;
+    return ec;
+}
+
+/**
+ *  Return an ExchangeContext, whose last reference has been released, to the free list.
+ *
+ *  @param[in]  ec              A pointer to the ExchangeContext to be returned. The object
+ *                              must be previously allocated from this #WeaveExchangeManager.
+ *
+ */
+void WeaveExchangeManager::FreeContext(ExchangeContext *ec)
+{
+    ec->ExchangeMgr = NULL;
+    ec->mNextFree = mFreeContextList;
+    mFreeContextList = ec;
+
+    mContextsInUse--;
 }
 
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
@@ -612,6 +715,149 @@ void WeaveExchangeManager::WRMPProcessDDMessage(uint32_t PauseTimeMillis, uint64
     // Schedule next physical wakeup
     WRMPStartTimer();
 }
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+
+enum
+{
+    kAckListEntryLen                    = 7,    // Exchange Id (2), Flags (1), Ack Msg Id (4)
+    kAckListEntryFlag_SenderInitiated   = 0x01  // The sender of the Ack List initiated the exchange.
+};
+
+/**
+ *  Send the acknowledgments pending on other exchanges with the peer of the given
+ *  exchange in a WRMP Ack List message on that exchange. The pending acknowledgment
+ *  of the exchange itself, if any, is piggybacked on the message.
+ *
+ *  Only the acknowledgments of exchanges that use the same key as the given exchange
+ *  are included, and only if the peer has advertised that it accepts Ack Lists.
+ *
+ *  @param[in]    ec          The exchange on which to send the Ack List.
+ *
+ *  @param[in]    minAcks     The smallest number of acknowledgments pending on other
+ *                            exchanges for which an Ack List is sent.
+ *
+ *  @return  True if an Ack List was sent, false otherwise.
+ *
+ */
+bool WeaveExchangeManager::WRMPSendAckList(ExchangeContext *ec, size_t minAcks)
+{
+    WEAVE_ERROR err             = WEAVE_NO_ERROR;
+    ExchangeContext *ackedEC[WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS];
+    size_t numAcks              = 0;
+    size_t maxAcks;
+    PacketBuffer *msgBuf        = NULL;
+    uint8_t *p;
+    bool sent                   = false;
+
+    VerifyOrExit(mAckAggregationEnabled && ec->PeerAcceptsAckLists() && ec->Con == NULL &&
+                 ec->mMsgProtocolVersion == kWeaveMessageVersion_V2, );
+
+    for (int i = 0; i < WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS; i++)
+    {
+        ExchangeContext *otherEC = &ContextPool[i];
+
+        if (otherEC != ec && otherEC->ExchangeMgr != NULL && otherEC->IsAckPending() &&
+            otherEC->PeerNodeId == ec->PeerNodeId && otherEC->Con == NULL &&
+            otherEC->EncryptionType == ec->EncryptionType && otherEC->KeyId == ec->KeyId)
+        {
+            ackedEC[numAcks++] = otherEC;
+        }
+    }
+
+    VerifyOrExit(numAcks >= minAcks && numAcks > 0, );
+
+    msgBuf = PacketBuffer::New();
+    VerifyOrExit(msgBuf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    maxAcks = msgBuf->AvailableDataLength() / kAckListEntryLen;
+    if (numAcks > maxAcks)
+    {
+        numAcks = maxAcks;
+    }
+
+    p = msgBuf->Start();
+    for (size_t i = 0; i < numAcks; i++)
+    {
+        LittleEndian::Write16(p, ackedEC[i]->ExchangeId);
+        Write8(p, ackedEC[i]->IsInitiator() ? kAckListEntryFlag_SenderInitiated : 0);
+        LittleEndian::Write32(p, ackedEC[i]->mPendingPeerAckId);
+    }
+    msgBuf->SetDataLength(numAcks * kAckListEntryLen);
+
+    err = ec->SendMessage(nl::Weave::Profiles::kWeaveProfile_Common, nl::Weave::Profiles::Common::kMsgType_WRMP_Ack_List,
+                          msgBuf, ExchangeContext::kSendFlag_NoAutoRequestAck);
+    msgBuf = NULL;
+    SuccessOrExit(err);
+
+    for (size_t i = 0; i < numAcks; i++)
+    {
+        ackedEC[i]->SetAckPending(false);
+    }
+
+    mWRMPAckStats.AckListsSent++;
+    mWRMPAckStats.AggregatedAcksSent += numAcks;
+    sent = true;
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(ExchangeManager, "Failed to send Ack List to Peer %016" PRIX64 ":%ld", ec->PeerNodeId, (long)err);
+    }
+    if (msgBuf != NULL)
+    {
+        PacketBuffer::Free(msgBuf);
+    }
+
+    return sent;
+}
+
+/**
+ *  Process the acknowledgments carried in a received WRMP Ack List message.
+ *
+ *  Each acknowledgment is applied to the exchange with the sender that it names,
+ *  provided that exchange uses the key the Ack List was received under.
+ *
+ *  @param[in]    msgInfo     General Weave message information for the Ack List message.
+ *
+ *  @param[in]    msgBuf      The payload of the Ack List message.
+ *
+ */
+void WeaveExchangeManager::WRMPProcessAckList(const WeaveMessageInfo *msgInfo, const PacketBuffer *msgBuf)
+{
+    const uint8_t *p = msgBuf->Start();
+    WeaveExchangeHeader ackHeader;
+
+    memset(&ackHeader, 0, sizeof(ackHeader));
+
+    mWRMPAckStats.AckListsReceived++;
+
+    for (uint16_t len = msgBuf->DataLength(); len >= kAckListEntryLen; len -= kAckListEntryLen)
+    {
+        uint16_t exchangeId = LittleEndian::Read16(p);
+        bool senderInitiated = (Read8(p) & kAckListEntryFlag_SenderInitiated) != 0;
+
+        ackHeader.AckMsgId = LittleEndian::Read32(p);
+
+        for (int i = 0; i < WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS; i++)
+        {
+            ExchangeContext *ec = &ContextPool[i];
+
+            if (ec->ExchangeMgr != NULL && ec->ExchangeId == exchangeId && ec->IsInitiator() != senderInitiated &&
+                ec->PeerNodeId == msgInfo->SourceNodeId && ec->Con == msgInfo->InCon &&
+                ec->EncryptionType == msgInfo->EncryptionType && ec->KeyId == msgInfo->KeyId)
+            {
+                if (ec->WRMPHandleRcvdAck(&ackHeader, msgInfo) == WEAVE_NO_ERROR)
+                {
+                    mWRMPAckStats.AggregatedAcksReceived++;
+                }
+                break;
+            }
+        }
+    }
+}
+
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
 
 static void DefaultOnMessageReceived(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo, uint32_t profileId,
@@ -723,6 +969,18 @@ void WeaveExchangeManager::DispatchMessage(WeaveMessageInfo *msgInfo, PacketBuff
         //Return after processing Delayed Delivery message
         ExitNow(err = WEAVE_NO_ERROR);
     }//If delayed delivery Msg
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    //Received Ack List Message: Process the acks it carries for other exchanges. The message is then
+    //dispatched to its own exchange like any other, so that the ack piggybacked on it is processed too.
+    if (exchangeHeader.ProfileId == nl::Weave::Profiles::kWeaveProfile_Common &&
+        exchangeHeader.MessageType == nl::Weave::Profiles::Common::kMsgType_WRMP_Ack_List &&
+        msgInfo->MessageVersion == kWeaveMessageVersion_V2 &&
+        (msgInfo->Flags & kWeaveMessageFlag_DuplicateMessage) == 0)
+    {
+        WRMPProcessAckList(msgInfo, msgBuf);
+    }
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
 #endif
 
     // Search for an existing exchange that the message applies to. If a match is found...
@@ -1144,12 +1402,46 @@ void WeaveExchangeManager::NotifyKeyFailed(uint64_t peerNodeId, uint16_t keyId,
         }
     }
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    // Stop sharing any connection whose session key has failed.
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        Binding::SharedConnection & sharedCon = SharedConnectionPool[i];
+        if (sharedCon.Con != NULL && sharedCon.IsReady && sharedCon.KeyId == keyId && sharedCon.PeerNodeId == peerNodeId)
+        {
+            Binding::RemoveSharedConnection(sharedCon, false);
+        }
+    }
+#endif
+
     for (int i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; i++)
     {
         BindingPool[i].OnKeyFailed(peerNodeId, keyId, keyErr);
     }
 }
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+/**
+ *  Close any shared connections that are no longer used by a Binding.
+ *
+ *  Connections shared between Bindings configured with Binding::Configuration::Transport_SharedTCP()
+ *  are normally kept open for #WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT milliseconds after their
+ *  last Binding closes.  This method closes them, and ends their sessions, immediately.
+ */
+void WeaveExchangeManager::CloseIdleSharedConnections(void)
+{
+    for (int i = 0; i < WEAVE_CONFIG_MAX_SHARED_CONNECTIONS; i++)
+    {
+        if (SharedConnectionPool[i].Con != NULL && SharedConnectionPool[i].UserCount == 0)
+        {
+            Binding::RemoveSharedConnection(SharedConnectionPool[i], false);
+        }
+    }
+}
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
 /**
  *  Invoked when the security manager becomes available for initiating new secure sessions.
  */
@@ -1205,10 +1497,21 @@ void WeaveExchangeManager::RetransPendingAppGroupMsgs(uint64_t peerNodeId)
     {
         if (re->exchContext != NULL && re->exchContext->PeerNodeId == peerNodeId && WeaveKeyId::IsAppGroupKey(re->exchContext->KeyId))
         {
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            // Messages held back by the congestion window have not been sent yet.
+            if (re->sendCount == 0)
+                continue;
+#endif
+
             // Decrement counter to discount the first sent message, which
             // was ignored by receiver due to un-synchronized message counter.
             re->sendCount--;
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+            // The message is still sent twice, so its ack yields no round trip time.
+            re->retransmitted = true;
+#endif
+
             // Retramsmit message.
             SendFromRetransTable(re);
         }
@@ -1275,6 +1578,12 @@ void WeaveExchangeManager::TicklessDebugDumpRetransTable(const char *log) { retu
 void WeaveExchangeManager::WRMPExecuteActions(void)
 {
     ExchangeContext *ec               = NULL;
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    bool retransmitted[WEAVE_CONFIG_WRMP_RETRANS_TABLE_SIZE] = { false };
+#endif
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    bool backedOff[WEAVE_CONFIG_WRMP_RETRANS_TABLE_SIZE] = { false };
+#endif
 
     //Process Ack Tables for all ExchangeContexts
     ec = (ExchangeContext *)ContextPool;
@@ -1292,8 +1601,15 @@ void WeaveExchangeManager::WRMPExecuteActions(void)
 #if defined(WRMP_TICKLESS_DEBUG)
                 WeaveLogProgress(ExchangeManager, "WRMPExecuteActions sending ACK");
 #endif
-                //Send the Ack in a Common::Null message
-                ec->SendCommonNullMessage();
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+                //Send the Ack along with those pending on other exchanges with the peer in an Ack List message,
+                //or else in a Common::Null message
+                if (!WRMPSendAckList(ec, 1))
+#endif
+                {
+                    //Send the Ack in a Common::Null message
+                    ec->SendCommonNullMessage();
+                }
                 ec->SetAckPending(false);
             }
         }
@@ -1310,6 +1626,14 @@ void WeaveExchangeManager::WRMPExecuteActions(void)
         {
             WEAVE_ERROR err = WEAVE_NO_ERROR;
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            // Messages held back by the congestion window are sent by WRMPSendQueuedMessages().
+            if (RetransTable[i].sendCount == 0)
+            {
+                continue;
+            }
+#endif
+
             if (0 == RetransTable[i].nextRetransTime)
             {
                 uint8_t sendCount = RetransTable[i].sendCount;
@@ -1322,9 +1646,46 @@ void WeaveExchangeManager::WRMPExecuteActions(void)
                     WeaveLogError(ExchangeManager, "Failed to Send Weave MsgId:%08" PRIX32 " sendCount: %" PRIu8 " max retries: %" PRIu8,
                                   RetransTable[i].msgId, sendCount, ec->mWRMPConfig.mMaxRetrans);
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+                    // The peer may not accept coalesced datagrams after all, so send to it directly from now on.
+                    MessageLayer->RemoveCoalescingPeer(ec->PeerAddr);
+#endif
+
                     // Remove from Table
                     ClearRetransmitTable(RetransTable[i]);
                 }
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+                else if (mCongestionControlEnabled)
+                {
+                    uint16_t retransToPeer = 0;
+
+                    for (int j = 0; j < i; j++)
+                    {
+                        if (retransmitted[j] && RetransTable[j].exchContext != NULL &&
+                            RetransTable[j].exchContext->PeerNodeId == ec->PeerNodeId)
+                        {
+                            retransToPeer++;
+                        }
+                    }
+
+                    // A loss halves the peer's congestion window, once per timer tick however
+                    // many messages to the peer are due.
+                    if (retransToPeer == 0)
+                    {
+                        FabricState->ShrinkPeerCongestionWindow(ec->PeerNodeId);
+                    }
+
+                    // Pace retransmissions: send no more than a window's worth to the peer this
+                    // tick and leave the rest for the following ticks.
+                    if (retransToPeer >= FabricState->GetPeerCongestionWindow(ec->PeerNodeId))
+                    {
+                        RetransTable[i].nextRetransTime = 1;
+                        continue;
+                    }
+
+                    retransmitted[i] = true;
+                }
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
 
                 if (err == WEAVE_NO_ERROR)
                 {
@@ -1334,6 +1695,28 @@ void WeaveExchangeManager::WRMPExecuteActions(void)
 
                 if (err == WEAVE_NO_ERROR)
                 {
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+                    // Back off the peer's retransmit timeout until a new round trip time is measured,
+                    // once per timer tick however many messages to the peer are retransmitted.
+                    if (mAdaptiveRetransTimeoutEnabled)
+                    {
+                        bool peerBackedOff = false;
+
+                        for (int j = 0; j < i && !peerBackedOff; j++)
+                        {
+                            peerBackedOff = backedOff[j] && RetransTable[j].exchContext != NULL &&
+                                RetransTable[j].exchContext->PeerNodeId == ec->PeerNodeId;
+                        }
+
+                        if (!peerBackedOff)
+                        {
+                            FabricState->BackOffPeerRetransTimeout(ec->PeerNodeId);
+                        }
+
+                        backedOff[i] = true;
+                    }
+#endif
+
                     // If the retransmission was successful, update the passive timer
                     RetransTable[i].nextRetransTime = ec->GetCurrentRetransmitTimeout() / mWRMPTimerInterval;
 #if defined(DEBUG)
@@ -1353,6 +1736,12 @@ void WeaveExchangeManager::WRMPExecuteActions(void)
         }
     }
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    // Send any messages that the congestion window or throttling have been holding back
+    // and that may now go out.
+    WRMPSendQueuedMessages();
+#endif
+
     TicklessDebugDumpRetransTable("WRMPExecuteActions Dumping RetransTable entries after processing");
 }
 
@@ -1522,9 +1911,15 @@ WEAVE_ERROR WeaveExchangeManager::AddToRetransTable(ExchangeContext *ec, PacketB
             RetransTable[i].msgId = messageId;
             RetransTable[i].msgBuf = msgBuf;
             RetransTable[i].sendCount = 0;
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+            RetransTable[i].retransmitted = false;
+#endif
             RetransTable[i].nextRetransTime = GetTickCounterFromTimeDelta(ec->GetCurrentRetransmitTimeout() + System::Timer::GetCurrentEpoch(), mWRMPTimeStampBase);
 
             RetransTable[i].msgCtxt = msgCtxt;
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            RetransTable[i].queueSeq = mWRMPNextQueueSeq++;
+#endif
             *rEntry = &RetransTable[i];
             //Increment the reference count
             ec->AddRef();
@@ -1598,6 +1993,13 @@ WEAVE_ERROR WeaveExchangeManager::SendFromRetransTable(RetransTableEntry *entry)
         entry->msgBuf->SetDataLength(len);
 
         //Update the counters
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+        if (entry->sendCount != 0)
+        {
+            entry->retransmitted = true;
+        }
+        entry->sendTime = static_cast<uint32_t>(System::Timer::GetCurrentEpoch());
+#endif
         entry->sendCount++;
     }
     else
@@ -1645,6 +2047,11 @@ void WeaveExchangeManager::ClearRetransmitTable(ExchangeContext *ec)
             ClearRetransmitTable(RetransTable[i]);
         }
     }
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    // Messages to the same peer may have been waiting for room in the congestion window.
+    WRMPSendQueuedMessages();
+#endif
 }
 
 /**
@@ -1702,6 +2109,11 @@ void WeaveExchangeManager::FailRetransmitTableEntries(ExchangeContext *ec, WEAVE
                 ec->OnSendError(ec, err, msgCtxt);
         }
     }
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    // Messages to the same peer may have been waiting for room in the congestion window.
+    WRMPSendQueuedMessages();
+#endif
 }
 
 /**
@@ -1746,6 +2158,12 @@ void WeaveExchangeManager::WRMPStartTimer()
 #endif
             }
 
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+            // Messages held back by the congestion window have no retransmit time yet.
+            if (RetransTable[i].sendCount == 0)
+                continue;
+#endif
+
             // When do we need to next wake up for WRMP retransmit?
             if (RetransTable[i].nextRetransTime < nextWakeTime) {
                 nextWakeTime = RetransTable[i].nextRetransTime;
@@ -1802,7 +2220,135 @@ void WeaveExchangeManager::WRMPStartTimer()
 void WeaveExchangeManager::WRMPStopTimer()
 {
     MessageLayer->SystemLayer->CancelTimer(WRMPTimeout, this);
+
+    // Forget the expiry of the cancelled timer, so that a later wakeup at the same time arms it again.
+    mWRMPCurrentTimerExpiry = 0;
+}
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+/**
+ *  Determine whether a new reliable message may be sent to a peer right away.
+ *
+ *  A message may be sent when the number of messages to the peer that await
+ *  acknowledgment is below the peer's congestion window, and no earlier message
+ *  to the peer is still being held back. While congestion control is disabled,
+ *  only the latter applies.
+ *
+ *  @param[in]    peerNodeId    The node identifier of the peer.
+ *
+ *  @return true if the message may be sent, false if it must wait in the
+ *          retransmission table.
+ *
+ */
+bool WeaveExchangeManager::WRMPCanSendToPeer(uint64_t peerNodeId) const
+{
+    uint16_t inFlight;
+    uint16_t queued;
+
+    GetWRMPPeerMessageCounts(peerNodeId, inFlight, queued);
+
+    if (!mCongestionControlEnabled)
+        return queued == 0;
+
+    return queued == 0 && inFlight < FabricState->GetPeerCongestionWindow(peerNodeId);
 }
+
+/**
+ *  Send, oldest first, the messages in the retransmission table that have been
+ *  held back by the congestion window, for as long as their peers' windows have
+ *  room and their exchanges are not throttled.
+ *
+ */
+void WeaveExchangeManager::WRMPSendQueuedMessages(void)
+{
+    bool sent = false;
+
+    while (true)
+    {
+        RetransTableEntry *next = NULL;
+        ExchangeContext *ec;
+        void *msgCtxt;
+        WEAVE_ERROR err;
+
+        for (int i = 0; i < WEAVE_CONFIG_WRMP_RETRANS_TABLE_SIZE; i++)
+        {
+            RetransTableEntry *entry = &RetransTable[i];
+            uint16_t inFlight;
+            uint16_t queued;
+
+            ec = entry->exchContext;
+            if (ec == NULL || entry->sendCount != 0 || ec->mWRMPThrottleTimeout != 0)
+                continue;
+
+            if (next != NULL && static_cast<int16_t>(entry->queueSeq - next->queueSeq) > 0)
+                continue;
+
+            GetWRMPPeerMessageCounts(ec->PeerNodeId, inFlight, queued);
+            if (mCongestionControlEnabled && inFlight >= FabricState->GetPeerCongestionWindow(ec->PeerNodeId))
+                continue;
+
+            next = entry;
+        }
+
+        if (next == NULL)
+            break;
+
+        ec = next->exchContext;
+        msgCtxt = next->msgCtxt;
+
+        // Expire any virtual ticks that have expired so the retransmit time is counted from now
+        WRMPExpireTicks();
+        next->nextRetransTime = ec->GetCurrentRetransmitTimeout() / mWRMPTimerInterval;
+
+        // Send from Table (if the operation fails, the entry is cleared)
+        err = SendFromRetransTable(next);
+        sent = true;
+
+        if (err != WEAVE_NO_ERROR && ec->OnSendError)
+        {
+            ec->OnSendError(ec, err, msgCtxt);
+        }
+    }
+
+    if (sent)
+    {
+        // Schedule next physical wakeup
+        WRMPStartTimer();
+    }
+}
+
+/**
+ *  Count the reliable messages to a peer that await acknowledgment, and those
+ *  that the congestion window is holding back.
+ *
+ *  @param[in]    peerNodeId    The node identifier of the peer.
+ *
+ *  @param[out]   inFlight      The number of messages sent to the peer that have not
+ *                              been acknowledged.
+ *
+ *  @param[out]   queued        The number of messages to the peer that have not been
+ *                              sent yet.
+ *
+ */
+void WeaveExchangeManager::GetWRMPPeerMessageCounts(uint64_t peerNodeId, uint16_t &inFlight, uint16_t &queued) const
+{
+    inFlight = 0;
+    queued = 0;
+
+    for (int i = 0; i < WEAVE_CONFIG_WRMP_RETRANS_TABLE_SIZE; i++)
+    {
+        if (RetransTable[i].exchContext != NULL && RetransTable[i].exchContext->PeerNodeId == peerNodeId)
+        {
+            if (RetransTable[i].sendCount == 0)
+                queued++;
+            else
+                inFlight++;
+        }
+    }
+}
+
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
 
 /**
@@ -1812,12 +2358,20 @@ void WeaveExchangeManager::WRMPStopTimer()
 void WeaveExchangeManager::InitBindingPool(void)
 {
     memset(BindingPool, 0, sizeof(BindingPool));
-    for (size_t i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; ++i)
+    mFreeBindingList = NULL;
+    for (int i = WEAVE_CONFIG_MAX_BINDINGS - 1; i >= 0; --i)
     {
         BindingPool[i].mState = Binding::kState_NotAllocated;
         BindingPool[i].mExchangeManager = this;
+        BindingPool[i].mNextFree = mFreeBindingList;
+        mFreeBindingList = &BindingPool[i];
     }
     mBindingsInUse = 0;
+
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    memset(SharedConnectionPool, 0, sizeof(SharedConnectionPool));
+    mConnectionSharingEnabled = false;
+#endif
 }
 
 /**
@@ -1833,15 +2387,13 @@ Binding * WeaveExchangeManager::AllocBinding(void)
     WEAVE_FAULT_INJECT(FaultInjection::kFault_AllocBinding,
                            return NULL);
 
-    for (size_t i = 0; i < WEAVE_CONFIG_MAX_BINDINGS; ++i)
+    if (NULL != mFreeBindingList)
     {
-        if (Binding::kState_NotAllocated == BindingPool[i].mState)
-        {
-            pResult = &BindingPool[i];
-            ++mBindingsInUse;
-            SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kExchangeMgr_NumBindings);
-            break;
-        }
+        pResult = mFreeBindingList;
+        mFreeBindingList = pResult->mNextFree;
+        pResult->mNextFree = NULL;
+        ++mBindingsInUse;
+        SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kExchangeMgr_NumBindings);
     }
 
     return pResult;
@@ -1857,6 +2409,8 @@ Binding * WeaveExchangeManager::AllocBinding(void)
 void WeaveExchangeManager::FreeBinding(Binding * binding)
 {
     binding->mState = Binding::kState_NotAllocated;
+    binding->mNextFree = mFreeBindingList;
+    mFreeBindingList = binding;
     --mBindingsInUse;
     SYSTEM_STATS_DECREMENT(nl::Weave::System::Stats::kExchangeMgr_NumBindings);
 }
@@ -1875,7 +2429,12 @@ Binding * WeaveExchangeManager::NewBinding(Binding::EventCallback eventCallback,
     Binding * pResult = AllocBinding();
     if (NULL != pResult)
     {
-        pResult->Init(appState, eventCallback);
+        if (pResult->Init(appState, eventCallback) != WEAVE_NO_ERROR)
+        {
+            // Return the binding to the free list, otherwise it would be lost from the pool.
+            FreeBinding(pResult);
+            pResult = NULL;
+        }
     }
     return pResult;
 }
@@ -105,7 +105,9 @@ typedef enum WeaveExchangeFlags
 {
     kWeaveExchangeFlag_Initiator     = 0x1,  /**< Set when current message is sent by the initiator of an exchange */
     kWeaveExchangeFlag_AckId         = 0x2,  /**< Set when current message is an acknowledgment for a previously received message */
-    kWeaveExchangeFlag_NeedsAck      = 0x4   /**< Set when current message is requesting an acknowledgment from the recipient. */
+    kWeaveExchangeFlag_NeedsAck      = 0x4,  /**< Set when current message is requesting an acknowledgment from the recipient. */
+    kWeaveExchangeFlag_AckListSupported = 0x8 /**< Set when the sender accepts acknowledgments for several exchanges in a single
+                                                   WRMP Ack List message. */
 } WeaveExchangeFlags;
 
 /**
@@ -181,6 +183,10 @@ public:
     void SetMsgRcvdFromPeer(bool inMsgRcvdFromPeer);
     WEAVE_ERROR WRMPFlushAcks(void);
     uint32_t GetCurrentRetransmitTimeout(void);
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    bool UseFixedRetransTimeout(void) const;
+    void SetUseFixedRetransTimeout(bool inFixedRetransTimeout);
+#endif
 #endif
     void SetResponseExpected(bool inResponseExpected);
     bool AutoRequestAck() const;
@@ -383,6 +389,9 @@ private:
     void HandleConnectionClosed(WEAVE_ERROR conErr);
 
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    bool PeerAcceptsAckLists(void) const;
+#endif
     bool WRMPCheckAndRemRetransTable(uint32_t msgId, void **rCtxt);
     WEAVE_ERROR WRMPHandleRcvdAck(const WeaveExchangeHeader *exchHeader, const WeaveMessageInfo *msgInfo);
     WEAVE_ERROR WRMPHandleNeedsAck(const WeaveMessageInfo *msgInfo);
@@ -390,6 +399,7 @@ private:
 #endif
 
     uint8_t mRefCount;
+    ExchangeContext *mNextFree;                 // Next context on the exchange manager's free list (only valid while free)
 };
 
 /**
@@ -439,6 +449,12 @@ public:
 
     Binding * NewBinding(Binding::EventCallback eventCallback = Binding::DefaultEventHandler, void *appState = NULL);
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    bool ConnectionSharingEnabled(void) const;
+    void SetConnectionSharingEnabled(bool val);
+    void CloseIdleSharedConnections(void);
+#endif
+
     WEAVE_ERROR RegisterUnsolicitedMessageHandler(uint32_t profileId, ExchangeContext::MessageReceiveFunct handler,
             void *appState);
     WEAVE_ERROR RegisterUnsolicitedMessageHandler(uint32_t profileId, ExchangeContext::MessageReceiveFunct handler,
@@ -459,6 +475,40 @@ public:
 
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     void ClearMsgCounterSyncReq(uint64_t peerNodeId);
+
+    /**
+     *  @brief
+     *    Counts of the WRMP acknowledgments sent and received by the exchange manager.
+     */
+    struct WRMPAckStats
+    {
+        uint32_t SolitaryAcksSent;                  /**< Acks sent in Common::Null messages. */
+        uint32_t PiggybackedAcksSent;               /**< Pending acks carried by another message on the same exchange. */
+        uint32_t AckListsSent;                      /**< WRMP Ack List messages sent. */
+        uint32_t AggregatedAcksSent;                /**< Acks for other exchanges carried in the WRMP Ack List messages sent. */
+        uint32_t AckListsReceived;                  /**< WRMP Ack List messages received. */
+        uint32_t AggregatedAcksReceived;            /**< Acks in received WRMP Ack List messages that matched a message
+                                                         awaiting acknowledgment. */
+    };
+
+    const WRMPAckStats &GetWRMPAckStats(void) const;
+    void ResetWRMPAckStats(void);
+
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    bool AdaptiveRetransTimeoutEnabled(void) const;
+    void SetAdaptiveRetransTimeoutEnabled(bool val);
+#endif
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    bool AckAggregationEnabled(void) const;
+    void SetAckAggregationEnabled(bool val);
+#endif
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    bool CongestionControlEnabled(void) const;
+    void SetCongestionControlEnabled(bool val);
+    void GetWRMPPeerMessageCounts(uint64_t peerNodeId, uint16_t &inFlight, uint16_t &queued) const;
+#endif
 #endif
 
 private:
@@ -467,6 +517,17 @@ private:
     uint64_t mWRMPTimeStampBase;    //WRMP timer base value to add offsets to evaluate timeouts
     System::Timer::Epoch mWRMPCurrentTimerExpiry; //Tracks when the WRM timer will next expire
     uint16_t mWRMPTimerInterval;    //WRMP Timer tick period
+    WRMPAckStats mWRMPAckStats;
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    bool mAdaptiveRetransTimeoutEnabled;
+#endif
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    bool mAckAggregationEnabled;
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    bool mCongestionControlEnabled;
+    uint16_t mWRMPNextQueueSeq;     //Sequence number given to the next message added to the retrans table
+#endif
     /**
      *  @class RetransTableEntry
      *
@@ -486,12 +547,29 @@ private:
        void                 *msgCtxt;           /**< A pointer to an application level context object associated with the message. */
        uint16_t             nextRetransTime;    /**< A counter representing the next retransmission time for the message. */
        uint8_t              sendCount;          /**< A counter representing the number of times the message has been sent. */
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+       uint32_t             sendTime;           /**< The time (in milliseconds) at which the message was last sent. */
+       bool                 retransmitted;      /**< Whether the message has been sent more than once, in which case its
+                                                     acknowledgment does not yield a round trip time (Karn's algorithm). */
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+       uint16_t             queueSeq;           /**< The order in which the message was added to the table; messages held back by
+                                                     the congestion window (those not yet sent) are sent in this order. */
+#endif
     };
     void     WRMPExecuteActions(void);
     void     WRMPExpireTicks(void);
     void     WRMPStartTimer(void);
     void     WRMPStopTimer(void);
     void     WRMPProcessDDMessage(uint32_t PauseTimeMillis, uint64_t DelayedNodeId);
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    bool     WRMPSendAckList(ExchangeContext *ec, size_t minAcks);
+    void     WRMPProcessAckList(const WeaveMessageInfo *msgInfo, const PacketBuffer *msgBuf);
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    bool     WRMPCanSendToPeer(uint64_t peerNodeId) const;
+    void     WRMPSendQueuedMessages(void);
+#endif
     uint32_t GetTickCounterFromTimeDelta (uint64_t newTime,
                                           uint64_t oldTime);
     static void WRMPTimeout(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
@@ -523,15 +601,24 @@ private:
 
 
     ExchangeContext ContextPool[WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS];
+    ExchangeContext *mFreeContextList;          // Head of the list of free contexts in ContextPool
     size_t mContextsInUse;
 
     Binding BindingPool[WEAVE_CONFIG_MAX_BINDINGS];
+    Binding *mFreeBindingList;                  // Head of the list of free bindings in BindingPool
     size_t mBindingsInUse;
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    Binding::SharedConnection SharedConnectionPool[WEAVE_CONFIG_MAX_SHARED_CONNECTIONS];
+    bool mConnectionSharingEnabled;
+#endif
+
     UnsolicitedMessageHandler UMHandlerPool[WEAVE_CONFIG_MAX_UNSOLICITED_MESSAGE_HANDLERS];
     void (*OnExchangeContextChanged)(size_t numContextsInUse);
 
+    void InitContextPool(void);
     ExchangeContext *AllocContext(void);
+    void FreeContext(ExchangeContext *ec);
 
     void HandleConnectionReceived(WeaveConnection *con);
     void HandleConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr);
@@ -557,6 +644,137 @@ private:
     WeaveExchangeManager(const WeaveExchangeManager&); // not defined
 };
 
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+
+/**
+ *  Get the counts of WRMP acknowledgments sent and received since the exchange
+ *  manager was initialized or the counts were last reset.
+ */
+inline const WeaveExchangeManager::WRMPAckStats &WeaveExchangeManager::GetWRMPAckStats(void) const
+{
+    return mWRMPAckStats;
+}
+
+/**
+ *  Reset the counts of WRMP acknowledgments sent and received.
+ */
+inline void WeaveExchangeManager::ResetWRMPAckStats(void)
+{
+    memset(&mWRMPAckStats, 0, sizeof(mWRMPAckStats));
+}
+
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+/**
+ *  Determine whether retransmit timeouts are derived from the round trip times
+ *  measured to each peer.
+ */
+inline bool WeaveExchangeManager::AdaptiveRetransTimeoutEnabled(void) const
+{
+    return mAdaptiveRetransTimeoutEnabled;
+}
+
+/**
+ *  Enable or disable retransmit timeouts derived from the round trip times
+ *  measured to each peer.
+ *
+ *  While disabled, which is the default, exchanges retransmit after their
+ *  configured initial and active retransmit timeouts.
+ *
+ *  @param[in]  val     True to enable adaptive retransmit timeouts, false to disable them.
+ */
+inline void WeaveExchangeManager::SetAdaptiveRetransTimeoutEnabled(bool val)
+{
+    mAdaptiveRetransTimeoutEnabled = val;
+}
+
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+
+/**
+ *  Determine whether acknowledgments for several exchanges with the same peer
+ *  may be sent in a single WRMP Ack List message.
+ */
+inline bool WeaveExchangeManager::AckAggregationEnabled(void) const
+{
+    return mAckAggregationEnabled;
+}
+
+/**
+ *  Enable or disable the aggregation of acknowledgments for several exchanges
+ *  with the same peer into a single WRMP Ack List message.
+ *
+ *  While enabled, the exchange manager advertises in every WRMP message it sends
+ *  that it accepts Ack List messages, and it aggregates acknowledgments only
+ *  towards peers that have advertised the same.
+ *
+ *  @param[in]  val     True to enable ack aggregation, false to disable it.
+ */
+inline void WeaveExchangeManager::SetAckAggregationEnabled(bool val)
+{
+    mAckAggregationEnabled = val;
+}
+
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+/**
+ *  Determine whether the number of unacknowledged WRMP messages to each peer
+ *  is limited to a congestion window.
+ */
+inline bool WeaveExchangeManager::CongestionControlEnabled(void) const
+{
+    return mCongestionControlEnabled;
+}
+
+/**
+ *  Enable or disable limiting the number of unacknowledged WRMP messages to
+ *  each peer to a congestion window.
+ *
+ *  While disabled, which is the default, reliable messages are sent as soon as
+ *  they are submitted, and retransmissions as soon as they are due.
+ *
+ *  @param[in]  val     True to enable congestion control, false to disable it.
+ */
+inline void WeaveExchangeManager::SetCongestionControlEnabled(bool val)
+{
+    mCongestionControlEnabled = val;
+}
+
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+/**
+ *  Determine whether Bindings configured with Binding::Configuration::Transport_SharedTCP()
+ *  share TCP connections and sessions with each other.
+ */
+inline bool WeaveExchangeManager::ConnectionSharingEnabled(void) const
+{
+    return mConnectionSharingEnabled;
+}
+
+/**
+ *  Enable or disable the sharing of TCP connections and sessions between Bindings configured
+ *  with Binding::Configuration::Transport_SharedTCP().
+ *
+ *  While disabled, which is the default, such Bindings each use a connection of their own, as
+ *  with Binding::Configuration::Transport_TCP().  The setting applies to Bindings configured
+ *  after it is changed.
+ *
+ *  @param[in]  val     True to enable connection sharing, false to disable it.
+ */
+inline void WeaveExchangeManager::SetConnectionSharingEnabled(bool val)
+{
+    mConnectionSharingEnabled = val;
+}
+
+#endif // WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
 #if !WEAVE_CONFIG_ENABLE_EPHEMERAL_UDP_PORT
 
 inline bool ExchangeContext::UseEphemeralUDPPort(void) const
@@ -733,6 +733,13 @@ WEAVE_ERROR WeaveFabricState::SuspendSession(uint16_t keyId, uint64_t peerNodeId
                     sessionKey->MsgEncKey.EncKey.AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
             SuccessOrExit(err);
             break;
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+        case kWeaveEncryptionType_AES128CCM:
+            err = writer.PutBytes(ContextTag(kTag_SerializedSession_AES128CCM_Key),
+                    sessionKey->MsgEncKey.EncKey.AES128CCM.Key, WeaveEncryptionKey_AES128CCM::KeySize);
+            SuccessOrExit(err);
+            break;
+#endif
         default:
             ExitNow(err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
         }
@@ -932,6 +939,15 @@ WEAVE_ERROR WeaveFabricState::RestoreSession(uint8_t * serializedSession, uint16
         err = reader.GetBytes(sessionKey->MsgEncKey.EncKey.AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
         SuccessOrExit(err);
         break;
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    case kWeaveEncryptionType_AES128CCM:
+        err = reader.Next(kTLVType_ByteString, ContextTag(kTag_SerializedSession_AES128CCM_Key));
+        SuccessOrExit(err);
+        VerifyOrExit(reader.GetLength() == WeaveEncryptionKey_AES128CCM::KeySize, err = WEAVE_ERROR_INVALID_ARGUMENT);
+        err = reader.GetBytes(sessionKey->MsgEncKey.EncKey.AES128CCM.Key, WeaveEncryptionKey_AES128CCM::KeySize);
+        SuccessOrExit(err);
+        break;
+#endif
     default:
         ExitNow(err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
     }
@@ -1413,6 +1429,14 @@ bool WeaveFabricState::FindOrAllocPeerEntry(uint64_t peerNodeId, bool allocEntry
         PeerStates.GroupKeyRcvFlags[retPeerIndex] = 0;
 #endif
         PeerStates.UnencRcvFlags[retPeerIndex] = 0;
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+        PeerStates.SmoothedRTT[retPeerIndex] = 0;
+        PeerStates.RTTVariance[retPeerIndex] = 0;
+        PeerStates.RetransBackoff[retPeerIndex] = 0;
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+        PeerStates.CongestionWindow[retPeerIndex] = 0;
+#endif
         retVal = true;
     }
 
@@ -1428,6 +1452,238 @@ bool WeaveFabricState::FindOrAllocPeerEntry(uint64_t peerNodeId, bool allocEntry
     return retVal;
 }
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+/**
+ * This method folds a round trip time measured to a peer into the peer's smoothed
+ * round trip time and round trip time variance, as described in RFC 6298.
+ *
+ * Callers must only supply measurements of messages that were not retransmitted
+ * (Karn's algorithm), since the acknowledgment of a retransmitted message cannot be
+ * matched to a particular transmission.
+ *
+ * Measurements are only kept for peers that already have an entry in the peer state
+ * table, such as peers that have sent unencrypted or group key encrypted messages;
+ * measurements to other peers are ignored.
+ *
+ * @param[in] peerNodeId        The node identifier of the peer.
+ * @param[in] rttMsec           The measured round trip time in milliseconds.
+ *
+ */
+void WeaveFabricState::UpdatePeerRoundTripTime(uint64_t peerNodeId, uint32_t rttMsec)
+{
+    PeerIndexType peerIndex;
+
+    if (peerNodeId == kNodeIdNotSpecified || peerNodeId == kAnyNodeId)
+        return;
+
+    // Only peers that already have an entry are tracked; allocating one here would evict
+    // the message counter state of another peer.
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex))
+        return;
+
+    uint32_t & srtt = PeerStates.SmoothedRTT[peerIndex];
+    uint32_t & rttvar = PeerStates.RTTVariance[peerIndex];
+
+    // Keep measurements below timer resolution distinct from "not measured".
+    if (rttMsec == 0)
+        rttMsec = 1;
+
+    // Clamp measurements so that the scaled values cannot overflow.
+    if (rttMsec > WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT)
+        rttMsec = WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT;
+
+    if (srtt == 0)
+    {
+        // First measurement: SRTT = R, RTTVAR = R/2
+        srtt = rttMsec << 3;
+        rttvar = rttMsec << 1;
+    }
+    else
+    {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+        int32_t delta = static_cast<int32_t>(rttMsec) - static_cast<int32_t>(srtt >> 3);
+
+        srtt = static_cast<uint32_t>(static_cast<int32_t>(srtt) + delta);
+
+        if (delta < 0)
+            delta = -delta;
+        rttvar = static_cast<uint32_t>(static_cast<int32_t>(rttvar) + delta - static_cast<int32_t>(rttvar >> 2));
+    }
+
+    // A new measurement ends any backoff.
+    PeerStates.RetransBackoff[peerIndex] = 0;
+}
+
+/**
+ * This method doubles the retransmit timeout of a peer, after messages sent to the
+ * peer had to be retransmitted. Callers back the timeout off once for every timer
+ * tick in which they retransmit to the peer, however many messages they retransmit.
+ * The timeout remains backed off until the next round trip time is measured to the
+ * peer. Peers without an entry in the peer state table are ignored.
+ *
+ * @param[in] peerNodeId        The node identifier of the peer.
+ *
+ */
+void WeaveFabricState::BackOffPeerRetransTimeout(uint64_t peerNodeId)
+{
+    PeerIndexType peerIndex;
+
+    if (peerNodeId == kNodeIdNotSpecified || peerNodeId == kAnyNodeId)
+        return;
+
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex))
+        return;
+
+    if (PeerStates.RetransBackoff[peerIndex] < UINT8_MAX)
+        PeerStates.RetransBackoff[peerIndex]++;
+}
+
+/**
+ * This method returns the retransmit timeout for a peer.
+ *
+ * Once a round trip time has been measured to the peer, the timeout is derived from
+ * the peer's smoothed round trip time and round trip time variance as described in
+ * RFC 6298, with the WRMP timer period as the clock granularity, and is kept between
+ * #WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT and #WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT.
+ * Until then, the supplied default timeout is used. Either is doubled for every
+ * backoff since the last measurement, up to #WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT.
+ *
+ * @param[in] peerNodeId            The node identifier of the peer.
+ * @param[in] defaultTimeoutMsec    The retransmit timeout in milliseconds to use if
+ *                                  no round trip time has been measured to the peer.
+ *
+ * @return the retransmit timeout in milliseconds.
+ *
+ */
+uint32_t WeaveFabricState::GetPeerRetransTimeout(uint64_t peerNodeId, uint32_t defaultTimeoutMsec)
+{
+    PeerIndexType peerIndex;
+    uint32_t timeout = defaultTimeoutMsec;
+
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex))
+        return timeout;
+
+    if (PeerStates.SmoothedRTT[peerIndex] != 0)
+    {
+        // RTO = SRTT + max(G, 4 * RTTVAR); the scaled variance is already 4 * RTTVAR.
+        timeout = ((PeerStates.SmoothedRTT[peerIndex] + 7) >> 3) +
+            max(PeerStates.RTTVariance[peerIndex], static_cast<uint32_t>(WEAVE_CONFIG_WRMP_TIMER_DEFAULT_PERIOD));
+
+        timeout = min(max(timeout, static_cast<uint32_t>(WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT)),
+                      static_cast<uint32_t>(WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT));
+    }
+
+    for (uint8_t i = 0; i < PeerStates.RetransBackoff[peerIndex] && timeout < WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT; i++)
+    {
+        timeout = min(timeout << 1, static_cast<uint32_t>(WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT));
+    }
+
+    return timeout;
+}
+
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+enum
+{
+    kCongestionWindowScale          = 16,
+    kInitialCongestionWindow        = WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW * kCongestionWindowScale,
+    kMaxCongestionWindow            = WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW * kCongestionWindowScale,
+};
+
+/**
+ * This method returns the number of unacknowledged WRMP messages that may currently
+ * be outstanding to a peer.
+ *
+ * Peers that have not been heard from start with a window of
+ * #WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW messages. Messages that are not
+ * addressed to a particular node are not limited beyond
+ * #WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW.
+ *
+ * @param[in] peerNodeId        The node identifier of the peer.
+ *
+ * @return the congestion window, in messages; always at least one.
+ *
+ */
+uint16_t WeaveFabricState::GetPeerCongestionWindow(uint64_t peerNodeId)
+{
+    PeerIndexType peerIndex;
+    uint16_t cwnd;
+
+    if (peerNodeId == kNodeIdNotSpecified || peerNodeId == kAnyNodeId)
+        return WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW;
+
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex) || PeerStates.CongestionWindow[peerIndex] == 0)
+        cwnd = kInitialCongestionWindow;
+    else
+        cwnd = PeerStates.CongestionWindow[peerIndex];
+
+    cwnd /= kCongestionWindowScale;
+
+    return (cwnd > 0) ? cwnd : 1;
+}
+
+/**
+ * This method opens the congestion window of a peer after a message sent to the peer
+ * has been acknowledged. The window grows by one message for every window's worth of
+ * acknowledgments (additive increase), up to #WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW.
+ * Peers without an entry in the peer state table keep the initial window.
+ *
+ * @param[in] peerNodeId        The node identifier of the peer.
+ *
+ */
+void WeaveFabricState::GrowPeerCongestionWindow(uint64_t peerNodeId)
+{
+    PeerIndexType peerIndex;
+    uint32_t cwnd;
+
+    if (peerNodeId == kNodeIdNotSpecified || peerNodeId == kAnyNodeId)
+        return;
+
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex))
+        return;
+
+    cwnd = PeerStates.CongestionWindow[peerIndex];
+    if (cwnd == 0)
+        cwnd = kInitialCongestionWindow;
+
+    // cwnd += 1/cwnd, in scaled units, but by at least one unit.
+    cwnd += max<uint32_t>((kCongestionWindowScale * kCongestionWindowScale) / cwnd, 1);
+
+    PeerStates.CongestionWindow[peerIndex] = static_cast<uint16_t>(min<uint32_t>(cwnd, kMaxCongestionWindow));
+}
+
+/**
+ * This method halves the congestion window of a peer (multiplicative decrease), after
+ * a message sent to the peer had to be retransmitted or the peer asked for the flow
+ * to be throttled. The window never drops below one message. Peers without an entry
+ * in the peer state table keep the initial window.
+ *
+ * @param[in] peerNodeId        The node identifier of the peer.
+ *
+ */
+void WeaveFabricState::ShrinkPeerCongestionWindow(uint64_t peerNodeId)
+{
+    PeerIndexType peerIndex;
+    uint16_t cwnd;
+
+    if (peerNodeId == kNodeIdNotSpecified || peerNodeId == kAnyNodeId)
+        return;
+
+    if (!FindOrAllocPeerEntry(peerNodeId, false, peerIndex))
+        return;
+
+    cwnd = PeerStates.CongestionWindow[peerIndex];
+    if (cwnd == 0)
+        cwnd = kInitialCongestionWindow;
+
+    PeerStates.CongestionWindow[peerIndex] = max<uint16_t>(cwnd / 2, kCongestionWindowScale);
+}
+
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
 /*
  * This method is used by provisioning servers to register callbacks with the
  * WeaveFabricState to be notified when the current session is closed.
@@ -2027,6 +2283,11 @@ WEAVE_ERROR WeaveFabricState::FindMsgEncAppKey(uint16_t keyId, uint8_t encType,
         err = DeriveMsgEncAppKey(keyId, encType, *retRec, appGroupGlobalId);
         SuccessOrExit(err);
 
+#if WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+        // Get the key for the next epoch ready before the group rotates to it.
+        PrecomputeNextEpochMsgEncAppKey(keyId, encType);
+#endif
+
 #if WEAVE_CONFIG_SECURITY_TEST_MODE && WEAVE_DETAIL_LOGGING
         if (LogKeys)
         {
@@ -2102,6 +2363,81 @@ exit:
 
     return err;
 }
+
+#if WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+/**
+ * Derives the message encryption application key that follows the specified rotating key
+ * once the epoch key rotates, and stores it in a free entry of the key cache.
+ * The next epoch key is the one with the earliest start time after the start time of the
+ * epoch key used by the specified key. Nothing is done if the specified key is not
+ * a rotating key, if there is no next epoch key, or if the key cache has no free entries.
+ *
+ * When the key cache is full, precomputing is bypassed rather than evicting a key: every
+ * cached key was derived for a message that was actually received, while the next epoch
+ * key may never be used. The key is then derived on demand after the epoch key rotation
+ * and the skipped precomputation is counted in the key cache statistics.
+ *
+ * @param[in]    keyId              The ID of a rotating key that was just derived.
+ * @param[in]    encType            The type of the message encryption key.
+ *
+ */
+void WeaveFabricState::PrecomputeNextEpochMsgEncAppKey(uint16_t keyId, uint8_t encType)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    WeaveGroupKey epochKey;
+    uint32_t epochKeyIds[WEAVE_CONFIG_MAX_APPLICATION_EPOCH_KEYS];
+    uint8_t epochKeyCount;
+    uint32_t curStartTime;
+    uint32_t nextStartTime = 0;
+    uint32_t nextEpochKeyId = WeaveKeyId::kNone;
+    uint32_t appGroupGlobalId;
+    uint16_t nextKeyId;
+    WeaveMsgEncryptionKey *keyEntry;
+
+    VerifyOrExit(WeaveKeyId::IsAppRotatingKey(keyId), /* no-op */);
+
+    err = GroupKeyStore->RetrieveGroupKey(WeaveKeyId::GetEpochKeyId(keyId), epochKey);
+    SuccessOrExit(err);
+
+    curStartTime = epochKey.StartTime;
+
+    err = GroupKeyStore->EnumerateGroupKeys(WeaveKeyId::kType_AppEpochKey, epochKeyIds, sizeof(epochKeyIds) / sizeof(uint32_t), epochKeyCount);
+    SuccessOrExit(err);
+
+    for (int i = 0; i < epochKeyCount; i++)
+    {
+        err = GroupKeyStore->RetrieveGroupKey(epochKeyIds[i], epochKey);
+        SuccessOrExit(err);
+
+        if (epochKey.StartTime > curStartTime && (nextEpochKeyId == WeaveKeyId::kNone || epochKey.StartTime < nextStartTime))
+        {
+            nextEpochKeyId = epochKeyIds[i];
+            nextStartTime = epochKey.StartTime;
+        }
+    }
+
+    VerifyOrExit(nextEpochKeyId != WeaveKeyId::kNone, /* no-op */);
+
+    nextKeyId = static_cast<uint16_t>(WeaveKeyId::UpdateEpochKeyId(keyId, nextEpochKeyId));
+
+    // Only use a free entry so that precomputing never evicts a key in use.
+    keyEntry = AppKeyCache.AllocateFreeKeyEntry(nextKeyId, encType);
+    VerifyOrExit(keyEntry != NULL, /* no-op */);
+
+    err = DeriveMsgEncAppKey(nextKeyId, encType, *keyEntry, appGroupGlobalId);
+    SuccessOrExit(err);
+
+    AppKeyCache.MarkPrecomputed(keyEntry);
+
+exit:
+    ClearSecretData(epochKey.Key, epochKey.MaxKeySize);
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogDetail(MessageLayer, "Failed to precompute next epoch key for key Id %04" PRIX16 ": %s", keyId, ErrorStr(err));
+    }
+}
+#endif // WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
 #endif // WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
 
 void WeaveFabricState::SetDelegate(FabricStateDelegate *aDelegate)
@@ -2173,8 +2509,16 @@ void WeaveMsgEncryptionKeyCache::Shutdown()
 void WeaveMsgEncryptionKeyCache::Reset()
 {
     for (uint8_t keyEntry = 0; keyEntry < WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS; keyEntry++)
+    {
         Clear(keyEntry);
-    memset(mMostRecentlyUsedKeyEntries, 0, sizeof(mMostRecentlyUsedKeyEntries));
+        mMostRecentlyUsedKeyEntries[keyEntry] = keyEntry;
+    }
+    ResetStats();
+}
+
+void WeaveMsgEncryptionKeyCache::ResetStats()
+{
+    memset(&mStats, 0, sizeof(mStats));
 }
 
 // Clear key cache entry.
@@ -2183,6 +2527,25 @@ void WeaveMsgEncryptionKeyCache::Clear(uint8_t keyEntryIndex)
     ClearSecretData((uint8_t *)(&mKeyCache[keyEntryIndex]), sizeof(WeaveMsgEncryptionKey));
     mKeyCache[keyEntryIndex].KeyId = WeaveKeyId::kNone;
     mKeyCache[keyEntryIndex].EncType = kWeaveEncryptionType_None;
+    mIsPrecomputed[keyEntryIndex] = false;
+}
+
+// Move key entry to the specified position in the most-recently used list of entries.
+void WeaveMsgEncryptionKeyCache::MoveToPosition(uint8_t keyEntryIndex, uint8_t position)
+{
+    uint8_t i;
+
+    // Find key entry index in the most-recently used list of entries.
+    for (i = 0; i < WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS; i++)
+        if (mMostRecentlyUsedKeyEntries[i] == keyEntryIndex)
+            break;
+
+    if (i > position)
+        memmove(&mMostRecentlyUsedKeyEntries[position + 1], &mMostRecentlyUsedKeyEntries[position], (i - position) * sizeof(uint8_t));
+    else if (i < position)
+        memmove(&mMostRecentlyUsedKeyEntries[i], &mMostRecentlyUsedKeyEntries[i + 1], (position - i) * sizeof(uint8_t));
+
+    mMostRecentlyUsedKeyEntries[position] = keyEntryIndex;
 }
 
 // If the key is found in the cache then function returns pointer to the key.
@@ -2191,6 +2554,7 @@ WeaveMsgEncryptionKey *WeaveMsgEncryptionKeyCache::FindOrAllocateKeyEntry(uint16
 {
     WeaveMsgEncryptionKey *keyEntry;
     uint8_t retKeyEntryIndex = WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS;
+    bool found = false;
     uint8_t i;
 
     // Find if key is in the cache.
@@ -2199,6 +2563,7 @@ WeaveMsgEncryptionKey *WeaveMsgEncryptionKeyCache::FindOrAllocateKeyEntry(uint16
         if (keyEntry->KeyId == keyId && keyEntry->EncType == encType)
         {
             retKeyEntryIndex = i;
+            found = true;
             break;
         }
         else if (retKeyEntryIndex == WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS && keyEntry->KeyId == WeaveKeyId::kNone)
@@ -2207,28 +2572,112 @@ WeaveMsgEncryptionKey *WeaveMsgEncryptionKeyCache::FindOrAllocateKeyEntry(uint16
         }
     }
 
-    // If cache is full and specified key was not found in the cache then replace the least-recently used key entry.
-    if (retKeyEntryIndex == WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS)
+    if (found)
     {
-        // Chose the least-recently used entry in the key cache.
-        retKeyEntryIndex = mMostRecentlyUsedKeyEntries[WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS - 1];
+        mStats.Hits++;
 
-        // Clear replaced key cache entry.
-        Clear(retKeyEntryIndex);
+        if (mIsPrecomputed[retKeyEntryIndex])
+        {
+            mStats.PrecomputedHits++;
+            mIsPrecomputed[retKeyEntryIndex] = false;
+        }
     }
+    else
+    {
+        mStats.Misses++;
 
-    // Find key entry index in the most-recently used list of entries.
-    for (i = 0; i < WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS; i++)
-        if (mMostRecentlyUsedKeyEntries[i] == retKeyEntryIndex)
-            break;
+        // If cache is full and specified key was not found in the cache then replace the least-recently used key entry.
+        if (retKeyEntryIndex == WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS)
+        {
+            // Chose the least-recently used entry in the key cache.
+            retKeyEntryIndex = mMostRecentlyUsedKeyEntries[WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS - 1];
+
+            // Clear replaced key cache entry.
+            Clear(retKeyEntryIndex);
+
+            mStats.Evictions++;
+        }
+    }
 
     // Mark selected key entry as most-recently used by moving it to the top of the most-recently used key entries list.
-    memmove(&mMostRecentlyUsedKeyEntries[1], &mMostRecentlyUsedKeyEntries[0], i * sizeof(uint8_t));
-    mMostRecentlyUsedKeyEntries[0] = retKeyEntryIndex;
+    MoveToPosition(retKeyEntryIndex, 0);
+
+    return &mKeyCache[retKeyEntryIndex];
+}
+
+// If the key is not in the cache and the cache has an empty key entry then function returns pointer to the empty
+// key entry, which is marked as least-recently used so that it is the first to be replaced if it doesn't get used.
+// Otherwise function returns NULL; a full cache is counted as a skipped precomputation and no key is evicted.
+WeaveMsgEncryptionKey *WeaveMsgEncryptionKeyCache::AllocateFreeKeyEntry(uint16_t keyId, uint8_t encType)
+{
+    WeaveMsgEncryptionKey *keyEntry;
+    uint8_t retKeyEntryIndex = WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS;
+    uint8_t i;
+
+    for (i = 0, keyEntry = mKeyCache; i < WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS; i++, keyEntry++)
+    {
+        if (keyEntry->KeyId == keyId && keyEntry->EncType == encType)
+            return NULL;
+        else if (retKeyEntryIndex == WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS && keyEntry->KeyId == WeaveKeyId::kNone)
+            retKeyEntryIndex = i;
+    }
+
+    if (retKeyEntryIndex == WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS)
+    {
+        mStats.PrecomputeSkipped++;
+        return NULL;
+    }
+
+    MoveToPosition(retKeyEntryIndex, WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS - 1);
 
     return &mKeyCache[retKeyEntryIndex];
 }
 
+// Record that the key entry was populated ahead of its use.
+void WeaveMsgEncryptionKeyCache::MarkPrecomputed(const WeaveMsgEncryptionKey *keyEntry)
+{
+    mIsPrecomputed[keyEntry - mKeyCache] = true;
+    mStats.Precomputed++;
+}
+
+/**
+ *  Determine whether a message encryption type can be used for session keys established via CASE or PASE.
+ */
+bool IsSupportedSessionEncryptionType(uint8_t encType)
+{
+    return (encType == kWeaveEncryptionType_AES128CTRSHA1
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+            || encType == kWeaveEncryptionType_AES128CCM
+#endif
+            );
+}
+
+/**
+ *  Size of the key material that must be derived to form a session key of the specified encryption type.
+ */
+uint16_t SessionEncryptionKeySize(uint8_t encType)
+{
+    return (encType == kWeaveEncryptionType_AES128CCM) ? (uint16_t) WeaveEncryptionKey_AES128CCM::KeySize
+                                                       : (uint16_t) WeaveEncryptionKey_AES128CTRSHA1::KeySize;
+}
+
+/**
+ *  Form a session key of the specified encryption type from derived key material of length
+ *  SessionEncryptionKeySize().
+ */
+void SetSessionEncryptionKey(uint8_t encType, const uint8_t *keyData, WeaveEncryptionKey& key)
+{
+    if (encType == kWeaveEncryptionType_AES128CCM)
+    {
+        memcpy(key.AES128CCM.Key, keyData, WeaveEncryptionKey_AES128CCM::KeySize);
+    }
+    else
+    {
+        memcpy(key.AES128CTRSHA1.DataKey, keyData, WeaveEncryptionKey_AES128CTRSHA1::DataKeySize);
+        memcpy(key.AES128CTRSHA1.IntegrityKey, keyData + WeaveEncryptionKey_AES128CTRSHA1::DataKeySize,
+               WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
+    }
+}
 
 #if WEAVE_CONFIG_SECURITY_TEST_MODE
 
@@ -2255,6 +2704,11 @@ void WeaveEncryptionKeyToString(uint8_t encType, const WeaveEncryptionKey& key,
         *buf++ = ',';
         ToHexString(key.AES128CTRSHA1.IntegrityKey, sizeof(key.AES128CTRSHA1.IntegrityKey), buf, bufSize);
     }
+    else if (encType == kWeaveEncryptionType_AES128CCM)
+    {
+        bufSize -= 1; // Reserve size for the null terminator.
+        ToHexString(key.AES128CCM.Key, sizeof(key.AES128CCM.Key), buf, bufSize);
+    }
 
     *buf = 0;
 }
@@ -281,12 +281,29 @@ public:
     uint8_t IntegrityKey[IntegrityKeySize];
 };
 
+// Encryption key for the AES-128-CCM message encryption type
+class WeaveEncryptionKey_AES128CCM
+{
+public:
+    enum
+    {
+        KeySize                                         = 16
+    };
+
+    uint8_t Key[KeySize];
+};
+
 // Represents a key or key set used to encrypt Weave messages.
 typedef union WeaveEncryptionKey
 {
     WeaveEncryptionKey_AES128CTRSHA1 AES128CTRSHA1;
+    WeaveEncryptionKey_AES128CCM AES128CCM;
 } WeaveEncryptionKey;
 
+extern bool IsSupportedSessionEncryptionType(uint8_t encType);
+extern uint16_t SessionEncryptionKeySize(uint8_t encType);
+extern void SetSessionEncryptionKey(uint8_t encType, const uint8_t *keyData, WeaveEncryptionKey& key);
+
 // AES128CTRSHA1 encryption and integrity test keys, which should only be used for testing purposes.
 enum
 {
@@ -414,19 +431,41 @@ public:
 class WeaveMsgEncryptionKeyCache
 {
 public:
+    /**
+     * Key cache usage counters.
+     */
+    struct Stats
+    {
+        uint32_t Hits;                  /**< Number of lookups satisfied by a cached key. */
+        uint32_t Misses;                /**< Number of lookups that required a key derivation. */
+        uint32_t Evictions;             /**< Number of least-recently used keys replaced by another key. */
+        uint32_t Precomputed;           /**< Number of next epoch keys derived ahead of the epoch key rotation. */
+        uint32_t PrecomputedHits;       /**< Number of lookups satisfied by a precomputed key. */
+        uint32_t PrecomputeSkipped;     /**< Number of next epoch keys not precomputed because the cache was full. */
+    };
+
     void Init(void);
     void Reset(void);
     void Shutdown(void);
 
     WeaveMsgEncryptionKey *FindOrAllocateKeyEntry(uint16_t keyId, uint8_t encType);
+    WeaveMsgEncryptionKey *AllocateFreeKeyEntry(uint16_t keyId, uint8_t encType);
+    void MarkPrecomputed(const WeaveMsgEncryptionKey *keyEntry);
+
+    const Stats& GetStats(void) const { return mStats; }
+    void ResetStats(void);
 
 private:
     // Array of Weave message encryption keys.
     WeaveMsgEncryptionKey mKeyCache[WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS];
     // Array of key entry indexes in sorted order from most- to least- recently used.
     uint8_t mMostRecentlyUsedKeyEntries[WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS];
+    // Array of flags indicating key entries that were precomputed and haven't been used yet.
+    bool mIsPrecomputed[WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS];
+    Stats mStats;
 
     void Clear(uint8_t keyEntryIndex);
+    void MoveToPosition(uint8_t keyEntryIndex, uint8_t position);
 };
 
 /**
@@ -559,6 +598,18 @@ public:
 
     void HandleConnectionClosed(WeaveConnection *con);
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    void UpdatePeerRoundTripTime(uint64_t peerNodeId, uint32_t rttMsec);
+    void BackOffPeerRetransTimeout(uint64_t peerNodeId);
+    uint32_t GetPeerRetransTimeout(uint64_t peerNodeId, uint32_t defaultTimeoutMsec);
+#endif
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    uint16_t GetPeerCongestionWindow(uint64_t peerNodeId);
+    void GrowPeerCongestionWindow(uint64_t peerNodeId);
+    void ShrinkPeerCongestionWindow(uint64_t peerNodeId);
+#endif
+
     /**
      * This method sets the delegate object.
      * The callback methods of delegate are invoked whenever the FabricId is changed,
@@ -578,6 +629,8 @@ public:
     bool IsMsgCounterSyncReqInProgress(void);
     WEAVE_ERROR GetMsgEncKeyIdForAppGroup(uint32_t appGroupGlobalId, uint32_t rootKeyId, bool useRotatingKey, uint32_t& keyId);
     WEAVE_ERROR CheckMsgEncForAppGroup(const WeaveMessageInfo *msgInfo, uint32_t appGroupGlobalId, uint32_t rootKeyId, bool requireRotatingKey);
+    const WeaveMsgEncryptionKeyCache::Stats& GetAppKeyCacheStats(void) const { return AppKeyCache.GetStats(); }
+    void ResetAppKeyCacheStats(void) { AppKeyCache.ResetStats(); }
 #endif // WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
 
     typedef void (*SessionEndCbFunct)(uint16_t keyId, uint64_t peerNodeId, void *context);
@@ -637,6 +690,18 @@ private:
         WeaveSessionState::ReceiveFlagsType GroupKeyRcvFlags[WEAVE_CONFIG_MAX_PEER_NODES];
 #endif
         WeaveSessionState::ReceiveFlagsType UnencRcvFlags[WEAVE_CONFIG_MAX_PEER_NODES];
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+        // Smoothed round trip time and its mean deviation, in units of 1/8 and 1/4 msec
+        // respectively; a zero smoothed round trip time means the peer has not been measured.
+        uint32_t SmoothedRTT[WEAVE_CONFIG_MAX_PEER_NODES];
+        uint32_t RTTVariance[WEAVE_CONFIG_MAX_PEER_NODES];
+        // Number of times the retransmit timeout has been doubled since the last measurement.
+        uint8_t RetransBackoff[WEAVE_CONFIG_MAX_PEER_NODES];
+#endif
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+        // Congestion window, in units of 1/16 message; zero means the initial window.
+        uint16_t CongestionWindow[WEAVE_CONFIG_MAX_PEER_NODES];
+#endif
         // Array of peer indexes in sorted order from most- to least- recently used.
         PeerIndexType MostRecentlyUsedIndexes[WEAVE_CONFIG_MAX_PEER_NODES];
     } PeerStates;
@@ -666,6 +731,9 @@ private:
     bool FindOrAllocPeerEntry(uint64_t peerNodeId, bool allocEntry, PeerIndexType& retPeerIndex);
     WEAVE_ERROR FindMsgEncAppKey(uint16_t keyId, uint8_t encType, WeaveMsgEncryptionKey *& retRec);
     WEAVE_ERROR DeriveMsgEncAppKey(uint32_t keyId, uint8_t encType, WeaveMsgEncryptionKey & appKey, uint32_t& appGroupGlobalId);
+#if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC && WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+    void PrecomputeNextEpochMsgEncAppKey(uint16_t keyId, uint8_t encType);
+#endif
 };
 
 #if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
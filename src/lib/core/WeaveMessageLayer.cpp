@@ -46,6 +46,7 @@
 #include <Weave/Support/crypto/HMAC.h>
 #include <Weave/Support/crypto/AESBlockCipher.h>
 #include <Weave/Support/crypto/CTRMode.h>
+#include <Weave/Support/crypto/CCMMode.h>
 #include <Weave/Support/logging/WeaveLogging.h>
 #include <Weave/Support/ErrorStr.h>
 #include <Weave/Support/CodeUtils.h>
@@ -88,7 +89,13 @@ using namespace nl::Weave::Encoding;
 enum
 {
     kKeyIdLen = 2,
-    kMinPayloadLen = 1
+    kMinPayloadLen = 1,
+    kMaxIntegrityCheckHeaderLen = 2 * sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t),
+    kAES128CCMNonceLen = sizeof(uint64_t) + sizeof(uint32_t),
+    kAES128CCMTagLen = 16,
+    kCoalescedHeaderLen = 2,
+    kCoalescedLengthLen = 2,
+    kCoalescedDatagramHeader = kWeaveMessageVersion_Coalesced << kMsgHeaderField_MessageVersionShift
 };
 
 /**
@@ -146,8 +153,7 @@ WEAVE_ERROR WeaveMessageLayer::Init(InitContext *context)
     OnUnsecuredConnectionCallbacksRemoved = NULL;
     OnAcceptError = NULL;
     OnMessageLayerActivityChange = NULL;
-    memset(mConPool, 0, sizeof(mConPool));
-    memset(mTunnelPool, 0, sizeof(mTunnelPool));
+    InitConnectionPools();
     AppState = NULL;
     ExchangeMgr = NULL;
     SecurityMgr = NULL;
@@ -166,6 +172,14 @@ WEAVE_ERROR WeaveMessageLayer::Init(InitContext *context)
     SetEphemeralUDPPortEnabled(context->enableEphemeralUDPPort);
 #endif
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    memset(mCoalescedDatagrams, 0, sizeof(mCoalescedDatagrams));
+    for (size_t i = 0; i < WEAVE_CONFIG_MAX_COALESCING_PEERS; i++)
+        mCoalescingPeers[i] = IPAddress::Any;
+    mNextCoalescingPeer = 0;
+    ResetCoalescingStats();
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
     mIPv6TCPListen = NULL;
     mIPv6UDP = NULL;
 
@@ -229,8 +243,6 @@ exit:
  */
 WEAVE_ERROR WeaveMessageLayer::Shutdown()
 {
-    CloseEndpoints();
-
 #if CONFIG_NETWORK_LAYER_BLE
     if (mBle != NULL && mBle->mAppState == this)
     {
@@ -239,6 +251,16 @@ WEAVE_ERROR WeaveMessageLayer::Shutdown()
     }
 #endif // CONFIG_NETWORK_LAYER_BLE
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    if (State == kState_Initialized)
+    {
+        FlushCoalescedMessages();
+        SystemLayer->CancelTimer(HandleCoalescingFlush, this);
+    }
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+    CloseEndpoints();
+
     State = kState_NotInitialized;
     IsListening = false;
     FabricState = NULL;
@@ -250,6 +272,8 @@ WEAVE_ERROR WeaveMessageLayer::Shutdown()
     OnMessageLayerActivityChange = NULL;
     memset(mConPool, 0, sizeof(mConPool));
     memset(mTunnelPool, 0, sizeof(mTunnelPool));
+    mFreeConList = NULL;
+    mFreeTunnelList = NULL;
     ExchangeMgr = NULL;
     AppState = NULL;
     mFlags = 0;
@@ -566,6 +590,13 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
         kMulticast_AllFabricAddrs,
     } sendAction;
     uint16_t udpSendFlags;
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    const InterfaceCache * intfCache;
+    enum
+    {
+        kBroadcastIntfFlags = InterfaceCache::kFlag_Up | InterfaceCache::kFlag_SupportsMulticast | InterfaceCache::kFlag_HasBroadcast
+    };
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
 
 #if WEAVE_CONFIG_ENABLE_MESSAGE_CAPTURE
     // Check the destination address to check if the message is meant to be sent
@@ -669,6 +700,26 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
     case kUnicast:
     case kMulticast_OneInterface:
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+        // Hold unicast messages for peers that accept coalesced datagrams, to be sent together with
+        // any other messages for the same destination at the end of the current event loop iteration.
+        if (sendAction == kUnicast)
+        {
+            bool coalesced = false;
+
+            mCoalescingStats.MessagesSent++;
+
+            // If the message had to be sent right away, err is the result of sending it.
+            if (MessageCoalescingEnabled())
+                err = CoalesceMessage(pktInfo, payload, msgFlags, coalesced);
+            if (coalesced)
+                break;
+
+            mCoalescingStats.DatagramsSent++;
+            mCoalescingStats.DatagramBytesSent += payload->DataLength();
+        }
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
         // Send the message once. If requested by the caller, instruct the end point code to not free the
         // message buffer. If a send interface was specified, the message is sent over that interface.
         udpSendFlags = GetFlag(msgFlags, kWeaveMessageFlag_RetainBuffer) ? UDPEndPoint::kSendFlag_RetainBuffer : 0;
@@ -680,6 +731,28 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
 
     case kMulticast_AllInterfaces:
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+        // Use the InetLayer's cached interface table, when available, to avoid querying the system on every send.
+        if ((intfCache = Inet->GetInterfaceCache()) != NULL)
+        {
+            for (uint16_t i = 0; i < intfCache->NumInterfaces(); i++)
+            {
+                const InterfaceCache::Interface & intf = intfCache->GetInterface(i);
+                if ((intf.Flags & kBroadcastIntfFlags) == kBroadcastIntfFlags)
+                {
+                    pktInfo.Interface = intf.Id;
+                    WEAVE_ERROR sendErr = SendMulticastCopy(ep, pktInfo, payload);
+                    if (err == WEAVE_NO_ERROR)
+                    {
+                        err = sendErr;
+                    }
+                }
+            }
+
+            break;
+        }
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
         // Send the message over each local interface that supports multicast.
         for (InterfaceIterator intfIter; intfIter.HasCurrent(); intfIter.Next())
         {
@@ -689,11 +762,10 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
             if (isBroadcastSupported)
             {
                 pktInfo.Interface = intfIter.GetInterface();
-                WEAVE_ERROR sendErr = ep->SendMsg(&pktInfo, payload, UDPEndPoint::kSendFlag_RetainBuffer);
-                CheckForceRefreshUDPEndPointsNeeded(sendErr);
+                WEAVE_ERROR sendErr = SendMulticastCopy(ep, pktInfo, payload);
                 if (err == WEAVE_NO_ERROR)
                 {
-                    err = FilterUDPSendError(sendErr, true);
+                    err = sendErr;
                 }
             }
         }
@@ -705,6 +777,30 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
         // Send the message once for each Weave Fabric ULA assigned to a local interface that supports
         // multicast/broadcast. If the caller has specified a particular interface, only send over the
         // specified interface.  For each message sent, arrange for the source address to be the Fabric ULA.
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+        if ((intfCache = Inet->GetInterfaceCache()) != NULL)
+        {
+            for (uint16_t i = 0; i < intfCache->NumAddresses(); i++)
+            {
+                const InterfaceCache::Address & addr = intfCache->GetAddress(i);
+                if ((addr.Flags & kBroadcastIntfFlags) == kBroadcastIntfFlags &&
+                    FabricState->IsLocalFabricAddress(addr.Addr) &&
+                    (sendIntfId == INET_NULL_INTERFACEID || addr.IntfId == sendIntfId))
+                {
+                    pktInfo.SrcAddress = addr.Addr;
+                    pktInfo.Interface = addr.IntfId;
+                    WEAVE_ERROR sendErr = SendMulticastCopy(ep, pktInfo, payload);
+                    if (err == WEAVE_NO_ERROR)
+                    {
+                        err = sendErr;
+                    }
+                }
+            }
+
+            break;
+        }
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
         for (InterfaceAddressIterator addrIter; addrIter.HasCurrent(); addrIter.Next())
         {
             pktInfo.SrcAddress = addrIter.GetAddress();
@@ -716,11 +812,10 @@ WEAVE_ERROR WeaveMessageLayer::SendMessage(IPAddress & destAddr, uint16_t destPo
                 FabricState->IsLocalFabricAddress(pktInfo.SrcAddress) &&
                 (sendIntfId == INET_NULL_INTERFACEID || pktInfo.Interface == sendIntfId))
             {
-                WEAVE_ERROR sendErr = ep->SendMsg(&pktInfo, payload, UDPEndPoint::kSendFlag_RetainBuffer);
-                CheckForceRefreshUDPEndPointsNeeded(sendErr);
+                WEAVE_ERROR sendErr = SendMulticastCopy(ep, pktInfo, payload);
                 if (err == WEAVE_NO_ERROR)
                 {
-                    err = FilterUDPSendError(sendErr, true);
+                    err = sendErr;
                 }
             }
         }
@@ -734,6 +829,283 @@ exit:
     return err;
 }
 
+/**
+ *  Send one copy of a multicast Weave message over the interface given in the packet info,
+ *  retaining the message buffer for further copies.
+ */
+WEAVE_ERROR WeaveMessageLayer::SendMulticastCopy(UDPEndPoint * ep, const IPPacketInfo & pktInfo, PacketBuffer * payload)
+{
+    WEAVE_ERROR err = ep->SendMsg(&pktInfo, payload, UDPEndPoint::kSendFlag_RetainBuffer);
+    CheckForceRefreshUDPEndPointsNeeded(err);
+    return FilterUDPSendError(err, true);
+}
+
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+/**
+ *  Enable or disable coalescing of messages sent to peers that accept coalesced datagrams.
+ *
+ *  When enabled, unicast messages sent over UDP to such a peer are held until the end of the
+ *  current event loop iteration, and the messages for each destination are then sent together
+ *  in as few datagrams as fit within #WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE. Every message
+ *  keeps its own header and integrity check, so coalescing does not change how the peer
+ *  authenticates, de-duplicates or acknowledges them.
+ *
+ *  Disabling coalescing sends any messages being held.
+ */
+void WeaveMessageLayer::SetMessageCoalescingEnabled(bool val)
+{
+    SetFlag(mFlags, kFlag_CoalesceMessages, val);
+
+    if (!val)
+        FlushCoalescedMessages();
+}
+
+/**
+ *  Record that a peer accepts coalesced datagrams.
+ *
+ *  Peers from which a coalesced datagram carrying an authenticated message is received while
+ *  coalescing is enabled are recorded automatically. Applications call this method for peers
+ *  known by other means to accept them, so that messages to those peers are coalesced from the
+ *  start. If the table of peers is full, the least recently added peer is forgotten.
+ *
+ *  @param[in]    peerAddr      The IP address of the peer.
+ */
+void WeaveMessageLayer::AddCoalescingPeer(const IPAddress &peerAddr)
+{
+    char ipAddrStr[64];
+
+    if (peerAddr == IPAddress::Any || IsCoalescingPeer(peerAddr))
+        return;
+
+    mCoalescingPeers[mNextCoalescingPeer] = peerAddr;
+    mNextCoalescingPeer = (mNextCoalescingPeer + 1) % WEAVE_CONFIG_MAX_COALESCING_PEERS;
+
+    peerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+    WeaveLogDetail(MessageLayer, "Coalescing messages to %s", ipAddrStr);
+}
+
+/**
+ *  Stop coalescing messages sent to a peer.
+ *
+ *  The message layer does this itself when a coalesced datagram cannot be sent to the peer, and
+ *  the exchange manager does it when WRMP gives up retransmitting a message to the peer, in case
+ *  the peer does not accept coalesced datagrams after all.
+ *
+ *  @param[in]    peerAddr      The IP address of the peer.
+ */
+void WeaveMessageLayer::RemoveCoalescingPeer(const IPAddress &peerAddr)
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_MAX_COALESCING_PEERS; i++)
+    {
+        if (mCoalescingPeers[i] == peerAddr)
+            mCoalescingPeers[i] = IPAddress::Any;
+    }
+}
+
+/**
+ *  Check if a peer is known to accept coalesced datagrams.
+ *
+ *  @param[in]    peerAddr      The IP address of the peer.
+ */
+bool WeaveMessageLayer::IsCoalescingPeer(const IPAddress &peerAddr) const
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_MAX_COALESCING_PEERS; i++)
+    {
+        if (mCoalescingPeers[i] == peerAddr && peerAddr != IPAddress::Any)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ *  Send any messages being held for coalescing without waiting for the end of the current
+ *  event loop iteration.
+ */
+void WeaveMessageLayer::FlushCoalescedMessages(void)
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS; i++)
+    {
+        if (mCoalescedDatagrams[i].Buf != NULL)
+            SendCoalescedDatagram(mCoalescedDatagrams[i]);
+    }
+}
+
+/**
+ *  Add an encoded unicast message to the datagram being filled for its destination, if the
+ *  destination accepts coalesced datagrams.
+ *
+ *  The message is copied; the caller retains ownership of the payload buffer.
+ *
+ *  @param[out]   coalesced     Set to true if the message was added to a datagram, or to false if
+ *                              the message must be sent on its own.
+ *
+ *  @return  #WEAVE_NO_ERROR, or the error sending the message if it could not be held and had to
+ *           be sent right away.
+ */
+WEAVE_ERROR WeaveMessageLayer::CoalesceMessage(const IPPacketInfo &pktInfo, PacketBuffer *payload, uint32_t msgFlags,
+                                               bool &coalesced)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    CoalescedDatagram *datagram = NULL;
+    CoalescedDatagram *freeDatagram = NULL;
+    const uint16_t msgLen = payload->DataLength();
+    uint8_t *p;
+
+    coalesced = false;
+    msgFlags &= kWeaveMessageFlag_ViaEphemeralUDPPort;
+
+    // Messages too big to share a datagram with another are sent on their own, as are messages to
+    // peers not known to accept coalesced datagrams.
+    VerifyOrExit(payload->Next() == NULL, );
+    VerifyOrExit(kCoalescedHeaderLen + 2 * kCoalescedLengthLen + msgLen < WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE, );
+    VerifyOrExit(IsCoalescingPeer(pktInfo.DestAddress), );
+
+    for (size_t i = 0; i < WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS; i++)
+    {
+        CoalescedDatagram &entry = mCoalescedDatagrams[i];
+
+        if (entry.Buf == NULL)
+        {
+            if (freeDatagram == NULL)
+                freeDatagram = &entry;
+        }
+        else if (entry.DestAddr == pktInfo.DestAddress && entry.DestPort == pktInfo.DestPort &&
+                 entry.IntfId == pktInfo.Interface && entry.MsgFlags == msgFlags)
+        {
+            datagram = &entry;
+        }
+    }
+
+    // If the message does not fit in the datagram for its destination, send that datagram now
+    // and start another.  Should that fail, the destination is no longer coalesced to, and the
+    // message is sent on its own so that the caller learns the outcome.
+    if (datagram != NULL &&
+        (datagram->Buf->DataLength() + kCoalescedLengthLen + msgLen > WEAVE_CONFIG_COALESCED_DATAGRAM_MAX_SIZE ||
+         datagram->Buf->AvailableDataLength() < kCoalescedLengthLen + msgLen))
+    {
+        VerifyOrExit(SendCoalescedDatagram(*datagram) == WEAVE_NO_ERROR, );
+        freeDatagram = datagram;
+        datagram = NULL;
+    }
+
+    if (datagram == NULL)
+    {
+        PacketBuffer *buf;
+
+        VerifyOrExit(freeDatagram != NULL, );
+
+        buf = PacketBuffer::New();
+        VerifyOrExit(buf != NULL, );
+
+        if (buf->AvailableDataLength() < kCoalescedHeaderLen + kCoalescedLengthLen + msgLen)
+        {
+            PacketBuffer::Free(buf);
+            ExitNow();
+        }
+
+        p = buf->Start();
+        LittleEndian::Write16(p, kCoalescedDatagramHeader);
+        buf->SetDataLength(kCoalescedHeaderLen);
+
+        datagram = freeDatagram;
+        datagram->Buf = buf;
+        datagram->DestAddr = pktInfo.DestAddress;
+        datagram->DestPort = pktInfo.DestPort;
+        datagram->IntfId = pktInfo.Interface;
+        datagram->MsgFlags = msgFlags;
+        datagram->MsgCount = 0;
+    }
+
+    p = datagram->Buf->Start() + datagram->Buf->DataLength();
+    LittleEndian::Write16(p, msgLen);
+    memcpy(p, payload->Start(), msgLen);
+    datagram->Buf->SetDataLength(datagram->Buf->DataLength() + kCoalescedLengthLen + msgLen);
+    datagram->MsgCount++;
+    coalesced = true;
+
+    // Arrange for the datagrams to be sent once the current event loop iteration is done.  If
+    // that isn't possible, send this one right away.
+    if (!GetFlag(mFlags, kFlag_CoalescingFlushScheduled))
+    {
+        if (SystemLayer->ScheduleWork(HandleCoalescingFlush, this) == WEAVE_SYSTEM_NO_ERROR)
+            SetFlag(mFlags, kFlag_CoalescingFlushScheduled);
+        else
+            err = SendCoalescedDatagram(*datagram);
+    }
+
+exit:
+    return err;
+}
+
+/**
+ *  Send a datagram filled by CoalesceMessage() and free its entry.
+ *
+ *  A datagram holding a single message is sent as that message alone, so that coalescing costs
+ *  nothing when there is nothing to coalesce.
+ *
+ *  The senders of the messages in a datagram flushed at the end of an event loop iteration are
+ *  no longer around to be told if it cannot be sent.  So on failure the destination is no
+ *  longer coalesced to: WRMP retransmissions of the messages, and any later messages, are sent
+ *  directly, and their senders see any error that persists.
+ */
+WEAVE_ERROR WeaveMessageLayer::SendCoalescedDatagram(CoalescedDatagram &datagram)
+{
+    WEAVE_ERROR err;
+    PacketBuffer *buf = datagram.Buf;
+    UDPEndPoint *ep;
+    IPPacketInfo pktInfo;
+
+    datagram.Buf = NULL;
+
+    pktInfo.Clear();
+    pktInfo.DestAddress = datagram.DestAddr;
+    pktInfo.DestPort = datagram.DestPort;
+    pktInfo.Interface = datagram.IntfId;
+
+    if (datagram.MsgCount == 1)
+    {
+        buf->SetStart(buf->Start() + kCoalescedHeaderLen + kCoalescedLengthLen);
+    }
+    else
+    {
+        mCoalescingStats.MessagesCoalesced += datagram.MsgCount;
+    }
+
+    err = SelectOutboundUDPEndPoint(datagram.DestAddr, datagram.MsgFlags, ep);
+    SuccessOrExit(err);
+
+    mCoalescingStats.DatagramsSent++;
+    mCoalescingStats.DatagramBytesSent += buf->DataLength();
+
+    err = ep->SendMsg(&pktInfo, buf, 0);
+    buf = NULL;
+    CheckForceRefreshUDPEndPointsNeeded(err);
+    err = FilterUDPSendError(err, false);
+
+exit:
+    if (buf != NULL)
+        PacketBuffer::Free(buf);
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(MessageLayer, "Failed to send %u coalesced message(s): %s", datagram.MsgCount, nl::ErrorStr(err));
+        mCoalescingStats.DatagramSendErrors++;
+        RemoveCoalescingPeer(datagram.DestAddr);
+    }
+    return err;
+}
+
+void WeaveMessageLayer::HandleCoalescingFlush(System::Layer *aSystemLayer, void *aAppState, System::Error aError)
+{
+    WeaveMessageLayer *msgLayer = static_cast<WeaveMessageLayer *>(aAppState);
+
+    ClearFlag(msgLayer->mFlags, kFlag_CoalescingFlushScheduled);
+    msgLayer->FlushCoalescedMessages();
+}
+
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
 /**
  *  Select an appropriate UDP endpoint for sending a Weave message.
  */
@@ -927,18 +1299,27 @@ void WeaveMessageLayer::GetConnectionPoolStats(nl::Weave::System::Stats::count_t
  */
 WeaveConnection *WeaveMessageLayer::NewConnection()
 {
-    WeaveConnection *con = (WeaveConnection *) mConPool;
-    for (int i = 0; i < WEAVE_CONFIG_MAX_CONNECTIONS; i++, con++)
+    WeaveConnection *con = mFreeConList;
+    if (con == NULL)
     {
-        if (con->mRefCount == 0)
-        {
-            con->Init(this);
-            return con;
-        }
+        WeaveLogError(ExchangeManager, "New con FAILED");
+        return NULL;
     }
 
-    WeaveLogError(ExchangeManager, "New con FAILED");
-    return NULL;
+    mFreeConList = con->mNextFree;
+    con->mNextFree = NULL;
+    con->Init(this);
+    return con;
+}
+
+/**
+ *  Return a WeaveConnection object, whose last reference has been released, to the pool.
+ *
+ */
+void WeaveMessageLayer::FreeConnection(WeaveConnection *con)
+{
+    con->mNextFree = mFreeConList;
+    mFreeConList = con;
 }
 
 void WeaveMessageLayer::GetIncomingTCPConCount(const IPAddress &peerAddr, uint16_t &count, uint16_t &countFromIP)
@@ -971,18 +1352,52 @@ void WeaveMessageLayer::GetIncomingTCPConCount(const IPAddress &peerAddr, uint16
  */
 WeaveConnectionTunnel *WeaveMessageLayer::NewConnectionTunnel()
 {
-    WeaveConnectionTunnel *tun = (WeaveConnectionTunnel *) mTunnelPool;
-    for (int i = 0; i < WEAVE_CONFIG_MAX_TUNNELS; i++, tun++)
+    WeaveConnectionTunnel *tun = mFreeTunnelList;
+    if (tun == NULL)
     {
-        if (tun->IsInUse() == false)
-        {
-            tun->Init(this);
-            return tun;
-        }
+        WeaveLogError(ExchangeManager, "New tun FAILED");
+        return NULL;
     }
 
-    WeaveLogError(ExchangeManager, "New tun FAILED");
-    return NULL;
+    mFreeTunnelList = tun->mNextFree;
+    tun->mNextFree = NULL;
+    tun->Init(this);
+    return tun;
+}
+
+/**
+ *  Return a WeaveConnectionTunnel object that has been shut down to the pool.
+ *
+ */
+void WeaveMessageLayer::FreeConnectionTunnel(WeaveConnectionTunnel *tun)
+{
+    tun->mNextFree = mFreeTunnelList;
+    mFreeTunnelList = tun;
+}
+
+/**
+ *  Initialize the pools of WeaveConnection and WeaveConnectionTunnel objects and thread all
+ *  of their entries onto the corresponding free lists.
+ *
+ */
+void WeaveMessageLayer::InitConnectionPools(void)
+{
+    memset(mConPool, 0, sizeof(mConPool));
+    memset(mTunnelPool, 0, sizeof(mTunnelPool));
+
+    mFreeConList = NULL;
+    for (int i = WEAVE_CONFIG_MAX_CONNECTIONS - 1; i >= 0; i--)
+    {
+        mConPool[i].mNextFree = mFreeConList;
+        mFreeConList = &mConPool[i];
+    }
+
+    mFreeTunnelList = NULL;
+    for (int i = WEAVE_CONFIG_MAX_TUNNELS - 1; i >= 0; i--)
+    {
+        mTunnelPool[i].mNextFree = mFreeTunnelList;
+        mFreeTunnelList = &mTunnelPool[i];
+    }
 }
 
 /**
@@ -1313,6 +1728,9 @@ WEAVE_ERROR WeaveMessageLayer::ReEncodeMessage(PacketBuffer *msgBuf)
  *                              about the message to be encoded.
  *
  *  @param[in]    msgBuf        A pointer to the PacketBuffer object that would hold the Weave message.
+ *                              The payload may span a chain of buffers, in which case the message header
+ *                              is written into the first buffer and the integrity check value, if any, is
+ *                              appended to the last buffer; the chain is encrypted in place without copying.
  *
  *  @param[in]    con           A pointer to the WeaveConnection object.
  *
@@ -1361,7 +1779,7 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessage(WeaveMessageInfo *msgInfo, PacketBu
     // in the final encoded message.
     uint16_t headLen = 6;
     uint16_t tailLen = 0;
-    uint16_t payloadLen = msgBuf->DataLength();
+    uint16_t payloadLen = msgBuf->TotalLength();
     if (msgInfo->Flags & kWeaveMessageFlag_SourceNodeId)
         headLen += 8;
     if (msgInfo->Flags & kWeaveMessageFlag_DestNodeId)
@@ -1377,12 +1795,21 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessage(WeaveMessageInfo *msgInfo, PacketBu
         headLen += 2;
         tailLen += HMACSHA1::kDigestLength;
         break;
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    case kWeaveEncryptionType_AES128CCM:
+        // Can only encrypt non-zero length payloads.
+        if (payloadLen == 0)
+            return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
+        headLen += 2;
+        tailLen += kAES128CCMTagLen;
+        break;
+#endif
     default:
         return WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE;
     }
 
     // Error if the encoded message would be longer than the requested maximum.
-    if ((headLen + msgBuf->DataLength() + tailLen) > maxLen)
+    if ((headLen + payloadLen + tailLen) > maxLen)
         return WEAVE_ERROR_MESSAGE_TOO_LONG;
 
     // Ensure there's enough room before the payload to hold the message header.
@@ -1390,8 +1817,12 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessage(WeaveMessageInfo *msgInfo, PacketBu
     if (!msgBuf->EnsureReservedSize(headLen + reserve))
         return WEAVE_ERROR_BUFFER_TOO_SMALL;
 
-    // Error if not enough space after the message payload.
-    if ((msgBuf->DataLength() + tailLen) > msgBuf->MaxDataLength())
+    // Error if not enough space after the message payload.  When the payload spans a chain of buffers
+    // the trailing integrity check value is placed in the last buffer of the chain.
+    PacketBuffer *lastBuf = msgBuf;
+    while (lastBuf->Next() != NULL)
+        lastBuf = lastBuf->Next();
+    if ((lastBuf->DataLength() + tailLen) > lastBuf->MaxDataLength())
         return WEAVE_ERROR_BUFFER_TOO_SMALL;
 
     uint8_t *payloadStart = msgBuf->Start();
@@ -1470,25 +1901,41 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessage(WeaveMessageInfo *msgInfo, PacketBu
         // Encode the key id.
         LittleEndian::Write16(p, msgInfo->KeyId);
 
-        // At this point we've completed encoding the head of the message (and therefore p == payloadStart),
-        // so skip over the payload data.
-        p += payloadLen;
+        // At this point we've completed encoding the head of the message (and therefore p == payloadStart).
+        // Compute the integrity check value, store it immediately after the payload data (in the last buffer
+        // of the chain) and encrypt the payload and the integrity check value, in place, in a single pass
+        // over the message buffers.
+        EncryptChain_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
+                                   sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey, msgBuf, payloadStart);
+
+        // Skip over the payload data and the integrity check value.
+        p += payloadLen + HMACSHA1::kDigestLength;
+
+        break;
 
-        // Compute the integrity check value and store it immediately after the payload data.
-        ComputeIntegrityCheck_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey,
-                                            payloadStart, payloadLen, p);
-        p += HMACSHA1::kDigestLength;
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    case kWeaveEncryptionType_AES128CCM:
+        // Encode the key id.
+        LittleEndian::Write16(p, msgInfo->KeyId);
 
-        // Encrypt the message payload and the integrity check value that follows it, in place, in the message buffer.
-        Encrypt_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
-                              payloadStart, payloadLen + HMACSHA1::kDigestLength, payloadStart);
+        // Encrypt and authenticate the payload, in place, in a single pass over the message buffers and
+        // store the authentication tag immediately after the payload data.
+        err = EncryptChain_AES128CCM(msgInfo, sessionState.MsgEncKey->EncKey.AES128CCM.Key, msgBuf, payloadStart, payloadLen);
+        if (err != WEAVE_NO_ERROR)
+            return err;
+
+        // Skip over the payload data and the authentication tag.
+        p += payloadLen + kAES128CCMTagLen;
 
         break;
+#endif
     }
 
     msgInfo->Flags |= kWeaveMessageFlag_MessageEncoded;
-    // Update the buffer length to reflect the entire encoded message.
-    msgBuf->SetDataLength(headLen + payloadLen + tailLen);
+
+    // Note that the buffer lengths already reflect the entire encoded message: moving the start of the
+    // first buffer back over the message header extended its length, and the integrity check value,
+    // if any, was appended to the last buffer in the chain.
 
     // We update the cursor (p) out of good hygiene,
     // such that if the code is extended in the future such that the cursor is used,
@@ -1504,7 +1951,6 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sour
     WEAVE_ERROR err;
     uint8_t *msgStart = msgBuf->Start();
     uint16_t msgLen = msgBuf->DataLength();
-    uint8_t *msgEnd = msgStart + msgLen;
     uint8_t *p = msgStart;
     msgInfo->SourceNodeId = sourceNodeId;
     err = DecodeHeader(msgBuf, msgInfo, &p);
@@ -1532,29 +1978,41 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessage(PacketBuffer *msgBuf, uint64_t sour
         break;
 
     case kWeaveEncryptionType_AES128CTRSHA1:
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    case kWeaveEncryptionType_AES128CCM:
+#endif
     {
+        // The payload and integrity check value may continue beyond the first buffer in the chain.
+        uint16_t headerLen = p - msgStart;
+        uint16_t totalLen = msgBuf->TotalLength();
+        uint16_t tailLen = (msgInfo->EncryptionType == kWeaveEncryptionType_AES128CTRSHA1) ? (uint16_t) HMACSHA1::kDigestLength
+                                                                                            : (uint16_t) kAES128CCMTagLen;
+
         // Error if the message is short given the expected fields.
-        if ((p + kMinPayloadLen + HMACSHA1::kDigestLength) > msgEnd)
+        if ((headerLen + kMinPayloadLen + tailLen) > totalLen)
             return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
 
-        // Return the position and length of the payload within the message.
-        uint16_t payloadLen = msgLen - ((p - msgStart) + HMACSHA1::kDigestLength);
-        *rPayloadLen = payloadLen;
+        uint16_t payloadLen = totalLen - (headerLen + tailLen);
+
+        // Decrypt the message payload, in place, in the message buffers and verify the integrity check value
+        // that follows it.
+        if (msgInfo->EncryptionType == kWeaveEncryptionType_AES128CTRSHA1)
+            err = DecryptChain_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
+                                             sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey, msgBuf, p, payloadLen);
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+        else
+            err = DecryptChain_AES128CCM(msgInfo, sessionState.MsgEncKey->EncKey.AES128CCM.Key, msgBuf, p, payloadLen);
+#endif
+        if (err != WEAVE_NO_ERROR)
+            return err;
+
+        // Return the position and length of the payload within the first message buffer.  If the message
+        // spans a chain of buffers, the remainder of the payload follows in the subsequent buffers.
         *rPayload = p;
+        *rPayloadLen = msgBuf->DataLength() - headerLen;
 
-        // Decrypt the message payload and the integrity check value that follows it, in place, in the message buffer.
-        Encrypt_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.DataKey,
-                              p, payloadLen + HMACSHA1::kDigestLength, p);
-
-        // Compute the expected integrity check value from the decrypted payload.
-        uint8_t expectedIntegrityCheck[HMACSHA1::kDigestLength];
-        ComputeIntegrityCheck_AES128CTRSHA1(msgInfo, sessionState.MsgEncKey->EncKey.AES128CTRSHA1.IntegrityKey,
-                                            p, payloadLen, expectedIntegrityCheck);
-        // Error if the expected integrity check doesn't match the integrity check in the message.
-        if (!ConstantTimeCompare(p + payloadLen, expectedIntegrityCheck, HMACSHA1::kDigestLength))
-            return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
         // Skip past the payload and the integrity check value.
-        p += payloadLen + HMACSHA1::kDigestLength;
+        p += payloadLen + tailLen;
 
         break;
     }
@@ -1591,7 +2049,7 @@ WEAVE_ERROR WeaveMessageLayer::EncodeMessageWithLength(WeaveMessageInfo *msgInfo
 
     // Prepend the message length to the beginning of the message.
     uint8_t * newMsgStart = msgBuf->Start() - 2;
-    uint16_t msgLen = msgBuf->DataLength();
+    uint16_t msgLen = msgBuf->TotalLength();
     msgBuf->SetStart(newMsgStart);
     LittleEndian::Put16(newMsgStart, msgLen);
 
@@ -1627,7 +2085,9 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessageWithLength(PacketBuffer *msgBuf, uin
     }
 
     // Adjust the message buffer to point at the message, not including the message length field that precedes it,
-    // and not including any data that may follow it.
+    // and not including any data that may follow it. Buffers queued after the first one hold data that follows
+    // the message, so detach them while decoding; DecodeMessage() treats the whole chain as the message.
+    PacketBuffer *nextBuf = msgBuf->DetachTail();
     msgBuf->SetStart(dataStart + 2);
     msgBuf->SetDataLength(msgLen);
 
@@ -1649,6 +2109,9 @@ WEAVE_ERROR WeaveMessageLayer::DecodeMessageWithLength(PacketBuffer *msgBuf, uin
         msgBuf->SetDataLength(dataLen);
     }
 
+    if (nextBuf != NULL)
+        msgBuf->AddToEnd(nextBuf);
+
     return err;
 }
 
@@ -1661,6 +2124,17 @@ void WeaveMessageLayer::HandleUDPMessage(UDPEndPoint *endPoint, PacketBuffer *ms
     uint8_t *payload;
     uint16_t payloadLen;
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    // Unpack datagrams carrying several messages and handle each message in turn.
+    if (msg->DataLength() >= kCoalescedHeaderLen &&
+        ((LittleEndian::Get16(msg->Start()) & kMsgHeaderField_MessageVersionMask) >> kMsgHeaderField_MessageVersionShift) ==
+            kWeaveMessageVersion_Coalesced)
+    {
+        HandleCoalescedDatagram(endPoint, msg, pktInfo);
+        return;
+    }
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
     WEAVE_FAULT_INJECT(FaultInjection::kFault_DropIncomingUDPMsg,
                        PacketBuffer::Free(msg);
                        ExitNow(err = WEAVE_NO_ERROR));
@@ -1708,6 +2182,17 @@ void WeaveMessageLayer::HandleUDPMessage(UDPEndPoint *endPoint, PacketBuffer *ms
     // If an error occurred, discard the message and call the on receive error handler.
     SuccessOrExit(err);
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    // A peer that sent a coalesced datagram accepts them, so coalesce messages sent back to it.  Only
+    // believe this of a datagram carrying a message authenticated with a session key, which cannot be
+    // forged, so that a spoofed datagram cannot have messages sent in a form the peer doesn't expect.
+    if (GetFlag(msgLayer->mFlags, kFlag_ReceivingCoalesced) && msgLayer->MessageCoalescingEnabled() &&
+        msgInfo.KeyId != WeaveKeyId::kNone && !GetFlag(msgInfo.Flags, kWeaveMessageFlag_DuplicateMessage))
+    {
+        msgLayer->AddCoalescingPeer(pktInfo->SrcAddress);
+    }
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
     // Record whether the message was sent to the local node's ephemeral port.
 #if WEAVE_CONFIG_ENABLE_EPHEMERAL_UDP_PORT
     SetFlag(msgInfo.Flags, kWeaveMessageFlag_ViaEphemeralUDPPort,
@@ -1785,6 +2270,104 @@ exit:
     return;
 }
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+/**
+ *  Check the framing of a coalesced datagram: its header, and that it is made up entirely of one or
+ *  more length-prefixed messages, none of which is itself a coalesced datagram.
+ */
+WEAVE_ERROR WeaveMessageLayer::CheckCoalescedDatagram(const PacketBuffer *msg)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    const uint8_t *p = msg->Start();
+    const uint8_t *msgEnd = p + msg->DataLength();
+    uint16_t msgLen;
+
+    VerifyOrExit(msg->Next() == NULL, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    VerifyOrExit(msgEnd - p >= kCoalescedHeaderLen, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    VerifyOrExit(LittleEndian::Read16(p) == kCoalescedDatagramHeader, err = WEAVE_ERROR_INVALID_MESSAGE_FLAG);
+    VerifyOrExit(p < msgEnd, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+
+    for (; p < msgEnd; p += msgLen)
+    {
+        VerifyOrExit(msgEnd - p >= kCoalescedLengthLen + kCoalescedHeaderLen, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+        msgLen = LittleEndian::Read16(p);
+        VerifyOrExit(msgLen >= kCoalescedHeaderLen && msgLen <= msgEnd - p, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+
+        // Coalesced datagrams do not nest.
+        VerifyOrExit(((LittleEndian::Get16(p) & kMsgHeaderField_MessageVersionMask) >> kMsgHeaderField_MessageVersionShift) !=
+                         kWeaveMessageVersion_Coalesced,
+                     err = WEAVE_ERROR_UNSUPPORTED_MESSAGE_VERSION);
+    }
+
+exit:
+    return err;
+}
+
+void WeaveMessageLayer::HandleCoalescedDatagram(UDPEndPoint *endPoint, PacketBuffer *msg, const IPPacketInfo *pktInfo)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    WeaveMessageLayer *msgLayer = (WeaveMessageLayer *) endPoint->AppState;
+    const uint8_t *p = msg->Start() + kCoalescedHeaderLen;
+    const uint8_t *msgEnd = msg->Start() + msg->DataLength();
+    uint16_t msgLen;
+
+    // Check the framing of the whole datagram before handling any of the messages in it.
+    err = CheckCoalescedDatagram(msg);
+    SuccessOrExit(err);
+
+    msgLayer->mCoalescingStats.DatagramsReceived++;
+
+    SetFlag(msgLayer->mFlags, kFlag_ReceivingCoalesced);
+
+    // Handle each message but the last from a buffer of its own, and the last from the datagram's
+    // buffer.  A message that cannot be copied for want of a buffer is dropped, as the datagram
+    // as a whole would have been.
+    while (true)
+    {
+        PacketBuffer *subMsg;
+
+        msgLen = LittleEndian::Read16(p);
+        if (p + msgLen == msgEnd)
+            break;
+
+        subMsg = PacketBuffer::New(0);
+        if (subMsg != NULL && subMsg->AvailableDataLength() >= msgLen)
+        {
+            memcpy(subMsg->Start(), p, msgLen);
+            subMsg->SetDataLength(msgLen);
+            HandleUDPMessage(endPoint, subMsg, pktInfo);
+        }
+        else
+        {
+            PacketBuffer::Free(subMsg);
+            WeaveLogError(MessageLayer, "Dropped coalesced message: %s", nl::ErrorStr(WEAVE_ERROR_NO_MEMORY));
+        }
+
+        p += msgLen;
+    }
+
+    msg->SetStart(const_cast<uint8_t *>(p));
+    msg->SetDataLength(msgLen);
+    HandleUDPMessage(endPoint, msg, pktInfo);
+    msg = NULL;
+
+    ClearFlag(msgLayer->mFlags, kFlag_ReceivingCoalesced);
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(MessageLayer, "HandleCoalescedDatagram Error %s", nl::ErrorStr(err));
+
+        PacketBuffer::Free(msg);
+
+        if (msgLayer->OnReceiveError != NULL)
+            msgLayer->OnReceiveError(msgLayer, err, pktInfo);
+    }
+}
+
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
 void WeaveMessageLayer::HandleUDPReceiveError(UDPEndPoint *endPoint, INET_ERROR err, const IPPacketInfo *pktInfo)
 {
     WeaveLogError(MessageLayer, "HandleUDPReceiveError Error %s", nl::ErrorStr(err));
@@ -2245,25 +2828,15 @@ exit:
     return err;
 }
 
-void WeaveMessageLayer::Encrypt_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *key,
-                                              const uint8_t *inData, uint16_t inLen, uint8_t *outBuf)
-{
-    AES128CTRMode aes128CTR;
-    aes128CTR.SetKey(key);
-    aes128CTR.SetWeaveMessageCounter(msgInfo->SourceNodeId, msgInfo->MessageId);
-    aes128CTR.EncryptData(inData, inLen, outBuf);
-}
-
-void WeaveMessageLayer::ComputeIntegrityCheck_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *key,
-                                                            const uint8_t *inData, uint16_t inLen, uint8_t *outBuf)
+/**
+ *  Encode the message header fields that are covered by the integrity check of an encrypted Weave message.
+ *
+ *  @return  The length of the encoded fields, at most kMaxIntegrityCheckHeaderLen bytes.
+ */
+static uint8_t EncodeIntegrityCheckHeader(const WeaveMessageInfo *msgInfo, uint8_t *encodedBuf)
 {
-    HMACSHA1 hmacSHA1;
-    uint8_t encodedBuf[2 * sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t)];
     uint8_t *p = encodedBuf;
 
-    // Initialize HMAC Key.
-    hmacSHA1.Begin(key, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
-
     // Encode the source and destination node identifiers in a little-endian format.
     Encoding::LittleEndian::Write64(p, msgInfo->SourceNodeId);
     Encoding::LittleEndian::Write64(p, msgInfo->DestNodeId);
@@ -2282,16 +2855,284 @@ void WeaveMessageLayer::ComputeIntegrityCheck_AES128CTRSHA1(const WeaveMessageIn
         Encoding::LittleEndian::Write32(p, msgInfo->MessageId);
     }
 
+    return p - encodedBuf;
+}
+
+/**
+ *  Initialize an HMAC-SHA1 context for computing the integrity check value of a Weave message
+ *  and hash the message header fields that are covered by the integrity check.
+ */
+static void BeginIntegrityCheck_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *key, HMACSHA1 &hmacSHA1)
+{
+    uint8_t encodedBuf[kMaxIntegrityCheckHeaderLen];
+    uint8_t encodedLen;
+
+    // Initialize HMAC Key.
+    hmacSHA1.Begin(key, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
+
     // Hash encoded message header fields.
-    hmacSHA1.AddData(encodedBuf, p - encodedBuf);
+    encodedLen = EncodeIntegrityCheckHeader(msgInfo, encodedBuf);
+    hmacSHA1.AddData(encodedBuf, encodedLen);
+}
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+/**
+ *  Initialize an AES-128-CCM context for encrypting or decrypting a Weave message and authenticate
+ *  the message header fields that are covered by the integrity check.
+ *
+ *  The CCM nonce is formed, like the AES-128-CTR counter, from the sending node id and the message id:
+ *
+ *        (64-bits)     |   (32 bits)
+ *    <sending-node-id> | <message-id>
+ *
+ *  leaving a 3-byte CCM length field.
+ */
+static WEAVE_ERROR BeginAES128CCM(const WeaveMessageInfo *msgInfo, const uint8_t *key, uint16_t payloadLen, AES128CCMMode &aes128CCM)
+{
+    WEAVE_ERROR err;
+    uint8_t nonce[kAES128CCMNonceLen];
+    uint8_t encodedBuf[kMaxIntegrityCheckHeaderLen];
+    uint8_t encodedLen;
+    uint8_t *p = nonce;
+
+    BigEndian::Write64(p, msgInfo->SourceNodeId);
+    BigEndian::Write32(p, msgInfo->MessageId);
+
+    encodedLen = EncodeIntegrityCheckHeader(msgInfo, encodedBuf);
+
+    aes128CCM.SetKey(key);
+    err = aes128CCM.Begin(nonce, sizeof(nonce), encodedLen, payloadLen, kAES128CCMTagLen);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    aes128CCM.AddAAD(encodedBuf, encodedLen);
+
+    return WEAVE_NO_ERROR;
+}
+
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+/**
+ *  Authenticate and encrypt, in place, a message payload that may span a chain of PacketBuffers.
+ *
+ *  The payload begins at @a payloadStart within @a msgBuf and continues through the end of the
+ *  buffer chain. Each buffer is hashed and then encrypted in a single pass, with the CTR-mode
+ *  keystream continuing across buffer boundaries. The resulting integrity check value is appended
+ *  to, and encrypted in, the last buffer in the chain, which must have room for it.
+ */
+void WeaveMessageLayer::EncryptChain_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *dataKey,
+                                                   const uint8_t *integrityKey, PacketBuffer *msgBuf,
+                                                   uint8_t *payloadStart)
+{
+    HMACSHA1 hmacSHA1;
+    AES128CTRMode aes128CTR;
+    PacketBuffer *buf = msgBuf;
+    uint8_t *segStart = payloadStart;
+    uint16_t segLen = msgBuf->DataLength() - (payloadStart - msgBuf->Start());
+
+    BeginIntegrityCheck_AES128CTRSHA1(msgInfo, integrityKey, hmacSHA1);
+
+    aes128CTR.SetKey(dataKey);
+    aes128CTR.SetWeaveMessageCounter(msgInfo->SourceNodeId, msgInfo->MessageId);
+
+    while (true)
+    {
+        // Hash the plaintext of the current segment, then encrypt it in place.
+        hmacSHA1.AddData(segStart, segLen);
+        aes128CTR.EncryptData(segStart, segLen, segStart);
 
-    // Handle payload data.
-    hmacSHA1.AddData(inData, inLen);
+        if (buf->Next() == NULL)
+            break;
+
+        buf = buf->Next();
+        segStart = buf->Start();
+        segLen = buf->DataLength();
+    }
 
-    // Generate the MAC.
-    hmacSHA1.Finish(outBuf);
+    // Store the integrity check value immediately after the payload data and encrypt it.
+    segStart = buf->Start() + buf->DataLength();
+    hmacSHA1.Finish(segStart);
+    aes128CTR.EncryptData(segStart, HMACSHA1::kDigestLength, segStart);
+    buf->SetDataLength(buf->DataLength() + HMACSHA1::kDigestLength, msgBuf);
 }
 
+/**
+ *  Decrypt, in place, and verify a message payload that may span a chain of PacketBuffers.
+ *
+ *  The payload begins at @a payloadStart within @a msgBuf and is followed by the encrypted integrity
+ *  check value, either or both of which may be split across buffer boundaries. The CTR-mode keystream
+ *  continues across buffers and each decrypted segment is hashed as it is produced. The integrity
+ *  check value is trimmed from the tail of the chain.
+ */
+WEAVE_ERROR WeaveMessageLayer::DecryptChain_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *dataKey,
+                                                          const uint8_t *integrityKey, PacketBuffer *msgBuf,
+                                                          uint8_t *payloadStart, uint16_t payloadLen)
+{
+    HMACSHA1 hmacSHA1;
+    AES128CTRMode aes128CTR;
+    uint8_t receivedIntegrityCheck[HMACSHA1::kDigestLength];
+    uint8_t expectedIntegrityCheck[HMACSHA1::kDigestLength];
+    uint16_t payloadRemaining = payloadLen;
+    uint16_t integrityCheckLen = 0;
+    uint8_t *segStart = payloadStart;
+    uint16_t segLen = msgBuf->DataLength() - (payloadStart - msgBuf->Start());
+
+    BeginIntegrityCheck_AES128CTRSHA1(msgInfo, integrityKey, hmacSHA1);
+
+    aes128CTR.SetKey(dataKey);
+    aes128CTR.SetWeaveMessageCounter(msgInfo->SourceNodeId, msgInfo->MessageId);
+
+    for (PacketBuffer *buf = msgBuf; buf != NULL; )
+    {
+        uint16_t segPayloadLen = (segLen < payloadRemaining) ? segLen : payloadRemaining;
+        uint16_t segCheckLen = segLen - segPayloadLen;
+
+        // Decrypt the current segment in place and hash the portion of it that belongs to the payload.
+        aes128CTR.EncryptData(segStart, segLen, segStart);
+        hmacSHA1.AddData(segStart, segPayloadLen);
+        payloadRemaining -= segPayloadLen;
+
+        // Collect any portion of the integrity check value carried in this segment.
+        if (segCheckLen > 0)
+        {
+            if (integrityCheckLen + segCheckLen > HMACSHA1::kDigestLength)
+                return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
+            memcpy(receivedIntegrityCheck + integrityCheckLen, segStart + segPayloadLen, segCheckLen);
+            integrityCheckLen += segCheckLen;
+
+            // Trim the integrity check value so that the buffers hold only the message header and payload.
+            buf->SetDataLength(buf->DataLength() - segCheckLen, msgBuf);
+        }
+
+        buf = buf->Next();
+        if (buf != NULL)
+        {
+            segStart = buf->Start();
+            segLen = buf->DataLength();
+        }
+    }
+
+    if (integrityCheckLen != HMACSHA1::kDigestLength)
+        return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
+
+    hmacSHA1.Finish(expectedIntegrityCheck);
+
+    // Error if the expected integrity check doesn't match the integrity check in the message.
+    if (!ConstantTimeCompare(receivedIntegrityCheck, expectedIntegrityCheck, HMACSHA1::kDigestLength))
+        return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
+
+    return WEAVE_NO_ERROR;
+}
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+/**
+ *  Encrypt and authenticate, in place, a message payload that may span a chain of PacketBuffers
+ *  using AES-128-CCM.
+ *
+ *  The payload begins at @a payloadStart within @a msgBuf and continues through the end of the
+ *  buffer chain. The authentication tag is appended to the last buffer in the chain, which must
+ *  have room for it.
+ */
+WEAVE_ERROR WeaveMessageLayer::EncryptChain_AES128CCM(const WeaveMessageInfo *msgInfo, const uint8_t *key, PacketBuffer *msgBuf,
+                                                      uint8_t *payloadStart, uint16_t payloadLen)
+{
+    WEAVE_ERROR err;
+    AES128CCMMode aes128CCM;
+    PacketBuffer *buf = msgBuf;
+    uint8_t *segStart = payloadStart;
+    uint16_t segLen = msgBuf->DataLength() - (payloadStart - msgBuf->Start());
+
+    err = BeginAES128CCM(msgInfo, key, payloadLen, aes128CCM);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    while (true)
+    {
+        aes128CCM.EncryptData(segStart, segLen, segStart);
+
+        if (buf->Next() == NULL)
+            break;
+
+        buf = buf->Next();
+        segStart = buf->Start();
+        segLen = buf->DataLength();
+    }
+
+    // Store the authentication tag immediately after the payload data.
+    aes128CCM.Finish(buf->Start() + buf->DataLength());
+    buf->SetDataLength(buf->DataLength() + kAES128CCMTagLen, msgBuf);
+
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ *  Decrypt, in place, and verify a message payload that may span a chain of PacketBuffers using
+ *  AES-128-CCM.
+ *
+ *  The payload begins at @a payloadStart within @a msgBuf and is followed by the authentication tag,
+ *  either or both of which may be split across buffer boundaries. The tag is trimmed from the tail
+ *  of the chain.
+ */
+WEAVE_ERROR WeaveMessageLayer::DecryptChain_AES128CCM(const WeaveMessageInfo *msgInfo, const uint8_t *key, PacketBuffer *msgBuf,
+                                                      uint8_t *payloadStart, uint16_t payloadLen)
+{
+    AES128CCMMode aes128CCM;
+    uint8_t receivedTag[kAES128CCMTagLen];
+    uint8_t expectedTag[kAES128CCMTagLen];
+    uint16_t payloadRemaining = payloadLen;
+    uint16_t tagLen = 0;
+    uint8_t *segStart = payloadStart;
+    uint16_t segLen = msgBuf->DataLength() - (payloadStart - msgBuf->Start());
+    WEAVE_ERROR err;
+
+    err = BeginAES128CCM(msgInfo, key, payloadLen, aes128CCM);
+    if (err != WEAVE_NO_ERROR)
+        return err;
+
+    for (PacketBuffer *buf = msgBuf; buf != NULL; )
+    {
+        uint16_t segPayloadLen = (segLen < payloadRemaining) ? segLen : payloadRemaining;
+        uint16_t segTagLen = segLen - segPayloadLen;
+
+        // Decrypt the portion of the current segment that belongs to the payload.
+        aes128CCM.DecryptData(segStart, segPayloadLen, segStart);
+        payloadRemaining -= segPayloadLen;
+
+        // Collect any portion of the authentication tag carried in this segment and trim it from the buffer.
+        if (segTagLen > 0)
+        {
+            if (tagLen + segTagLen > kAES128CCMTagLen)
+                return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
+            memcpy(receivedTag + tagLen, segStart + segPayloadLen, segTagLen);
+            tagLen += segTagLen;
+
+            buf->SetDataLength(buf->DataLength() - segTagLen, msgBuf);
+        }
+
+        buf = buf->Next();
+        if (buf != NULL)
+        {
+            segStart = buf->Start();
+            segLen = buf->DataLength();
+        }
+    }
+
+    if (tagLen != kAES128CCMTagLen)
+        return WEAVE_ERROR_INVALID_MESSAGE_LENGTH;
+
+    aes128CCM.Finish(expectedTag);
+
+    // Error if the expected tag doesn't match the tag in the message.
+    if (!ConstantTimeCompare(receivedTag, expectedTag, kAES128CCMTagLen))
+        return WEAVE_ERROR_INTEGRITY_CHECK_FAILED;
+
+    return WEAVE_NO_ERROR;
+}
+
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
 /**
  *  Close all open TCP and UDP endpoints. Then abort any
  *  open WeaveConnections and shutdown any open
@@ -168,8 +168,10 @@ typedef enum WeaveMessageFlags
 typedef enum WeaveEncryptionType
 {
     kWeaveEncryptionType_None                           = 0, /**< Message not encrypted. */
-    kWeaveEncryptionType_AES128CTRSHA1                  = 1  /**< Message encrypted using AES-128-CTR
+    kWeaveEncryptionType_AES128CTRSHA1                  = 1, /**< Message encrypted using AES-128-CTR
                                                                   encryption with HMAC-SHA-1 message integrity. */
+    kWeaveEncryptionType_AES128CCM                      = 2  /**< Message encrypted and authenticated using
+                                                                  AES-128-CCM with a 16-byte tag. */
 } WeaveEncryptionType;
 
 /**
@@ -186,7 +188,9 @@ typedef enum WeaveMessageVersion
 {
     kWeaveMessageVersion_Unspecified                    = 0, /**< Unspecified message version. */
     kWeaveMessageVersion_V1                             = 1, /**< Message header format version V1. */
-    kWeaveMessageVersion_V2                             = 2  /**< Message header format version V2. */
+    kWeaveMessageVersion_V2                             = 2, /**< Message header format version V2. */
+    kWeaveMessageVersion_Coalesced                      = 15 /**< Not a message header: marks a UDP datagram carrying several
+                                                                  length-prefixed Weave messages. */
 } WeaveMessageVersion;
 
 /**
@@ -262,6 +266,7 @@ public:
     WEAVE_ERROR Connect(uint64_t peerNodeId);
     WEAVE_ERROR Connect(uint64_t peerNodeId, const IPAddress &peerAddr, uint16_t peerPort = 0);
     WEAVE_ERROR Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const IPAddress &peerAddr, uint16_t peerPort = 0, InterfaceId intf = INET_NULL_INTERFACEID);
+    WEAVE_ERROR Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const IPAddress *peerAddrs, uint8_t peerAddrCount, uint16_t peerPort = 0, InterfaceId intf = INET_NULL_INTERFACEID);
     WEAVE_ERROR Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const char *peerAddr, uint16_t defaultPort = 0);
     WEAVE_ERROR Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const char *peerAddr, uint16_t peerAddrLen, uint16_t defaultPort = 0);
     WEAVE_ERROR Connect(uint64_t peerNodeId, WeaveAuthMode authMode, const char *peerAddr, uint16_t peerAddrLen, uint8_t dnsOptions, uint16_t defaultPort);
@@ -415,6 +420,10 @@ private:
 
     IPAddress mPeerAddrs[WEAVE_CONFIG_CONNECT_IP_ADDRS];
     TCPEndPoint *mTcpEndPoint;
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    TCPEndPoint *mConnectAttempts[WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS];
+    IPAddress mConnectAttemptAddrs[WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS];
+#endif
     HostPortList mPeerHostPortList;
     InterfaceId mTargetInterface;
     uint32_t mConnectTimeout;
@@ -429,8 +438,10 @@ private:
     };
 
     uint8_t mFlags;                                     /**< Various flags associated with the connection. */
+    WeaveConnection *mNextFree;                         /**< Next connection on the message layer's free list (only valid while free). */
 
     void Init(WeaveMessageLayer *msgLayer);
+    void DecrementRefCount(void);
     void MakeConnectedTcp(TCPEndPoint *endPoint, const IPAddress &localAddr, const IPAddress &peerAddr);
     WEAVE_ERROR StartConnect(void);
     void DoClose(WEAVE_ERROR err, uint8_t flags);
@@ -440,12 +451,21 @@ private:
     bool StateAllowsReceive(void) const { return State == kState_EstablishingSession || State == kState_Connected || State == kState_SendShutdown; }
     void DisconnectOnError(WEAVE_ERROR err);
     WEAVE_ERROR StartConnectToAddressLiteral(const char *peerAddr, size_t peerAddrLen);
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    int FindConnectAttempt(const TCPEndPoint *endPoint) const;
+    void FinishConnectAttempt(TCPEndPoint *endPoint, INET_ERROR conRes);
+    void AbortConnectAttempts(void);
+    void InterleavePeerAddressFamilies(void);
+#endif
 
 #if WEAVE_CONFIG_TCP_CONN_REPAIR_SUPPORTED
     static void AppCallbackAfterConnectionRepair(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
 #endif // WEAVE_CONFIG_TCP_CONN_REPAIR_SUPPORTED
     static void HandleResolveComplete(void *appState, INET_ERROR err, uint8_t addrCount, IPAddress *addrArray);
     static void HandleConnectComplete(TCPEndPoint *endPoint, INET_ERROR conRes);
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    static void HandleConnectAttemptDelay(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
+#endif
     static void HandleDataReceived(TCPEndPoint *endPoint, PacketBuffer *data);
     static void HandleTcpConnectionClosed(TCPEndPoint *endPoint, INET_ERROR err);
     static void HandleSecureSessionEstablished(WeaveSecurityManager *sm, WeaveConnection *con, void *reqState, uint16_t sessionKeyId, uint64_t peerNodeId, uint8_t encType);
@@ -500,6 +520,7 @@ private:
     WeaveMessageLayer *mMessageLayer;
     TCPEndPoint *mEPOne;
     TCPEndPoint *mEPTwo;
+    WeaveConnectionTunnel *mNextFree;
 
     void Init(WeaveMessageLayer *messageLayer);
     WEAVE_ERROR MakeTunnelConnected(TCPEndPoint *endpointOne, TCPEndPoint *endpointTwo);
@@ -524,6 +545,7 @@ class NL_DLL_EXPORT WeaveMessageLayer
 {
     friend class WeaveMessageLayerTestObject;
     friend class WeaveConnection;
+    friend class WeaveConnectionTunnel;
     friend class WeaveExchangeManager;
     friend class ExchangeContext;
     friend class WeaveFabricState;
@@ -767,6 +789,30 @@ public:
     void SetMessageLayerPktCaptureHandler(MessageLayerPktCaptureHandlerFunct messageLayerPktCaptureHandler);
 #endif // WEAVE_CONFIG_ENABLE_MESSAGE_CAPTURE
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    /**
+     *  Counters of unicast UDP traffic, kept when message coalescing is compiled in.
+     */
+    struct CoalescingStats
+    {
+        uint32_t MessagesSent;                          /**< Unicast Weave messages sent over UDP. */
+        uint32_t MessagesCoalesced;                     /**< Messages sent in a datagram shared with other messages. */
+        uint32_t DatagramsSent;                         /**< Unicast UDP datagrams sent. */
+        uint32_t DatagramBytesSent;                     /**< UDP payload bytes in the datagrams sent. */
+        uint32_t DatagramsReceived;                     /**< Coalesced datagrams received. */
+        uint32_t DatagramSendErrors;                    /**< Coalesced datagrams that could not be sent. */
+    };
+
+    bool MessageCoalescingEnabled(void) const;
+    void SetMessageCoalescingEnabled(bool val);
+    void AddCoalescingPeer(const IPAddress &peerAddr);
+    void RemoveCoalescingPeer(const IPAddress &peerAddr);
+    bool IsCoalescingPeer(const IPAddress &peerAddr) const;
+    void FlushCoalescedMessages(void);
+    const CoalescingStats &GetCoalescingStats(void) const;
+    void ResetCoalescingStats(void);
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
     static uint32_t GetMaxWeavePayloadSize(const PacketBuffer *msgBuf, bool isUDP, uint32_t udpMTU);
 
     static void GetPeerDescription(char *buf, size_t bufSize, uint64_t nodeId, const IPAddress *addr, uint16_t port, InterfaceId interfaceId, const WeaveConnection *con);
@@ -780,12 +826,17 @@ private:
         kFlag_ListenUnsecured           = 0x04,
         kFlag_EphemeralUDPPortEnabled   = 0x08,
         kFlag_ForceRefreshUDPEndPoints  = 0x10,
+        kFlag_CoalesceMessages          = 0x20,
+        kFlag_CoalescingFlushScheduled  = 0x40,
+        kFlag_ReceivingCoalesced        = 0x80,
     };
 
     TCPEndPoint *mIPv6TCPListen;
     UDPEndPoint *mIPv6UDP;
     WeaveConnection mConPool[WEAVE_CONFIG_MAX_CONNECTIONS];
     WeaveConnectionTunnel mTunnelPool[WEAVE_CONFIG_MAX_TUNNELS];
+    WeaveConnection *mFreeConList;                      // Head of the list of free connections in mConPool
+    WeaveConnectionTunnel *mFreeTunnelList;             // Head of the list of free tunnels in mTunnelPool
     uint8_t mFlags;
 
 #if WEAVE_CONFIG_ENABLE_TARGETED_LISTEN
@@ -821,6 +872,30 @@ private:
     MessageLayerPktCaptureHandlerFunct OnMessageCapture;
 #endif // WEAVE_CONFIG_ENABLE_MESSAGE_CAPTURE
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    struct CoalescedDatagram
+    {
+        PacketBuffer *Buf;                              // The datagram being filled; NULL if the entry is free.
+        IPAddress DestAddr;
+        InterfaceId IntfId;
+        uint32_t MsgFlags;                              // Message flags that select the outbound endpoint.
+        uint16_t DestPort;
+        uint8_t MsgCount;
+    };
+
+    CoalescedDatagram mCoalescedDatagrams[WEAVE_CONFIG_MAX_COALESCED_DATAGRAMS];
+    IPAddress mCoalescingPeers[WEAVE_CONFIG_MAX_COALESCING_PEERS];
+    uint8_t mNextCoalescingPeer;
+    CoalescingStats mCoalescingStats;
+
+    WEAVE_ERROR CoalesceMessage(const IPPacketInfo &pktInfo, PacketBuffer *payload, uint32_t msgFlags, bool &coalesced);
+    WEAVE_ERROR SendCoalescedDatagram(CoalescedDatagram &datagram);
+
+    static WEAVE_ERROR CheckCoalescedDatagram(const PacketBuffer *msg);
+    static void HandleCoalescedDatagram(UDPEndPoint *endPoint, PacketBuffer *msg, const IPPacketInfo *pktInfo);
+    static void HandleCoalescingFlush(System::Layer *aSystemLayer, void *aAppState, System::Error aError);
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
     WEAVE_ERROR EnableUnsecuredListen(void);
     WEAVE_ERROR DisableUnsecuredListen(void);
 
@@ -832,15 +907,27 @@ private:
     WEAVE_ERROR RefreshEndpoint(UDPEndPoint *& endPoint, bool enable, const char * name, IPAddressType addrType, IPAddress addr, uint16_t port, InterfaceId intfId);
 
     WEAVE_ERROR SendMessage(IPAddress &destAddr, uint16_t destPort, InterfaceId sendIntfId, PacketBuffer *payload, uint32_t msgFlags);
+    WEAVE_ERROR SendMulticastCopy(UDPEndPoint *ep, const IPPacketInfo &pktInfo, PacketBuffer *payload);
     WEAVE_ERROR SelectOutboundUDPEndPoint(const IPAddress & destAddr, uint32_t msgFlags, UDPEndPoint *& ep);
     WEAVE_ERROR SelectDestNodeIdAndAddress(uint64_t& destNodeId, IPAddress& destAddr);
+    // Decodes the message held in msgBuf, which may be a chain of buffers; every buffer in the chain is
+    // part of the message. On success, rPayload points at the start of the payload in the first buffer
+    // and rPayloadLen is the number of payload bytes in that buffer. If the message spans a chain, the
+    // rest of the payload follows in the subsequent buffers, so callers that need the whole payload
+    // length must use the chain's total length after setting the first buffer to the payload.
     WEAVE_ERROR DecodeMessage(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
             WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen);
     WEAVE_ERROR EncodeMessageWithLength(WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf, WeaveConnection *con,
             uint16_t maxLen);
+    // Decodes the length-prefixed message at the start of msgBuf. The whole frame must be in the first
+    // buffer; any buffers chained after it hold data that follows the frame and are not decoded. On
+    // success, rPayloadLen is the full payload length and msgBuf is adjusted to the data after the frame.
     WEAVE_ERROR DecodeMessageWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
             WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen, uint32_t *rFrameLen);
     void GetIncomingTCPConCount(const IPAddress &peerAddr, uint16_t &count, uint16_t &countFromIP);
+    void InitConnectionPools(void);
+    void FreeConnection(WeaveConnection *con);
+    void FreeConnectionTunnel(WeaveConnectionTunnel *tun);
     void CheckForceRefreshUDPEndPointsNeeded(WEAVE_ERROR udpSendErr);
 
     static void HandleUDPMessage(UDPEndPoint *endPoint, PacketBuffer *msg, const IPPacketInfo *pktInfo);
@@ -848,10 +935,17 @@ private:
     static void HandleIncomingTcpConnection(TCPEndPoint *listeningEndPoint, TCPEndPoint *conEndPoint, const IPAddress &peerAddr,
             uint16_t peerPort);
     static void HandleAcceptError(TCPEndPoint *endPoint, INET_ERROR err);
-    static void Encrypt_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *key,
-                                      const uint8_t *inData, uint16_t inLen, uint8_t *outBuf);
-    static void ComputeIntegrityCheck_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *key,
-                                                    const uint8_t *inData, uint16_t inLen, uint8_t *outBuf);
+    static void EncryptChain_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *dataKey,
+                                           const uint8_t *integrityKey, PacketBuffer *msgBuf, uint8_t *payloadStart);
+    static WEAVE_ERROR DecryptChain_AES128CTRSHA1(const WeaveMessageInfo *msgInfo, const uint8_t *dataKey,
+                                                  const uint8_t *integrityKey, PacketBuffer *msgBuf,
+                                                  uint8_t *payloadStart, uint16_t payloadLen);
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    static WEAVE_ERROR EncryptChain_AES128CCM(const WeaveMessageInfo *msgInfo, const uint8_t *key, PacketBuffer *msgBuf,
+                                              uint8_t *payloadStart, uint16_t payloadLen);
+    static WEAVE_ERROR DecryptChain_AES128CCM(const WeaveMessageInfo *msgInfo, const uint8_t *key, PacketBuffer *msgBuf,
+                                              uint8_t *payloadStart, uint16_t payloadLen);
+#endif
     static WEAVE_ERROR FilterUDPSendError(WEAVE_ERROR err, bool isMulticast);
     static bool IsIgnoredMulticastSendError(WEAVE_ERROR err);
 
@@ -967,6 +1061,34 @@ inline void WeaveMessageLayer::SetEphemeralUDPPortEnabled(bool val)
 
 #endif // WEAVE_CONFIG_ENABLE_EPHEMERAL_UDP_PORT
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+/**
+ *  Check if the WeaveMessageLayer coalesces messages sent to peers that accept coalesced datagrams.
+ */
+inline bool WeaveMessageLayer::MessageCoalescingEnabled(void) const
+{
+    return GetFlag(mFlags, kFlag_CoalesceMessages);
+}
+
+/**
+ *  Returns the counters of unicast UDP traffic since the last reset.
+ */
+inline const WeaveMessageLayer::CoalescingStats &WeaveMessageLayer::GetCoalescingStats(void) const
+{
+    return mCoalescingStats;
+}
+
+/**
+ *  Reset the counters of unicast UDP traffic.
+ */
+inline void WeaveMessageLayer::ResetCoalescingStats(void)
+{
+    memset(&mCoalescingStats, 0, sizeof(mCoalescingStats));
+}
+
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
 /**
  *  Check if unsecured listening is enabled.
  */
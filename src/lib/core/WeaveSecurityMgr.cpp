@@ -113,6 +113,7 @@ WEAVE_ERROR WeaveSecurityManager::Init(WeaveExchangeManager& aExchangeMgr, Syste
     InitiatorAllowedCASEConfigs = CASE::kCASEAllowedConfig_Config2|CASE::kCASEAllowedConfig_Config1;
     InitiatorAllowedCASECurves = WEAVE_CONFIG_DEFAULT_CASE_ALLOWED_CURVES;
 #endif
+    InitiatorEncryptionType = WEAVE_CONFIG_DEFAULT_SESSION_ENCRYPTION_TYPE;
 #if WEAVE_CONFIG_ENABLE_CASE_RESPONDER
     ResponderAllowedCASEConfigs = CASE::kCASEAllowedConfig_Config2|CASE::kCASEAllowedConfig_Config1;
     ResponderAllowedCASECurves = WEAVE_CONFIG_DEFAULT_CASE_ALLOWED_CURVES;
@@ -343,7 +344,7 @@ WEAVE_ERROR WeaveSecurityManager::StartPASESession(WeaveConnection *con, WeaveAu
 
     State = kState_PASEInProgress;
     mRequestedAuthMode = requestedAuthMode;
-    mEncType = kWeaveEncryptionType_AES128CTRSHA1;
+    mEncType = InitiatorEncryptionType;
     mCon = con;
     mStartSecureSession_OnComplete = onComplete;
     mStartSecureSession_OnError = onError;
@@ -425,6 +426,48 @@ void WeaveSecurityManager::HandlePASEMessageInitiator(ExchangeContext *ec, const
     // This is a signal that the responder does not want to continue.
     if (profileId == kWeaveProfile_Common && msgType == kMsgType_StatusReport)
     {
+        // If the responder rejected a proposed encryption type other than AES128CTRSHA1, which all
+        // peers support, restart the PASE session using AES128CTRSHA1.
+        if (secMgr->mEncType != kWeaveEncryptionType_AES128CTRSHA1)
+        {
+            StatusReport rcvdStatusReport;
+            err = StatusReport::parse(msgBuf, rcvdStatusReport);
+            SuccessOrExit(err);
+            if (rcvdStatusReport.mProfileId == kWeaveProfile_Security &&
+                rcvdStatusReport.mStatusCode == Security::kStatusCode_UnsupportedEncryptionType)
+            {
+                uint32_t paseConfig = secMgr->mPASEEngine->ProtocolConfig;
+                const uint8_t *pw = secMgr->mPASEEngine->Pw;
+                uint16_t pwLen = secMgr->mPASEEngine->PwLen;
+
+                WeaveLogProgress(SecurityManager, "PASE encryption type %d rejected; retrying with %d",
+                                 secMgr->mEncType, kWeaveEncryptionType_AES128CTRSHA1);
+
+                PacketBuffer::Free(msgBuf);
+                msgBuf = NULL;
+
+                secMgr->mEncType = kWeaveEncryptionType_AES128CTRSHA1;
+
+                // Create a new exchange context for the new PASE session, since the responder ended
+                // the initial exchange when it sent the status report.
+                err = secMgr->NewSessionExchange(ec->PeerNodeId, ec->PeerAddr, ec->PeerPort);
+                SuccessOrExit(err);
+
+                // Return the PASE engine to its initial state, retaining the password and the
+                // proposed configuration, and resend the initiator's first message.
+                secMgr->mPASEEngine->Reset();
+                secMgr->mPASEEngine->Pw = pw;
+                secMgr->mPASEEngine->PwLen = pwLen;
+
+                err = secMgr->SendPASEInitiatorStep1(paseConfig);
+                SuccessOrExit(err);
+
+                secMgr->mEC->OnMessageReceived = HandlePASEMessageInitiator;
+                secMgr->mEC->OnConnectionClosed = HandleConnectionClosed;
+                ExitNow();
+            }
+        }
+
 #if WEAVE_CONFIG_SUPPORT_PASE_CONFIG1
         // Check if Error Status is coming from the old version of PASE code, which only supports Config1
         StatusReport rcvdStatusReport;
@@ -537,7 +580,7 @@ WEAVE_ERROR WeaveSecurityManager::SendPASEInitiatorStep1(uint32_t paseConfig)
 
     // Generate and encode PASE step 1 message.
     Platform::Security::OnTimeConsumingCryptoStart();
-    err = mPASEEngine->GenerateInitiatorStep1(msgBuf, paseConfig, FabricState->LocalNodeId, mEC->PeerNodeId, mSessionKeyId, kWeaveEncryptionType_AES128CTRSHA1, pwSource, FabricState, true);
+    err = mPASEEngine->GenerateInitiatorStep1(msgBuf, paseConfig, FabricState->LocalNodeId, mEC->PeerNodeId, mSessionKeyId, mEncType, pwSource, FabricState, true);
     Platform::Security::OnTimeConsumingCryptoDone();
     SuccessOrExit(err);
 
@@ -941,7 +984,7 @@ WEAVE_ERROR WeaveSecurityManager::StartCASESession(WeaveConnection *con, uint64_
     WeaveSessionKey *sessionKey = NULL;
     bool clearStateOnError = false;
     bool isSharedSession = (terminatingNodeId != kNodeIdNotSpecified);
-    const uint8_t encType = kWeaveEncryptionType_AES128CTRSHA1; // Only one encryption type supported for now.
+    const uint8_t encType = InitiatorEncryptionType;
 
     // Verify security manager has been initialized.
     VerifyOrExit(State != kState_NotInitialized, err = WEAVE_ERROR_INCORRECT_STATE);
@@ -1040,16 +1083,8 @@ WEAVE_ERROR WeaveSecurityManager::StartCASESession(WeaveConnection *con, uint64_
     VerifyOrExit(authDelegate != NULL, err = WEAVE_ERROR_NO_CASE_AUTH_DELEGATE);
     mCASEEngine->AuthDelegate = authDelegate;
 
-    // Set the allowed CASE configs and ECDH curves.
-    mCASEEngine->SetAllowedConfigs(InitiatorAllowedCASEConfigs);
-    mCASEEngine->SetAllowedCurves(InitiatorAllowedCASECurves);
-
-    // Set the expected peer certificate type based on the requested authentication mode.
-    mCASEEngine->SetCertType(CertTypeFromAuthMode(requestedAuthMode));
-
-#if WEAVE_CONFIG_SECURITY_TEST_MODE
-    mCASEEngine->SetUseKnownECDHKey(CASEUseKnownECDHKey);
-#endif
+    // Configure the CASE engine for initiating a session.
+    ConfigureCASEInitiatorEngine();
 
     // Start CASE Session using specified initiator parameters.
     StartCASESession(InitiatorCASEConfig, InitiatorCASECurveId);
@@ -1066,6 +1101,20 @@ exit:
     return err;
 }
 
+void WeaveSecurityManager::ConfigureCASEInitiatorEngine(void)
+{
+    // Set the allowed CASE configs and ECDH curves.
+    mCASEEngine->SetAllowedConfigs(InitiatorAllowedCASEConfigs);
+    mCASEEngine->SetAllowedCurves(InitiatorAllowedCASECurves);
+
+    // Set the expected peer certificate type based on the requested authentication mode.
+    mCASEEngine->SetCertType(CertTypeFromAuthMode(mRequestedAuthMode));
+
+#if WEAVE_CONFIG_SECURITY_TEST_MODE
+    mCASEEngine->SetUseKnownECDHKey(CASEUseKnownECDHKey);
+#endif
+}
+
 void WeaveSecurityManager::StartCASESession(uint32_t config, uint32_t curveId)
 {
     WEAVE_ERROR err;
@@ -1134,7 +1183,40 @@ void WeaveSecurityManager::HandleCASEMessageInitiator(ExchangeContext *ec, const
     // Abort the CASE interaction immediately if we receive a status report message from the responder.
     // This is a signal that the responder does not want to continue.
     if (profileId == kWeaveProfile_Common && msgType == kMsgType_StatusReport)
+    {
+        // If the responder rejected a proposed encryption type other than AES128CTRSHA1, which all
+        // peers support, restart the CASE session using AES128CTRSHA1.
+        if (secMgr->mEncType != kWeaveEncryptionType_AES128CTRSHA1)
+        {
+            StatusReport rcvdStatusReport;
+            err = StatusReport::parse(msgBuf, rcvdStatusReport);
+            SuccessOrExit(err);
+            if (rcvdStatusReport.mProfileId == kWeaveProfile_Security &&
+                rcvdStatusReport.mStatusCode == Security::kStatusCode_UnsupportedEncryptionType)
+            {
+                WeaveLogProgress(SecurityManager, "CASE encryption type %d rejected; retrying with %d",
+                                 secMgr->mEncType, kWeaveEncryptionType_AES128CTRSHA1);
+
+                PacketBuffer::Free(msgBuf);
+                msgBuf = NULL;
+
+                secMgr->mEncType = kWeaveEncryptionType_AES128CTRSHA1;
+
+                // Create a new exchange context for the new CASE session, for the same reason as when
+                // handling a Reconfigure message.
+                err = secMgr->NewSessionExchange(ec->PeerNodeId, ec->PeerAddr, ec->PeerPort);
+                SuccessOrExit(err);
+
+                // Return the CASE engine to its initial state and restart the session.
+                secMgr->mCASEEngine->Reset();
+                secMgr->ConfigureCASEInitiatorEngine();
+                secMgr->StartCASESession(secMgr->InitiatorCASEConfig, secMgr->InitiatorCASECurveId);
+                ExitNow();
+            }
+        }
+
         ExitNow(err = WEAVE_ERROR_STATUS_REPORT_RECEIVED);
+    }
 
     // All other messages must be part of the Security profile.
     VerifyOrExit(profileId == kWeaveProfile_Security, err = WEAVE_ERROR_INVALID_MESSAGE_TYPE);
@@ -201,6 +201,7 @@ public:
     uint8_t InitiatorAllowedCASEConfigs;                // Set of allowed CASE configurations when initiating a CASE session
     uint8_t InitiatorAllowedCASECurves;                 // Set of allowed ECDH curves when initiating a CASE session
 #endif
+    uint8_t InitiatorEncryptionType;                    // Message encryption type proposed when initiating a CASE or PASE session
 #if WEAVE_CONFIG_ENABLE_CASE_RESPONDER
     uint8_t ResponderAllowedCASEConfigs;                // Set of allowed CASE configurations when responding to CASE session
     uint8_t ResponderAllowedCASECurves;                 // Set of allowed ECDH curves when responding to CASE session
@@ -459,6 +460,7 @@ private:
     static void HandlePASEMessageResponder(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo,
             uint32_t profileId, uint8_t msgType, PacketBuffer *msgBuf);
 
+    void ConfigureCASEInitiatorEngine(void);
     void StartCASESession(uint32_t config, uint32_t curveId);
     void HandleCASESessionStart(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf);
     static void HandleCASEMessageInitiator(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo,
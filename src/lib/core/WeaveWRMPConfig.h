@@ -113,6 +113,118 @@ namespace Weave {
 #define WEAVE_CONFIG_WRMP_DEFAULT_MAX_RETRANS               (3)
 #endif // WEAVE_CONFIG_WRMP_DEFAULT_MAX_RETRANS
 
+/**
+ *  @def WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+ *
+ *  @brief
+ *    If set to (1), WRMP measures the round trip time of each
+ *    acknowledged message that was sent only once, keeps a smoothed
+ *    round trip time and variance for each peer node, and derives the
+ *    retransmission timeout for that peer from them. The configured
+ *    initial and active retransmission timeouts are used until the
+ *    first measurement for a peer is taken. Every timer tick in which
+ *    messages to a peer are retransmitted doubles its timeout until the
+ *    next measurement.
+ *
+ *    Adaptive timeouts are off at run time until enabled with
+ *    WeaveExchangeManager::SetAdaptiveRetransTimeoutEnabled().
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+#define WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT          0
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT
+ *
+ *  @brief
+ *    The smallest retransmission timeout in milliseconds that is derived
+ *    from a peer's round trip time, when
+ *    #WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT is enabled.
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT
+#define WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT               (2 * WEAVE_CONFIG_WRMP_TIMER_DEFAULT_PERIOD)
+#endif // WEAVE_CONFIG_WRMP_MIN_RETRANS_TIMEOUT
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT
+ *
+ *  @brief
+ *    The largest retransmission timeout in milliseconds that is derived
+ *    from a peer's round trip time, including any backoff, when
+ *    #WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT is enabled.
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT
+#define WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT               (30000)
+#endif // WEAVE_CONFIG_WRMP_MAX_RETRANS_TIMEOUT
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+ *
+ *  @brief
+ *    If set to (1), WRMP can acknowledge messages received on several
+ *    exchanges with the same peer in a single Common::WRMP Ack List
+ *    message. Nodes that have ack aggregation enabled advertise it in
+ *    the exchange header of every WRMP message they send, and acks are
+ *    only aggregated towards peers that have advertised it.
+ *
+ *    Ack aggregation is off at run time until enabled with
+ *    WeaveExchangeManager::SetAckAggregationEnabled().
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+#define WEAVE_CONFIG_WRMP_ACK_AGGREGATION                   0
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+ *
+ *  @brief
+ *    If set to (1), WRMP limits the number of unacknowledged messages
+ *    to each peer node to a congestion window. The window grows by one
+ *    message for every window's worth of acknowledgments, and is halved
+ *    when messages to the peer have to be retransmitted or the peer
+ *    throttles the flow. Messages sent while the window is full are
+ *    held in the retransmission table and sent in order as
+ *    acknowledgments open the window, and retransmissions to a peer are
+ *    spread over successive timer ticks so that no more than a window's
+ *    worth of them are sent at once.
+ *
+ *    Congestion control is off at run time until enabled with
+ *    WeaveExchangeManager::SetCongestionControlEnabled().
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+#define WEAVE_CONFIG_WRMP_CONGESTION_CONTROL                0
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW
+ *
+ *  @brief
+ *    The number of unacknowledged messages that may be sent to a peer
+ *    node before any acknowledgment has been received from it, when
+ *    #WEAVE_CONFIG_WRMP_CONGESTION_CONTROL is enabled.
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW
+#define WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW         (4)
+#endif // WEAVE_CONFIG_WRMP_INITIAL_CONGESTION_WINDOW
+
+/**
+ *  @def WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW
+ *
+ *  @brief
+ *    The largest number of unacknowledged messages that may be sent to a
+ *    peer node, when #WEAVE_CONFIG_WRMP_CONGESTION_CONTROL is enabled.
+ *
+ */
+#ifndef WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW
+#define WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW             (32)
+#endif // WEAVE_CONFIG_WRMP_MAX_CONGESTION_WINDOW
+
 /**
  *  @brief
  *    The WRMP configuration.
@@ -120,6 +120,17 @@ enum
     kStatus_Unknown =                       0x005F,
 };
 
+/*
+ * profile-specific TLV tags that may appear in the metadata of a
+ * SendInit or ReceiveInit message.
+ * - resume hash, rolling hash over the data preceding the proposed
+ * start offset, present when the init resumes an interrupted transfer.
+ */
+enum
+{
+    kTag_ResumeHash =                       0x01,
+};
+
 } // namespace WeaveMakeManagedNamespaceIdentifier(BDX, kWeaveManagedNamespaceDesignation_Development)
 } // namespace Profiles
 } // namespace Weave
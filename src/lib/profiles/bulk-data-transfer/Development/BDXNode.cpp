@@ -720,6 +720,7 @@ void BdxNode::HandleReceiveInit(ExchangeContext *anEc, const IPPacketInfo *aPktI
     xfer->mIsAccepted = false;
     xfer->mAmSender = true;
     xfer->mMaxBlockSize = receiveInit.mMaxBlockSize;
+    xfer->mStartOffset = receiveInit.mStartOffset;
     xfer->mVersion = (receiveInit.mVersion > WEAVE_CONFIG_BDX_VERSION) ? WEAVE_CONFIG_BDX_VERSION : receiveInit.mVersion;
 
     // Verify we have a legitimate block size or reject
@@ -866,6 +867,7 @@ void BdxNode::HandleSendInit(ExchangeContext *anEc, const IPPacketInfo *aPktInfo
     xfer->mMaxBlockSize = sendInit.mMaxBlockSize;
     xfer->mAmInitiator = false;
     xfer->mAmSender = false;
+    xfer->mStartOffset = sendInit.mStartOffset;
     xfer->mVersion = (sendInit.mVersion > WEAVE_CONFIG_BDX_VERSION) ? WEAVE_CONFIG_BDX_VERSION : sendInit.mVersion;
 
     // Fire application callback to validate request and setup transfer
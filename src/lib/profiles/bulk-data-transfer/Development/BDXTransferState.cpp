@@ -22,6 +22,8 @@
  *      the state of an ongoing transfer and is managed by the BdxNode.
  */
 
+#include <Weave/Core/WeaveTLV.h>
+#include <Weave/Support/CodeUtils.h>
 #include <Weave/Support/logging/WeaveLogging.h>
 
 #include <Weave/Profiles/bulk-data-transfer/Development/BDXTransferState.h>
@@ -32,6 +34,163 @@ namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(BDX, kWeaveManagedNamespaceDesignation_Development) {
 
 using namespace nl::Weave::Logging;
+using namespace nl::Weave::TLV;
+
+// Largest prime below 2^16, the modulus of the Adler-32 checksum.
+#define BDX_RESUME_HASH_MODULUS 65521
+
+// Number of bytes that can be summed before the 32-bit Adler-32 accumulators
+// must be reduced modulo BDX_RESUME_HASH_MODULUS to avoid overflow.
+#define BDX_RESUME_HASH_MAX_RUN 5552
+
+/**
+ * @brief
+ *      Rewinds the cursor to the beginning of the file.
+ */
+void BDXResumeCursor::Reset(void)
+{
+    mOffset = 0;
+    mHash   = 1;
+}
+
+/**
+ * @brief
+ *      Extends the cursor over the next block of contiguous data.
+ *
+ * @param[in]   aData       Pointer to the data immediately following mOffset
+ * @param[in]   aLength     Length of the data
+ */
+void BDXResumeCursor::Update(const uint8_t *aData, uint64_t aLength)
+{
+    uint32_t a = mHash & 0xFFFF;
+    uint32_t b = (mHash >> 16) & 0xFFFF;
+    uint64_t remaining = aLength;
+
+    while (remaining > 0)
+    {
+        uint32_t run = (remaining < BDX_RESUME_HASH_MAX_RUN) ? static_cast<uint32_t>(remaining) : BDX_RESUME_HASH_MAX_RUN;
+
+        remaining -= run;
+
+        while (run-- > 0)
+        {
+            a += *aData++;
+            b += a;
+        }
+
+        a %= BDX_RESUME_HASH_MODULUS;
+        b %= BDX_RESUME_HASH_MODULUS;
+    }
+
+    mHash = (b << 16) | a;
+    mOffset += aLength;
+}
+
+/**
+ * @brief
+ *      Writes the resume hash as TLV metadata suitable for a SendInit or
+ *      ReceiveInit message.
+ *
+ * @param[in]   aBuffer             The destination buffer
+ * @param[in]   aBufferLength       The length of the destination buffer
+ * @param[out]  aNumBytesWritten    The number of bytes written to aBuffer
+ *
+ * @retval      #WEAVE_NO_ERROR                 If successful
+ * @retval      #WEAVE_ERROR_BUFFER_TOO_SMALL   If aBuffer cannot hold the metadata
+ */
+WEAVE_ERROR BDXResumeCursor::Encode(uint8_t *aBuffer, uint16_t aBufferLength, uint16_t &aNumBytesWritten) const
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVWriter writer;
+    TLVType container;
+
+    aNumBytesWritten = 0;
+
+    writer.Init(aBuffer, aBufferLength);
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, container);
+    SuccessOrExit(err);
+
+    err = writer.Put(ProfileTag(kWeaveProfile_BDX, kTag_ResumeHash), mHash);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(container);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    aNumBytesWritten = static_cast<uint16_t>(writer.GetLengthWritten());
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *      Loads the cursor proposed by the initiator of a resumed transfer.
+ *
+ * @param[in]   aMetaData       Metadata of the received SendInit or ReceiveInit
+ * @param[in]   aStartOffset    Start offset proposed by the same message
+ *
+ * @retval      #WEAVE_NO_ERROR                 If the metadata carried a resume hash
+ * @retval      #WEAVE_ERROR_TLV_TAG_NOT_FOUND  If the init is not a resume request
+ * @retval      other                           The metadata could not be parsed
+ */
+WEAVE_ERROR BDXResumeCursor::Decode(const ReferencedTLVData &aMetaData, uint64_t aStartOffset)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVReader reader;
+    TLVType container;
+
+    VerifyOrExit(aMetaData.theLength > 0, err = WEAVE_ERROR_TLV_TAG_NOT_FOUND);
+
+    reader.Init(aMetaData.theData, aMetaData.theLength);
+
+    err = reader.Next(kTLVType_Structure, AnonymousTag);
+    SuccessOrExit(err);
+
+    err = reader.EnterContainer(container);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        if (reader.GetTag() == ProfileTag(kWeaveProfile_BDX, kTag_ResumeHash))
+        {
+            err = reader.Get(mHash);
+            SuccessOrExit(err);
+
+            mOffset = aStartOffset;
+            ExitNow();
+        }
+    }
+
+    if (err == WEAVE_END_OF_TLV)
+    {
+        err = WEAVE_ERROR_TLV_TAG_NOT_FOUND;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *      SendInit::MetaDataTLVWriteCallback that writes the resume hash of the
+ *      BDXResumeCursor passed as aAppState.
+ *
+ * @see BDXResumeCursor::Encode
+ */
+WEAVE_ERROR BDXResumeCursor::WriteMetaData(uint8_t *aBuffer, uint16_t aBufferLength,
+                                           uint16_t &aNumBytesWritten, void *aAppState)
+{
+    return static_cast<const BDXResumeCursor *>(aAppState)->Encode(aBuffer, aBufferLength, aNumBytesWritten);
+}
+
+bool BDXResumeCursor::operator == (const BDXResumeCursor &aOther) const
+{
+    return (mOffset == aOther.mOffset && mHash == aOther.mHash);
+}
 
 /**
  * @brief
@@ -83,6 +242,7 @@ void BDXTransfer::Reset(void)
     mLength                         = 0;
     mBytesSent                      = 0;
     mBlockCounter                   = 0;
+    mResumeCursor.Reset();
     mIsWideRange                    = false;
     mIsCompletedSuccessfully        = false;
     mAmInitiator                    = false;
@@ -213,7 +373,8 @@ void BDXTransfer::DispatchRejectHandler(StatusReport *aReport)
 
 /**
  * @brief
- *  If the put block handler has been set, call it.
+ *  Advance the resume cursor over the received block and, if the put block
+ *  handler has been set, call it.
  *
  * @param[in]   aLength             Length of block
  * @param[in]   aDataBlock          Pointer to the data block
@@ -223,6 +384,8 @@ void BDXTransfer::DispatchPutBlockHandler(uint64_t aLength,
                                           uint8_t *aDataBlock,
                                           bool aLastBlock)
 {
+    mResumeCursor.Update(aDataBlock, aLength);
+
     if (mHandlers.mPutBlockHandler)
     {
         mHandlers.mPutBlockHandler(this, aLength, aDataBlock, aLastBlock);
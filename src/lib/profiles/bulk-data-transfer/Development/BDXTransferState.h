@@ -239,6 +239,49 @@ struct BDXHandlers
     ErrorHandler            mErrorHandler;
 };
 
+/**
+ * @brief
+ *  Position up to which a transfer has been contiguously delivered, together
+ *  with a rolling hash of all the data preceding that position.
+ *
+ * On the receiving side the protocol advances the cursor of a BDXTransfer
+ * every time an in-order block is handed to the PutBlockHandler, so the
+ * handler may persist it right after the block has been committed to
+ * storage. After an interruption, the application resumes the transfer by
+ * proposing the persisted mOffset as the start offset of a new SendInit or
+ * ReceiveInit and carrying mHash in the init metadata (see WriteMetaData()).
+ * The node holding the source data recomputes the hash over its first
+ * mOffset bytes and only accepts the resumed transfer if both agree;
+ * otherwise it rejects with kStatus_StartOffsetNotSupported and the
+ * transfer must be restarted from the beginning.
+ *
+ * The protocol does not advance the cursor on the sending side, since blocks
+ * are not retained until they are acknowledged; a sender wanting to resume
+ * must maintain it from its GetBlockHandler.
+ *
+ * The hash is an Adler-32 checksum: it can be extended incrementally one
+ * block at a time and fits in 4 bytes of persistent storage. It guards
+ * against resuming on top of stale or mismatched data, not against a
+ * malicious peer.
+ */
+struct BDXResumeCursor
+{
+    uint64_t            mOffset; // Number of contiguous bytes delivered so far
+    uint32_t            mHash; // Rolling hash over the first mOffset bytes
+
+    void Reset(void);
+
+    void Update(const uint8_t *aData, uint64_t aLength);
+
+    WEAVE_ERROR Encode(uint8_t *aBuffer, uint16_t aBufferLength, uint16_t &aNumBytesWritten) const;
+    WEAVE_ERROR Decode(const ReferencedTLVData &aMetaData, uint64_t aStartOffset);
+
+    static WEAVE_ERROR WriteMetaData(uint8_t *aBuffer, uint16_t aBufferLength,
+                                     uint16_t &aNumBytesWritten, void *aAppState);
+
+    bool operator == (const BDXResumeCursor &aOther) const;
+};
+
 /** This structure contains data members representing an active BDX transfer.
  * These objects are used by the BdxProtocol to maintain protocol state.
  * They are managed by the BdxServer, which handles creating and initializing
@@ -289,6 +332,11 @@ struct BDXTransfer
      * and the first query sent that is).
      */
     uint32_t            mBlockCounter;
+    /** Contiguous data delivered so far, counted from the beginning of the
+     * file rather than from mStartOffset. Seed it with a persisted cursor
+     * before initiating a resumed transfer; see BDXResumeCursor.
+     */
+    BDXResumeCursor     mResumeCursor;
 
     // application-supplied handlers
     //TODO: make these private when BdxProtocol doesn't inspect them directly
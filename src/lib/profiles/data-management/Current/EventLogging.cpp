@@ -151,6 +151,15 @@ event_id_t LogFreeform(ImportanceType inImportance, const char * inFormat, ...)
     return eid;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+WEAVE_ERROR FetchMatchingEvents(TLVWriter & ioWriter, const EventQuery & inQuery, event_id_t & ioEventID)
+{
+    LoggingManagement & logManager = LoggingManagement::GetInstance();
+
+    return logManager.FetchMatchingEvents(ioWriter, inQuery, ioEventID);
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 } // namespace Profiles
 } // namespace Weave
@@ -253,6 +253,36 @@ event_id_t LogFreeform(ImportanceType inImportance, const char * inFormat, ...);
  */
 WEAVE_ERROR PlainTextWriter(::nl::Weave::TLV::TLVWriter & ioWriter, uint8_t inDataTag, void * appData);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+/**
+ * @brief
+ *   Fetch the logged events that match a query.
+ *
+ * The function writes the events of the query's importance, starting
+ * with `ioEventID`, that are of the query's profile and were logged in
+ * the query's time range.  Regions of the log that hold no such events
+ * are passed over without being decoded.
+ *
+ * @param[inout] ioWriter  The writer to use for the events.
+ *
+ * @param[in] inQuery      The events to be fetched.
+ *
+ * @param[inout] ioEventID On input, the ID of the first event to
+ *                         consider.  On completion, the ID of the
+ *                         event following the last one considered.
+ *
+ * @retval #WEAVE_END_OF_TLV      All the matching events in the log were written.
+ *
+ * @retval #WEAVE_ERROR_NO_MEMORY The writer ran out of space; more
+ *                                matching events may be available.
+ *
+ * @retval other                  Other errors that may be returned from the ioWriter.
+ *
+ * @sa LoggingManagement::FetchMatchingEvents
+ */
+WEAVE_ERROR FetchMatchingEvents(nl::Weave::TLV::TLVWriter & ioWriter, const EventQuery & inQuery, event_id_t & ioEventID);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 } // namespace Profiles
 } // namespace Weave
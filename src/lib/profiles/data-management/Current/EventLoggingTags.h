@@ -148,6 +148,7 @@ enum
 
     kTag_EventData               = 50, ///< Optional.  Event data itself.  If empty, it defaults to an empty structure.
 
+    kTag_EventHeaderReference    = 98, ///< Internal tag for compactly encoded events, standing in for the profile ID and event type.  Never transmitted across the wire, should never be used outside of Weave library
     kTag_ExternalEventStructure  = 99, ///< Internal tag for external events.  Never transmitted across the wire, should never be used outside of Weave library
 
 };
@@ -219,6 +220,17 @@ enum
 #endif
 };
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+/**
+ *  Tags for persisting the compact encoding dictionary
+ */
+enum
+{
+    kTag_PersistEvent_HeaderProfileIds              = 13,
+    kTag_PersistEvent_HeaderEventTypes              = 14
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 } // namespace Profiles
 } // namespace Weave
@@ -76,11 +76,42 @@ EventOptions::EventOptions(utc_timestamp_t aUtcTimestamp, DetailedRootSection *
     timestampType(kTimestampType_UTC), urgent(aUrgent)
 { }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+EventQuery::EventQuery(ImportanceType aImportance) :
+    importance(aImportance), matchProfile(false), profileId(0), timestampType(kTimestampType_Invalid), startTime(), endTime()
+{ }
+
+void EventQuery::SetProfile(uint32_t aProfileId)
+{
+    matchProfile = true;
+    profileId    = aProfileId;
+}
+
+void EventQuery::SetTimeRange(timestamp_t aStartTime, timestamp_t aEndTime)
+{
+    timestampType = kTimestampType_System;
+    startTime     = Timestamp(aStartTime);
+    endTime       = Timestamp(aEndTime);
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+void EventQuery::SetTimeRange(utc_timestamp_t aStartTime, utc_timestamp_t aEndTime)
+{
+    timestampType = kTimestampType_UTC;
+    startTime     = Timestamp(aStartTime);
+    endTime       = Timestamp(aEndTime);
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 EventLoadOutContext::EventLoadOutContext(nl::Weave::TLV::TLVWriter & inWriter, ImportanceType inImportance,
                                          uint32_t inStartingEventID, ExternalEvents * ioExternalEvents) :
     mWriter(inWriter),
     mImportance(inImportance), mStartingEventID(inStartingEventID), mCurrentTime(0), mCurrentEventID(0),
     mExternalEvents(ioExternalEvents),
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    mHeaderDictionary(NULL),
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
 #if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
     mCurrentUTCTime(0), mFirstUtc(true),
 #endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
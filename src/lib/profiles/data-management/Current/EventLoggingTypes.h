@@ -228,6 +228,39 @@ struct EventOptions
     bool urgent;                       /**< A flag denoting that the event is time sensitive.  When set, it causes the event log to be flushed. */
 };
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+/**
+ *   The structure that selects the events fetched by LoggingManagement::FetchMatchingEvents().
+ */
+struct EventQuery
+{
+    EventQuery(ImportanceType aImportance);
+
+    void SetProfile(uint32_t aProfileId);
+    void SetTimeRange(timestamp_t aStartTime, timestamp_t aEndTime);
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    void SetTimeRange(utc_timestamp_t aStartTime, utc_timestamp_t aEndTime);
+#endif
+
+    ImportanceType importance;   /**< The importance of the events to fetch. */
+
+    bool matchProfile;           /**< When set, only events of `profileId` are fetched. */
+
+    uint32_t profileId;          /**< The profile ID of the events to fetch, when `matchProfile` is set. */
+
+    TimestampType timestampType; /**< The type of `startTime` and `endTime`, or kTimestampType_Invalid to fetch events logged at any
+                                      time.  Otherwise, only events timestamped with this type of timestamp are fetched. */
+
+    Timestamp startTime;         /**< The earliest timestamp of the events to fetch. */
+
+    Timestamp endTime;           /**< The latest timestamp of the events to fetch. */
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+struct EventHeaderDictionary;
+#endif
+
 /**
  * @brief
  *   Structure for copying event lists on output.
@@ -243,6 +276,9 @@ struct EventLoadOutContext
     uint32_t mCurrentTime;
     uint32_t mCurrentEventID;
     ExternalEvents *mExternalEvents;
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    EventHeaderDictionary *mHeaderDictionary; ///< When set, BlitEvent() may encode the event header compactly using this dictionary
+#endif
 #if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
     uint64_t mCurrentUTCTime;
     bool mFirstUtc;
@@ -30,6 +30,7 @@
 #include <map>
 #include <queue>
 #include <limits>
+#include <unordered_map>
 #include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
 #include <Weave/Profiles/data-management/TraitCatalog.h>
 
@@ -42,6 +43,10 @@ namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNames
  *
  *  @brief A Weave provided implementation of the TraitCatalogBase interface for a collection of trait data instances
  *         that all refer to the same resource. It provides a c++ map-backed storage for these instances.
+ *
+ *         In addition to the handle-keyed store, the catalog maintains hash indexes keyed by trait path
+ *         (resource, profile and instance id) and by trait instance pointer, so that mapping an incoming
+ *         path or instance to its handle does not require a scan of the whole catalog.
  */
 template <typename T>
 class GenericTraitCatalogImpl : public TraitCatalogBase<T>
@@ -93,11 +98,31 @@ private:
         PropertyPathHandle mBasePathHandle;
     };
 
+    struct PathKey
+    {
+        PathKey(uint32_t aProfileId, uint64_t aInstanceId, const ResourceIdentifier & aResourceId);
+
+        bool operator ==(const PathKey & aOther) const;
+
+        uint64_t mInstanceId;
+        uint64_t mResourceId;
+        uint32_t mProfileId;
+        uint16_t mResourceType;
+    };
+
+    struct PathKeyHash
+    {
+        size_t operator ()(const PathKey & aKey) const;
+    };
+
     TraitDataHandle GetNextHandle();
+    void RemoveFromIndexes(TraitDataHandle aHandle, const CatalogItem * aItem);
 
     uint64_t mNodeId;
     std::map<TraitDataHandle, CatalogItem *> mItemStore;
     std::queue<TraitDataHandle> mRecycledHandles;
+    std::unordered_map<PathKey, TraitDataHandle, PathKeyHash> mPathIndex;
+    std::unordered_map<const T *, TraitDataHandle> mInstanceIndex;
 };
 
 typedef GenericTraitCatalogImpl<TraitDataSink> GenericTraitSinkCatalog;
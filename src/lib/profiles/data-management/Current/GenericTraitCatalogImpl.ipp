@@ -22,6 +22,7 @@
 #include <map>
 #include <queue>
 #include <limits>
+#include <unordered_map>
 #include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
 #include <Weave/Profiles/data-management/TraitCatalog.h>
 
@@ -30,6 +31,37 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 
+template <typename T>
+GenericTraitCatalogImpl<T>::PathKey::PathKey(uint32_t aProfileId, uint64_t aInstanceId, const ResourceIdentifier & aResourceId) :
+    mInstanceId(aInstanceId), mResourceId(aResourceId.GetResourceId()), mProfileId(aProfileId),
+    mResourceType(aResourceId.GetResourceType())
+{ }
+
+template <typename T>
+bool GenericTraitCatalogImpl<T>::PathKey::operator ==(const PathKey & aOther) const
+{
+    return mProfileId == aOther.mProfileId && mInstanceId == aOther.mInstanceId && mResourceId == aOther.mResourceId &&
+        mResourceType == aOther.mResourceType;
+}
+
+template <typename T>
+size_t GenericTraitCatalogImpl<T>::PathKeyHash::operator ()(const PathKey & aKey) const
+{
+    // Mix the fields with the 64-bit finalizer from MurmurHash3; resource and instance ids are frequently
+    // sequential, so their low bits alone make poor bucket indexes.
+    uint64_t h = aKey.mResourceId;
+
+    h ^= (static_cast<uint64_t>(aKey.mProfileId) << 16) ^ aKey.mResourceType;
+    h ^= aKey.mInstanceId * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= h >> 33;
+    h *= UINT64_C(0xFF51AFD7ED558CCD);
+    h ^= h >> 33;
+    h *= UINT64_C(0xC4CEB9FE1A85EC53);
+    h ^= h >> 33;
+
+    return static_cast<size_t>(h);
+}
+
 template <typename T>
 GenericTraitCatalogImpl<T>::GenericTraitCatalogImpl(void) : mNodeId(ResourceIdentifier::SELF_NODE_ID)
 {
@@ -77,6 +109,11 @@ WEAVE_ERROR GenericTraitCatalogImpl<T>::Add(const ResourceIdentifier & aResource
     aHandle             = GetNextHandle();
     mItemStore[aHandle] = item;
 
+    // Index the item by path and by instance. If the same instance is added under several paths, the
+    // instance index refers to the first of them.
+    mPathIndex[PathKey(item->mProfileId, item->mInstanceId, item->mResourceId)] = aHandle;
+    mInstanceIndex.insert(std::make_pair(traitInstance, aHandle));
+
 exit:
     if (err != WEAVE_NO_ERROR && item != NULL)
     {
@@ -114,12 +151,36 @@ WEAVE_ERROR GenericTraitCatalogImpl<T>::Remove(TraitDataHandle aHandle)
     // Remove the item and delete it
     item = itemIterator->second;
     mItemStore.erase(itemIterator);
+    RemoveFromIndexes(aHandle, item);
     delete item;
     mRecycledHandles.push(aHandle);
 exit:
     return err;
 }
 
+template <typename T>
+void GenericTraitCatalogImpl<T>::RemoveFromIndexes(TraitDataHandle aHandle, const CatalogItem * aItem)
+{
+    mPathIndex.erase(PathKey(aItem->mProfileId, aItem->mInstanceId, aItem->mResourceId));
+
+    auto instanceIterator = mInstanceIndex.find(aItem->mItem);
+    if (instanceIterator != mInstanceIndex.end() && instanceIterator->second == aHandle)
+    {
+        mInstanceIndex.erase(instanceIterator);
+
+        // Fall back to any other path under which the same instance is still cataloged. This is rare, so
+        // a scan of the store is acceptable here.
+        for (auto itemIterator = mItemStore.begin(); itemIterator != mItemStore.end(); itemIterator++)
+        {
+            if (itemIterator->second->mItem == aItem->mItem)
+            {
+                mInstanceIndex.insert(std::make_pair(aItem->mItem, itemIterator->first));
+                break;
+            }
+        }
+    }
+}
+
 template <typename T>
 TraitDataHandle GenericTraitCatalogImpl<T>::GetNextHandle(void)
 {
@@ -153,6 +214,8 @@ WEAVE_ERROR GenericTraitCatalogImpl<T>::Clear(void)
         delete item;
     }
     mItemStore.clear();
+    mPathIndex.clear();
+    mInstanceIndex.clear();
 
     std::swap(mRecycledHandles, empty);
 
@@ -293,19 +356,14 @@ exit:
 template <typename T>
 WEAVE_ERROR GenericTraitCatalogImpl<T>::Locate(T * aTraitInstance, TraitDataHandle & aHandle) const
 {
-    WEAVE_ERROR err = WEAVE_ERROR_INVALID_ARGUMENT;
-    // Iterate and find this trait instance
-    for (auto itemIterator = mItemStore.begin(); itemIterator != mItemStore.end(); itemIterator++)
-    {
-        CatalogItem * item = itemIterator->second;
-        if (aTraitInstance == item->mItem)
-        {
-            aHandle = itemIterator->first;
-            err     = WEAVE_NO_ERROR;
-            break;
-        }
-    }
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    // Look up this trait instance
+    auto instanceIterator = mInstanceIndex.find(aTraitInstance);
+    VerifyOrExit(instanceIterator != mInstanceIndex.end(), err = WEAVE_ERROR_INVALID_ARGUMENT);
 
+    aHandle = instanceIterator->second;
+
+exit:
     return err;
 }
 
@@ -313,19 +371,14 @@ template <typename T>
 WEAVE_ERROR GenericTraitCatalogImpl<T>::Locate(uint32_t aProfileId, uint64_t aInstanceId, ResourceIdentifier aResourceId,
                                                TraitDataHandle & aHandle) const
 {
-    WEAVE_ERROR err = WEAVE_ERROR_INVALID_PROFILE_ID;
-    // Loop through the items and check if the path matches
-    for (auto itemIterator = mItemStore.begin(); itemIterator != mItemStore.end(); itemIterator++)
-    {
-        CatalogItem * item = itemIterator->second;
-        if (item->mProfileId == aProfileId && item->mResourceId == aResourceId && item->mInstanceId == aInstanceId)
-        {
-            aHandle = itemIterator->first;
-            err     = WEAVE_NO_ERROR;
-            break;
-        }
-    }
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    // Look up the handle for this path
+    auto pathIterator = mPathIndex.find(PathKey(aProfileId, aInstanceId, aResourceId));
+    VerifyOrExit(pathIterator != mPathIndex.end(), err = WEAVE_ERROR_INVALID_PROFILE_ID);
+
+    aHandle = pathIterator->second;
 
+exit:
     return err;
 }
 
@@ -333,19 +386,16 @@ template <typename T>
 WEAVE_ERROR GenericTraitCatalogImpl<T>::Locate(uint32_t aProfileId, uint64_t aInstanceId, ResourceIdentifier aResourceId,
                                                T ** aTraitInstance) const
 {
-    WEAVE_ERROR err = WEAVE_ERROR_INVALID_PROFILE_ID;
-    // Loop through the items and check if the path matches
-    for (auto itemIterator = mItemStore.begin(); itemIterator != mItemStore.end(); itemIterator++)
-    {
-        CatalogItem * item = itemIterator->second;
-        if (item->mProfileId == aProfileId && item->mResourceId == aResourceId && item->mInstanceId == aInstanceId)
-        {
-            *aTraitInstance = itemIterator->second->mItem;
-            err             = WEAVE_NO_ERROR;
-            break;
-        }
-    }
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TraitDataHandle handle;
+
+    // Look up the handle for this path, then the instance it refers to
+    err = Locate(aProfileId, aInstanceId, aResourceId, handle);
+    SuccessOrExit(err);
+
+    err = Locate(handle, aTraitInstance);
 
+exit:
     return err;
 }
 
@@ -106,7 +106,19 @@ void LogBDXUpload::BlockHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransf
             ThrottleIfNeeded();
         }
 
-        err = mLogger->FetchEventsSince(writer, mCurrentImportance, mCurrentEventID);
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+        if (mHasFilter)
+        {
+            EventQuery query = mFilter;
+
+            query.importance = mCurrentImportance;
+            err              = mLogger->FetchMatchingEvents(writer, query, mCurrentEventID);
+        }
+        else
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+        {
+            err = mLogger->FetchEventsSince(writer, mCurrentImportance, mCurrentEventID);
+        }
 
         // Reached the end of the current importance
         if ((err == WEAVE_END_OF_TLV) || (err == WEAVE_ERROR_TLV_UNDERRUN))
@@ -194,7 +206,11 @@ void BdxErrorHandler(nl::Weave::Profiles::BulkDataTransfer::BDXTransfer * aXfer,
     uploader->Abort();
 }
 
-LogBDXUpload::LogBDXUpload() { }
+LogBDXUpload::LogBDXUpload()
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    : mFilter(kImportanceType_First), mHasFilter(false)
+#endif
+{ }
 
 WEAVE_ERROR LogBDXUpload::Init(LoggingManagement * inLogger)
 {
@@ -304,6 +320,28 @@ uint32_t LogBDXUpload::GetUploadPosition(void)
     return mUploadPosition;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+/**
+ * @brief
+ *   Upload only the events that match a query.
+ *
+ * Events of every importance are uploaded as before, but only those of
+ * the filter's profile and time range; the filter's importance is not
+ * used.  The filter applies from the next block of the upload onward.
+ *
+ * @param[in] inFilter The events to upload, or NULL to upload all
+ *                     events.
+ */
+void LogBDXUpload::SetUploadFilter(const EventQuery * inFilter)
+{
+    mHasFilter = (inFilter != NULL);
+    if (mHasFilter)
+    {
+        mFilter = *inFilter;
+    }
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
 } // namespace Profiles
 } // namespace Weave
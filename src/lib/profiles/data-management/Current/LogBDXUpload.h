@@ -68,6 +68,10 @@ public:
 
     uint32_t GetUploadPosition(void);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    void SetUploadFilter(const EventQuery * inFilter);
+#endif
+
     UploaderState mState;
 
 private:
@@ -82,6 +86,10 @@ private:
     uint32_t mUploadPosition;
     bool mThrottled;
     bool mFirstXfer;
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    EventQuery mFilter;
+    bool mHasFilter;
+#endif
 };
 
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
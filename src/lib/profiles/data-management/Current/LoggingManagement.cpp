@@ -34,6 +34,15 @@
 
 #include <SystemLayer/SystemTimer.h>
 
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
 #if HAVE_NEW
 #include <new>
 #else
@@ -67,6 +76,12 @@ namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNames
 
 static LoggingManagement sInstance;
 
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+// The staging rings outlive any one LoggingManagement instance, so that a
+// thread holding a ring is unaffected by the logger being re-created.
+static EventStagingRing sStagingRings[WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
 LoggingManagement & LoggingManagement::GetInstance(void)
 {
     return sInstance;
@@ -76,6 +91,9 @@ struct ReclaimEventCtx
 {
     CircularEventBuffer * mEventBuffer;
     size_t mSpaceNeededForEvent;
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    EventSummaryBlock mEvent; ///< The head event, as found by EvictEvent()
+#endif
 };
 
 WEAVE_ERROR LoggingManagement::AlwaysFail(nl::Weave::TLV::WeaveCircularTLVBuffer & inBuffer, void * inAppData,
@@ -124,6 +142,9 @@ WEAVE_ERROR LoggingManagement::EnsureSpace(size_t inRequiredSpace)
     CircularEventBuffer * eventBuffer = mEventBuffer;
     WeaveCircularTLVBuffer * circularBuffer;
     ReclaimEventCtx ctx;
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    size_t lengthBefore;
+#endif
 
     // check whether we actually need to do anything, exit if we don't
     VerifyOrExit(requiredSpace > eventBuffer->mBuffer.AvailableDataLength(), err = WEAVE_NO_ERROR);
@@ -141,7 +162,26 @@ WEAVE_ERROR LoggingManagement::EnsureSpace(size_t inRequiredSpace)
 
             circularBuffer->mProcessEvictedElement = EvictEvent;
             circularBuffer->mAppData               = &ctx;
-            err                                    = circularBuffer->EvictHead();
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+            lengthBefore = circularBuffer->DataLength();
+#endif
+            err = circularBuffer->EvictHead();
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+            if (err == WEAVE_NO_ERROR)
+            {
+                ctx.mEvent.mNumBytes = lengthBefore - circularBuffer->DataLength();
+                GetEventSummary(eventBuffer).RemoveHead(ctx.mEvent);
+            }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+            // Record the eviction before the freed space is reused
+            if (err == WEAVE_NO_ERROR)
+            {
+                eventBuffer->SyncMappedState();
+            }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
 
             // one of two things happened: either the element was evicted,
             // or we figured out how much space we need to evict it into
@@ -158,18 +198,46 @@ WEAVE_ERROR LoggingManagement::EnsureSpace(size_t inRequiredSpace)
                     // Since we're calling CopyElement and we've checked
                     // that there is space in the next buffer, we don't expect
                     // this to fail.
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+                    lengthBefore = eventBuffer->mNext->mBuffer.DataLength();
+#endif
                     err = CopyToNextBuffer(eventBuffer);
                     SuccessOrExit(err);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+                    ctx.mEvent.mNumBytes      = eventBuffer->mNext->mBuffer.DataLength() - lengthBefore;
+                    ctx.mEvent.mProfileFilter = GetEventSummary(eventBuffer).GetHeadProfileFilter();
+                    AppendEventSummary(eventBuffer->mNext, ctx.mEvent);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+                    // Record the copy before the original is evicted,
+                    // so that a crash in between duplicates the event
+                    // rather than losing it.
+                    eventBuffer->mNext->SyncMappedState();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
                     // success; evict head unconditionally
                     circularBuffer->mProcessEvictedElement = NULL;
-                    err                                    = circularBuffer->EvictHead();
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+                    lengthBefore = circularBuffer->DataLength();
+#endif
+                    err = circularBuffer->EvictHead();
                     // if unconditional eviction failed, this
                     // means that we have no way of further
                     // clearing the buffer.  fail out and let the
                     // caller know that we could not honor the
                     // request
                     SuccessOrExit(err);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+                    ctx.mEvent.mNumBytes = lengthBefore - circularBuffer->DataLength();
+                    GetEventSummary(eventBuffer).RemoveHead(ctx.mEvent);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+                    eventBuffer->SyncMappedState();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
                     continue;
                 }
                 // we cannot copy event outright. We remember the
@@ -300,6 +368,25 @@ WEAVE_ERROR LoggingManagement::BlitEvent(EventLoadOutContext * aContext, const E
         }
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    // Compact header: a single dictionary reference stands in for the
+    // profile ID and event type, which are adjacent only when the event
+    // carries no resource and its schema versions are the defaults.
+    if ((aContext->mHeaderDictionary != NULL) && (inOptions->eventSource == NULL) &&
+        (inSchema.mMinCompatibleDataSchemaVersion == 1) && (inSchema.mDataSchemaVersion == 1))
+    {
+        uint8_t headerIndex;
+
+        if (aContext->mHeaderDictionary->FindOrAdd(inSchema.mProfileId, inSchema.mStructureType, headerIndex))
+        {
+            err = aContext->mWriter.Put(ContextTag(kTag_EventHeaderReference), headerIndex);
+            SuccessOrExit(err);
+
+            ExitNow(err = WriteEventData(aContext, inEventWriter, inAppData, containerType));
+        }
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
     // Event Trait Profile ID
     if (inSchema.mMinCompatibleDataSchemaVersion != 1 || inSchema.mDataSchemaVersion != 1)
     {
@@ -346,22 +433,9 @@ WEAVE_ERROR LoggingManagement::BlitEvent(EventLoadOutContext * aContext, const E
     err = aContext->mWriter.Put(ContextTag(kTag_EventType), inSchema.mStructureType);
     SuccessOrExit(err);
 
-    // Callback to write the EventData
-    err = inEventWriter(aContext->mWriter, kTag_EventData, inAppData);
-    SuccessOrExit(err);
-
-    err = aContext->mWriter.EndContainer(containerType);
-    SuccessOrExit(err);
-
-    err = aContext->mWriter.Finalize();
+    err = WriteEventData(aContext, inEventWriter, inAppData, containerType);
     SuccessOrExit(err);
 
-    // only update mFirst if an event was successfully written.
-    if (aContext->mFirst)
-    {
-        aContext->mFirst = false;
-    }
-
 exit:
     if (err != WEAVE_NO_ERROR)
     {
@@ -386,6 +460,34 @@ exit:
     return err;
 }
 
+// Internal helper for BlitEvent: write the event data and close out the
+// event structure opened by the caller.
+
+WEAVE_ERROR LoggingManagement::WriteEventData(EventLoadOutContext * aContext, EventWriterFunct inEventWriter, void * inAppData,
+                                              TLVType inContainerType)
+{
+    WEAVE_ERROR err;
+
+    // Callback to write the EventData
+    err = inEventWriter(aContext->mWriter, kTag_EventData, inAppData);
+    SuccessOrExit(err);
+
+    err = aContext->mWriter.EndContainer(inContainerType);
+    SuccessOrExit(err);
+
+    err = aContext->mWriter.Finalize();
+    SuccessOrExit(err);
+
+    // only update mFirst if an event was successfully written.
+    if (aContext->mFirst)
+    {
+        aContext->mFirst = false;
+    }
+
+exit:
+    return err;
+}
+
 /**
  * @brief Helper function to skip writing an event corresponding to an allocated
  *   event id.
@@ -451,6 +553,10 @@ WEAVE_ERROR LoggingManagement::SerializeEvents(TLVWriter & writer)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
 
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    MergeStagedEvents();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
     Platform::CriticalSectionEnter();
 
     CircularEventBuffer * eventBuffer = mEventBuffer;
@@ -467,6 +573,16 @@ WEAVE_ERROR LoggingManagement::SerializeEvents(TLVWriter & writer)
         eventBuffer = eventBuffer->mNext;
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    // Events in the compact encoding refer to the header dictionary, so it
+    // is persisted alongside them.
+    if (mCompactEncoding)
+    {
+        err = SerializeHeaderDictionary(writer);
+        SuccessOrExit(err);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
     err = writer.EndContainer(container);
     SuccessOrExit(err);
 
@@ -502,17 +618,260 @@ WEAVE_ERROR LoggingManagement::LoadEvents(TLVReader & reader)
         eventBuffer = eventBuffer->mNext;
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    // The loaded events may reuse the IDs of cached ones.
+    mBatchCache.Clear();
+#endif
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    mHeaderDictionary.Clear();
+    mCompactEncoding = false;
+
+    err = reader.Next();
+    if (err == WEAVE_NO_ERROR)
+    {
+        err = LoadHeaderDictionary(reader);
+        SuccessOrExit(err);
+
+        mCompactEncoding = true;
+    }
+    else if (err == WEAVE_END_OF_TLV)
+    {
+        err = WEAVE_NO_ERROR;
+    }
+    SuccessOrExit(err);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+    err = reader.VerifyEndOfContainer();
+    SuccessOrExit(err);
+    err = reader.ExitContainer(container);
+    SuccessOrExit(err);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    for (eventBuffer = mEventBuffer; eventBuffer != NULL; eventBuffer = eventBuffer->mNext)
+    {
+        SummarizeEvents(eventBuffer);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    SyncMappedBuffers();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
+exit:
+    Platform::CriticalSectionExit();
+
+    return err;
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+WEAVE_ERROR LoggingManagement::SerializeHeaderDictionary(TLVWriter & writer)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVType container;
+    TLVType array;
+
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, container);
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(kTag_PersistEvent_HeaderProfileIds), kTLVType_Array, array);
+    SuccessOrExit(err);
+
+    for (uint16_t i = 0; i < mHeaderDictionary.mNumEntries; i++)
+    {
+        err = writer.Put(AnonymousTag, mHeaderDictionary.mProfileIds[i]);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(array);
+    SuccessOrExit(err);
+
+    err = writer.StartContainer(ContextTag(kTag_PersistEvent_HeaderEventTypes), kTLVType_Array, array);
+    SuccessOrExit(err);
+
+    for (uint16_t i = 0; i < mHeaderDictionary.mNumEntries; i++)
+    {
+        err = writer.Put(AnonymousTag, mHeaderDictionary.mStructureTypes[i]);
+        SuccessOrExit(err);
+    }
+
+    err = writer.EndContainer(array);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(container);
+    SuccessOrExit(err);
+
+exit:
+    return err;
+}
+
+WEAVE_ERROR LoggingManagement::LoadHeaderDictionary(TLVReader & reader)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVType container;
+    TLVType array;
+    uint16_t numEntries = 0;
+
+    VerifyOrExit(reader.GetType() == kTLVType_Structure, err = WEAVE_ERROR_WRONG_TLV_TYPE);
+
+    err = reader.EnterContainer(container);
+    SuccessOrExit(err);
+
+    err = reader.Next(kTLVType_Array, ContextTag(kTag_PersistEvent_HeaderProfileIds));
+    SuccessOrExit(err);
+
+    err = reader.EnterContainer(array);
+    SuccessOrExit(err);
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        VerifyOrExit(numEntries < WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE, err = WEAVE_ERROR_BUFFER_TOO_SMALL);
+
+        err = reader.Get(mHeaderDictionary.mProfileIds[numEntries]);
+        SuccessOrExit(err);
+
+        numEntries++;
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, /* no-op */);
+
+    err = reader.ExitContainer(array);
+    SuccessOrExit(err);
+
+    err = reader.Next(kTLVType_Array, ContextTag(kTag_PersistEvent_HeaderEventTypes));
+    SuccessOrExit(err);
+
+    err = reader.EnterContainer(array);
+    SuccessOrExit(err);
+
+    for (uint16_t i = 0; i < numEntries; i++)
+    {
+        err = reader.Next();
+        SuccessOrExit(err);
+
+        err = reader.Get(mHeaderDictionary.mStructureTypes[i]);
+        SuccessOrExit(err);
+    }
+
     err = reader.VerifyEndOfContainer();
     SuccessOrExit(err);
+
+    err = reader.ExitContainer(array);
+    SuccessOrExit(err);
+
     err = reader.ExitContainer(container);
     SuccessOrExit(err);
 
+    mHeaderDictionary.mNumEntries = numEntries;
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        mHeaderDictionary.Clear();
+    }
+    return err;
+}
+
+/**
+ * @brief
+ *   Enable or disable the compact encoding of event headers.
+ *
+ * With the compact encoding enabled, the profile ID and event type of
+ * each event logged without an event source and with the default
+ * schema versions are replaced in the event buffers by a one-byte
+ * reference into a dictionary of recurring headers.  The encoding is
+ * internal to the buffers: events are expanded back to the standard
+ * encoding by FetchEventsSince(), so readers of the fetched events
+ * see no difference.
+ *
+ * Because buffered events depend on the dictionary, the encoding may
+ * only be changed while the event buffers are empty.
+ *
+ * @param[in] inEnable   true to store new events compactly, false to
+ *                       store them in the standard encoding.
+ *
+ * @retval WEAVE_ERROR_INCORRECT_STATE  Events are already buffered.
+ * @retval WEAVE_ERROR_NOT_IMPLEMENTED  An event buffer is memory-mapped.
+ * @retval WEAVE_NO_ERROR               On success.
+ */
+WEAVE_ERROR LoggingManagement::SetCompactEncoding(bool inEnable)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    Platform::CriticalSectionEnter();
+
+    for (CircularEventBuffer * eventBuffer = mEventBuffer; eventBuffer != NULL; eventBuffer = eventBuffer->mNext)
+    {
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        // The dictionary is not kept in the mapped files, so events
+        // recovered from them could not be expanded.
+        VerifyOrExit(eventBuffer->mMappedState == NULL, err = WEAVE_ERROR_NOT_IMPLEMENTED);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        VerifyOrExit(eventBuffer->mBuffer.DataLength() == 0, err = WEAVE_ERROR_INCORRECT_STATE);
+    }
+
+    mHeaderDictionary.Clear();
+    mCompactEncoding = inEnable;
+
 exit:
     Platform::CriticalSectionExit();
 
     return err;
 }
 
+void EventHeaderDictionary::Clear(void)
+{
+    mNumEntries = 0;
+}
+
+/**
+ * @brief
+ *   Find the dictionary entry for an event header, adding one if needed.
+ *
+ * @return false if the header is not in the dictionary and the
+ *         dictionary is full, true otherwise.
+ */
+bool EventHeaderDictionary::FindOrAdd(uint32_t inProfileId, uint32_t inStructureType, uint8_t & outIndex)
+{
+    uint16_t i;
+
+    for (i = 0; i < mNumEntries; i++)
+    {
+        if (mProfileIds[i] == inProfileId && mStructureTypes[i] == inStructureType)
+        {
+            outIndex = static_cast<uint8_t>(i);
+            return true;
+        }
+    }
+
+    if (mNumEntries == WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE)
+    {
+        return false;
+    }
+
+    mProfileIds[mNumEntries]     = inProfileId;
+    mStructureTypes[mNumEntries] = inStructureType;
+    outIndex                     = static_cast<uint8_t>(mNumEntries);
+    mNumEntries++;
+
+    return true;
+}
+
+bool EventHeaderDictionary::Get(uint8_t inIndex, uint32_t & outProfileId, uint32_t & outStructureType) const
+{
+    if (inIndex >= mNumEntries)
+    {
+        return false;
+    }
+
+    outProfileId     = mProfileIds[inIndex];
+    outStructureType = mStructureTypes[inIndex];
+
+    return true;
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
 /**
  * @brief Set mShutdownInProgress flag to true.
  */
@@ -576,6 +935,10 @@ LoggingManagement::LoggingManagement(nl::Weave::WeaveExchangeManager * inMgr,
     CircularEventBuffer * prev    = NULL;
     CircularEventBuffer * next    = NULL;
     size_t i, j;
+    size_t reserved;
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    bool recovered = false;
+#endif
 
     VerifyOrDie(inNumBuffers > 0);
 
@@ -588,11 +951,19 @@ LoggingManagement::LoggingManagement(nl::Weave::WeaveExchangeManager * inMgr,
 
         next = (i > 0) ? static_cast<CircularEventBuffer *>(inLogStorageResources[i - 1].mBuffer) : NULL;
 
-        VerifyOrDie(inLogStorageResources[i].mBufferSize > sizeof(CircularEventBuffer));
+        reserved = sizeof(CircularEventBuffer);
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        if (inLogStorageResources[i].mIsMapped)
+        {
+            reserved += 2 * sizeof(MappedEventBufferState);
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
+        VerifyOrDie(inLogStorageResources[i].mBufferSize > reserved);
 
         new (inLogStorageResources[i].mBuffer)
-            CircularEventBuffer(static_cast<uint8_t *>(inLogStorageResources[i].mBuffer) + sizeof(CircularEventBuffer),
-                                inLogStorageResources[i].mBufferSize - sizeof(CircularEventBuffer), prev, next);
+            CircularEventBuffer(static_cast<uint8_t *>(inLogStorageResources[i].mBuffer) + reserved,
+                                inLogStorageResources[i].mBufferSize - reserved, prev, next);
 
         current = prev                          = static_cast<CircularEventBuffer *>(inLogStorageResources[i].mBuffer);
         current->mBuffer.mProcessEvictedElement = AlwaysFail;
@@ -621,6 +992,19 @@ LoggingManagement::LoggingManagement(nl::Weave::WeaveExchangeManager * inMgr,
         }
 
         current->mFirstEventID = current->mEventIdCounter->GetValue();
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        if (inLogStorageResources[i].mIsMapped)
+        {
+            MappedEventBufferState * state = reinterpret_cast<MappedEventBufferState *>(
+                static_cast<uint8_t *>(inLogStorageResources[i].mBuffer) + sizeof(CircularEventBuffer));
+
+            if (current->RecoverMappedState(state))
+            {
+                recovered = true;
+            }
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
     }
     mEventBuffer = static_cast<CircularEventBuffer *>(inLogStorageResources[kImportanceType_Last - kImportanceType_First].mBuffer);
 
@@ -629,6 +1013,42 @@ LoggingManagement::LoggingManagement(nl::Weave::WeaveExchangeManager * inMgr,
     mBytesWritten        = 0;
     mUploadRequested     = false;
     mMaxImportanceBuffer = kImportanceType_Last;
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    mMergeRequested = false;
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    mCompactEncoding = false;
+    mHeaderDictionary.Clear();
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    mBatchCache.Clear();
+    ResetBatchCacheStats();
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    for (i = 0; i <= kImportanceType_Last - kImportanceType_First; i++)
+    {
+        mEventSummaries[i].Clear();
+    }
+    ResetQueryStats();
+#endif
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    if (recovered)
+    {
+        // Recovered events count toward the next upload.
+        for (current = mEventBuffer; current != NULL; current = current->mNext)
+        {
+            mBytesWritten += current->mBuffer.DataLength();
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+            SummarizeEvents(current);
+#endif
+        }
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+        ReleaseRecoveredExternalEvents();
+#endif
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
 }
 
 /**
@@ -641,7 +1061,28 @@ LoggingManagement::LoggingManagement(nl::Weave::WeaveExchangeManager * inMgr,
 LoggingManagement::LoggingManagement(void) :
     mEventBuffer(NULL), mExchangeMgr(NULL), mState(kLoggingManagementState_Idle), mBDXUploader(NULL), mBytesWritten(0),
     mThrottled(0), mMaxImportanceBuffer(kImportanceType_Invalid), mUploadRequested(false)
-{ }
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    , mMergeRequested(false)
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    , mCompactEncoding(false)
+#endif
+{
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    mHeaderDictionary.Clear();
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    mBatchCache.Clear();
+    ResetBatchCacheStats();
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    for (size_t i = 0; i <= kImportanceType_Last - kImportanceType_First; i++)
+    {
+        mEventSummaries[i].Clear();
+    }
+    ResetQueryStats();
+#endif
+}
 
 /**
  * @brief
@@ -949,9 +1390,25 @@ WEAVE_ERROR LoggingManagement::RegisterEventCallbackForImportance(ImportanceType
     // can't quite use the BlitEvent method, use the specially created one
 
     err = BlitExternalEvent(writer, inImportance, ev);
+    SuccessOrExit(err);
 
     mBytesWritten += writer.GetLengthWritten();
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    {
+        EventEnvelopeContext envelope;
+        EventSummaryBlock event;
+
+        envelope.mNumFieldsToRead = 0;
+        envelope.mImportance      = inImportance;
+        envelope.mExternalEvents  = &ev;
+
+        event.Init(envelope);
+        event.mNumBytes = writer.GetLengthWritten();
+        AppendEventSummary(mEventBuffer, event);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 exit:
 
     if (err != WEAVE_NO_ERROR)
@@ -960,6 +1417,10 @@ exit:
     }
     else
     {
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        SyncMappedBuffers();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
         if (outLastEventID != NULL)
         {
             *outLastEventID = ev.mLastEventID;
@@ -1118,9 +1579,28 @@ WEAVE_ERROR LoggingManagement::CopyAndAdjustDeltaTime(const TLVReader & aReader,
         }
     }
 #endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
-    else
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    else if (aReader.GetTag() == ContextTag(kTag_EventHeaderReference))
     {
-        err = ctx->mWriter->CopyElement(reader);
+        // Expand the compact header back to the standard encoding
+        uint8_t headerIndex;
+        uint32_t profileId;
+        uint32_t structureType;
+
+        err = reader.Get(headerIndex);
+        SuccessOrExit(err);
+
+        VerifyOrExit(sInstance.mHeaderDictionary.Get(headerIndex, profileId, structureType), err = WEAVE_ERROR_INVALID_TLV_ELEMENT);
+
+        err = ctx->mWriter->Put(ContextTag(kTag_EventTraitProfileID), profileId);
+        SuccessOrExit(err);
+
+        err = ctx->mWriter->Put(ContextTag(kTag_EventType), structureType);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    else
+    {
+        err = ctx->mWriter->CopyElement(reader);
     }
 
     // First event in the sequence gets a eventID neatly packaged
@@ -1133,6 +1613,9 @@ WEAVE_ERROR LoggingManagement::CopyAndAdjustDeltaTime(const TLVReader & aReader,
         }
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+exit:
+#endif
     return err;
 }
 
@@ -1270,6 +1753,13 @@ inline event_id_t LoggingManagement::LogEventPrivate(const EventSchema & inSchem
         opts.relatedImportance = inOptions->relatedImportance;
     }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    if (mCompactEncoding)
+    {
+        ctxt.mHeaderDictionary = &mHeaderDictionary;
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
     ctxt.mFirst          = false;
     ctxt.mCurrentEventID = GetImportanceBuffer(inSchema.mImportance)->mLastEventID;
     ctxt.mCurrentTime    = GetImportanceBuffer(inSchema.mImportance)->mLastEventTimestamp;
@@ -1339,6 +1829,31 @@ exit:
     }
     else if (inSchema.mImportance <= GetCurrentImportance(inSchema.mProfileId))
     {
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+        {
+            EventEnvelopeContext envelope;
+            EventSummaryBlock event;
+
+            envelope.mNumFieldsToRead = 0;
+            envelope.mImportance      = inSchema.mImportance;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+            if (opts.timestampType == kTimestampType_UTC)
+            {
+                envelope.mDeltaUtc = opts.timestamp.utcTimestamp - GetImportanceBuffer(inSchema.mImportance)->mLastEventUTCTimestamp;
+            }
+            else
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+            {
+                envelope.mDeltaTime = opts.timestamp.systemTimestamp - GetImportanceBuffer(inSchema.mImportance)->mLastEventTimestamp;
+            }
+
+            event.Init(envelope);
+            event.mNumBytes      = writer.GetLengthWritten();
+            event.mProfileFilter = EventSummaryBlock::GetProfileFilterBit(inSchema.mProfileId);
+            AppendEventSummary(mEventBuffer, event);
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
         event_id = GetImportanceBuffer(inSchema.mImportance)->VendEventID();
 
 #if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
@@ -1364,12 +1879,347 @@ exit:
 #endif // WEAVE_CONFIG_EVENT_LOGGING_VERBOSE_DEBUG_LOGS
         }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+        SyncMappedBuffers();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
         ScheduleFlushIfNeeded(inOptions == NULL ? false : inOptions->urgent);
     }
 
     return event_id;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
+/**
+ * @brief
+ *   Get the entry the producer may fill in next.
+ *
+ * @return A pointer to the entry, or NULL if the ring is full.
+ */
+EventStagingRing::Entry * EventStagingRing::GetProducerEntry(void)
+{
+    uint32_t head = mHead;
+
+    if ((head - mTail) >= WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES)
+        return NULL;
+
+    // Make sure the consumer is done with the entry before reusing it.
+    __sync_synchronize();
+
+    return &mEntries[head % WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES];
+}
+
+/**
+ * @brief
+ *   Publish the entry returned by GetProducerEntry() to the consumer.
+ */
+void EventStagingRing::CommitProducerEntry(void)
+{
+    // The entry contents must be visible before the new head.
+    __sync_synchronize();
+    mHead = mHead + 1;
+}
+
+/**
+ * @brief
+ *   Get the oldest staged entry.
+ *
+ * @return A pointer to the entry, or NULL if the ring is empty.
+ */
+EventStagingRing::Entry * EventStagingRing::GetConsumerEntry(void)
+{
+    uint32_t tail = mTail;
+
+    if (tail == mHead)
+        return NULL;
+
+    // Don't read the entry contents ahead of the head that published them.
+    __sync_synchronize();
+
+    return &mEntries[tail % WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES];
+}
+
+/**
+ * @brief
+ *   Return the entry returned by GetConsumerEntry() to the producer.
+ */
+void EventStagingRing::CommitConsumerEntry(void)
+{
+    __sync_synchronize();
+    mTail = mTail + 1;
+}
+
+/**
+ * @brief
+ *   Claim a staging ring for the calling thread.
+ *
+ * The ring may only be used by the thread that acquired it, until that
+ * thread passes it to ReleaseStagingRing().  This function may be called
+ * from any thread.
+ *
+ * @return A pointer to the ring, or NULL if all rings are in use, in which
+ *         case the thread should log events with LogEvent().
+ */
+EventStagingRing * LoggingManagement::AcquireStagingRing(void)
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS; i++)
+    {
+        if (__sync_bool_compare_and_swap(&sStagingRings[i].mInUse, false, true))
+        {
+            return &sStagingRings[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief
+ *   Merge any events still staged in a ring, and return the ring to the
+ *   pool.
+ *
+ * @param[in] inRing  A ring returned by AcquireStagingRing().
+ */
+void LoggingManagement::ReleaseStagingRing(EventStagingRing * inRing)
+{
+    VerifyOrExit(inRing != NULL, /* no-op */);
+
+    Platform::CriticalSectionEnter();
+
+    if (mState != kLoggingManagementState_Shutdown)
+    {
+        MergeStagedEventsPrivate(inRing);
+    }
+
+    // Anything left could not be merged; drop it rather than hand it to
+    // the next owner.
+    inRing->mTail  = inRing->mHead;
+    inRing->mInUse = false;
+
+    Platform::CriticalSectionExit();
+
+exit:
+    return;
+}
+
+/**
+ * @brief
+ *   Log an event through a staging ring.
+ *
+ * The event data is encoded into the ring without taking the event logging
+ * critical section.  The event is assigned its event ID, and its timestamp
+ * is delta-encoded, when the Weave thread merges it into the event buffers,
+ * which this function schedules.  Options are captured at the time of the
+ * call; if no timestamp is supplied, the current system time is recorded.
+ *
+ * Only when the ring is full does the calling thread take the critical
+ * section, to merge the staged events itself.
+ *
+ * @param[in] inRing         The calling thread's staging ring.
+ * @param[in] inSchema       Schema defining importance, profile ID, and
+ *                           structure type of this event.
+ * @param[in] inEventWriter  The callback to invoke to serialize the event
+ *                           data.
+ * @param[in] inAppData      Application context for the callback.
+ * @param[in] inOptions      The options for the event metadata. May be NULL.
+ *
+ * @retval #WEAVE_NO_ERROR                   The event was staged, or was
+ *                                           discarded by the importance
+ *                                           filter.
+ * @retval #WEAVE_ERROR_INCORRECT_STATE      The logger is shut down.
+ * @retval #WEAVE_ERROR_NO_MEMORY            The ring remained full.
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL     The event data exceeds
+ *                                           #WEAVE_CONFIG_EVENT_LOGGING_STAGING_MAX_EVENT_SIZE.
+ * @retval other                             An error returned by inEventWriter.
+ */
+WEAVE_ERROR LoggingManagement::StageEvent(EventStagingRing * inRing, const EventSchema & inSchema, EventWriterFunct inEventWriter,
+                                          void * inAppData, const EventOptions * inOptions)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    EventStagingRing::Entry * entry;
+    TLVWriter writer;
+    TLVType containerType;
+
+    VerifyOrExit(inRing != NULL, err = WEAVE_ERROR_INVALID_ARGUMENT);
+    VerifyOrExit(mState != kLoggingManagementState_Shutdown, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    // Discard early what the merge would discard anyway.
+    VerifyOrExit(inSchema.mImportance <= GetCurrentImportance(inSchema.mProfileId), /* no-op */);
+
+    entry = inRing->GetProducerEntry();
+    if (entry == NULL)
+    {
+        MergeStagedEvents();
+        entry = inRing->GetProducerEntry();
+        VerifyOrExit(entry != NULL, err = WEAVE_ERROR_NO_MEMORY);
+    }
+
+    writer.Init(entry->mData, sizeof(entry->mData));
+
+    // The event writer emits a context-tagged element, which is only valid within a structure.
+    err = writer.StartContainer(AnonymousTag, kTLVType_Structure, containerType);
+    SuccessOrExit(err);
+
+    err = inEventWriter(writer, kTag_EventData, inAppData);
+    SuccessOrExit(err);
+
+    err = writer.EndContainer(containerType);
+    SuccessOrExit(err);
+
+    err = writer.Finalize();
+    SuccessOrExit(err);
+
+    entry->mSchema  = inSchema;
+    entry->mDataLen = static_cast<uint16_t>(writer.GetLengthWritten());
+
+    if ((inOptions != NULL) && (inOptions->timestampType != kTimestampType_Invalid))
+    {
+        entry->mTimestamp     = inOptions->timestamp;
+        entry->mTimestampType = inOptions->timestampType;
+    }
+    else
+    {
+        entry->mTimestamp.systemTimestamp = static_cast<timestamp_t>(System::Timer::GetCurrentEpoch());
+        entry->mTimestampType             = kTimestampType_System;
+    }
+
+    entry->mHasEventSource    = (inOptions != NULL) && (inOptions->eventSource != NULL);
+    entry->mRelatedEventID    = (inOptions != NULL) ? inOptions->relatedEventID : 0;
+    entry->mRelatedImportance = (inOptions != NULL) ? inOptions->relatedImportance : kImportanceType_Invalid;
+    entry->mUrgent            = (inOptions != NULL) && inOptions->urgent;
+    if (entry->mHasEventSource)
+    {
+        entry->mEventSource = *inOptions->eventSource;
+    }
+
+    inRing->CommitProducerEntry();
+
+    if (__sync_bool_compare_and_swap(&mMergeRequested, false, true))
+    {
+        System::Error mergeErr = WEAVE_SYSTEM_ERROR_NOT_SUPPORTED;
+
+        if ((mExchangeMgr != NULL) && (mExchangeMgr->MessageLayer != NULL) && (mExchangeMgr->MessageLayer->SystemLayer != NULL))
+        {
+            mergeErr = mExchangeMgr->MessageLayer->SystemLayer->ScheduleWork(LoggingMergeHandler, this);
+        }
+
+        if (mergeErr != WEAVE_SYSTEM_NO_ERROR)
+        {
+            // Nothing will run the merge, so let the next staged event request it again. Until then, the next fetch merges.
+            mMergeRequested = false;
+        }
+    }
+
+exit:
+    if (err != WEAVE_NO_ERROR)
+    {
+        WeaveLogError(EventLogging, "Failed to stage event for profile id: 0x%x (err: %d)", inSchema.mProfileId, err);
+    }
+    return err;
+}
+
+/**
+ * @brief
+ *   Merge the events staged in all rings into the event buffers, assigning
+ *   their event IDs.
+ *
+ * Events from the same ring are merged in the order they were staged.
+ * This function may be called from any thread.
+ *
+ * @return The number of events merged.
+ */
+size_t LoggingManagement::MergeStagedEvents(void)
+{
+    size_t numMerged = 0;
+
+    Platform::CriticalSectionEnter();
+
+    VerifyOrExit(mState != kLoggingManagementState_Shutdown, /* no-op */);
+
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_STAGING_NUM_RINGS; i++)
+    {
+        if (sStagingRings[i].mInUse)
+        {
+            numMerged += MergeStagedEventsPrivate(&sStagingRings[i]);
+        }
+    }
+
+exit:
+    Platform::CriticalSectionExit();
+    return numMerged;
+}
+
+// Note: the function below must be called with the critical section
+// locked, and only when the logger is not shutting down
+
+size_t LoggingManagement::MergeStagedEventsPrivate(EventStagingRing * inRing)
+{
+    EventStagingRing::Entry * entry;
+    size_t numMerged = 0;
+
+    while ((entry = inRing->GetConsumerEntry()) != NULL)
+    {
+        EventOptions opts;
+        TLVReader reader;
+
+        opts.timestamp         = entry->mTimestamp;
+        opts.timestampType     = entry->mTimestampType;
+        opts.eventSource       = entry->mHasEventSource ? &entry->mEventSource : NULL;
+        opts.relatedEventID    = entry->mRelatedEventID;
+        opts.relatedImportance = entry->mRelatedImportance;
+        opts.urgent            = entry->mUrgent;
+
+        reader.Init(entry->mData, entry->mDataLen);
+
+        if (LogEventPrivate(entry->mSchema, StagedEventWriter, &reader, &opts) != 0)
+        {
+            numMerged++;
+        }
+
+        inRing->CommitConsumerEntry();
+    }
+
+    return numMerged;
+}
+
+WEAVE_ERROR LoggingManagement::StagedEventWriter(TLVWriter & ioWriter, uint8_t inDataTag, void * appData)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    // Read from a copy, since the writer is called again if the event has to be retried with more space.
+    TLVReader reader = *static_cast<TLVReader *>(appData);
+    TLVType containerType;
+
+    // Step into the structure StageEvent() wrapped the event data in.
+    err = reader.Next();
+    SuccessOrExit(err);
+
+    err = reader.EnterContainer(containerType);
+    SuccessOrExit(err);
+
+    err = reader.Next();
+    SuccessOrExit(err);
+
+    err = ioWriter.CopyElement(ContextTag(inDataTag), reader);
+
+exit:
+    return err;
+}
+
+void LoggingManagement::LoggingMergeHandler(System::Layer * systemLayer, void * appState, INET_ERROR err)
+{
+    LoggingManagement * logger = static_cast<LoggingManagement *>(appState);
+
+    // Clear the request first, so that events staged during the merge
+    // schedule another one.
+    logger->mMergeRequested = false;
+    __sync_synchronize();
+
+    logger->MergeStagedEvents();
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
 /**
  * @brief
  *   ThrottleLogger elevates the effective logging level to the Production level.
@@ -1533,118 +2383,1011 @@ exit:
  */
 WEAVE_ERROR LoggingManagement::CopyEventsSince(const TLVReader & aReader, size_t aDepth, void * aContext)
 {
-    WEAVE_ERROR err = WEAVE_NO_ERROR;
-    nl::Weave::TLV::TLVWriter checkpoint;
-    EventLoadOutContext * loadOutContext = static_cast<EventLoadOutContext *>(aContext);
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    nl::Weave::TLV::TLVWriter checkpoint;
+    EventLoadOutContext * loadOutContext = static_cast<EventLoadOutContext *>(aContext);
+
+    err = EventIterator(aReader, aDepth, aContext);
+    if (err == WEAVE_EVENT_ID_FOUND)
+    {
+        // checkpoint the writer
+        checkpoint = loadOutContext->mWriter;
+
+        err = CopyEvent(aReader, loadOutContext->mWriter, loadOutContext);
+
+        // WEAVE_NO_ERROR and WEAVE_END_OF_TLV signify a
+        // successful copy.  In all other cases, roll back the
+        // writer state back to the checkpoint, i.e., the state
+        // before we began the copy operation.
+        VerifyOrExit((err == WEAVE_NO_ERROR) || (err == WEAVE_END_OF_TLV), loadOutContext->mWriter = checkpoint);
+
+        loadOutContext->mCurrentTime = 0;
+        loadOutContext->mFirst       = false;
+        loadOutContext->mCurrentEventID++;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   A function to retrieve events of specified importance since a specified event ID.
+ *
+ * Given a nl::Weave::TLV::TLVWriter, an importance type, and an event ID, the
+ * function will fetch events of specified importance since the
+ * specified event.  The function will continue fetching events until
+ * it runs out of space in the nl::Weave::TLV::TLVWriter or in the log. The function
+ * will terminate the event writing on event boundary.
+ *
+ * @param[in] ioWriter     The writer to use for event storage
+ *
+ * @param[in] inImportance The importance of events to be fetched
+ *
+ * @param[inout] ioEventID On input, the ID of the event immediately
+ *                         prior to the one we're fetching.  On
+ *                         completion, the ID of the last event
+ *                         fetched.
+ *
+ * @retval #WEAVE_END_OF_TLV             The function has reached the end of the
+ *                                       available log entries at the specified
+ *                                       importance level
+ *
+ * @retval #WEAVE_ERROR_NO_MEMORY        The function ran out of space in the
+ *                                       ioWriter, more events in the log are
+ *                                       available.
+ *
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL The function ran out of space in the
+ *                                       ioWriter, more events in the log are
+ *                                       available.
+ *
+ * @note With #WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE enabled, the events
+ *       are copied from encodings shared with other callers fetching
+ *       from the same event, and each cached batch of events starts
+ *       with a full event ID and timestamp.
+ */
+WEAVE_ERROR LoggingManagement::FetchEventsSince(TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    // Bring in anything staged so far so that it is offloaded together
+    // with the events already in the buffers.
+    MergeStagedEvents();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
+    Platform::CriticalSectionEnter();
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    err = FetchCachedEventsSince(ioWriter, inImportance, ioEventID);
+#else
+    err = FetchEventsFromBuffers(ioWriter, inImportance, ioEventID, NULL);
+#endif
+
+    Platform::CriticalSectionExit();
+
+    return err;
+}
+
+/**
+ * @brief
+ *   Internal API used to implement #FetchEventsSince
+ *
+ * Reads the events of the specified importance out of the event buffers
+ * and encodes them into the writer.  Must be called with the critical
+ * section held.
+ *
+ * @param[out] outStoppedAtExternalEvents If NULL, externally stored
+ *                         events are fetched through their callback.
+ *                         Otherwise, the fetch ends before the first
+ *                         externally stored event that would need the
+ *                         callback, and the flag is set if it did so.
+ */
+WEAVE_ERROR LoggingManagement::FetchEventsFromBuffers(TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID,
+                                                      bool * outStoppedAtExternalEvents)
+{
+    WEAVE_ERROR err    = WEAVE_NO_ERROR;
+    const bool recurse = false;
+    TLVReader reader;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    ExternalEvents ev;
+    EventLoadOutContext aContext(ioWriter, inImportance, ioEventID, &ev);
+#else
+    EventLoadOutContext aContext(ioWriter, inImportance, ioEventID, NULL);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+    CircularEventBuffer * buf = GetImportanceBuffer(inImportance);
+
+    if (outStoppedAtExternalEvents != NULL)
+    {
+        *outStoppedAtExternalEvents = false;
+    }
+
+    aContext.mCurrentTime = buf->mFirstEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    aContext.mCurrentUTCTime = buf->mFirstEventUTCTimestamp;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    aContext.mCurrentEventID = buf->mFirstEventID;
+    err                      = GetEventReader(reader, inImportance);
+    SuccessOrExit(err);
+
+    err = nl::Weave::TLV::Utilities::Iterate(reader, CopyEventsSince, &aContext, recurse);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    if ((err == WEAVE_END_OF_TLV) && (ev.IsValid()))
+    {
+        if (ev.mFetchEventsFunct != NULL)
+        {
+            if (outStoppedAtExternalEvents != NULL)
+            {
+                *outStoppedAtExternalEvents = true;
+                ExitNow();
+            }
+
+            err = ev.mFetchEventsFunct(&aContext);
+        }
+        else
+        {
+            aContext.mCurrentEventID = ev.mLastEventID + 1;
+            err                      = WEAVE_END_OF_TLV;
+        }
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+exit:
+    ioEventID = aContext.mCurrentEventID;
+
+    return err;
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+/**
+ * @brief
+ *   Internal API used to implement #FetchEventsSince
+ *
+ * Copies events to the writer out of the batches in the event batch
+ * cache, encoding a batch first if no cached batch starts at the
+ * requested event.  A fetch that runs past the end of a batch carries
+ * on with the batch that starts where it ended, and a batch that held
+ * every event in the log when it was encoded is encoded again once
+ * newer events are logged.  Events that cannot be cached are fetched
+ * from the buffers as before.  Must be called with the critical section
+ * held.
+ */
+WEAVE_ERROR LoggingManagement::FetchCachedEventsSince(TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID)
+{
+    WEAVE_ERROR err           = WEAVE_NO_ERROR;
+    CircularEventBuffer * buf = GetImportanceBuffer(inImportance);
+    EventBatch * batch;
+    event_id_t startEventID;
+
+    // Events before the oldest one buffered have been evicted; the
+    // fetch starts with the oldest one, just as it would without the
+    // cache.
+    if (ioEventID < buf->mFirstEventID)
+    {
+        ioEventID = buf->mFirstEventID;
+    }
+
+    while (ioEventID <= buf->mLastEventID)
+    {
+        batch = mBatchCache.Find(inImportance, ioEventID);
+
+        if ((batch != NULL) && !(batch->mReachedEnd && (batch->GetNextEventID() <= buf->mLastEventID)))
+        {
+            mBatchCache.mStats.Hits++;
+        }
+        else
+        {
+            if (batch == NULL)
+            {
+                batch = mBatchCache.Allocate();
+            }
+
+            err = EncodeEventBatch(*batch, inImportance, ioEventID);
+            if (err == WEAVE_END_OF_TLV)
+            {
+                ExitNow();
+            }
+            else if (err != WEAVE_NO_ERROR)
+            {
+                mBatchCache.mStats.Uncacheable++;
+                ExitNow(err = FetchEventsFromBuffers(ioWriter, inImportance, ioEventID, NULL));
+            }
+
+            mBatchCache.mStats.Misses++;
+        }
+
+        mBatchCache.Touch(*batch);
+
+        startEventID = ioEventID;
+        err          = CopyEventBatch(ioWriter, *batch, ioEventID);
+        mBatchCache.mStats.EventsServed += ioEventID - startEventID;
+        SuccessOrExit(err);
+    }
+
+    err = WEAVE_END_OF_TLV;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Encode the events of an importance starting at an event into a batch.
+ *
+ * @retval #WEAVE_NO_ERROR    The batch holds one or more events.
+ * @retval #WEAVE_END_OF_TLV  There are no events to encode.
+ * @retval other              The events cannot be cached, e.g. because
+ *                            they are stored externally or the first
+ *                            one is larger than the batch; the batch
+ *                            is left unused.
+ */
+WEAVE_ERROR LoggingManagement::EncodeEventBatch(EventBatch & ioBatch, ImportanceType inImportance, event_id_t inFirstEventID)
+{
+    WEAVE_ERROR err;
+    TLVWriter writer;
+    TLVReader reader;
+    TLVType containerType;
+    event_id_t nextEventID = inFirstEventID;
+    bool stoppedAtExternalEvents;
+    bool reachedEnd;
+    size_t numEvents = 0;
+
+    ioBatch.mImportance = kImportanceType_Invalid;
+
+    writer.Init(ioBatch.mData, sizeof(ioBatch.mData));
+
+    err = FetchEventsFromBuffers(writer, inImportance, nextEventID, &stoppedAtExternalEvents);
+    if ((err == WEAVE_END_OF_TLV) || (err == WEAVE_ERROR_TLV_UNDERRUN) || (err == WEAVE_NO_ERROR))
+    {
+        reachedEnd = !stoppedAtExternalEvents;
+    }
+    else if ((err == WEAVE_ERROR_BUFFER_TOO_SMALL) || (err == WEAVE_ERROR_NO_MEMORY))
+    {
+        reachedEnd = false;
+    }
+    else
+    {
+        ExitNow();
+    }
+
+    // Note where each event ends, so that fetches can copy whole events
+    // without parsing them.
+    reader.Init(ioBatch.mData, writer.GetLengthWritten());
+
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        err = reader.EnterContainer(containerType);
+        SuccessOrExit(err);
+
+        err = reader.ExitContainer(containerType);
+        SuccessOrExit(err);
+
+        if (numEvents < WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS)
+        {
+            ioBatch.mEventEnds[numEvents] = static_cast<uint16_t>(reader.GetReadPoint() - ioBatch.mData);
+        }
+        numEvents++;
+    }
+    VerifyOrExit(err == WEAVE_END_OF_TLV, );
+
+    VerifyOrExit(!(reachedEnd && (numEvents == 0) && (nextEventID == inFirstEventID)), err = WEAVE_END_OF_TLV);
+
+    // Event IDs are implied by position within the batch, so every event
+    // in the range must have been copied rather than skipped over.
+    VerifyOrExit((numEvents > 0) && (nextEventID - inFirstEventID == numEvents), err = WEAVE_ERROR_INCORRECT_STATE);
+
+    if (numEvents > WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS)
+    {
+        numEvents  = WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS;
+        reachedEnd = false;
+    }
+
+    ioBatch.mImportance   = inImportance;
+    ioBatch.mFirstEventID = inFirstEventID;
+    ioBatch.mNumEvents    = static_cast<uint16_t>(numEvents);
+    ioBatch.mReachedEnd   = reachedEnd;
+    err                   = WEAVE_NO_ERROR;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Copy the events of a batch to a writer, stopping on an event
+ *   boundary if the writer runs out of space.
+ *
+ * @param[inout] ioEventID On input, the ID of the first event in the
+ *                         batch.  On completion, the ID of the event
+ *                         following the last one copied.
+ */
+WEAVE_ERROR LoggingManagement::CopyEventBatch(TLVWriter & ioWriter, const EventBatch & inBatch, event_id_t & ioEventID)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    TLVWriter checkpoint;
+    uint16_t eventStart = 0;
+
+    for (uint16_t i = 0; i < inBatch.mNumEvents; i++)
+    {
+        checkpoint = ioWriter;
+
+        err = ioWriter.CopyContainer(AnonymousTag, inBatch.mData + eventStart, inBatch.mEventEnds[i] - eventStart);
+        if (err == WEAVE_NO_ERROR)
+        {
+            err = ioWriter.Finalize();
+        }
+        VerifyOrExit(err == WEAVE_NO_ERROR, ioWriter = checkpoint);
+
+        eventStart = inBatch.mEventEnds[i];
+        ioEventID++;
+    }
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Reset the event batch cache usage counters.
+ */
+void LoggingManagement::ResetBatchCacheStats(void)
+{
+    memset(&mBatchCache.mStats, 0, sizeof(mBatchCache.mStats));
+}
+
+void EventBatchCache::Clear(void)
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES; i++)
+    {
+        mBatches[i].mImportance = kImportanceType_Invalid;
+    }
+    mUseCounter = 0;
+}
+
+EventBatch * EventBatchCache::Find(ImportanceType inImportance, event_id_t inFirstEventID)
+{
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES; i++)
+    {
+        if ((mBatches[i].mImportance == inImportance) && (mBatches[i].mFirstEventID == inFirstEventID))
+        {
+            return &mBatches[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief
+ *   Return an unused batch, or else the least recently used one.
+ */
+EventBatch * EventBatchCache::Allocate(void)
+{
+    EventBatch * leastRecentlyUsed = &mBatches[0];
+
+    for (size_t i = 0; i < WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES; i++)
+    {
+        if (mBatches[i].mImportance == kImportanceType_Invalid)
+        {
+            return &mBatches[i];
+        }
+
+        if (mBatches[i].mLastUsed < leastRecentlyUsed->mLastUsed)
+        {
+            leastRecentlyUsed = &mBatches[i];
+        }
+    }
+
+    mStats.Evictions++;
+
+    return leastRecentlyUsed;
+}
+
+void EventBatchCache::Touch(EventBatch & ioBatch)
+{
+    ioBatch.mLastUsed = ++mUseCounter;
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+/**
+ * @brief
+ *   A function to retrieve the events of specified importance that
+ *   match a query.
+ *
+ * Given a nl::Weave::TLV::TLVWriter, a query, and an event ID, the
+ * function will fetch the events of the query's importance since the
+ * specified event that are of the query's profile and fall in the
+ * query's time range.  Like FetchEventsSince(), the function continues
+ * until it runs out of space in the writer or in the log, and ends on
+ * an event boundary.
+ *
+ * Each summary block of events in the buffers is passed over as a
+ * whole when it holds no event of the query's importance after the
+ * specified event, when none of its events can be of the query's
+ * profile, or when its timestamps lie outside the query's time range.
+ * The events of other blocks are decoded and matched one at a time.
+ *
+ * Since the events written are not consecutive, each one carries its
+ * event ID and absolute timestamp.  Events stored outside the log
+ * through RegisterEventCallbackForImportance() never match.
+ *
+ * @param[in] ioWriter     The writer to use for event storage
+ *
+ * @param[in] inQuery      The events to be fetched
+ *
+ * @param[inout] ioEventID On input, the ID of the first event to
+ *                         consider.  On completion, the ID of the
+ *                         event following the last one considered.
+ *
+ * @retval #WEAVE_END_OF_TLV             The function has reached the end of the
+ *                                       available log entries at the specified
+ *                                       importance level
+ *
+ * @retval #WEAVE_ERROR_NO_MEMORY        The function ran out of space in the
+ *                                       ioWriter, more events in the log are
+ *                                       available.
+ *
+ * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL The function ran out of space in the
+ *                                       ioWriter, more events in the log are
+ *                                       available.
+ *
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT The query's importance is invalid.
+ */
+WEAVE_ERROR LoggingManagement::FetchMatchingEvents(TLVWriter & ioWriter, const EventQuery & inQuery, event_id_t & ioEventID)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    CircularEventBuffer * buf;
+    CircularTLVReader reader;
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    ExternalEvents ev;
+    EventLoadOutContext context(ioWriter, inQuery.importance, ioEventID, &ev);
+#else
+    EventLoadOutContext context(ioWriter, inQuery.importance, ioEventID, NULL);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+    context.mCurrentEventID = ioEventID;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    MergeStagedEvents();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
+    Platform::CriticalSectionEnter();
+
+    VerifyOrExit((inQuery.importance >= kImportanceType_First) && (inQuery.importance <= kImportanceType_Last),
+                 err = WEAVE_ERROR_INVALID_ARGUMENT);
+
+    buf = GetImportanceBuffer(inQuery.importance);
+
+    context.mCurrentTime = buf->mFirstEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    context.mCurrentUTCTime = buf->mFirstEventUTCTimestamp;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    context.mCurrentEventID = buf->mFirstEventID;
+
+    // Read the buffers from the oldest events to the newest, as
+    // GetEventReader() does, keeping track of the summary block each
+    // event belongs to.
+    for (; buf != NULL; buf = buf->mPrev)
+    {
+        EventSummary & summary = GetEventSummary(buf);
+        uint8_t blockIndex     = 0;
+        uint16_t eventsInBlock = 0;
+
+        // A summary that does not account for every byte in the buffer
+        // cannot be lined up with the events in it.
+        if (summary.GetNumBytes() != buf->mBuffer.DataLength())
+        {
+            SummarizeEvents(buf);
+        }
+
+        reader.Init(&buf->mBuffer);
+
+        while ((err = reader.Next()) == WEAVE_NO_ERROR)
+        {
+            if ((eventsInBlock == 0) && (blockIndex < summary.mNumBlocks))
+            {
+                const EventSummaryBlock & block = summary.GetBlock(blockIndex++);
+                const size_t index              = inQuery.importance - kImportanceType_First;
+
+                eventsInBlock = block.mNumEvents;
+
+                if (CanSkipEvents(block, inQuery, context))
+                {
+                    for (; eventsInBlock > 1; eventsInBlock--)
+                    {
+                        err = reader.Next();
+                        SuccessOrExit(err);
+                    }
+                    eventsInBlock = 0;
+
+                    context.mCurrentEventID += block.mNumEventIDs[index];
+                    context.mCurrentTime += block.mDeltaTime[index];
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+                    context.mCurrentUTCTime += block.mDeltaUtc[index];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+                    mQueryStats.BlocksSkipped++;
+                    continue;
+                }
+
+                mQueryStats.BlocksSearched++;
+            }
+
+            if (eventsInBlock > 0)
+            {
+                eventsInBlock--;
+            }
+
+            err = QueryEvent(reader, inQuery, context);
+            SuccessOrExit(err);
+        }
+
+        VerifyOrExit(err == WEAVE_END_OF_TLV, );
+    }
+
+exit:
+    ioEventID = context.mCurrentEventID;
+
+    Platform::CriticalSectionExit();
+
+    return err;
+}
+
+/**
+ * @brief
+ *   Internal API used to implement #FetchMatchingEvents
+ *
+ * Determine whether none of the events in a summary block can match
+ * the query, given the event ID and timestamps reached just before
+ * the block.
+ */
+bool LoggingManagement::CanSkipEvents(const EventSummaryBlock & inBlock, const EventQuery & inQuery,
+                                      const EventLoadOutContext & inContext)
+{
+    const size_t index = inQuery.importance - kImportanceType_First;
+
+    if ((inBlock.mNumEventIDs[index] == 0) || (inContext.mCurrentEventID + inBlock.mNumEventIDs[index] <= inContext.mStartingEventID))
+    {
+        return true;
+    }
+
+    if (inQuery.matchProfile && ((inBlock.mProfileFilter & EventSummaryBlock::GetProfileFilterBit(inQuery.profileId)) == 0))
+    {
+        return true;
+    }
+
+    // Timestamps that run backwards leave no bounds on the others.
+    if (inBlock.mOutOfOrder)
+    {
+        return false;
+    }
+
+    if (inQuery.timestampType == kTimestampType_System)
+    {
+        timestamp_t lastTime = inContext.mCurrentTime + inBlock.mDeltaTime[index];
+
+        return (lastTime < inQuery.startTime.systemTimestamp) || (inContext.mCurrentTime > inQuery.endTime.systemTimestamp);
+    }
+
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    if (inQuery.timestampType == kTimestampType_UTC)
+    {
+        utc_timestamp_t lastTime = inContext.mCurrentUTCTime + inBlock.mDeltaUtc[index];
+
+        return (lastTime < inQuery.startTime.utcTimestamp) || (inContext.mCurrentUTCTime > inQuery.endTime.utcTimestamp);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+    return false;
+}
+
+/**
+ * @brief
+ *   Internal API used to implement #FetchMatchingEvents
+ *
+ * Keeps track of the event ID and timestamps of the event read by
+ * aReader, and copies the event into the writer if it matches the
+ * query.  If the event cannot be written as a whole, the writer is
+ * rolled back to the event boundary.
+ */
+WEAVE_ERROR LoggingManagement::QueryEvent(const TLVReader & aReader, const EventQuery & inQuery, EventLoadOutContext & ioContext)
+{
+    WEAVE_ERROR err    = WEAVE_NO_ERROR;
+    const bool recurse = false;
+    TLVReader innerReader;
+    TLVType tlvType;
+    TLVWriter checkpoint;
+    EventEnvelopeContext event;
+    uint32_t profileId;
+    TimestampType timestampType;
+    bool matches;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    event.mExternalEvents = ioContext.mExternalEvents;
+    event.mExternalEvents->Invalidate();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+    innerReader.Init(aReader);
+    err = innerReader.EnterContainer(tlvType);
+    SuccessOrExit(err);
+
+    nl::Weave::TLV::Utilities::Iterate(innerReader, FetchEventParameters, &event, recurse);
+    VerifyOrExit((event.mNumFieldsToRead == 0) && (event.mImportance == inQuery.importance), err = WEAVE_NO_ERROR);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    if (event.mExternalEvents->IsValid())
+    {
+        ioContext.mCurrentEventID = event.mExternalEvents->mLastEventID + 1;
+        ExitNow();
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+    ioContext.mCurrentTime += event.mDeltaTime;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    ioContext.mCurrentUTCTime += event.mDeltaUtc;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+    VerifyOrExit(ioContext.mCurrentEventID >= ioContext.mStartingEventID, ioContext.mCurrentEventID++);
+
+    err = ReadEventHeader(aReader, profileId, timestampType);
+    SuccessOrExit(err);
+
+    matches = !inQuery.matchProfile || (profileId == inQuery.profileId);
+
+    if (inQuery.timestampType == kTimestampType_System)
+    {
+        matches = matches && (timestampType == kTimestampType_System) &&
+            (ioContext.mCurrentTime >= inQuery.startTime.systemTimestamp) && (ioContext.mCurrentTime <= inQuery.endTime.systemTimestamp);
+    }
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    else if (inQuery.timestampType == kTimestampType_UTC)
+    {
+        matches = matches && (timestampType == kTimestampType_UTC) && (ioContext.mCurrentUTCTime >= inQuery.startTime.utcTimestamp) &&
+            (ioContext.mCurrentUTCTime <= inQuery.endTime.utcTimestamp);
+    }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+    if (matches)
+    {
+        // The events written are not consecutive, so each one gets its
+        // own event ID and absolute timestamp.
+        checkpoint       = ioContext.mWriter;
+        ioContext.mFirst = true;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        ioContext.mFirstUtc = true;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+        err = CopyEvent(aReader, ioContext.mWriter, &ioContext);
+        VerifyOrExit((err == WEAVE_NO_ERROR) || (err == WEAVE_END_OF_TLV), ioContext.mWriter = checkpoint);
+        err = WEAVE_NO_ERROR;
+
+        mQueryStats.EventsMatched++;
+    }
+
+    ioContext.mCurrentEventID++;
+
+exit:
+    return err;
+}
+
+/**
+ * @brief
+ *   Internal API used to implement #FetchMatchingEvents
+ *
+ * Find the profile ID of an event, and whether it is timestamped with
+ * a system or a UTC time.
+ *
+ * @retval #WEAVE_ERROR_INVALID_TLV_ELEMENT The event has no profile ID,
+ *                                          e.g. it is stored outside the log.
+ */
+WEAVE_ERROR LoggingManagement::ReadEventHeader(const TLVReader & aReader, uint32_t & outProfileId,
+                                               TimestampType & outTimestampType) const
+{
+    WEAVE_ERROR err;
+    TLVReader reader;
+    TLVType containerType;
+
+    outTimestampType = kTimestampType_Invalid;
+
+    reader.Init(aReader);
+    err = reader.EnterContainer(containerType);
+    SuccessOrExit(err);
+
+    // The timestamp always comes before the profile ID.
+    while ((err = reader.Next()) == WEAVE_NO_ERROR)
+    {
+        if (reader.GetTag() == ContextTag(kTag_EventDeltaSystemTime))
+        {
+            outTimestampType = kTimestampType_System;
+        }
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        else if (reader.GetTag() == ContextTag(kTag_EventDeltaUTCTime))
+        {
+            outTimestampType = kTimestampType_UTC;
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        else if (reader.GetTag() == ContextTag(kTag_EventTraitProfileID))
+        {
+            // The profile ID may be followed by schema versions in an array
+            if (reader.GetType() == kTLVType_Array)
+            {
+                err = reader.EnterContainer(containerType);
+                SuccessOrExit(err);
+
+                err = reader.Next();
+                SuccessOrExit(err);
+            }
+
+            ExitNow(err = reader.Get(outProfileId));
+        }
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+        else if (reader.GetTag() == ContextTag(kTag_EventHeaderReference))
+        {
+            uint8_t headerIndex;
+            uint32_t structureType;
+
+            err = reader.Get(headerIndex);
+            SuccessOrExit(err);
+
+            VerifyOrExit(mHeaderDictionary.Get(headerIndex, outProfileId, structureType), err = WEAVE_ERROR_INVALID_TLV_ELEMENT);
+            ExitNow();
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    }
+
+    if (err == WEAVE_END_OF_TLV)
+    {
+        err = WEAVE_ERROR_INVALID_TLV_ELEMENT;
+    }
+
+exit:
+    return err;
+}
+
+EventSummary & LoggingManagement::GetEventSummary(const CircularEventBuffer * inBuffer)
+{
+    return mEventSummaries[inBuffer->mImportance - kImportanceType_First];
+}
+
+void LoggingManagement::AppendEventSummary(CircularEventBuffer * inBuffer, const EventSummaryBlock & inEvent)
+{
+    GetEventSummary(inBuffer).Append(inEvent, inBuffer->mBuffer.GetQueueSize() / WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS);
+}
+
+/**
+ * @brief
+ *   Summarize the events in a buffer anew, e.g. after they were loaded
+ *   or recovered.
+ *
+ * An event whose profile ID cannot be found may be of any profile.
+ */
+void LoggingManagement::SummarizeEvents(CircularEventBuffer * inBuffer)
+{
+    WEAVE_ERROR err;
+    const bool recurse = false;
+    CircularTLVReader reader;
+    TLVType containerType;
+    uint32_t eventStart = 0;
+
+    GetEventSummary(inBuffer).Clear();
+
+    reader.Init(&inBuffer->mBuffer);
+
+    while (reader.Next() == WEAVE_NO_ERROR)
+    {
+        EventEnvelopeContext envelope;
+        EventSummaryBlock event;
+        uint32_t profileId;
+        uint32_t profileFilter;
+        TimestampType timestampType;
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+        ExternalEvents ev;
+
+        ev.Invalidate();
+        envelope.mExternalEvents = &ev;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+        err           = ReadEventHeader(reader, profileId, timestampType);
+        profileFilter = (err == WEAVE_NO_ERROR) ? EventSummaryBlock::GetProfileFilterBit(profileId) : UINT32_MAX;
+
+        err = reader.EnterContainer(containerType);
+        SuccessOrExit(err);
+
+        nl::Weave::TLV::Utilities::Iterate(reader, FetchEventParameters, &envelope, recurse);
+
+        err = reader.ExitContainer(containerType);
+        SuccessOrExit(err);
+
+        event.Init(envelope);
+        event.mProfileFilter = profileFilter;
+        event.mNumBytes      = reader.GetLengthRead() - eventStart;
+        eventStart           = reader.GetLengthRead();
+
+        AppendEventSummary(inBuffer, event);
+    }
+
+exit:
+    mQueryStats.SummariesRebuilt++;
+}
+
+/**
+ * @brief
+ *   Reset the event query counters.
+ */
+void LoggingManagement::ResetQueryStats(void)
+{
+    memset(&mQueryStats, 0, sizeof(mQueryStats));
+}
+
+/**
+ * @brief
+ *   Map a profile ID to the bit that stands for it in a profile filter.
+ */
+uint32_t EventSummaryBlock::GetProfileFilterBit(uint32_t inProfileId)
+{
+    // Fold the vendor ID in with the profile number.
+    inProfileId ^= inProfileId >> 16;
+    inProfileId ^= inProfileId >> 8;
+
+    return static_cast<uint32_t>(1) << (inProfileId & 31);
+}
+
+void EventSummaryBlock::Clear(void)
+{
+    memset(this, 0, sizeof(*this));
+}
+
+/**
+ * @brief
+ *   Describe a single event, from the envelope read out of it by
+ *   FetchEventParameters().  The profile filter and size are left for
+ *   the caller.
+ */
+void EventSummaryBlock::Init(const EventEnvelopeContext & inEvent)
+{
+    Clear();
+
+    mNumEvents = 1;
+
+    // Events without an importance and timestamp are not counted by
+    // readers, so they take up no event ID.
+    if ((inEvent.mNumFieldsToRead == 0) && (inEvent.mImportance >= kImportanceType_First) &&
+        (inEvent.mImportance <= kImportanceType_Last))
+    {
+        const size_t index = inEvent.mImportance - kImportanceType_First;
+
+        mNumEventIDs[index] = 1;
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+        if ((inEvent.mExternalEvents != NULL) && inEvent.mExternalEvents->IsValid())
+        {
+            mNumEventIDs[index] = inEvent.mExternalEvents->mLastEventID - inEvent.mExternalEvents->mFirstEventID + 1;
+        }
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+        mDeltaTime[index] = inEvent.mDeltaTime;
+        mOutOfOrder       = (inEvent.mDeltaTime < 0);
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        mDeltaUtc[index] = inEvent.mDeltaUtc;
+        mOutOfOrder      = mOutOfOrder || (inEvent.mDeltaUtc < 0);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    }
+}
+
+void EventSummaryBlock::Add(const EventSummaryBlock & inEvents)
+{
+    mNumBytes += inEvents.mNumBytes;
+    mNumEvents += inEvents.mNumEvents;
+    mOutOfOrder = mOutOfOrder || inEvents.mOutOfOrder;
+    mProfileFilter |= inEvents.mProfileFilter;
 
-    err = EventIterator(aReader, aDepth, aContext);
-    if (err == WEAVE_EVENT_ID_FOUND)
+    for (size_t i = 0; i <= kImportanceType_Last - kImportanceType_First; i++)
     {
-        // checkpoint the writer
-        checkpoint = loadOutContext->mWriter;
+        mNumEventIDs[i] += inEvents.mNumEventIDs[i];
+        mDeltaTime[i] += inEvents.mDeltaTime[i];
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        mDeltaUtc[i] += inEvents.mDeltaUtc[i];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    }
+}
 
-        err = CopyEvent(aReader, loadOutContext->mWriter, loadOutContext);
+void EventSummary::Clear(void)
+{
+    mHead      = 0;
+    mNumBlocks = 0;
+}
 
-        // WEAVE_NO_ERROR and WEAVE_END_OF_TLV signify a
-        // successful copy.  In all other cases, roll back the
-        // writer state back to the checkpoint, i.e., the state
-        // before we began the copy operation.
-        VerifyOrExit((err == WEAVE_NO_ERROR) || (err == WEAVE_END_OF_TLV), loadOutContext->mWriter = checkpoint);
+/**
+ * @brief
+ *   Add an event to the newest block, or to a new block if the newest
+ *   one already covers inBlockSize bytes.  Once every block is in use,
+ *   the newest one keeps growing.
+ */
+void EventSummary::Append(const EventSummaryBlock & inEvent, size_t inBlockSize)
+{
+    uint8_t tail = (mHead + mNumBlocks + WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS - 1) % WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS;
 
-        loadOutContext->mCurrentTime = 0;
-        loadOutContext->mFirst       = false;
-        loadOutContext->mCurrentEventID++;
+    if ((mNumBlocks == 0) ||
+        ((mBlocks[tail].mNumBytes >= inBlockSize) && (mNumBlocks < WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS)))
+    {
+        tail = (mHead + mNumBlocks) % WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS;
+        mBlocks[tail].Clear();
+        mNumBlocks++;
     }
 
-exit:
-    return err;
+    mBlocks[tail].Add(inEvent);
 }
 
 /**
  * @brief
- *   A function to retrieve events of specified importance since a specified event ID.
- *
- * Given a nl::Weave::TLV::TLVWriter, an importance type, and an event ID, the
- * function will fetch events of specified importance since the
- * specified event.  The function will continue fetching events until
- * it runs out of space in the nl::Weave::TLV::TLVWriter or in the log. The function
- * will terminate the event writing on event boundary.
- *
- * @param[in] ioWriter     The writer to use for event storage
- *
- * @param[in] inImportance The importance of events to be fetched
- *
- * @param[inout] ioEventID On input, the ID of the event immediately
- *                         prior to the one we're fetching.  On
- *                         completion, the ID of the last event
- *                         fetched.
- *
- * @retval #WEAVE_END_OF_TLV             The function has reached the end of the
- *                                       available log entries at the specified
- *                                       importance level
- *
- * @retval #WEAVE_ERROR_NO_MEMORY        The function ran out of space in the
- *                                       ioWriter, more events in the log are
- *                                       available.
- *
- * @retval #WEAVE_ERROR_BUFFER_TOO_SMALL The function ran out of space in the
- *                                       ioWriter, more events in the log are
- *                                       available.
- *
+ *   Take the oldest event out of the oldest block.  The oldest block is
+ *   released once it holds no events.
  */
-WEAVE_ERROR LoggingManagement::FetchEventsSince(TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID)
+void EventSummary::RemoveHead(const EventSummaryBlock & inEvent)
 {
-    WEAVE_ERROR err    = WEAVE_NO_ERROR;
-    const bool recurse = false;
-    TLVReader reader;
+    EventSummaryBlock & head = mBlocks[mHead];
 
-#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
-    ExternalEvents ev;
-    EventLoadOutContext aContext(ioWriter, inImportance, ioEventID, &ev);
-#else
-    EventLoadOutContext aContext(ioWriter, inImportance, ioEventID, NULL);
-#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    VerifyOrExit(mNumBlocks > 0, );
 
-    CircularEventBuffer * buf = mEventBuffer;
-    Platform::CriticalSectionEnter();
+    // The summary has lost track of the buffer; FetchMatchingEvents()
+    // finds it out of step with the buffer and summarizes it anew.
+    VerifyOrExit((head.mNumEvents > 0) && (head.mNumBytes >= inEvent.mNumBytes), Clear());
 
-    while (!buf->IsFinalDestinationForImportance(inImportance))
-    {
-        buf = buf->mNext;
-    }
+    head.mNumBytes -= inEvent.mNumBytes;
+    head.mNumEvents--;
 
-    aContext.mCurrentTime = buf->mFirstEventTimestamp;
+    for (size_t i = 0; i <= kImportanceType_Last - kImportanceType_First; i++)
+    {
+        head.mNumEventIDs[i] -= inEvent.mNumEventIDs[i];
+        head.mDeltaTime[i] -= inEvent.mDeltaTime[i];
 #if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
-    aContext.mCurrentUTCTime = buf->mFirstEventUTCTimestamp;
+        head.mDeltaUtc[i] -= inEvent.mDeltaUtc[i];
 #endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
-    aContext.mCurrentEventID = buf->mFirstEventID;
-    err                      = GetEventReader(reader, inImportance);
-    SuccessOrExit(err);
-
-    err = nl::Weave::TLV::Utilities::Iterate(reader, CopyEventsSince, &aContext, recurse);
+    }
 
-#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
-    if ((err == WEAVE_END_OF_TLV) && (ev.IsValid()))
+    if (head.mNumEvents == 0)
     {
-        if (ev.mFetchEventsFunct != NULL)
-        {
-            err = ev.mFetchEventsFunct(&aContext);
-        }
-        else
-        {
-            aContext.mCurrentEventID = ev.mLastEventID + 1;
-            err                      = WEAVE_END_OF_TLV;
-        }
+        mHead = (mHead + 1) % WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS;
+        mNumBlocks--;
     }
-#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
 
 exit:
-    ioEventID = aContext.mCurrentEventID;
+    return;
+}
 
-    Platform::CriticalSectionExit();
-    return err;
+uint32_t EventSummary::GetHeadProfileFilter(void) const
+{
+    return (mNumBlocks > 0) ? mBlocks[mHead].mProfileFilter : UINT32_MAX;
+}
+
+size_t EventSummary::GetNumBytes(void) const
+{
+    size_t numBytes = 0;
+
+    for (uint8_t i = 0; i < mNumBlocks; i++)
+    {
+        numBytes += GetBlock(i).mNumBytes;
+    }
+
+    return numBytes;
+}
+
+/**
+ * @brief
+ *   Return a block by its position, counting from the oldest block.
+ */
+const EventSummaryBlock & EventSummary::GetBlock(uint8_t inIndex) const
+{
+    return mBlocks[(mHead + inIndex) % WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS];
 }
 
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 /**
  * @brief
  *   A helper method useful for examining the in-memory log buffers
@@ -1662,6 +3405,10 @@ exit:
  *                         reader will traverse the least data when
  *                         the Debug importance is passed in.
  *
+ * @note The reader sees events as they are stored, so when the
+ *       compact encoding is enabled, event headers may hold a
+ *       reference in place of the profile ID and event type.
+ *
  * @return                 #WEAVE_NO_ERROR Unconditionally.
  */
 WEAVE_ERROR LoggingManagement::GetEventReader(TLVReader & ioReader, ImportanceType inImportance)
@@ -1765,6 +3512,12 @@ WEAVE_ERROR LoggingManagement::EvictEvent(WeaveCircularTLVBuffer & inBuffer, voi
 
     imp = static_cast<ImportanceType>(context.mImportance);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    // Describe the event to EnsureSpace(), which takes it out of the
+    // buffer summaries once it has left the buffer.
+    ctx->mEvent.Init(context);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
     if (eventBuffer->IsFinalDestinationForImportance(imp))
     {
         // event is getting dropped.  Increase the eventid and first timestamp.
@@ -2173,6 +3926,9 @@ CircularEventBuffer::CircularEventBuffer(uint8_t * inBuffer, size_t inBufferLeng
     mFirstEventUTCTimestamp(0), mLastEventUTCTimestamp(0), mUTCInitialized(false),
 #endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
     mEventIdCounter(NULL)
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    , mMappedState(NULL), mMappedSequence(0)
+#endif
 {
     // TODO: hook up the platform-specific persistent event ID.
 }
@@ -2443,6 +4199,285 @@ exit:
     return err;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
+#define MAPPED_EVENT_BUFFER_MAGIC 0x4D455642 // 'MEVB'
+
+static uint32_t ComputeMappedStateChecksum(const MappedEventBufferState & inState)
+{
+    // FNV-1a over everything ahead of the checksum itself
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(&inState);
+    uint32_t hash     = 2166136261UL;
+
+    for (size_t i = 0; i < offsetof(MappedEventBufferState, mChecksum); i++)
+    {
+        hash ^= p[i];
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief
+ *   Restore the buffer from the state kept in its memory-mapped file.
+ *
+ * The newer of the two copies of the state that is intact and matches
+ * this buffer is used; if neither is, the buffer starts out empty.
+ * Either way, the buffer keeps its state in @a inState from then on.
+ *
+ * @param[in] inState  The two copies of the state, which directly
+ *                     precede the event data in the mapped file.
+ *
+ * @return true if events and event IDs were recovered, false if the
+ *         buffer starts out empty.
+ */
+bool CircularEventBuffer::RecoverMappedState(MappedEventBufferState * inState)
+{
+    const MappedEventBufferState * recovered = NULL;
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        const MappedEventBufferState & state = inState[i];
+
+        if ((state.mMagic != MAPPED_EVENT_BUFFER_MAGIC) || (state.mChecksum != ComputeMappedStateChecksum(state)))
+            continue;
+        if ((state.mQueueSize != mBuffer.GetQueueSize()) || (state.mImportance != static_cast<uint32_t>(mImportance)))
+            continue;
+        if ((state.mHeadOffset >= state.mQueueSize) || (state.mDataLength > state.mQueueSize))
+            continue;
+        if ((recovered == NULL) || (static_cast<int32_t>(state.mSequence - recovered->mSequence) > 0))
+            recovered = &state;
+    }
+
+    mMappedState = inState;
+
+    if (recovered != NULL)
+    {
+        mMappedSequence = recovered->mSequence;
+
+        mBuffer.SetQueueHead(mBuffer.GetQueue() + recovered->mHeadOffset);
+        mBuffer.SetQueueLength(recovered->mDataLength);
+
+        mFirstEventID        = recovered->mFirstEventID;
+        mLastEventID         = recovered->mLastEventID;
+        mFirstEventTimestamp = recovered->mFirstEventTimestamp;
+        mLastEventTimestamp  = recovered->mLastEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+        mFirstEventUTCTimestamp = recovered->mFirstEventUTCTimestamp;
+        mLastEventUTCTimestamp  = recovered->mLastEventUTCTimestamp;
+        mUTCInitialized         = (recovered->mUTCInitialized != 0);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+        // Never vend an event ID that a recovered event may already hold.
+        if (mEventIdCounter->GetValue() <= mLastEventID)
+        {
+            if (mEventIdCounter == &mNonPersistedCounter)
+            {
+                mNonPersistedCounter.Init(mLastEventID + 1);
+            }
+            else
+            {
+                static_cast<PersistedCounter *>(mEventIdCounter)->SetValue(mLastEventID + 1);
+            }
+        }
+    }
+    else
+    {
+        mMappedSequence = 0;
+    }
+
+    SyncMappedState();
+
+    return (recovered != NULL);
+}
+
+/**
+ * @brief
+ *   Write the current state of the buffer to its memory-mapped file.
+ *
+ * The older of the two copies is overwritten, after the event data it
+ * describes, so that a crash at any point leaves one consistent copy.
+ * Does nothing if the buffer is not mapped.
+ */
+void CircularEventBuffer::SyncMappedState(void)
+{
+    MappedEventBufferState * state;
+
+    VerifyOrExit(mMappedState != NULL, /* no-op */);
+
+    mMappedSequence++;
+    state = &mMappedState[mMappedSequence % 2];
+
+    // Event data must reach the mapping before the state describing it.
+    __sync_synchronize();
+
+    memset(state, 0, sizeof(MappedEventBufferState));
+
+    state->mMagic               = MAPPED_EVENT_BUFFER_MAGIC;
+    state->mSequence            = mMappedSequence;
+    state->mQueueSize           = mBuffer.GetQueueSize();
+    state->mHeadOffset          = mBuffer.QueueHead() - mBuffer.GetQueue();
+    state->mDataLength          = mBuffer.DataLength();
+    state->mImportance          = static_cast<uint32_t>(mImportance);
+    state->mFirstEventID        = mFirstEventID;
+    state->mLastEventID         = mLastEventID;
+    state->mFirstEventTimestamp = mFirstEventTimestamp;
+    state->mLastEventTimestamp  = mLastEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    state->mFirstEventUTCTimestamp = mFirstEventUTCTimestamp;
+    state->mLastEventUTCTimestamp  = mLastEventUTCTimestamp;
+    state->mUTCInitialized         = mUTCInitialized ? 1 : 0;
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+    __sync_synchronize();
+
+    state->mChecksum = ComputeMappedStateChecksum(*state);
+
+exit:
+    return;
+}
+
+/**
+ * @brief
+ *   Map a file to back the storage for one importance level.
+ *
+ * The returned memory is passed to CreateLoggingManagement() as the
+ * `mBuffer` of a LogStorageResources with `mIsMapped` set, in place of
+ * a static array.  Events left in the file by a previous run are then
+ * recovered as the logging subsystem is created, without copying.  A
+ * file of a different size holds nothing recoverable and is cleared.
+ *
+ * The mapping is shared, so the contents of the file survive the
+ * process crashing; surviving a loss of power also requires the
+ * platform to write the mapping back to storage, which
+ * UnmapEventBuffer() does on orderly shutdown.
+ *
+ * @param[in]  inPath        Path of the file to map, created if needed.
+ * @param[in]  inBufferSize  Size of the storage, as it will be passed in
+ *                           `mBufferSize`.
+ * @param[out] outBuffer     The mapped storage.
+ *
+ * @return #WEAVE_NO_ERROR on success, otherwise the error reported by
+ *         the system.
+ */
+WEAVE_ERROR LoggingManagement::MapEventBuffer(const char * inPath, size_t inBufferSize, void *& outBuffer)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    struct stat fileStat;
+    void * mapping;
+    int fd;
+
+    fd = open(inPath, O_RDWR | O_CREAT, 0600);
+    VerifyOrExit(fd >= 0, err = System::MapErrorPOSIX(errno));
+
+    if ((fstat(fd, &fileStat) != 0) || (static_cast<size_t>(fileStat.st_size) != inBufferSize))
+    {
+        VerifyOrExit(ftruncate(fd, 0) == 0, err = System::MapErrorPOSIX(errno));
+        VerifyOrExit(ftruncate(fd, static_cast<off_t>(inBufferSize)) == 0, err = System::MapErrorPOSIX(errno));
+    }
+
+    mapping = mmap(NULL, inBufferSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    VerifyOrExit(mapping != MAP_FAILED, err = System::MapErrorPOSIX(errno));
+
+    outBuffer = mapping;
+
+exit:
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return err;
+}
+
+/**
+ * @brief
+ *   Write back and unmap storage returned by MapEventBuffer().
+ *
+ * Must only be called once the logging subsystem no longer uses the
+ * storage.
+ */
+void LoggingManagement::UnmapEventBuffer(void * inBuffer, size_t inBufferSize)
+{
+    msync(inBuffer, inBufferSize, MS_SYNC);
+    munmap(inBuffer, inBufferSize);
+}
+
+void LoggingManagement::SyncMappedBuffers(void)
+{
+    for (CircularEventBuffer * eventBuffer = mEventBuffer; eventBuffer != NULL; eventBuffer = eventBuffer->mNext)
+    {
+        eventBuffer->SyncMappedState();
+    }
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+struct RecoveredExternalEventsCtx
+{
+    ImportanceType mImportance;
+    event_id_t mEventID;
+};
+
+WEAVE_ERROR LoggingManagement::FindRecoveredExternalEvents(const TLVReader & aReader, size_t aDepth, void * aContext)
+{
+    WEAVE_ERROR err                   = WEAVE_NO_ERROR;
+    RecoveredExternalEventsCtx * ctxt = static_cast<RecoveredExternalEventsCtx *>(aContext);
+    ExternalEvents ev;
+    EventEnvelopeContext event;
+    TLVReader innerReader;
+    TLVType tlvType;
+
+    event.mExternalEvents = &ev;
+
+    innerReader.Init(aReader);
+    err = innerReader.EnterContainer(tlvType);
+    SuccessOrExit(err);
+
+    nl::Weave::TLV::Utilities::Iterate(innerReader, FetchEventParameters, &event, false);
+    err = WEAVE_NO_ERROR;
+
+    if (ev.IsValid() &&
+        ((ev.mFetchEventsFunct != NULL) || (ev.mNotifyEventsDeliveredFunct != NULL) || (ev.mNotifyEventsEvictedFunct != NULL)))
+    {
+        ctxt->mImportance = event.mImportance;
+        ctxt->mEventID    = ev.mFirstEventID;
+        err               = WEAVE_ERROR_MAX;
+    }
+
+exit:
+    return err;
+}
+
+// Recovered blocks of external events refer to callbacks registered by
+// the previous run; clear them just as unregistering would.
+
+void LoggingManagement::ReleaseRecoveredExternalEvents(void)
+{
+    RecoveredExternalEventsCtx ctxt;
+    RecoveredExternalEventsCtx prev = { kImportanceType_Invalid, 0 };
+    TLVReader reader;
+
+    while (true)
+    {
+        GetEventReader(reader, kImportanceType_First);
+
+        if (nl::Weave::TLV::Utilities::Iterate(reader, FindRecoveredExternalEvents, &ctxt, false) != WEAVE_ERROR_MAX)
+            break;
+
+        // Give up rather than spin on a block that could not be cleared.
+        if ((ctxt.mImportance == prev.mImportance) && (ctxt.mEventID == prev.mEventID))
+            break;
+
+        UnregisterEventCallbackForImportance(ctxt.mImportance, ctxt.mEventID);
+        prev = ctxt;
+    }
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
 CopyAndAdjustDeltaTimeContext::CopyAndAdjustDeltaTimeContext(TLVWriter * inWriter, EventLoadOutContext * inContext) :
     mWriter(inWriter), mContext(inContext)
 { }
@@ -40,6 +40,37 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+/**
+ * @brief
+ *   The recoverable state of an event buffer in a memory-mapped file.
+ *
+ * A mapped buffer keeps two copies of its state, ahead of the event
+ * data, and overwrites the older one each time the state changes.
+ * Each copy carries a sequence number and a checksum, so a crash part
+ * way through an update leaves the other copy to recover from.
+ */
+struct MappedEventBufferState
+{
+    uint32_t mMagic;
+    uint32_t mSequence;
+    uint32_t mQueueSize;
+    uint32_t mHeadOffset;
+    uint32_t mDataLength;
+    uint32_t mImportance;
+    event_id_t mFirstEventID;
+    event_id_t mLastEventID;
+    timestamp_t mFirstEventTimestamp;
+    timestamp_t mLastEventTimestamp;
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    utc_timestamp_t mFirstEventUTCTimestamp;
+    utc_timestamp_t mLastEventUTCTimestamp;
+    uint32_t mUTCInitialized;
+#endif
+    uint32_t mChecksum;
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
 /**
  * @brief
  *   Internal event buffer, built around the nl::Weave::TLV::WeaveCircularTLVBuffer
@@ -96,6 +127,15 @@ struct CircularEventBuffer
     // The backup counter to use if no counter is provided for us.
     nl::Weave::MonotonicallyIncreasingCounter mNonPersistedCounter;
 
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    // for doxygen, see the CPP file
+    bool RecoverMappedState(MappedEventBufferState * inState);
+    void SyncMappedState(void);
+
+    MappedEventBufferState * mMappedState; ///< The two copies of the recoverable state, or NULL if the buffer is not mapped
+    uint32_t mMappedSequence;              ///< Sequence number of the most recently written copy of the state
+#endif
+
     static WEAVE_ERROR GetNextBufferFunct(nl::Weave::TLV::TLVReader & ioReader, uintptr_t & inBufHandle,
                                           const uint8_t *& outBufStart, uint32_t & outBufLen);
 };
@@ -141,6 +181,185 @@ struct EventEnvelopeContext
     ExternalEvents * mExternalEvents;
 };
 
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+/**
+ * @brief
+ *   A ring of events logged by a single application thread and waiting to
+ *   be merged into the event buffers.
+ *
+ * Each ring has exactly one producer, the thread that acquired it, which
+ * never takes the event logging critical section while staging.  Rings are
+ * only consumed with the critical section held, so there is exactly one
+ * consumer at a time.  The head and tail indices run freely and are each
+ * written by one side only.
+ */
+struct EventStagingRing
+{
+    struct Entry
+    {
+        EventSchema mSchema;
+        Timestamp mTimestamp;
+        TimestampType mTimestampType;
+        DetailedRootSection mEventSource;
+        bool mHasEventSource;
+        event_id_t mRelatedEventID;
+        ImportanceType mRelatedImportance;
+        bool mUrgent;
+        uint16_t mDataLen;
+        uint8_t mData[WEAVE_CONFIG_EVENT_LOGGING_STAGING_MAX_EVENT_SIZE];
+    };
+
+    Entry * GetProducerEntry(void);
+    void CommitProducerEntry(void);
+    Entry * GetConsumerEntry(void);
+    void CommitConsumerEntry(void);
+
+    Entry mEntries[WEAVE_CONFIG_EVENT_LOGGING_STAGING_RING_ENTRIES];
+    volatile uint32_t mHead; ///< Index of the next entry to stage; written only by the producer
+    volatile uint32_t mTail; ///< Index of the next entry to merge; written only by the consumer
+    volatile bool mInUse;    ///< Set while a thread owns the ring
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+/**
+ * @brief
+ *   Dictionary of recurring event headers for the compact event encoding.
+ *
+ * Entries are only ever added, so a reference stays valid for as long as
+ * the event holding it is buffered; once the dictionary is full, events
+ * of new types are stored in the standard encoding.
+ */
+struct EventHeaderDictionary
+{
+    void Clear(void);
+    bool FindOrAdd(uint32_t inProfileId, uint32_t inStructureType, uint8_t & outIndex);
+    bool Get(uint8_t inIndex, uint32_t & outProfileId, uint32_t & outStructureType) const;
+
+    uint32_t mProfileIds[WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE];
+    uint32_t mStructureTypes[WEAVE_CONFIG_EVENT_LOGGING_COMPACT_DICTIONARY_SIZE];
+    uint16_t mNumEntries;
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+/**
+ * @brief
+ *   A run of consecutive events of one importance, encoded once as
+ *   FetchEventsSince() writes them into an event list.
+ *
+ * The first event carries its event ID and absolute timestamps, so any
+ * leading part of the run is itself a valid event list.  Events never
+ * change once logged, so a batch stays valid for as long as event IDs
+ * are not reused.
+ */
+struct EventBatch
+{
+    event_id_t GetNextEventID(void) const { return mFirstEventID + mNumEvents; }
+
+    ImportanceType mImportance; ///< The importance of the events, or kImportanceType_Invalid if the batch is unused
+    event_id_t mFirstEventID;
+    uint16_t mNumEvents;
+    bool mReachedEnd;  ///< The batch held every event of its importance in the log when it was encoded
+    uint32_t mLastUsed;
+    uint16_t mEventEnds[WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_MAX_EVENTS]; ///< Offset just past each encoded event
+    uint8_t mData[WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_SIZE];
+};
+
+/**
+ * @brief
+ *   Event batches shared by all subscriptions, keyed by importance and
+ *   first event ID.
+ */
+struct EventBatchCache
+{
+    /**
+     * Event batch cache usage counters.
+     */
+    struct Stats
+    {
+        uint32_t Hits;         /**< Number of fetches that found a batch starting at the requested event. */
+        uint32_t Misses;       /**< Number of batches encoded, including batches re-encoded to take in newer events. */
+        uint32_t Evictions;    /**< Number of least-recently used batches replaced by another batch. */
+        uint32_t Uncacheable;  /**< Number of fetches that had to bypass the cache, e.g. for external events. */
+        uint32_t EventsServed; /**< Number of events copied out of cached batches. */
+    };
+
+    void Clear(void);
+    EventBatch * Find(ImportanceType inImportance, event_id_t inFirstEventID);
+    EventBatch * Allocate(void);
+    void Touch(EventBatch & ioBatch);
+
+    EventBatch mBatches[WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE_ENTRIES];
+    uint32_t mUseCounter;
+    Stats mStats;
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+/**
+ * @brief
+ *   A summary of a run of consecutive events in an event buffer, or
+ *   of a single event.
+ *
+ * The event ID and time sums are kept for each importance exactly, so
+ * that a query passing over the run can carry on from its end.  The
+ * profile filter only ever gains bits, and may match profiles that are
+ * no longer present.
+ */
+struct EventSummaryBlock
+{
+    static uint32_t GetProfileFilterBit(uint32_t inProfileId);
+
+    void Clear(void);
+    void Init(const EventEnvelopeContext & inEvent);
+    void Add(const EventSummaryBlock & inEvents);
+
+    uint32_t mNumBytes;
+    uint16_t mNumEvents;
+    bool mOutOfOrder;        ///< Some event is timestamped earlier than the event of its importance before it
+    uint32_t mProfileFilter; ///< The union of GetProfileFilterBit() for the profile of each event
+    event_id_t mNumEventIDs[kImportanceType_Last - kImportanceType_First + 1]; ///< Event IDs taken up, by importance
+    int32_t mDeltaTime[kImportanceType_Last - kImportanceType_First + 1];      ///< Sum of the system time deltas, by importance
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    int64_t mDeltaUtc[kImportanceType_Last - kImportanceType_First + 1]; ///< Sum of the UTC time deltas, by importance
+#endif
+};
+
+/**
+ * @brief
+ *   The summary blocks of one event buffer, from the oldest event to
+ *   the newest.
+ *
+ * Events are added to the newest block until it covers a share of the
+ * buffer, and removed from the oldest one as they leave the buffer.
+ */
+struct EventSummary
+{
+    void Clear(void);
+    void Append(const EventSummaryBlock & inEvent, size_t inBlockSize);
+    void RemoveHead(const EventSummaryBlock & inEvent);
+    uint32_t GetHeadProfileFilter(void) const;
+    size_t GetNumBytes(void) const;
+    const EventSummaryBlock & GetBlock(uint8_t inIndex) const;
+
+    EventSummaryBlock mBlocks[WEAVE_CONFIG_EVENT_LOGGING_QUERY_SUMMARY_BLOCKS];
+    uint8_t mHead;
+    uint8_t mNumBlocks;
+};
+
+/**
+ * Event query counters.
+ */
+struct EventQueryStats
+{
+    uint32_t BlocksSkipped;    /**< Number of summary blocks passed over without decoding their events. */
+    uint32_t BlocksSearched;   /**< Number of summary blocks whose events were decoded. */
+    uint32_t EventsMatched;    /**< Number of events copied out by queries. */
+    uint32_t SummariesRebuilt; /**< Number of times a buffer was summarized anew, e.g. after events were loaded. */
+};
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 enum LoggingManagementStates
 {
     kLoggingManagementState_Idle       = 1, ///< No log offload in progress, log offload can begin without any constraints
@@ -177,6 +396,10 @@ struct LogStorageResources
         mCounterStorage; ///< Application-provided storage for persistent counter for this importance level. When NULL, persistent
                          ///< counters will not be used for this importance level.
     ImportanceType mImportance; ///< Log importance level associated with the resources provided in this structure.
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    bool mIsMapped; ///< When true, `mBuffer` was returned by LoggingManagement::MapEventBuffer().  Events found in it are
+                    ///< recovered, and its state is kept current as events are logged.
+#endif
 };
 
 /**
@@ -242,6 +465,34 @@ public:
 
     void SetBDXUploader(LogBDXUpload * inUploader);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    WEAVE_ERROR SetCompactEncoding(bool inEnable);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    const EventBatchCache::Stats & GetBatchCacheStats(void) const { return mBatchCache.mStats; }
+    void ResetBatchCacheStats(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    WEAVE_ERROR FetchMatchingEvents(nl::Weave::TLV::TLVWriter & ioWriter, const EventQuery & inQuery, event_id_t & ioEventID);
+    const EventQueryStats & GetQueryStats(void) const { return mQueryStats; }
+    void ResetQueryStats(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    static WEAVE_ERROR MapEventBuffer(const char * inPath, size_t inBufferSize, void *& outBuffer);
+    static void UnmapEventBuffer(void * inBuffer, size_t inBufferSize);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    EventStagingRing * AcquireStagingRing(void);
+    void ReleaseStagingRing(EventStagingRing * inRing);
+    WEAVE_ERROR StageEvent(EventStagingRing * inRing, const EventSchema & inSchema, EventWriterFunct inEventWriter,
+                           void * inAppData, const EventOptions * inOptions);
+    size_t MergeStagedEvents(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
 #if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
     WEAVE_ERROR RegisterEventCallbackForImportance(ImportanceType inImportance, FetchExternalEventsFunct inFetchCallback,
                                                    NotifyExternalEventsDeliveredFunct inNotifyCallback,
@@ -269,6 +520,35 @@ private:
     void SignalUploadDone(void);
     WEAVE_ERROR CopyToNextBuffer(CircularEventBuffer * inEventBuffer);
     WEAVE_ERROR EnsureSpace(size_t inRequiredSpace);
+    WEAVE_ERROR WriteEventData(EventLoadOutContext * aContext, EventWriterFunct inEventWriter, void * inAppData,
+                               nl::Weave::TLV::TLVType inContainerType);
+    WEAVE_ERROR FetchEventsFromBuffers(nl::Weave::TLV::TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID,
+                                       bool * outStoppedAtExternalEvents);
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    WEAVE_ERROR FetchCachedEventsSince(nl::Weave::TLV::TLVWriter & ioWriter, ImportanceType inImportance, event_id_t & ioEventID);
+    WEAVE_ERROR EncodeEventBatch(EventBatch & ioBatch, ImportanceType inImportance, event_id_t inFirstEventID);
+    static WEAVE_ERROR CopyEventBatch(nl::Weave::TLV::TLVWriter & ioWriter, const EventBatch & inBatch, event_id_t & ioEventID);
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    EventSummary & GetEventSummary(const CircularEventBuffer * inBuffer);
+    void AppendEventSummary(CircularEventBuffer * inBuffer, const EventSummaryBlock & inEvent);
+    void SummarizeEvents(CircularEventBuffer * inBuffer);
+    WEAVE_ERROR ReadEventHeader(const nl::Weave::TLV::TLVReader & aReader, uint32_t & outProfileId,
+                                TimestampType & outTimestampType) const;
+    WEAVE_ERROR QueryEvent(const nl::Weave::TLV::TLVReader & aReader, const EventQuery & inQuery, EventLoadOutContext & ioContext);
+    static bool CanSkipEvents(const EventSummaryBlock & inBlock, const EventQuery & inQuery, const EventLoadOutContext & inContext);
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    WEAVE_ERROR SerializeHeaderDictionary(TLVWriter & writer);
+    WEAVE_ERROR LoadHeaderDictionary(TLVReader & reader);
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    void SyncMappedBuffers(void);
+#if WEAVE_CONFIG_EVENT_LOGGING_EXTERNAL_EVENT_SUPPORT
+    void ReleaseRecoveredExternalEvents(void);
+    static WEAVE_ERROR FindRecoveredExternalEvents(const nl::Weave::TLV::TLVReader & aReader, size_t aDepth, void * aContext);
+#endif
+#endif
 
     static WEAVE_ERROR CopyEventsSince(const nl::Weave::TLV::TLVReader & aReader, size_t aDepth, void * aContext);
     static WEAVE_ERROR EventIterator(const nl::Weave::TLV::TLVReader & aReader, size_t aDepth, void * aContext);
@@ -283,6 +563,12 @@ private:
 
     static void LoggingFlushHandler(System::Layer * systemLayer, void * appState, INET_ERROR err);
 
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    size_t MergeStagedEventsPrivate(EventStagingRing * inRing);
+    static WEAVE_ERROR StagedEventWriter(nl::Weave::TLV::TLVWriter & ioWriter, uint8_t inDataTag, void * appData);
+    static void LoggingMergeHandler(System::Layer * systemLayer, void * appState, INET_ERROR err);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_STAGING
+
 #if WEAVE_CONFIG_EVENT_LOGGING_BDX_OFFLOAD
     bool CheckShouldRunBDX(void);
 #endif
@@ -308,6 +594,20 @@ private:
     uint32_t mThrottled;
     ImportanceType mMaxImportanceBuffer;
     bool mUploadRequested;
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    bool mMergeRequested;
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    bool mCompactEncoding;
+    EventHeaderDictionary mHeaderDictionary;
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    EventBatchCache mBatchCache;
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    EventSummary mEventSummaries[kImportanceType_Last - kImportanceType_First + 1];
+    EventQueryStats mQueryStats;
+#endif
 };
 
 namespace Platform {
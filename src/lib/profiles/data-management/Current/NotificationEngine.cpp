@@ -44,6 +44,15 @@ using namespace ::nl::Weave::Profiles;
 using namespace ::nl::Weave::Profiles::Common;
 using namespace ::nl::Weave::Profiles::DataManagement;
 
+/**
+ * Returns true if aChangeSeq was recorded after aChangeCursor. Change sequence numbers are compared using serial number
+ * arithmetic so that the comparison remains correct when the 32-bit sequence wraps.
+ */
+static inline bool IsChangeAfter(uint32_t aChangeSeq, uint32_t aChangeCursor)
+{
+    return static_cast<int32_t>(aChangeSeq - aChangeCursor) > 0;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // BasicGraphSolver
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -63,7 +72,8 @@ bool NotificationEngine::BasicGraphSolver::IsPropertyPathSupported(PropertyPathH
 
 WEAVE_ERROR NotificationEngine::BasicGraphSolver::RetrieveTraitInstanceData(NotifyRequestBuilder * aBuilder,
                                                                             TraitDataHandle aTraitDataHandle,
-                                                                            SchemaVersion aSchemaVersion, bool aRetrieveAll)
+                                                                            SchemaVersion aSchemaVersion, bool aRetrieveAll,
+                                                                            uint32_t aChangeCursor)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
 
@@ -93,6 +103,7 @@ WEAVE_ERROR NotificationEngine::BasicGraphSolver::SetDirty(TraitDataHandle aData
                 {
                     WeaveLogDetail(DataManagement, "<BSolver:SetD> Set S%u:T%u dirty", i, j);
                     traitInstance[j].SetDirty();
+                    subEngine->GetNotificationEngine()->ScheduleHandler(subHandler);
                 }
             }
         }
@@ -106,6 +117,11 @@ WEAVE_ERROR NotificationEngine::BasicGraphSolver::ClearDirty()
     return WEAVE_NO_ERROR;
 }
 
+WEAVE_ERROR NotificationEngine::BasicGraphSolver::TrimChanges()
+{
+    return WEAVE_NO_ERROR;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // IntermediateGraphSolver::Store
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -117,11 +133,12 @@ NotificationEngine::IntermediateGraphSolver::Store::Store()
     {
         mStore[i].mPropertyPathHandle = kNullPropertyPathHandle;
         mStore[i].mTraitDataHandle    = UINT16_MAX;
+        mChangeSeqs[i]                = 0;
         mValidFlags[i]                = false;
     }
 }
 
-bool NotificationEngine::IntermediateGraphSolver::Store::AddItem(TraitPath aItem)
+bool NotificationEngine::IntermediateGraphSolver::Store::AddItem(TraitPath aItem, uint32_t aChangeSeq)
 {
     if (mNumItems >= WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE)
     {
@@ -133,6 +150,7 @@ bool NotificationEngine::IntermediateGraphSolver::Store::AddItem(TraitPath aItem
         if (!mValidFlags[i])
         {
             mStore[i]      = aItem;
+            mChangeSeqs[i] = aChangeSeq;
             mValidFlags[i] = true;
             mNumItems++;
             return true;
@@ -185,9 +203,47 @@ bool NotificationEngine::IntermediateGraphSolver::Store::IsPresent(TraitPath aIt
     return false;
 }
 
+/**
+ * If the item is present in the store, restamp it with the provided change sequence number so that subscriptions that have
+ * already notified the earlier change pick it up again.
+ *
+ * @retval true  The item was present and has been updated.
+ * @retval false The item is not present in the store.
+ */
+bool NotificationEngine::IntermediateGraphSolver::Store::UpdateItem(TraitPath aItem, uint32_t aChangeSeq)
+{
+    for (size_t i = 0; i < WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE; i++)
+    {
+        if (mValidFlags[i] && (mStore[i] == aItem))
+        {
+            mChangeSeqs[i] = aChangeSeq;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // IntermediateGraphSolver
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+NotificationEngine::IntermediateGraphSolver::IntermediateGraphSolver()
+{
+    mChangeSeq                  = 0;
+    mNumRootDirtyTraitInstances = 0;
+}
+
+uint32_t NotificationEngine::IntermediateGraphSolver::NextChangeSeq()
+{
+    // Zero is reserved to mean 'no change' (see TraitDataSource::IsRootDirty).
+    if (++mChangeSeq == 0)
+    {
+        mChangeSeq = 1;
+    }
+
+    return mChangeSeq;
+}
+
 bool NotificationEngine::IntermediateGraphSolver::IsPropertyPathSupported(PropertyPathHandle aHandle)
 {
     // The intermediate solver also only supports subscribing to root.
@@ -201,12 +257,12 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::DeleteKey(TraitDataHand
     size_t i;
     SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
     TraitDataSource * dataSource;
+    uint32_t changeSeq = NextChangeSeq();
 
     WeaveLogDetail(DataManagement, "<ISolver:DeleteKey> T%u::(%u:%u), CurDeleteItems = %u/%u", aDataHandle,
                    GetPropertyDictionaryKey(aPropertyHandle), GetPropertySchemaHandle(aPropertyHandle), mDeleteStore.GetNumItems(),
                    WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE);
 
-    // Check if the data source is already marked dirty at the root.
     err = subEngine->mPublisherCatalog->Locate(aDataHandle, &dataSource);
     SuccessOrExit(err);
 
@@ -214,17 +270,22 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::DeleteKey(TraitDataHand
     err = BasicGraphSolver::SetDirty(aDataHandle, aPropertyHandle);
     SuccessOrExit(err);
 
-    // if it's marked root dirty already, nothing more to be done!
-    VerifyOrExit(!dataSource->IsRootDirty(), WeaveLogDetail(DataManagement, "<ISolver:DeleteKey> Already root dirty!");
-                 err = WEAVE_NO_ERROR);
+    // Granular items continue to be recorded even if the data source is marked dirty at the root, since subscriptions that have
+    // already notified the root only need the changes made since.
 
-    // if previously present in the delete store, nothing more to be done!
-    if (mDeleteStore.IsPresent(TraitPath(aDataHandle, aPropertyHandle)))
+    // if previously present in the delete store, just bring its change sequence number up to date.
+    if (mDeleteStore.UpdateItem(TraitPath(aDataHandle, aPropertyHandle), changeSeq))
     {
         WeaveLogDetail(DataManagement, "<ISolver:DeleteKey> Previously dirty");
         return WEAVE_NO_ERROR;
     }
 
+    // Before giving up on granularity, reclaim items that every subscription has already notified.
+    if (mDeleteStore.IsFull())
+    {
+        TrimChanges();
+    }
+
     // If we have exceeded the num items in the store, we need to mark the whole trait instance as dirty and remove all
     // existing references to this trait instance in the delete store.
     if (mDeleteStore.IsFull())
@@ -234,11 +295,15 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::DeleteKey(TraitDataHand
         mDeleteStore.RemoveItem(aDataHandle);
 
         // Mark the data source is being entirely dirty.
-        dataSource->SetRootDirty();
+        if (!dataSource->IsRootDirty())
+        {
+            mNumRootDirtyTraitInstances++;
+        }
+        dataSource->SetRootDirty(changeSeq);
     }
     else
     {
-        mDeleteStore.AddItem(TraitPath(aDataHandle, aPropertyHandle));
+        mDeleteStore.AddItem(TraitPath(aDataHandle, aPropertyHandle), changeSeq);
 
         // If we are deleting something, we need to remove any prior additions to this dictionary for this item.
         for (i = 0; i < mDirtyStore.GetStoreSize(); i++)
@@ -267,12 +332,12 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::SetDirty(TraitDataHandl
     WEAVE_ERROR err                = WEAVE_NO_ERROR;
     SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
     TraitDataSource * dataSource;
+    uint32_t changeSeq             = NextChangeSeq();
 
     WeaveLogDetail(DataManagement, "<ISolver:SetDirty> T%u::(%u:%u), CurDirtyItems = %u/%u", aDataHandle,
                    GetPropertyDictionaryKey(aPropertyHandle), GetPropertySchemaHandle(aPropertyHandle), mDirtyStore.GetNumItems(),
                    WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE);
 
-    // Check if the data source is already marked dirty at the root.
     err = subEngine->mPublisherCatalog->Locate(aDataHandle, &dataSource);
     SuccessOrExit(err);
 
@@ -280,17 +345,22 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::SetDirty(TraitDataHandl
     err = BasicGraphSolver::SetDirty(aDataHandle, aPropertyHandle);
     SuccessOrExit(err);
 
-    // if it's marked root dirty already, nothing more to be done!
-    VerifyOrExit(!dataSource->IsRootDirty(), WeaveLogDetail(DataManagement, "<ISolver:SetDirty> Already root dirty!");
-                 err = WEAVE_NO_ERROR);
+    // Granular items continue to be recorded even if the data source is marked dirty at the root, since subscriptions that have
+    // already notified the root only need the changes made since.
 
-    // if previously present in the delete store, nothing more to be done!
-    if (mDirtyStore.IsPresent(TraitPath(aDataHandle, aPropertyHandle)))
+    // if previously present in the dirty store, just bring its change sequence number up to date.
+    if (mDirtyStore.UpdateItem(TraitPath(aDataHandle, aPropertyHandle), changeSeq))
     {
         WeaveLogDetail(DataManagement, "<ISolver:SetDirty> Previously dirty");
         return WEAVE_NO_ERROR;
     }
 
+    // Before giving up on granularity, reclaim items that every subscription has already notified.
+    if (mDirtyStore.IsFull())
+    {
+        TrimChanges();
+    }
+
     // If we have exceeded the num items in the store, we need to mark the whole trait instance as dirty and remove all
     // existing references to this trait instance in the dirty store.
     if (mDirtyStore.IsFull())
@@ -300,7 +370,11 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::SetDirty(TraitDataHandl
         mDirtyStore.RemoveItem(aDataHandle);
 
         // Mark the data source is being entirely dirty.
-        dataSource->SetRootDirty();
+        if (!dataSource->IsRootDirty())
+        {
+            mNumRootDirtyTraitInstances++;
+        }
+        dataSource->SetRootDirty(changeSeq);
     }
     else
     {
@@ -331,7 +405,7 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::SetDirty(TraitDataHandl
         }
 #endif // TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
 
-        mDirtyStore.AddItem(TraitPath(aDataHandle, handleToAdd));
+        mDirtyStore.AddItem(TraitPath(aDataHandle, handleToAdd), changeSeq);
     }
 
 exit:
@@ -340,6 +414,7 @@ exit:
 
 PropertyPathHandle NotificationEngine::IntermediateGraphSolver::GetNextCandidateHandle(uint32_t & aChangeStoreCursor,
                                                                                        TraitDataHandle aTargetDataHandle,
+                                                                                       uint32_t aChangeCursor,
                                                                                        bool & aCandidateHandleIsDelete)
 {
     PropertyPathHandle candidateHandle = kNullPropertyPathHandle;
@@ -348,7 +423,8 @@ PropertyPathHandle NotificationEngine::IntermediateGraphSolver::GetNextCandidate
     {
         TraitPath dirtyPath = mDirtyStore.mStore[aChangeStoreCursor];
 
-        if (mDirtyStore.mValidFlags[aChangeStoreCursor] && (dirtyPath.mTraitDataHandle == aTargetDataHandle))
+        if (mDirtyStore.mValidFlags[aChangeStoreCursor] && (dirtyPath.mTraitDataHandle == aTargetDataHandle) &&
+            IsChangeAfter(mDirtyStore.mChangeSeqs[aChangeStoreCursor], aChangeCursor))
         {
             candidateHandle          = dirtyPath.mPropertyPathHandle;
             aCandidateHandleIsDelete = false;
@@ -366,7 +442,8 @@ PropertyPathHandle NotificationEngine::IntermediateGraphSolver::GetNextCandidate
         TraitPath deletePath = mDeleteStore.mStore[aChangeStoreCursor - mDirtyStore.GetStoreSize()];
 
         if (mDeleteStore.mValidFlags[aChangeStoreCursor - mDirtyStore.GetStoreSize()] &&
-            (deletePath.mTraitDataHandle == aTargetDataHandle))
+            (deletePath.mTraitDataHandle == aTargetDataHandle) &&
+            IsChangeAfter(mDeleteStore.mChangeSeqs[aChangeStoreCursor - mDirtyStore.GetStoreSize()], aChangeCursor))
         {
             candidateHandle          = deletePath.mPropertyPathHandle;
             aCandidateHandleIsDelete = true;
@@ -383,7 +460,8 @@ PropertyPathHandle NotificationEngine::IntermediateGraphSolver::GetNextCandidate
 
 WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::RetrieveTraitInstanceData(NotifyRequestBuilder * aBuilder,
                                                                                    TraitDataHandle aTraitDataHandle,
-                                                                                   SchemaVersion aSchemaVersion, bool aRetrieveAll)
+                                                                                   SchemaVersion aSchemaVersion, bool aRetrieveAll,
+                                                                                   uint32_t aChangeCursor)
 {
     WEAVE_ERROR err;
     PropertyPathHandle mergeHandleSet[WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET]  = { kNullPropertyPathHandle };
@@ -412,8 +490,8 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::RetrieveTraitInstanceDa
         WeaveLogDetail(DataManagement, "<ISolver::Retr> Retrieving all!");
         currentCommonHandle = kRootPropertyPathHandle;
     }
-    // If the data source as a whole has been marked dirty, our job here is done
-    else if (dataSource->IsRootDirty())
+    // If the data source as a whole has been marked dirty since this subscription last notified it, our job here is done
+    else if (dataSource->IsRootDirty() && IsChangeAfter(dataSource->GetRootDirtyChangeSeq(), aChangeCursor))
     {
         WeaveLogDetail(DataManagement, "<ISolver::Retr> Root is dirty!");
         currentCommonHandle = kRootPropertyPathHandle;
@@ -468,7 +546,7 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::RetrieveTraitInstanceDa
         //      mergeHandleSet = set of handles that will be merged in relative to the currentCommonHandle. If empty, all children
         //                   under the commonHandle will be included.
         //
-        while ((candidateHandle = GetNextCandidateHandle(changeStoreCursor, aTraitDataHandle, candidateHandleIsDelete)) !=
+        while ((candidateHandle = GetNextCandidateHandle(changeStoreCursor, aTraitDataHandle, aChangeCursor, candidateHandleIsDelete)) !=
                kNullPropertyPathHandle)
         {
             oldCandidateHandleIsDelete = candidateHandleIsDelete;
@@ -710,6 +788,7 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::ClearDirty()
 {
     // Iterate over every publisher trait instance and clear their dirty field.
     SubscriptionEngine::GetInstance()->mPublisherCatalog->Iterate(ClearTraitInstanceDirty, this);
+    mNumRootDirtyTraitInstances = 0;
 
     // Clear out our granular dirty store.
     mDirtyStore.Clear();
@@ -721,6 +800,117 @@ WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::ClearDirty()
     return WEAVE_NO_ERROR;
 }
 
+/**
+ * Returns the change cursor of the subscription that has fallen furthest behind on the given trait instance, or the current change
+ * sequence number if no active subscription covers it.
+ */
+uint32_t NotificationEngine::IntermediateGraphSolver::GetOldestChangeCursor(TraitDataHandle aTraitDataHandle) const
+{
+    SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
+    uint32_t oldestCursor          = mChangeSeq;
+
+    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; ++i)
+    {
+        SubscriptionHandler * subHandler = &subEngine->mHandlers[i];
+
+        if (subHandler->IsActive())
+        {
+            SubscriptionHandler::TraitInstanceInfo * traitInstance = subHandler->GetTraitInstanceInfoList();
+
+            for (size_t j = 0; j < subHandler->GetNumTraitInstances(); j++)
+            {
+                if ((traitInstance[j].mTraitDataHandle == aTraitDataHandle) &&
+                    IsChangeAfter(oldestCursor, traitInstance[j].mChangeCursor))
+                {
+                    oldestCursor = traitInstance[j].mChangeCursor;
+                }
+            }
+        }
+    }
+
+    return oldestCursor;
+}
+
+void NotificationEngine::IntermediateGraphSolver::TrimStore(Store & aStore)
+{
+    for (size_t i = 0; i < aStore.GetStoreSize(); i++)
+    {
+        if (aStore.mValidFlags[i] &&
+            !IsChangeAfter(aStore.mChangeSeqs[i], GetOldestChangeCursor(aStore.mStore[i].mTraitDataHandle)))
+        {
+            aStore.RemoveItemAt(i);
+        }
+    }
+}
+
+void NotificationEngine::IntermediateGraphSolver::TrimTraitInstanceDirty(void * aDataSource, TraitDataHandle aDataHandle,
+                                                                         void * aContext)
+{
+    TraitDataSource * dataSource         = static_cast<TraitDataSource *>(aDataSource);
+    IntermediateGraphSolver * graphSolver = static_cast<IntermediateGraphSolver *>(aContext);
+
+    if (dataSource->IsRootDirty())
+    {
+        if (IsChangeAfter(dataSource->GetRootDirtyChangeSeq(), graphSolver->GetOldestChangeCursor(aDataHandle)))
+        {
+            graphSolver->mNumRootDirtyTraitInstances++;
+        }
+        else
+        {
+            dataSource->ClearRootDirty();
+        }
+    }
+}
+
+/**
+ * Drop the changes that every active subscription has already notified. Unlike ClearDirty(), this does not require all
+ * subscriptions to be clean at the same time, so a subscription that lags behind only retains the changes it has yet to send.
+ */
+WEAVE_ERROR NotificationEngine::IntermediateGraphSolver::TrimChanges()
+{
+    SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
+
+    // Nothing to reclaim, so there is no need to visit the subscriptions.
+#if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+    VerifyOrExit(mDirtyStore.GetNumItems() != 0 || mDeleteStore.GetNumItems() != 0 || mNumRootDirtyTraitInstances != 0, );
+#else
+    VerifyOrExit(mDirtyStore.GetNumItems() != 0 || mNumRootDirtyTraitInstances != 0, );
+#endif
+
+    // A trait instance that is not dirty for a subscription has nothing left to notify, so its cursor can be brought up to date.
+    // While a NotifyRequest is in flight, the cursors wait for it to be acknowledged.
+    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; ++i)
+    {
+        SubscriptionHandler * subHandler = &subEngine->mHandlers[i];
+
+        if (subHandler->IsActive() && !subHandler->IsNotifying())
+        {
+            SubscriptionHandler::TraitInstanceInfo * traitInstance = subHandler->GetTraitInstanceInfoList();
+
+            for (size_t j = 0; j < subHandler->GetNumTraitInstances(); j++)
+            {
+                if (!traitInstance[j].IsDirty())
+                {
+                    traitInstance[j].SetChangeCursor(mChangeSeq);
+                }
+            }
+        }
+    }
+
+    TrimStore(mDirtyStore);
+
+#if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
+    TrimStore(mDeleteStore);
+#endif
+
+    // Recounted as the root dirty trait instances are visited.
+    mNumRootDirtyTraitInstances = 0;
+    subEngine->mPublisherCatalog->Iterate(TrimTraitInstanceDirty, this);
+
+exit:
+    return WEAVE_NO_ERROR;
+}
+
 void NotificationEngine::IntermediateGraphSolver::Store::Clear()
 {
     mNumItems = 0;
@@ -1030,14 +1220,93 @@ WEAVE_ERROR NotificationEngine::NotifyRequestBuilder::Rollback(TLVWriter & aPoin
 
 WEAVE_ERROR NotificationEngine::Init()
 {
-    mCurSubscriptionHandlerIdx = 0;
-    mCurTraitInstanceIdx       = 0;
-    mNumNotifiesInFlight       = 0;
-    mNotifyTxEnabled           = true;
+    mCurTraitInstanceIdx = 0;
+    mNumNotifiesInFlight = 0;
+    mNotifyTxEnabled     = true;
+    mReadyQueueHead      = 0;
+    mNumReadyHandlers    = 0;
+    memset(mIsHandlerReady, 0, sizeof(mIsHandlerReady));
+
+#if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+    memset(mLastScheduledEventIds, 0, sizeof(mLastScheduledEventIds));
+#endif // WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
 
     return WEAVE_NO_ERROR;
 }
 
+/**
+ * Queue a subscription handler to be evaluated on the next run of the engine, unless it is already queued. This should be called
+ * with the subscription engine lock held whenever the handler might have gained work to do.
+ */
+void NotificationEngine::ScheduleHandler(SubscriptionHandler * aSubHandler)
+{
+    uint16_t handlerId = SubscriptionEngine::GetInstance()->GetHandlerId(aSubHandler);
+
+    if (!mIsHandlerReady[handlerId])
+    {
+        mReadyQueue[(mReadyQueueHead + mNumReadyHandlers) % SubscriptionEngine::kMaxNumSubscriptionHandlers] = handlerId;
+        mIsHandlerReady[handlerId] = true;
+        mNumReadyHandlers++;
+    }
+}
+
+SubscriptionHandler * NotificationEngine::DequeueReadyHandler(void)
+{
+    uint16_t handlerId;
+
+    if (mNumReadyHandlers == 0)
+    {
+        return NULL;
+    }
+
+    handlerId                  = mReadyQueue[mReadyQueueHead];
+    mReadyQueueHead            = (mReadyQueueHead + 1) % SubscriptionEngine::kMaxNumSubscriptionHandlers;
+    mIsHandlerReady[handlerId] = false;
+    mNumReadyHandlers--;
+
+    return SubscriptionEngine::GetInstance()->mHandlers + handlerId;
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+/**
+ * If events have been logged since the last time this was called, queue every handler that is subscribed to events.
+ */
+void NotificationEngine::ScheduleEventSubscribers(void)
+{
+    LoggingManagement & logger = LoggingManagement::GetInstance();
+    SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
+    bool newEvents = false;
+
+    VerifyOrExit(logger.IsValid(), /* no-op */);
+
+    for (int i = 0; i < kImportanceType_Last - kImportanceType_First + 1; i++)
+    {
+        event_id_t eid = logger.GetLastEventID(static_cast<ImportanceType>(i + kImportanceType_First));
+
+        if (eid != mLastScheduledEventIds[i])
+        {
+            mLastScheduledEventIds[i] = eid;
+            newEvents                 = true;
+        }
+    }
+
+    VerifyOrExit(newEvents, /* no-op */);
+
+    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; ++i)
+    {
+        SubscriptionHandler * subHandler = &subEngine->mHandlers[i];
+
+        if (subHandler->IsNotifiable() && subHandler->mSubscribeToAllEvents)
+        {
+            ScheduleHandler(subHandler);
+        }
+    }
+
+exit:
+    return;
+}
+#endif // WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+
 #if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
 WEAVE_ERROR NotificationEngine::DeleteKey(TraitDataSource * aDataSource, PropertyPathHandle aPropertyHandle)
 {
@@ -1103,11 +1372,11 @@ WEAVE_ERROR NotificationEngine::RetrieveTraitInstanceData(SubscriptionHandler *
     *aPacketFull = false;
 
     err = mGraphSolver.RetrieveTraitInstanceData(aBuilder, aTraitInfo->mTraitDataHandle, aTraitInfo->mRequestedVersion,
-                                                 aSubHandler->IsSubscribing());
+                                                 aSubHandler->IsSubscribing(), aTraitInfo->mChangeCursor);
     SuccessOrExit(err);
 
     // Clear out the dirty bit since we're done processing this trait instance.
-    aTraitInfo->ClearDirty();
+    MarkTraitInstanceClean(aTraitInfo);
 
 exit:
     if ((err == WEAVE_ERROR_BUFFER_TOO_SMALL) || (err == WEAVE_ERROR_NO_MEMORY))
@@ -1119,6 +1388,40 @@ exit:
     return err;
 }
 
+void NotificationEngine::MarkTraitInstanceClean(SubscriptionHandler::TraitInstanceInfo * aTraitInfo)
+{
+    // Everything changed up to now has either been written out for this subscription or been abandoned. The change cursor only
+    // advances once the NotifyRequest carrying it has been acknowledged.
+    aTraitInfo->ClearDirty();
+    aTraitInfo->mPendingChangeCursor = mGraphSolver.GetCurrentChangeSeq();
+}
+
+/**
+ * Advance the change cursors of the trait instances written into the NotifyRequest that was in flight for the given subscription
+ * if the subscriber acknowledged it. Otherwise roll them back and mark the trait instances dirty again, so that the changes are
+ * retained by the graph solver and sent once more should the subscription continue.
+ */
+void NotificationEngine::UpdateChangeCursors(SubscriptionHandler * aSubHandler, bool aNotifyDelivered)
+{
+    SubscriptionHandler::TraitInstanceInfo * traitInstance = aSubHandler->GetTraitInstanceInfoList();
+
+    for (size_t i = 0; i < aSubHandler->GetNumTraitInstances(); i++)
+    {
+        if (traitInstance[i].mPendingChangeCursor != traitInstance[i].mChangeCursor)
+        {
+            if (aNotifyDelivered)
+            {
+                traitInstance[i].mChangeCursor = traitInstance[i].mPendingChangeCursor;
+            }
+            else
+            {
+                traitInstance[i].mPendingChangeCursor = traitInstance[i].mChangeCursor;
+                traitInstance[i].SetDirty();
+            }
+        }
+    }
+}
+
 WEAVE_ERROR NotificationEngine::SendNotify(PacketBuffer * aBuffer, SubscriptionHandler * aSubHandler)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -1144,6 +1447,8 @@ void NotificationEngine::OnNotifyConfirm(SubscriptionHandler * aSubHandler, bool
     WeaveLogDetail(DataManagement, "<NE> OnNotifyConfirm: NumNotifies-- = %d", mNumNotifiesInFlight - 1);
     mNumNotifiesInFlight--;
 
+    UpdateChangeCursors(aSubHandler, aNotifyDelivered);
+
     if (aNotifyDelivered && aSubHandler->mSubscribeToAllEvents)
     {
         LoggingManagement & logger = LoggingManagement::GetInstance();
@@ -1456,7 +1761,7 @@ WEAVE_ERROR NotificationEngine::BuildSingleNotifyRequestDataList(SubscriptionHan
                 if (!aNeWriteInProgress)
                 {
                     WeaveLogDetail(DataManagement, "<NE:Run> trait property is too big so that it fails to fit in the packet");
-                    traitInfo->ClearDirty();
+                    MarkTraitInstanceClean(traitInfo);
                 }
                 else
                 {
@@ -1621,6 +1926,9 @@ exit:
     // On any error, abort the subscription, and consider it handled.
     if (err != WEAVE_NO_ERROR)
     {
+        // Nothing written out was delivered.
+        UpdateChangeCursors(aSubHandler, false);
+
         // abort subscription, squash error, signal to upper
         // layers that the subscription is done
         aSubHandler->TerminateSubscription(err, NULL, false);
@@ -1754,12 +2062,11 @@ void NotificationEngine::ScheduleRun()
 
 void NotificationEngine::Run()
 {
-    WEAVE_ERROR err                  = WEAVE_NO_ERROR;
-    uint32_t numSubscriptionsHandled = 0;
-    SubscriptionEngine * subEngine   = SubscriptionEngine::GetInstance();
-    SubscriptionHandler * subHandler = subEngine->mHandlers + mCurSubscriptionHandlerIdx;
+    WEAVE_ERROR err                = WEAVE_NO_ERROR;
+    uint32_t numHandlersToVisit    = 0;
+    SubscriptionEngine * subEngine = SubscriptionEngine::GetInstance();
+    SubscriptionHandler * subHandler;
     bool subscriptionHandled, isSubscriptionClean;
-    bool isClean  = true;
     bool isLocked = false;
 
 
@@ -1772,80 +2079,54 @@ void NotificationEngine::Run()
 
     isLocked = true;
 
-    WeaveLogDetail(DataManagement, "<NE:Run> NotifiesInFlight = %u", mNumNotifiesInFlight);
+#if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+    ScheduleEventSubscribers();
+#endif // WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+
+    WeaveLogDetail(DataManagement, "<NE:Run> NotifiesInFlight = %u, ReadyHandlers = %u", mNumNotifiesInFlight, mNumReadyHandlers);
+
+    // Give every handler that was ready at the start of this run one turn. Handlers that still have work left afterwards are queued
+    // again behind the others and picked up on a later run.
+    numHandlersToVisit = mNumReadyHandlers;
 
-    while ((mNumNotifiesInFlight < WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT) &&
-           (numSubscriptionsHandled < SubscriptionEngine::kMaxNumSubscriptionHandlers))
+    while ((mNumNotifiesInFlight < WDM_PUBLISHER_MAX_NOTIFIES_IN_FLIGHT) && (numHandlersToVisit > 0))
     {
-        subscriptionHandled = true;
+        numHandlersToVisit--;
+        subHandler = DequeueReadyHandler();
 
-        // limit the prints to handlers that are in meaingful subscribing/notifying states.
-        if (subHandler->IsNotifying() || subHandler->IsSubscribing())
+        // Handlers that are not notifiable at the moment are queued again when they get back to a notifiable state.
+        if (!subHandler->IsNotifiable())
         {
-            WeaveLogDetail(DataManagement, "<NE:Run> Eval Subscription: %u (state = %s, num-traits = %u)!",
-                           mCurSubscriptionHandlerIdx, subHandler->GetStateStr(), subHandler->GetNumTraitInstances());
+            continue;
         }
 
-        if (subHandler->IsNotifiable())
-        {
-            // This is needed because some error could trigger abort on subscription, which leads to destroy of the handler
-            subHandler->_AddRef();
-            err = BuildSingleNotifyRequest(subHandler, subscriptionHandled, isSubscriptionClean);
-            SuccessOrExit(err);
+        WeaveLogDetail(DataManagement, "<NE:Run> Eval Subscription: %u (state = %s, num-traits = %u)!",
+                       subEngine->GetHandlerId(subHandler), subHandler->GetStateStr(), subHandler->GetNumTraitInstances());
 
-            if (isSubscriptionClean)
-            {
-                // TODO: notification based on the event list state.
-                subHandler->OnNotifyProcessingComplete(false, NULL, 0);
-            }
-            subHandler->_Release();
-        }
+        subscriptionHandled = true;
 
-        if (subscriptionHandled)
+        // This is needed because some error could trigger abort on subscription, which leads to destroy of the handler
+        subHandler->_AddRef();
+        err = BuildSingleNotifyRequest(subHandler, subscriptionHandled, isSubscriptionClean);
+        SuccessOrExit(err);
+
+        if (isSubscriptionClean)
         {
-            numSubscriptionsHandled++;
+            // TODO: notification based on the event list state.
+            subHandler->OnNotifyProcessingComplete(false, NULL, 0);
         }
         else
         {
-            WeaveLogDetail(DataManagement, "<NE:Run> Subscription %u not handled", mCurSubscriptionHandlerIdx);
-            numSubscriptionsHandled = 0;
+            WeaveLogDetail(DataManagement, "<NE:Run> Subscription %u not %s", subEngine->GetHandlerId(subHandler),
+                           subscriptionHandled ? "clean" : "handled");
+            ScheduleHandler(subHandler);
         }
-
-        mCurSubscriptionHandlerIdx = (mCurSubscriptionHandlerIdx + 1) % SubscriptionEngine::kMaxNumSubscriptionHandlers;
-        subHandler                 = subEngine->mHandlers + mCurSubscriptionHandlerIdx;
+        subHandler->_Release();
     }
 
-    subHandler = subEngine->mHandlers;
-    isClean    = true;
-
-    // We only wipe our granular dirty stores if all the subscriptions are clean. To do so, we iterate over
-    // all of them and check each of their dirty flags.
-    for (int i = 0; i < SubscriptionEngine::kMaxNumSubscriptionHandlers; i++)
-    {
-        if (subHandler->IsActive())
-        {
-            SubscriptionHandler::TraitInstanceInfo * traitInfo = subHandler->GetTraitInstanceInfoList();
-            for (size_t j = 0; j < subHandler->GetNumTraitInstances(); j++)
-            {
-                if (traitInfo->IsDirty())
-                {
-                    WeaveLogDetail(DataManagement, "<NE:Run> S%u:T%u still dirty", i, j);
-                    isClean = false;
-                    break;
-                }
-
-                traitInfo++;
-            }
-        }
-
-        subHandler++;
-    }
-
-    if (isClean)
-    {
-        WeaveLogDetail(DataManagement, "<NE> Done processing!");
-        mGraphSolver.ClearDirty();
-    }
+    // Drop the granular changes that every subscription has already notified. Subscriptions that are still dirty only hold on to
+    // the changes they have yet to send, and no longer prevent the changes already sent by the others from being reclaimed.
+    mGraphSolver.TrimChanges();
 
 exit:
     if (isLocked)
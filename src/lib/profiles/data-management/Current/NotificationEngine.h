@@ -92,8 +92,11 @@ public:
  *
  *         Some notable features:
  *
- *         - Subscription fairness: The engine round-robins over all subscriptions and will always resume its work loop at the last
- *           subscription it was trying to process to ensure all subscriptions are handled with equal priority.
+ *         - Subscription fairness: The engine keeps a FIFO ready queue of the subscriptions that may have work to do (dirty trait
+ *           instances, pending events or an outstanding subscribe response). Subscriptions are queued as data is marked dirty, as
+ *           events are logged and as they return to a notifiable state, and a subscription that still has work left after its turn
+ *           is queued again behind the others. Idle subscriptions are never visited, so the cost of a run scales with the number of
+ *           subscriptions that have work rather than with the number of subscriptions.
  *
  *         - Trait instance fairness: Within a subscription, the engine also rounds robins over all trait instances and will resume
  *           its work loop at the last trait instance that was being processed *for that subscription*. This ensures trait instances
@@ -325,9 +328,11 @@ public:
     public:
         static bool IsPropertyPathSupported(PropertyPathHandle aHandle);
         WEAVE_ERROR RetrieveTraitInstanceData(NotifyRequestBuilder * aBuilder, TraitDataHandle aTraitDataHandle,
-                                              SchemaVersion aSchemaVersion, bool aRetrieveAll);
+                                              SchemaVersion aSchemaVersion, bool aRetrieveAll, uint32_t aChangeCursor);
         static WEAVE_ERROR SetDirty(TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyHandle);
         WEAVE_ERROR ClearDirty(void);
+        WEAVE_ERROR TrimChanges(void);
+        uint32_t GetCurrentChangeSeq(void) const { return 0; }
     };
 
     /*
@@ -344,13 +349,21 @@ public:
      *         instance as dirty. In addition, if it runs out of space in the merge handle set, it will degrade to including all
      *         child trees of the LCA'ed node.
      *
+     *         Every item in the store is stamped with a monotonically increasing change sequence number, and each subscription
+     *         remembers the sequence number it last notified for every trait instance (its change cursor). A subscription is only
+     *         sent the items changed since its own cursor, and items are only dropped from the store once every subscription to
+     *         the trait instance has moved past them. A subscription that lags behind therefore no longer forces the others to
+     *         re-send data they have already delivered.
+     *
      */
     class IntermediateGraphSolver
     {
     public:
+        IntermediateGraphSolver(void);
+
         static bool IsPropertyPathSupported(PropertyPathHandle aHandle);
         WEAVE_ERROR RetrieveTraitInstanceData(NotifyRequestBuilder * aBuilder, TraitDataHandle aTraitDataHandle,
-                                              SchemaVersion aSchemaVersion, bool aRetrieveAll);
+                                              SchemaVersion aSchemaVersion, bool aRetrieveAll, uint32_t aChangeCursor);
         WEAVE_ERROR SetDirty(TraitDataHandle aTraitDataHandle, PropertyPathHandle aPropertyHandle);
 
 #if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
@@ -358,30 +371,40 @@ public:
 #endif
 
         WEAVE_ERROR ClearDirty(void);
+        WEAVE_ERROR TrimChanges(void);
+        uint32_t GetCurrentChangeSeq(void) const { return mChangeSeq; }
 
         struct Store
         {
         public:
             Store();
-            bool AddItem(TraitPath aItem);
+            bool AddItem(TraitPath aItem, uint32_t aChangeSeq);
             void RemoveItem(TraitDataHandle aDataHandle);
             void RemoveItemAt(uint32_t aIndex);
             bool IsPresent(TraitPath aItem);
+            bool UpdateItem(TraitPath aItem, uint32_t aChangeSeq);
             bool IsFull() { return mNumItems >= WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE; }
             uint32_t GetNumItems() { return mNumItems; }
             uint32_t GetStoreSize() { return WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE; }
             void Clear();
 
             TraitPath mStore[WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE];
+            uint32_t mChangeSeqs[WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE];
             bool mValidFlags[WDM_PUBLISHER_MAX_ITEMS_IN_TRAIT_DIRTY_STORE];
             uint32_t mNumItems;
         };
 
     private:
         static void ClearTraitInstanceDirty(void * aDataSource, TraitDataHandle aDataHandle, void * aContext);
+        static void TrimTraitInstanceDirty(void * aDataSource, TraitDataHandle aDataHandle, void * aContext);
         PropertyPathHandle GetNextCandidateHandle(uint32_t & aChangeStoreCursor, TraitDataHandle aTargetDataHandle,
-                                                  bool & aCandidateHandleIsDelete);
+                                                  uint32_t aChangeCursor, bool & aCandidateHandleIsDelete);
+        uint32_t NextChangeSeq(void);
+        uint32_t GetOldestChangeCursor(TraitDataHandle aTraitDataHandle) const;
+        void TrimStore(Store & aStore);
 
+        uint32_t mChangeSeq;
+        uint32_t mNumRootDirtyTraitInstances;
         Store mDirtyStore;
 
 #if TDM_ENABLE_PUBLISHER_DICTIONARY_SUPPORT
@@ -413,6 +436,13 @@ private:
 
     WEAVE_ERROR RetrieveTraitInstanceData(SubscriptionHandler * aSubHandler, SubscriptionHandler::TraitInstanceInfo * aTraitInfo,
                                           NotifyRequestBuilder * aBuilder, bool * aPacketFull);
+    void MarkTraitInstanceClean(SubscriptionHandler::TraitInstanceInfo * aTraitInfo);
+    void UpdateChangeCursors(SubscriptionHandler * aSubHandler, bool aNotifyDelivered);
+    void ScheduleHandler(SubscriptionHandler * aSubHandler);
+    SubscriptionHandler * DequeueReadyHandler(void);
+#if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+    void ScheduleEventSubscribers(void);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
     WEAVE_ERROR SendNotify(PacketBuffer * aBuf, SubscriptionHandler * aSubHandler);
 
     WEAVE_ERROR SendNotifyRequest();
@@ -423,10 +453,21 @@ private:
     WEAVE_ERROR BuildSubscriptionlessNotification(PacketBuffer *msgBuf, uint32_t maxPayloadSize, TraitPath *aPathList,
                                                   uint16_t aPathListSize);
 #endif // WDM_ENABLE_SUBSCRIPTIONLESS_NOTIFICATION
-    uint32_t mCurSubscriptionHandlerIdx;
     uint32_t mCurTraitInstanceIdx;
     uint32_t mNumNotifiesInFlight;
     bool     mNotifyTxEnabled;
+
+    // Subscription handlers that may have data or events to notify, in the order in which they became ready. The queue is a
+    // circular buffer of handler indices; a handler appears in it at most once.
+    uint16_t mReadyQueue[WDM_MAX_NUM_SUBSCRIPTION_HANDLERS];
+    bool     mIsHandlerReady[WDM_MAX_NUM_SUBSCRIPTION_HANDLERS];
+    uint16_t mReadyQueueHead;
+    uint16_t mNumReadyHandlers;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
+    // Last event IDs seen in the log when event subscribers were last scheduled.
+    event_id_t mLastScheduledEventIds[kImportanceType_Last - kImportanceType_First + 1];
+#endif // WEAVE_CONFIG_EVENT_LOGGING_WDM_OFFLOAD
     nl::Weave::TLV::TLVType mOuterContainerType;
     WEAVE_CONFIG_WDM_PUBLISHER_GRAPH_SOLVER mGraphSolver;
 };
@@ -368,6 +368,8 @@ WEAVE_ERROR SubscriptionHandler::ParsePathVersionEventLists(SubscribeRequest::Pa
                 SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kWDM_NumTraits);
 
                 traitInstance->Init();
+                traitInstance->SetChangeCursor(
+                    SubscriptionEngine::GetInstance()->GetNotificationEngine()->mGraphSolver.GetCurrentChangeSeq());
             }
             else
             {
@@ -1519,6 +1521,15 @@ void SubscriptionHandler::MoveToState(const HandlerState aTargetState)
     WeaveLogDetail(DataManagement, "Handler[%u] Moving to [%5.5s] Ref(%d)", SubscriptionEngine::GetInstance()->GetHandlerId(this),
                    GetStateStr(), mRefCount);
 
+    // Whenever the handler gets (back) to a state where it can send notifies, it may have work pending that was held back while
+    // it was busy, or a subscribe response to send. Queue it so that the notification engine evaluates it on its next run.
+    if (IsNotifiable())
+    {
+        SubscriptionEngine::GetInstance()->Lock();
+        SubscriptionEngine::GetInstance()->GetNotificationEngine()->ScheduleHandler(this);
+        SubscriptionEngine::GetInstance()->Unlock();
+    }
+
 #if WEAVE_DETAIL_LOGGING
     if (kState_Free == mCurrentState)
     {
@@ -1966,6 +1977,8 @@ WEAVE_ERROR SubscriptionHandler::LoadTraitInstances(TLVReader & reader)
             SYSTEM_STATS_INCREMENT(nl::Weave::System::Stats::kWDM_NumTraits);
 
             traitInstance->Init();
+            traitInstance->SetChangeCursor(
+                SubscriptionEngine::GetInstance()->GetNotificationEngine()->mGraphSolver.GetCurrentChangeSeq());
         }
         else
         {
@@ -55,14 +55,19 @@ public:
 
     struct TraitInstanceInfo
     {
-        void Init(void) { this->ClearDirty(); }
+        void Init(void) { this->ClearDirty(); this->SetChangeCursor(0); }
         bool IsDirty(void) { return mDirty; }
         void SetDirty(void) { mDirty = true; }
         void ClearDirty(void) { mDirty = false; }
+        void SetChangeCursor(uint32_t aChangeSeq) { mChangeCursor = mPendingChangeCursor = aChangeSeq; }
 
         TraitDataHandle mTraitDataHandle;
         uint16_t mRequestedVersion;
         bool mDirty;
+        // Change sequence number of the graph solver up to which the subscriber has acknowledged this trait instance
+        uint32_t mChangeCursor;
+        // Change sequence number that mChangeCursor advances to once the NotifyRequest in flight is acknowledged
+        uint32_t mPendingChangeCursor;
     };
 
     enum EventID
@@ -925,11 +925,13 @@ public:
 
 #if (WEAVE_CONFIG_WDM_PUBLISHER_GRAPH_SOLVER == IntermediateGraphSolver)
     /* Set of functions to be called by the intermediate graph solver on the notification engine for marking/clearing this entire
-     * data source as dirty */
-    void SetRootDirty(void) { mRootIsDirty = true; }
-    void ClearRootDirty(void) { mRootIsDirty = false; }
-    bool IsRootDirty(void) const { return mRootIsDirty; }
-    bool mRootIsDirty;
+     * data source as dirty. The solver records the change sequence number at which the root was last dirtied so that each
+     * subscription can tell whether it has already notified the entire trait instance since then; zero means clean. */
+    void SetRootDirty(uint32_t aChangeSeq) { mRootDirtyChangeSeq = aChangeSeq; }
+    void ClearRootDirty(void) { mRootDirtyChangeSeq = 0; }
+    bool IsRootDirty(void) const { return mRootDirtyChangeSeq != 0; }
+    uint32_t GetRootDirtyChangeSeq(void) const { return mRootDirtyChangeSeq; }
+    uint32_t mRootDirtyChangeSeq;
 #endif
 
     // Set current version of the data in this source.
@@ -147,7 +147,7 @@ WEAVE_ERROR WeaveCASEEngine::GenerateBeginSessionRequest(BeginSessionRequestCont
     VerifyOrExit(WeaveKeyId::IsSessionKey(reqCtx.SessionKeyId), err = WEAVE_ERROR_WRONG_KEY_TYPE);
 
     // Verify the requested encryption type.
-    VerifyOrExit(reqCtx.EncryptionType == kWeaveEncryptionType_AES128CTRSHA1,
+    VerifyOrExit(IsSupportedSessionEncryptionType(reqCtx.EncryptionType),
             err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
 
     // Record that we are acting as the initiator.
@@ -245,7 +245,7 @@ WEAVE_ERROR WeaveCASEEngine::ProcessBeginSessionRequest(PacketBuffer * msgBuf, B
     VerifyOrExit(WeaveKeyId::IsSessionKey(reqCtx.SessionKeyId), err = WEAVE_ERROR_WRONG_KEY_TYPE);
 
     // Verify the requested encryption type.
-    VerifyOrExit(reqCtx.EncryptionType == kWeaveEncryptionType_AES128CTRSHA1,
+    VerifyOrExit(IsSupportedSessionEncryptionType(reqCtx.EncryptionType),
                  err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
 
     State = kState_BeginRequestProcessed;
@@ -879,8 +879,8 @@ WEAVE_ERROR WeaveCASEEngine::DeriveSessionKeys(EncodedECPublicKey & pubKey, cons
 
     WeaveLogDetail(SecurityManager, "CASE:DeriveSessionKeys");
 
-    // Only AES128CTRSHA1 keys supported for now.
-    VerifyOrExit(EncryptionType == kWeaveEncryptionType_AES128CTRSHA1, err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
+    // Verify the session encryption type.
+    VerifyOrExit(IsSupportedSessionEncryptionType(EncryptionType), err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
 
     // Prepare a salt value to be used in the generation of the master key. The salt value
     // is composed from the hashes of the signed portions of the CASE request and response
@@ -930,14 +930,15 @@ WEAVE_ERROR WeaveCASEEngine::DeriveSessionKeys(EncodedECPublicKey & pubKey, cons
     // Derive the session keys from the master key...
     {
         uint8_t sessionKeyData[WeaveEncryptionKey_AES128CTRSHA1::KeySize + kMaxHashLength];
+        uint16_t encKeyLen = SessionEncryptionKeySize(EncryptionType);
         uint16_t keyLen;
 
         // If performing key confirmation, arrange to generate enough key data for the session
         // keys (data encryption and integrity) as well as a key to be used in key confirmation.
         if (PerformingKeyConfirm())
-            keyLen = WeaveEncryptionKey_AES128CTRSHA1::KeySize + hashLen;
+            keyLen = encKeyLen + hashLen;
         else
-            keyLen = WeaveEncryptionKey_AES128CTRSHA1::KeySize;
+            keyLen = encKeyLen;
 
         // Perform HKDF-based key expansion to produce the desired key data.
         err = hkdf.ExpandKey(NULL, 0, keyLen, sessionKeyData);
@@ -948,12 +949,7 @@ WEAVE_ERROR WeaveCASEEngine::DeriveSessionKeys(EncodedECPublicKey & pubKey, cons
 #endif
 
         // Copy the generated key data to the appropriate destinations.
-        memcpy(mSecureState.AfterKeyGen.EncryptionKey.AES128CTRSHA1.DataKey,
-               sessionKeyData,
-               WeaveEncryptionKey_AES128CTRSHA1::DataKeySize);
-        memcpy(mSecureState.AfterKeyGen.EncryptionKey.AES128CTRSHA1.IntegrityKey,
-               sessionKeyData + WeaveEncryptionKey_AES128CTRSHA1::DataKeySize,
-               WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
+        SetSessionEncryptionKey(EncryptionType, sessionKeyData, mSecureState.AfterKeyGen.EncryptionKey);
 
         // If performing key confirmation...
         if (PerformingKeyConfirm())
@@ -961,7 +957,7 @@ WEAVE_ERROR WeaveCASEEngine::DeriveSessionKeys(EncodedECPublicKey & pubKey, cons
             // Use the key confirmation key to generate key confirmation hashes. Store the initiator hash
             // (the single hash) in state data for later use.  Return the responder hash (the double hash)
             // to the caller.
-            uint8_t *keyConfirmKey = sessionKeyData + WeaveEncryptionKey_AES128CTRSHA1::KeySize;
+            uint8_t *keyConfirmKey = sessionKeyData + encKeyLen;
             GenerateKeyConfirmHashes(keyConfirmKey, mSecureState.AfterKeyGen.InitiatorKeyConfirmHash,
                                      responderKeyConfirmHash);
         }
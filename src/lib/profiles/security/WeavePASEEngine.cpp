@@ -941,7 +941,7 @@ WEAVE_ERROR WeavePASEEngine::ProcessInitiatorStep1(PacketBuffer *buf, uint64_t l
     VerifyOrExit(WeaveKeyId::IsSessionKey(SessionKeyId), err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
 
     // Verify the requested encryption type.
-    VerifyOrExit(EncryptionType == kWeaveEncryptionType_AES128CTRSHA1, err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
+    VerifyOrExit(IsSupportedSessionEncryptionType(EncryptionType), err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
 
     // Read and Decode the size header field.
     sizeHeader = LittleEndian::Read32(p);
@@ -1984,10 +1984,12 @@ WEAVE_ERROR WeavePASEEngine::DeriveKeys(const uint8_t *initiatorStep2ZKPXGRHash,
         uint8_t keySalt[2 * kStep2ZKPXGRHashLengthMax];
         uint8_t sessionKeyData[WeaveEncryptionKey_AES128CTRSHA1::KeySize + kKeyConfirmKeyLengthMax];
     };
+    uint16_t encKeyLen;
     uint16_t keyLen;
 
-    // Only AES128CTRSHA1 keys supported for now.
-    VerifyOrExit(EncryptionType == kWeaveEncryptionType_AES128CTRSHA1, err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
+    // Verify the session encryption type.
+    VerifyOrExit(IsSupportedSessionEncryptionType(EncryptionType), err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE);
+    encKeyLen = SessionEncryptionKeySize(EncryptionType);
 
     // Produce a salt value to be used in generating a master key. The salt is constructed by concatenating the
     // ZKP g^r value for x2*s (generated by the initiator in round 2) and the ZKP g^r value for x4*s (generated
@@ -2043,7 +2045,7 @@ WEAVE_ERROR WeavePASEEngine::DeriveKeys(const uint8_t *initiatorStep2ZKPXGRHash,
     // Derive the session keys from the master key...
     // If performing key confirmation, arrange to generate enough key data for the session
     // keys (data encryption and integrity) as well as a key to be used in key confirmation.
-    keyLen = WeaveEncryptionKey_AES128CTRSHA1::KeySize + keyConfirmKeyLength;
+    keyLen = encKeyLen + keyConfirmKeyLength;
 
     // Perform HKDF-based key expansion to produce the desired key data.
     err = hkdf.ExpandKey(NULL, 0, keyLen, sessionKeyData);
@@ -2054,15 +2056,9 @@ WEAVE_ERROR WeavePASEEngine::DeriveKeys(const uint8_t *initiatorStep2ZKPXGRHash,
 #endif
 
     // Copy the generated key data to the appropriate destinations.
-    memcpy(EncryptionKey.AES128CTRSHA1.DataKey,
-           sessionKeyData,
-           WeaveEncryptionKey_AES128CTRSHA1::DataKeySize);
-    memcpy(EncryptionKey.AES128CTRSHA1.IntegrityKey,
-           sessionKeyData + WeaveEncryptionKey_AES128CTRSHA1::DataKeySize,
-           WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize);
+    SetSessionEncryptionKey(EncryptionType, sessionKeyData, EncryptionKey);
     memcpy(keyConfirmKey,
-           sessionKeyData + WeaveEncryptionKey_AES128CTRSHA1::DataKeySize
-                          + WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize,
+           sessionKeyData + encKeyLen,
            keyConfirmKeyLength);
 
     ClearSecretData(sessionKeyData, keyLen);
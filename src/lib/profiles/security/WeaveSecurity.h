@@ -348,6 +348,8 @@ enum
     kTag_SerializedSession_ResumptionRecvMessageId      = 15, // [ UNSIGNED INT, range 32bits ] Next expected receive message id
                                                               //    for a session resumed after persistence.
     kTag_SerializedSession_IsUsedOverConnection         = 16, // [ BOOLEAN ] Is session used over a connection
+    kTag_SerializedSession_AES128CCM_Key                = 17, // [ BYTE STRING, len 16 ] For sessions supporting AES128CCM
+                                                              //    message encryption, the encryption key.
 };
 
 // Weave-defined elliptic curve ids
@@ -246,6 +246,25 @@ static void handleResponseTimeout(ExchangeContext *aExchangeCtx)
         manager->onResponseTimeout();
 }
 
+/**
+ *  @brief
+ *    This method is a trampoline which calls the actual handler
+ *    WeaveServiceManager::onRefreshTimer() .
+ *
+ *  @param[in] aSystemLayer A pointer to the system layer that owns the timer.
+ *  @param[in] aAppState    A pointer to the service manager.
+ *  @param[in] aError       An error code from the system layer.
+ */
+static void handleRefreshTimer(System::Layer *aSystemLayer, void *aAppState, System::Error aError)
+{
+    WeaveServiceManager *manager = (WeaveServiceManager *)aAppState;
+
+    WeaveLogProgress(ServiceDirectory, "handleRefreshTimer()");
+
+    if (manager)
+        manager->onRefreshTimer();
+}
+
 /**
  *  @brief
  *    This method initializes the WeaveServiceManager instance.
@@ -262,8 +281,14 @@ WeaveServiceManager::WeaveServiceManager()
     mExchangeContext = NULL;
     mServiceEndpointQueryBegin = NULL;
     mServiceEndpointQueryEndWithTimeInfo = NULL;
+    mCacheLifetime = WEAVE_CONFIG_SERVICE_DIR_CACHE_LIFETIME_MSECS;
+    mCacheExpiryTime = 0;
+    mCacheExpired = false;
+    mRefreshing = false;
+    mPendingRefresh = NULL;
 
     freeConnectRequests();
+    ResetDirectoryStats();
 
     clearWorkingState();
     clearCacheState();
@@ -274,6 +299,8 @@ WeaveServiceManager::WeaveServiceManager()
  */
 WeaveServiceManager::~WeaveServiceManager()
 {
+    cancelRefresh();
+
     mExchangeManager = NULL;
     mCache.base = NULL;
     mCache.length = 0;
@@ -343,6 +370,8 @@ WEAVE_ERROR WeaveServiceManager::init(WeaveExchangeManager *aExchangeMgr,
 
     VerifyOrExit(aExchangeMgr && aCache && aCacheLen > 0 && aAccessor, err = WEAVE_ERROR_INVALID_ARGUMENT);
 
+    cancelRefresh();
+
     mExchangeManager = aExchangeMgr;
     mCache.base = aCache;
     mCache.length = aCacheLen;
@@ -376,6 +405,13 @@ WEAVE_ERROR WeaveServiceManager::init(WeaveExchangeManager *aExchangeMgr,
         {
             mCacheState = kServiceMgrState_Resolved;
             WeaveLogProgress(ServiceDirectory, "Persistent service directory successfully restored");
+
+            /*
+             * the age of the persisted directory is unknown, so count
+             * its lifetime from now.
+             */
+
+            scheduleRefresh();
         }
 
     }
@@ -441,6 +477,20 @@ WEAVE_ERROR WeaveServiceManager::connect(uint64_t aServiceEp,
 
     WeaveLogProgress(ServiceDirectory, "connect(%llx...)", aServiceEp);
 
+    if (mCacheState == kServiceMgrState_Resolved && mCacheExpired)
+    {
+        WeaveLogProgress(ServiceDirectory, "expired");
+
+        /*
+         * the directory has run out its lifetime, so new requests
+         * wait for a directory query. it can only be sent once the
+         * requests still connecting with the old directory are done
+         * with the cache.
+         */
+
+        replaceExpiredCache();
+    }
+
     if (mCacheState == kServiceMgrState_Initial)
     {
         WeaveLogProgress(ServiceDirectory, "initial");
@@ -462,6 +512,8 @@ WEAVE_ERROR WeaveServiceManager::connect(uint64_t aServiceEp,
         mDirectory.base = mCache.base;
         mDirectory.length = 1;
 
+        indexDirectory();
+
         mCacheState = kServiceMgrState_Resolving;
     }
 
@@ -530,9 +582,12 @@ WEAVE_ERROR WeaveServiceManager::connect(uint64_t aServiceEp,
                     aConnectIntf);
     SuccessOrExit(err);
 
-    if (mCacheState == kServiceMgrState_Waiting)
+    if (mCacheState == kServiceMgrState_Waiting ||
+        (mCacheState == kServiceMgrState_Resolved && mCacheExpired))
     {
         WeaveLogProgress(ServiceDirectory, "waiting");
+
+        mStats.DeferredConnects++;
     }
 
     else if (mCacheState == kServiceMgrState_Resolved)
@@ -669,33 +724,64 @@ WEAVE_ERROR WeaveServiceManager::lookup(uint64_t aServiceEp, uint8_t *aControlBy
     WEAVE_FAULT_INJECT(nl::Weave::FaultInjection::kFault_ServiceManager_Lookup,
                        memset(&aServiceEp, 0x0F, sizeof(aServiceEp)));
 
-    for (uint8_t i = 0; i < mDirectory.length; i++)
+    if (mIndexLength == mDirectory.length)
     {
-        uint8_t  entryCtrlByte = Read8(p);
-        uint64_t svcEp = Read64(p);
+        /*
+         * the whole directory is indexed, so there's no need to walk
+         * the packed entries.
+         */
 
-        if (svcEp == aServiceEp)
-        {
-            // found it.
-            // break out of the loop
+        mStats.IndexedLookups++;
 
-            WeaveLogProgress(ServiceDirectory, "found [%x,%llx]", entryCtrlByte, svcEp);
+        for (uint8_t i = 0; i < mIndexLength; i++)
+        {
+            if (mIndex[i].serviceEp == aServiceEp)
+            {
+                WeaveLogProgress(ServiceDirectory, "found [%x,%llx]", mIndex[i].ctrlByte, aServiceEp);
 
-            *aControlByte = entryCtrlByte;
-            *aDirectoryEntry = p;
+                *aControlByte = mIndex[i].ctrlByte;
+                *aDirectoryEntry = mIndex[i].entry;
 
-            found = true;
-            err = WEAVE_NO_ERROR;
+                found = true;
+                err = WEAVE_NO_ERROR;
 
-            break;
+                break;
+            }
         }
+    }
 
-        // skip over this entry
+    else
+    {
+        mStats.ScannedLookups++;
 
-        err = calculateEntryLength(p, entryCtrlByte, &entryLen);
-        SuccessOrExit(err);
+        for (uint8_t i = 0; i < mDirectory.length; i++)
+        {
+            uint8_t  entryCtrlByte = Read8(p);
+            uint64_t svcEp = Read64(p);
 
-        p += entryLen;
+            if (svcEp == aServiceEp)
+            {
+                // found it.
+                // break out of the loop
+
+                WeaveLogProgress(ServiceDirectory, "found [%x,%llx]", entryCtrlByte, svcEp);
+
+                *aControlByte = entryCtrlByte;
+                *aDirectoryEntry = p;
+
+                found = true;
+                err = WEAVE_NO_ERROR;
+
+                break;
+            }
+
+            // skip over this entry
+
+            err = calculateEntryLength(p, entryCtrlByte, &entryLen);
+            SuccessOrExit(err);
+
+            p += entryLen;
+        }
     }
 
     if (!found)
@@ -831,6 +917,10 @@ WEAVE_ERROR WeaveServiceManager::replaceOrAddCacheEntry(uint16_t port,
 
     mDirAndSuffTableSize += overrideEntryTotalLen;
 
+    // Entries have moved, so rebuild the index.
+
+    indexDirectory();
+
 exit:
     WeaveLogProgress(ServiceDirectory, "%s : %s", __func__, nl::ErrorStr(err));
 
@@ -883,10 +973,12 @@ void WeaveServiceManager::cancel(uint64_t aServiceEp, void *aAppState)
 
         /*
          * now clean up the exchange state being used to request
-         * service directory info.
+         * service directory info. a background refresh doesn't
+         * belong to any request, so leave it running.
          */
 
-        cleanupExchangeContext(WEAVE_ERROR_CONNECTION_CLOSED_UNEXPECTEDLY);
+        if (!mRefreshing)
+            cleanupExchangeContext(WEAVE_ERROR_CONNECTION_CLOSED_UNEXPECTEDLY);
     }
 }
 
@@ -936,9 +1028,11 @@ void WeaveServiceManager::unresolve(void)
         Platform::ClearPersistentServiceDir();
 #endif //WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
 
+        cancelRefresh();
         cleanupExchangeContext();
 
         mCacheState = kServiceMgrState_Resolving;
+        mCacheExpired = false;
 
         finalizeConnectRequests();
     }
@@ -977,6 +1071,7 @@ void WeaveServiceManager::reset(void)
 {
     WeaveLogProgress(ServiceDirectory, "reset()");
 
+    cancelRefresh();
     cleanupExchangeContext();
 
     clearWorkingState();
@@ -1092,6 +1187,9 @@ void WeaveServiceManager::onConnectionComplete(WEAVE_ERROR aError)
                                         buf,
                                         ExchangeContext::kSendFlag_ExpectResponse);
     buf = NULL;
+    SuccessOrExit(err);
+
+    mStats.DirectoryQueries++;
 
 exit:
 
@@ -1137,6 +1235,12 @@ void WeaveServiceManager::onResponseReceived(uint32_t aProfileId, uint8_t aMsgTy
 
     cleanupExchangeContext();
 
+    if (mRefreshing)
+    {
+        onRefreshResponse(aProfileId, aMsgType, aMsg);
+        return;
+    }
+
     if (aProfileId == kWeaveProfile_StatusReport_Deprecated || aProfileId == kWeaveProfile_Common)
     {
         /*
@@ -1219,6 +1323,8 @@ void WeaveServiceManager::onResponseReceived(uint32_t aProfileId, uint8_t aMsgTy
 
             WeaveLogProgress(ServiceDirectory, "onResponseReceived(): ->resolved");
 
+            scheduleRefresh();
+
             // now we gotta process all the pending transactions (see below)
 
             for (uint8_t j = 0; j < ARRAY_SIZE(mConnectRequestPool); j++)
@@ -1640,6 +1746,14 @@ WEAVE_ERROR WeaveServiceManager::unpackPacketBuffer(PacketBuffer *aMsg, bool use
         mDirectory.length = dirLen;
         writePtr = mDirectory.base = mCache.base;
 
+        /*
+         * cacheDirectory() and cacheSuffixes() add to the table size.
+         * a background refresh unpacks over a resolved cache, so start
+         * the count over rather than adding to the old directory's.
+         */
+
+        mDirAndSuffTableSize = 0;
+
         err = cacheDirectory(i, mDirectory.length, writePtr);
         SuccessOrExit(err);
 
@@ -1798,6 +1912,13 @@ WEAVE_ERROR WeaveServiceManager::cacheDirectory(MessageIterator &aIterator, uint
 
     mDirAndSuffTableSize += aWritePtr - startWritePtr;
 
+    // Index the entries so lookups don't have to walk the cache.
+
+    if (retval == WEAVE_NO_ERROR)
+        indexDirectory();
+    else
+        mIndexLength = 0;
+
     return retval;
 }
 
@@ -1861,6 +1982,18 @@ void WeaveServiceManager::fail(WEAVE_ERROR aError)
 {
     WeaveLogProgress(ServiceDirectory, "fail() <= %s", ErrorStr(aError));
 
+    /*
+     * a failed background refresh leaves the resolved directory
+     * and its connect requests alone.
+     */
+
+    if (mRefreshing)
+    {
+        refreshFailed(aError);
+        return;
+    }
+
+    cancelRefresh();
     cleanupExchangeContext(aError);
 
     clearWorkingState();
@@ -1980,6 +2113,7 @@ void WeaveServiceManager::clearWorkingState(void)
     mSuffixTable.length = 0;
     mSuffixTable.base = NULL;
     mDirAndSuffTableSize = 0;
+    mIndexLength = 0;
 }
 
 /**
@@ -2027,6 +2161,8 @@ void WeaveServiceManager::clearCache(void)
 
     if (mCacheState == kServiceMgrState_Resolved)
     {
+        cancelRefresh();
+
         clearWorkingState();
         clearCacheState();
 
@@ -2035,4 +2171,503 @@ void WeaveServiceManager::clearCache(void)
 #endif
     }
 }
+
+/**
+ *  @brief
+ *    This method sets the lifetime of a resolved service directory.
+ *
+ *  Once three quarters of the lifetime have elapsed the service manager
+ *  queries the directory service again in the background and installs
+ *  the response in the cache. If that doesn't succeed before the end of
+ *  the lifetime, the cache is unresolved. If the directory is already
+ *  resolved, its lifetime is counted again from now.
+ *
+ *  @param [in] aLifetimeMsecs  The lifetime in milliseconds, or 0 to keep
+ *    a resolved directory until it is explicitly invalidated.
+ */
+void WeaveServiceManager::SetCacheLifetime(uint32_t aLifetimeMsecs)
+{
+    mCacheLifetime = aLifetimeMsecs;
+
+    if (mCacheState == kServiceMgrState_Resolved && !mCacheExpired && !mRefreshing && mPendingRefresh == NULL)
+    {
+        cancelRefresh();
+        scheduleRefresh();
+    }
+}
+
+/**
+ *  @brief
+ *    This method retrieves the directory cache usage counters.
+ *
+ *  @param [out] aStats     A reference to the structure to fill in.
+ */
+void WeaveServiceManager::GetDirectoryStats(DirectoryStats &aStats) const
+{
+    aStats = mStats;
+}
+
+/**
+ *  @brief
+ *    This method resets the directory cache usage counters.
+ */
+void WeaveServiceManager::ResetDirectoryStats(void)
+{
+    memset(&mStats, 0, sizeof(mStats));
+}
+
+/**
+ *  @brief
+ *    This method indexes the entries of the working directory by
+ *    service endpoint.
+ *
+ *  If the directory has more entries than the index can hold, or an
+ *  entry can't be parsed, the index covers only the leading entries
+ *  and lookup() falls back to scanning the cache.
+ */
+void WeaveServiceManager::indexDirectory(void)
+{
+    uint8_t *p = mDirectory.base;
+    uint16_t entryLen;
+
+    mIndexLength = 0;
+
+    if (p == NULL)
+        return;
+
+    for (uint8_t i = 0; i < mDirectory.length && i < ARRAY_SIZE(mIndex); i++)
+    {
+        IndexEntry &indexEntry = mIndex[i];
+
+        indexEntry.ctrlByte = Read8(p);
+        indexEntry.serviceEp = Read64(p);
+        indexEntry.entry = p;
+
+        if (calculateEntryLength(p, indexEntry.ctrlByte, &entryLen) != WEAVE_NO_ERROR)
+            break;
+
+        p += entryLen;
+        mIndexLength++;
+    }
+}
+
+/**
+ *  @brief
+ *    This method tests whether any connect request is outstanding.
+ *
+ *  An outstanding request may still be connecting using host names in the
+ *  cache, so the cache must not be overwritten while this is true.
+ *
+ *  @return true if a connect request is in use, false otherwise.
+ */
+bool WeaveServiceManager::hasActiveRequests(void)
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(mConnectRequestPool); i++)
+    {
+        if (mConnectRequestPool[i].mServiceEp != 0)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ *  @brief
+ *    This method checks whether any connect request has started to
+ *    connect using the resolved directory.
+ *
+ *  Unlike a request waiting for a directory query, such a request may
+ *  refer to host names in the cache until its connection completes.
+ *
+ *  @return true if a connect request is connecting, false otherwise.
+ */
+bool WeaveServiceManager::hasConnectingRequests(void)
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(mConnectRequestPool); i++)
+    {
+        const ConnectRequest &req = mConnectRequestPool[i];
+
+        if (req.mServiceEp != 0 && req.mConnection != NULL &&
+            req.mConnection->State != WeaveConnection::kState_ReadyToConnect)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ *  @brief
+ *    This method starts the lifetime of a newly resolved directory and
+ *    arms the timer for its background refresh.
+ */
+void WeaveServiceManager::scheduleRefresh(void)
+{
+    if (mCacheLifetime == 0)
+        return;
+
+    mCacheExpiryTime = System::Layer::GetClock_MonotonicMS() + mCacheLifetime;
+
+    startRefreshTimer(mCacheLifetime - mCacheLifetime / 4);
+}
+
+/**
+ *  @brief
+ *    This method (re)arms the refresh timer.
+ *
+ *  @param [in] aDelayMsecs     The delay in milliseconds.
+ */
+void WeaveServiceManager::startRefreshTimer(uint32_t aDelayMsecs)
+{
+    WEAVE_ERROR err;
+
+    err = mExchangeManager->MessageLayer->SystemLayer->StartTimer(aDelayMsecs, handleRefreshTimer, this);
+
+    if (err != WEAVE_NO_ERROR)
+        WeaveLogError(ServiceDirectory, "refresh timer: %s", ErrorStr(err));
+}
+
+/**
+ *  @brief
+ *    This method stops any background refresh, including its timer, its
+ *    query and any response waiting to be installed.
+ */
+void WeaveServiceManager::cancelRefresh(void)
+{
+    if (mRefreshing)
+    {
+        mRefreshing = false;
+
+        cleanupExchangeContext(WEAVE_ERROR_CONNECTION_ABORTED);
+    }
+
+    if (mPendingRefresh != NULL)
+    {
+        PacketBuffer::Free(mPendingRefresh);
+        mPendingRefresh = NULL;
+    }
+
+    // the exchange manager may already be shut down when a static manager is destroyed
+
+    if (mExchangeManager != NULL && mExchangeManager->MessageLayer != NULL)
+        mExchangeManager->MessageLayer->SystemLayer->CancelTimer(handleRefreshTimer, this);
+}
+
+/**
+ *  @brief
+ *    This method handles the refresh timer.
+ *
+ *  Depending on how far the resolved directory is into its lifetime, this
+ *  installs a refreshed directory that was held back, expires the
+ *  directory, or sends a directory query in the background. A query still
+ *  outstanding when the directory expires is abandoned. Once a directory
+ *  has expired, the timer only serves connect requests waiting to replace
+ *  it.
+ */
+void WeaveServiceManager::onRefreshTimer(void)
+{
+    WEAVE_ERROR err;
+    uint64_t now = System::Layer::GetClock_MonotonicMS();
+
+    if (mCacheState != kServiceMgrState_Resolved)
+        return;
+
+    if (mCacheExpired)
+    {
+        if (hasActiveRequests())
+            replaceExpiredCache();
+    }
+
+    else if (mRefreshing)
+    {
+        // the directory has run out its lifetime while the query is outstanding
+
+        refreshFailed(WEAVE_ERROR_TIMEOUT);
+    }
+
+    else if (mPendingRefresh != NULL)
+    {
+        applyRefresh();
+    }
+
+    else if (now >= mCacheExpiryTime)
+    {
+        expireCache();
+    }
+
+    else
+    {
+        err = startRefresh();
+
+        /*
+         * the query may already have failed through the connection
+         * complete callback, in which case it has been handled.
+         * otherwise, don't let the query outlive the directory.
+         */
+
+        if (err != WEAVE_NO_ERROR && mRefreshing)
+            refreshFailed(err);
+
+        else if (mRefreshing)
+            startRefreshTimer(static_cast<uint32_t>(mCacheExpiryTime - now));
+    }
+}
+
+/**
+ *  @brief
+ *    This method sends a service endpoint query while the cache stays
+ *    resolved.
+ *
+ *  @return #WEAVE_NO_ERROR on success; otherwise, a respective error code.
+ */
+WEAVE_ERROR WeaveServiceManager::startRefresh(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    WeaveLogProgress(ServiceDirectory, "startRefresh()");
+
+    VerifyOrExit(mConnection == NULL && mExchangeContext == NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mConnection = mExchangeManager->MessageLayer->NewConnection();
+    VerifyOrExit(mConnection, err = WEAVE_ERROR_NO_MEMORY);
+
+    mRefreshing = true;
+    mStats.RefreshesStarted++;
+
+    err = lookupAndConnect(mConnection,
+                           kServiceEndpoint_Directory,
+                           mDirAuthMode,
+                           this,
+                           handleSDConnectionComplete,
+                           WEAVE_CONFIG_SERVICE_DIR_CONNECT_TIMEOUT_MSECS);
+
+exit:
+
+    return err;
+}
+
+/**
+ *  @brief
+ *    This method handles the response to a background refresh query.
+ *
+ *  Anything other than a plain service endpoint response, including a
+ *  redirect, counts as a failed refresh; the resolved directory stays in
+ *  use until it expires.
+ *
+ *  @param [in] aProfileId   The profile ID for this incoming message.
+ *  @param [in] aMsgType     The profile-specific type for this message.
+ *  @param [in] aMsg         The content of this message.
+ */
+void WeaveServiceManager::onRefreshResponse(uint32_t aProfileId, uint8_t aMsgType, PacketBuffer *aMsg)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(aProfileId == kWeaveProfile_ServiceDirectory, err = WEAVE_ERROR_STATUS_REPORT_RECEIVED);
+    VerifyOrExit(aMsgType == kMsgType_ServiceEndpointResponse, err = WEAVE_ERROR_INVALID_MESSAGE_TYPE);
+    VerifyOrExit(aMsg->DataLength() > 0, err = WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    VerifyOrExit((aMsg->Start()[0] & kMask_Redirect) == 0, err = WEAVE_ERROR_UNSUPPORTED_WEAVE_FEATURE);
+
+    mRefreshing = false;
+
+    mPendingRefresh = aMsg;
+    aMsg = NULL;
+
+    applyRefresh();
+
+exit:
+
+    PacketBuffer::Free(aMsg);
+
+    if (err != WEAVE_NO_ERROR)
+        refreshFailed(err);
+}
+
+/**
+ *  @brief
+ *    This method installs a refreshed directory in the cache, or holds it
+ *    back for a moment if connect requests still refer to the cache.
+ *
+ *  A refreshed directory is held back no longer than the current one's
+ *  lifetime; after that, the cache expires instead.
+ */
+void WeaveServiceManager::applyRefresh(void)
+{
+    WEAVE_ERROR err;
+    PacketBuffer *msg;
+
+    if (hasActiveRequests())
+    {
+        uint64_t now = System::Layer::GetClock_MonotonicMS();
+
+        if (now < mCacheExpiryTime)
+        {
+            WeaveLogProgress(ServiceDirectory, "applyRefresh(): deferred");
+
+            if (mCacheExpiryTime - now < kWeave_RefreshDeferTimeout)
+                startRefreshTimer(static_cast<uint32_t>(mCacheExpiryTime - now));
+            else
+                startRefreshTimer(kWeave_RefreshDeferTimeout);
+
+            return;
+        }
+
+        expireCache();
+        return;
+    }
+
+    msg = mPendingRefresh;
+    mPendingRefresh = NULL;
+
+    err = unpackPacketBuffer(msg, true);
+    SuccessOrExit(err);
+
+#if WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
+    WeaveLogProgress(ServiceDirectory, "Persisting service directory response");
+    err = Platform::StorePersistentServiceDir(msg->Start(),
+                                              msg->DataLength(),
+                                              kPersistedServiceDirVersion);
+    SuccessOrExit(err);
+#endif // WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
+
+    mStats.RefreshesCompleted++;
+
+    WeaveLogProgress(ServiceDirectory, "applyRefresh(): ->resolved");
+
+    scheduleRefresh();
+
+exit:
+
+    PacketBuffer::Free(msg);
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        /*
+         * the cache may have been partly overwritten, so there's no
+         * going back to the old directory.
+         */
+
+        WeaveLogProgress(ServiceDirectory, "applyRefresh: %s", ErrorStr(err));
+
+        mStats.RefreshesFailed++;
+
+        clearWorkingState();
+        clearCacheState();
+
+#if WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
+        Platform::ClearPersistentServiceDir();
+#endif
+    }
+}
+
+/**
+ *  @brief
+ *    This method cleans up after a failed background refresh and retries it
+ *    if the resolved directory hasn't expired yet.
+ *
+ *  @param[in] aError An error code indicating the cause of failure.
+ */
+void WeaveServiceManager::refreshFailed(WEAVE_ERROR aError)
+{
+    uint64_t now = System::Layer::GetClock_MonotonicMS();
+
+    WeaveLogProgress(ServiceDirectory, "refreshFailed() <= %s", ErrorStr(aError));
+
+    mRefreshing = false;
+    mStats.RefreshesFailed++;
+
+    cleanupExchangeContext(aError);
+
+    if (now >= mCacheExpiryTime)
+    {
+        expireCache();
+    }
+
+    else if (mCacheExpiryTime - now < WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS)
+    {
+        startRefreshTimer(static_cast<uint32_t>(mCacheExpiryTime - now));
+    }
+
+    else
+    {
+        startRefreshTimer(WEAVE_CONFIG_SERVICE_DIR_REFRESH_RETRY_MSECS);
+    }
+}
+
+/**
+ *  @brief
+ *    This method unresolves a directory that has outlived its lifetime so
+ *    that the next connect request queries the directory service.
+ *
+ *  Connect requests already connecting with the directory are left to
+ *  finish. In that case the directory is only marked as expired, and
+ *  connect requests made from then on wait for it to be replaced.
+ */
+void WeaveServiceManager::expireCache(void)
+{
+    WeaveLogProgress(ServiceDirectory, "directory expired");
+
+    mStats.CacheExpirations++;
+
+    if (!hasActiveRequests())
+    {
+        unresolve();
+        return;
+    }
+
+#if WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
+    Platform::ClearPersistentServiceDir();
+#endif //WEAVE_CONFIG_PERSIST_SERVICE_DIRECTORY
+
+    cancelRefresh();
+
+    mCacheExpired = true;
+}
+
+/**
+ *  @brief
+ *    This method queries the directory service on behalf of connect
+ *    requests made after the resolved directory expired.
+ *
+ *  The response overwrites the cache, so the query waits for any request
+ *  still connecting with the expired directory to complete. Meanwhile the
+ *  refresh timer checks back periodically.
+ */
+void WeaveServiceManager::replaceExpiredCache(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    if (hasConnectingRequests())
+    {
+        startRefreshTimer(kWeave_RefreshDeferTimeout);
+        return;
+    }
+
+    WeaveLogProgress(ServiceDirectory, "replaceExpiredCache()");
+
+    mCacheExpired = false;
+    mCacheState = kServiceMgrState_Resolving;
+
+    mConnection = mExchangeManager->MessageLayer->NewConnection();
+    VerifyOrExit(mConnection, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = lookupAndConnect(mConnection,
+                           kServiceEndpoint_Directory,
+                           mDirAuthMode,
+                           this,
+                           handleSDConnectionComplete,
+                           WEAVE_CONFIG_SERVICE_DIR_CONNECT_TIMEOUT_MSECS);
+    SuccessOrExit(err);
+
+    /*
+     * as in connect(), a synchronous failure has already been
+     * handled through the connection complete callback.
+     */
+
+    if (mCacheState == kServiceMgrState_Resolving)
+        mCacheState = kServiceMgrState_Waiting;
+
+exit:
+
+    if (err != WEAVE_NO_ERROR && mCacheState == kServiceMgrState_Resolving)
+        fail(err);
+}
 #endif //WEAVE_CONFIG_ENABLE_SERVICE_DIRECTORY
@@ -276,6 +276,23 @@ public:
      */
     typedef void (*OnConnectBegin)(struct ServiceConnectBeginArgs & args);
 
+    /**
+     * @struct DirectoryStats
+     *
+     * @brief Counters describing how the directory cache is being used.
+     */
+    struct DirectoryStats
+    {
+        uint32_t IndexedLookups;        ///< lookups answered from the endpoint index
+        uint32_t ScannedLookups;        ///< lookups that had to scan the packed cache
+        uint32_t DirectoryQueries;      ///< service endpoint queries sent to the directory service
+        uint32_t DeferredConnects;      ///< connect() calls that had to wait for a directory query
+        uint32_t RefreshesStarted;      ///< background refreshes started
+        uint32_t RefreshesCompleted;    ///< background refreshes applied to the cache
+        uint32_t RefreshesFailed;       ///< background refreshes that failed
+        uint32_t CacheExpirations;      ///< times the cache was unresolved because its lifetime ran out
+    };
+
     WeaveServiceManager(void);
     ~WeaveServiceManager(void);
 
@@ -328,6 +345,13 @@ public:
 
     void SetConnectBeginCallback(OnConnectBegin aConnectBegin);
 
+    void SetCacheLifetime(uint32_t aLifetimeMsecs);
+
+    void onRefreshTimer(void);
+
+    void GetDirectoryStats(DirectoryStats &aStats) const;
+    void ResetDirectoryStats(void);
+
     enum
     {
         /**
@@ -335,7 +359,15 @@ public:
          *    Number of milliseconds a response must be received for the
          *    directory query before the exchange context times out.
          */
-        kWeave_DefaultSendTimeout = 15000
+        kWeave_DefaultSendTimeout = 15000,
+
+        /**
+         *  @brief
+         *    Number of milliseconds a refreshed directory is held back
+         *    while connect requests still refer to the current cache,
+         *    up to the current directory's expiry.
+         */
+        kWeave_RefreshDeferTimeout = 1000
     };
 
     /**
@@ -420,6 +452,13 @@ private:
         size_t  length;
     };
 
+    struct IndexEntry
+    {
+        uint64_t serviceEp;
+        uint8_t  *entry;
+        uint8_t  ctrlByte;
+    };
+
     void freeConnectRequests(void);
     void finalizeConnectRequests(void);
     ConnectRequest *getAvailableRequest(void);
@@ -439,6 +478,26 @@ private:
     WEAVE_ERROR cacheDirectory(MessageIterator &, uint8_t, uint8_t *&);
     WEAVE_ERROR cacheSuffixes(MessageIterator &, uint8_t, uint8_t *&);
     WEAVE_ERROR calculateEntryLength(uint8_t *entryStart, uint8_t entryCtrlByte, uint16_t *entryLen);
+    void indexDirectory(void);
+    bool hasActiveRequests(void);
+    bool hasConnectingRequests(void);
+
+    /*
+     *  Background refresh of a resolved directory. The refresh runs
+     *  its query while the cache stays resolved and swaps the new
+     *  directory in only once no connect request refers to the old
+     *  one.
+     */
+
+    void scheduleRefresh(void);
+    void startRefreshTimer(uint32_t aDelayMsecs);
+    void cancelRefresh(void);
+    WEAVE_ERROR startRefresh(void);
+    void onRefreshResponse(uint32_t aProfileId, uint8_t aMsgType, PacketBuffer *aMsg);
+    void applyRefresh(void);
+    void refreshFailed(WEAVE_ERROR aError);
+    void expireCache(void);
+    void replaceExpiredCache(void);
     /*
      *  A group of methods that clear up working state and free
      *  resources - generally in the case of a failure. one of
@@ -462,6 +521,7 @@ private:
     {
         mCacheState = kServiceMgrState_Initial;
         mWasRelocated = false;
+        mCacheExpired = false;
     }
 
     WEAVE_ERROR handleTimeInfo(MessageIterator &itMsg);
@@ -480,6 +540,14 @@ private:
     bool                    mWasRelocated;                ///< true iff the service manager has been relocated once.
     WeaveAuthMode           mDirAuthMode;                 ///< the authentication mode to use when talking to the directory service.
     uint32_t                mDirAndSuffTableSize;         ///< the size of the directory and suffix table  in the cache.
+    IndexEntry              mIndex[WEAVE_CONFIG_SERVICE_DIR_INDEX_SIZE]; ///< the working directory indexed by service endpoint
+    uint8_t                 mIndexLength;                 ///< the number of valid entries in the index
+    uint32_t                mCacheLifetime;               ///< the lifetime of a resolved directory in msec, 0 for unlimited
+    uint64_t                mCacheExpiryTime;             ///< monotonic time in msec at which the resolved directory expires
+    bool                    mCacheExpired;                ///< true iff the resolved directory expired while still in use by connect requests
+    bool                    mRefreshing;                  ///< true iff the pending directory query is a background refresh
+    PacketBuffer            *mPendingRefresh;             ///< a refreshed directory awaiting installation in the cache
+    DirectoryStats          mStats;                       ///< directory cache usage counters
 
     /**
      *  Callback happens right before we send out the service endpoint query request
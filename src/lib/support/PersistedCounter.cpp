@@ -18,6 +18,7 @@
 #include <Weave/Support/CodeUtils.h>
 #include <Weave/Support/logging/WeaveLogging.h>
 #include <Weave/Support/PersistedCounter.h>
+#include <Weave/Support/PersistedStorageWriteBehind.h>
 #include <Weave/Support/platform/PersistedStorage.h>
 
 #include <stdlib.h>
@@ -29,7 +30,9 @@ namespace Weave {
 PersistedCounter::PersistedCounter(void) :
     MonotonicallyIncreasingCounter(),
     mStartingCounterValue(0),
-    mEpoch(0)
+    mEpoch(0),
+    mPersistedStartValue(0),
+    mRequestedStartValue(0)
 {
     memset(&mId, 0, sizeof(mId));
 }
@@ -51,17 +54,28 @@ PersistedCounter::Init(const nl::Weave::Platform::PersistedStorage::Key aId,
     VerifyOrExit(aEpoch > 0, err = WEAVE_ERROR_INVALID_INTEGER_VALUE);
     mEpoch = aEpoch;
 
+    // A value for this counter may still be waiting in the write-behind
+    // cache, e.g. if the counter is being re-initialized; make sure we
+    // read the latest one.
+    if (PersistedStorageWriteBehind::GetInstance().IsEnabled())
+    {
+        err = PersistedStorageWriteBehind::GetInstance().Flush();
+        SuccessOrExit(err);
+    }
+
     // Read our previously-stored starting value.
     err = ReadStartValue(mStartingCounterValue);
     SuccessOrExit(err);
 
+    mPersistedStartValue = mRequestedStartValue = mStartingCounterValue;
+
 #if WEAVE_CONFIG_PERSISTED_COUNTER_DEBUG_LOGGING
     WeaveLogDetail(EventLogging, "PersistedCounter::Init() aEpoch 0x%x mStartingCounterValue 0x%x", aEpoch, mStartingCounterValue);
 #endif
 
     // Write out the counter value with which we'll start next time we
     // boot up.
-    err = WriteStartValue(mStartingCounterValue + mEpoch);
+    err = PersistStartValue(mStartingCounterValue);
     SuccessOrExit(err);
 
     // This will set the starting value, after which we're ready.
@@ -77,7 +91,7 @@ PersistedCounter::SetValue(uint32_t value)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
 
-    err = WriteStartValue(value + mEpoch);
+    err = PersistStartValue(value);
     SuccessOrExit(err);
 
     mCounterValue = mStartingCounterValue = value;
@@ -135,7 +149,7 @@ PersistedCounter::IncrementCount(void)
     if (GetNextValue(mCounterValue))
     {
         // Started a new epoch, so write out the next one.
-        err = WriteStartValue(mCounterValue + mEpoch);
+        err = PersistStartValue(mCounterValue);
         SuccessOrExit(err);
 
         mStartingCounterValue = mCounterValue;
@@ -145,6 +159,55 @@ exit:
     return err;
 }
 
+WEAVE_ERROR
+PersistedCounter::PersistStartValue(uint32_t aEpochStartValue)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PersistedStorageWriteBehind & writeBehind = PersistedStorageWriteBehind::GetInstance();
+    uint32_t requiredStartValue = aEpochStartValue + mEpoch;
+
+    if (!writeBehind.IsEnabled())
+    {
+        err = WriteStartValue(requiredStartValue);
+        SuccessOrExit(err);
+
+        mPersistedStartValue = mRequestedStartValue = requiredStartValue;
+        ExitNow();
+    }
+
+    // Once nothing is pending for this counter, the last value we asked
+    // for has reached persistent storage.
+    if (!writeBehind.IsPending(mId))
+    {
+        mPersistedStartValue = mRequestedStartValue;
+    }
+
+    // Ask for one epoch more than we need, so that the write can be batched
+    // with others while the previously requested value still covers the
+    // epoch we are entering.
+    err = writeBehind.Write(mId, requiredStartValue + mEpoch);
+    SuccessOrExit(err);
+
+    mRequestedStartValue = requiredStartValue + mEpoch;
+
+#if WEAVE_CONFIG_PERSISTED_COUNTER_DEBUG_LOGGING
+    WeaveLogDetail(EventLogging, "PersistedCounter::PersistStartValue() requested 0x%x persisted 0x%x", mRequestedStartValue, mPersistedStartValue);
+#endif
+
+    // No value in the new epoch may be vended until storage holds a start
+    // value beyond it; otherwise a reboot could repeat it.
+    if (static_cast<int32_t>(mPersistedStartValue - requiredStartValue) < 0)
+    {
+        err = writeBehind.Flush();
+        SuccessOrExit(err);
+
+        mPersistedStartValue = mRequestedStartValue;
+    }
+
+exit:
+    return err;
+}
+
 WEAVE_ERROR
 PersistedCounter::WriteStartValue(uint32_t aStartValue)
 {
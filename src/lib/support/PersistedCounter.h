@@ -109,6 +109,23 @@ private:
      */
     WEAVE_ERROR IncrementCount(void);
 
+    /**
+     *  @brief
+     *    Make sure the starting value for the next boot lies beyond the epoch
+     *    starting at aEpochStartValue, before any value in that epoch is vended.
+     *
+     *    When the PersistedStorageWriteBehind cache is enabled, the write is
+     *    left to the cache and storage is only flushed synchronously if the
+     *    value already persisted does not cover the new epoch.  The value
+     *    requested is then two epochs ahead rather than one, so up to two
+     *    epochs of values may be skipped across a reboot.
+     *
+     *  @param[in] aEpochStartValue  The first value of the epoch being entered.
+     *
+     *  @return Any error returned by a write to persistent storage.
+     */
+    WEAVE_ERROR PersistStartValue(uint32_t aEpochStartValue);
+
     /**
      *  @brief
      *    Write out the counter value to persistent storage.
@@ -132,6 +149,8 @@ private:
     nl::Weave::Platform::PersistedStorage::Key mId;
     uint32_t mStartingCounterValue;
     uint32_t mEpoch;
+    uint32_t mPersistedStartValue;  // Starting value known to be in persistent storage.
+    uint32_t mRequestedStartValue;  // Starting value most recently written or queued.
 };
 
 } // Weave
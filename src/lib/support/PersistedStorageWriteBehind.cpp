@@ -0,0 +1,244 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Implementation of a write-behind cache that coalesces writes to the
+ *   platform's persistent storage into periodic batches.
+ */
+
+#include <string.h>
+
+#include <Weave/Support/PersistedStorageWriteBehind.h>
+#include <Weave/Support/CodeUtils.h>
+#include <Weave/Support/ErrorStr.h>
+#include <Weave/Support/logging/WeaveLogging.h>
+
+#include <SystemLayer/SystemLayer.h>
+
+namespace nl {
+namespace Weave {
+
+using namespace nl::Weave::Platform;
+
+PersistedStorageWriteBehind PersistedStorageWriteBehind::sInstance;
+
+// Keys are compared by content, since callers may name the same key from different buffers.
+static inline bool KeysMatch(PersistedStorage::Key aKey1, PersistedStorage::Key aKey2)
+{
+    return strcmp(aKey1, aKey2) == 0;
+}
+
+PersistedStorageWriteBehind::PersistedStorageWriteBehind(void) :
+    mNumPending(0),
+    mIsEnabled(false),
+    mSystemLayer(NULL),
+    mFlushIntervalMsec(0)
+{
+}
+
+/**
+ *  @brief
+ *    Start caching writes.
+ *
+ *  @param[in] aSystemLayer        The system layer on which to run the flush
+ *                                 timer, or NULL if pending values are only
+ *                                 written by explicit calls to Flush().
+ *  @param[in] aFlushIntervalMsec  The longest time a value may remain pending
+ *                                 before the timer writes it out.
+ *
+ *  @return WEAVE_ERROR_INCORRECT_STATE if the cache is already enabled,
+ *          WEAVE_NO_ERROR otherwise.
+ */
+WEAVE_ERROR PersistedStorageWriteBehind::Init(System::Layer * aSystemLayer, uint32_t aFlushIntervalMsec)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(!mIsEnabled, err = WEAVE_ERROR_INCORRECT_STATE);
+
+    mSystemLayer = aSystemLayer;
+    mFlushIntervalMsec = aFlushIntervalMsec;
+    mNumPending = 0;
+    mIsEnabled = true;
+
+exit:
+    return err;
+}
+
+/**
+ *  @brief
+ *    Write out any pending values and return to writing straight through.
+ *
+ *  @return Any error returned by the final Flush(), in which case the cache
+ *          remains enabled.
+ */
+WEAVE_ERROR PersistedStorageWriteBehind::Shutdown(void)
+{
+    WEAVE_ERROR err;
+
+    err = Flush();
+    SuccessOrExit(err);
+
+    mIsEnabled = false;
+    mSystemLayer = NULL;
+
+exit:
+    return err;
+}
+
+/**
+ *  @brief
+ *    Record a value to be written to persistent storage.
+ *
+ *  @param[in] aKey    A key to a persistently-stored value.
+ *  @param[in] aValue  The value, which replaces any value already pending
+ *                     for aKey.
+ *
+ *  @return Any error returned by a write to persistent storage, which only
+ *          happens here if the cache is disabled or has no room for aKey.
+ */
+WEAVE_ERROR PersistedStorageWriteBehind::Write(PersistedStorage::Key aKey, uint32_t aValue)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint8_t i;
+
+    if (!mIsEnabled)
+    {
+        return PersistedStorage::Write(aKey, aValue);
+    }
+
+    for (i = 0; i < mNumPending; i++)
+    {
+        if (KeysMatch(mPendingKeys[i], aKey))
+        {
+            mPendingValues[i] = aValue;
+            ExitNow();
+        }
+    }
+
+    if (mNumPending == WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS)
+    {
+        err = Flush();
+        SuccessOrExit(err);
+    }
+
+    mPendingKeys[mNumPending] = aKey;
+    mPendingValues[mNumPending] = aValue;
+    mNumPending++;
+
+    if (mNumPending == 1)
+    {
+        ScheduleFlush();
+    }
+
+exit:
+    return err;
+}
+
+/**
+ *  @brief
+ *    Write all pending values to persistent storage as one batch.
+ *
+ *  @return Any error returned by a write to persistent storage.  Values that
+ *          may not have been written remain pending.
+ */
+WEAVE_ERROR PersistedStorageWriteBehind::Flush(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    if (mNumPending == 0)
+        ExitNow();
+
+#if WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+    err = PersistedStorage::WriteMultiple(mPendingKeys, mPendingValues, mNumPending);
+    SuccessOrExit(err);
+
+    mNumPending = 0;
+#else
+    {
+        uint8_t numWritten = 0;
+
+        while (numWritten < mNumPending)
+        {
+            err = PersistedStorage::Write(mPendingKeys[numWritten], mPendingValues[numWritten]);
+            if (err != WEAVE_NO_ERROR)
+                break;
+            numWritten++;
+        }
+
+        // Keep whatever could not be written pending, in order.
+        for (uint8_t i = numWritten; i < mNumPending; i++)
+        {
+            mPendingKeys[i - numWritten] = mPendingKeys[i];
+            mPendingValues[i - numWritten] = mPendingValues[i];
+        }
+        mNumPending -= numWritten;
+
+        SuccessOrExit(err);
+    }
+#endif // WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+
+exit:
+    if (mSystemLayer != NULL)
+    {
+        mSystemLayer->CancelTimer(HandleFlushTimer, this);
+
+        if (mNumPending > 0)
+        {
+            WeaveLogError(Support, "Persisted storage write-behind flush failed: %s", ErrorStr(err));
+            ScheduleFlush();
+        }
+    }
+
+    return err;
+}
+
+/**
+ *  @brief
+ *    Determine whether a value for a key is waiting to be written.
+ */
+bool PersistedStorageWriteBehind::IsPending(PersistedStorage::Key aKey) const
+{
+    for (uint8_t i = 0; i < mNumPending; i++)
+    {
+        if (KeysMatch(mPendingKeys[i], aKey))
+            return true;
+    }
+
+    return false;
+}
+
+void PersistedStorageWriteBehind::ScheduleFlush(void)
+{
+    if (mSystemLayer != NULL)
+    {
+        mSystemLayer->StartTimer(mFlushIntervalMsec, HandleFlushTimer, this);
+    }
+}
+
+void PersistedStorageWriteBehind::HandleFlushTimer(System::Layer * aSystemLayer, void * aAppState, System::Error aError)
+{
+    PersistedStorageWriteBehind * writeBehind = static_cast<PersistedStorageWriteBehind *>(aAppState);
+
+    writeBehind->Flush();
+}
+
+} // Weave
+} // nl
@@ -0,0 +1,104 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ * @file
+ *
+ * @brief
+ *   Class declaration for a write-behind cache that coalesces writes to the
+ *   platform's persistent storage into periodic batches.
+ */
+
+#ifndef PERSISTED_STORAGE_WRITE_BEHIND_H
+#define PERSISTED_STORAGE_WRITE_BEHIND_H
+
+#include <Weave/Support/platform/PersistedStorage.h>
+#include <SystemLayer/SystemError.h>
+
+namespace nl {
+namespace Weave {
+
+namespace System {
+class Layer;
+} // namespace System
+
+/**
+ * @class PersistedStorageWriteBehind
+ *
+ * @brief
+ *   A process-wide cache of pending writes to persistent storage.
+ *
+ *   Until Init() is called, Write() writes straight through to persistent
+ *   storage. Once enabled, Write() only records the value; repeated writes
+ *   to the same key are coalesced, and all pending values are written out
+ *   together by Flush(), which runs on a timer every flush interval when a
+ *   system layer is supplied.
+ *
+ *   The cache holds on to the key passed to Write() rather than a copy, so
+ *   the key must remain valid until its value has been flushed.
+ *
+ *   Callers that must know a value is durable before acting on it, such as
+ *   PersistedCounter before vending a value from a new epoch, call Flush()
+ *   themselves when IsPending() reports the key still outstanding.
+ *
+ *   Methods on this class are not thread-safe and must be called from the
+ *   thread that drives the supplied system layer.
+ */
+class PersistedStorageWriteBehind
+{
+public:
+    static PersistedStorageWriteBehind & GetInstance(void);
+
+    WEAVE_ERROR Init(System::Layer * aSystemLayer, uint32_t aFlushIntervalMsec);
+    WEAVE_ERROR Shutdown(void);
+    bool IsEnabled(void) const;
+
+    WEAVE_ERROR Write(nl::Weave::Platform::PersistedStorage::Key aKey, uint32_t aValue);
+    WEAVE_ERROR Flush(void);
+    bool IsPending(nl::Weave::Platform::PersistedStorage::Key aKey) const;
+
+private:
+    PersistedStorageWriteBehind(void);
+
+    nl::Weave::Platform::PersistedStorage::Key mPendingKeys[WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS];
+    uint32_t mPendingValues[WEAVE_CONFIG_PERSISTED_STORAGE_WRITE_BEHIND_MAX_KEYS];
+    uint8_t mNumPending;
+    bool mIsEnabled;
+    System::Layer * mSystemLayer;
+    uint32_t mFlushIntervalMsec;
+
+    void ScheduleFlush(void);
+    static void HandleFlushTimer(System::Layer * aSystemLayer, void * aAppState, System::Error aError);
+
+    static PersistedStorageWriteBehind sInstance;
+};
+
+inline PersistedStorageWriteBehind & PersistedStorageWriteBehind::GetInstance(void)
+{
+    return sInstance;
+}
+
+inline bool PersistedStorageWriteBehind::IsEnabled(void) const
+{
+    return mIsEnabled;
+}
+
+} // Weave
+} // nl
+
+#endif // PERSISTED_STORAGE_WRITE_BEHIND_H
@@ -0,0 +1,298 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a template object for doing counter with
+ *      CBC-MAC (CCM) mode authenticated encryption and a specialized
+ *      object for CCM mode AES-128.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "WeaveCrypto.h"
+#include "CCMMode.h"
+
+namespace nl {
+namespace Weave {
+namespace Crypto {
+
+template <class BlockCipher>
+CCMMode<BlockCipher>::CCMMode() : mBlockCipher()
+{
+    mMacIndex = 0;
+    mKeyStreamIndex = 0;
+    mLengthFieldSize = 0;
+    mTagLength = 0;
+    mPayloadStarted = false;
+    ClearSecretData(mMac, sizeof(mMac));
+    memset(mCounter, 0, sizeof(mCounter));
+    ClearSecretData(mKeyStream, sizeof(mKeyStream));
+    ClearSecretData(mTagMask, sizeof(mTagMask));
+}
+
+template <class BlockCipher>
+CCMMode<BlockCipher>::~CCMMode()
+{
+    Reset();
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::SetKey(const uint8_t *key)
+{
+    mBlockCipher.SetKey(key);
+}
+
+/**
+ * Begin the authenticated encryption or decryption of a message.
+ *
+ * @param[in] nonce         The per-message nonce. The nonce must never be reused with the same key.
+ * @param[in] nonceLen      The length of the nonce, between 7 and 13 bytes. The length field of the
+ *                          CCM blocks occupies the remaining 15 - nonceLen bytes.
+ * @param[in] aadLen        The total length of the additional authenticated data that will be
+ *                          supplied via AddAAD().
+ * @param[in] payloadLen    The total length of the payload that will be supplied via EncryptData()
+ *                          or DecryptData().
+ * @param[in] tagLen        The length of the authentication tag; an even value between 4 and 16.
+ *
+ * @retval #WEAVE_NO_ERROR              On success.
+ * @retval #WEAVE_ERROR_INVALID_ARGUMENT If the nonce or tag length is invalid, or the payload is too
+ *                                      long to be described by the length field.
+ */
+template <class BlockCipher>
+WEAVE_ERROR CCMMode<BlockCipher>::Begin(const uint8_t *nonce, uint8_t nonceLen, uint32_t aadLen, uint32_t payloadLen, uint8_t tagLen)
+{
+    uint8_t lengthFieldSize = kBlockLength - 1 - nonceLen;
+    uint8_t *p;
+
+    if (nonceLen < kMinNonceLength || nonceLen > kMaxNonceLength)
+        return WEAVE_ERROR_INVALID_ARGUMENT;
+    if (tagLen < kMinTagLength || tagLen > kMaxTagLength || (tagLen & 1) != 0)
+        return WEAVE_ERROR_INVALID_ARGUMENT;
+    if (lengthFieldSize < sizeof(uint32_t) && (payloadLen >> (lengthFieldSize * 8)) != 0)
+        return WEAVE_ERROR_INVALID_ARGUMENT;
+
+    mLengthFieldSize = lengthFieldSize;
+    mTagLength = tagLen;
+
+    // Form the first CBC-MAC block (B0):
+    //
+    //      (1 byte)    | (nonceLen bytes) | (lengthFieldSize bytes)
+    //    <flags>       |     <nonce>      |    <payload length>
+    //
+    // where the flags byte encodes the presence of additional data, the tag length and the size
+    // of the length field.
+    mMac[0] = (uint8_t) (((aadLen > 0) ? 0x40 : 0) | (((tagLen - 2) / 2) << 3) | (lengthFieldSize - 1));
+    memcpy(mMac + 1, nonce, nonceLen);
+    p = mMac + kBlockLength;
+    for (uint8_t i = 0; i < lengthFieldSize; i++)
+    {
+        *--p = (uint8_t) payloadLen;
+        payloadLen = (i < sizeof(uint32_t) - 1) ? (payloadLen >> 8) : 0;
+    }
+    mBlockCipher.EncryptBlock(mMac, mMac);
+    mMacIndex = 0;
+    mPayloadStarted = false;
+
+    // Form the initial counter block (A0), which is identical in layout to B0 but carries only the
+    // length field size in its flags byte and the block counter in its length field.
+    mCounter[0] = (uint8_t) (lengthFieldSize - 1);
+    memcpy(mCounter + 1, nonce, nonceLen);
+    memset(mCounter + 1 + nonceLen, 0, lengthFieldSize);
+
+    // The keystream block for counter 0 is reserved for masking the authentication tag.
+    mBlockCipher.EncryptBlock(mCounter, mTagMask);
+    mKeyStreamIndex = kBlockLength;
+
+    // Begin the encoded additional data with its length.
+    if (aadLen > 0)
+    {
+        uint8_t encodedLen[6];
+
+        if (aadLen < 0xFF00)
+        {
+            encodedLen[0] = (uint8_t) (aadLen >> 8);
+            encodedLen[1] = (uint8_t) aadLen;
+            MacData(encodedLen, 2);
+        }
+        else
+        {
+            encodedLen[0] = 0xFF;
+            encodedLen[1] = 0xFE;
+            encodedLen[2] = (uint8_t) (aadLen >> 24);
+            encodedLen[3] = (uint8_t) (aadLen >> 16);
+            encodedLen[4] = (uint8_t) (aadLen >> 8);
+            encodedLen[5] = (uint8_t) aadLen;
+            MacData(encodedLen, 6);
+        }
+    }
+
+    return WEAVE_NO_ERROR;
+}
+
+/**
+ * Add additional authenticated data. All additional data must be supplied before any payload
+ * data is encrypted or decrypted.
+ */
+template <class BlockCipher>
+void CCMMode<BlockCipher>::AddAAD(const uint8_t *aad, uint16_t aadLen)
+{
+    MacData(aad, aadLen);
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::EncryptData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData)
+{
+    // The CBC-MAC is computed over the plaintext, so it must be updated before the data is
+    // encrypted (possibly in place).
+    BeginPayload();
+    MacData(inData, dataLen);
+    CTRData(inData, dataLen, outData);
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::DecryptData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData)
+{
+    // Decrypt first, then update the CBC-MAC with the recovered plaintext.
+    BeginPayload();
+    CTRData(inData, dataLen, outData);
+    MacData(outData, dataLen);
+}
+
+/**
+ * Finish the operation and output the authentication tag. When decrypting, the caller compares the
+ * result against the received tag using a constant time comparison.
+ */
+template <class BlockCipher>
+void CCMMode<BlockCipher>::Finish(uint8_t *tag)
+{
+    // Pad out the final partial block of payload data.
+    if (mMacIndex != 0)
+    {
+        mBlockCipher.EncryptBlock(mMac, mMac);
+        mMacIndex = 0;
+    }
+
+    for (uint8_t i = 0; i < mTagLength; i++)
+        tag[i] = mMac[i] ^ mTagMask[i];
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::Reset()
+{
+    mBlockCipher.Reset();
+    mMacIndex = 0;
+    mKeyStreamIndex = 0;
+    mLengthFieldSize = 0;
+    mTagLength = 0;
+    mPayloadStarted = false;
+    ClearSecretData(mMac, sizeof(mMac));
+    memset(mCounter, 0, sizeof(mCounter));
+    ClearSecretData(mKeyStream, sizeof(mKeyStream));
+    ClearSecretData(mTagMask, sizeof(mTagMask));
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::MacData(const uint8_t *data, uint16_t dataLen)
+{
+    while (dataLen > 0)
+    {
+        // Fold whole blocks directly into the MAC when aligned; otherwise accumulate a byte at a time.
+        if (mMacIndex == 0 && dataLen >= kBlockLength)
+        {
+            for (uint8_t i = 0; i < kBlockLength; i++)
+                mMac[i] ^= data[i];
+            mBlockCipher.EncryptBlock(mMac, mMac);
+            data += kBlockLength;
+            dataLen -= kBlockLength;
+            continue;
+        }
+
+        mMac[mMacIndex++] ^= *data++;
+        dataLen--;
+
+        if (mMacIndex == kBlockLength)
+        {
+            mBlockCipher.EncryptBlock(mMac, mMac);
+            mMacIndex = 0;
+        }
+    }
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::BeginPayload()
+{
+    // The additional data is zero padded to a block boundary before the payload begins. Payload
+    // data supplied across several calls is contiguous and is only padded by Finish().
+    if (!mPayloadStarted)
+    {
+        if (mMacIndex != 0)
+        {
+            mBlockCipher.EncryptBlock(mMac, mMac);
+            mMacIndex = 0;
+        }
+        mPayloadStarted = true;
+    }
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::CTRData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData)
+{
+    while (dataLen > 0)
+    {
+        if (mKeyStreamIndex == kBlockLength)
+            NextKeyStreamBlock();
+
+        // XOR whole keystream blocks at once when aligned.
+        if (mKeyStreamIndex == 0 && dataLen >= kBlockLength)
+        {
+            for (uint8_t i = 0; i < kBlockLength; i++)
+                outData[i] = inData[i] ^ mKeyStream[i];
+            mKeyStreamIndex = kBlockLength;
+            inData += kBlockLength;
+            outData += kBlockLength;
+            dataLen -= kBlockLength;
+            continue;
+        }
+
+        *outData++ = *inData++ ^ mKeyStream[mKeyStreamIndex++];
+        dataLen--;
+    }
+}
+
+template <class BlockCipher>
+void CCMMode<BlockCipher>::NextKeyStreamBlock()
+{
+    // Bump the counter held in the length field of the counter block.
+    for (uint8_t i = kBlockLength - 1; i >= kBlockLength - mLengthFieldSize; i--)
+    {
+        if (++mCounter[i] != 0)
+            break;
+    }
+
+    mBlockCipher.EncryptBlock(mCounter, mKeyStream);
+    mKeyStreamIndex = 0;
+}
+
+template class CCMMode<Platform::Security::AES128BlockCipherEnc>;
+
+} /* namespace Crypto */
+} /* namespace Weave */
+} /* namespace nl */
@@ -0,0 +1,92 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines a template object for doing counter with CBC-MAC
+ *      (CCM) mode authenticated encryption, as specified in RFC 3610 and
+ *      NIST SP 800-38C, and a specialized object for CCM mode AES-128.
+ *
+ *      The object operates incrementally: additional authenticated data and
+ *      payload may be supplied in any number of pieces, allowing a message
+ *      spread across several buffers to be processed in a single pass.
+ *
+ */
+
+#include <Weave/Support/NLDLLUtil.h>
+
+#include "AESBlockCipher.h"
+
+#ifndef CCMMODE_H_
+#define CCMMODE_H_
+
+namespace nl {
+namespace Weave {
+namespace Crypto {
+
+template <class BlockCipher>
+class NL_DLL_EXPORT CCMMode
+{
+public:
+    enum
+    {
+        kKeyLength      = BlockCipher::kKeyLength,
+        kBlockLength    = BlockCipher::kBlockLength,
+        kMinNonceLength = 7,
+        kMaxNonceLength = 13,
+        kMinTagLength   = 4,
+        kMaxTagLength   = 16
+    };
+
+    CCMMode(void);
+    ~CCMMode(void);
+
+    void SetKey(const uint8_t *key);
+    WEAVE_ERROR Begin(const uint8_t *nonce, uint8_t nonceLen, uint32_t aadLen, uint32_t payloadLen, uint8_t tagLen);
+    void AddAAD(const uint8_t *aad, uint16_t aadLen);
+    void EncryptData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData);
+    void DecryptData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData);
+    void Finish(uint8_t *tag);
+
+    void Reset(void);
+
+private:
+    BlockCipher mBlockCipher;
+    uint8_t mMac[kBlockLength];
+    uint8_t mCounter[kBlockLength];
+    uint8_t mKeyStream[kBlockLength];
+    uint8_t mTagMask[kBlockLength];
+    uint8_t mMacIndex;
+    uint8_t mKeyStreamIndex;
+    uint8_t mLengthFieldSize;
+    uint8_t mTagLength;
+    bool mPayloadStarted;
+
+    void MacData(const uint8_t *data, uint16_t dataLen);
+    void BeginPayload(void);
+    void CTRData(const uint8_t *inData, uint16_t dataLen, uint8_t *outData);
+    void NextKeyStreamBlock(void);
+};
+
+typedef CCMMode<Platform::Security::AES128BlockCipherEnc> AES128CCMMode;
+
+} /* namespace Crypto */
+} /* namespace Weave */
+} /* namespace nl */
+
+#endif /* CCMMODE_H_ */
@@ -0,0 +1,883 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements SHA1 and SHA256 hash functions for the Weave layer.
+ *      This implementation is used when #WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+ *      is enabled (1).
+ *
+ *      Single messages are hashed using the x86 SHA extensions (SHA-NI) and
+ *      several independent messages are hashed in parallel, eight at a time,
+ *      using AVX2.  The processor's support for these features is detected at
+ *      run time; when a feature is not available a portable C implementation
+ *      is used instead, so this implementation may be enabled on any platform.
+ *
+ */
+
+#include <string.h>
+
+#include "WeaveCrypto.h"
+#include "HashAlgos.h"
+
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define WEAVE_SHA_X86_ACCEL 1
+#include <cpuid.h>
+#include <immintrin.h>
+#else
+#define WEAVE_SHA_X86_ACCEL 0
+#endif
+
+namespace nl {
+namespace Weave {
+namespace Platform {
+namespace Security {
+
+using namespace nl::Weave::Crypto;
+
+enum
+{
+    kSHABlockLength             = 64,
+    kSHALengthFieldSize         = 8,
+    kMaxLanes                   = 8
+};
+
+static const uint32_t sSHA1InitialState[5] =
+{
+    0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0
+};
+
+static const uint32_t sSHA256InitialState[8] =
+{
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+static const uint32_t sSHA256RoundConstants[64] =
+{
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208, 0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2
+};
+
+static const uint32_t sSHA1RoundConstants[4] =
+{
+    0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+};
+
+typedef void (*SHABlockFunct)(uint32_t *state, const uint8_t *data, size_t blockCount);
+typedef void (*SHALanesFunct)(uint32_t *laneState, const uint8_t * const *blocks);
+
+// ============================================================
+// Processor feature detection
+// ============================================================
+
+static uint8_t sDetectedAccel = 0xFF;
+static uint8_t sAllowedAccel = kSHAAccel_All;
+
+static uint8_t DetectSHAAcceleration(void)
+{
+    uint8_t accel = kSHAAccel_None;
+
+#if WEAVE_SHA_X86_ACCEL
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        bool hasSSSE3 = (ecx & bit_SSSE3) != 0;
+        bool hasSSE41 = (ecx & bit_SSE4_1) != 0;
+        bool hasOSXSAVE = (ecx & bit_OSXSAVE) != 0;
+        bool hasAVXState = false;
+
+        // AVX2 is only usable if the OS saves the YMM registers on context switch.
+        if (hasOSXSAVE)
+        {
+            uint32_t xcr0Lo, xcr0Hi;
+            __asm__ __volatile__ ("xgetbv" : "=a" (xcr0Lo), "=d" (xcr0Hi) : "c" (0));
+            hasAVXState = (xcr0Lo & 0x6) == 0x6;
+        }
+
+        if (__get_cpuid_max(0, NULL) >= 7)
+        {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+            if ((ebx & bit_SHA) != 0 && hasSSSE3 && hasSSE41)
+                accel |= kSHAAccel_SHANI;
+            if ((ebx & bit_AVX2) != 0 && hasAVXState)
+                accel |= kSHAAccel_AVX2;
+        }
+    }
+#endif // WEAVE_SHA_X86_ACCEL
+
+    return accel;
+}
+
+/**
+ * Get the set of processor features currently used by the SHA1 and SHA256 implementation.
+ *
+ * @return  A bitmask of kSHAAccel_ values.
+ */
+uint8_t GetSHAAcceleration(void)
+{
+    if (sDetectedAccel == 0xFF)
+        sDetectedAccel = DetectSHAAcceleration();
+
+    return sDetectedAccel & sAllowedAccel;
+}
+
+/**
+ * Restrict the set of processor features used by the SHA1 and SHA256 implementation.
+ *
+ * Features not supported by the processor are never used, regardless of this setting.
+ * This is primarily intended for testing the portable implementation on processors
+ * that support the accelerated ones.
+ *
+ * @param[in] allowed   A bitmask of kSHAAccel_ values.
+ */
+void SetSHAAcceleration(uint8_t allowed)
+{
+    sAllowedAccel = allowed;
+}
+
+// ============================================================
+// Portable implementation
+// ============================================================
+
+static inline uint32_t ReadBE32(const uint8_t *p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+static inline void WriteBE32(uint8_t *p, uint32_t val)
+{
+    p[0] = (uint8_t) (val >> 24);
+    p[1] = (uint8_t) (val >> 16);
+    p[2] = (uint8_t) (val >> 8);
+    p[3] = (uint8_t) val;
+}
+
+static inline uint32_t Rotl32(uint32_t val, unsigned int n)
+{
+    return (val << n) | (val >> (32 - n));
+}
+
+static inline uint32_t Rotr32(uint32_t val, unsigned int n)
+{
+    return (val >> n) | (val << (32 - n));
+}
+
+static void SHA1Blocks_Portable(uint32_t *state, const uint8_t *data, size_t blockCount)
+{
+    uint32_t w[16];
+
+    for (; blockCount > 0; blockCount--, data += kSHABlockLength)
+    {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+        for (int t = 0; t < 80; t++)
+        {
+            uint32_t f, k, tmp;
+
+            if (t < 16)
+                w[t] = ReadBE32(data + 4 * t);
+            else
+                w[t & 15] = Rotl32(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);
+
+            if (t < 20)
+                f = (b & c) | (~b & d), k = sSHA1RoundConstants[0];
+            else if (t < 40)
+                f = b ^ c ^ d, k = sSHA1RoundConstants[1];
+            else if (t < 60)
+                f = (b & c) | (b & d) | (c & d), k = sSHA1RoundConstants[2];
+            else
+                f = b ^ c ^ d, k = sSHA1RoundConstants[3];
+
+            tmp = Rotl32(a, 5) + f + e + k + w[t & 15];
+            e = d;
+            d = c;
+            c = Rotl32(b, 30);
+            b = a;
+            a = tmp;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+static void SHA256Blocks_Portable(uint32_t *state, const uint8_t *data, size_t blockCount)
+{
+    uint32_t w[16];
+
+    for (; blockCount > 0; blockCount--, data += kSHABlockLength)
+    {
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int t = 0; t < 64; t++)
+        {
+            uint32_t t1, t2;
+
+            if (t < 16)
+                w[t] = ReadBE32(data + 4 * t);
+            else
+            {
+                uint32_t w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+                w[t & 15] += (Rotr32(w15, 7) ^ Rotr32(w15, 18) ^ (w15 >> 3)) + w[(t - 7) & 15] +
+                             (Rotr32(w2, 17) ^ Rotr32(w2, 19) ^ (w2 >> 10));
+            }
+
+            t1 = h + (Rotr32(e, 6) ^ Rotr32(e, 11) ^ Rotr32(e, 25)) + ((e & f) ^ (~e & g)) + sSHA256RoundConstants[t] + w[t & 15];
+            t2 = (Rotr32(a, 2) ^ Rotr32(a, 13) ^ Rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+#if WEAVE_SHA_X86_ACCEL
+
+// ============================================================
+// SHA extensions (SHA-NI) implementation
+// ============================================================
+
+#define WEAVE_SHANI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+// Perform four SHA1 rounds using the message words in MSG and the round function selected by FUNC.
+#define SHA1_ROUNDS4(ABCD, E, PREV_ABCD, MSG, FUNC)                     \
+do {                                                                    \
+    E = _mm_sha1nexte_epu32(E, MSG);                                    \
+    PREV_ABCD = ABCD;                                                   \
+    ABCD = _mm_sha1rnds4_epu32(ABCD, E, FUNC);                          \
+} while (0)
+
+// Compute the next four SHA1 message words from the previous sixteen.
+#define SHA1_SCHEDULE(M0, M1, M2, M3)                                   \
+    M0 = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(M0, M1), M2), M3)
+
+WEAVE_SHANI_TARGET
+static void SHA1Blocks_SHANI(uint32_t *state, const uint8_t *data, size_t blockCount)
+{
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+    __m128i abcd, abcdSave, e0, e1, eSave, m0, m1, m2, m3;
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1B);
+    e0 = _mm_set_epi32((int) state[4], 0, 0, 0);
+
+    for (; blockCount > 0; blockCount--, data += kSHABlockLength)
+    {
+        abcdSave = abcd;
+        eSave = e0;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 0)), byteSwapMask);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), byteSwapMask);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), byteSwapMask);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), byteSwapMask);
+
+        // Rounds 0-3 (the first group adds the message words to E directly).
+        e0 = _mm_add_epi32(e0, m0);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+        // Rounds 4-19
+        SHA1_ROUNDS4(abcd, e1, e0, m1, 0);
+        SHA1_ROUNDS4(abcd, e0, e1, m2, 0);
+        SHA1_ROUNDS4(abcd, e1, e0, m3, 0);
+        SHA1_SCHEDULE(m0, m1, m2, m3);
+        SHA1_ROUNDS4(abcd, e0, e1, m0, 0);
+
+        // Rounds 20-39
+        SHA1_SCHEDULE(m1, m2, m3, m0);
+        SHA1_ROUNDS4(abcd, e1, e0, m1, 1);
+        SHA1_SCHEDULE(m2, m3, m0, m1);
+        SHA1_ROUNDS4(abcd, e0, e1, m2, 1);
+        SHA1_SCHEDULE(m3, m0, m1, m2);
+        SHA1_ROUNDS4(abcd, e1, e0, m3, 1);
+        SHA1_SCHEDULE(m0, m1, m2, m3);
+        SHA1_ROUNDS4(abcd, e0, e1, m0, 1);
+        SHA1_SCHEDULE(m1, m2, m3, m0);
+        SHA1_ROUNDS4(abcd, e1, e0, m1, 1);
+
+        // Rounds 40-59
+        SHA1_SCHEDULE(m2, m3, m0, m1);
+        SHA1_ROUNDS4(abcd, e0, e1, m2, 2);
+        SHA1_SCHEDULE(m3, m0, m1, m2);
+        SHA1_ROUNDS4(abcd, e1, e0, m3, 2);
+        SHA1_SCHEDULE(m0, m1, m2, m3);
+        SHA1_ROUNDS4(abcd, e0, e1, m0, 2);
+        SHA1_SCHEDULE(m1, m2, m3, m0);
+        SHA1_ROUNDS4(abcd, e1, e0, m1, 2);
+        SHA1_SCHEDULE(m2, m3, m0, m1);
+        SHA1_ROUNDS4(abcd, e0, e1, m2, 2);
+
+        // Rounds 60-79
+        SHA1_SCHEDULE(m3, m0, m1, m2);
+        SHA1_ROUNDS4(abcd, e1, e0, m3, 3);
+        SHA1_SCHEDULE(m0, m1, m2, m3);
+        SHA1_ROUNDS4(abcd, e0, e1, m0, 3);
+        SHA1_SCHEDULE(m1, m2, m3, m0);
+        SHA1_ROUNDS4(abcd, e1, e0, m1, 3);
+        SHA1_SCHEDULE(m2, m3, m0, m1);
+        SHA1_ROUNDS4(abcd, e0, e1, m2, 3);
+        SHA1_SCHEDULE(m3, m0, m1, m2);
+        SHA1_ROUNDS4(abcd, e1, e0, m3, 3);
+
+        // Add this block's result to the state.
+        e0 = _mm_sha1nexte_epu32(e0, eSave);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+    }
+
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+// Perform four SHA256 rounds using the message words in MSG and round constants K[I..I+3].
+#define SHA256_ROUNDS4(STATE0, STATE1, MSG, I)                                                      \
+do {                                                                                                \
+    __m128i _wk = _mm_add_epi32(MSG, _mm_loadu_si128((const __m128i *) &sSHA256RoundConstants[I])); \
+    STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, _wk);                                            \
+    STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, _mm_shuffle_epi32(_wk, 0x0E));                   \
+} while (0)
+
+// Compute the next four SHA256 message words from the previous sixteen.
+#define SHA256_SCHEDULE(M0, M1, M2, M3)                                                             \
+    M0 = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(M0, M1), _mm_alignr_epi8(M3, M2, 4)), M3)
+
+WEAVE_SHANI_TARGET
+static void SHA256Blocks_SHANI(uint32_t *state, const uint8_t *data, size_t blockCount)
+{
+    const __m128i byteSwapMask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+    __m128i state0, state1, tmp, abefSave, cdghSave, m0, m1, m2, m3;
+
+    // Rearrange the state into the ABEF/CDGH form used by the SHA256 instructions.
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blockCount > 0; blockCount--, data += kSHABlockLength)
+    {
+        abefSave = state0;
+        cdghSave = state1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 0)), byteSwapMask);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), byteSwapMask);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), byteSwapMask);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), byteSwapMask);
+
+        SHA256_ROUNDS4(state0, state1, m0, 0);
+        SHA256_ROUNDS4(state0, state1, m1, 4);
+        SHA256_ROUNDS4(state0, state1, m2, 8);
+        SHA256_ROUNDS4(state0, state1, m3, 12);
+
+        for (int i = 16; i < 64; i += 16)
+        {
+            SHA256_SCHEDULE(m0, m1, m2, m3);
+            SHA256_ROUNDS4(state0, state1, m0, i);
+            SHA256_SCHEDULE(m1, m2, m3, m0);
+            SHA256_ROUNDS4(state0, state1, m1, i + 4);
+            SHA256_SCHEDULE(m2, m3, m0, m1);
+            SHA256_ROUNDS4(state0, state1, m2, i + 8);
+            SHA256_SCHEDULE(m3, m0, m1, m2);
+            SHA256_ROUNDS4(state0, state1, m3, i + 12);
+        }
+
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    // Return the state to ABCD/EFGH order.
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i *) &state[0], state0);
+    _mm_storeu_si128((__m128i *) &state[4], state1);
+}
+
+// ============================================================
+// AVX2 multi-buffer implementation
+//
+// Each 256-bit register holds the same 32-bit word for eight independent messages (lanes).
+// Lane states are stored word-major: laneState[word * kMaxLanes + lane].
+// ============================================================
+
+#define WEAVE_AVX2_TARGET __attribute__((target("avx2")))
+
+#define V_ADD(A, B)         _mm256_add_epi32(A, B)
+#define V_XOR(A, B)         _mm256_xor_si256(A, B)
+#define V_AND(A, B)         _mm256_and_si256(A, B)
+#define V_ANDNOT(A, B)      _mm256_andnot_si256(A, B)
+#define V_OR(A, B)          _mm256_or_si256(A, B)
+#define V_ROTL(X, N)        _mm256_or_si256(_mm256_slli_epi32(X, N), _mm256_srli_epi32(X, 32 - (N)))
+#define V_ROTR(X, N)        _mm256_or_si256(_mm256_srli_epi32(X, N), _mm256_slli_epi32(X, 32 - (N)))
+#define V_SET1(X)           _mm256_set1_epi32((int) (X))
+
+// Load the big-endian message word at offset OFF from each lane's block.
+#define V_LOAD_WORD(BLOCKS, OFF)                                                                    \
+    _mm256_set_epi32((int) ReadBE32(BLOCKS[7] + OFF), (int) ReadBE32(BLOCKS[6] + OFF),              \
+                     (int) ReadBE32(BLOCKS[5] + OFF), (int) ReadBE32(BLOCKS[4] + OFF),              \
+                     (int) ReadBE32(BLOCKS[3] + OFF), (int) ReadBE32(BLOCKS[2] + OFF),              \
+                     (int) ReadBE32(BLOCKS[1] + OFF), (int) ReadBE32(BLOCKS[0] + OFF))
+
+WEAVE_AVX2_TARGET
+static void SHA1Lanes_AVX2(uint32_t *laneState, const uint8_t * const *blocks)
+{
+    __m256i w[16];
+    __m256i a, b, c, d, e, f, k, tmp;
+
+    a = _mm256_loadu_si256((const __m256i *) &laneState[0 * kMaxLanes]);
+    b = _mm256_loadu_si256((const __m256i *) &laneState[1 * kMaxLanes]);
+    c = _mm256_loadu_si256((const __m256i *) &laneState[2 * kMaxLanes]);
+    d = _mm256_loadu_si256((const __m256i *) &laneState[3 * kMaxLanes]);
+    e = _mm256_loadu_si256((const __m256i *) &laneState[4 * kMaxLanes]);
+
+    for (int t = 0; t < 80; t++)
+    {
+        if (t < 16)
+            w[t] = V_LOAD_WORD(blocks, 4 * t);
+        else
+        {
+            tmp = V_XOR(V_XOR(w[(t - 3) & 15], w[(t - 8) & 15]), V_XOR(w[(t - 14) & 15], w[t & 15]));
+            w[t & 15] = V_ROTL(tmp, 1);
+        }
+
+        if (t < 20)
+            f = V_OR(V_AND(b, c), V_ANDNOT(b, d)), k = V_SET1(sSHA1RoundConstants[0]);
+        else if (t < 40)
+            f = V_XOR(V_XOR(b, c), d), k = V_SET1(sSHA1RoundConstants[1]);
+        else if (t < 60)
+            f = V_OR(V_AND(b, c), V_AND(d, V_OR(b, c))), k = V_SET1(sSHA1RoundConstants[2]);
+        else
+            f = V_XOR(V_XOR(b, c), d), k = V_SET1(sSHA1RoundConstants[3]);
+
+        tmp = V_ADD(V_ADD(V_ROTL(a, 5), f), V_ADD(V_ADD(e, k), w[t & 15]));
+        e = d;
+        d = c;
+        c = V_ROTL(b, 30);
+        b = a;
+        a = tmp;
+    }
+
+    a = V_ADD(a, _mm256_loadu_si256((const __m256i *) &laneState[0 * kMaxLanes]));
+    b = V_ADD(b, _mm256_loadu_si256((const __m256i *) &laneState[1 * kMaxLanes]));
+    c = V_ADD(c, _mm256_loadu_si256((const __m256i *) &laneState[2 * kMaxLanes]));
+    d = V_ADD(d, _mm256_loadu_si256((const __m256i *) &laneState[3 * kMaxLanes]));
+    e = V_ADD(e, _mm256_loadu_si256((const __m256i *) &laneState[4 * kMaxLanes]));
+
+    _mm256_storeu_si256((__m256i *) &laneState[0 * kMaxLanes], a);
+    _mm256_storeu_si256((__m256i *) &laneState[1 * kMaxLanes], b);
+    _mm256_storeu_si256((__m256i *) &laneState[2 * kMaxLanes], c);
+    _mm256_storeu_si256((__m256i *) &laneState[3 * kMaxLanes], d);
+    _mm256_storeu_si256((__m256i *) &laneState[4 * kMaxLanes], e);
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+WEAVE_AVX2_TARGET
+static void SHA256Lanes_AVX2(uint32_t *laneState, const uint8_t * const *blocks)
+{
+    __m256i w[16];
+    __m256i s[8];
+    __m256i a, b, c, d, e, f, g, h, t1, t2;
+
+    for (int i = 0; i < 8; i++)
+        s[i] = _mm256_loadu_si256((const __m256i *) &laneState[i * kMaxLanes]);
+
+    a = s[0]; b = s[1]; c = s[2]; d = s[3];
+    e = s[4]; f = s[5]; g = s[6]; h = s[7];
+
+    for (int t = 0; t < 64; t++)
+    {
+        if (t < 16)
+            w[t] = V_LOAD_WORD(blocks, 4 * t);
+        else
+        {
+            __m256i w15 = w[(t - 15) & 15], w2 = w[(t - 2) & 15];
+            __m256i sigma0 = V_XOR(V_XOR(V_ROTR(w15, 7), V_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i sigma1 = V_XOR(V_XOR(V_ROTR(w2, 17), V_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w[t & 15] = V_ADD(V_ADD(w[t & 15], sigma0), V_ADD(w[(t - 7) & 15], sigma1));
+        }
+
+        t1 = V_ADD(V_ADD(h, V_XOR(V_XOR(V_ROTR(e, 6), V_ROTR(e, 11)), V_ROTR(e, 25))),
+                   V_ADD(V_XOR(V_AND(e, f), V_ANDNOT(e, g)), V_ADD(V_SET1(sSHA256RoundConstants[t]), w[t & 15])));
+        t2 = V_ADD(V_XOR(V_XOR(V_ROTR(a, 2), V_ROTR(a, 13)), V_ROTR(a, 22)),
+                   V_XOR(V_AND(a, b), V_AND(c, V_XOR(a, b))));
+        h = g;
+        g = f;
+        f = e;
+        e = V_ADD(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = V_ADD(t1, t2);
+    }
+
+    s[0] = V_ADD(s[0], a); s[1] = V_ADD(s[1], b); s[2] = V_ADD(s[2], c); s[3] = V_ADD(s[3], d);
+    s[4] = V_ADD(s[4], e); s[5] = V_ADD(s[5], f); s[6] = V_ADD(s[6], g); s[7] = V_ADD(s[7], h);
+
+    for (int i = 0; i < 8; i++)
+        _mm256_storeu_si256((__m256i *) &laneState[i * kMaxLanes], s[i]);
+
+    ClearSecretData((uint8_t *) w, sizeof(w));
+}
+
+#endif // WEAVE_SHA_X86_ACCEL
+
+// ============================================================
+// Common hashing logic
+// ============================================================
+
+static inline SHABlockFunct SHA1BlockFunct(void)
+{
+#if WEAVE_SHA_X86_ACCEL
+    if ((GetSHAAcceleration() & kSHAAccel_SHANI) != 0)
+        return SHA1Blocks_SHANI;
+#endif
+    return SHA1Blocks_Portable;
+}
+
+static inline SHABlockFunct SHA256BlockFunct(void)
+{
+#if WEAVE_SHA_X86_ACCEL
+    if ((GetSHAAcceleration() & kSHAAccel_SHANI) != 0)
+        return SHA256Blocks_SHANI;
+#endif
+    return SHA256Blocks_Portable;
+}
+
+static void HashUpdate(SHABlockFunct blockFunct, uint32_t *state, uint8_t *block, uint64_t &msgLen,
+                       const uint8_t *data, uint16_t dataLen)
+{
+    uint8_t blockIndex = (uint8_t) (msgLen % kSHABlockLength);
+
+    msgLen += dataLen;
+
+    // Complete any partially filled block.
+    if (blockIndex > 0)
+    {
+        uint16_t copyLen = kSHABlockLength - blockIndex;
+        if (copyLen > dataLen)
+            copyLen = dataLen;
+
+        memcpy(block + blockIndex, data, copyLen);
+        data += copyLen;
+        dataLen -= copyLen;
+        blockIndex += copyLen;
+
+        if (blockIndex < kSHABlockLength)
+            return;
+
+        blockFunct(state, block, 1);
+    }
+
+    // Hash whole blocks directly from the input.
+    if (dataLen >= kSHABlockLength)
+    {
+        size_t blockCount = dataLen / kSHABlockLength;
+        blockFunct(state, data, blockCount);
+        data += blockCount * kSHABlockLength;
+        dataLen -= blockCount * kSHABlockLength;
+    }
+
+    // Save any remaining input.
+    memcpy(block, data, dataLen);
+}
+
+// Form the final one or two padded blocks of a message in padBuf and return the number of blocks.
+static uint8_t FormFinalBlocks(const uint8_t *tail, uint8_t tailLen, uint64_t msgLen, uint8_t *padBuf)
+{
+    uint8_t padBlockCount = (tailLen + 1 + kSHALengthFieldSize > kSHABlockLength) ? 2 : 1;
+    uint8_t *lenField = padBuf + padBlockCount * kSHABlockLength - kSHALengthFieldSize;
+    uint64_t bitLen = msgLen * 8;
+
+    memcpy(padBuf, tail, tailLen);
+    padBuf[tailLen] = 0x80;
+    memset(padBuf + tailLen + 1, 0, lenField - (padBuf + tailLen + 1));
+
+    WriteBE32(lenField, (uint32_t) (bitLen >> 32));
+    WriteBE32(lenField + 4, (uint32_t) bitLen);
+
+    return padBlockCount;
+}
+
+static void HashFinish(SHABlockFunct blockFunct, uint32_t *state, const uint8_t *block, uint64_t msgLen,
+                       uint8_t stateWords, uint8_t *hashBuf)
+{
+    uint8_t padBuf[2 * kSHABlockLength];
+    uint8_t padBlockCount;
+
+    padBlockCount = FormFinalBlocks(block, (uint8_t) (msgLen % kSHABlockLength), msgLen, padBuf);
+    blockFunct(state, padBuf, padBlockCount);
+
+    for (uint8_t i = 0; i < stateWords; i++)
+        WriteBE32(hashBuf + 4 * i, state[i]);
+
+    ClearSecretData(padBuf, sizeof(padBuf));
+}
+
+#if WEAVE_SHA_X86_ACCEL
+
+/**
+ * Hash up to eight messages in parallel, one message per lane.
+ */
+static void HashLanes(SHALanesFunct lanesFunct, const uint32_t *initialState, uint8_t stateWords,
+                      const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs)
+{
+    static const uint8_t sIdleBlock[kSHABlockLength] = { 0 };
+    uint32_t laneState[8 * kMaxLanes];
+    uint8_t padBufs[kMaxLanes][2 * kSHABlockLength];
+    uint16_t fullBlockCounts[kMaxLanes];
+    uint16_t totalBlockCounts[kMaxLanes];
+    const uint8_t *blocks[kMaxLanes];
+    uint16_t maxBlockCount = 0;
+
+    for (uint8_t word = 0; word < stateWords; word++)
+        for (uint8_t lane = 0; lane < kMaxLanes; lane++)
+            laneState[word * kMaxLanes + lane] = initialState[word];
+
+    for (uint8_t lane = 0; lane < kMaxLanes; lane++)
+    {
+        if (lane < count)
+        {
+            uint16_t fullBlockCount = dataLens[lane] / kSHABlockLength;
+            uint8_t tailLen = (uint8_t) (dataLens[lane] % kSHABlockLength);
+
+            fullBlockCounts[lane] = fullBlockCount;
+            totalBlockCounts[lane] = fullBlockCount +
+                FormFinalBlocks(dataBufs[lane] + fullBlockCount * kSHABlockLength, tailLen, dataLens[lane], padBufs[lane]);
+        }
+        else
+        {
+            fullBlockCounts[lane] = 0;
+            totalBlockCounts[lane] = 0;
+        }
+
+        if (totalBlockCounts[lane] > maxBlockCount)
+            maxBlockCount = totalBlockCounts[lane];
+    }
+
+    for (uint16_t blockNum = 0; blockNum < maxBlockCount; blockNum++)
+    {
+        for (uint8_t lane = 0; lane < kMaxLanes; lane++)
+        {
+            if (blockNum < fullBlockCounts[lane])
+                blocks[lane] = dataBufs[lane] + blockNum * kSHABlockLength;
+            else if (blockNum < totalBlockCounts[lane])
+                blocks[lane] = padBufs[lane] + (blockNum - fullBlockCounts[lane]) * kSHABlockLength;
+            else
+                blocks[lane] = sIdleBlock;
+        }
+
+        lanesFunct(laneState, blocks);
+
+        // Output the hash of each message whose final block was just processed.
+        for (uint8_t lane = 0; lane < count; lane++)
+            if (blockNum + 1 == totalBlockCounts[lane])
+                for (uint8_t word = 0; word < stateWords; word++)
+                    WriteBE32(hashBufs + lane * stateWords * 4 + word * 4, laneState[word * kMaxLanes + lane]);
+    }
+
+    ClearSecretData((uint8_t *) padBufs, sizeof(padBufs));
+    ClearSecretData((uint8_t *) laneState, sizeof(laneState));
+}
+
+#endif // WEAVE_SHA_X86_ACCEL
+
+// ============================================================
+// SHA1
+// ============================================================
+
+SHA1::SHA1()
+{
+    memset(&mSHACtx, 0, sizeof(mSHACtx));
+}
+
+SHA1::~SHA1()
+{
+    Reset();
+}
+
+void SHA1::Begin()
+{
+    memcpy(mSHACtx.State, sSHA1InitialState, sizeof(mSHACtx.State));
+    mSHACtx.MsgLen = 0;
+}
+
+void SHA1::AddData(const uint8_t *data, uint16_t dataLen)
+{
+    HashUpdate(SHA1BlockFunct(), mSHACtx.State, mSHACtx.Block, mSHACtx.MsgLen, data, dataLen);
+}
+
+void SHA1::Finish(uint8_t *hashBuf)
+{
+    HashFinish(SHA1BlockFunct(), mSHACtx.State, mSHACtx.Block, mSHACtx.MsgLen, kHashLength / 4, hashBuf);
+    Reset();
+}
+
+void SHA1::Reset()
+{
+    ClearSecretData((uint8_t *) &mSHACtx, sizeof(mSHACtx));
+}
+
+/**
+ * Compute the SHA1 hashes of several independent messages.
+ *
+ * When the processor supports AVX2, up to eight messages are hashed in parallel.
+ *
+ * @param[in]  dataBufs     An array of count pointers to the messages.
+ * @param[in]  dataLens     An array of count message lengths.
+ * @param[in]  count        The number of messages.
+ * @param[out] hashBufs     A buffer of count * kHashLength bytes that receives the hashes, in order.
+ */
+void SHA1::HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs)
+{
+#if WEAVE_SHA_X86_ACCEL
+    if ((GetSHAAcceleration() & kSHAAccel_AVX2) != 0)
+    {
+        for (; count > 1; dataBufs += kMaxLanes, dataLens += kMaxLanes, hashBufs += kMaxLanes * kHashLength)
+        {
+            uint8_t laneCount = (count < kMaxLanes) ? count : (uint8_t) kMaxLanes;
+            HashLanes(SHA1Lanes_AVX2, sSHA1InitialState, kHashLength / 4, dataBufs, dataLens, laneCount, hashBufs);
+            count -= laneCount;
+        }
+    }
+#endif
+
+    // Hash any remaining messages individually.
+    if (count > 0)
+    {
+        SHA1 sha1;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            sha1.Begin();
+            sha1.AddData(dataBufs[i], dataLens[i]);
+            sha1.Finish(hashBufs + i * kHashLength);
+        }
+    }
+}
+
+// ============================================================
+// SHA256
+// ============================================================
+
+SHA256::SHA256()
+{
+    memset(&mSHACtx, 0, sizeof(mSHACtx));
+}
+
+SHA256::~SHA256()
+{
+    Reset();
+}
+
+void SHA256::Begin()
+{
+    memcpy(mSHACtx.State, sSHA256InitialState, sizeof(mSHACtx.State));
+    mSHACtx.MsgLen = 0;
+}
+
+void SHA256::AddData(const uint8_t *data, uint16_t dataLen)
+{
+    HashUpdate(SHA256BlockFunct(), mSHACtx.State, mSHACtx.Block, mSHACtx.MsgLen, data, dataLen);
+}
+
+void SHA256::Finish(uint8_t *hashBuf)
+{
+    HashFinish(SHA256BlockFunct(), mSHACtx.State, mSHACtx.Block, mSHACtx.MsgLen, kHashLength / 4, hashBuf);
+    Reset();
+}
+
+void SHA256::Reset()
+{
+    ClearSecretData((uint8_t *) &mSHACtx, sizeof(mSHACtx));
+}
+
+/**
+ * Compute the SHA256 hashes of several independent messages.
+ *
+ * When the processor supports AVX2, up to eight messages are hashed in parallel.
+ *
+ * @param[in]  dataBufs     An array of count pointers to the messages.
+ * @param[in]  dataLens     An array of count message lengths.
+ * @param[in]  count        The number of messages.
+ * @param[out] hashBufs     A buffer of count * kHashLength bytes that receives the hashes, in order.
+ */
+void SHA256::HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs)
+{
+#if WEAVE_SHA_X86_ACCEL
+    if ((GetSHAAcceleration() & kSHAAccel_AVX2) != 0)
+    {
+        for (; count > 1; dataBufs += kMaxLanes, dataLens += kMaxLanes, hashBufs += kMaxLanes * kHashLength)
+        {
+            uint8_t laneCount = (count < kMaxLanes) ? count : (uint8_t) kMaxLanes;
+            HashLanes(SHA256Lanes_AVX2, sSHA256InitialState, kHashLength / 4, dataBufs, dataLens, laneCount, hashBufs);
+            count -= laneCount;
+        }
+    }
+#endif
+
+    // Hash any remaining messages individually.
+    if (count > 0)
+    {
+        SHA256 sha256;
+
+        for (uint8_t i = 0; i < count; i++)
+        {
+            sha256.Begin();
+            sha256.AddData(dataBufs[i], dataLens[i]);
+            sha256.Finish(hashBufs + i * kHashLength);
+        }
+    }
+}
+
+} /* namespace Security */
+} /* namespace Platform */
+} /* namespace Weave */
+} /* namespace nl */
+
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
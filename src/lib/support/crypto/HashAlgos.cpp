@@ -0,0 +1,84 @@
+/*
+ *
+ *    Copyright (c) 2017 Nest Labs, Inc.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements hash functions that are common to all of the
+ *      SHA1 and SHA256 implementations that do not provide their own
+ *      multi-buffer support.
+ *
+ */
+
+#include <string.h>
+
+#include "WeaveCrypto.h"
+#include "HashAlgos.h"
+
+namespace nl {
+namespace Weave {
+namespace Platform {
+namespace Security {
+
+#if !WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
+/**
+ * Compute the SHA1 hashes of several independent messages.
+ *
+ * @param[in]  dataBufs     An array of count pointers to the messages.
+ * @param[in]  dataLens     An array of count message lengths.
+ * @param[in]  count        The number of messages.
+ * @param[out] hashBufs     A buffer of count * kHashLength bytes that receives the hashes, in order.
+ */
+void SHA1::HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs)
+{
+    SHA1 sha1;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sha1.Begin();
+        sha1.AddData(dataBufs[i], dataLens[i]);
+        sha1.Finish(hashBufs + i * kHashLength);
+    }
+}
+
+/**
+ * Compute the SHA256 hashes of several independent messages.
+ *
+ * @param[in]  dataBufs     An array of count pointers to the messages.
+ * @param[in]  dataLens     An array of count message lengths.
+ * @param[in]  count        The number of messages.
+ * @param[out] hashBufs     A buffer of count * kHashLength bytes that receives the hashes, in order.
+ */
+void SHA256::HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs)
+{
+    SHA256 sha256;
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sha256.Begin();
+        sha256.AddData(dataBufs[i], dataLens[i]);
+        sha256.Finish(hashBufs + i * kHashLength);
+    }
+}
+
+#endif // !WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
+} /* namespace Security */
+} /* namespace Platform */
+} /* namespace Weave */
+} /* namespace nl */
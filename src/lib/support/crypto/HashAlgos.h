@@ -35,6 +35,12 @@
  *      The platform-specific header file should include declarations of the
  *      SHA_CTX_PLATFORM and SHA256_CTX_PLATFORM context structures.
  *
+ *      Each hash class also provides HashMultiple(), which computes the hashes
+ *      of several independent messages in one call.  The in-tree implementation
+ *      selected by #WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI processes up to eight
+ *      such messages in parallel using AVX2; other implementations hash the
+ *      messages one at a time.
+ *
  */
 
 #ifndef HashAlgos_H_
@@ -83,6 +89,40 @@ namespace Weave {
 namespace Platform {
 namespace Security {
 
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
+// Hash contexts for the in-tree SHA implementation, which uses the x86 SHA extensions or AVX2
+// when the processor supports them.
+struct SHA1_CTX_SHANI
+{
+    uint32_t State[5];
+    uint64_t MsgLen;
+    uint8_t Block[64];
+};
+
+struct SHA256_CTX_SHANI
+{
+    uint32_t State[8];
+    uint64_t MsgLen;
+    uint8_t Block[64];
+};
+
+/**
+ *  Processor features used by the in-tree SHA implementation.
+ */
+enum
+{
+    kSHAAccel_None              = 0x00,     /**< Portable C implementation only. */
+    kSHAAccel_SHANI             = 0x01,     /**< x86 SHA extensions, used for single messages. */
+    kSHAAccel_AVX2              = 0x02,     /**< AVX2, used to hash up to 8 messages in parallel. */
+    kSHAAccel_All               = kSHAAccel_SHANI | kSHAAccel_AVX2
+};
+
+extern uint8_t GetSHAAcceleration(void);
+extern void SetSHAAcceleration(uint8_t allowed);
+
+#endif // WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+
 class NL_DLL_EXPORT SHA1
 {
 public:
@@ -103,6 +143,8 @@ public:
     void Finish(uint8_t *hashBuf);
     void Reset(void);
 
+    static void HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs);
+
 private:
 #if WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
     SHA_CTX mSHACtx;
@@ -110,6 +152,8 @@ private:
     MINCRYPT_SHA_CTX mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS
     mbedtls_sha1_context mSHACtx;
+#elif WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+    SHA1_CTX_SHANI mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
     SHA_CTX_PLATFORM mSHACtx;
 #endif
@@ -135,6 +179,8 @@ public:
     void Finish(uint8_t *hashBuf);
     void Reset(void);
 
+    static void HashMultiple(const uint8_t * const *dataBufs, const uint16_t *dataLens, uint8_t count, uint8_t *hashBufs);
+
 private:
 #if WEAVE_CONFIG_HASH_IMPLEMENTATION_OPENSSL
     SHA256_CTX mSHACtx;
@@ -142,6 +188,8 @@ private:
     MINCRYPT_SHA256_CTX mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_MBEDTLS
     mbedtls_sha256_context mSHACtx;
+#elif WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+    SHA256_CTX_SHANI mSHACtx;
 #elif WEAVE_CONFIG_HASH_IMPLEMENTATION_PLATFORM
     SHA256_CTX_PLATFORM mSHACtx;
 #endif
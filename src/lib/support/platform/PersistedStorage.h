@@ -70,6 +70,25 @@ WEAVE_ERROR Read(Key aKey, uint32_t &aValue);
  */
 WEAVE_ERROR Write(Key aKey, uint32_t aValue);
 
+#if WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+/**
+ *  @brief
+ *    Write the integer values of several keys to persistent storage as a
+ *    single update.  Platforms that can commit several values at the cost
+ *    of one (e.g. with a single file sync or flash page write) provide this
+ *    function by asserting #WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE.
+ *    The semantics for each key are those of Write().
+ *
+ *  @param[in] aKeys     An array of aCount keys.
+ *  @param[in] aValues   An array of aCount values, one per key.
+ *  @param[in] aCount    The number of keys.
+ *
+ *  @return Any error that Write() may return.  On error, none, some or all
+ *          of the values may have been written.
+ */
+WEAVE_ERROR WriteMultiple(const Key *aKeys, const uint32_t *aValues, size_t aCount);
+#endif // WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+
 } // PersistedStorage
 } // Platform
 } // Weave
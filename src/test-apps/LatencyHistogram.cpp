@@ -0,0 +1,188 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a fixed-size, log-linear histogram for recording
+ *      latencies in the test tools.
+ *
+ */
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram(void)
+{
+    Reset();
+}
+
+/**
+ *  Discard all recorded samples.
+ */
+void LatencyHistogram::Reset(void)
+{
+    memset(mBuckets, 0, sizeof(mBuckets));
+    mCount = 0;
+    mSum = 0;
+    mMin = UINT32_MAX;
+    mMax = 0;
+}
+
+/**
+ *  Record one sample.
+ *
+ *  @param[in]  valueUS     The sample, in microseconds.
+ */
+void LatencyHistogram::Record(uint32_t valueUS)
+{
+    mBuckets[BucketIndex(valueUS)]++;
+    mCount++;
+    mSum += valueUS;
+
+    if (valueUS < mMin)
+        mMin = valueUS;
+    if (valueUS > mMax)
+        mMax = valueUS;
+}
+
+/**
+ *  Add all the samples recorded in another histogram to this one.
+ */
+void LatencyHistogram::Add(const LatencyHistogram & other)
+{
+    for (uint32_t i = 0; i < kBucketCount; i++)
+        mBuckets[i] += other.mBuckets[i];
+
+    mCount += other.mCount;
+    mSum += other.mSum;
+
+    if (other.mCount != 0 && other.mMin < mMin)
+        mMin = other.mMin;
+    if (other.mMax > mMax)
+        mMax = other.mMax;
+}
+
+/**
+ *  Get the value below which the given percentage of the recorded samples fall.
+ *
+ *  The value returned is the highest value that falls in the same bucket as the
+ *  sample at the requested rank, limited to the largest sample recorded.
+ *
+ *  @param[in]  percentile  The percentage of samples, between 0 and 100.
+ *
+ *  @return The value at the requested percentile, in microseconds, or 0 if no samples
+ *          have been recorded.
+ */
+uint32_t LatencyHistogram::GetPercentile(double percentile) const
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (mCount == 0)
+        return 0;
+
+    if (percentile <= 0)
+        return mMin;
+
+    if (percentile >= 100)
+        return mMax;
+
+    // The rank of the sample at the requested percentile, counting from 1.
+    rank = (uint64_t) ((percentile * mCount) / 100);
+    if ((double) rank * 100 < percentile * mCount)
+        rank++;
+    if (rank == 0)
+        rank = 1;
+
+    for (uint32_t i = 0; i < kBucketCount; i++)
+    {
+        seen += mBuckets[i];
+        if (seen >= rank)
+        {
+            uint32_t value = BucketHighestValue(i);
+            return (value < mMax) ? value : mMax;
+        }
+    }
+
+    return mMax;
+}
+
+/**
+ *  Print a one-line summary of the recorded samples, in milliseconds.
+ *
+ *  @param[in]  out         The stream to print to.
+ *  @param[in]  title       A title that starts the line.
+ */
+void LatencyHistogram::Print(FILE * out, const char * title) const
+{
+    fprintf(out,
+            "%s: count %" PRIu64 ", min %.3f, mean %.3f, p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f (ms)\n",
+            title, mCount, GetMin() / 1000.0, GetMean() / 1000.0, GetPercentile(50) / 1000.0, GetPercentile(90) / 1000.0,
+            GetPercentile(99) / 1000.0, GetPercentile(99.9) / 1000.0, GetMax() / 1000.0);
+}
+
+/**
+ *  Get the index of the bucket in which a value is recorded.
+ */
+uint32_t LatencyHistogram::BucketIndex(uint32_t value)
+{
+    uint32_t msb;
+    uint32_t shift;
+
+    if (value < kSubBucketCount)
+        return value;
+
+#if defined(__GNUC__)
+    msb = 31 - __builtin_clz(value);
+#else
+    msb = 0;
+    for (uint32_t v = value; v > 1; v >>= 1)
+        msb++;
+#endif
+
+    // Values in [2^msb, 2^(msb+1)) are spread over kSubBucketCount buckets, each
+    // 2^shift wide.
+    shift = msb - kSubBucketBits;
+
+    return (shift + 1) * kSubBucketCount + ((value >> shift) - kSubBucketCount);
+}
+
+/**
+ *  Get the highest value that is recorded in a given bucket.
+ */
+uint32_t LatencyHistogram::BucketHighestValue(uint32_t index)
+{
+    uint32_t shift;
+    uint64_t subBucket;
+    uint64_t value;
+
+    if (index < kSubBucketCount)
+        return index;
+
+    shift = index / kSubBucketCount - 1;
+    subBucket = kSubBucketCount + index % kSubBucketCount;
+    value = ((subBucket + 1) << shift) - 1;
+
+    return (value > UINT32_MAX) ? UINT32_MAX : (uint32_t) value;
+}
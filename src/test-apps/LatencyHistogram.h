@@ -0,0 +1,79 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file defines a fixed-size, log-linear histogram for recording
+ *      latencies in the test tools.
+ *
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ *  @class LatencyHistogram
+ *
+ *  @brief
+ *    Records latency samples, in microseconds, in the style of an HDR histogram.
+ *
+ *    Values below kSubBucketCount are recorded exactly. Above that, every power-of-two
+ *    range is divided into kSubBucketCount equal buckets, so a value is reported with a
+ *    relative error of at most 1 / kSubBucketCount (about 3%). The histogram covers the
+ *    full range of uint32_t in a fixed amount of memory. Recording a sample takes
+ *    constant time and no allocation.
+ */
+class LatencyHistogram
+{
+public:
+    enum
+    {
+        kSubBucketBits  = 5,
+        kSubBucketCount = 1 << kSubBucketBits,
+        kBucketCount    = (32 - kSubBucketBits + 1) * kSubBucketCount,
+    };
+
+    LatencyHistogram(void);
+
+    void Reset(void);
+    void Record(uint32_t valueUS);
+    void Add(const LatencyHistogram & other);
+
+    uint64_t GetCount(void) const { return mCount; }
+    uint32_t GetMin(void) const { return (mCount != 0) ? mMin : 0; }
+    uint32_t GetMax(void) const { return mMax; }
+    uint32_t GetMean(void) const { return (mCount != 0) ? (uint32_t) (mSum / mCount) : 0; }
+    uint32_t GetPercentile(double percentile) const;
+
+    void Print(FILE * out, const char * title) const;
+
+    static uint32_t BucketIndex(uint32_t value);
+    static uint32_t BucketHighestValue(uint32_t index);
+
+private:
+    uint32_t mBuckets[kBucketCount];
+    uint64_t mCount;
+    uint64_t mSum;
+    uint32_t mMin;
+    uint32_t mMax;
+};
+
+#endif // LATENCYHISTOGRAM_H_
@@ -115,6 +115,8 @@ PASEEngineTest::PASEEngineTest(const char *testName)
     mInitiatorAllowedConfigs = mResponderAllowedConfigs = kPASEConfig_Config1|kPASEConfig_Config4;
     mExpectReconfig = false;
     mForceRepeatedReconfig = false;
+    mProposedEncType = mExpectedEncType = kWeaveEncryptionType_AES128CTRSHA1;
+    mLegacyResponder = false;
     memset(mExpectedErrors, 0, sizeof(mExpectedErrors));
     mMutator = &gNullMutator;
     mLogMessageData = false;
@@ -152,6 +154,15 @@ PASEEngineTest& PASEEngineTest::PerformReconfig(bool val) { mForceRepeatedReconf
 bool PASEEngineTest::ConfirmKey() const { return mConfirmKey; }
 PASEEngineTest& PASEEngineTest::ConfirmKey(bool val) { mConfirmKey = val; return *this; }
 
+uint8_t PASEEngineTest::ProposedEncType() const { return mProposedEncType; }
+PASEEngineTest& PASEEngineTest::ProposedEncType(uint8_t val) { mProposedEncType = mExpectedEncType = val; return *this; }
+
+uint8_t PASEEngineTest::ExpectedEncType() const { return mExpectedEncType; }
+PASEEngineTest& PASEEngineTest::ExpectedEncType(uint8_t val) { mExpectedEncType = val; return *this; }
+
+bool PASEEngineTest::LegacyResponder() const { return mLegacyResponder; }
+PASEEngineTest& PASEEngineTest::LegacyResponder(bool val) { mLegacyResponder = val; return *this; }
+
 PASEEngineTest& PASEEngineTest::ExpectError(WEAVE_ERROR err)
 {
     return ExpectError(NULL, err);
@@ -249,7 +260,7 @@ void PASEEngineTest::Run()
     uint64_t initNodeId = 1;
     uint64_t respNodeId = 2;
     uint16_t sessionKeyId = sTestDefaultSessionKeyId;
-    uint16_t encType = kWeaveEncryptionType_AES128CTRSHA1;
+    uint8_t encType = ProposedEncType();
     uint16_t pwSrc = kPasswordSource_PairingCode;
     bool expectSuccess = strcmp(mInitPW, mRespPW) == 0;
 
@@ -294,9 +305,31 @@ onReconfig:
 
     // =========== Responder Processes PASE InitiatorStep1 ================
     err = responderEng.ProcessInitiatorStep1(msgBuf, respNodeId, initNodeId, &respFabricState);
+    if (err == WEAVE_NO_ERROR && LegacyResponder() && responderEng.EncryptionType != kWeaveEncryptionType_AES128CTRSHA1)
+        err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE;
     if (IsExpectedError(INITIATOR_STEP_1, err))
         goto onExpectedError;
 
+    // If the responder rejected the proposed encryption type, restart the session using AES128CTRSHA1,
+    // as WeaveSecurityManager does on receiving the responder's status report.
+    if (err == WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE && encType != kWeaveEncryptionType_AES128CTRSHA1)
+    {
+        if (LogMessageData())
+            printf("Responder: Rejected encryption type %d; restarting with AES128CTRSHA1\n", encType);
+
+        PacketBuffer::Free(msgBuf);
+        msgBuf = NULL;
+
+        initiatorEng.Reset();
+        initiatorEng.Pw = (const uint8_t *)mInitPW;
+        initiatorEng.PwLen = (uint16_t)strlen(mInitPW);
+        responderEng.Reset();
+        respFabricState.Shutdown();
+
+        encType = kWeaveEncryptionType_AES128CTRSHA1;
+        goto onReconfig;
+    }
+
     if (ExpectReconfig())
     {
         VerifyOrQuit(err == WEAVE_ERROR_PASE_RECONFIGURE_REQUIRED, "WEAVE_ERROR_PASE_RECONFIG_REQUIRED error expected");
@@ -466,6 +499,7 @@ onReconfig:
 
     VerifyOrQuit(initiatorEng.SessionKeyId == responderEng.SessionKeyId, "Initiator SessionKeyId != Responder SessionKeyId\n");
     VerifyOrQuit(initiatorEng.EncryptionType == responderEng.EncryptionType, "Initiator EncryptionType != Responder EncryptionType\n");
+    VerifyOrQuit(initiatorEng.EncryptionType == ExpectedEncType(), "Unexpected EncryptionType\n");
     VerifyOrQuit(initiatorEng.PerformKeyConfirmation == responderEng.PerformKeyConfirmation, "Initiator SessionKeyId != Responder SessionKeyId\n");
 
     err = initiatorEng.GetSessionKey(initiatorKey);
@@ -474,10 +508,20 @@ onReconfig:
     err = responderEng.GetSessionKey(responderKey);
     SuccessOrQuit(err, "WeavePASEEngine::GetSessionKey() failed\n");
 
-    VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.DataKey, responderKey->AES128CTRSHA1.DataKey, WeaveEncryptionKey_AES128CTRSHA1::DataKeySize) == 0,
-                 "Data key mismatch\n");
-    VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.IntegrityKey, responderKey->AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize) == 0,
-                 "Integrity key mismatch\n");
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    if (ExpectedEncType() == kWeaveEncryptionType_AES128CCM)
+    {
+        VerifyOrQuit(memcmp(initiatorKey->AES128CCM.Key, responderKey->AES128CCM.Key, WeaveEncryptionKey_AES128CCM::KeySize) == 0,
+                     "Key mismatch\n");
+    }
+    else
+#endif
+    {
+        VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.DataKey, responderKey->AES128CTRSHA1.DataKey, WeaveEncryptionKey_AES128CTRSHA1::DataKeySize) == 0,
+                     "Data key mismatch\n");
+        VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.IntegrityKey, responderKey->AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize) == 0,
+                     "Integrity key mismatch\n");
+    }
 
     // Shutdown the Initiator/Responder FabricState objects
     err = initFabricState.Shutdown();
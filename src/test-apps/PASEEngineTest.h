@@ -81,6 +81,17 @@ public:
     bool ConfirmKey() const;
     PASEEngineTest& ConfirmKey(bool val);
 
+    uint8_t ProposedEncType() const;
+    PASEEngineTest& ProposedEncType(uint8_t val);
+
+    uint8_t ExpectedEncType() const;
+    PASEEngineTest& ExpectedEncType(uint8_t val);
+
+    // A legacy responder behaves like a peer that predates support for message encryption types other
+    // than AES128CTRSHA1, rejecting any other type in the InitiatorStep1 message.
+    bool LegacyResponder() const;
+    PASEEngineTest& LegacyResponder(bool val);
+
     PASEEngineTest& ExpectError(WEAVE_ERROR err);
     PASEEngineTest& ExpectError(const char *opName, WEAVE_ERROR err);
 
@@ -116,6 +127,9 @@ private:
     uint32_t mExpectedConfig;
     bool mConfirmKey;
     bool mForceRepeatedReconfig;
+    uint8_t mProposedEncType;
+    uint8_t mExpectedEncType;
+    bool mLegacyResponder;
     ExpectedError mExpectedErrors[kMaxExpectedErrors];
     MessageMutator *mMutator;
     bool mLogMessageData;
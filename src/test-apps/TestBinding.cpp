@@ -64,6 +64,7 @@ public:
     nl::Weave::Binding *binding;
     ExchangeContext *ec;
     uint32_t echosSent;
+    uint64_t prepareStartTime;
     bool defaultCheckDelivered;
 
     BindingTestDriver()
@@ -71,6 +72,7 @@ public:
         binding = NULL;
         ec = NULL;
         echosSent = 0;
+        prepareStartTime = 0;
         defaultCheckDelivered = false;
     }
 
@@ -113,6 +115,7 @@ static uint32_t gEchoResponseTimeout = 5000; // in ms
 static uint32_t gStartDelay = 0; // in ms
 static bool gOnDemandPrepare = false;
 static bool gCloseBindingDuringRequest = false;
+static bool gShareConnection = false;
 #if WEAVE_CONFIG_ENABLE_DNS_RESOLVER
 static uint8_t gDNSOptions = ::nl::Inet::kDNSOption_Default;
 #endif
@@ -120,6 +123,9 @@ static uint8_t gDNSOptions = ::nl::Inet::kDNSOption_Default;
 static TestMode gSelectedTestMode = kTestMode_Sequential;
 static uint32_t gTestDriversStarted = 0;
 static uint32_t gTestDriversActive = 0;
+static uint32_t gBindingsPrepared = 0;
+static uint64_t gTotalPrepareTime = 0; // in ms
+static uint64_t gMaxPrepareTime = 0; // in ms
 
 enum
 {
@@ -128,6 +134,7 @@ enum
     kToolOpt_OnDemandPrepare         = 1002,
     kToolOpt_StartDelay              = 1003,
     kToolOpt_DNSOptions              = 1004,
+    kToolOpt_ShareConnection         = 1005,
 };
 
 static OptionDef gToolOptionDefs[] =
@@ -140,6 +147,7 @@ static OptionDef gToolOptionDefs[] =
     { "start-delay",            kArgumentRequired, kToolOpt_StartDelay          },
     { "dest-addr",              kArgumentRequired, 'D'                          },
     { "tcp",                    kNoArgument,       't'                          },
+    { "share-connection",       kNoArgument,       kToolOpt_ShareConnection     },
     { "udp",                    kNoArgument,       'u'                          },
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
     { "wrmp",                   kNoArgument,       'w'                          },
@@ -187,6 +195,10 @@ static const char *const gToolOptionHelp =
     "  -t, --tcp\n"
     "       Use TCP to interact with the peer. This is the default.\n"
     "\n"
+    "  --share-connection\n"
+    "       When using TCP, share a single connection, and its session, between all\n"
+    "       bindings to the peer.\n"
+    "\n"
     "  -u, --udp\n"
     "       Use UDP to interact with the peer.\n"
     "\n"
@@ -305,6 +317,10 @@ int main(int argc, char *argv[])
     InitNetwork();
     InitWeaveStack(false, true);
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+    ExchangeMgr.SetConnectionSharingEnabled(gShareConnection);
+#endif
+
 #if WEAVE_CONFIG_TEST
     nl::Weave::Stats::UpdateSnapshot(before);
 
@@ -316,6 +332,12 @@ int main(int argc, char *argv[])
         StartTest();
         ServiceNetworkUntil(&Done, NULL);
 
+#if WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+        // Close the shared connection now, rather than after its idle timeout, so that it is not
+        // mistaken for a leak.
+        ExchangeMgr.CloseIdleSharedConnections();
+#endif
+
 #if WEAVE_CONFIG_TEST
         if (gSigusr1Received)
         {
@@ -328,6 +350,12 @@ int main(int argc, char *argv[])
     PrintFaultInjectionCounters();
 #endif // WEAVE_CONFIG_TEST
 
+    if (gBindingsPrepared != 0)
+    {
+        printf("%" PRIu32 " bindings prepared: average %" PRIu64 " ms, max %" PRIu64 " ms\n",
+               gBindingsPrepared, gTotalPrepareTime / gBindingsPrepared, gMaxPrepareTime);
+    }
+
     ShutdownWeaveStack();
     ShutdownNetwork();
     ShutdownSystemLayer();
@@ -390,6 +418,9 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
         gUseUDP = false;
         gUseWRMP = false;
         break;
+    case kToolOpt_ShareConnection:
+        gShareConnection = true;
+        break;
     case 'u':
         gUseTCP = false;
         gUseUDP = true;
@@ -578,7 +609,14 @@ void BindingTestDriver::PrepareBinding()
     // Configure the transport.
     if (gUseTCP)
     {
-        bindingConf.Transport_TCP();
+        if (gShareConnection)
+        {
+            bindingConf.Transport_SharedTCP();
+        }
+        else
+        {
+            bindingConf.Transport_TCP();
+        }
     }
     else if (gUseUDP)
     {
@@ -615,6 +653,7 @@ void BindingTestDriver::PrepareBinding()
     bindingConf.Exchange_ResponseTimeoutMsec(gEchoResponseTimeout);
 
     // Prepare the binding.
+    prepareStartTime = NowMs();
     err = bindingConf.PrepareBinding();
     if (err != WEAVE_NO_ERROR)
     {
@@ -656,6 +695,15 @@ void BindingTestDriver::BindingEventCallback(void *apAppState, Binding::EventTyp
         VerifyOrQuit(binding->IsReady());
         VerifyOrQuit(!binding->IsPreparing());
         VerifyOrQuit(!binding->CanBePrepared());
+        {
+            uint64_t prepareTime = NowMs() - _this->prepareStartTime;
+            gBindingsPrepared++;
+            gTotalPrepareTime += prepareTime;
+            if (prepareTime > gMaxPrepareTime)
+            {
+                gMaxPrepareTime = prepareTime;
+            }
+        }
         _this->SendEcho();
         break;
     case Binding::kEvent_PrepareFailed:
@@ -385,6 +385,8 @@ public:
         mExpectedConfig = kCASEConfig_NotSpecified;
         mExpectedCurve = kWeaveCurveId_NotSpecified;
         mForceRepeatedReconfig = false;
+        mProposedEncType = mExpectedEncType = kWeaveEncryptionType_AES128CTRSHA1;
+        mLegacyResponder = false;
         memset(mExpectedErrors, 0, sizeof(mExpectedErrors));
         mMutator = &gNullMutator;
         mLogMessageData = false;
@@ -435,6 +437,17 @@ public:
     bool ForceRepeatedReconfig() const { return mForceRepeatedReconfig; }
     CASEEngineTest& ForceRepeatedReconfig(bool val) { mForceRepeatedReconfig = val; return *this; }
 
+    uint8_t ProposedEncType() const { return mProposedEncType; }
+    CASEEngineTest& ProposedEncType(uint8_t val) { mProposedEncType = mExpectedEncType = val; return *this; }
+
+    uint8_t ExpectedEncType() const { return mExpectedEncType; }
+    CASEEngineTest& ExpectedEncType(uint8_t val) { mExpectedEncType = val; return *this; }
+
+    // A legacy responder behaves like a peer that predates support for message encryption types other
+    // than AES128CTRSHA1, rejecting any other type in the BeginSessionRequest.
+    bool LegacyResponder() const { return mLegacyResponder; }
+    CASEEngineTest& LegacyResponder(bool val) { mLegacyResponder = val; return *this; }
+
     CASEEngineTest& ExpectError(WEAVE_ERROR err)
     {
         return ExpectError(NULL, err);
@@ -500,6 +513,9 @@ private:
     uint32_t mExpectedConfig;
     uint32_t mExpectedCurve;
     bool mForceRepeatedReconfig;
+    uint8_t mProposedEncType;
+    uint8_t mExpectedEncType;
+    bool mLegacyResponder;
     ExpectedError mExpectedErrors[kMaxExpectedErrors];
     MessageMutator *mMutator;
     bool mLogMessageData;
@@ -528,6 +544,9 @@ void CASEEngineTest::Run() const
         bool reconfigPerformed = false;
         uint32_t config = ProposedConfig();
         uint32_t curveId = ProposedCurve();
+        uint8_t encType = ProposedEncType();
+
+    onEncTypeFallback:
 
         initiatorEng.Init();
         initiatorEng.AuthDelegate = &initiatorDelegate;
@@ -553,7 +572,7 @@ void CASEEngineTest::Run() const
             initiatorEng.SetAlternateCurves(req);
             req.SetPerformKeyConfirm(InitiatorRequestKeyConfirm());
             req.SessionKeyId = sTestDefaultSessionKeyId;
-            req.EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
+            req.EncryptionType = encType;
 
             msgBuf = PacketBuffer::New();
             VerifyOrQuit(msgBuf != NULL, "PacketBuffer::New() failed");
@@ -588,9 +607,31 @@ void CASEEngineTest::Run() const
 
             err = responderEng.ProcessBeginSessionRequest(msgBuf, req, reconf);
 
+            if (err == WEAVE_NO_ERROR && LegacyResponder() && req.EncryptionType != kWeaveEncryptionType_AES128CTRSHA1)
+                err = WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE;
+
             if (IsExpectedError("Responder:ProcessBeginSessionRequest", err))
                 goto onExpectedError;
 
+            // If the responder rejected the proposed encryption type, restart the session using
+            // AES128CTRSHA1, as WeaveSecurityManager does on receiving the responder's status report.
+            if (err == WEAVE_ERROR_UNSUPPORTED_ENCRYPTION_TYPE && encType != kWeaveEncryptionType_AES128CTRSHA1)
+            {
+                printf("Responder: Rejected encryption type %d; restarting with AES128CTRSHA1\n", encType);
+
+                PacketBuffer::Free(msgBuf);
+                msgBuf = NULL;
+
+                initiatorEng.Shutdown();
+                responderEng.Shutdown();
+
+                reconfigPerformed = false;
+                config = ProposedConfig();
+                curveId = ProposedCurve();
+                encType = kWeaveEncryptionType_AES128CTRSHA1;
+                goto onEncTypeFallback;
+            }
+
             if (ExpectReconfig() && !reconfigPerformed)
             {
                 VerifyOrQuit(err == WEAVE_ERROR_CASE_RECONFIG_REQUIRED, "WEAVE_ERROR_CASE_RECONFIG_REQUIRED error expected");
@@ -769,11 +810,24 @@ void CASEEngineTest::Run() const
         err = responderEng.GetSessionKey(responderKey);
         SuccessOrQuit(err, "WeaveCASEEngine::GetSessionKey() failed");
 
-        VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.DataKey, responderKey->AES128CTRSHA1.DataKey, WeaveEncryptionKey_AES128CTRSHA1::DataKeySize) == 0,
-                     "Data key mismatch");
+        VerifyOrQuit(initiatorEng.EncryptionType == ExpectedEncType(), "Initiator did not select expected encryption type");
+        VerifyOrQuit(responderEng.EncryptionType == ExpectedEncType(), "Responder did not select expected encryption type");
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+        if (ExpectedEncType() == kWeaveEncryptionType_AES128CCM)
+        {
+            VerifyOrQuit(memcmp(initiatorKey->AES128CCM.Key, responderKey->AES128CCM.Key, WeaveEncryptionKey_AES128CCM::KeySize) == 0,
+                         "Key mismatch");
+        }
+        else
+#endif
+        {
+            VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.DataKey, responderKey->AES128CTRSHA1.DataKey, WeaveEncryptionKey_AES128CTRSHA1::DataKeySize) == 0,
+                         "Data key mismatch");
 
-        VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.IntegrityKey, responderKey->AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize) == 0,
-                     "Integrity key mismatch");
+            VerifyOrQuit(memcmp(initiatorKey->AES128CTRSHA1.IntegrityKey, responderKey->AES128CTRSHA1.IntegrityKey, WeaveEncryptionKey_AES128CTRSHA1::IntegrityKeySize) == 0,
+                         "Integrity key mismatch");
+        }
 
         VerifyOrQuit(IsSuccessExpected(), "Test succeeded unexpectedly");
 
@@ -945,6 +999,49 @@ void CASEEngineTests_KeyConfirmationTests()
 
 uint32_t gFuzzTestDurationSecs = 5;
 
+void CASEEngineTests_EncryptionTypeTests()
+{
+    // Initiator and responder both support AES128CTRSHA1 only
+    CASEEngineTest("Legacy initiator, legacy responder")
+        .LegacyResponder(true)
+        .Run();
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+    // Initiator proposes AES128CTRSHA1 only, responder supports AES128CCM, expect use of AES128CTRSHA1
+    CASEEngineTest("Legacy initiator, AES128CCM responder")
+        .ProposedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+        .Run();
+
+    // Initiator proposes AES128CCM, responder supports AES128CCM, expect use of AES128CCM
+    CASEEngineTest("AES128CCM initiator, AES128CCM responder")
+        .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+        .Run();
+
+    // Initiator proposes AES128CCM, responder supports AES128CTRSHA1 only, expect fallback to AES128CTRSHA1
+    CASEEngineTest("AES128CCM initiator, legacy responder")
+        .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+        .ExpectedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+        .LegacyResponder(true)
+        .Run();
+
+#if WEAVE_CONFIG_SUPPORT_ELLIPTIC_CURVE_SECP224R1 && WEAVE_CONFIG_SUPPORT_ELLIPTIC_CURVE_SECP256R1
+
+    // As above, with the responder also requesting a different curve, expect fallback after reconfiguration
+    CASEEngineTest("AES128CCM initiator, legacy responder, reconfigure")
+        .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+        .ExpectedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+        .LegacyResponder(true)
+        .ProposedCurve(kWeaveCurveId_prime256v1)
+        .ResponderAllowedCurves(kWeaveCurveSet_secp224r1)
+        .ExpectReconfigCurve(kWeaveCurveId_secp224r1)
+        .Run();
+
+#endif
+
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+}
+
 void CASEEngineTests_FuzzTests()
 {
     time_t now, endTime;
@@ -1082,6 +1179,7 @@ int main(int argc, char *argv[])
     CASEEngineTests_ConfigNegotiationTests();
     CASEEngineTests_CurveNegotiationTests();
     CASEEngineTests_KeyConfirmationTests();
+    CASEEngineTests_EncryptionTypeTests();
     CASEEngineTests_FuzzTests();
 
     printf("All tests succeeded\n");
@@ -0,0 +1,513 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file tests the cache of host name resolution results kept by
+ *      the InetLayer, against a stub resolver that stands in for
+ *      getaddrinfo().
+ *
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <netdb.h>
+
+#include "ToolCommon.h"
+#include <nlunit-test.h>
+
+#if INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE && INET_CONFIG_TEST
+
+using namespace nl::Inet;
+
+#define TOOL_NAME "TestDNSCache"
+#define TEST_DURATION_MILLISECS                       (5000)
+
+// The time the stub resolver takes to answer, long enough for requests made in
+// the meantime to find the lookup in progress.
+#define TEST_LOOKUP_DELAY_MILLISECS                   (50)
+
+#define TEST_HOST_NAME                                "service.test"
+#define TEST_HOST_ADDR                                "192.0.2.10"
+#define TEST_OTHER_HOST_NAME                          "other.test"
+#define TEST_OTHER_HOST_ADDR                          "192.0.2.20"
+#define TEST_MISSING_HOST_NAME                        "missing.test"
+#define TEST_FLAKY_HOST_NAME                          "flaky.test"
+
+#define TEST_MAX_REQUESTS                             (3)
+
+struct CacheTestRequest
+{
+    bool complete;
+    INET_ERROR err;
+    uint8_t addrCount;
+    IPAddress addrs[INET_CONFIG_DNS_CACHE_MAX_ADDRS];
+};
+
+static volatile uint32_t sNumLookups = 0;
+static volatile bool sHostRemoved    = false;
+static uint32_t sNumPending          = 0;
+
+static int StubGetAddrInfo(const char * hostName, const char * service, const struct addrinfo * hints,
+                           struct addrinfo ** results);
+static void StartRequest(nlTestSuite * testSuite, const char * hostName, CacheTestRequest & request);
+static void RunRequest(nlTestSuite * testSuite, const char * hostName, CacheTestRequest & request);
+static void HandleResolveComplete(void * appState, INET_ERROR err, uint8_t addrCount, IPAddress * addrArray);
+static void ServiceNetworkUntilDone(uint32_t timeoutMS);
+static void ServiceNetworkFor(uint32_t durationMS);
+static bool IsAddress(const CacheTestRequest & request, const char * addrStr);
+
+/**
+ *  Test that concurrent requests for a host name share one lookup, and that later
+ *  requests are answered from the cache.
+ */
+static void TestDNSCache_Coalesce(nlTestSuite * testSuite, void * testContext)
+{
+    DNSCache & cache               = Inet.GetDNSCache();
+    const DNSCache::Stats & stats  = cache.GetStats();
+    CacheTestRequest requests[TEST_MAX_REQUESTS];
+    CacheTestRequest request;
+    uint32_t numLookups;
+
+    cache.Flush();
+    cache.ResetStats();
+    numLookups = sNumLookups;
+
+    for (int i = 0; i < TEST_MAX_REQUESTS; i++)
+    {
+        StartRequest(testSuite, TEST_HOST_NAME, requests[i]);
+    }
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    for (int i = 0; i < TEST_MAX_REQUESTS; i++)
+    {
+        NL_TEST_ASSERT(testSuite, requests[i].complete);
+        NL_TEST_ASSERT(testSuite, requests[i].err == INET_NO_ERROR);
+        NL_TEST_ASSERT(testSuite, IsAddress(requests[i], TEST_HOST_ADDR));
+    }
+
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 1);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 1);
+    NL_TEST_ASSERT(testSuite, stats.Coalesced == TEST_MAX_REQUESTS - 1);
+
+    // A cached result is still delivered after the request returns, as a lookup would be.
+
+    StartRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, !request.complete);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, request.complete);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 1);
+    NL_TEST_ASSERT(testSuite, stats.Hits == 1);
+
+    // Host names are compared regardless of case.
+
+    RunRequest(testSuite, "SERVICE.Test", request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 1);
+    NL_TEST_ASSERT(testSuite, stats.Hits == 2);
+
+    // Flushing the cache forces a new lookup.
+
+    cache.Flush();
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 2);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 2);
+}
+
+/**
+ *  Test that names that were not found are cached, but transient failures are not.
+ */
+static void TestDNSCache_Errors(nlTestSuite * testSuite, void * testContext)
+{
+    DNSCache & cache               = Inet.GetDNSCache();
+    const DNSCache::Stats & stats  = cache.GetStats();
+    CacheTestRequest request;
+    uint32_t numLookups;
+
+    cache.Flush();
+    cache.ResetStats();
+    numLookups = sNumLookups;
+
+    RunRequest(testSuite, TEST_MISSING_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, request.err == INET_ERROR_HOST_NOT_FOUND);
+    RunRequest(testSuite, TEST_MISSING_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, request.err == INET_ERROR_HOST_NOT_FOUND);
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 1);
+    NL_TEST_ASSERT(testSuite, stats.NegativeHits == 1);
+
+    RunRequest(testSuite, TEST_FLAKY_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, request.err == INET_ERROR_DNS_TRY_AGAIN);
+    RunRequest(testSuite, TEST_FLAKY_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, request.err == INET_ERROR_DNS_TRY_AGAIN);
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 3);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 3);
+}
+
+/**
+ *  Test that canceling one of the requests waiting for a lookup leaves the others
+ *  to complete.
+ */
+static void TestDNSCache_Cancel(nlTestSuite * testSuite, void * testContext)
+{
+    DNSCache & cache = Inet.GetDNSCache();
+    CacheTestRequest canceled;
+    CacheTestRequest request;
+
+    cache.Flush();
+
+    StartRequest(testSuite, TEST_OTHER_HOST_NAME, canceled);
+    StartRequest(testSuite, TEST_OTHER_HOST_NAME, request);
+
+    Inet.CancelResolveHostAddress(HandleResolveComplete, &canceled);
+    sNumPending--;
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, !canceled.complete);
+    NL_TEST_ASSERT(testSuite, request.complete);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_OTHER_HOST_ADDR));
+
+    // The result was still cached.
+
+    RunRequest(testSuite, TEST_OTHER_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_OTHER_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, cache.GetStats().Hits > 0);
+}
+
+/**
+ *  Test that results expire, and that a request made shortly before expiry refreshes
+ *  the result in the background.
+ */
+static void TestDNSCache_Expiry(nlTestSuite * testSuite, void * testContext)
+{
+    DNSCache & cache               = Inet.GetDNSCache();
+    const DNSCache::Stats & stats  = cache.GetStats();
+    CacheTestRequest request;
+    uint32_t numLookups;
+
+    cache.SetTimeouts(600, 200, 400);
+    cache.Flush();
+    cache.ResetStats();
+    numLookups = sNumLookups;
+
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 1);
+
+    // Well before expiry, a request is answered from the cache alone.
+
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, stats.Hits == 1);
+    NL_TEST_ASSERT(testSuite, stats.Refreshes == 0);
+
+    // Within the refresh time, it is answered from the cache and starts a refresh...
+
+    ServiceNetworkFor(300);
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, stats.Hits == 2);
+    NL_TEST_ASSERT(testSuite, stats.Refreshes == 1);
+    ServiceNetworkFor(2 * TEST_LOOKUP_DELAY_MILLISECS);
+    NL_TEST_ASSERT(testSuite, sNumLookups == numLookups + 2);
+
+    // ...which keeps the name in the cache past its original expiry.
+
+    ServiceNetworkFor(300);
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, stats.Hits == 3);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 1);
+
+    // Without further requests, the result expires.
+
+    ServiceNetworkFor(1000);
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, stats.Misses == 2);
+
+    cache.SetTimeouts(INET_CONFIG_DNS_CACHE_TTL_MSEC, INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC, INET_CONFIG_DNS_CACHE_REFRESH_MSEC);
+}
+
+/**
+ *  Test that a refresh that finds no host leaves the cached addresses in place
+ *  until they expire, rather than replacing them with a negative result.
+ */
+static void TestDNSCache_RefreshNotFound(nlTestSuite * testSuite, void * testContext)
+{
+    DNSCache & cache               = Inet.GetDNSCache();
+    const DNSCache::Stats & stats  = cache.GetStats();
+    CacheTestRequest request;
+
+    cache.SetTimeouts(600, 1000, 400);
+    cache.Flush();
+    cache.ResetStats();
+
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+
+    sHostRemoved = true;
+
+    ServiceNetworkFor(300);
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, stats.Refreshes == 1);
+    ServiceNetworkFor(2 * TEST_LOOKUP_DELAY_MILLISECS);
+
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, IsAddress(request, TEST_HOST_ADDR));
+    NL_TEST_ASSERT(testSuite, stats.Hits == 2);
+    NL_TEST_ASSERT(testSuite, stats.NegativeHits == 0);
+
+    // Once the addresses expire, the host is looked up again and found missing.
+
+    ServiceNetworkFor(300);
+    RunRequest(testSuite, TEST_HOST_NAME, request);
+    NL_TEST_ASSERT(testSuite, request.err == INET_ERROR_HOST_NOT_FOUND);
+    NL_TEST_ASSERT(testSuite, stats.Misses == 2);
+
+    sHostRemoved = false;
+
+    cache.Flush();
+    cache.SetTimeouts(INET_CONFIG_DNS_CACHE_TTL_MSEC, INET_CONFIG_DNS_CACHE_NEGATIVE_TTL_MSEC, INET_CONFIG_DNS_CACHE_REFRESH_MSEC);
+}
+
+/**
+ *  Test that shutting down the InetLayer while requests wait for a lookup frees
+ *  the resolvers they occupy, without calling them back.
+ */
+static void TestDNSCache_Shutdown(nlTestSuite * testSuite, void * testContext)
+{
+    CacheTestRequest requests[TEST_MAX_REQUESTS];
+    CacheTestRequest waiting[TEST_MAX_REQUESTS - 1];
+
+    Inet.GetDNSCache().Flush();
+
+    for (int i = 0; i < TEST_MAX_REQUESTS - 1; i++)
+    {
+        StartRequest(testSuite, TEST_OTHER_HOST_NAME, waiting[i]);
+    }
+
+    ShutdownNetwork();
+    InitNetwork();
+    InetLayer::SetDNSGetAddrInfoFunct(StubGetAddrInfo);
+    sNumPending = 0;
+
+    // Let the canceled lookup finish and release its resolver.
+    ServiceNetworkFor(2 * TEST_LOOKUP_DELAY_MILLISECS);
+
+    for (int i = 0; i < TEST_MAX_REQUESTS - 1; i++)
+    {
+        NL_TEST_ASSERT(testSuite, !waiting[i].complete);
+    }
+
+    // One lookup and its waiting requests take every resolver, so none may be left over.
+
+    for (int i = 0; i < TEST_MAX_REQUESTS; i++)
+    {
+        StartRequest(testSuite, TEST_OTHER_HOST_NAME, requests[i]);
+    }
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    for (int i = 0; i < TEST_MAX_REQUESTS; i++)
+    {
+        NL_TEST_ASSERT(testSuite, IsAddress(requests[i], TEST_OTHER_HOST_ADDR));
+    }
+
+    NL_TEST_ASSERT(testSuite, Inet.GetDNSCache().GetStats().Bypassed == 0);
+}
+
+/**
+ *  Answer lookups from a fixed table after a short delay, as a name server would.
+ *  Runs on the asynchronous resolver threads.
+ */
+static int StubGetAddrInfo(const char * hostName, const char * service, const struct addrinfo * hints,
+                           struct addrinfo ** results)
+{
+    struct addrinfo numericHints = *hints;
+    const char * addrStr;
+
+    __sync_add_and_fetch(&sNumLookups, 1);
+
+    usleep(TEST_LOOKUP_DELAY_MILLISECS * 1000);
+
+    if (strcasecmp(hostName, TEST_HOST_NAME) == 0 && !sHostRemoved)
+        addrStr = TEST_HOST_ADDR;
+    else if (strcasecmp(hostName, TEST_OTHER_HOST_NAME) == 0)
+        addrStr = TEST_OTHER_HOST_ADDR;
+    else if (strcasecmp(hostName, TEST_FLAKY_HOST_NAME) == 0)
+        return EAI_AGAIN;
+    else
+        return EAI_NONAME;
+
+    // Ask for one socket type, so that the address is returned only once.
+    numericHints.ai_flags    = AI_NUMERICHOST;
+    numericHints.ai_socktype = SOCK_STREAM;
+
+    return getaddrinfo(addrStr, service, &numericHints, results);
+}
+
+static void StartRequest(nlTestSuite * testSuite, const char * hostName, CacheTestRequest & request)
+{
+    INET_ERROR err;
+
+    memset(&request, 0, sizeof(request));
+
+    err = Inet.ResolveHostAddress(hostName, strlen(hostName), kDNSOption_Default, INET_CONFIG_DNS_CACHE_MAX_ADDRS,
+                                  request.addrs, HandleResolveComplete, &request);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    if (err == INET_NO_ERROR)
+    {
+        sNumPending++;
+        Done = false;
+    }
+}
+
+static void RunRequest(nlTestSuite * testSuite, const char * hostName, CacheTestRequest & request)
+{
+    StartRequest(testSuite, hostName, request);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+    NL_TEST_ASSERT(testSuite, request.complete);
+}
+
+static void HandleResolveComplete(void * appState, INET_ERROR err, uint8_t addrCount, IPAddress * addrArray)
+{
+    CacheTestRequest * request = static_cast<CacheTestRequest *>(appState);
+
+    request->complete  = true;
+    request->err       = err;
+    request->addrCount = addrCount;
+
+    if (--sNumPending == 0)
+    {
+        Done = true;
+    }
+}
+
+static void ServiceNetworkUntilDone(uint32_t timeoutMS)
+{
+    uint64_t timeoutTimeMS = System::Layer::GetClock_MonotonicMS() + timeoutMS;
+    struct timeval sleepTime;
+    sleepTime.tv_sec = 0;
+    sleepTime.tv_usec = 10000;
+
+    while (!Done)
+    {
+        ServiceNetwork(sleepTime);
+
+        if (System::Layer::GetClock_MonotonicMS() >= timeoutTimeMS)
+        {
+            break;
+        }
+    }
+}
+
+static void ServiceNetworkFor(uint32_t durationMS)
+{
+    Done = false;
+    ServiceNetworkUntilDone(durationMS);
+    Done = true;
+}
+
+static bool IsAddress(const CacheTestRequest & request, const char * addrStr)
+{
+    IPAddress addr;
+
+    IPAddress::FromString(addrStr, addr);
+
+    return request.err == INET_NO_ERROR && request.addrCount == 1 && request.addrs[0] == addr;
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gNetworkOptions,
+    &gFaultInjectionOptions,
+    &gHelpOptions,
+    NULL
+};
+
+int main(int argc, char *argv[])
+{
+    const nlTest DNSCacheTests[] = {
+        NL_TEST_DEF("TestDNSCache:Coalesce", TestDNSCache_Coalesce),
+        NL_TEST_DEF("TestDNSCache:Errors", TestDNSCache_Errors),
+        NL_TEST_DEF("TestDNSCache:Cancel", TestDNSCache_Cancel),
+        NL_TEST_DEF("TestDNSCache:Expiry", TestDNSCache_Expiry),
+        NL_TEST_DEF("TestDNSCache:RefreshNotFound", TestDNSCache_RefreshNotFound),
+        NL_TEST_DEF("TestDNSCache:Shutdown", TestDNSCache_Shutdown),
+        NL_TEST_SENTINEL()
+    };
+
+    nlTestSuite DNSCacheTestSuite = {
+        "DNSCache",
+        &DNSCacheTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    InitToolCommon();
+
+    SetupFaultInjectionContext(argc, argv);
+
+    if (!ParseArgsFromEnvVar(TOOL_NAME, TOOL_OPTIONS_ENV_VAR_NAME, gToolOptionSets, NULL, true) ||
+        !ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets, NULL))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    InitSystemLayer();
+
+    InitNetwork();
+
+    InetLayer::SetDNSGetAddrInfoFunct(StubGetAddrInfo);
+
+    // Run all tests in Suite
+
+    nlTestRunner(&DNSCacheTestSuite, NULL);
+
+    InetLayer::SetDNSGetAddrInfoFunct(NULL);
+
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    return nlTestRunnerStats(&DNSCacheTestSuite);
+}
+
+#else // !(INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE && INET_CONFIG_TEST)
+
+int main(int argc, char *argv[])
+{
+    return 0;
+}
+
+#endif // !(INET_CONFIG_ENABLE_DNS_RESOLVER && INET_CONFIG_ENABLE_DNS_CACHE && INET_CONFIG_TEST)
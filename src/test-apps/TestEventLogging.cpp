@@ -32,6 +32,7 @@
 #endif
 
 #include <new>
+#include <pthread.h>
 #include <stdint.h>
 #include <string.h>
 #include <unistd.h>
@@ -115,15 +116,18 @@ namespace Weave {
 namespace Profiles {
 namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current) {
 namespace Platform {
-// for unit tests, the dummy critical section is sufficient.
+// The throughput benchmark logs from several threads, so this must be a
+// real lock; it is recursive to match the permissive dummy it replaces.
+static pthread_mutex_t sCriticalSection = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+
 void CriticalSectionEnter()
 {
-    return;
+    pthread_mutex_lock(&sCriticalSection);
 }
 
 void CriticalSectionExit()
 {
-    return;
+    pthread_mutex_unlock(&sCriticalSection);
 }
 } // namespace Platform
 } // namespace WeaveMakeManagedNamespaceIdentifier(DataManagement, kWeaveManagedNamespaceDesignation_Current)
@@ -1141,6 +1145,426 @@ static void CheckEvict(nlTestSuite * inSuite, void * inContext)
     }
 }
 
+#define LOGGING_BENCHMARK_EVENTS_PER_THREAD 2000
+#define LOGGING_BENCHMARK_MAX_THREADS 8
+
+struct LoggingBenchmarkThread
+{
+    pthread_t mThread;
+    bool mStaged;
+    size_t mNumLogged;
+};
+
+static volatile bool sLoggingBenchmarkStart;
+static volatile size_t sLoggingBenchmarkNumDone;
+
+static WEAVE_ERROR BenchmarkEventWriter(TLVWriter & ioWriter, uint8_t inDataTag, void * appData)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    uint32_t * value = static_cast<uint32_t *>(appData);
+    TLVType outer;
+
+    err = ioWriter.StartContainer(ContextTag(inDataTag), kTLVType_Structure, outer);
+    SuccessOrExit(err);
+
+    err = ioWriter.Put(ContextTag(1), *value);
+    SuccessOrExit(err);
+
+    err = ioWriter.EndContainer(outer);
+
+exit:
+    return err;
+}
+
+static void * LoggingBenchmarkProducer(void * arg)
+{
+    LoggingBenchmarkThread * thread = static_cast<LoggingBenchmarkThread *>(arg);
+    LoggingManagement & logger      = LoggingManagement::GetInstance();
+    EventSchema schema              = { kWeaveProfile_NestDebug, kNestDebug_StringLogEntryEvent, Production, 1, 1 };
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    EventStagingRing * ring = thread->mStaged ? logger.AcquireStagingRing() : NULL;
+#endif
+
+    while (!sLoggingBenchmarkStart)
+        ;
+
+    for (uint32_t i = 0; i < LOGGING_BENCHMARK_EVENTS_PER_THREAD; i++)
+    {
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+        if (ring != NULL)
+        {
+            if (logger.StageEvent(ring, schema, BenchmarkEventWriter, &i, NULL) == WEAVE_NO_ERROR)
+                thread->mNumLogged++;
+            continue;
+        }
+#endif
+        if (logger.LogEvent(schema, BenchmarkEventWriter, &i, NULL) != 0)
+            thread->mNumLogged++;
+    }
+
+    __sync_add_and_fetch(&sLoggingBenchmarkNumDone, 1);
+
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    if (ring != NULL)
+    {
+        logger.ReleaseStagingRing(ring);
+    }
+#endif
+
+    return NULL;
+}
+
+static void RunLoggingBenchmark(nlTestSuite * inSuite, size_t inNumThreads, bool inStaged)
+{
+    LoggingManagement & logger = LoggingManagement::GetInstance();
+    LoggingBenchmarkThread threads[LOGGING_BENCHMARK_MAX_THREADS];
+    event_id_t firstEventID = logger.GetLastEventID(Production);
+    size_t numLogged        = 0;
+    uint64_t startTime, elapsed;
+
+    sLoggingBenchmarkStart   = false;
+    sLoggingBenchmarkNumDone = 0;
+
+    for (size_t i = 0; i < inNumThreads; i++)
+    {
+        threads[i].mStaged    = inStaged;
+        threads[i].mNumLogged = 0;
+        NL_TEST_ASSERT(inSuite, pthread_create(&threads[i].mThread, NULL, LoggingBenchmarkProducer, &threads[i]) == 0);
+    }
+
+    startTime              = Now();
+    sLoggingBenchmarkStart = true;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+    // Stand in for the Weave thread, merging staged events as they arrive.
+    while (inStaged && sLoggingBenchmarkNumDone < inNumThreads)
+    {
+        logger.MergeStagedEvents();
+    }
+#endif
+
+    for (size_t i = 0; i < inNumThreads; i++)
+    {
+        pthread_join(threads[i].mThread, NULL);
+        numLogged += threads[i].mNumLogged;
+    }
+
+    elapsed = Now() - startTime;
+
+    NL_TEST_ASSERT(inSuite, numLogged == inNumThreads * LOGGING_BENCHMARK_EVENTS_PER_THREAD);
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) - firstEventID == numLogged);
+
+    printf("%s, %u threads: %u events in %" PRIu64 " us (%" PRIu64 " events/s)\n", inStaged ? "staged" : "locked",
+           static_cast<unsigned>(inNumThreads), static_cast<unsigned>(numLogged), elapsed,
+           (elapsed != 0) ? (static_cast<uint64_t>(numLogged) * 1000000) / elapsed : 0);
+}
+
+static void CheckLoggingThroughput(nlTestSuite * inSuite, void * inContext)
+{
+    TestLoggingContext * context = static_cast<TestLoggingContext *>(inContext);
+
+    InitializeEventLogging(context);
+
+    for (size_t numThreads = 1; numThreads <= LOGGING_BENCHMARK_MAX_THREADS; numThreads *= 2)
+    {
+        RunLoggingBenchmark(inSuite, numThreads, false);
+#if WEAVE_CONFIG_EVENT_LOGGING_STAGING
+        RunLoggingBenchmark(inSuite, numThreads, true);
+#endif
+    }
+}
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING || WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE ||                                    \
+    WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE || WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+// Tests that compare two fetches fetch into the two halves of
+// gLargeMemoryBackingStore.
+#define BENCHMARK_FETCH_BUFFER_SIZE (sizeof(gLargeMemoryBackingStore) / 2)
+#define BENCHMARK_FETCH_BUFFER(n) (gLargeMemoryBackingStore + (n) * BENCHMARK_FETCH_BUFFER_SIZE)
+
+// Log Production events with the values inFirstValue onwards, alternating
+// between two event types, 10 ms apart in UTC time.
+static void LogBenchmarkEvents(uint32_t inFirstValue, size_t inNumEvents, uint32_t inProfileId)
+{
+    for (uint32_t i = inFirstValue; i < inFirstValue + inNumEvents; i++)
+    {
+        EventSchema schema = { inProfileId, (i % 2) ? kNestDebug_TokenizedLogEntryEvent : kNestDebug_StringLogEntryEvent,
+                               Production, 1, 1 };
+        EventOptions options(static_cast<utc_timestamp_t>(1500000000000ULL + 10 * i));
+
+        LogEvent(schema, BenchmarkEventWriter, &i, &options);
+    }
+}
+
+// Fetch the Production events from ioEventID onwards, returning the result
+// of the fetch along with the number of bytes and events written.
+static WEAVE_ERROR FetchBenchmarkEvents(uint8_t * outBuf, size_t inBufSize, event_id_t & ioEventID, size_t & outLen,
+                                        size_t & outNumEvents)
+{
+    TLVWriter writer;
+    TLVReader reader;
+    WEAVE_ERROR err;
+
+    writer.Init(outBuf, inBufSize);
+    err = LoggingManagement::GetInstance().FetchEventsSince(writer, Production, ioEventID);
+    writer.Finalize();
+
+    outLen = writer.GetLengthWritten();
+
+    reader.Init(outBuf, outLen);
+    outNumEvents = 0;
+    nl::Weave::TLV::Utilities::Count(reader, outNumEvents, false);
+
+    return err;
+}
+
+#endif
+
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+#define COMPACT_ENCODING_BENCHMARK_EVENTS 2000
+
+static void CheckCompactEncoding(nlTestSuite * inSuite, void * inContext)
+{
+    TestLoggingContext * context = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement & logger   = LoggingManagement::GetInstance();
+    size_t bufferSize = sizeof(gCritEventBuffer) + sizeof(gProdEventBuffer) + sizeof(gInfoEventBuffer) + sizeof(gDebugEventBuffer);
+    size_t plainLen, compactLen, numEvents;
+    uint64_t plainLogTime, compactLogTime, plainFetchTime, compactFetchTime;
+    event_id_t plainRetained, compactRetained, eventId;
+
+    // Fetched events are identical with and without the compact encoding.
+
+    InitializeEventLogging(context);
+    LogBenchmarkEvents(0, 20, kWeaveProfile_NestDebug);
+    eventId = 0;
+    FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, plainLen, numEvents);
+
+    InitializeEventLogging(context);
+    NL_TEST_ASSERT(inSuite, logger.SetCompactEncoding(true) == WEAVE_NO_ERROR);
+    LogBenchmarkEvents(0, 20, kWeaveProfile_NestDebug);
+    eventId = 0;
+    FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, compactLen, numEvents);
+
+    NL_TEST_ASSERT(inSuite, plainLen > 0);
+    NL_TEST_ASSERT(inSuite, plainLen == compactLen);
+    NL_TEST_ASSERT(inSuite, memcmp(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER(1), plainLen) == 0);
+
+    // The encoding cannot change under buffered events.
+    NL_TEST_ASSERT(inSuite, logger.SetCompactEncoding(false) == WEAVE_ERROR_INCORRECT_STATE);
+
+    // Events retained, and the cost of encoding and expanding them.
+
+    InitializeEventLogging(context);
+    plainLogTime = Now();
+    LogBenchmarkEvents(0, COMPACT_ENCODING_BENCHMARK_EVENTS, kWeaveProfile_NestDebug);
+    plainLogTime   = Now() - plainLogTime;
+    plainRetained  = logger.GetLastEventID(Production) - logger.GetFirstEventID(Production) + 1;
+    eventId        = 0;
+    plainFetchTime = Now();
+    FetchBenchmarkEvents(gLargeMemoryBackingStore, sizeof(gLargeMemoryBackingStore), eventId, plainLen, numEvents);
+    plainFetchTime = Now() - plainFetchTime;
+
+    InitializeEventLogging(context);
+    logger.SetCompactEncoding(true);
+    compactLogTime = Now();
+    LogBenchmarkEvents(0, COMPACT_ENCODING_BENCHMARK_EVENTS, kWeaveProfile_NestDebug);
+    compactLogTime   = Now() - compactLogTime;
+    compactRetained  = logger.GetLastEventID(Production) - logger.GetFirstEventID(Production) + 1;
+    eventId          = 0;
+    compactFetchTime = Now();
+    FetchBenchmarkEvents(gLargeMemoryBackingStore, sizeof(gLargeMemoryBackingStore), eventId, compactLen, numEvents);
+    compactFetchTime = Now() - compactFetchTime;
+
+    NL_TEST_ASSERT(inSuite, compactRetained > plainRetained);
+
+    printf("plain:   %u events retained (%u per KB), log %" PRIu64 " us, fetch %" PRIu64 " us\n",
+           static_cast<unsigned>(plainRetained), static_cast<unsigned>(plainRetained * 1024 / bufferSize), plainLogTime,
+           plainFetchTime);
+    printf("compact: %u events retained (%u per KB), log %" PRIu64 " us, fetch %" PRIu64 " us\n",
+           static_cast<unsigned>(compactRetained), static_cast<unsigned>(compactRetained * 1024 / bufferSize), compactLogTime,
+           compactFetchTime);
+
+    InitializeEventLogging(context);
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
+#define MAPPED_EVENT_BUFFER_SIZE 2048
+#define MAPPED_EVENT_BUFFER_COUNT 4
+
+static void * gMappedEventBuffers[MAPPED_EVENT_BUFFER_COUNT];
+
+static void MappedEventBufferPath(size_t inIndex, char * outPath, size_t inPathSize)
+{
+    snprintf(outPath, inPathSize, "/tmp/TestEventLogging-%d-%u.evb", static_cast<int>(getpid()), static_cast<unsigned>(inIndex));
+}
+
+// Map the event buffer files and create the logging subsystem over them,
+// as a device would at boot.
+static void StartMappedEventLogging(nlTestSuite * inSuite, TestLoggingContext * context)
+{
+    const ImportanceType importance[MAPPED_EVENT_BUFFER_COUNT] = { ProductionCritical, Production, Info,
+                                                                   nl::Weave::Profiles::DataManagement::Debug };
+    LogStorageResources logStorageResources[MAPPED_EVENT_BUFFER_COUNT];
+    char path[64];
+
+    for (size_t i = 0; i < MAPPED_EVENT_BUFFER_COUNT; i++)
+    {
+        MappedEventBufferPath(i, path, sizeof(path));
+        NL_TEST_ASSERT(inSuite,
+                       LoggingManagement::MapEventBuffer(path, MAPPED_EVENT_BUFFER_SIZE, gMappedEventBuffers[i]) == WEAVE_NO_ERROR);
+
+        memset(&logStorageResources[i], 0, sizeof(LogStorageResources));
+        logStorageResources[i].mBuffer     = gMappedEventBuffers[i];
+        logStorageResources[i].mBufferSize = MAPPED_EVENT_BUFFER_SIZE;
+        logStorageResources[i].mImportance = importance[i];
+        logStorageResources[i].mIsMapped   = true;
+    }
+
+    LoggingManagement::CreateLoggingManagement(context->mExchangeMgr, MAPPED_EVENT_BUFFER_COUNT, logStorageResources);
+    LoggingConfiguration::GetInstance().mGlobalImportance = nl::Weave::Profiles::DataManagement::Debug;
+}
+
+// Tear the logging subsystem down without any orderly shutdown, as a
+// crash would, and unmap the files.
+static void StopMappedEventLogging(void)
+{
+    LoggingManagement::GetInstance().DestroyLoggingManagement();
+
+    for (size_t i = 0; i < MAPPED_EVENT_BUFFER_COUNT; i++)
+    {
+        LoggingManagement::UnmapEventBuffer(gMappedEventBuffers[i], MAPPED_EVENT_BUFFER_SIZE);
+    }
+}
+
+static MappedEventBufferState * NewestMappedState(size_t inIndex)
+{
+    CircularEventBuffer * buffer  = static_cast<CircularEventBuffer *>(gMappedEventBuffers[inIndex]);
+    MappedEventBufferState * state = reinterpret_cast<MappedEventBufferState *>(buffer + 1);
+
+    return (static_cast<int32_t>(state[1].mSequence - state[0].mSequence) > 0) ? &state[1] : &state[0];
+}
+
+static void CheckMappedEventBufferRecovery(nlTestSuite * inSuite, void * inContext)
+{
+    TestLoggingContext * context = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement & logger   = LoggingManagement::GetInstance();
+    size_t len, recoveredLen, numEvents, recoveredNumEvents;
+    event_id_t lastEventId, eventId;
+    char path[64];
+    WEAVE_ERROR err;
+
+    for (size_t i = 0; i < MAPPED_EVENT_BUFFER_COUNT; i++)
+    {
+        MappedEventBufferPath(i, path, sizeof(path));
+        unlink(path);
+    }
+
+    // Fresh files start out empty.
+    StartMappedEventLogging(inSuite, context);
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, numEvents == 0);
+
+    // Log enough events to overflow into every buffer, then restart:
+    // the same events come back, and event IDs carry on from them.
+    LogBenchmarkEvents(0, 100, kWeaveProfile_NestDebug);
+    lastEventId = logger.GetLastEventID(Production);
+    eventId     = 0;
+    err         = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, numEvents > 0);
+    StopMappedEventLogging();
+
+    StartMappedEventLogging(inSuite, context);
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, recoveredLen,
+                                   recoveredNumEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, recoveredLen == len);
+    NL_TEST_ASSERT(inSuite, memcmp(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER(1), len) == 0);
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) == lastEventId);
+
+    LogBenchmarkEvents(100, 1, kWeaveProfile_NestDebug);
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) == lastEventId + 1);
+    lastEventId = logger.GetLastEventID(Production);
+    eventId     = 0;
+    err         = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+
+    // A crash part way through a state update: the newest copy of the
+    // state of the buffer events are written to is torn.  Recovery
+    // falls back to the previous copy, and no event ID is reused.
+    NewestMappedState(MAPPED_EVENT_BUFFER_COUNT - 1)->mDataLength ^= 0x5a;
+    StopMappedEventLogging();
+
+    StartMappedEventLogging(inSuite, context);
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, recoveredLen,
+                                   recoveredNumEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, recoveredNumEvents <= numEvents);
+    NL_TEST_ASSERT(inSuite, recoveredNumEvents + 1 >= numEvents);
+    LogBenchmarkEvents(101, 1, kWeaveProfile_NestDebug);
+    NL_TEST_ASSERT(inSuite, logger.GetLastEventID(Production) > lastEventId);
+
+    // A crash part way through writing an event: bytes beyond the
+    // recorded end of the data are ignored.
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    {
+        CircularEventBuffer * buffer = static_cast<CircularEventBuffer *>(gMappedEventBuffers[MAPPED_EVENT_BUFFER_COUNT - 1]);
+        uint8_t * tail               = buffer->mBuffer.QueueTail();
+
+        if (buffer->mBuffer.AvailableDataLength() > 0)
+        {
+            *tail = 0x15; // start of an anonymous structure that never ends
+        }
+    }
+    StopMappedEventLogging();
+
+    StartMappedEventLogging(inSuite, context);
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, recoveredLen,
+                                   recoveredNumEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, recoveredNumEvents == numEvents);
+
+    // With both copies of the state lost, the buffer starts out empty.
+    for (size_t i = 0; i < MAPPED_EVENT_BUFFER_COUNT; i++)
+    {
+        CircularEventBuffer * buffer   = static_cast<CircularEventBuffer *>(gMappedEventBuffers[i]);
+        MappedEventBufferState * state = reinterpret_cast<MappedEventBufferState *>(buffer + 1);
+
+        state[0].mChecksum ^= 1;
+        state[1].mChecksum ^= 1;
+    }
+    StopMappedEventLogging();
+
+    StartMappedEventLogging(inSuite, context);
+    eventId = 0;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, recoveredLen,
+                                   recoveredNumEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, recoveredNumEvents == 0);
+    StopMappedEventLogging();
+
+    for (size_t i = 0; i < MAPPED_EVENT_BUFFER_COUNT; i++)
+    {
+        MappedEventBufferPath(i, path, sizeof(path));
+        unlink(path);
+    }
+
+    InitializeEventLogging(context);
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+
 static WEAVE_ERROR ReadFirstEventHeader(TLVReader & aReader, timestamp_t & aTimestamp, utc_timestamp_t & aUtcTimestamp,
                                         event_id_t & aEventId)
 {
@@ -1188,6 +1612,286 @@ exit:
     return err;
 }
 
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+static void CheckEventBatchCache(nlTestSuite * inSuite, void * inContext)
+{
+    TestLoggingContext * context = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement & logger   = LoggingManagement::GetInstance();
+    const EventBatchCache::Stats & stats = logger.GetBatchCacheStats();
+    uint8_t smallBuf[128];
+    event_id_t firstEventId, eventId, chunkEventId;
+    size_t fullLen, len, numEvents;
+    bool firstChunk = true;
+    uint32_t misses;
+    WEAVE_ERROR err;
+
+    InitializeEventLogging(context);
+    LogBenchmarkEvents(0, 20, kWeaveProfile_NestDebug);
+    logger.ResetBatchCacheStats();
+
+    firstEventId = logger.GetFirstEventID(Production);
+
+    // The first subscription at a cursor encodes the events...
+
+    eventId = firstEventId;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER_SIZE, eventId, fullLen, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, eventId == logger.GetLastEventID(Production) + 1);
+    NL_TEST_ASSERT(inSuite, stats.Hits == 0);
+    NL_TEST_ASSERT(inSuite, stats.Misses > 0);
+    misses = stats.Misses;
+
+    // ...and later ones at the same cursor get the same encoding without
+    // encoding again.
+
+    eventId = firstEventId;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, eventId == logger.GetLastEventID(Production) + 1);
+    NL_TEST_ASSERT(inSuite, len == fullLen);
+    NL_TEST_ASSERT(inSuite, memcmp(BENCHMARK_FETCH_BUFFER(0), BENCHMARK_FETCH_BUFFER(1), fullLen) == 0);
+    NL_TEST_ASSERT(inSuite, stats.Hits > 0);
+    NL_TEST_ASSERT(inSuite, stats.Misses == misses);
+    NL_TEST_ASSERT(inSuite, stats.EventsServed == 2 * 20);
+
+    // A subscription with less room gets whole events, each fetch
+    // starting with the event it asked for.
+
+    eventId = firstEventId;
+    do
+    {
+        TLVReader reader;
+        timestamp_t timestamp       = 0;
+        utc_timestamp_t utcTimestamp = 0;
+        event_id_t readEventId      = 0;
+
+        chunkEventId = eventId;
+        err          = FetchBenchmarkEvents(smallBuf, sizeof(smallBuf), eventId, len, numEvents);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV || err == WEAVE_ERROR_BUFFER_TOO_SMALL);
+        NL_TEST_ASSERT(inSuite, eventId > chunkEventId);
+        NL_TEST_ASSERT(inSuite, len > 0);
+
+        reader.Init(smallBuf, len);
+        NL_TEST_ASSERT(inSuite, ReadFirstEventHeader(reader, timestamp, utcTimestamp, readEventId) == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, readEventId == chunkEventId);
+
+        // The first chunk is a prefix of the full fetch.
+        if (firstChunk)
+        {
+            NL_TEST_ASSERT(inSuite, memcmp(smallBuf, BENCHMARK_FETCH_BUFFER(0), len) == 0);
+            firstChunk = false;
+        }
+    } while (err == WEAVE_ERROR_BUFFER_TOO_SMALL && eventId > chunkEventId);
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, eventId == logger.GetLastEventID(Production) + 1);
+
+    // Events logged after a cursor's events were encoded are picked up.
+
+    LogBenchmarkEvents(20, 5, kWeaveProfile_NestDebug);
+    misses = stats.Misses;
+
+    eventId = firstEventId;
+    err     = FetchBenchmarkEvents(BENCHMARK_FETCH_BUFFER(1), BENCHMARK_FETCH_BUFFER_SIZE, eventId, len, numEvents);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, eventId == logger.GetLastEventID(Production) + 1);
+    NL_TEST_ASSERT(inSuite, len > fullLen);
+    NL_TEST_ASSERT(inSuite, stats.Misses > misses);
+
+    printf("batch cache: %u hits, %u misses, %u evictions, %u uncacheable, %u events served\n", stats.Hits, stats.Misses,
+           stats.Evictions, stats.Uncacheable, stats.EventsServed);
+
+    InitializeEventLogging(context);
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
+#define QUERY_TEST_OTHER_PROFILE 0x0000000CU
+
+// Check that every event in a fetched event list carries its own event
+// ID, in increasing order, and the expected profile, if one is given.
+static size_t CheckQueriedEvents(nlTestSuite * inSuite, const uint8_t * inBuf, size_t inLen, uint32_t inProfileId,
+                                 utc_timestamp_t & ioLastTimestamp)
+{
+    TLVReader reader;
+    TLVType containerType;
+    event_id_t lastEventId = 0;
+    size_t numEvents       = 0;
+
+    reader.Init(inBuf, inLen);
+
+    while (reader.Next() == WEAVE_NO_ERROR)
+    {
+        event_id_t eventId           = 0;
+        uint32_t profileId           = 0;
+        utc_timestamp_t utcTimestamp = 0;
+
+        NL_TEST_ASSERT(inSuite, reader.EnterContainer(containerType) == WEAVE_NO_ERROR);
+
+        while (reader.Next() == WEAVE_NO_ERROR)
+        {
+            if (reader.GetTag() == ContextTag(nl::Weave::Profiles::DataManagement::kTag_EventID))
+            {
+                reader.Get(eventId);
+            }
+            else if (reader.GetTag() == ContextTag(nl::Weave::Profiles::DataManagement::kTag_EventUTCTimestamp))
+            {
+                reader.Get(utcTimestamp);
+            }
+            else if (reader.GetTag() == ContextTag(nl::Weave::Profiles::DataManagement::kTag_EventTraitProfileID))
+            {
+                reader.Get(profileId);
+            }
+        }
+
+        NL_TEST_ASSERT(inSuite, reader.ExitContainer(containerType) == WEAVE_NO_ERROR);
+
+        NL_TEST_ASSERT(inSuite, eventId > lastEventId);
+        NL_TEST_ASSERT(inSuite, utcTimestamp > ioLastTimestamp);
+        NL_TEST_ASSERT(inSuite, (inProfileId == 0) || (profileId == inProfileId));
+
+        lastEventId     = eventId;
+        ioLastTimestamp = utcTimestamp;
+        numEvents++;
+    }
+
+    return numEvents;
+}
+
+static size_t FetchQueriedEvents(nlTestSuite * inSuite, const EventQuery & inQuery, event_id_t inFirstEventId, size_t inBufSize)
+{
+    LoggingManagement & logger    = LoggingManagement::GetInstance();
+    const uint32_t profileId      = inQuery.matchProfile ? inQuery.profileId : 0;
+    utc_timestamp_t lastTimestamp = 0;
+    event_id_t eventId            = inFirstEventId;
+    event_id_t chunkEventId;
+    size_t numEvents = 0;
+    WEAVE_ERROR err;
+
+    do
+    {
+        TLVWriter writer;
+
+        chunkEventId = eventId;
+        writer.Init(gLargeMemoryBackingStore, inBufSize);
+        err = logger.FetchMatchingEvents(writer, inQuery, eventId);
+        writer.Finalize();
+
+        NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV || err == WEAVE_ERROR_BUFFER_TOO_SMALL);
+        numEvents += CheckQueriedEvents(inSuite, gLargeMemoryBackingStore, writer.GetLengthWritten(), profileId, lastTimestamp);
+    } while (err == WEAVE_ERROR_BUFFER_TOO_SMALL && eventId > chunkEventId);
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, eventId == logger.GetLastEventID(Production) + 1);
+
+    return numEvents;
+}
+
+static void CheckEventQuery(nlTestSuite * inSuite, void * inContext)
+{
+    TestLoggingContext * context   = static_cast<TestLoggingContext *>(inContext);
+    LoggingManagement & logger     = LoggingManagement::GetInstance();
+    const EventQueryStats & stats  = logger.GetQueryStats();
+    EventQuery query(Production);
+    event_id_t baseEventId, firstEventId, lastEventId, eventId;
+    size_t numEvents, numFetched;
+    uint32_t value;
+    TLVWriter writer;
+    WEAVE_ERROR err;
+
+    // The test relies on the two profiles not sharing a filter bit.
+    NL_TEST_ASSERT(inSuite,
+                   EventSummaryBlock::GetProfileFilterBit(kWeaveProfile_NestDebug) !=
+                       EventSummaryBlock::GetProfileFilterBit(QUERY_TEST_OTHER_PROFILE));
+
+    InitializeEventLogging(context);
+    LogBenchmarkEvents(0, 20, kWeaveProfile_NestDebug);
+    LogBenchmarkEvents(20, 20, QUERY_TEST_OTHER_PROFILE);
+    logger.ResetQueryStats();
+
+    firstEventId = logger.GetFirstEventID(Production);
+    lastEventId  = logger.GetLastEventID(Production);
+    baseEventId  = firstEventId;
+    NL_TEST_ASSERT(inSuite, lastEventId - firstEventId + 1 == 40);
+
+    // Without conditions, a query fetches every event.
+
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, sizeof(gLargeMemoryBackingStore)) == 40);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, 128) == 40);
+
+    // A query for one profile passes over the runs of the other one.
+
+    query.SetProfile(QUERY_TEST_OTHER_PROFILE);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, sizeof(gLargeMemoryBackingStore)) == 20);
+    NL_TEST_ASSERT(inSuite, stats.BlocksSkipped > 0);
+    NL_TEST_ASSERT(inSuite, stats.EventsMatched == 40 + 40 + 20);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, lastEventId - 4, 128) == 5);
+
+    query.SetProfile(kWeaveProfile_NestDebug);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, sizeof(gLargeMemoryBackingStore)) == 20);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, lastEventId - 4, sizeof(gLargeMemoryBackingStore)) == 0);
+
+    // Events of other importance levels never match.
+
+    eventId = 0;
+    writer.Init(gLargeMemoryBackingStore, sizeof(gLargeMemoryBackingStore));
+    query.importance = Info;
+    err              = logger.FetchMatchingEvents(writer, query, eventId);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_END_OF_TLV);
+    NL_TEST_ASSERT(inSuite, writer.GetLengthWritten() == 0);
+    query.importance = Production;
+
+#if WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+    // A time range selects the events logged in it, of either profile...
+
+    query = EventQuery(Production);
+    query.SetTimeRange(static_cast<utc_timestamp_t>(1500000000000ULL + 10 * 15),
+                       static_cast<utc_timestamp_t>(1500000000000ULL + 10 * 24));
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, sizeof(gLargeMemoryBackingStore)) == 10);
+
+    // ...or of one.
+
+    query.SetProfile(QUERY_TEST_OTHER_PROFILE);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, 128) == 5);
+
+    query.SetTimeRange(static_cast<utc_timestamp_t>(0), static_cast<utc_timestamp_t>(1000));
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, firstEventId, sizeof(gLargeMemoryBackingStore)) == 0);
+#endif // WEAVE_CONFIG_EVENT_LOGGING_UTC_TIMESTAMPS
+
+    // The summaries follow events as they move between buffers and are
+    // dropped: a query still finds every event left in the log.  Log until
+    // the oldest events start to be dropped, then a few more.
+
+    for (value = 40; logger.GetFirstEventID(Production) == baseEventId; value++)
+    {
+        LogBenchmarkEvents(value, 1, kWeaveProfile_NestDebug);
+    }
+    LogBenchmarkEvents(value, 10, QUERY_TEST_OTHER_PROFILE);
+
+    firstEventId = logger.GetFirstEventID(Production);
+    numEvents    = logger.GetLastEventID(Production) - firstEventId + 1;
+    NL_TEST_ASSERT(inSuite, firstEventId > baseEventId && firstEventId < baseEventId + 20);
+
+    query = EventQuery(Production);
+    NL_TEST_ASSERT(inSuite, FetchQueriedEvents(inSuite, query, 0, sizeof(gLargeMemoryBackingStore)) == numEvents);
+
+    query.SetProfile(QUERY_TEST_OTHER_PROFILE);
+    numFetched = FetchQueriedEvents(inSuite, query, 0, sizeof(gLargeMemoryBackingStore));
+    NL_TEST_ASSERT(inSuite, numFetched == 20 + 10);
+
+    printf("event query: %u blocks skipped, %u blocks searched, %u events matched, %u summaries rebuilt\n", stats.BlocksSkipped,
+           stats.BlocksSearched, stats.EventsMatched, stats.SummariesRebuilt);
+
+    NL_TEST_ASSERT(inSuite, stats.SummariesRebuilt == 0);
+
+    InitializeEventLogging(context);
+}
+
+#endif // WEAVE_CONFIG_EVENT_LOGGING_QUERY
+
 static void CheckFetchTimestamps(nlTestSuite * inSuite, void * inContext)
 {
     WEAVE_ERROR err;
@@ -3829,6 +4533,18 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Check Fetch Events", CheckFetchEvents),
     NL_TEST_DEF("Check Large Events", CheckLargeEvents),
     NL_TEST_DEF("Check Fetch Event Timestamps", CheckFetchTimestamps),
+#if WEAVE_CONFIG_EVENT_LOGGING_COMPACT_ENCODING
+    NL_TEST_DEF("Check Compact Event Encoding", CheckCompactEncoding),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_MAPPED_STORAGE
+    NL_TEST_DEF("Check Mapped Event Buffer Recovery", CheckMappedEventBufferRecovery),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_BATCH_CACHE
+    NL_TEST_DEF("Check Event Batch Cache", CheckEventBatchCache),
+#endif
+#if WEAVE_CONFIG_EVENT_LOGGING_QUERY
+    NL_TEST_DEF("Check Event Query", CheckEventQuery),
+#endif
     NL_TEST_DEF("Basic Deserialization Test", CheckBasicEventDeserialization),
     NL_TEST_DEF("Complex Deserialization Test", CheckComplexEventDeserialization),
     NL_TEST_DEF("Empty Array Deserialization Test", CheckEmptyArrayEventDeserialization),
@@ -3880,6 +4596,7 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Check Drop Overlapping Event Id Ranges", CheckDropOverlap),
     NL_TEST_DEF("Check Last Observed Event Id", CheckLastObservedEventId),
     NL_TEST_DEF("Check External Event eviction notification", CheckExternalEventNotifyEvicted),
+    NL_TEST_DEF("Check logging throughput", CheckLoggingThroughput),
     NL_TEST_SENTINEL()
 };
 
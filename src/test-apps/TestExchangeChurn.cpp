@@ -0,0 +1,345 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file tests the ExchangeContext, Binding and WeaveConnection
+ *      pools, and measures the cost of allocating and freeing objects from
+ *      them under heavy churn.
+ *
+ *      Each churn benchmark first fills its pool up to the last free entry,
+ *      and then repeatedly allocates and frees that entry, which is the
+ *      pattern seen when short-lived exchanges (WDM notifies, echoes, WRMP
+ *      exchanges) come and go while long-lived ones hold the rest of the pool.
+ *
+ */
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ToolCommon.h"
+#include <nlunit-test.h>
+#include <Weave/Core/WeaveBinding.h>
+#include <Weave/Support/logging/WeaveLogging.h>
+
+using namespace nl::Inet;
+
+#define TOOL_NAME "TestExchangeChurn"
+#define TEST_DEFAULT_ITERATIONS                       (100000)
+#define TEST_PEER_NODE_ID                             (2)
+
+static uint32_t gIterations = TEST_DEFAULT_ITERATIONS;
+
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+
+enum
+{
+    kToolOpt_Iterations = 1000,
+};
+
+static OptionDef gToolOptionDefs[] =
+{
+    { "iterations", kArgumentRequired, kToolOpt_Iterations },
+    { NULL }
+};
+
+static const char *const gToolOptionHelp =
+    "  --iterations <num>\n"
+    "       Number of allocate/free cycles performed by each churn benchmark.\n"
+    "       Defaults to 100000.\n"
+    "\n";
+
+static OptionSet gToolOptions =
+{
+    HandleOption,
+    gToolOptionDefs,
+    "GENERAL OPTIONS",
+    gToolOptionHelp
+};
+
+static void BindingEventCallback(void *appState, Binding::EventType event, const Binding::InEventParam &inParam,
+                                 Binding::OutEventParam &outParam)
+{
+    Binding::DefaultEventHandler(appState, event, inParam, outParam);
+}
+
+static void ReportChurn(const char *poolName, uint32_t iterations, uint64_t elapsedUS)
+{
+    uint64_t nsPerCycle = (iterations != 0) ? (elapsedUS * 1000) / iterations : 0;
+
+    printf("%s churn: %" PRIu32 " allocate/free cycles in %" PRIu64 " us (%" PRIu64 " ns/cycle)\n", poolName, iterations,
+           elapsedUS, nsPerCycle);
+}
+
+/**
+ *  Test that every ExchangeContext in the pool can be allocated, that allocation fails once the
+ *  pool is exhausted, and that contexts freed in an arbitrary order are all available again.
+ */
+static void TestExchangeChurn_ContextPool(nlTestSuite *testSuite, void *testContext)
+{
+    ExchangeContext *ecs[WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS];
+    int count;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (count = 0; count < WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS; count++)
+        {
+            ecs[count] = ExchangeMgr.NewContext(TEST_PEER_NODE_ID, IPAddress::Any);
+            NL_TEST_ASSERT(testSuite, ecs[count] != NULL);
+            if (ecs[count] == NULL)
+                break;
+
+            for (int i = 0; i < count; i++)
+                NL_TEST_ASSERT(testSuite, ecs[i] != ecs[count]);
+        }
+
+        NL_TEST_ASSERT(testSuite, ExchangeMgr.NewContext(TEST_PEER_NODE_ID, IPAddress::Any) == NULL);
+
+        // Free the odd entries first, then the even ones in reverse order.
+        for (int i = 1; i < count; i += 2)
+            ecs[i]->Close();
+        for (int i = ((count - 1) & ~1); i >= 0; i -= 2)
+            ecs[i]->Close();
+    }
+}
+
+/**
+ *  Measure the cost of creating and closing an ExchangeContext while the rest of the pool is in use.
+ */
+static void TestExchangeChurn_Contexts(nlTestSuite *testSuite, void *testContext)
+{
+    ExchangeContext *held[WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS];
+    int heldCount = 0;
+    uint64_t startTimeUS;
+    uint32_t i;
+
+    while (heldCount < WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS - 1)
+    {
+        held[heldCount] = ExchangeMgr.NewContext(TEST_PEER_NODE_ID, IPAddress::Any);
+        NL_TEST_ASSERT(testSuite, held[heldCount] != NULL);
+        if (held[heldCount] == NULL)
+            break;
+        heldCount++;
+    }
+
+    startTimeUS = System::Layer::GetClock_MonotonicHiRes();
+
+    for (i = 0; i < gIterations; i++)
+    {
+        ExchangeContext *ec = ExchangeMgr.NewContext(TEST_PEER_NODE_ID, IPAddress::Any);
+        if (ec == NULL)
+            break;
+
+        // A reused context must not carry any state over from its previous use.
+        if (ec->AppState != NULL || ec->OnMessageReceived != NULL || ec->Con != NULL || ec->ResponseTimeout != 0 ||
+            !ec->IsInitiator() || ec->IsResponseExpected())
+            break;
+
+        ec->AppState = ec;
+        ec->ResponseTimeout = 1000;
+        ec->SetResponseExpected(true);
+        ec->Close();
+    }
+
+    ReportChurn("ExchangeContext", i, System::Layer::GetClock_MonotonicHiRes() - startTimeUS);
+    NL_TEST_ASSERT(testSuite, i == gIterations);
+
+    while (heldCount > 0)
+        held[--heldCount]->Close();
+}
+
+/**
+ *  Measure the cost of creating and releasing a Binding while the rest of the pool is in use.
+ */
+static void TestExchangeChurn_Bindings(nlTestSuite *testSuite, void *testContext)
+{
+    Binding *held[WEAVE_CONFIG_MAX_BINDINGS];
+    int heldCount = 0;
+    uint64_t startTimeUS;
+    uint32_t i;
+
+    while (heldCount < WEAVE_CONFIG_MAX_BINDINGS - 1)
+    {
+        held[heldCount] = ExchangeMgr.NewBinding(BindingEventCallback, NULL);
+        NL_TEST_ASSERT(testSuite, held[heldCount] != NULL);
+        if (held[heldCount] == NULL)
+            break;
+        heldCount++;
+    }
+
+    startTimeUS = System::Layer::GetClock_MonotonicHiRes();
+
+    for (i = 0; i < gIterations; i++)
+    {
+        Binding *binding = ExchangeMgr.NewBinding(BindingEventCallback, NULL);
+        if (binding == NULL)
+            break;
+
+        binding->Release();
+    }
+
+    ReportChurn("Binding", i, System::Layer::GetClock_MonotonicHiRes() - startTimeUS);
+    NL_TEST_ASSERT(testSuite, i == gIterations);
+
+    // With the last free entry taken, the pool must be exhausted.
+    held[heldCount] = ExchangeMgr.NewBinding(BindingEventCallback, NULL);
+    NL_TEST_ASSERT(testSuite, held[heldCount] != NULL);
+    if (held[heldCount] != NULL)
+    {
+        heldCount++;
+        NL_TEST_ASSERT(testSuite, ExchangeMgr.NewBinding(BindingEventCallback, NULL) == NULL);
+    }
+
+    while (heldCount > 0)
+        held[--heldCount]->Release();
+}
+
+/**
+ *  Measure the cost of creating and releasing a WeaveConnection while the rest of the pool is in use.
+ */
+static void TestExchangeChurn_Connections(nlTestSuite *testSuite, void *testContext)
+{
+    WeaveConnection *held[WEAVE_CONFIG_MAX_CONNECTIONS];
+    int heldCount = 0;
+    nl::Weave::System::Stats::count_t inUse;
+    uint64_t startTimeUS;
+    uint32_t i;
+
+    while (heldCount < WEAVE_CONFIG_MAX_CONNECTIONS - 1)
+    {
+        held[heldCount] = MessageLayer.NewConnection();
+        NL_TEST_ASSERT(testSuite, held[heldCount] != NULL);
+        if (held[heldCount] == NULL)
+            break;
+        heldCount++;
+    }
+
+    startTimeUS = System::Layer::GetClock_MonotonicHiRes();
+
+    for (i = 0; i < gIterations; i++)
+    {
+        WeaveConnection *con = MessageLayer.NewConnection();
+        if (con == NULL)
+            break;
+
+        con->Release();
+    }
+
+    ReportChurn("WeaveConnection", i, System::Layer::GetClock_MonotonicHiRes() - startTimeUS);
+    NL_TEST_ASSERT(testSuite, i == gIterations);
+
+    MessageLayer.GetConnectionPoolStats(inUse);
+    NL_TEST_ASSERT(testSuite, inUse == (nl::Weave::System::Stats::count_t) heldCount);
+
+    while (heldCount > 0)
+        held[--heldCount]->Release();
+
+    MessageLayer.GetConnectionPoolStats(inUse);
+    NL_TEST_ASSERT(testSuite, inUse == 0);
+}
+
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    switch (id)
+    {
+    case kToolOpt_Iterations:
+        if (!ParseInt(arg, gIterations) || gIterations == 0)
+        {
+            PrintArgError("%s: Invalid value specified for iteration count: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gToolOptions,
+    &gNetworkOptions,
+    &gWeaveNodeOptions,
+    &gFaultInjectionOptions,
+    &gHelpOptions,
+    NULL
+};
+
+int main(int argc, char *argv[])
+{
+    const nlTest ChurnTests[] = {
+        NL_TEST_DEF("TestExchangeChurn:ContextPool", TestExchangeChurn_ContextPool),
+        NL_TEST_DEF("TestExchangeChurn:Contexts",    TestExchangeChurn_Contexts),
+        NL_TEST_DEF("TestExchangeChurn:Bindings",    TestExchangeChurn_Bindings),
+        NL_TEST_DEF("TestExchangeChurn:Connections", TestExchangeChurn_Connections),
+        NL_TEST_SENTINEL()
+    };
+
+    nlTestSuite ChurnTestSuite = {
+        "ExchangeChurn",
+        &ChurnTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    InitToolCommon();
+
+    SetupFaultInjectionContext(argc, argv);
+
+    if (!ParseArgsFromEnvVar(TOOL_NAME, TOOL_OPTIONS_ENV_VAR_NAME, gToolOptionSets, NULL, true) ||
+        !ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets, NULL))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    InitSystemLayer();
+
+    InitNetwork();
+
+    InitWeaveStack(false, true);
+
+    // Keep per-object log messages from dominating the measurements.
+    nl::Weave::Logging::SetLogFilter(nl::Weave::Logging::kLogCategory_Error);
+
+    // Run all tests in Suite
+
+    nlTestRunner(&ChurnTestSuite, NULL);
+
+    ShutdownWeaveStack();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    return nlTestRunnerStats(&ChurnTestSuite);
+}
@@ -307,6 +307,79 @@ static void TestInetInterface(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, !addrIterator.HasBroadcastAddress());
 }
 
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+static InterfaceId LookupInterfaceFromAddrUncached(const IPAddress& addr)
+{
+    for (InterfaceAddressIterator addrIter; addrIter.HasCurrent(); addrIter.Next())
+    {
+        if (addrIter.GetAddress() == addr)
+            return addrIter.GetInterfaceId();
+    }
+
+    return INET_NULL_INTERFACEID;
+}
+
+static void TestInetInterfaceCache(nlTestSuite *inSuite, void *inContext)
+{
+    const InterfaceCache *intfCache = Inet.GetInterfaceCache();
+    const uint32_t kNumLookups = 1000;
+    InterfaceId intId;
+    IPAddress addr;
+    uint16_t numAddrs = 0;
+    uint64_t start, uncachedTime, cachedTime;
+
+    if (intfCache == NULL)
+    {
+        printf("    Interface cache unavailable, skipping\n");
+        return;
+    }
+
+    // The cache must agree with the iterators it replaces.
+    for (InterfaceAddressIterator addrIter; addrIter.HasCurrent(); addrIter.Next())
+    {
+        addr = addrIter.GetAddress();
+        intId = INET_NULL_INTERFACEID;
+        Inet.GetInterfaceFromAddr(addr, intId);
+        NL_TEST_ASSERT(inSuite, intId == addrIter.GetInterfaceId());
+        numAddrs++;
+    }
+    NL_TEST_ASSERT(inSuite, numAddrs == intfCache->NumAddresses());
+
+    uint16_t numIntfs = 0;
+    for (InterfaceIterator intfIter; intfIter.HasCurrent(); intfIter.Next())
+    {
+        const InterfaceCache::Interface & intf = intfCache->GetInterface(numIntfs);
+        NL_TEST_ASSERT(inSuite, intf.Id == intfIter.GetInterfaceId());
+        NL_TEST_ASSERT(inSuite, ((intf.Flags & InterfaceCache::kFlag_Up) != 0) == intfIter.IsUp());
+        numIntfs++;
+    }
+    NL_TEST_ASSERT(inSuite, numIntfs == intfCache->NumInterfaces());
+
+    // An address that is not assigned locally must not match.
+    IPAddress::FromString("2001:db8::1", addr);
+    Inet.GetInterfaceFromAddr(addr, intId);
+    NL_TEST_ASSERT(inSuite, intId == INET_NULL_INTERFACEID);
+
+    // Microbenchmark: look up the last address in the table, which is the
+    // worst case for both the system query and the cached table.
+    if (numAddrs > 0)
+        addr = intfCache->GetAddress(numAddrs - 1).Addr;
+
+    start = Now();
+    for (uint32_t i = 0; i < kNumLookups; i++)
+        intId = LookupInterfaceFromAddrUncached(addr);
+    uncachedTime = Now() - start;
+
+    start = Now();
+    for (uint32_t i = 0; i < kNumLookups; i++)
+        Inet.GetInterfaceFromAddr(addr, intId);
+    cachedTime = Now() - start;
+
+    printf("    %u interface address lookups over %u addresses: uncached %" PRIu64 " us, cached %" PRIu64 " us\n",
+           kNumLookups, numAddrs, uncachedTime, cachedTime);
+}
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
+
 static void TestInetEndPoint(nlTestSuite *inSuite, void *inContext)
 {
     INET_ERROR err;
@@ -570,6 +643,9 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("InetEndPoint::TestParseHost",       TestParseHost),
     NL_TEST_DEF("InetEndPoint::TestInetError",       TestInetError),
     NL_TEST_DEF("InetEndPoint::TestInetInterface",   TestInetInterface),
+#if INET_CONFIG_ENABLE_INTERFACE_CACHE
+    NL_TEST_DEF("InetEndPoint::TestInterfaceCache",  TestInetInterfaceCache),
+#endif // INET_CONFIG_ENABLE_INTERFACE_CACHE
     NL_TEST_DEF("InetEndPoint::TestInetEndPoint",    TestInetEndPoint),
     NL_TEST_DEF("InetEndPoint::TestEndPointLimit",   TestInetEndPointLimit),
     NL_TEST_SENTINEL()
@@ -0,0 +1,170 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements unit tests for the LatencyHistogram used by the
+ *      weave-echo-load tool.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <nlunit-test.h>
+
+#include "LatencyHistogram.h"
+
+/**
+ *  Test that every value maps to a bucket whose range contains it, that bucket
+ *  indices never decrease as values grow, and that the width of a bucket is
+ *  within the advertised relative error.
+ */
+static void LatencyHistogram_Buckets(nlTestSuite *inSuite, void *inContext)
+{
+    uint32_t lastIndex = 0;
+
+    for (uint32_t value = 0; value < LatencyHistogram::kSubBucketCount; value++)
+    {
+        NL_TEST_ASSERT(inSuite, LatencyHistogram::BucketIndex(value) == value);
+        NL_TEST_ASSERT(inSuite, LatencyHistogram::BucketHighestValue(value) == value);
+    }
+
+    for (uint64_t value = 1; value <= UINT32_MAX; value = value * 3 / 2 + 1)
+    {
+        uint32_t index = LatencyHistogram::BucketIndex((uint32_t) value);
+        uint32_t highest = LatencyHistogram::BucketHighestValue(index);
+
+        NL_TEST_ASSERT(inSuite, index < LatencyHistogram::kBucketCount);
+        NL_TEST_ASSERT(inSuite, index >= lastIndex);
+        NL_TEST_ASSERT(inSuite, highest >= value);
+        NL_TEST_ASSERT(inSuite, highest - value <= value / LatencyHistogram::kSubBucketCount);
+        NL_TEST_ASSERT(inSuite, index == 0 || LatencyHistogram::BucketHighestValue(index - 1) < value);
+
+        lastIndex = index;
+    }
+
+    NL_TEST_ASSERT(inSuite, LatencyHistogram::BucketIndex(UINT32_MAX) == LatencyHistogram::kBucketCount - 1);
+    NL_TEST_ASSERT(inSuite, LatencyHistogram::BucketHighestValue(LatencyHistogram::kBucketCount - 1) == UINT32_MAX);
+}
+
+/**
+ *  Test the count, min, max, mean and percentiles of a uniform distribution.
+ */
+static void LatencyHistogram_Percentiles(nlTestSuite *inSuite, void *inContext)
+{
+    LatencyHistogram histogram;
+
+    NL_TEST_ASSERT(inSuite, histogram.GetCount() == 0);
+    NL_TEST_ASSERT(inSuite, histogram.GetMin() == 0);
+    NL_TEST_ASSERT(inSuite, histogram.GetMax() == 0);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(50) == 0);
+
+    // 1..10000 us, recorded in reverse order.
+    for (uint32_t value = 10000; value >= 1; value--)
+        histogram.Record(value);
+
+    NL_TEST_ASSERT(inSuite, histogram.GetCount() == 10000);
+    NL_TEST_ASSERT(inSuite, histogram.GetMin() == 1);
+    NL_TEST_ASSERT(inSuite, histogram.GetMax() == 10000);
+    NL_TEST_ASSERT(inSuite, histogram.GetMean() == 5000);
+
+    // Each percentile is reported as the top of the bucket holding the exact value,
+    // so it may be high by up to one bucket width, but never low.
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(50) >= 5000 && histogram.GetPercentile(50) <= 5000 + 5000 / 32);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(99) >= 9900 && histogram.GetPercentile(99) <= 9900 + 9900 / 32);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(99.9) >= 9990 && histogram.GetPercentile(99.9) <= 10000);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(0) == 1);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(100) == 10000);
+
+    histogram.Reset();
+
+    NL_TEST_ASSERT(inSuite, histogram.GetCount() == 0);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(99) == 0);
+}
+
+/**
+ *  Test that a long tail shows up in the high percentiles but not the median.
+ */
+static void LatencyHistogram_Tail(nlTestSuite *inSuite, void *inContext)
+{
+    LatencyHistogram histogram;
+
+    for (int i = 0; i < 990; i++)
+        histogram.Record(1000);
+    for (int i = 0; i < 10; i++)
+        histogram.Record(2000000);
+
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(50) >= 1000 && histogram.GetPercentile(50) < 1100);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(99) >= 1000 && histogram.GetPercentile(99) < 1100);
+    NL_TEST_ASSERT(inSuite, histogram.GetPercentile(99.9) == 2000000);
+    NL_TEST_ASSERT(inSuite, histogram.GetMax() == 2000000);
+}
+
+/**
+ *  Test that merging histograms gives the same result as recording all the samples in one.
+ */
+static void LatencyHistogram_Add(nlTestSuite *inSuite, void *inContext)
+{
+    LatencyHistogram all;
+    LatencyHistogram odd;
+    LatencyHistogram even;
+    LatencyHistogram empty;
+
+    for (uint32_t value = 100; value < 5000; value++)
+    {
+        all.Record(value);
+        if (value & 1)
+            odd.Record(value);
+        else
+            even.Record(value);
+    }
+
+    odd.Add(empty);
+    NL_TEST_ASSERT(inSuite, odd.GetMin() == 101);
+
+    odd.Add(even);
+
+    NL_TEST_ASSERT(inSuite, odd.GetCount() == all.GetCount());
+    NL_TEST_ASSERT(inSuite, odd.GetMin() == all.GetMin());
+    NL_TEST_ASSERT(inSuite, odd.GetMax() == all.GetMax());
+    NL_TEST_ASSERT(inSuite, odd.GetMean() == all.GetMean());
+    NL_TEST_ASSERT(inSuite, odd.GetPercentile(50) == all.GetPercentile(50));
+    NL_TEST_ASSERT(inSuite, odd.GetPercentile(99.9) == all.GetPercentile(99.9));
+}
+
+int main(int argc, char *argv[])
+{
+    static const nlTest tests[] = {
+        NL_TEST_DEF("LatencyHistogram_Buckets",                 LatencyHistogram_Buckets),
+        NL_TEST_DEF("LatencyHistogram_Percentiles",             LatencyHistogram_Percentiles),
+        NL_TEST_DEF("LatencyHistogram_Tail",                    LatencyHistogram_Tail),
+        NL_TEST_DEF("LatencyHistogram_Add",                     LatencyHistogram_Add),
+        NL_TEST_SENTINEL()
+    };
+
+    static nlTestSuite testSuite = {
+        "latency-histogram",
+        &tests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    nlTestRunner(&testSuite, NULL);
+
+    return nlTestRunnerStats(&testSuite);
+}
@@ -32,8 +32,10 @@
 #include <string.h>
 
 #include "ToolCommon.h"
+#include "TestGroupKeyStore.h"
 #include <Weave/Core/WeaveConfig.h>
 #include <Weave/Support/crypto/CTRMode.h>
+#include <Weave/Support/crypto/CCMMode.h>
 #include <Weave/Support/crypto/WeaveCrypto.h>
 
 #if WEAVE_SYSTEM_CONFIG_USE_LWIP
@@ -44,6 +46,7 @@ using namespace nl::Inet;
 using namespace nl::Weave::Encoding;
 using namespace nl::Weave::Crypto;
 using namespace nl::Weave::Profiles::Security;
+using namespace nl::Weave::Profiles::Security::AppKeys;
 
 #define DEBUG_PRINT_ENABLE 0
 
@@ -60,6 +63,24 @@ public:
     {
         return msgLayer->DecodeMessage(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen);
     }
+
+    WEAVE_ERROR EncodeMessageWithLength(WeaveMessageInfo *msgInfo, PacketBuffer *msgBuf, WeaveConnection *con, uint16_t maxLen)
+    {
+        return msgLayer->EncodeMessageWithLength(msgInfo, msgBuf, con, maxLen);
+    }
+
+    WEAVE_ERROR DecodeMessageWithLength(PacketBuffer *msgBuf, uint64_t sourceNodeId, WeaveConnection *con,
+            WeaveMessageInfo *msgInfo, uint8_t **rPayload, uint16_t *rPayloadLen, uint32_t *rFrameLen)
+    {
+        return msgLayer->DecodeMessageWithLength(msgBuf, sourceNodeId, con, msgInfo, rPayload, rPayloadLen, rFrameLen);
+    }
+
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    static WEAVE_ERROR CheckCoalescedDatagram(const PacketBuffer *msg)
+    {
+        return WeaveMessageLayer::CheckCoalescedDatagram(msg);
+    }
+#endif
 };
 
 } // namespace nl
@@ -340,10 +361,854 @@ void WeaveMessageEncryption_Test1(nlTestSuite *inSuite, void *inContext)
 }
 
 
+enum
+{
+    // Length of the payload encoded in the chained buffer test.
+    kChainTestPayloadLen = 250,
+
+    // Length of the message header encoded in the chained buffer test.
+    kChainTestHeaderLen = 24,
+};
+
+// Segment sizes used to split payloads and encoded messages across chains of buffers.
+static const uint16_t sChainTestSegmentSizes[] = { 7, 16, 37, 128, kChainTestPayloadLen };
+
+// Build a buffer chain holding the specified data, with at most firstSegSize bytes in the first buffer
+// and at most segSize bytes in each subsequent buffer.
+static PacketBuffer *MakeBufferChain(const uint8_t *data, uint16_t dataLen, uint16_t firstSegSize, uint16_t segSize)
+{
+    PacketBuffer *head = NULL;
+
+    do
+    {
+        uint16_t maxLen = (head == NULL) ? firstSegSize : segSize;
+        uint16_t len = (dataLen < maxLen) ? dataLen : maxLen;
+        PacketBuffer *buf = PacketBuffer::New();
+
+        if (buf == NULL)
+        {
+            PacketBuffer::Free(head);
+            return NULL;
+        }
+
+        memcpy(buf->Start(), data, len);
+        buf->SetDataLength(len);
+
+        if (head == NULL)
+            head = buf;
+        else
+            head->AddToEnd(buf);
+
+        data += len;
+        dataLen -= len;
+    } while (dataLen > 0);
+
+    return head;
+}
+
+// Copy the contents of a buffer chain, beginning at the specified position in the first buffer, into a flat array.
+static uint16_t FlattenBufferChain(PacketBuffer *buf, const uint8_t *start, uint8_t *out, uint16_t outSize)
+{
+    uint16_t outLen = 0;
+
+    for (; buf != NULL; buf = buf->Next(), start = NULL)
+    {
+        const uint8_t *segStart = (start != NULL) ? start : buf->Start();
+        uint16_t segLen = buf->DataLength() - (segStart - buf->Start());
+
+        if (outLen + segLen > outSize)
+            break;
+
+        memcpy(out + outLen, segStart, segLen);
+        outLen += segLen;
+    }
+
+    return outLen;
+}
+
+static void InitChainTestMsgInfo(WeaveMessageInfo &msgInfo, uint64_t srcNodeId, uint64_t destNodeId, uint8_t encType)
+{
+    msgInfo.Clear();
+    msgInfo.SourceNodeId = srcNodeId;
+    msgInfo.DestNodeId = destNodeId;
+    msgInfo.MessageId = 7;
+    msgInfo.KeyId = sTestDefaultSessionKeyId;
+    msgInfo.Flags = kWeaveMessageFlag_DestNodeId | kWeaveMessageFlag_SourceNodeId | kWeaveMessageFlag_ReuseMessageId;
+    msgInfo.MessageVersion = kWeaveMessageVersion_V2;
+    msgInfo.EncryptionType = encType;
+}
+
+// Form a test session key of the specified encryption type.
+static void InitTestSessionKey(uint8_t encType, WeaveEncryptionKey &msgEncSessionKey)
+{
+    if (encType == kWeaveEncryptionType_AES128CTRSHA1)
+    {
+        memcpy(msgEncSessionKey.AES128CTRSHA1.DataKey, sMsgEncKey_DataKey, sizeof(sMsgEncKey_DataKey));
+        memcpy(msgEncSessionKey.AES128CTRSHA1.IntegrityKey, sMsgEncKey_IntegrityKey, sizeof(sMsgEncKey_IntegrityKey));
+    }
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    else if (encType == kWeaveEncryptionType_AES128CCM)
+    {
+        memcpy(msgEncSessionKey.AES128CCM.Key, sMsgEncKey_DataKey, sizeof(sMsgEncKey_DataKey));
+    }
+#endif
+}
+
+static void CheckChainedBuffers(nlTestSuite *inSuite, uint8_t encType)
+{
+    static WeaveFabricState fabricState;
+    static WeaveMessageLayer messageLayer;
+
+    WEAVE_ERROR err;
+    WeaveMessageLayerTestObject msgLayerTestObject;
+    WeaveMessageInfo msgInfo;
+    WeaveSessionKey *sessionKey;
+    WeaveEncryptionKey msgEncSessionKey;
+    PacketBuffer *msgBuf;
+    uint64_t srcNodeId;
+    uint64_t destNodeId = 0x18B4300012345678;
+    uint8_t payloadData[kChainTestPayloadLen];
+    uint8_t refMsg[kChainTestPayloadLen + 64];
+    uint16_t refMsgLen;
+    uint8_t flatBuf[kChainTestPayloadLen + 64];
+    uint8_t *payload;
+    uint16_t payloadLen;
+
+    const char localAddrStr[] = "fd00:0:1:1:18B4:3000::2";
+    IPAddress localIPv6Addr;
+    NL_TEST_ASSERT(inSuite, ParseIPAddress(localAddrStr, localIPv6Addr));
+
+    err = fabricState.Init();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    srcNodeId = localIPv6Addr.InterfaceId();
+    fabricState.LocalNodeId = srcNodeId;
+    fabricState.FabricId = localIPv6Addr.GlobalId();
+    fabricState.DefaultSubnet = localIPv6Addr.Subnet();
+
+    InitTestSessionKey(encType, msgEncSessionKey);
+
+    // Install the session key for both the destination (encode) and the local node (decode).
+    err = fabricState.AllocSessionKey(destNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.SetSessionKey(sessionKey, encType, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    err = fabricState.AllocSessionKey(srcNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.SetSessionKey(sessionKey, encType, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    messageLayer.FabricState = &fabricState;
+    msgLayerTestObject.msgLayer = &messageLayer;
+
+    for (uint16_t i = 0; i < kChainTestPayloadLen; i++)
+        payloadData[i] = (uint8_t) (i * 7 + 3);
+
+    // Encode the payload from a single buffer to produce the reference encoding.
+    msgBuf = MakeBufferChain(payloadData, sizeof(payloadData), sizeof(payloadData), sizeof(payloadData));
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return;
+
+    InitChainTestMsgInfo(msgInfo, srcNodeId, destNodeId, encType);
+    err = messageLayer.EncodeMessage(&msgInfo, msgBuf, NULL, UINT16_MAX, 0);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    refMsgLen = FlattenBufferChain(msgBuf, msgBuf->Start(), refMsg, sizeof(refMsg));
+    NL_TEST_ASSERT(inSuite, refMsgLen == msgBuf->DataLength());
+    PacketBuffer::Free(msgBuf);
+
+    for (size_t ith = 0; ith < sizeof(sChainTestSegmentSizes) / sizeof(sChainTestSegmentSizes[0]); ith++)
+    {
+        uint16_t segSize = sChainTestSegmentSizes[ith];
+        uint16_t msgLen;
+
+        // =====================================================================================================
+        // Encode a payload spread across a buffer chain and compare against the reference encoding.
+        // =====================================================================================================
+        msgBuf = MakeBufferChain(payloadData, sizeof(payloadData), segSize, segSize);
+        NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+        if (msgBuf == NULL)
+            continue;
+
+        InitChainTestMsgInfo(msgInfo, srcNodeId, destNodeId, encType);
+        err = messageLayer.EncodeMessage(&msgInfo, msgBuf, NULL, UINT16_MAX, 0);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, msgBuf->TotalLength() == refMsgLen);
+
+        msgLen = FlattenBufferChain(msgBuf, msgBuf->Start(), flatBuf, sizeof(flatBuf));
+        NL_TEST_ASSERT(inSuite, msgLen == refMsgLen && memcmp(flatBuf, refMsg, refMsgLen) == 0);
+
+        // Decode the encoded chain in place and verify the payload.
+        err = msgLayerTestObject.DecodeMessage(msgBuf, srcNodeId, NULL, &msgInfo, &payload, &payloadLen);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        if (err == WEAVE_NO_ERROR)
+        {
+            NL_TEST_ASSERT(inSuite, payloadLen == ((segSize < sizeof(payloadData)) ? segSize : sizeof(payloadData)));
+            msgLen = FlattenBufferChain(msgBuf, payload, flatBuf, sizeof(flatBuf));
+            NL_TEST_ASSERT(inSuite, msgLen == sizeof(payloadData) && memcmp(flatBuf, payloadData, sizeof(payloadData)) == 0);
+        }
+
+        PacketBuffer::Free(msgBuf);
+
+        // =====================================================================================================
+        // Split the reference encoding across a buffer chain, so that the integrity check value straddles
+        // buffer boundaries, and verify that it decodes.
+        // =====================================================================================================
+        // The message header must be contained in the first buffer.
+        msgBuf = MakeBufferChain(refMsg, refMsgLen, kChainTestHeaderLen + segSize, segSize);
+        NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+        if (msgBuf == NULL)
+            continue;
+
+        msgInfo.Clear();
+        err = msgLayerTestObject.DecodeMessage(msgBuf, srcNodeId, NULL, &msgInfo, &payload, &payloadLen);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        if (err == WEAVE_NO_ERROR)
+        {
+            msgLen = FlattenBufferChain(msgBuf, payload, flatBuf, sizeof(flatBuf));
+            NL_TEST_ASSERT(inSuite, msgLen == sizeof(payloadData) && memcmp(flatBuf, payloadData, sizeof(payloadData)) == 0);
+        }
+
+        PacketBuffer::Free(msgBuf);
+
+        // Corrupt the last byte of the integrity check value and verify that decoding fails.
+        refMsg[refMsgLen - 1] ^= 0x01;
+
+        msgBuf = MakeBufferChain(refMsg, refMsgLen, kChainTestHeaderLen + segSize, segSize);
+        NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+        if (msgBuf != NULL)
+        {
+            msgInfo.Clear();
+            err = msgLayerTestObject.DecodeMessage(msgBuf, srcNodeId, NULL, &msgInfo, &payload, &payloadLen);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INTEGRITY_CHECK_FAILED);
+            PacketBuffer::Free(msgBuf);
+        }
+
+        refMsg[refMsgLen - 1] ^= 0x01;
+    }
+
+    // =====================================================================================================
+    // Decode a length-prefixed message, as received over TCP, that is followed by more received data in the
+    // next buffer of the queue. Only the message itself is decoded and the following data is left in place.
+    // =====================================================================================================
+    msgBuf = MakeBufferChain(payloadData, sizeof(payloadData), sizeof(payloadData), sizeof(payloadData));
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf != NULL)
+    {
+        PacketBuffer *nextBuf = MakeBufferChain(refMsg, kChainTestHeaderLen, kChainTestHeaderLen, kChainTestHeaderLen);
+        uint32_t frameLen;
+
+        InitChainTestMsgInfo(msgInfo, srcNodeId, destNodeId, encType);
+        err = msgLayerTestObject.EncodeMessageWithLength(&msgInfo, msgBuf, NULL, UINT16_MAX);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        NL_TEST_ASSERT(inSuite, nextBuf != NULL);
+
+        if (err == WEAVE_NO_ERROR && nextBuf != NULL)
+        {
+            msgBuf->AddToEnd(nextBuf);
+
+            msgInfo.Clear();
+            err = msgLayerTestObject.DecodeMessageWithLength(msgBuf, srcNodeId, NULL, &msgInfo, &payload, &payloadLen, &frameLen);
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+            NL_TEST_ASSERT(inSuite, frameLen == refMsgLen + 2u);
+            NL_TEST_ASSERT(inSuite, payloadLen == sizeof(payloadData) && memcmp(payload, payloadData, sizeof(payloadData)) == 0);
+            NL_TEST_ASSERT(inSuite, msgBuf->DataLength() == 0);
+            NL_TEST_ASSERT(inSuite, msgBuf->Next() == nextBuf && msgBuf->TotalLength() == kChainTestHeaderLen);
+        }
+        else if (nextBuf != NULL)
+        {
+            PacketBuffer::Free(nextBuf);
+        }
+
+        PacketBuffer::Free(msgBuf);
+    }
+
+    fabricState.Shutdown();
+}
+
+void WeaveMessageEncryption_ChainedBuffers(nlTestSuite *inSuite, void *inContext)
+{
+    CheckChainedBuffers(inSuite, kWeaveEncryptionType_AES128CTRSHA1);
+}
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+void WeaveMessageEncryption_AES128CCM(nlTestSuite *inSuite, void *inContext)
+{
+    static WeaveFabricState fabricState;
+    static WeaveMessageLayer messageLayer;
+
+    WEAVE_ERROR err;
+    WeaveMessageLayerTestObject msgLayerTestObject;
+    WeaveMessageInfo msgInfo;
+    WeaveSessionKey *sessionKey;
+    WeaveEncryptionKey msgEncSessionKey;
+    PacketBuffer *msgBuf;
+    uint64_t srcNodeId;
+    uint64_t destNodeId = 0x18B4300012345678;
+    uint8_t *payload;
+    uint16_t payloadLen;
+
+    const char localAddrStr[] = "fd00:0:1:1:18B4:3000::2";
+    IPAddress localIPv6Addr;
+    NL_TEST_ASSERT(inSuite, ParseIPAddress(localAddrStr, localIPv6Addr));
+
+    // Run the chained buffer checks using AES-128-CCM.
+    CheckChainedBuffers(inSuite, kWeaveEncryptionType_AES128CCM);
+
+    err = fabricState.Init();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    srcNodeId = localIPv6Addr.InterfaceId();
+    fabricState.LocalNodeId = srcNodeId;
+    fabricState.FabricId = localIPv6Addr.GlobalId();
+    fabricState.DefaultSubnet = localIPv6Addr.Subnet();
+
+    InitTestSessionKey(kWeaveEncryptionType_AES128CCM, msgEncSessionKey);
+
+    err = fabricState.AllocSessionKey(destNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CCM, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    err = fabricState.AllocSessionKey(srcNodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.SetSessionKey(sessionKey, kWeaveEncryptionType_AES128CCM, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    messageLayer.FabricState = &fabricState;
+    msgLayerTestObject.msgLayer = &messageLayer;
+
+    msgBuf = PacketBuffer::New();
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return;
+
+    memcpy(msgBuf->Start(), sMsgPayload, sizeof(sMsgPayload));
+    msgBuf->SetDataLength(sizeof(sMsgPayload));
+
+    InitChainTestMsgInfo(msgInfo, srcNodeId, destNodeId, kWeaveEncryptionType_AES128CCM);
+    err = messageLayer.EncodeMessage(&msgInfo, msgBuf, NULL, UINT16_MAX, 0);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, msgBuf->DataLength() == kChainTestHeaderLen + sizeof(sMsgPayload) + 16);
+
+    // Independently compute the expected ciphertext and tag using the nonce (source node id followed by
+    // message id) and additional data (source and destination node ids, masked header field and message
+    // id) defined for the AES-128-CCM message encryption type.
+    {
+        AES128CCMMode aes128CCM;
+        uint8_t nonce[12];
+        uint8_t aad[2 * sizeof(uint64_t) + sizeof(uint16_t) + sizeof(uint32_t)];
+        uint8_t expected[sizeof(sMsgPayload) + 16];
+        uint8_t *p;
+        uint16_t headerField = (uint16_t) (LittleEndian::Get16(msgBuf->Start()) & kMsgHeaderField_MessageHMACMask);
+
+        p = nonce;
+        BigEndian::Write64(p, srcNodeId);
+        BigEndian::Write32(p, msgInfo.MessageId);
+
+        p = aad;
+        LittleEndian::Write64(p, srcNodeId);
+        LittleEndian::Write64(p, destNodeId);
+        LittleEndian::Write16(p, headerField);
+        LittleEndian::Write32(p, msgInfo.MessageId);
+
+        aes128CCM.SetKey(sMsgEncKey_DataKey);
+        err = aes128CCM.Begin(nonce, sizeof(nonce), sizeof(aad), sizeof(sMsgPayload), 16);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        aes128CCM.AddAAD(aad, sizeof(aad));
+        aes128CCM.EncryptData(sMsgPayload, sizeof(sMsgPayload), expected);
+        aes128CCM.Finish(expected + sizeof(sMsgPayload));
+
+        NL_TEST_ASSERT(inSuite, memcmp(msgBuf->Start() + kChainTestHeaderLen, expected, sizeof(expected)) == 0);
+    }
+
+    // Decode the message and verify the payload.
+    msgInfo.Clear();
+    err = msgLayerTestObject.DecodeMessage(msgBuf, srcNodeId, NULL, &msgInfo, &payload, &payloadLen);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, msgInfo.EncryptionType == kWeaveEncryptionType_AES128CCM);
+    NL_TEST_ASSERT(inSuite, payloadLen == sizeof(sMsgPayload) && memcmp(payload, sMsgPayload, sizeof(sMsgPayload)) == 0);
+
+    PacketBuffer::Free(msgBuf);
+
+    fabricState.Shutdown();
+}
+
+enum
+{
+    // Payload length and iteration count for the message encryption timing report. The times are
+    // printed for information only; they depend on the AES implementation and are not checked.
+    kThroughputTestPayloadLen = 1024,
+    kThroughputTestIterations = 2000,
+};
+
+// Encode and decode a fixed payload repeatedly using the specified encryption type and return the elapsed time in microseconds.
+static uint64_t MeasureMessageEncryption(nlTestSuite *inSuite, uint8_t encType)
+{
+    static WeaveFabricState fabricState;
+    static WeaveMessageLayer messageLayer;
+
+    WEAVE_ERROR err;
+    WeaveMessageLayerTestObject msgLayerTestObject;
+    WeaveMessageInfo msgInfo;
+    WeaveSessionKey *sessionKey;
+    WeaveEncryptionKey msgEncSessionKey;
+    PacketBuffer *msgBuf;
+    uint64_t nodeId = 0x18B4300000000002;
+    uint8_t *payload;
+    uint16_t payloadLen;
+    uint64_t startTime;
+    uint64_t elapsedUS;
+
+    err = fabricState.Init();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.LocalNodeId = nodeId;
+
+    InitTestSessionKey(encType, msgEncSessionKey);
+    err = fabricState.AllocSessionKey(nodeId, sTestDefaultSessionKeyId, NULL, sessionKey);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    fabricState.SetSessionKey(sessionKey, encType, kWeaveAuthMode_CASE_Device, &msgEncSessionKey);
+
+    messageLayer.FabricState = &fabricState;
+    msgLayerTestObject.msgLayer = &messageLayer;
+
+    msgBuf = PacketBuffer::New();
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return 0;
+
+    startTime = Now();
+
+    for (uint32_t i = 0; i < kThroughputTestIterations; i++)
+    {
+        memset(msgBuf->Start(), (uint8_t) i, kThroughputTestPayloadLen);
+        msgBuf->SetDataLength(kThroughputTestPayloadLen);
+
+        InitChainTestMsgInfo(msgInfo, nodeId, nodeId, encType);
+        msgInfo.MessageId = i;
+        err = messageLayer.EncodeMessage(&msgInfo, msgBuf, NULL, UINT16_MAX, 0);
+        if (err != WEAVE_NO_ERROR)
+            break;
+
+        msgInfo.Clear();
+        err = msgLayerTestObject.DecodeMessage(msgBuf, nodeId, NULL, &msgInfo, &payload, &payloadLen);
+        if (err != WEAVE_NO_ERROR)
+            break;
+
+        // Return the buffer to its initial state for the next iteration.
+        msgBuf->SetStart(payload);
+    }
+
+    elapsedUS = Now() - startTime;
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    PacketBuffer::Free(msgBuf);
+    fabricState.Shutdown();
+
+    return elapsedUS;
+}
+
+void WeaveMessageEncryption_Throughput(nlTestSuite *inSuite, void *inContext)
+{
+    uint64_t ctrSHA1US = MeasureMessageEncryption(inSuite, kWeaveEncryptionType_AES128CTRSHA1);
+    uint64_t ccmUS = MeasureMessageEncryption(inSuite, kWeaveEncryptionType_AES128CCM);
+
+    printf("Encode+decode of %u x %u byte messages: AES128CTRSHA1 %" PRIu64 " us, AES128CCM %" PRIu64 " us\n",
+           (unsigned) kThroughputTestIterations, (unsigned) kThroughputTestPayloadLen, ctrSHA1US, ccmUS);
+}
+
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+
+#if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
+
+enum
+{
+    // Number of application groups receiving multicast messages in the key cache test. Only half of
+    // the key cache is used by the current epoch keys so that the next epoch keys can be precomputed.
+    kAppKeyCacheTestGroupCount = ((WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS / 2) < 4) ? (WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS / 2) : 4,
+
+    // Number of messages received from each group in the key cache test.
+    kAppKeyCacheTestMsgsPerGroup = 1000,
+
+    kAppKeyCacheTestMaxEncodedMsgLen = 128,
+
+    // Number of application groups, and of distinct keys, used by the key cache thrash test:
+    // a rotating and a static key per group under two root keys, more than the cache holds.
+    kAppKeyCacheThrashTestGroupCount = 4,
+    kAppKeyCacheThrashTestKeyCount = 2 * 2 * kAppKeyCacheThrashTestGroupCount,
+
+    // Number of rounds in which the key cache thrash test receives one message per key.
+    kAppKeyCacheThrashTestIterations = 100,
+};
+
+struct AppKeyCacheTestMsg
+{
+    uint8_t Data[kAppKeyCacheTestMaxEncodedMsgLen];
+    uint16_t DataLen;
+};
+
+// Encode the test payload as a multicast message encrypted with the specified application key.
+static void EncodeAppKeyMsg(nlTestSuite *inSuite, WeaveMessageLayer &msgLayer, uint32_t keyId, uint32_t msgId, AppKeyCacheTestMsg &encodedMsg)
+{
+    WEAVE_ERROR err;
+    WeaveMessageInfo msgInfo;
+    PacketBuffer *msgBuf = PacketBuffer::New();
+
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return;
+
+    memcpy(msgBuf->Start(), sMsgPayload, sizeof(sMsgPayload));
+    msgBuf->SetDataLength(sizeof(sMsgPayload));
+
+    msgInfo.Clear();
+    msgInfo.SourceNodeId = msgLayer.FabricState->LocalNodeId;
+    msgInfo.DestNodeId = kAnyNodeId;
+    msgInfo.MessageId = msgId;
+    msgInfo.KeyId = keyId;
+    // Multicast messages carry the destination node id, which is covered by the integrity check.
+    msgInfo.Flags = kWeaveMessageFlag_SourceNodeId | kWeaveMessageFlag_DestNodeId | kWeaveMessageFlag_ReuseMessageId;
+    msgInfo.MessageVersion = kWeaveMessageVersion_V2;
+    msgInfo.EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
+
+    err = msgLayer.EncodeMessage(&msgInfo, msgBuf, NULL, UINT16_MAX, 0);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, msgBuf->DataLength() <= sizeof(encodedMsg.Data));
+
+    encodedMsg.DataLen = msgBuf->DataLength();
+    memcpy(encodedMsg.Data, msgBuf->Start(), encodedMsg.DataLen);
+
+    PacketBuffer::Free(msgBuf);
+}
+
+// Decode every message the specified number of times, round-robin, and return the elapsed time in microseconds.
+static uint64_t DecodeAppKeyMsgs(nlTestSuite *inSuite, WeaveMessageLayer &msgLayer, const AppKeyCacheTestMsg *encodedMsgs, size_t msgCount, size_t iterations)
+{
+    WeaveMessageLayerTestObject msgLayerTestObject;
+    WeaveMessageInfo msgInfo;
+    uint8_t *payload;
+    uint16_t payloadLen;
+    uint64_t startTime;
+    size_t failures = 0;
+    uint8_t *msgStart;
+    PacketBuffer *msgBuf = PacketBuffer::New();
+
+    NL_TEST_ASSERT(inSuite, msgBuf != NULL);
+    if (msgBuf == NULL)
+        return 0;
+
+    msgStart = msgBuf->Start();
+
+    msgLayerTestObject.msgLayer = &msgLayer;
+
+    startTime = Now();
+
+    for (size_t iter = 0; iter < iterations; iter++)
+    {
+        for (size_t i = 0; i < msgCount; i++)
+        {
+            // Decoding advances the buffer start past the message header.
+            msgBuf->SetStart(msgStart);
+            memcpy(msgBuf->Start(), encodedMsgs[i].Data, encodedMsgs[i].DataLen);
+            msgBuf->SetDataLength(encodedMsgs[i].DataLen);
+
+            msgInfo.Clear();
+            if (msgLayerTestObject.DecodeMessage(msgBuf, kNodeIdNotSpecified, NULL, &msgInfo, &payload, &payloadLen) != WEAVE_NO_ERROR ||
+                payloadLen != sizeof(sMsgPayload) || memcmp(payload, sMsgPayload, payloadLen) != 0)
+            {
+                failures++;
+            }
+        }
+    }
+
+    NL_TEST_ASSERT(inSuite, failures == 0);
+
+    PacketBuffer::Free(msgBuf);
+
+    return Now() - startTime;
+}
+
+static void PrintAppKeyCacheResults(const char *phase, const WeaveFabricState &fabricState, size_t msgCount, uint64_t elapsedUS)
+{
+    const WeaveMsgEncryptionKeyCache::Stats &stats = fabricState.GetAppKeyCacheStats();
+
+    printf("%s: %u msgs in %" PRIu64 " us (%" PRIu64 " msgs/s); hits %" PRIu32 ", misses %" PRIu32 ", evictions %" PRIu32
+           ", precomputed %" PRIu32 ", precomputed hits %" PRIu32 ", precompute skipped %" PRIu32 "\n",
+           phase, (unsigned) msgCount, elapsedUS, (elapsedUS != 0) ? (static_cast<uint64_t>(msgCount) * 1000000 / elapsedUS) : 0,
+           stats.Hits, stats.Misses, stats.Evictions, stats.Precomputed, stats.PrecomputedHits, stats.PrecomputeSkipped);
+}
+
+// Set up a sender and a receiver that share the test group keys. Encoding the first message
+// with an application key starts the message counter synchronization timer, so the fabric
+// states need a message layer with a system layer.
+static void InitAppKeyCacheTestNodes(nlTestSuite *inSuite, System::Layer &systemLayer,
+                                     WeaveFabricState &senderFabricState, WeaveMessageLayer &senderMsgLayer, TestGroupKeyStore &senderKeyStore,
+                                     WeaveFabricState &receiverFabricState, WeaveMessageLayer &receiverMsgLayer, TestGroupKeyStore &receiverKeyStore)
+{
+    WEAVE_ERROR err;
+
+    err = systemLayer.Init(NULL);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = senderFabricState.Init(&senderKeyStore);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    senderFabricState.LocalNodeId = 0x18B4300000000001ULL;
+    senderFabricState.MessageLayer = &senderMsgLayer;
+    senderMsgLayer.FabricState = &senderFabricState;
+    senderMsgLayer.SystemLayer = &systemLayer;
+
+    err = receiverFabricState.Init(&receiverKeyStore);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    receiverFabricState.LocalNodeId = 0x18B4300000000002ULL;
+    receiverFabricState.MessageLayer = &receiverMsgLayer;
+    receiverMsgLayer.FabricState = &receiverFabricState;
+    receiverMsgLayer.SystemLayer = &systemLayer;
+}
+
+static void ShutdownAppKeyCacheTestNodes(System::Layer &systemLayer, WeaveFabricState &senderFabricState, WeaveFabricState &receiverFabricState)
+{
+    senderFabricState.Shutdown();
+    receiverFabricState.Shutdown();
+    systemLayer.Shutdown();
+}
+
+/**
+ * Measure multicast receive throughput for several application groups, before and after
+ * the epoch key rotation, and verify that the application key cache derives each key once.
+ */
+void WeaveMessageEncryption_AppKeyCache(nlTestSuite *inSuite, void *inContext)
+{
+    static System::Layer systemLayer;
+    static TestGroupKeyStore senderKeyStore;
+    static TestGroupKeyStore receiverKeyStore;
+    static WeaveFabricState senderFabricState;
+    static WeaveFabricState receiverFabricState;
+    static WeaveMessageLayer senderMsgLayer;
+    static WeaveMessageLayer receiverMsgLayer;
+
+    WEAVE_ERROR err;
+    uint32_t groupMasterKeyIds[WEAVE_CONFIG_MAX_APPLICATION_GROUPS];
+    uint8_t groupCount;
+    AppKeyCacheTestMsg curEpochMsgs[kAppKeyCacheTestGroupCount];
+    AppKeyCacheTestMsg nextEpochMsgs[kAppKeyCacheTestGroupCount];
+    const size_t msgCount = kAppKeyCacheTestGroupCount * kAppKeyCacheTestMsgsPerGroup;
+    uint64_t elapsedUS;
+
+    InitAppKeyCacheTestNodes(inSuite, systemLayer, senderFabricState, senderMsgLayer, senderKeyStore,
+                             receiverFabricState, receiverMsgLayer, receiverKeyStore);
+
+    err = receiverKeyStore.EnumerateGroupKeys(WeaveKeyId::kType_AppGroupMasterKey, groupMasterKeyIds, WEAVE_CONFIG_MAX_APPLICATION_GROUPS, groupCount);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, groupCount >= kAppKeyCacheTestGroupCount);
+    if (groupCount < kAppKeyCacheTestGroupCount)
+        return;
+
+    // Encode one message per group with the rotating key of the current and of the next epoch.
+    for (uint8_t i = 0; i < kAppKeyCacheTestGroupCount; i++)
+    {
+        EncodeAppKeyMsg(inSuite, senderMsgLayer,
+                        WeaveKeyId::MakeAppRotatingKeyId(WeaveKeyId::kFabricRootKey, sEpochKey0_KeyId, groupMasterKeyIds[i], false),
+                        i + 1, curEpochMsgs[i]);
+        EncodeAppKeyMsg(inSuite, senderMsgLayer,
+                        WeaveKeyId::MakeAppRotatingKeyId(WeaveKeyId::kFabricRootKey, sEpochKey1_KeyId, groupMasterKeyIds[i], false),
+                        kAppKeyCacheTestGroupCount + i + 1, nextEpochMsgs[i]);
+    }
+
+    // Receive messages from all groups. Each current epoch key is derived exactly once.
+    receiverFabricState.ResetAppKeyCacheStats();
+    elapsedUS = DecodeAppKeyMsgs(inSuite, receiverMsgLayer, curEpochMsgs, kAppKeyCacheTestGroupCount, kAppKeyCacheTestMsgsPerGroup);
+    PrintAppKeyCacheResults("Current epoch", receiverFabricState, msgCount, elapsedUS);
+
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Misses == kAppKeyCacheTestGroupCount);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Evictions == 0);
+#if WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Precomputed == kAppKeyCacheTestGroupCount);
+#endif
+
+    // Rotate to the next epoch key. Its keys were precomputed, so no derivations are needed.
+    receiverFabricState.ResetAppKeyCacheStats();
+    elapsedUS = DecodeAppKeyMsgs(inSuite, receiverMsgLayer, nextEpochMsgs, kAppKeyCacheTestGroupCount, kAppKeyCacheTestMsgsPerGroup);
+    PrintAppKeyCacheResults("Next epoch", receiverFabricState, msgCount, elapsedUS);
+
+#if WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Misses == 0);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().PrecomputedHits == kAppKeyCacheTestGroupCount);
+#else
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Misses == kAppKeyCacheTestGroupCount);
+#endif
+
+    ShutdownAppKeyCacheTestNodes(systemLayer, senderFabricState, receiverFabricState);
+}
+
+/**
+ * Measure multicast receive throughput when messages arrive round-robin with more application
+ * keys than the key cache holds, and verify the behavior of a full cache: received keys are
+ * evicted in least-recently used order and next epoch keys are not precomputed.
+ */
+void WeaveMessageEncryption_AppKeyCacheThrash(nlTestSuite *inSuite, void *inContext)
+{
+    static System::Layer systemLayer;
+    static TestGroupKeyStore senderKeyStore;
+    static TestGroupKeyStore receiverKeyStore;
+    static WeaveFabricState senderFabricState;
+    static WeaveFabricState receiverFabricState;
+    static WeaveMessageLayer senderMsgLayer;
+    static WeaveMessageLayer receiverMsgLayer;
+    static const uint32_t rootKeyIds[] = { WeaveKeyId::kFabricRootKey, WeaveKeyId::kServiceRootKey };
+
+    WEAVE_ERROR err;
+    uint32_t groupMasterKeyIds[WEAVE_CONFIG_MAX_APPLICATION_GROUPS];
+    uint8_t groupCount;
+    AppKeyCacheTestMsg msgs[kAppKeyCacheThrashTestKeyCount];
+    size_t keyCount = 0;
+    const size_t msgCount = kAppKeyCacheThrashTestKeyCount * kAppKeyCacheThrashTestIterations;
+    uint64_t elapsedUS;
+
+    // The test needs more keys than the cache can hold.
+    if (kAppKeyCacheThrashTestKeyCount <= WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS)
+        return;
+
+    InitAppKeyCacheTestNodes(inSuite, systemLayer, senderFabricState, senderMsgLayer, senderKeyStore,
+                             receiverFabricState, receiverMsgLayer, receiverKeyStore);
+
+    err = receiverKeyStore.EnumerateGroupKeys(WeaveKeyId::kType_AppGroupMasterKey, groupMasterKeyIds, WEAVE_CONFIG_MAX_APPLICATION_GROUPS, groupCount);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, groupCount >= kAppKeyCacheThrashTestGroupCount);
+    if (groupCount < kAppKeyCacheThrashTestGroupCount)
+        return;
+
+    // Encode one message with the current epoch rotating key and one with the static key of
+    // every group, under both the fabric and the service root keys.
+    for (size_t r = 0; r < sizeof(rootKeyIds) / sizeof(rootKeyIds[0]); r++)
+    {
+        for (uint8_t i = 0; i < kAppKeyCacheThrashTestGroupCount; i++)
+        {
+            EncodeAppKeyMsg(inSuite, senderMsgLayer,
+                            WeaveKeyId::MakeAppRotatingKeyId(rootKeyIds[r], sEpochKey0_KeyId, groupMasterKeyIds[i], false),
+                            keyCount + 1, msgs[keyCount]);
+            keyCount++;
+            EncodeAppKeyMsg(inSuite, senderMsgLayer,
+                            WeaveKeyId::MakeAppStaticKeyId(rootKeyIds[r], groupMasterKeyIds[i]),
+                            keyCount + 1, msgs[keyCount]);
+            keyCount++;
+        }
+    }
+
+    NL_TEST_ASSERT(inSuite, keyCount == kAppKeyCacheThrashTestKeyCount);
+
+    // With the keys used round-robin, a least-recently used cache smaller than the set of keys
+    // misses on every message.
+    receiverFabricState.ResetAppKeyCacheStats();
+    elapsedUS = DecodeAppKeyMsgs(inSuite, receiverMsgLayer, msgs, kAppKeyCacheThrashTestKeyCount, kAppKeyCacheThrashTestIterations);
+    PrintAppKeyCacheResults("Cache thrash", receiverFabricState, msgCount, elapsedUS);
+
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Hits == 0);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Misses == msgCount);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Evictions >= msgCount - WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().PrecomputedHits == 0);
+#if WEAVE_CONFIG_PRECOMPUTE_NEXT_EPOCH_MSG_ENC_APP_KEYS
+    // Next epoch keys only fill the free entries of the cold cache; once it is full they are skipped.
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Precomputed <= WEAVE_CONFIG_MAX_CACHED_MSG_ENC_APP_KEYS);
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().PrecomputeSkipped > 0);
+#else
+    NL_TEST_ASSERT(inSuite, receiverFabricState.GetAppKeyCacheStats().Precomputed == 0);
+#endif
+
+    ShutdownAppKeyCacheTestNodes(systemLayer, senderFabricState, receiverFabricState);
+}
+
+#endif // WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
+
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+// The first bytes of a V2 message, and the header of a coalesced datagram, in wire order.
+#define TEST_MSG_HEADER             0x00, 0x20
+#define TEST_COALESCED_HEADER       0x00, 0xF0
+
+static WEAVE_ERROR CheckCoalescedDatagram(const uint8_t *datagram, uint16_t datagramLen)
+{
+    PacketBuffer *buf = PacketBuffer::New();
+    WEAVE_ERROR err;
+
+    memcpy(buf->Start(), datagram, datagramLen);
+    buf->SetDataLength(datagramLen);
+
+    err = WeaveMessageLayerTestObject::CheckCoalescedDatagram(buf);
+
+    PacketBuffer::Free(buf);
+
+    return err;
+}
+
+/**
+ *  Test that the framing of received coalesced datagrams is checked before any message in them is
+ *  handled.
+ */
+static void WeaveMessageCoalescing_Parse(nlTestSuite *inSuite, void *inContext)
+{
+    static const uint8_t twoMsgs[] = { TEST_COALESCED_HEADER, 4, 0, TEST_MSG_HEADER, 1, 2, 3, 0, TEST_MSG_HEADER, 3 };
+    static const uint8_t oneMsg[] = { TEST_COALESCED_HEADER, 2, 0, TEST_MSG_HEADER };
+    static const uint8_t noMsgs[] = { TEST_COALESCED_HEADER };
+    static const uint8_t truncatedHeader[] = { 0x00 };
+    static const uint8_t truncatedLength[] = { TEST_COALESCED_HEADER, 2, 0, TEST_MSG_HEADER, 2 };
+    static const uint8_t truncatedMsg[] = { TEST_COALESCED_HEADER, 2, 0, TEST_MSG_HEADER, 2, 0, 0x00 };
+    static const uint8_t zeroLength[] = { TEST_COALESCED_HEADER, 0, 0, TEST_MSG_HEADER };
+    static const uint8_t shortLength[] = { TEST_COALESCED_HEADER, 1, 0, TEST_MSG_HEADER };
+    static const uint8_t pastEnd[] = { TEST_COALESCED_HEADER, 5, 0, TEST_MSG_HEADER, 1, 2 };
+    static const uint8_t hugeLength[] = { TEST_COALESCED_HEADER, 0xFF, 0xFF, TEST_MSG_HEADER };
+    static const uint8_t nested[] = { TEST_COALESCED_HEADER, 6, 0, TEST_COALESCED_HEADER, 2, 0, TEST_MSG_HEADER };
+    static const uint8_t nestedLast[] = { TEST_COALESCED_HEADER, 2, 0, TEST_MSG_HEADER, 2, 0, TEST_COALESCED_HEADER };
+    static const uint8_t wrongHeader[] = { 0x01, 0xF0, 2, 0, TEST_MSG_HEADER };
+    PacketBuffer *buf;
+    PacketBuffer *tail;
+
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(twoMsgs, sizeof(twoMsgs)) == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(oneMsg, sizeof(oneMsg)) == WEAVE_NO_ERROR);
+
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(noMsgs, sizeof(noMsgs)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(truncatedHeader, sizeof(truncatedHeader)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(truncatedLength, sizeof(truncatedLength)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(truncatedMsg, sizeof(truncatedMsg)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(zeroLength, sizeof(zeroLength)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(shortLength, sizeof(shortLength)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(pastEnd, sizeof(pastEnd)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(hugeLength, sizeof(hugeLength)) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(nested, sizeof(nested)) == WEAVE_ERROR_UNSUPPORTED_MESSAGE_VERSION);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(nestedLast, sizeof(nestedLast)) == WEAVE_ERROR_UNSUPPORTED_MESSAGE_VERSION);
+    NL_TEST_ASSERT(inSuite, CheckCoalescedDatagram(wrongHeader, sizeof(wrongHeader)) == WEAVE_ERROR_INVALID_MESSAGE_FLAG);
+
+    // A datagram split across a chain of buffers is rejected rather than read past the first.
+    buf = PacketBuffer::New();
+    tail = PacketBuffer::New();
+    memcpy(buf->Start(), twoMsgs, 6);
+    buf->SetDataLength(6);
+    memcpy(tail->Start(), twoMsgs + 6, sizeof(twoMsgs) - 6);
+    tail->SetDataLength(sizeof(twoMsgs) - 6);
+    buf->AddToEnd(tail);
+
+    NL_TEST_ASSERT(inSuite, WeaveMessageLayerTestObject::CheckCoalescedDatagram(buf) == WEAVE_ERROR_INVALID_MESSAGE_LENGTH);
+
+    PacketBuffer::Free(buf);
+}
+
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
 int main(int argc, char *argv[])
 {
     static const nlTest tests[] = {
         NL_TEST_DEF("WeaveMessageEncryption",           WeaveMessageEncryption_Test1),
+        NL_TEST_DEF("WeaveMessageEncryptionChainedBuffers", WeaveMessageEncryption_ChainedBuffers),
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+        NL_TEST_DEF("WeaveMessageEncryptionAES128CCM",  WeaveMessageEncryption_AES128CCM),
+        NL_TEST_DEF("WeaveMessageEncryptionThroughput", WeaveMessageEncryption_Throughput),
+#endif
+#if WEAVE_CONFIG_USE_APP_GROUP_KEYS_FOR_MSG_ENC
+        NL_TEST_DEF("WeaveMessageEncryptionAppKeyCache", WeaveMessageEncryption_AppKeyCache),
+        NL_TEST_DEF("WeaveMessageEncryptionAppKeyCacheThrash", WeaveMessageEncryption_AppKeyCacheThrash),
+#endif
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+        NL_TEST_DEF("WeaveMessageCoalescingParse",      WeaveMessageCoalescing_Parse),
+#endif
         NL_TEST_SENTINEL()
     };
 
@@ -144,6 +144,50 @@ void PASEEngineTest_MixedConfigs()
             .Run();
 }
 
+void PASEEngineTest_EncryptionTypes()
+{
+    PASEEngineTest("Legacy Initiator Legacy Responder")
+            .ProposedConfig(kPASEConfig_Config4)
+            .ResponderAllowedConfigs(kPASEConfig_Config4)
+            .LegacyResponder(true)
+            .ConfirmKey(true)
+            .Run();
+
+#if WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+    PASEEngineTest("Legacy Initiator AES128CCM Responder")
+            .ProposedConfig(kPASEConfig_Config4)
+            .ResponderAllowedConfigs(kPASEConfig_Config4)
+            .ProposedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+            .ConfirmKey(true)
+            .Run();
+
+    PASEEngineTest("AES128CCM Initiator AES128CCM Responder")
+            .ProposedConfig(kPASEConfig_Config4)
+            .ResponderAllowedConfigs(kPASEConfig_Config4)
+            .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+            .ConfirmKey(true)
+            .Run();
+
+    PASEEngineTest("AES128CCM Initiator Legacy Responder")
+            .ProposedConfig(kPASEConfig_Config4)
+            .ResponderAllowedConfigs(kPASEConfig_Config4)
+            .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+            .ExpectedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+            .LegacyResponder(true)
+            .ConfirmKey(true)
+            .Run();
+
+    PASEEngineTest("AES128CCM Initiator Legacy Responder No Confirm Key")
+            .ProposedConfig(kPASEConfig_Config4)
+            .ResponderAllowedConfigs(kPASEConfig_Config4)
+            .ProposedEncType(kWeaveEncryptionType_AES128CCM)
+            .ExpectedEncType(kWeaveEncryptionType_AES128CTRSHA1)
+            .LegacyResponder(true)
+            .ConfirmKey(false)
+            .Run();
+#endif // WEAVE_CONFIG_SUPPORT_MSG_ENC_AES128CCM
+}
+
 void PASEEngine_ExternalFuzzingEngine(const char *fuzzLocation, const uint8_t *fuzzInput, size_t fuzzInputSize)
 {
     MessageExternalFuzzer fuzzer = MessageExternalFuzzer(fuzzLocation)
@@ -175,5 +219,6 @@ int main(int argc, char *argv[])
     PASEEngine_ConfigTest1();
     PASEEngine_ConfigTest4();
     PASEEngineTest_MixedConfigs();
+    PASEEngineTest_EncryptionTypes();
     printf("All tests succeeded\n");
 }
@@ -39,6 +39,7 @@
 #include <nlunit-test.h>
 
 #include <Weave/Support/PersistedCounter.h>
+#include <Weave/Support/PersistedStorageWriteBehind.h>
 #include <Weave/Support/platform/PersistedStorage.h>
 
 #include "ToolCommon.h"
@@ -173,6 +174,109 @@ static void CheckWriteNextCounterStart(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, value == 0x20000);
 }
 
+static bool IsValueDurable(const char *aKey, uint32_t aValue)
+{
+    uint32_t storedValue;
+
+    // A crash at this point leaves only what is in storage; the counter
+    // restarts from the stored value and must not repeat aValue.
+    return nl::Weave::Platform::PersistedStorage::Read(aKey, storedValue) == WEAVE_NO_ERROR &&
+           static_cast<int32_t>(storedValue - aValue) > 0;
+}
+
+static void CheckWriteBehindCrashPoints(nlTestSuite *inSuite, void *inContext)
+{
+    TestPersistedCounterContext *context = static_cast<TestPersistedCounterContext *>(inContext);
+    nl::Weave::PersistedStorageWriteBehind &writeBehind = nl::Weave::PersistedStorageWriteBehind::GetInstance();
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    nl::Weave::PersistedCounter counter, counter2;
+    const char *testKey = "testcounter";
+    const uint32_t epoch = 0x100;
+    std::map<std::string, std::string> crashStore;
+    uint32_t value = 0;
+    uint32_t crashValue = 0;
+
+    InitializePersistedStorage(context);
+
+    // No timer; pending values are only written by explicit flushes.
+    err = writeBehind.Init(NULL, 0);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = counter.Init(testKey, epoch);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, counter.GetValue() == 0);
+    NL_TEST_ASSERT(inSuite, IsValueDurable(testKey, 0));
+
+    // Entering the second epoch is still covered by the value written at
+    // init, so the next start value is left pending.
+    for (uint32_t i = 0; i < epoch; i++)
+    {
+        err = counter.Advance();
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+    NL_TEST_ASSERT(inSuite, counter.GetValue() == epoch);
+    NL_TEST_ASSERT(inSuite, writeBehind.IsPending(testKey));
+    NL_TEST_ASSERT(inSuite, IsValueDurable(testKey, counter.GetValue()));
+
+    // Keys are matched by content, not by address.
+    {
+        char testKeyCopy[] = "testcounter";
+        NL_TEST_ASSERT(inSuite, writeBehind.IsPending(testKeyCopy));
+    }
+
+    // Vend values across several epochs, flushing at arbitrary points as
+    // the timer would, and check at every value that a crash right after
+    // vending it would not lead to its reuse.
+    for (uint32_t i = 0; i < 8 * epoch; i++)
+    {
+        err = counter.Advance();
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+        value = counter.GetValue();
+        NL_TEST_ASSERT(inSuite, IsValueDurable(testKey, value));
+
+        if (i % 0x15B == 0x15A)
+        {
+            err = writeBehind.Flush();
+            NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+        }
+
+        if (i == 5 * epoch + 1)
+        {
+            // Snapshot storage for a simulated crash while a write is pending.
+            NL_TEST_ASSERT(inSuite, writeBehind.IsPending(testKey));
+            crashStore = sPersistentStore;
+            crashValue = value;
+        }
+    }
+
+    // "Crash": drop everything written since the snapshot, including the
+    // pending value, then reboot.  Values vended after the snapshot may
+    // repeat, but the restarted counter must start beyond every value
+    // vended before it.
+    err = writeBehind.Shutdown();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    sPersistentStore = crashStore;
+
+    err = writeBehind.Init(NULL, 0);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = counter2.Init(testKey, epoch);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, counter2.GetValue() > crashValue);
+    NL_TEST_ASSERT(inSuite, IsValueDurable(testKey, counter2.GetValue()));
+
+    // A clean shutdown flushes, so a reboot after it skips no more than
+    // two epochs.
+    err = writeBehind.Shutdown();
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    err = counter.Init(testKey, epoch);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, counter.GetValue() > counter2.GetValue());
+    NL_TEST_ASSERT(inSuite, counter.GetValue() <= counter2.GetValue() + 2 * epoch);
+}
+
 // Test Suite
 
 /**
@@ -182,6 +286,7 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Out of box Test", CheckOOB),
     NL_TEST_DEF("Reboot Test", CheckReboot),
     NL_TEST_DEF("Write Next Counter Start Test", CheckWriteNextCounterStart),
+    NL_TEST_DEF("Write-Behind Crash Point Test", CheckWriteBehindCrashPoints),
 
     NL_TEST_SENTINEL()
 };
@@ -18,7 +18,9 @@
 
 /**
  *    @file
- *      Implementation of a simple std::map based persisted store.
+ *      Implementation of a simple std::map based persisted store, or, when
+ *      a store file is supplied, a file-backed store that is synced to disk
+ *      after each batch of writes.
  *
  */
 
@@ -131,7 +133,17 @@ static WEAVE_ERROR SaveCounterValueToFile(const char *aKey, uint32_t aValue)
     VerifyOrExit(res != EOF, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
 
 exit:
-    fflush(sPersistentStoreFile);
+    return err;
+}
+
+static WEAVE_ERROR SyncFile(void)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    VerifyOrExit(fflush(sPersistentStoreFile) == 0, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+    VerifyOrExit(fsync(fileno(sPersistentStoreFile)) == 0, err = WEAVE_ERROR_PERSISTED_STORAGE_FAIL);
+
+exit:
     return err;
 }
 
@@ -161,32 +173,53 @@ exit:
     return err;
 }
 
-WEAVE_ERROR Write(const char *aKey, uint32_t aValue)
+// Defined whether or not WEAVE_CONFIG_PERSISTED_STORAGE_SUPPORT_WRITE_MULTIPLE
+// is set, so that the file-backed store pays for a single sync per batch.
+WEAVE_ERROR WriteMultiple(const char * const *aKeys, const uint32_t *aValues, size_t aCount)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
 
-    VerifyOrExit(aKey != NULL, err = WEAVE_ERROR_INVALID_ARGUMENT);
-    VerifyOrExit(strlen(aKey) <= WEAVE_CONFIG_PERSISTED_STORAGE_MAX_KEY_LENGTH,
-                 err = WEAVE_ERROR_INVALID_STRING_LENGTH);
-
-    if (sPersistentStoreFile)
+    for (size_t i = 0; i < aCount; i++)
     {
-        err = SaveCounterValueToFile(aKey, aValue);
+        VerifyOrExit(aKeys[i] != NULL, err = WEAVE_ERROR_INVALID_ARGUMENT);
+        VerifyOrExit(strlen(aKeys[i]) <= WEAVE_CONFIG_PERSISTED_STORAGE_MAX_KEY_LENGTH,
+                     err = WEAVE_ERROR_INVALID_STRING_LENGTH);
     }
-    else
+
+    for (size_t i = 0; i < aCount; i++)
     {
-        char encodedValue[BASE64_ENCODED_LEN(sizeof(uint32_t)) + 1];
+        if (sPersistentStoreFile)
+        {
+            err = SaveCounterValueToFile(aKeys[i], aValues[i]);
+            SuccessOrExit(err);
+        }
+        else
+        {
+            char encodedValue[BASE64_ENCODED_LEN(sizeof(uint32_t)) + 1];
 
-        memset(encodedValue, 0, sizeof(encodedValue));
-        Base64Encode((uint8_t *)&aValue, sizeof(aValue), encodedValue);
+            memset(encodedValue, 0, sizeof(encodedValue));
+            Base64Encode((const uint8_t *)&aValues[i], sizeof(aValues[i]), encodedValue);
 
-        sPersistentStore[aKey] = encodedValue;
+            sPersistentStore[aKeys[i]] = encodedValue;
+        }
     }
 
 exit:
+    if (sPersistentStoreFile)
+    {
+        WEAVE_ERROR syncErr = SyncFile();
+
+        if (err == WEAVE_NO_ERROR)
+            err = syncErr;
+    }
     return err;
 }
 
+WEAVE_ERROR Write(const char *aKey, uint32_t aValue)
+{
+    return WriteMultiple(&aKey, &aValue, 1);
+}
+
 } // PersistentStorage
 } // Platform
 } // Weave
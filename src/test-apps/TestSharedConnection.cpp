@@ -0,0 +1,526 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file tests the sharing of TCP connections, and the sessions
+ *      established over them, between Bindings to the same peer.
+ *
+ */
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ToolCommon.h"
+#include <nlunit-test.h>
+
+#if INET_CONFIG_ENABLE_IPV4 && WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0
+
+using namespace nl::Inet;
+
+#define TOOL_NAME "TestSharedConnection"
+#define TEST_DURATION_MILLISECS                       (10000)
+#define TEST_SETTLE_MILLISECS                         (200)
+#define TEST_SESSION_ESTABLISH_TIMEOUT_MILLISECS      (500)
+#define TEST_MAX_ACCEPTED_CONNECTIONS                 (4)
+#define TEST_BINDING_COUNT                            (3)
+
+// Nodes for which test certificates exist, so that CASE sessions get as far as waiting for the peer.
+#define TEST_LOCAL_NODE_ID                            (0x18B4300000000001ULL)
+#define TEST_PEER_NODE_ID                             (0x18B4300000000002ULL)
+
+// A loopback address on which nothing listens, so connection attempts to it are refused.
+#define TEST_REFUSED_ADDR                             "127.0.0.2"
+
+#define TEST_LISTEN_ADDR                              "127.0.0.1"
+#define TEST_LISTEN_PORT                              (11098)
+
+struct BindingTestContext
+{
+    Binding * binding;
+    bool ready;
+    bool failed;
+    WEAVE_ERROR err;
+};
+
+static TCPEndPoint * sListenEndPoint = NULL;
+static TCPEndPoint * sAcceptedEndPoints[TEST_MAX_ACCEPTED_CONNECTIONS];
+static int sNumAccepted = 0;
+static int sNumPeerClosed = 0;
+static int sNumPending = 0;
+
+static void StartListening(nlTestSuite * testSuite);
+static void StopListening(void);
+static void PrepareBinding(nlTestSuite * testSuite, BindingTestContext & context, const char * peerAddrStr, bool useCASE);
+static void CloseBinding(BindingTestContext & context);
+static void HandleBindingEvent(void * appState, Binding::EventType event, const Binding::InEventParam & inParam,
+                               Binding::OutEventParam & outParam);
+static void HandleConnectionReceived(TCPEndPoint * listeningEndPoint, TCPEndPoint * conEndPoint, const IPAddress & peerAddr,
+                                     uint16_t peerPort);
+static void HandleDataReceived(TCPEndPoint * endPoint, PacketBuffer * data);
+static void HandlePeerClose(TCPEndPoint * endPoint);
+static void ServiceNetworkUntilDone(uint32_t timeoutMS);
+static void ServiceNetworkFor(uint32_t durationMS);
+
+/**
+ *  Test that bindings prepared together to the same peer join one connection, that the connection
+ *  stays open while any of them uses it, and that CloseIdleSharedConnections() closes it once none
+ *  does.
+ */
+static void TestSharedConnection_Join(nlTestSuite * testSuite, void * testContext)
+{
+    BindingTestContext contexts[TEST_BINDING_COUNT];
+    BindingTestContext rejoin;
+    WeaveConnection * con;
+
+    StartListening(testSuite);
+
+    for (int i = 0; i < TEST_BINDING_COUNT; i++)
+        PrepareBinding(testSuite, contexts[i], TEST_LISTEN_ADDR, false);
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    for (int i = 0; i < TEST_BINDING_COUNT; i++)
+        NL_TEST_ASSERT(testSuite, contexts[i].ready);
+
+    con = contexts[0].binding->GetConnection();
+    NL_TEST_ASSERT(testSuite, con != NULL);
+    for (int i = 1; i < TEST_BINDING_COUNT; i++)
+        NL_TEST_ASSERT(testSuite, contexts[i].binding->GetConnection() == con);
+
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+    NL_TEST_ASSERT(testSuite, sNumAccepted == 1);
+
+    // The connection stays open while any binding uses it, even when asked to close idle ones.
+    CloseBinding(contexts[0]);
+    CloseBinding(contexts[1]);
+    ExchangeMgr.CloseIdleSharedConnections();
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, sNumPeerClosed == 0);
+    NL_TEST_ASSERT(testSuite, contexts[2].binding->IsReady());
+    NL_TEST_ASSERT(testSuite, con->State == WeaveConnection::kState_Connected);
+
+    // Once the last binding has gone, the connection is kept idle, and a new binding reuses it.
+    CloseBinding(contexts[2]);
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+    NL_TEST_ASSERT(testSuite, sNumPeerClosed == 0);
+
+    PrepareBinding(testSuite, rejoin, TEST_LISTEN_ADDR, false);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, rejoin.ready);
+    NL_TEST_ASSERT(testSuite, rejoin.binding->GetConnection() == con);
+    NL_TEST_ASSERT(testSuite, sNumAccepted == 1);
+
+    CloseBinding(rejoin);
+
+    ExchangeMgr.CloseIdleSharedConnections();
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+    NL_TEST_ASSERT(testSuite, sNumPeerClosed == 1);
+
+    StopListening();
+}
+
+/**
+ *  Test that an idle shared connection is closed after the idle timeout.
+ */
+static void TestSharedConnection_IdleTimeout(nlTestSuite * testSuite, void * testContext)
+{
+    BindingTestContext context;
+
+    StartListening(testSuite);
+
+    PrepareBinding(testSuite, context, TEST_LISTEN_ADDR, false);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+    NL_TEST_ASSERT(testSuite, context.ready);
+
+    CloseBinding(context);
+
+    ServiceNetworkFor(WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT / 2);
+    NL_TEST_ASSERT(testSuite, sNumPeerClosed == 0);
+
+    ServiceNetworkFor(WEAVE_CONFIG_SHARED_CONNECTION_IDLE_TIMEOUT / 2 + TEST_SETTLE_MILLISECS);
+    NL_TEST_ASSERT(testSuite, sNumAccepted == 1);
+    NL_TEST_ASSERT(testSuite, sNumPeerClosed == 1);
+
+    StopListening();
+}
+
+/**
+ *  Test that a binding waiting for a shared connection establishes one of its own when the binding
+ *  establishing the connection is closed before the connection is ready.
+ */
+static void TestSharedConnection_EstablisherClosed(nlTestSuite * testSuite, void * testContext)
+{
+    BindingTestContext establisher;
+    BindingTestContext waiter;
+
+    StartListening(testSuite);
+
+    PrepareBinding(testSuite, establisher, TEST_LISTEN_ADDR, false);
+    PrepareBinding(testSuite, waiter, TEST_LISTEN_ADDR, false);
+
+    CloseBinding(establisher);
+    sNumPending = 1;
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, waiter.ready);
+    NL_TEST_ASSERT(testSuite, waiter.binding->GetConnection() != NULL);
+
+    CloseBinding(waiter);
+    ExchangeMgr.CloseIdleSharedConnections();
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+
+    StopListening();
+}
+
+/**
+ *  Test that, when the shared connection cannot be established, every binding waiting for it fails
+ *  in turn rather than waiting forever.
+ */
+static void TestSharedConnection_ConnectionFailed(nlTestSuite * testSuite, void * testContext)
+{
+    BindingTestContext contexts[TEST_BINDING_COUNT];
+    BindingTestContext context;
+
+    StartListening(testSuite);
+
+    for (int i = 0; i < TEST_BINDING_COUNT; i++)
+        PrepareBinding(testSuite, contexts[i], TEST_REFUSED_ADDR, false);
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    for (int i = 0; i < TEST_BINDING_COUNT; i++)
+    {
+        NL_TEST_ASSERT(testSuite, contexts[i].failed);
+        NL_TEST_ASSERT(testSuite, contexts[i].err != WEAVE_NO_ERROR);
+        CloseBinding(contexts[i]);
+    }
+
+    // A working peer can still be reached afterwards.
+    PrepareBinding(testSuite, context, TEST_LISTEN_ADDR, false);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+    NL_TEST_ASSERT(testSuite, context.ready);
+
+    CloseBinding(context);
+    ExchangeMgr.CloseIdleSharedConnections();
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+
+    StopListening();
+}
+
+/**
+ *  Test that, when the session cannot be established over the shared connection, the waiting
+ *  binding retries over a new connection, and that the failed connection is not reused.
+ */
+static void TestSharedConnection_KeyEstablishmentFailed(nlTestSuite * testSuite, void * testContext)
+{
+    BindingTestContext establisher;
+    BindingTestContext waiter;
+    uint32_t savedTimeout = SecurityMgr.SessionEstablishTimeout;
+    uint64_t savedNodeId = FabricState.LocalNodeId;
+
+    // The listener accepts connections but never answers, so every CASE session times out.
+    SecurityMgr.SessionEstablishTimeout = TEST_SESSION_ESTABLISH_TIMEOUT_MILLISECS;
+    FabricState.LocalNodeId = TEST_LOCAL_NODE_ID;
+
+    StartListening(testSuite);
+
+    PrepareBinding(testSuite, establisher, TEST_LISTEN_ADDR, true);
+    PrepareBinding(testSuite, waiter, TEST_LISTEN_ADDR, true);
+
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, establisher.failed);
+    NL_TEST_ASSERT(testSuite, establisher.err == WEAVE_ERROR_TIMEOUT);
+    NL_TEST_ASSERT(testSuite, waiter.failed);
+    NL_TEST_ASSERT(testSuite, waiter.err == WEAVE_ERROR_TIMEOUT);
+    NL_TEST_ASSERT(testSuite, sNumAccepted == 2);
+
+    CloseBinding(establisher);
+    CloseBinding(waiter);
+
+    // Neither failed connection is offered to a later binding.
+    PrepareBinding(testSuite, establisher, TEST_LISTEN_ADDR, true);
+    ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+
+    NL_TEST_ASSERT(testSuite, establisher.failed);
+    NL_TEST_ASSERT(testSuite, sNumAccepted == 3);
+
+    CloseBinding(establisher);
+    ServiceNetworkFor(TEST_SETTLE_MILLISECS);
+
+    StopListening();
+
+    SecurityMgr.SessionEstablishTimeout = savedTimeout;
+    FabricState.LocalNodeId = savedNodeId;
+}
+
+static void StartListening(nlTestSuite * testSuite)
+{
+    IPAddress listenAddr;
+    INET_ERROR err;
+
+    IPAddress::FromString(TEST_LISTEN_ADDR, listenAddr);
+
+    err = Inet.NewTCPEndPoint(&sListenEndPoint);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    err = sListenEndPoint->Bind(kIPAddressType_IPv4, listenAddr, TEST_LISTEN_PORT, true);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    sListenEndPoint->OnConnectionReceived = HandleConnectionReceived;
+    err = sListenEndPoint->Listen(1);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    memset(sAcceptedEndPoints, 0, sizeof(sAcceptedEndPoints));
+    sNumAccepted = 0;
+    sNumPeerClosed = 0;
+}
+
+static void StopListening(void)
+{
+    for (int i = 0; i < TEST_MAX_ACCEPTED_CONNECTIONS; i++)
+        if (sAcceptedEndPoints[i] != NULL)
+        {
+            sAcceptedEndPoints[i]->Abort();
+            sAcceptedEndPoints[i]->Free();
+            sAcceptedEndPoints[i] = NULL;
+        }
+
+    if (sListenEndPoint != NULL)
+    {
+        sListenEndPoint->Free();
+        sListenEndPoint = NULL;
+    }
+}
+
+static void PrepareBinding(nlTestSuite * testSuite, BindingTestContext & context, const char * peerAddrStr, bool useCASE)
+{
+    IPAddress peerAddr;
+    WEAVE_ERROR err;
+
+    IPAddress::FromString(peerAddrStr, peerAddr);
+
+    context.ready  = false;
+    context.failed = false;
+    context.err    = WEAVE_NO_ERROR;
+
+    context.binding = ExchangeMgr.NewBinding(HandleBindingEvent, &context);
+    NL_TEST_ASSERT(testSuite, context.binding != NULL);
+    if (context.binding == NULL)
+        return;
+
+    Binding::Configuration bindingConfig = context.binding->BeginConfiguration()
+        .Target_NodeId(TEST_PEER_NODE_ID)
+        .TargetAddress_IP(peerAddr, TEST_LISTEN_PORT)
+        .Transport_SharedTCP();
+
+    if (useCASE)
+        bindingConfig.Security_CASESession();
+    else
+        bindingConfig.Security_None();
+
+    sNumPending++;
+    Done = false;
+
+    err = bindingConfig.PrepareBinding();
+    NL_TEST_ASSERT(testSuite, err == WEAVE_NO_ERROR);
+}
+
+static void CloseBinding(BindingTestContext & context)
+{
+    if (context.binding != NULL)
+    {
+        context.binding->Close();
+        context.binding = NULL;
+    }
+}
+
+static void HandleBindingEvent(void * appState, Binding::EventType event, const Binding::InEventParam & inParam,
+                               Binding::OutEventParam & outParam)
+{
+    BindingTestContext * context = static_cast<BindingTestContext *>(appState);
+
+    switch (event)
+    {
+    case Binding::kEvent_BindingReady:
+        context->ready = true;
+        break;
+    case Binding::kEvent_PrepareFailed:
+        context->failed = true;
+        context->err    = inParam.PrepareFailed.Reason;
+        break;
+    case Binding::kEvent_BindingFailed:
+        context->failed = true;
+        context->err    = inParam.BindingFailed.Reason;
+        break;
+    default:
+        Binding::DefaultEventHandler(appState, event, inParam, outParam);
+        return;
+    }
+
+    if (--sNumPending <= 0)
+        Done = true;
+}
+
+static void HandleConnectionReceived(TCPEndPoint * listeningEndPoint, TCPEndPoint * conEndPoint, const IPAddress & peerAddr,
+                                     uint16_t peerPort)
+{
+    sNumAccepted++;
+
+    conEndPoint->OnDataReceived = HandleDataReceived;
+    conEndPoint->OnPeerClose    = HandlePeerClose;
+
+    for (int i = 0; i < TEST_MAX_ACCEPTED_CONNECTIONS; i++)
+        if (sAcceptedEndPoints[i] == NULL)
+        {
+            sAcceptedEndPoints[i] = conEndPoint;
+            return;
+        }
+
+    conEndPoint->Free();
+}
+
+static void HandleDataReceived(TCPEndPoint * endPoint, PacketBuffer * data)
+{
+    // Never answer, so that any session establishment over the connection times out.
+    PacketBuffer::Free(data);
+}
+
+static void HandlePeerClose(TCPEndPoint * endPoint)
+{
+    sNumPeerClosed++;
+}
+
+static void ServiceNetworkUntilDone(uint32_t timeoutMS)
+{
+    uint64_t timeoutTimeMS = System::Layer::GetClock_MonotonicMS() + timeoutMS;
+    struct timeval sleepTime;
+    sleepTime.tv_sec = 0;
+    sleepTime.tv_usec = 10000;
+
+    while (!Done)
+    {
+        ServiceNetwork(sleepTime);
+
+        if (System::Layer::GetClock_MonotonicMS() >= timeoutTimeMS)
+        {
+            break;
+        }
+    }
+
+    sNumPending = 0;
+}
+
+static void ServiceNetworkFor(uint32_t durationMS)
+{
+    uint64_t endTimeMS = System::Layer::GetClock_MonotonicMS() + durationMS;
+    struct timeval sleepTime;
+    sleepTime.tv_sec = 0;
+    sleepTime.tv_usec = 10000;
+
+    while (System::Layer::GetClock_MonotonicMS() < endTimeMS)
+    {
+        ServiceNetwork(sleepTime);
+    }
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gNetworkOptions,
+    &gWeaveNodeOptions,
+    &gCASEOptions,
+    &gFaultInjectionOptions,
+    &gHelpOptions,
+    NULL
+};
+
+int main(int argc, char *argv[])
+{
+    const nlTest SharedConnectionTests[] = {
+        NL_TEST_DEF("TestSharedConnection:Join",                    TestSharedConnection_Join),
+        NL_TEST_DEF("TestSharedConnection:IdleTimeout",             TestSharedConnection_IdleTimeout),
+        NL_TEST_DEF("TestSharedConnection:EstablisherClosed",       TestSharedConnection_EstablisherClosed),
+        NL_TEST_DEF("TestSharedConnection:ConnectionFailed",        TestSharedConnection_ConnectionFailed),
+        NL_TEST_DEF("TestSharedConnection:KeyEstablishmentFailed",  TestSharedConnection_KeyEstablishmentFailed),
+        NL_TEST_SENTINEL()
+    };
+
+    nlTestSuite SharedConnectionTestSuite = {
+        "SharedConnection",
+        &SharedConnectionTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    InitToolCommon();
+
+    SetupFaultInjectionContext(argc, argv);
+
+    if (!ParseArgsFromEnvVar(TOOL_NAME, TOOL_OPTIONS_ENV_VAR_NAME, gToolOptionSets, NULL, true) ||
+        !ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets, NULL))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    InitSystemLayer();
+
+    InitNetwork();
+
+    InitWeaveStack(false, true);
+
+    // Connection sharing is off unless enabled.
+    ExchangeMgr.SetConnectionSharingEnabled(true);
+
+    // Run all tests in Suite
+
+    nlTestRunner(&SharedConnectionTestSuite, NULL);
+
+    ShutdownWeaveStack();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    return nlTestRunnerStats(&SharedConnectionTestSuite);
+}
+
+#else // !(INET_CONFIG_ENABLE_IPV4 && WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0)
+
+int main(int argc, char *argv[])
+{
+    return 0;
+}
+
+#endif // !(INET_CONFIG_ENABLE_IPV4 && WEAVE_CONFIG_MAX_SHARED_CONNECTIONS > 0)
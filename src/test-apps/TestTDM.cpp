@@ -38,6 +38,7 @@
 
 #include <Weave/Profiles/data-management/Current/WdmManagedNamespace.h>
 #include <Weave/Profiles/data-management/DataManagement.h>
+#include <Weave/Profiles/data-management/Current/GenericTraitCatalogImpl.h>
 
 #include <nest/test/trait/TestHTrait.h>
 #include <nest/test/trait/TestCTrait.h>
@@ -116,6 +117,8 @@ SubscriptionEngine * SubscriptionEngine::GetInstance()
 
 static void CheckDataSourceEmptySchema(nlTestSuite *inSuite, void *inContext);
 static void CheckDataSinkEmptySchema(nlTestSuite *inSuite, void *inContext);
+static void CheckGenericTraitCatalogLookup(nlTestSuite *inSuite, void *inContext);
+static void CheckGenericTraitCatalogIngestRate(nlTestSuite *inSuite, void *inContext);
 
 static void TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite, void *inContext);
 static void TestTdmStatic_SingleLevelMerge(nlTestSuite *inSuite, void *inContext);
@@ -161,7 +164,11 @@ static void TestTdmDictionary_DeleteEntryTwice(nlTestSuite *inSuite, void *inCon
 static void TestRandomizedDataVersions(nlTestSuite *inSuite, void *inContext);
 
 static void TestTdmStatic_MultiInstance(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_ManySubscribers(nlTestSuite *inSuite, void *inContext);
+static void TestTdmStatic_UndeliveredNotify(nlTestSuite *inSuite, void *inContext);
+static void CheckNotificationEngineReadyQueue(nlTestSuite *inSuite, void *inContext);
 static void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite, void *inContext);
+static void CheckNotifyRequestIngestRate(nlTestSuite *inSuite, void *inContext);
 static void CheckSynchronizedTraitState(nlTestSuite *inSuite, void *inContext);
 
 // Test Suite
@@ -173,6 +180,10 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Test TraitDataSource + schema with no properties",  CheckDataSourceEmptySchema),
     NL_TEST_DEF("Test TraitDataSink + schema with no properties",    CheckDataSinkEmptySchema),
 
+    // Tests the path and instance indexes of the generic trait catalog
+    NL_TEST_DEF("Test GenericTraitCatalog: Indexed lookup",          CheckGenericTraitCatalogLookup),
+    NL_TEST_DEF("Test GenericTraitCatalog: Path lookup rate",        CheckGenericTraitCatalogIngestRate),
+
     // Tests the static schema portions of TDM
     NL_TEST_DEF("Test Tdm (Static schema): Single leaf handle", TestTdmStatic_SingleLeafHandle),
 
@@ -224,11 +235,17 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("Test Tdm (Randomized Data Versions): Randomized Data Versions", TestRandomizedDataVersions),
 
     NL_TEST_DEF("Test Tdm (Multi Instance): Multi Instance", TestTdmStatic_MultiInstance),
+    NL_TEST_DEF("Test Tdm (Multi Subscriber): Lagging subscriber with many up-to-date subscribers", TestTdmStatic_ManySubscribers),
+    NL_TEST_DEF("Test Tdm (Multi Subscriber): Changes in an undelivered notify are sent again", TestTdmStatic_UndeliveredNotify),
+    NL_TEST_DEF("Test Tdm (Multi Subscriber): Notification engine only runs ready subscribers", CheckNotificationEngineReadyQueue),
 
     // Tests the allocation of buffer for building and sending Notifies and
     // Updates.
     NL_TEST_DEF("Test Allocate Right Sized Buffer", CheckAllocateRightSizedBufferForNotifications),
 
+    // Measures NotifyRequest ingest into a GenericTraitCatalog of increasing size.
+    NL_TEST_DEF("Test NotifyRequest ingest rate", CheckNotifyRequestIngestRate),
+
     // Test command + data synchronizer
     NL_TEST_DEF("Test Command + State Synchronization Logic", CheckSynchronizedTraitState),
 
@@ -391,6 +408,230 @@ exit:
     return;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Testing GenericTraitCatalogImpl
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const TraitSchemaEngine gCatalogTestTraitSchema = {
+    {
+        0xF00D,
+        gEmptyPropertyMap,
+        sizeof(gEmptyPropertyMap) / sizeof(gEmptyPropertyMap[0]),
+        1,
+#if (TDM_EXTENSION_SUPPORT) || (TDM_VERSIONING_SUPPORT)
+        2,
+#endif
+#if (TDM_DICTIONARY_SUPPORT)
+        NULL,
+#endif
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+#if (TDM_EXTENSION_SUPPORT)
+        NULL,
+#endif
+#if (TDM_VERSIONING_SUPPORT)
+        NULL,
+#endif
+    }
+};
+
+// Spread the catalog entries across resources and instances, the way a gateway proxying many devices would.
+static ResourceIdentifier CatalogTestResource(uint32_t aIndex)
+{
+    return ResourceIdentifier(Schema::Weave::Common::RESOURCE_TYPE_DEVICE, 0x18B4300000000000ULL + (aIndex / 8));
+}
+
+static uint64_t CatalogTestInstance(uint32_t aIndex)
+{
+    return aIndex % 8;
+}
+
+static void CheckGenericTraitCatalogLookup(nlTestSuite *inSuite, void *inContext)
+{
+    enum
+    {
+        kNumSinks = 200
+    };
+
+    WEAVE_ERROR err;
+    GenericTraitSinkCatalog catalog;
+    TestEmptyDataSink * sinks[kNumSinks];
+    TraitDataHandle handles[kNumSinks];
+    TraitDataHandle handle;
+    TraitDataSink * sink;
+
+    for (uint32_t i = 0; i < kNumSinks; i++)
+    {
+        sinks[i] = new TestEmptyDataSink(&gCatalogTestTraitSchema);
+        err = catalog.Add(CatalogTestResource(i), CatalogTestInstance(i), kRootPropertyPathHandle, sinks[i], handles[i]);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    NL_TEST_ASSERT(inSuite, catalog.Size() == kNumSinks);
+
+    // A second instance on an existing path is rejected.
+    {
+        TestEmptyDataSink duplicate(&gCatalogTestTraitSchema);
+        err = catalog.Add(CatalogTestResource(7), CatalogTestInstance(7), kRootPropertyPathHandle, &duplicate, handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_DUPLICATE_KEY_ID);
+    }
+
+    for (uint32_t i = 0; i < kNumSinks; i++)
+    {
+        err = catalog.Locate(0xF00D, CatalogTestInstance(i), CatalogTestResource(i), handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+
+        err = catalog.Locate(0xF00D, CatalogTestInstance(i), CatalogTestResource(i), &sink);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && sink == sinks[i]);
+
+        err = catalog.Locate(sinks[i], handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+    }
+
+    // Paths that differ from a cataloged one in a single component are not found.
+    err = catalog.Locate(0xF00E, CatalogTestInstance(0), CatalogTestResource(0), handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_PROFILE_ID);
+    err = catalog.Locate(0xF00D, 8, CatalogTestResource(0), handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_PROFILE_ID);
+    err = catalog.Locate(0xF00D, CatalogTestInstance(0), CatalogTestResource(kNumSinks), handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_PROFILE_ID);
+
+    // Remove every third entry, by handle and by instance alternately, and check the indexes follow.
+    for (uint32_t i = 0; i < kNumSinks; i += 3)
+    {
+        err = (i % 2) ? catalog.Remove(handles[i]) : catalog.Remove(sinks[i]);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    }
+
+    for (uint32_t i = 0; i < kNumSinks; i++)
+    {
+        bool removed = (i % 3) == 0;
+
+        err = catalog.Locate(0xF00D, CatalogTestInstance(i), CatalogTestResource(i), handle);
+        NL_TEST_ASSERT(inSuite, removed ? (err == WEAVE_ERROR_INVALID_PROFILE_ID) : (err == WEAVE_NO_ERROR && handle == handles[i]));
+
+        err = catalog.Locate(sinks[i], handle);
+        NL_TEST_ASSERT(inSuite, removed ? (err == WEAVE_ERROR_INVALID_ARGUMENT) : (err == WEAVE_NO_ERROR && handle == handles[i]));
+    }
+
+    // Re-adding the removed entries makes them visible again under recycled handles.
+    for (uint32_t i = 0; i < kNumSinks; i += 3)
+    {
+        err = catalog.Add(CatalogTestResource(i), CatalogTestInstance(i), kRootPropertyPathHandle, sinks[i], handles[i]);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+        err = catalog.Locate(sinks[i], handle);
+        NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handle == handles[i]);
+    }
+
+    // An instance cataloged under two paths stays locatable until both are removed.
+    err = catalog.Add(CatalogTestResource(kNumSinks), 0, kRootPropertyPathHandle, sinks[0], handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = catalog.Remove(handles[0]);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = catalog.Locate(sinks[0], handles[0]);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR && handles[0] == handle);
+    err = catalog.Remove(sinks[0]);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    err = catalog.Locate(sinks[0], handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    catalog.Clear();
+    NL_TEST_ASSERT(inSuite, catalog.Size() == 0);
+
+    err = catalog.Locate(sinks[1], handle);
+    NL_TEST_ASSERT(inSuite, err == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    for (uint32_t i = 0; i < kNumSinks; i++)
+    {
+        delete sinks[i];
+    }
+}
+
+static void CheckGenericTraitCatalogIngestRate(nlTestSuite *inSuite, void *inContext)
+{
+    // Measure the rate at which DataElement paths can be mapped to trait handles, which bounds the rate at which
+    // NotifyRequests can be ingested, for increasingly large catalogs.
+    static const uint32_t kCatalogSizes[] = { 16, 256, 4096 };
+    enum
+    {
+        kNumLookups = 100000
+    };
+
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    for (size_t s = 0; s < sizeof(kCatalogSizes) / sizeof(kCatalogSizes[0]); s++)
+    {
+        const uint32_t numSinks = kCatalogSizes[s];
+        GenericTraitSinkCatalog catalog;
+        TestEmptyDataSink ** sinks = new TestEmptyDataSink *[numSinks];
+        uint8_t * pathBuf = new uint8_t[numSinks * 64];
+        uint32_t * pathLens = new uint32_t[numSinks];
+        uint64_t startTime, elapsedUS;
+
+        // Build the catalog, then encode the path of every entry as it would appear in a DataElement.
+        for (uint32_t i = 0; i < numSinks; i++)
+        {
+            TraitDataHandle handle;
+            SchemaVersionRange versionRange;
+            TLVWriter writer;
+            TLVType pathContainer;
+
+            sinks[i] = new TestEmptyDataSink(&gCatalogTestTraitSchema);
+            err = catalog.Add(CatalogTestResource(i), CatalogTestInstance(i), kRootPropertyPathHandle, sinks[i], handle);
+            SuccessOrExit(err);
+
+            writer.Init(pathBuf + i * 64, 64);
+            err = writer.StartContainer(AnonymousTag, kTLVType_Path, pathContainer);
+            SuccessOrExit(err);
+            err = catalog.HandleToAddress(handle, writer, versionRange);
+            SuccessOrExit(err);
+            err = writer.EndContainer(pathContainer);
+            SuccessOrExit(err);
+            err = writer.Finalize();
+            SuccessOrExit(err);
+            pathLens[i] = writer.GetLengthWritten();
+        }
+
+        startTime = Now();
+
+        for (uint32_t n = 0; n < kNumLookups; n++)
+        {
+            uint32_t i = (n * 7919) % numSinks;
+            TraitDataHandle handle;
+            SchemaVersionRange versionRange;
+            TLVReader reader;
+
+            reader.Init(pathBuf + i * 64, pathLens[i]);
+            err = reader.Next();
+            SuccessOrExit(err);
+            err = catalog.AddressToHandle(reader, handle, versionRange);
+            SuccessOrExit(err);
+        }
+
+        elapsedUS = Now() - startTime;
+
+        printf("Catalog size %5u: %u paths in %u us (%u paths/sec)\n", numSinks, kNumLookups, (uint32_t) elapsedUS,
+               (uint32_t) ((elapsedUS > 0) ? (kNumLookups * 1000000ULL) / elapsedUS : 0));
+
+        catalog.Clear();
+        for (uint32_t i = 0; i < numSinks; i++)
+        {
+            delete sinks[i];
+        }
+        delete[] sinks;
+        delete[] pathBuf;
+        delete[] pathLens;
+    }
+
+exit:
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // Testing NotificationEngine + TraitData
@@ -694,6 +935,8 @@ public:
     int Teardown();
     int Reset();
     int BuildAndProcessNotify();
+    int BuildAndProcessNotify(SubscriptionHandler *aSubHandler, bool aNotifyDelivered = true);
+    WEAVE_ERROR NewSubscriptionHandler(TraitDataHandle aTraitDataHandle, SubscriptionHandler *&aSubHandler);
 
     void TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite);
     void TestTdmStatic_SingleLevelMerge(nlTestSuite *inSuite);
@@ -740,9 +983,14 @@ public:
     void TestRandomizedDataVersions(nlTestSuite *inSuite);
 
     void TestTdmStatic_MultiInstance(nlTestSuite *inSuite);
+    void TestTdmStatic_ManySubscribers(nlTestSuite *inSuite);
+    void TestTdmStatic_UndeliveredNotify(nlTestSuite *inSuite);
+    void CheckNotificationEngineReadyQueue(nlTestSuite *inSuite);
 
     void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite);
 
+    void CheckNotifyRequestIngestRate(nlTestSuite *inSuite);
+
     void CheckSynchronizedTraitState(nlTestSuite *inSuite);
 
 private:
@@ -796,6 +1044,11 @@ int TestTdm::Setup()
 
     gSubscriptionEngine = &mSubscriptionEngine;
 
+    // Terminating a subscription handler cancels its timer through the exchange manager's message layer.
+    InitSystemLayer();
+    InitNetwork();
+    InitWeaveStack(false, true);
+
     // Initialize SubEngine and set it up
     err = mSubscriptionEngine.Init(&ExchangeMgr, NULL, NULL);
     SuccessOrExit(err);
@@ -807,6 +1060,8 @@ int TestTdm::Setup()
     err = mSubscriptionEngine.NewSubscriptionHandler(&mSubHandler);
     SuccessOrExit(err);
 
+    // Hold the reference that an incoming subscription would, so that NotificationEngine::Run() does not free the handler.
+    mSubHandler->_AddRef();
     mSubHandler->mBinding = ExchangeMgr.NewBinding();
     mSubHandler->mBinding->BeginConfiguration().Transport_UDP();
 
@@ -907,7 +1162,53 @@ int TestTdm::Reset()
     return err;
 }
 
+/**
+ * Allocate a subscription handler, outside of the one used by most tests, that is subscribed to a single trait instance and is in
+ * the established idle state. The handler is released with AbortSubscription().
+ */
+WEAVE_ERROR TestTdm::NewSubscriptionHandler(TraitDataHandle aTraitDataHandle, SubscriptionHandler *&aSubHandler)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    SubscriptionHandler::TraitInstanceInfo *traitInstance;
+
+    VerifyOrExit(mSubscriptionEngine.mNumTraitInfosInPool < SubscriptionEngine::kMaxNumPathGroups, err = WEAVE_ERROR_NO_MEMORY);
+
+    err = mSubscriptionEngine.NewSubscriptionHandler(&aSubHandler);
+    SuccessOrExit(err);
+
+    // Hold the reference that an incoming subscription would, so that AbortSubscription() frees the handler.
+    aSubHandler->_AddRef();
+    aSubHandler->mBinding = ExchangeMgr.NewBinding();
+    if (aSubHandler->mBinding == NULL)
+    {
+        aSubHandler->_Release();
+        aSubHandler = NULL;
+        ExitNow(err = WEAVE_ERROR_NO_MEMORY);
+    }
+    aSubHandler->mBinding->BeginConfiguration().Transport_UDP();
+
+    traitInstance = mSubscriptionEngine.mTraitInfoPool + mSubscriptionEngine.mNumTraitInfosInPool;
+    aSubHandler->mTraitInstanceList = traitInstance;
+    aSubHandler->mNumTraitInstances++;
+    ++(mSubscriptionEngine.mNumTraitInfosInPool);
+
+    traitInstance->Init();
+    traitInstance->mTraitDataHandle = aTraitDataHandle;
+    traitInstance->mRequestedVersion = 1;
+    traitInstance->SetChangeCursor(mNotificationEngine->mGraphSolver.GetCurrentChangeSeq());
+
+    aSubHandler->MoveToState(SubscriptionHandler::kState_SubscriptionEstablished_Idle);
+
+exit:
+    return err;
+}
+
 int TestTdm::BuildAndProcessNotify()
+{
+    return BuildAndProcessNotify(mSubHandler);
+}
+
+int TestTdm::BuildAndProcessNotify(SubscriptionHandler *aSubHandler, bool aNotifyDelivered)
 {
     bool isSubscriptionClean;
     NotificationEngine::NotifyRequestBuilder notifyRequest;
@@ -921,15 +1222,15 @@ int TestTdm::BuildAndProcessNotify()
     uint32_t maxNotificationSize = 0;
     uint32_t maxPayloadSize = 0;
 
-    maxNotificationSize = mSubHandler->GetMaxNotificationSize();
+    maxNotificationSize = aSubHandler->GetMaxNotificationSize();
 
-    err = mSubHandler->mBinding->AllocateRightSizedBuffer(buf, maxNotificationSize, WDM_MIN_NOTIFICATION_SIZE, maxPayloadSize);
+    err = aSubHandler->mBinding->AllocateRightSizedBuffer(buf, maxNotificationSize, WDM_MIN_NOTIFICATION_SIZE, maxPayloadSize);
     SuccessOrExit(err);
 
-    err = notifyRequest.Init(buf, &writer, mSubHandler, maxPayloadSize);
+    err = notifyRequest.Init(buf, &writer, aSubHandler, maxPayloadSize);
     SuccessOrExit(err);
 
-    err = mNotificationEngine->BuildSingleNotifyRequestDataList(mSubHandler, notifyRequest, isSubscriptionClean, neWriteInProgress);
+    err = mNotificationEngine->BuildSingleNotifyRequestDataList(aSubHandler, notifyRequest, isSubscriptionClean, neWriteInProgress);
     SuccessOrExit(err);
 
     if (neWriteInProgress)
@@ -965,6 +1266,9 @@ int TestTdm::BuildAndProcessNotify()
 
         err = mSubClient->ProcessDataList(reader);
         SuccessOrExit(err);
+
+        // The subscriber acknowledges the notify, or it times out.
+        mNotificationEngine->UpdateChangeCursors(aSubHandler, aNotifyDelivered);
     }
     else
     {
@@ -1006,6 +1310,262 @@ exit:
     NL_TEST_ASSERT(inSuite, testPass);
 }
 
+void TestTdm::TestTdmStatic_ManySubscribers(nlTestSuite *inSuite)
+{
+    // Every handler the engine has room for subscribes to mTestTdmSource. The others are notified after every change, while
+    // mSubHandler lags behind and only catches up every kLagInterval rounds. The number of rotating properties is kept within
+    // the merge handle set so that a granular notify never degrades to the whole trait.
+    enum
+    {
+        kNumRounds          = 1000,
+        kLagInterval        = 7,
+        kNumRotatingHandles = WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET < 4 ? WDM_PUBLISHER_INTERMEDIATE_SOLVER_MAX_MERGE_HANDLE_SET : 4
+    };
+    const PropertyPathHandle rotatingHandles[] = { TestHTrait::kPropertyHandle_A, TestHTrait::kPropertyHandle_B,
+                                                   TestHTrait::kPropertyHandle_C, TestHTrait::kPropertyHandle_D };
+    SubscriptionHandler *subHandlers[SubscriptionEngine::kMaxNumSubscriptionHandlers];
+    size_t numSubHandlers = 0;
+    TraitDataHandle sourceHandle = mSubHandler->mTraitInstanceList[0].mTraitDataHandle;
+    std::map <PropertyPathHandle, uint32_t> laggingChanges;
+    uint32_t numNotifies = 0;
+    uint64_t startTime, elapsedUS;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool testPass = false;
+
+    Reset();
+
+    subHandlers[numSubHandlers++] = mSubHandler;
+
+    while (numSubHandlers < SubscriptionEngine::kMaxNumSubscriptionHandlers &&
+           mSubscriptionEngine.mNumTraitInfosInPool < SubscriptionEngine::kMaxNumPathGroups)
+    {
+        err = NewSubscriptionHandler(sourceHandle, subHandlers[numSubHandlers]);
+        SuccessOrExit(err);
+        numSubHandlers++;
+    }
+
+    startTime = Now();
+
+    for (uint32_t round = 1; round <= kNumRounds; round++)
+    {
+        PropertyPathHandle handle = rotatingHandles[round % kNumRotatingHandles];
+
+        mTestTdmSource.SetValue(handle, round);
+        laggingChanges[handle] = round;
+
+        // The up-to-date subscriptions only receive the property that just changed, however far behind mSubHandler is.
+        for (size_t i = 1; i < numSubHandlers; i++)
+        {
+            mTestTdmSink.Reset();
+
+            err = BuildAndProcessNotify(subHandlers[i]);
+            SuccessOrExit(err);
+            numNotifies++;
+
+            testPass = mTestTdmSink.ValidateChangeSets( { { handle, round } }, { }, { } );
+            VerifyOrExit(testPass, );
+        }
+
+        // The lagging subscription receives exactly what changed since it was last notified.
+        if ((round % kLagInterval) == 0)
+        {
+            mTestTdmSink.Reset();
+
+            err = BuildAndProcessNotify(mSubHandler);
+            SuccessOrExit(err);
+            numNotifies++;
+
+            testPass = mTestTdmSink.ValidateChangeSets(laggingChanges, { }, { });
+            VerifyOrExit(testPass, );
+
+            laggingChanges.clear();
+        }
+
+        // What the engine does at the end of every run. The changes still pending for mSubHandler must never force the trait
+        // instance to be notified from root.
+        mNotificationEngine->mGraphSolver.TrimChanges();
+        VerifyOrExit(!mTestTdmSource.IsRootDirty(), testPass = false);
+    }
+
+    elapsedUS = Now() - startTime;
+    printf("%u subscribers, %u rounds: %u notifies in %u us\n", (unsigned) numSubHandlers, kNumRounds, numNotifies,
+           (uint32_t) elapsedUS);
+
+    // Let the lagging subscription catch up so that it is clean for the tests that follow.
+    mTestTdmSink.Reset();
+
+    err = BuildAndProcessNotify(mSubHandler);
+    SuccessOrExit(err);
+
+    testPass = mTestTdmSink.ValidateChangeSets(laggingChanges, { }, { });
+    VerifyOrExit(testPass, );
+
+exit:
+    for (size_t i = 1; i < numSubHandlers; i++)
+    {
+        subHandlers[i]->AbortSubscription();
+    }
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, testPass);
+}
+
+void TestTdm::TestTdmStatic_UndeliveredNotify(nlTestSuite *inSuite)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    bool testPass = false;
+
+    Reset();
+
+    // The notify carrying A is written out but never acknowledged.
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+
+    err = BuildAndProcessNotify(mSubHandler, false);
+    SuccessOrExit(err);
+
+    testPass = mTestTdmSink.ValidateChangeSets( { { TestHTrait::kPropertyHandle_A, 2 } }, { }, { } );
+    VerifyOrExit(testPass, );
+
+    // The end of the run must not drop A, since the subscriber has yet to receive it.
+    mNotificationEngine->mGraphSolver.TrimChanges();
+
+    mTestTdmSink.Reset();
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_B, 3);
+
+    err = BuildAndProcessNotify();
+    SuccessOrExit(err);
+
+    testPass = mTestTdmSink.ValidateChangeSets( { { TestHTrait::kPropertyHandle_A, 2 }, { TestHTrait::kPropertyHandle_B, 3 } },
+                                                { },
+                                                { } );
+    VerifyOrExit(testPass, );
+
+    // Once acknowledged, only later changes are sent.
+    mNotificationEngine->mGraphSolver.TrimChanges();
+
+    mTestTdmSink.Reset();
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_C, 4);
+
+    err = BuildAndProcessNotify();
+    SuccessOrExit(err);
+
+    testPass = mTestTdmSink.ValidateChangeSets( { { TestHTrait::kPropertyHandle_C, 4 } }, { }, { } );
+    VerifyOrExit(testPass, );
+
+exit:
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(inSuite, testPass);
+}
+
+void TestTdm::CheckNotificationEngineReadyQueue(nlTestSuite *inSuite)
+{
+    // Every handler the engine has room for subscribes to mTestTdmSource, while only mSubHandler subscribes to mTestTdmSource1.
+    // Run() is only ever invoked here while the handlers are clean, so that it does not attempt to send anything.
+    enum
+    {
+        kNumRuns = 10000
+    };
+    SubscriptionHandler *subHandlers[SubscriptionEngine::kMaxNumSubscriptionHandlers];
+    size_t numSubHandlers = 0;
+    TraitDataHandle sourceHandle = mSubHandler->mTraitInstanceList[0].mTraitDataHandle;
+    uint64_t startTime, idleUS, oneReadyUS, allReadyUS;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+
+    Reset();
+
+    // Flush anything left pending for mSubHandler by earlier tests.
+    err = BuildAndProcessNotify();
+    SuccessOrExit(err);
+
+    subHandlers[numSubHandlers++] = mSubHandler;
+
+    // Double the number of handlers at each step, for as long as the engine has room for them, and compare the cost of a run when
+    // no handler is ready and when a single one is, which should not depend on the number of handlers, against one where every
+    // handler is evaluated, as was the case for every run before handlers were scheduled by readiness.
+    for (size_t target = 1; ; target *= 2)
+    {
+        size_t prevNumSubHandlers = numSubHandlers;
+
+        while (numSubHandlers < target && numSubHandlers < SubscriptionEngine::kMaxNumSubscriptionHandlers &&
+               mSubscriptionEngine.mNumTraitInfosInPool < SubscriptionEngine::kMaxNumPathGroups)
+        {
+            err = NewSubscriptionHandler(sourceHandle, subHandlers[numSubHandlers]);
+            SuccessOrExit(err);
+            numSubHandlers++;
+
+            // Handlers are queued as they become notifiable.
+            NL_TEST_ASSERT(inSuite, mNotificationEngine->mIsHandlerReady[mSubscriptionEngine.GetHandlerId(subHandlers[numSubHandlers - 1])]);
+        }
+
+        if (target > 1 && numSubHandlers == prevNumSubHandlers)
+        {
+            break;
+        }
+
+        // With nothing dirty, a single run drains the queue.
+        mNotificationEngine->Run();
+        NL_TEST_ASSERT(inSuite, mNotificationEngine->mNumReadyHandlers == 0);
+
+        startTime = Now();
+        for (int i = 0; i < kNumRuns; i++)
+        {
+            mNotificationEngine->Run();
+        }
+        idleUS = Now() - startTime;
+
+        startTime = Now();
+        for (int i = 0; i < kNumRuns; i++)
+        {
+            mNotificationEngine->ScheduleHandler(subHandlers[numSubHandlers - 1]);
+            mNotificationEngine->Run();
+        }
+        oneReadyUS = Now() - startTime;
+
+        startTime = Now();
+        for (int i = 0; i < kNumRuns; i++)
+        {
+            for (size_t j = 0; j < numSubHandlers; j++)
+            {
+                mNotificationEngine->ScheduleHandler(subHandlers[j]);
+            }
+            mNotificationEngine->Run();
+        }
+        allReadyUS = Now() - startTime;
+
+        printf("%2u subscribers: %u runs in %u us with no handler ready, %u us with one ready, %u us with every handler ready\n",
+               (unsigned) numSubHandlers, kNumRuns, (uint32_t) idleUS, (uint32_t) oneReadyUS, (uint32_t) allReadyUS);
+    }
+
+    // Marking a trait instance dirty only queues the handlers subscribed to it.
+    mTestTdmSource1.SetValue(TestHTrait::kPropertyHandle_A, 2);
+    NL_TEST_ASSERT(inSuite, mNotificationEngine->mNumReadyHandlers == 1);
+    NL_TEST_ASSERT(inSuite, mNotificationEngine->mIsHandlerReady[mSubscriptionEngine.GetHandlerId(mSubHandler)]);
+
+    // Marking it dirty again does not queue the handler twice.
+    mTestTdmSource1.SetValue(TestHTrait::kPropertyHandle_B, 2);
+    NL_TEST_ASSERT(inSuite, mNotificationEngine->mNumReadyHandlers == 1);
+
+    mTestTdmSource.SetValue(TestHTrait::kPropertyHandle_A, 2);
+    NL_TEST_ASSERT(inSuite, mNotificationEngine->mNumReadyHandlers == numSubHandlers);
+
+    for (size_t i = 0; i < numSubHandlers; i++)
+    {
+        err = BuildAndProcessNotify(subHandlers[i]);
+        SuccessOrExit(err);
+    }
+
+    mNotificationEngine->Run();
+    NL_TEST_ASSERT(inSuite, mNotificationEngine->mNumReadyHandlers == 0);
+
+exit:
+    for (size_t i = 1; i < numSubHandlers; i++)
+    {
+        subHandlers[i]->AbortSubscription();
+    }
+
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+}
+
 void TestTdm::TestTdmStatic_SingleLeafHandle(nlTestSuite *inSuite)
 {
     WEAVE_ERROR err = WEAVE_NO_ERROR;
@@ -2047,6 +2607,147 @@ void TestTdm::CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite
     NL_TEST_ASSERT(inSuite, err != WEAVE_NO_ERROR);
 }
 
+class AcceptAllDataElementsDelegate : public IDataElementAccessControlDelegate
+{
+public:
+    WEAVE_ERROR DataElementAccessCheck(const TraitPath & aTraitPath, const TraitCatalogBase<TraitDataSink> & aCatalog)
+    {
+        return WEAVE_NO_ERROR;
+    }
+};
+
+void TestTdm::CheckNotifyRequestIngestRate(nlTestSuite *inSuite)
+{
+    // Measure the rate at which NotifyRequests carrying one DataElement per trait instance are ingested, from parsing the
+    // message through to the data sinks storing the new versions, for increasingly large catalogs. Each notify covers a
+    // different slice of the catalog, the way a gateway proxying many devices sees them.
+    static const uint32_t kCatalogSizes[] = { 16, 256, 4096 };
+    enum
+    {
+        kElementsPerNotify = 32,
+        kNumNotifies       = 256,
+        kNotifyBufSize     = 2048
+    };
+
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    AcceptAllDataElementsDelegate acDelegate;
+    uint8_t * notifyBuf  = new uint8_t[kNumNotifies * kNotifyBufSize];
+    uint32_t * notifyLen = new uint32_t[kNumNotifies];
+
+    for (size_t s = 0; s < sizeof(kCatalogSizes) / sizeof(kCatalogSizes[0]); s++)
+    {
+        const uint32_t numSinks = kCatalogSizes[s];
+        GenericTraitSinkCatalog catalog;
+        TestEmptyDataSink ** sinks = new TestEmptyDataSink *[numSinks];
+        TraitDataHandle * handles  = new TraitDataHandle[numSinks];
+        uint64_t startTime, elapsedUS;
+
+        for (uint32_t i = 0; i < numSinks; i++)
+        {
+            sinks[i] = new TestEmptyDataSink(&gCatalogTestTraitSchema);
+            err      = catalog.Add(CatalogTestResource(i), CatalogTestInstance(i), kRootPropertyPathHandle, sinks[i], handles[i]);
+            SuccessOrExit(err);
+        }
+
+        // Encode the notifies up front. Element e of the stream targets entry (e % numSinks) with a version that is newer
+        // every time the stream wraps around the catalog, so every element is stored.
+        for (uint32_t n = 0; n < kNumNotifies; n++)
+        {
+            TLVWriter writer;
+            TLVType notifyContainer, dataListContainer, elementContainer, pathContainer, dataContainer;
+
+            writer.Init(notifyBuf + n * kNotifyBufSize, kNotifyBufSize);
+
+            err = writer.StartContainer(AnonymousTag, kTLVType_Structure, notifyContainer);
+            SuccessOrExit(err);
+            err = writer.Put(ContextTag(NotificationRequest::kCsTag_SubscriptionId), (uint64_t) 1);
+            SuccessOrExit(err);
+            err = writer.StartContainer(ContextTag(NotificationRequest::kCsTag_DataList), kTLVType_Array, dataListContainer);
+            SuccessOrExit(err);
+
+            for (uint32_t e = n * kElementsPerNotify; e < (n + 1) * kElementsPerNotify; e++)
+            {
+                SchemaVersionRange versionRange;
+
+                err = writer.StartContainer(AnonymousTag, kTLVType_Structure, elementContainer);
+                SuccessOrExit(err);
+                err = writer.StartContainer(ContextTag(DataElement::kCsTag_Path), kTLVType_Path, pathContainer);
+                SuccessOrExit(err);
+                err = catalog.HandleToAddress(handles[e % numSinks], writer, versionRange);
+                SuccessOrExit(err);
+                err = writer.EndContainer(pathContainer);
+                SuccessOrExit(err);
+                err = writer.Put(ContextTag(DataElement::kCsTag_Version), (uint64_t) (1 + e / numSinks));
+                SuccessOrExit(err);
+                err = writer.StartContainer(ContextTag(DataElement::kCsTag_Data), kTLVType_Structure, dataContainer);
+                SuccessOrExit(err);
+                err = writer.EndContainer(dataContainer);
+                SuccessOrExit(err);
+                err = writer.EndContainer(elementContainer);
+                SuccessOrExit(err);
+            }
+
+            err = writer.EndContainer(dataListContainer);
+            SuccessOrExit(err);
+            err = writer.EndContainer(notifyContainer);
+            SuccessOrExit(err);
+            err = writer.Finalize();
+            SuccessOrExit(err);
+            notifyLen[n] = writer.GetLengthWritten();
+        }
+
+        startTime = Now();
+
+        // Process each notify the way SubscriptionClient::NotificationRequestHandler does.
+        for (uint32_t n = 0; n < kNumNotifies; n++)
+        {
+            TLVReader reader;
+            NotificationRequest::Parser notify;
+            DataList::Parser dataList;
+            bool isPartialChange = false;
+            TraitDataHandle prevHandle;
+
+            reader.Init(notifyBuf + n * kNotifyBufSize, notifyLen[n]);
+            err = reader.Next();
+            SuccessOrExit(err);
+            err = notify.Init(reader);
+            SuccessOrExit(err);
+            err = notify.GetDataList(&dataList);
+            SuccessOrExit(err);
+            dataList.GetReader(&reader);
+
+            err = SubscriptionEngine::ProcessDataList(reader, &catalog, isPartialChange, prevHandle, acDelegate);
+            SuccessOrExit(err);
+        }
+
+        elapsedUS = Now() - startTime;
+
+        // Every entry holds the version of the last element that targeted it.
+        for (uint32_t i = 0; i < numSinks; i++)
+        {
+            NL_TEST_ASSERT(inSuite, sinks[i]->GetVersion() == 1 + (kNumNotifies * kElementsPerNotify - 1 - i) / numSinks);
+        }
+
+        printf("Catalog size %5u: %u notifies (%u data elements) in %u us (%u data elements/sec)\n", numSinks, kNumNotifies,
+               kNumNotifies * kElementsPerNotify, (uint32_t) elapsedUS,
+               (uint32_t) ((elapsedUS > 0) ? (kNumNotifies * kElementsPerNotify * 1000000ULL) / elapsedUS : 0));
+
+        catalog.Clear();
+        for (uint32_t i = 0; i < numSinks; i++)
+        {
+            delete sinks[i];
+        }
+        delete[] sinks;
+        delete[] handles;
+    }
+
+exit:
+    NL_TEST_ASSERT(inSuite, err == WEAVE_NO_ERROR);
+
+    delete[] notifyBuf;
+    delete[] notifyLen;
+}
+
 void TestTdm::CheckSynchronizedTraitState(nlTestSuite *inSuite)
 {
     CommandSender::SynchronizedTraitState synchronizedState;
@@ -2400,11 +3101,31 @@ static void TestTdmStatic_MultiInstance(nlTestSuite *inSuite, void *inContext)
     gTestTdm->TestTdmStatic_MultiInstance(inSuite);
 }
 
+static void TestTdmStatic_ManySubscribers(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_ManySubscribers(inSuite);
+}
+
+static void TestTdmStatic_UndeliveredNotify(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->TestTdmStatic_UndeliveredNotify(inSuite);
+}
+
+static void CheckNotificationEngineReadyQueue(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->CheckNotificationEngineReadyQueue(inSuite);
+}
+
 static void CheckAllocateRightSizedBufferForNotifications(nlTestSuite *inSuite, void *inContext)
 {
     gTestTdm->CheckAllocateRightSizedBufferForNotifications(inSuite);
 }
 
+static void CheckNotifyRequestIngestRate(nlTestSuite *inSuite, void *inContext)
+{
+    gTestTdm->CheckNotifyRequestIngestRate(inSuite);
+}
+
 static void CheckSynchronizedTraitState(nlTestSuite *inSuite, void *inContext)
 {
     gTestTdm->CheckSynchronizedTraitState(inSuite);
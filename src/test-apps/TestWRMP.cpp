@@ -37,6 +37,7 @@
 #include <SystemLayer/SystemTimer.h>
 #include <Weave/Profiles/service-directory/ServiceDirectory.h>
 #include <Weave/Profiles/echo/WeaveEcho.h>
+#include <Weave/Support/WeaveFaultInjection.h>
 #include "TestWRMP.h"
 
 #if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
@@ -182,6 +183,9 @@ static const char *gToolOptionHelp =
     "       TestWRMPDuplicateMsgAckOnClosedExResponder------------[14]\n"
     "       TestWRMPDuplicateMsgAckOnClosedExInitiator------------[15]\n"
     "       TestWRMPDuplicateMsgDetection-------------------------[16]\n"
+    "       TestWRMPAdaptiveRetransTimeout------------------------[17]\n"
+    "       TestWRMPAggregatedAcks--------------------------------[18]\n"
+    "       TestWRMPCongestionControl-----------------------------[19]\n"
     "\n"
     "  -W, --wait <TestWaitTime>\n"
     "\n"
@@ -1423,6 +1427,484 @@ testStatus_t TestWRMPDuplicateMsgDetection(void)
     return TEST_FAIL;
 }
 
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+#define TEST_LOSS_MESSAGE_COUNT            (20)
+#define TEST_LOSS_INTERVAL                 (5)
+#define TEST_ADAPTIVE_WARMUP_COUNT         (5)
+
+// Send a message that requests an ack on the test exchange, optionally
+// dropping its first transmission, and wait for the ack.
+static bool SendAndWaitForAck(bool dropFirstTransmission, uint64_t & transmitTime)
+{
+    WEAVE_ERROR err;
+    PacketBuffer *payloadBuf = NULL;
+
+    PrepareNewBuf(&payloadBuf);
+    isAckRcvd = false;
+
+    WRMPClient.ExchangeMgr->MessageLayer->mDropMessage = dropFirstTransmission;
+
+    err = SendCustomMessage(WRMPClient.ExchangeCtx, kWeaveProfile_Test, kWeaveTestMessageType_Generate_Response,
+                            ExchangeContext::kSendFlag_RequestAck, payloadBuf);
+    transmitTime = Now();
+
+    WRMPClient.ExchangeMgr->MessageLayer->mDropMessage = false;
+
+    if (err != WEAVE_NO_ERROR)
+    {
+        printf("WRMPTestClient.SendCustomMessage failed: %s\n", ErrorStr(err));
+        return false;
+    }
+
+    while (!isAckRcvd && Now() < transmitTime + MaxAckReceiptInterval + TEST_ACTIVE_RETRANS_TIMEOUT * System::kTimerFactor_micro_per_milli)
+    {
+        struct timeval sleepTime;
+        sleepTime.tv_sec = 0;
+        sleepTime.tv_usec = 10000;
+
+        ServiceNetwork(sleepTime);
+    }
+
+    return isAckRcvd;
+}
+
+// Send messages to the peer, dropping the first transmission of every
+// TEST_LOSS_INTERVAL'th one so that the exchange layer retransmits it, either
+// after the configured retransmit timeout or after the timeout derived from the
+// round trip times measured to the peer. Add up the time taken to deliver the
+// lost messages.
+static bool MeasureLossRecovery(bool fixedTimeout, uint64_t & recoveryTime)
+{
+    uint64_t transmitTime = 0;
+
+    WRMPClient.ExchangeCtx->SetUseFixedRetransTimeout(fixedTimeout);
+
+    recoveryTime = 0;
+
+    for (uint32_t i = 0; i < TEST_LOSS_MESSAGE_COUNT; i++)
+    {
+        bool lost = (i % TEST_LOSS_INTERVAL) == (TEST_LOSS_INTERVAL - 1);
+
+        if (!SendAndWaitForAck(lost, transmitTime))
+        {
+            printf("No ack received\n");
+            return false;
+        }
+
+        if (lost)
+        {
+            recoveryTime += Now() - transmitTime;
+        }
+    }
+
+    WRMPClient.ExchangeCtx->SetUseFixedRetransTimeout(false);
+
+    return true;
+}
+
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+
+//Measure the round trip time to the peer, verify that a lost message is
+//retransmitted after the adaptive timeout rather than the configured one and
+//that its ack yields no round trip time, then compare the time taken to recover
+//from losses with fixed and adaptive retransmit timeouts.
+testStatus_t TestWRMPAdaptiveRetransTimeout(void)
+{
+#if WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+    uint64_t transmitTime = 0;
+    uint64_t fixedRecovery, adaptiveRecovery;
+    uint32_t adaptiveTimeout;
+
+    Done = false;
+
+    // Adaptive retransmit timeouts are off unless enabled; this test is the only one that does.
+    WRMPClient.ExchangeMgr->SetAdaptiveRetransTimeoutEnabled(true);
+
+    // Measure the round trip time to the peer over a few exchanges.
+    WRMPClient.ExchangeCtx->mWRMPConfig.mInitialRetransTimeout = TEST_INITIAL_RETRANS_TIMEOUT;
+    WRMPClient.ExchangeCtx->mWRMPConfig.mActiveRetransTimeout = TEST_ACTIVE_RETRANS_TIMEOUT;
+
+    for (int i = 0; i < TEST_ADAPTIVE_WARMUP_COUNT; i++)
+    {
+        if (!SendAndWaitForAck(false, transmitTime))
+        {
+            printf("No ack received\n");
+            return TEST_FAIL;
+        }
+    }
+
+    adaptiveTimeout = WRMPClient.ExchangeCtx->GetCurrentRetransmitTimeout();
+    printf("Adaptive retransmit timeout %" PRIu32 " ms\n", adaptiveTimeout);
+
+    if (adaptiveTimeout >= TEST_ACTIVE_RETRANS_TIMEOUT)
+    {
+        return TEST_FAIL;
+    }
+
+    // A lost message is retransmitted after the adaptive timeout.
+    if (!SendAndWaitForAck(true, transmitTime) || IsRetransOutsideWindow(transmitTime, adaptiveTimeout))
+    {
+        return TEST_FAIL;
+    }
+
+    // The ack of the retransmitted message is ambiguous, so the retransmit
+    // timeout stays backed off until a message that was sent once is acked.
+    if (WRMPClient.ExchangeCtx->GetCurrentRetransmitTimeout() <= adaptiveTimeout)
+    {
+        printf("Round trip time measured from a retransmitted message\n");
+        return TEST_FAIL;
+    }
+
+    if (!MeasureLossRecovery(true, fixedRecovery) || !MeasureLossRecovery(false, adaptiveRecovery))
+    {
+        return TEST_FAIL;
+    }
+
+    printf("Loss recovery %" PRIu64 " ms fixed, %" PRIu64 " ms adaptive\n",
+           fixedRecovery / System::kTimerFactor_micro_per_milli, adaptiveRecovery / System::kTimerFactor_micro_per_milli);
+
+    if (adaptiveRecovery >= fixedRecovery)
+    {
+        return TEST_FAIL;
+    }
+
+    Done = true;
+    return TEST_PASS;
+#else
+    printf("Adaptive retransmit timeouts are not enabled\n");
+    return TEST_PASS;
+#endif // WEAVE_CONFIG_WRMP_ADAPTIVE_RETRANS_TIMEOUT
+}
+
+#define TEST_AGGREGATED_ACK_EXCHANGES      (4)
+
+//Send a message that requests an ack on each of several exchanges with the peer,
+//and verify that the peer sends the acks together in a single Ack List message.
+testStatus_t TestWRMPAggregatedAcks(void)
+{
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+    testStatus_t testStatus = TEST_FAIL;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PacketBuffer *payloadBuf = NULL;
+    ExchangeContext *ecs[TEST_AGGREGATED_ACK_EXCHANGES] = { NULL };
+    const WeaveExchangeManager::WRMPAckStats &ackStats = WRMPClient.ExchangeMgr->GetWRMPAckStats();
+
+    ackCount = 0;
+    Done = false;
+    LastEchoTime = Now();
+
+    // Ack aggregation is off unless enabled; the peer only aggregates acks towards nodes that advertise it,
+    // and this test is the only one that does.
+    WRMPClient.ExchangeMgr->SetAckAggregationEnabled(true);
+    WRMPClient.ExchangeMgr->ResetWRMPAckStats();
+
+    for (int i = 0; i < TEST_AGGREGATED_ACK_EXCHANGES; i++)
+    {
+        ecs[i] = WRMPClient.ExchangeMgr->NewContext(DestNodeId, DestIPAddr, WEAVE_PORT, DestIntf, &WRMPClient);
+        if (ecs[i] == NULL)
+        {
+            printf("NewContext failed\n");
+            goto exit;
+        }
+
+        ecs[i]->OnAckRcvd = HandleAckRcvd;
+
+        PrepareNewBuf(&payloadBuf);
+        err = SendCustomMessage(ecs[i], kWeaveProfile_Test, kWeaveTestMessageType_No_Response, ExchangeContext::kSendFlag_RequestAck, payloadBuf);
+        if (err != WEAVE_NO_ERROR)
+        {
+            printf("WRMPTestClient.SendCustomMessage failed: %s\n", ErrorStr(err));
+            goto exit;
+        }
+    }
+
+    while (ackCount < TEST_AGGREGATED_ACK_EXCHANGES && Now() < LastEchoTime + MaxAckReceiptInterval)
+    {
+        struct timeval sleepTime;
+        sleepTime.tv_sec = 0;
+        sleepTime.tv_usec = 100000;
+
+        ServiceNetwork(sleepTime);
+    }
+
+    printf("Acks received %d; Ack Lists received %" PRIu32 " carrying %" PRIu32 " acks\n",
+           ackCount, ackStats.AckListsReceived, ackStats.AggregatedAcksReceived);
+
+    if (ackCount == TEST_AGGREGATED_ACK_EXCHANGES && ackStats.AckListsReceived == 1 &&
+        ackStats.AggregatedAcksReceived == TEST_AGGREGATED_ACK_EXCHANGES - 1)
+    {
+        testStatus = TEST_PASS;
+    }
+
+exit:
+    for (int i = 0; i < TEST_AGGREGATED_ACK_EXCHANGES; i++)
+    {
+        if (ecs[i] != NULL)
+        {
+            ecs[i]->Close();
+        }
+    }
+
+    Done = true;
+    return testStatus;
+#else
+    printf("Ack aggregation is not enabled\n");
+    return TEST_PASS;
+#endif // WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+}
+
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+#define TEST_CC_EXTRA_MESSAGES             (3)
+
+#if WEAVE_CONFIG_TEST
+
+#define TEST_CC_LINK_MESSAGE_COUNT         (60)
+#define TEST_CC_LINK_RATE                  (2)
+#define TEST_CC_LINK_BURST                 (4)
+#define TEST_CC_LINK_MAX_RETRANS           (10)
+#define TEST_CC_LINK_RETRANS_TIMEOUT       (400)
+#define TEST_CC_LINK_DURATION              (30 * System::kTimerFactor_micro_per_unit)
+
+// A bottleneck link between the client and the peer, which carries no more than
+// TEST_CC_LINK_RATE messages per WRMP timer period, or TEST_CC_LINK_BURST after a
+// quiet spell, and drops the rest.
+struct BottleneckLink
+{
+    uint64_t lastRefillTime;
+    uint32_t credit;
+    uint32_t transmissions;
+    uint32_t losses;
+};
+
+static BottleneckLink sBottleneckLink;
+
+// Invoked by the message layer for every UDP message the client sends, through the
+// fault that drops outgoing messages.
+static bool DropAtBottleneck(nl::FaultInjection::Identifier aId, nl::FaultInjection::Record *aFaultRecord, void *aContext)
+{
+    BottleneckLink & link = *static_cast<BottleneckLink *>(aContext);
+    const uint64_t period = WEAVE_CONFIG_WRMP_TIMER_DEFAULT_PERIOD * System::kTimerFactor_micro_per_milli;
+    const uint64_t periods = (Now() - link.lastRefillTime) / period;
+
+    if (periods > 0)
+    {
+        link.credit = (link.credit + periods * TEST_CC_LINK_RATE < TEST_CC_LINK_BURST) ?
+            link.credit + periods * TEST_CC_LINK_RATE : TEST_CC_LINK_BURST;
+        link.lastRefillTime += periods * period;
+    }
+
+    link.transmissions++;
+
+    if (link.credit == 0)
+    {
+        link.losses++;
+        return true;
+    }
+
+    link.credit--;
+    return false;
+}
+
+// Send messages that request acks to the peer over the bottleneck link, and let the
+// exchange manager deliver them: it keeps no more messages in flight than the
+// congestion window, halves the window when it retransmits, and opens it again as
+// acks arrive. Report the lowest window reached, the fraction of transmissions the
+// link dropped, and the time taken to deliver all the messages.
+static bool SendOverBottleneckLink(uint16_t & minWindow, uint32_t & lossPercent, uint64_t & duration)
+{
+    nl::FaultInjection::Manager & faultMgr = nl::Weave::FaultInjection::GetManager();
+    nl::FaultInjection::Callback dropCb;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PacketBuffer *payloadBuf = NULL;
+    ExchangeContext *ec = NULL;
+    uint64_t startTime;
+    bool delivered = false;
+
+    memset(&sBottleneckLink, 0, sizeof(sBottleneckLink));
+    sBottleneckLink.lastRefillTime = Now();
+    sBottleneckLink.credit = TEST_CC_LINK_BURST;
+
+    memset(&dropCb, 0, sizeof(dropCb));
+    dropCb.mCallBackFn = DropAtBottleneck;
+    dropCb.mContext = &sBottleneckLink;
+    faultMgr.InsertCallbackAtFault(nl::Weave::FaultInjection::kFault_DropOutgoingUDPMsg, &dropCb);
+
+    ackCount = 0;
+    minWindow = WRMPClient.ExchangeMgr->FabricState->GetPeerCongestionWindow(DestNodeId);
+    startTime = Now();
+
+    ec = WRMPClient.ExchangeMgr->NewContext(DestNodeId, DestIPAddr, WEAVE_PORT, DestIntf, &WRMPClient);
+    if (ec == NULL)
+    {
+        printf("NewContext failed\n");
+        goto exit;
+    }
+
+    ec->OnAckRcvd = HandleAckRcvd;
+    ec->mWRMPConfig.mMaxRetrans = TEST_CC_LINK_MAX_RETRANS;
+    ec->mWRMPConfig.mInitialRetransTimeout = TEST_CC_LINK_RETRANS_TIMEOUT;
+    ec->mWRMPConfig.mActiveRetransTimeout = TEST_CC_LINK_RETRANS_TIMEOUT;
+
+    for (int i = 0; i < TEST_CC_LINK_MESSAGE_COUNT; i++)
+    {
+        PrepareNewBuf(&payloadBuf);
+        err = SendCustomMessage(ec, kWeaveProfile_Test, kWeaveTestMessageType_No_Response,
+                                ExchangeContext::kSendFlag_RequestAck, payloadBuf);
+        if (err != WEAVE_NO_ERROR)
+        {
+            printf("WRMPTestClient.SendCustomMessage failed: %s\n", ErrorStr(err));
+            goto exit;
+        }
+    }
+
+    while (ackCount < TEST_CC_LINK_MESSAGE_COUNT && Now() < startTime + TEST_CC_LINK_DURATION)
+    {
+        struct timeval sleepTime;
+        uint16_t window;
+        sleepTime.tv_sec = 0;
+        sleepTime.tv_usec = 10000;
+
+        ServiceNetwork(sleepTime);
+
+        window = WRMPClient.ExchangeMgr->FabricState->GetPeerCongestionWindow(DestNodeId);
+        if (window < minWindow)
+        {
+            minWindow = window;
+        }
+    }
+
+    duration = Now() - startTime;
+    lossPercent = (sBottleneckLink.transmissions != 0) ? (sBottleneckLink.losses * 100) / sBottleneckLink.transmissions : 0;
+    delivered = (ackCount == TEST_CC_LINK_MESSAGE_COUNT);
+
+    printf("Bottleneck link: %d of %d messages acked in %" PRIu64 " ms; %" PRIu32 " transmissions, %" PRIu32 " dropped\n",
+           ackCount, TEST_CC_LINK_MESSAGE_COUNT, duration / System::kTimerFactor_micro_per_milli,
+           sBottleneckLink.transmissions, sBottleneckLink.losses);
+
+exit:
+    faultMgr.RemoveCallbackAtFault(nl::Weave::FaultInjection::kFault_DropOutgoingUDPMsg, &dropCb);
+
+    if (ec != NULL)
+    {
+        ec->Close();
+    }
+
+    return delivered;
+}
+
+#endif // WEAVE_CONFIG_TEST
+
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+
+//Send more messages to the peer than its congestion window allows and verify that
+//the excess is held back and sent as acks arrive, then deliver messages over a
+//bottleneck link that drops what it can't carry, and verify that the losses close
+//the window and that every message still gets through.
+testStatus_t TestWRMPCongestionControl(void)
+{
+#if WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+    testStatus_t testStatus = TEST_FAIL;
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    PacketBuffer *payloadBuf = NULL;
+    uint16_t window, inFlight, queued;
+    ExchangeContext *ec = NULL;
+
+    Done = false;
+
+    // Congestion control is off unless enabled; this test is the only one that does.
+    WRMPClient.ExchangeMgr->SetCongestionControlEnabled(true);
+
+    // Send more messages than the window allows on a new exchange.
+    window = WRMPClient.ExchangeMgr->FabricState->GetPeerCongestionWindow(DestNodeId);
+    ackCount = 0;
+    LastEchoTime = Now();
+
+    ec = WRMPClient.ExchangeMgr->NewContext(DestNodeId, DestIPAddr, WEAVE_PORT, DestIntf, &WRMPClient);
+    if (ec == NULL)
+    {
+        printf("NewContext failed\n");
+        return TEST_FAIL;
+    }
+
+    ec->OnAckRcvd = HandleAckRcvd;
+
+    for (int i = 0; i < window + TEST_CC_EXTRA_MESSAGES; i++)
+    {
+        PrepareNewBuf(&payloadBuf);
+        err = SendCustomMessage(ec, kWeaveProfile_Test, kWeaveTestMessageType_No_Response,
+                                ExchangeContext::kSendFlag_RequestAck, payloadBuf);
+        if (err != WEAVE_NO_ERROR)
+        {
+            printf("WRMPTestClient.SendCustomMessage failed: %s\n", ErrorStr(err));
+            goto exit;
+        }
+    }
+
+    WRMPClient.ExchangeMgr->GetWRMPPeerMessageCounts(DestNodeId, inFlight, queued);
+    printf("Congestion window %" PRIu16 ": %" PRIu16 " messages in flight, %" PRIu16 " held back\n", window, inFlight, queued);
+
+    if (inFlight != window || queued != TEST_CC_EXTRA_MESSAGES)
+    {
+        goto exit;
+    }
+
+    while (ackCount < window + TEST_CC_EXTRA_MESSAGES && Now() < LastEchoTime + MaxAckReceiptInterval)
+    {
+        struct timeval sleepTime;
+        sleepTime.tv_sec = 0;
+        sleepTime.tv_usec = 10000;
+
+        ServiceNetwork(sleepTime);
+    }
+
+    printf("Acks received %d\n", ackCount);
+
+    if (ackCount != window + TEST_CC_EXTRA_MESSAGES)
+    {
+        goto exit;
+    }
+
+#if WEAVE_CONFIG_TEST
+    {
+        uint16_t minWindow;
+        uint32_t lossPercent;
+        uint64_t duration;
+        uint16_t finalWindow;
+
+        if (!SendOverBottleneckLink(minWindow, lossPercent, duration))
+        {
+            goto exit;
+        }
+
+        finalWindow = WRMPClient.ExchangeMgr->FabricState->GetPeerCongestionWindow(DestNodeId);
+
+        printf("Congestion window %" PRIu16 " before, %" PRIu16 " at lowest, %" PRIu16 " after; %" PRIu32 "%% of transmissions dropped\n",
+               window, minWindow, finalWindow, lossPercent);
+
+        // The link dropped messages, so the window must have closed, and the acks
+        // that followed must have opened it again.
+        if (lossPercent == 0 || minWindow >= window || finalWindow <= minWindow)
+        {
+            goto exit;
+        }
+    }
+#endif // WEAVE_CONFIG_TEST
+
+    testStatus = TEST_PASS;
+
+exit:
+    ec->Close();
+
+    Done = true;
+    return testStatus;
+#else
+    printf("Congestion control is not enabled\n");
+    return TEST_PASS;
+#endif // WEAVE_CONFIG_WRMP_CONGESTION_CONTROL
+}
+
 struct Tests {
     testStatus_t (*mTest)(void);
     const char * mTestName;
@@ -1445,7 +1927,10 @@ Tests gTests[] =
     { .mTest = TestWRMPDuplicateMsgLostAck, .mTestName = "TestWRMPDuplicateMsgLostAck" },
     { .mTest = TestWRMPDuplicateMsgAckOnClosedExResponder, .mTestName = "TestWRMPDuplicateMsgAckOnClosedExResponder" },
     { .mTest = TestWRMPDuplicateMsgAckOnClosedExInitiator, .mTestName = "TestWRMPDuplicateMsgAckOnClosedExInitiator" },
-    { .mTest = TestWRMPDuplicateMsgDetection, .mTestName = "TestWRMPDuplicateMsgDetection" }
+    { .mTest = TestWRMPDuplicateMsgDetection, .mTestName = "TestWRMPDuplicateMsgDetection" },
+    { .mTest = TestWRMPAdaptiveRetransTimeout, .mTestName = "TestWRMPAdaptiveRetransTimeout" },
+    { .mTest = TestWRMPAggregatedAcks, .mTestName = "TestWRMPAggregatedAcks" },
+    { .mTest = TestWRMPCongestionControl, .mTestName = "TestWRMPCongestionControl" }
 };
 
 #endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
@@ -1523,6 +2008,11 @@ int main(int argc, char *argv[])
         // Arrange to get a callback whenever an Echo Request is received.
         WRMPServer.OnEchoRequestReceived = HandleEchoRequestReceived;
 
+#if WEAVE_CONFIG_WRMP_ACK_AGGREGATION
+        // Accept Ack List messages, and send them to clients that accept them too (TestWRMP -T 18).
+        ExchangeMgr.SetAckAggregationEnabled(true);
+#endif
+
         //SecurityMgr.OnSessionEstablished = HandleSecureSessionEstablished;
         //SecurityMgr.OnSessionError = HandleSecureSessionError;
     }
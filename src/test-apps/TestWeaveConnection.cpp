@@ -0,0 +1,315 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file tests the establishment of WeaveConnections to peers
+ *      that have several addresses, some of which are unreachable.
+ *
+ */
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#ifndef __STDC_LIMIT_MACROS
+#define __STDC_LIMIT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ToolCommon.h"
+#include <nlunit-test.h>
+
+#if INET_CONFIG_ENABLE_IPV4
+
+using namespace nl::Inet;
+
+#define TOOL_NAME "TestWeaveConnection"
+#define TEST_CONNECT_TIMEOUT_MILLISECS                (10000)
+#define TEST_DURATION_MILLISECS                       (20000)
+#define TEST_MAX_ACCEPTED_CONNECTIONS                 (4)
+
+// An address reserved for documentation (RFC 5737), to which connection attempts either fail
+// immediately or are never answered, depending on the routes of the host.
+#define TEST_UNREACHABLE_ADDR                         "192.0.2.1"
+
+// Loopback addresses on which nothing listens, so connection attempts to them are refused.
+#define TEST_REFUSED_ADDR_1                           "127.0.0.2"
+#define TEST_REFUSED_ADDR_2                           "127.0.0.3"
+
+#define TEST_LISTEN_ADDR                              "127.0.0.1"
+#define TEST_LISTEN_PORT                              (11097)
+
+struct ConnectTestContext
+{
+    bool complete;
+    WEAVE_ERROR conErr;
+    IPAddress peerAddr;
+};
+
+static TCPEndPoint * sListenEndPoint = NULL;
+static TCPEndPoint * sAcceptedEndPoints[TEST_MAX_ACCEPTED_CONNECTIONS];
+
+static void StartListening(nlTestSuite * testSuite);
+static void StopListening(void);
+static uint64_t RunConnectTest(nlTestSuite * testSuite, const char * const peerAddrStrs[], uint8_t peerAddrCount,
+                               ConnectTestContext & testContext);
+static void HandleConnectionReceived(TCPEndPoint * listeningEndPoint, TCPEndPoint * conEndPoint, const IPAddress & peerAddr,
+                                     uint16_t peerPort);
+static void HandleConnectionComplete(WeaveConnection * con, WEAVE_ERROR conErr);
+static void ServiceNetworkUntilDone(uint32_t timeoutMS);
+
+/**
+ *  Test that a connection is made to the one reachable address of a peer, even when it is listed
+ *  after an unreachable address and a refused one.
+ */
+static void TestWeaveConnection_UnreachableAddress(nlTestSuite * testSuite, void * testContext)
+{
+    static const char * const peerAddrStrs[] = { TEST_UNREACHABLE_ADDR, TEST_REFUSED_ADDR_1, TEST_LISTEN_ADDR };
+    ConnectTestContext context;
+    IPAddress listenAddr;
+    uint64_t elapsedMS;
+
+    StartListening(testSuite);
+
+    elapsedMS = RunConnectTest(testSuite, peerAddrStrs, 3, context);
+
+    IPAddress::FromString(TEST_LISTEN_ADDR, listenAddr);
+    NL_TEST_ASSERT(testSuite, context.complete);
+    NL_TEST_ASSERT(testSuite, context.conErr == WEAVE_NO_ERROR);
+    NL_TEST_ASSERT(testSuite, context.peerAddr == listenAddr);
+
+#if WEAVE_CONFIG_CONNECT_MAX_PARALLEL_ATTEMPTS > 1
+    // The attempt to the reachable address must not have waited for the unreachable one to time out.
+    NL_TEST_ASSERT(testSuite, elapsedMS < TEST_CONNECT_TIMEOUT_MILLISECS / 2);
+#endif
+
+    printf("Connection to %s completed in %" PRIu64 " ms\n", TEST_LISTEN_ADDR, elapsedMS);
+
+    StopListening();
+}
+
+/**
+ *  Test that a connection fails, with the error of the last attempt, when none of the addresses of
+ *  the peer can be reached.
+ */
+static void TestWeaveConnection_NoReachableAddress(nlTestSuite * testSuite, void * testContext)
+{
+    static const char * const peerAddrStrs[] = { TEST_REFUSED_ADDR_1, TEST_REFUSED_ADDR_2 };
+    ConnectTestContext context;
+
+    StartListening(testSuite);
+
+    RunConnectTest(testSuite, peerAddrStrs, 2, context);
+
+    NL_TEST_ASSERT(testSuite, context.complete);
+    NL_TEST_ASSERT(testSuite, context.conErr != WEAVE_NO_ERROR);
+
+    StopListening();
+}
+
+static void StartListening(nlTestSuite * testSuite)
+{
+    IPAddress listenAddr;
+    INET_ERROR err;
+
+    IPAddress::FromString(TEST_LISTEN_ADDR, listenAddr);
+
+    err = Inet.NewTCPEndPoint(&sListenEndPoint);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    err = sListenEndPoint->Bind(kIPAddressType_IPv4, listenAddr, TEST_LISTEN_PORT, true);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    sListenEndPoint->OnConnectionReceived = HandleConnectionReceived;
+    err = sListenEndPoint->Listen(1);
+    NL_TEST_ASSERT(testSuite, err == INET_NO_ERROR);
+
+    memset(sAcceptedEndPoints, 0, sizeof(sAcceptedEndPoints));
+}
+
+static void StopListening(void)
+{
+    for (int i = 0; i < TEST_MAX_ACCEPTED_CONNECTIONS; i++)
+        if (sAcceptedEndPoints[i] != NULL)
+        {
+            sAcceptedEndPoints[i]->Abort();
+            sAcceptedEndPoints[i]->Free();
+            sAcceptedEndPoints[i] = NULL;
+        }
+
+    if (sListenEndPoint != NULL)
+    {
+        sListenEndPoint->Free();
+        sListenEndPoint = NULL;
+    }
+}
+
+static uint64_t RunConnectTest(nlTestSuite * testSuite, const char * const peerAddrStrs[], uint8_t peerAddrCount,
+                               ConnectTestContext & testContext)
+{
+    IPAddress peerAddrs[WEAVE_CONFIG_CONNECT_IP_ADDRS];
+    WeaveConnection * con;
+    uint64_t startTimeMS;
+    WEAVE_ERROR err;
+
+    for (uint8_t i = 0; i < peerAddrCount; i++)
+        IPAddress::FromString(peerAddrStrs[i], peerAddrs[i]);
+
+    testContext.complete = false;
+    testContext.conErr   = WEAVE_NO_ERROR;
+    testContext.peerAddr = IPAddress::Any;
+
+    con = MessageLayer.NewConnection();
+    NL_TEST_ASSERT(testSuite, con != NULL);
+    if (con == NULL)
+        return 0;
+
+    con->AppState             = &testContext;
+    con->OnConnectionComplete = HandleConnectionComplete;
+    con->SetConnectTimeout(TEST_CONNECT_TIMEOUT_MILLISECS);
+
+    Done        = false;
+    startTimeMS = System::Layer::GetClock_MonotonicMS();
+
+    err = con->Connect(kNodeIdNotSpecified, kWeaveAuthMode_Unauthenticated, peerAddrs, peerAddrCount, TEST_LISTEN_PORT);
+    if (err != WEAVE_NO_ERROR)
+    {
+        testContext.complete = true;
+        testContext.conErr   = err;
+    }
+    else
+    {
+        ServiceNetworkUntilDone(TEST_DURATION_MILLISECS);
+    }
+
+    con->Close();
+
+    return System::Layer::GetClock_MonotonicMS() - startTimeMS;
+}
+
+static void HandleConnectionReceived(TCPEndPoint * listeningEndPoint, TCPEndPoint * conEndPoint, const IPAddress & peerAddr,
+                                     uint16_t peerPort)
+{
+    for (int i = 0; i < TEST_MAX_ACCEPTED_CONNECTIONS; i++)
+        if (sAcceptedEndPoints[i] == NULL)
+        {
+            sAcceptedEndPoints[i] = conEndPoint;
+            return;
+        }
+
+    conEndPoint->Free();
+}
+
+static void HandleConnectionComplete(WeaveConnection * con, WEAVE_ERROR conErr)
+{
+    ConnectTestContext * testContext = static_cast<ConnectTestContext *>(con->AppState);
+
+    testContext->complete = true;
+    testContext->conErr   = conErr;
+    testContext->peerAddr = con->PeerAddr;
+
+    Done = true;
+}
+
+static void ServiceNetworkUntilDone(uint32_t timeoutMS)
+{
+    uint64_t timeoutTimeMS = System::Layer::GetClock_MonotonicMS() + timeoutMS;
+    struct timeval sleepTime;
+    sleepTime.tv_sec = 0;
+    sleepTime.tv_usec = 10000;
+
+    while (!Done)
+    {
+        ServiceNetwork(sleepTime);
+
+        if (System::Layer::GetClock_MonotonicMS() >= timeoutTimeMS)
+        {
+            break;
+        }
+    }
+}
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>]\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gNetworkOptions,
+    &gWeaveNodeOptions,
+    &gFaultInjectionOptions,
+    &gHelpOptions,
+    NULL
+};
+
+int main(int argc, char *argv[])
+{
+    const nlTest ConnectionTests[] = {
+        NL_TEST_DEF("TestWeaveConnection:UnreachableAddress", TestWeaveConnection_UnreachableAddress),
+        NL_TEST_DEF("TestWeaveConnection:NoReachableAddress", TestWeaveConnection_NoReachableAddress),
+        NL_TEST_SENTINEL()
+    };
+
+    nlTestSuite ConnectionTestSuite = {
+        "WeaveConnection",
+        &ConnectionTests[0]
+    };
+
+    nl_test_set_output_style(OUTPUT_CSV);
+
+    InitToolCommon();
+
+    SetupFaultInjectionContext(argc, argv);
+
+    if (!ParseArgsFromEnvVar(TOOL_NAME, TOOL_OPTIONS_ENV_VAR_NAME, gToolOptionSets, NULL, true) ||
+        !ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets, NULL))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    InitSystemLayer();
+
+    InitNetwork();
+
+    InitWeaveStack(false, false);
+
+    // Run all tests in Suite
+
+    nlTestRunner(&ConnectionTestSuite, NULL);
+
+    ShutdownWeaveStack();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    return nlTestRunnerStats(&ConnectionTestSuite);
+}
+
+#else // !INET_CONFIG_ENABLE_IPV4
+
+int main(int argc, char *argv[])
+{
+    return 0;
+}
+
+#endif // !INET_CONFIG_ENABLE_IPV4
@@ -44,6 +44,9 @@ static void HandleConnectionReceived(WeaveMessageLayer *msgLayer, WeaveConnectio
 static void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr);
 static void HandleOutboundConnectionClosed(WeaveConnection *con, WEAVE_ERROR err);
 static void HandleInboundConnectionClosed(WeaveConnection *con, WEAVE_ERROR err);
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+static void PrintSendStats();
+#endif
 
 
 bool SendMsgs = false;
@@ -55,6 +58,16 @@ int32_t SendInterval = 1000000;
 int32_t SendLength = -1;
 bool UseTCP = false;
 bool UseSessionKey = false;
+int32_t BurstSize = 1;
+uint64_t FirstSendTime = 0;
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+bool CoalesceMessages = false;
+#endif
+
+enum
+{
+    kToolOpt_Coalesce = 1000,
+};
 
 static OptionDef gToolOptionDefs[] =
 {
@@ -63,6 +76,10 @@ static OptionDef gToolOptionDefs[] =
     { "length",             kArgumentRequired,  'l' },
     { "interval",           kArgumentRequired,  'i' },
     { "tcp",                kNoArgument,        't' },
+    { "burst",              kArgumentRequired,  'b' },
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    { "coalesce",           kNoArgument,        kToolOpt_Coalesce },
+#endif
 #if WEAVE_CONFIG_SECURITY_TEST_MODE
     { "use-session-key",    kNoArgument,        'S' },
 #endif
@@ -86,6 +103,19 @@ static const char *gToolOptionHelp =
     "  -t, --tcp\n"
     "       Use TCP to send weave messages. Defaults to using UDP.\n"
     "\n"
+    "  -b, --burst <num>\n"
+    "       Send the specified number of weave messages back to back at each send\n"
+    "       interval. Defaults to 1.\n"
+    "\n"
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    "  --coalesce\n"
+    "       Carry several weave messages in each UDP datagram when the peer accepts\n"
+    "       it. The sender assumes the destination does; the receiver learns it from\n"
+    "       the coalesced datagrams it receives, if their messages are encrypted with\n"
+    "       a session key. When sending, the number of UDP datagrams and bytes sent is\n"
+    "       reported at the end.\n"
+    "\n"
+#endif
 #if WEAVE_CONFIG_SECURITY_TEST_MODE
     "  -S, --use-session-key\n"
     "       Use a session key when encrypting weave messages.\n"
@@ -141,6 +171,15 @@ int main(int argc, char *argv[])
     MessageLayer.OnReceiveError = HandleReceiveError;
     MessageLayer.OnConnectionReceived = HandleConnectionReceived;
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    if (CoalesceMessages)
+    {
+        MessageLayer.SetMessageCoalescingEnabled(true);
+        if (SendMsgs && !UseTCP)
+            MessageLayer.AddCoalescingPeer(DestAddr);
+    }
+#endif
+
     PrintNodeConfig();
 
     if (!SendMsgs)
@@ -158,6 +197,11 @@ int main(int argc, char *argv[])
             DriveSending();
     }
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    if (SendMsgs && !UseTCP)
+        PrintSendStats();
+#endif
+
     ShutdownWeaveStack();
     ShutdownNetwork();
     ShutdownSystemLayer();
@@ -177,6 +221,18 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
     case 't':
         UseTCP = true;
         break;
+    case 'b':
+        if (!ParseInt(arg, BurstSize) || BurstSize < 1)
+        {
+            PrintArgError("%s: Invalid value specified for burst size: %s\n", progName, arg);
+            return false;
+        }
+        break;
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+    case kToolOpt_Coalesce:
+        CoalesceMessages = true;
+        break;
+#endif
     case 'c':
         if (!ParseInt(arg, MaxSendCount) || MaxSendCount < 0)
         {
@@ -245,6 +301,7 @@ void DriveSending()
     PacketBuffer*           msgBuf;
     WeaveMessageInfo        msgInfo;
     bool                    isTimeToSend;
+    int32_t                 burstCount;
 
     isTimeToSend = (Now() >= LastSendTime + SendInterval);
     if (!isTimeToSend)
@@ -294,45 +351,42 @@ void DriveSending()
 
         if (con->State != WeaveConnection::kState_Connected)
             return;
-
-        msgBuf = MakeWeaveMessage(&msgInfo);
-
-        if (UseSessionKey)
-        {
-            msgInfo.EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
-            msgInfo.KeyId = sTestDefaultTCPSessionKeyId;
-        }
-
-        sendCount++;
-        LastSendTime = Now();
-
-        res = con->SendMessage(&msgInfo, msgBuf);
-        if (res != WEAVE_NO_ERROR)
-        {
-            printf("WeaveConnection.SendMessage failed: %d\n", (int) res);
-            return;
-        }
     }
 
-    else
+    if (FirstSendTime == 0)
+        FirstSendTime = Now();
+    LastSendTime = Now();
+
+    for (burstCount = 0; burstCount < BurstSize && (MaxSendCount == -1 || sendCount < MaxSendCount); burstCount++)
     {
         msgBuf = MakeWeaveMessage(&msgInfo);
 
         if (UseSessionKey)
         {
             msgInfo.EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
-            msgInfo.KeyId = sTestDefaultUDPSessionKeyId;
+            msgInfo.KeyId = UseTCP ? sTestDefaultTCPSessionKeyId : sTestDefaultUDPSessionKeyId;
         }
 
         sendCount++;
-        LastSendTime = Now();
 
-        res = MessageLayer.SendMessage(DestAddr, &msgInfo, msgBuf);
-        if (res != WEAVE_NO_ERROR)
+        if (UseTCP)
+        {
+            res = con->SendMessage(&msgInfo, msgBuf);
+            if (res != WEAVE_NO_ERROR)
+            {
+                printf("WeaveConnection.SendMessage failed: %d\n", (int) res);
+                return;
+            }
+        }
+        else
         {
-            printf("WeaveMessageLayer.SendMessage failed: %d\n", (int) res);
+            res = MessageLayer.SendMessage(DestAddr, &msgInfo, msgBuf);
+            if (res != WEAVE_NO_ERROR)
+            {
+                printf("WeaveMessageLayer.SendMessage failed: %d\n", (int) res);
 
-            return;
+                return;
+            }
         }
     }
 
@@ -340,10 +394,34 @@ void DriveSending()
         char nodeAddrStr[64];
         DestAddr.ToString(nodeAddrStr, sizeof(nodeAddrStr));
 
-        printf("Weave message sent to node %" PRIX64 " (%s)\n", DestNodeId, nodeAddrStr);
+        if (burstCount == 1)
+            printf("Weave message sent to node %" PRIX64 " (%s)\n", DestNodeId, nodeAddrStr);
+        else
+            printf("%d Weave messages sent to node %" PRIX64 " (%s)\n", (int) burstCount, DestNodeId, nodeAddrStr);
     }
 }
 
+#if WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
+void PrintSendStats()
+{
+    const WeaveMessageLayer::CoalescingStats & stats = MessageLayer.GetCoalescingStats();
+    const uint32_t ipAndUdpHeaderSize = DestAddr.IsIPv4() ? 20 + 8 : 40 + 8;
+    uint64_t elapsedUS = Now() - FirstSendTime;
+
+    if (elapsedUS == 0)
+        elapsedUS = 1;
+
+    printf("%" PRIu32 " messages sent in %" PRIu32 " UDP datagrams (%" PRIu32 " messages coalesced)\n",
+           stats.MessagesSent, stats.DatagramsSent, stats.MessagesCoalesced);
+    printf("%" PRIu32 " UDP payload bytes, %" PRIu64 " bytes on the wire including IP and UDP headers\n",
+           stats.DatagramBytesSent, (uint64_t) stats.DatagramBytesSent + (uint64_t) stats.DatagramsSent * ipAndUdpHeaderSize);
+    printf("%.1f packets/sec, %.1f messages/sec over %" PRIu64 " ms\n",
+           stats.DatagramsSent * 1000000.0 / elapsedUS, stats.MessagesSent * 1000000.0 / elapsedUS, elapsedUS / 1000);
+}
+
+#endif // WEAVE_CONFIG_ENABLE_MESSAGE_COALESCING
+
 PacketBuffer *MakeWeaveMessage(WeaveMessageInfo *msgInfo)
 {
     PacketBuffer *msgBuf;
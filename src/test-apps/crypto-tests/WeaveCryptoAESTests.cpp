@@ -28,6 +28,7 @@
 
 #include <Weave/Support/crypto/AESBlockCipher.h>
 #include <Weave/Support/crypto/CTRMode.h>
+#include <Weave/Support/crypto/CCMMode.h>
 
 #include "WeaveCryptoTests.h"
 
@@ -311,6 +312,122 @@ bool AES128BlockCipher_DoTest(const uint8_t *key, const uint8_t *plainText, cons
     return true;
 }
 
+bool AES128CCMMode_DoTest(const uint8_t *key, const uint8_t *nonce, size_t nonceLen, const uint8_t *aad, size_t aadLen,
+                          const uint8_t *plainText, size_t plainTextLen, const uint8_t *expectedCipherText,
+                          const uint8_t *expectedTag, size_t tagLen)
+{
+    uint8_t cipherText[TEXT_BUFFER_LENGHT] = { 0 };
+    uint8_t decryptedPlainText[TEXT_BUFFER_LENGHT] = { 0 };
+    uint8_t tag[AES128CCMMode::kMaxTagLength];
+    bool res = true;
+
+    // Encrypt the payload in chunks of every possible size to exercise partial block handling.
+    for (size_t chunkSize = 1; chunkSize <= plainTextLen; chunkSize++)
+    {
+        AES128CCMMode aes128CCM;
+
+        aes128CCM.SetKey(key);
+        if (aes128CCM.Begin(nonce, nonceLen, aadLen, plainTextLen, tagLen) != WEAVE_NO_ERROR)
+            return false;
+        aes128CCM.AddAAD(aad, aadLen);
+
+        for (size_t chunkStart = 0; chunkStart < plainTextLen; chunkStart += chunkSize)
+        {
+            uint16_t inLen = plainTextLen - chunkStart;
+            if (inLen > chunkSize)
+                inLen = chunkSize;
+            aes128CCM.EncryptData(plainText + chunkStart, inLen, cipherText + chunkStart);
+        }
+
+        aes128CCM.Finish(tag);
+        aes128CCM.Reset();
+
+        if (memcmp(cipherText, expectedCipherText, plainTextLen) != 0 || memcmp(tag, expectedTag, tagLen) != 0)
+        {
+            res = false;
+            break;
+        }
+    }
+
+    {
+        AES128CCMMode aes128CCM;
+
+        aes128CCM.SetKey(key);
+        aes128CCM.Begin(nonce, nonceLen, aadLen, plainTextLen, tagLen);
+        aes128CCM.AddAAD(aad, aadLen);
+        aes128CCM.DecryptData(cipherText, plainTextLen, decryptedPlainText);
+        aes128CCM.Finish(tag);
+
+        if (memcmp(decryptedPlainText, plainText, plainTextLen) != 0 || memcmp(tag, expectedTag, tagLen) != 0)
+            res = false;
+    }
+
+    return res;
+}
+
+static void Check_AES128CCMMode_Test1(nlTestSuite *inSuite, void *inContext)
+{
+    bool res;
+
+    // This is Packet Vector #1 from RFC-3610.
+    static uint8_t key[]                = { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF };
+    static uint8_t nonce[]              = { 0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+    static uint8_t aad[]                = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+    static uint8_t plainText[]          = { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+                                            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E };
+    static uint8_t expectedCipherText[] = { 0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+                                            0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84 };
+    static uint8_t expectedTag[]        = { 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 };
+
+    res = AES128CCMMode_DoTest(key, nonce, sizeof(nonce), aad, sizeof(aad), plainText, sizeof(plainText),
+                               expectedCipherText, expectedTag, sizeof(expectedTag));
+
+    // Invalid ciphertext or tag generated by AES128CCMMode
+    NL_TEST_ASSERT(inSuite, res == true);
+}
+
+static void Check_AES128CCMMode_Test2(nlTestSuite *inSuite, void *inContext)
+{
+    bool res;
+
+    // This is Packet Vector #2 from RFC-3610.
+    static uint8_t key[]                = { 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF };
+    static uint8_t nonce[]              = { 0x00, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5 };
+    static uint8_t aad[]                = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 };
+    static uint8_t plainText[]          = { 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+                                            0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F };
+    static uint8_t expectedCipherText[] = { 0x72, 0xC9, 0x1A, 0x36, 0xE1, 0x35, 0xF8, 0xCF, 0x29, 0x1C, 0xA8, 0x94, 0x08, 0x5C, 0x87, 0xE3,
+                                            0xCC, 0x15, 0xC4, 0x39, 0xC9, 0xE4, 0x3A, 0x3B };
+    static uint8_t expectedTag[]        = { 0xA0, 0x91, 0xD5, 0x6E, 0x10, 0x40, 0x09, 0x16 };
+
+    res = AES128CCMMode_DoTest(key, nonce, sizeof(nonce), aad, sizeof(aad), plainText, sizeof(plainText),
+                               expectedCipherText, expectedTag, sizeof(expectedTag));
+
+    // Invalid ciphertext or tag generated by AES128CCMMode
+    NL_TEST_ASSERT(inSuite, res == true);
+}
+
+static void Check_AES128CCMMode_Test3(nlTestSuite *inSuite, void *inContext)
+{
+    AES128CCMMode aes128CCM;
+    static uint8_t key[16] = { 0 };
+    static uint8_t nonce[AES128CCMMode::kMaxNonceLength + 1] = { 0 };
+
+    aes128CCM.SetKey(key);
+
+    // Invalid nonce lengths must be rejected.
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, AES128CCMMode::kMinNonceLength - 1, 0, 1, 16) == WEAVE_ERROR_INVALID_ARGUMENT);
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, AES128CCMMode::kMaxNonceLength + 1, 0, 1, 16) == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // Odd or out of range tag lengths must be rejected.
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, 12, 0, 1, 5) == WEAVE_ERROR_INVALID_ARGUMENT);
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, 12, 0, 1, 18) == WEAVE_ERROR_INVALID_ARGUMENT);
+
+    // Payloads too long for the length field must be rejected.
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, 13, 0, 0x10000, 16) == WEAVE_ERROR_INVALID_ARGUMENT);
+    NL_TEST_ASSERT(inSuite, aes128CCM.Begin(nonce, 13, 0, 0xFFFF, 16) == WEAVE_NO_ERROR);
+}
+
 static void Check_AES128BlockCipher_Test1(nlTestSuite *inSuite, void *inContext)
 {
     bool res;
@@ -410,6 +527,9 @@ static const nlTest sTests[] = {
     NL_TEST_DEF("AES256CTRMode Test1",        Check_AES256CTRMode_Test1),
     NL_TEST_DEF("AES256CTRMode Test2",        Check_AES256CTRMode_Test2),
     NL_TEST_DEF("AES256CTRMode Test3",        Check_AES256CTRMode_Test3),
+    NL_TEST_DEF("AES128CCMMode Test1",        Check_AES128CCMMode_Test1),
+    NL_TEST_DEF("AES128CCMMode Test2",        Check_AES128CCMMode_Test2),
+    NL_TEST_DEF("AES128CCMMode Test3",        Check_AES128CCMMode_Test3),
     NL_TEST_DEF("AES128BlockCipher Test1",    Check_AES128BlockCipher_Test1),
     NL_TEST_DEF("AES256BlockCipher Test1",    Check_AES256BlockCipher_Test1),
     NL_TEST_SENTINEL()
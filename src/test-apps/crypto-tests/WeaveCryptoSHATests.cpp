@@ -303,12 +303,124 @@ static void Check_SHA1_Test3(nlTestSuite *inSuite, void *inContext)
     NL_TEST_ASSERT(inSuite, memcmp(hashBuf, LongMsg6056Result, SHA1::kHashLength) == 0);
 }
 
+static void Check_SHA256_Test1(nlTestSuite *inSuite, void *inContext)
+{
+    // Test vectors from FIPS 180-2, Appendix B.
+
+    static const char *testarray[3] =
+    {
+        TEST1,
+        TEST2,
+        TEST3
+    };
+
+    static long int repeatcount[3] = { 1, 1, 1000000 };
+
+    static uint8_t resultarray[][SHA256::kHashLength] =
+    {
+        { 0xBA, 0x78, 0x16, 0xBF, 0x8F, 0x01, 0xCF, 0xEA, 0x41, 0x41, 0x40, 0xDE, 0x5D, 0xAE, 0x22, 0x23,
+          0xB0, 0x03, 0x61, 0xA3, 0x96, 0x17, 0x7A, 0x9C, 0xB4, 0x10, 0xFF, 0x61, 0xF2, 0x00, 0x15, 0xAD },
+        { 0x24, 0x8D, 0x6A, 0x61, 0xD2, 0x06, 0x38, 0xB8, 0xE5, 0xC0, 0x26, 0x93, 0x0C, 0x3E, 0x60, 0x39,
+          0xA3, 0x3C, 0xE4, 0x59, 0x64, 0xFF, 0x21, 0x67, 0xF6, 0xEC, 0xED, 0xD4, 0x19, 0xDB, 0x06, 0xC1 },
+        { 0xCD, 0xC7, 0x6E, 0x5C, 0x99, 0x14, 0xFB, 0x92, 0x81, 0xA1, 0xC7, 0xE2, 0x84, 0xD7, 0x3E, 0x67,
+          0xF1, 0x80, 0x9A, 0x48, 0xA4, 0x97, 0x20, 0x0E, 0x04, 0x6D, 0x39, 0xCC, 0xC7, 0x11, 0x2C, 0xD0 }
+    };
+
+    nl::Weave::Platform::Security::SHA256 sha256;
+    uint8_t hashBuf[SHA256::kHashLength];
+
+    for (int j = 0; j < 3; ++j)
+    {
+        sha256.Begin();
+        for (int i = 0; i < repeatcount[j]; ++i)
+            sha256.AddData((const uint8_t *) testarray[j], strlen(testarray[j]));
+        sha256.Finish(hashBuf);
+        // Invalid SHA256 result
+        NL_TEST_ASSERT(inSuite, memcmp(hashBuf, resultarray[j], SHA256::kHashLength) == 0);
+    }
+}
+
+static void Check_SHA_HashMultiple(nlTestSuite *inSuite)
+{
+    // Hash a mix of message lengths around the block and padding boundaries, more than fit
+    // in a single multi-buffer pass, and compare against hashing each message separately.
+
+    enum
+    {
+        kMsgCount = 19
+    };
+
+    static const uint16_t msgLens[kMsgCount] = { 0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 128, 200, 447, 1000, 8, 72, 1304, 0, 6056 };
+
+    uint8_t msgData[6056];
+    const uint8_t *msgBufs[kMsgCount];
+    uint8_t sha1Hashes[kMsgCount * SHA1::kHashLength];
+    uint8_t sha256Hashes[kMsgCount * SHA256::kHashLength];
+    uint8_t hashBuf[SHA256::kHashLength];
+    nl::Weave::Platform::Security::SHA1 sha1;
+    nl::Weave::Platform::Security::SHA256 sha256;
+
+    for (size_t i = 0; i < sizeof(msgData); i++)
+        msgData[i] = (uint8_t) (i * 7 + (i >> 8));
+
+    for (int i = 0; i < kMsgCount; i++)
+        msgBufs[i] = msgData + (i * 13) % 64;
+
+    msgBufs[kMsgCount - 1] = msgData;
+
+    for (uint8_t count = 1; count <= kMsgCount; count += (count < 9) ? 1 : 9)
+    {
+        SHA1::HashMultiple(msgBufs, msgLens, count, sha1Hashes);
+        SHA256::HashMultiple(msgBufs, msgLens, count, sha256Hashes);
+
+        for (int i = 0; i < count; i++)
+        {
+            sha1.Begin();
+            sha1.AddData(msgBufs[i], msgLens[i]);
+            sha1.Finish(hashBuf);
+            // Invalid SHA1 multi-buffer result
+            NL_TEST_ASSERT(inSuite, memcmp(hashBuf, sha1Hashes + i * SHA1::kHashLength, SHA1::kHashLength) == 0);
+
+            sha256.Begin();
+            sha256.AddData(msgBufs[i], msgLens[i]);
+            sha256.Finish(hashBuf);
+            // Invalid SHA256 multi-buffer result
+            NL_TEST_ASSERT(inSuite, memcmp(hashBuf, sha256Hashes + i * SHA256::kHashLength, SHA256::kHashLength) == 0);
+        }
+    }
+}
+
+static void Check_SHA_Test4(nlTestSuite *inSuite, void *inContext)
+{
+#if WEAVE_CONFIG_HASH_IMPLEMENTATION_SHANI
+    // Repeat the known answer tests using each combination of processor features; the
+    // portable results serve as the reference for the multi-buffer comparison.
+    static const uint8_t accelModes[] = { kSHAAccel_None, kSHAAccel_SHANI, kSHAAccel_AVX2, kSHAAccel_All };
+
+    for (size_t i = 0; i < sizeof(accelModes); i++)
+    {
+        SetSHAAcceleration(accelModes[i]);
+
+        Check_SHA1_Test1(inSuite, inContext);
+        Check_SHA1_Test3(inSuite, inContext);
+        Check_SHA256_Test1(inSuite, inContext);
+        Check_SHA_HashMultiple(inSuite);
+    }
+
+    SetSHAAcceleration(kSHAAccel_All);
+#else
+    Check_SHA_HashMultiple(inSuite);
+#endif
+}
+
 static const nlTest sTests[] = {
     NL_TEST_DEF("SHA1 Test1",          Check_SHA1_Test1),
 #if WEAVE_WITH_OPENSSL
     NL_TEST_DEF("SHA1 Test2",          Check_SHA1_Test2),
 #endif
     NL_TEST_DEF("SHA1 Test3",          Check_SHA1_Test3),
+    NL_TEST_DEF("SHA256 Test1",        Check_SHA256_Test1),
+    NL_TEST_DEF("SHA Test4",           Check_SHA_Test4),
     NL_TEST_SENTINEL()
 };
 
@@ -138,6 +138,11 @@ class Weave(WeaveState):
         cmd_path = self.__get_cmd_path("weave-ping")
         return cmd_path
 
+    def getWeaveEchoLoadPath(self):
+        self.__check_weave_path()
+        cmd_path = self.__get_cmd_path("weave-echo-load")
+        return cmd_path
+
     def getWeaveKeyExportPath(self):
         self.__check_weave_path()
         cmd_path = self.__get_cmd_path("weave-key-export")
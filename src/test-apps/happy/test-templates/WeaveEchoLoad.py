@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+
+
+#
+#    Copyright (c) 2019 Google LLC.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#       Implements WeaveEchoLoad class that runs weave-echo-load between
+#       a client and a listener.
+#
+
+from __future__ import absolute_import
+from __future__ import print_function
+import sys
+import re
+
+from happy.ReturnMsg import ReturnMsg
+from happy.Utils import *
+from happy.HappyNode import HappyNode
+from happy.HappyNetwork import HappyNetwork
+
+from WeaveTest import WeaveTest
+
+
+options = {"client": None,
+           "server": None,
+           "udp": False,
+           "tcp": False,
+           "wrmp": False,
+           "count": None,
+           "concurrency": None,
+           "quiet": False,
+           "timeout": None,
+           "tap": None,
+           "client_process_tag": "WEAVE-ECHO-LOAD-CLIENT",
+           "server_process_tag": "WEAVE-ECHO-LOAD-SERVER",
+           "strace": True,
+           "use_persistent_storage": True,
+           "plaid_server_env": {},
+           "plaid_client_env": {}
+           }
+
+
+def option():
+    return options.copy()
+
+
+class WeaveEchoLoad(HappyNode, HappyNetwork, WeaveTest):
+    """
+    weave-echo-load [-h --help] [-q --quiet] [-o --origin <NAME>] [-s --server <NAME>]
+           [-c --count <NUMBER>] [--concurrency <NUMBER>] [-u --udp] [-t --tcp] [-w --wrmp]
+           [-p --tap <TAP_INTERFACE>]
+
+    The client and the server may be the same node, in which case the
+    requests go over the node's loopback.
+
+    command to send 100 Echo Requests over UDP, 8 at a time, from node01 to itself:
+        $ weave-echo-load -o node01 -s node01 -u -c 100 --concurrency 8
+
+    return:
+        the number of Echo Requests that got no response; 0 on success
+
+    """
+    def __init__(self, opts = options):
+        HappyNode.__init__(self)
+        HappyNetwork.__init__(self)
+        WeaveTest.__init__(self)
+        self.__dict__.update(opts)
+
+    def __pre_check(self):
+        # Make sure that fabric was created
+        if self.getFabricId() == None:
+            emsg = "Weave Fabric has not been created yet."
+            self.logger.error("[localhost] WeaveEchoLoad: %s" % (emsg))
+            sys.exit(1)
+
+        if self.count != None and self.count.isdigit():
+            self.count = int(float(self.count))
+        else:
+            self.count = 1
+
+        for node in [self.client, self.server]:
+            if node == None or not self._nodeExists(node):
+                emsg = "Missing or unknown weave-echo-load node %s." % (str(node))
+                self.logger.error("[localhost] WeaveEchoLoad: %s" % (emsg))
+                sys.exit(1)
+
+        self.client_ip = self.getNodeWeaveIPAddress(self.client)
+        self.client_weave_id = self.getWeaveNodeID(self.client)
+        self.server_ip = self.getNodeWeaveIPAddress(self.server)
+        self.server_weave_id = self.getWeaveNodeID(self.server)
+
+        if self.client_ip == None or self.server_ip == None:
+            emsg = "Could not find IP address of the client or server node."
+            self.logger.error("[localhost] WeaveEchoLoad: %s" % (emsg))
+            sys.exit(1)
+
+        if self.client_weave_id == None or self.server_weave_id == None:
+            emsg = "Could not find Weave node ID of the client or server node."
+            self.logger.error("[localhost] WeaveEchoLoad: %s" % (emsg))
+            sys.exit(1)
+
+        if self.client == self.server:
+            # Leave the node's Weave address to the listener and let the
+            # client bind to any address.
+            self.client_ip = None
+
+    def __transport_option(self):
+        if self.tcp:
+            return " --tcp"
+        elif self.wrmp:
+            return " --wrmp"
+        else:
+            return " --udp"
+
+    def __process_results(self, output):
+        # search for the summary e.g.
+        #   Sent 100 Echo Requests in 0.009s: 100 responses, 0 timeouts, 0 errors
+        missing = self.count
+
+        summaryRE = re.compile('Sent (\d+) Echo Requests in [\.\d]+s: (\d+) responses, (\d+) timeouts, (\d+) errors')
+        for line in output.split("\n"):
+            m = summaryRE.search(line)
+            if m:
+                missing = self.count - int(m.group(2))
+
+        if self.quiet == False:
+            print("weave-echo-load from node %s to node %s (%s) : " % \
+                (self.client, self.server, self.server_ip), end=' ')
+
+            if missing == 0:
+                print(hgreen("%d of %d responses" % (self.count, self.count)))
+            else:
+                print(hred("%d of %d responses" % (self.count - missing, self.count)))
+
+        return missing
+
+    def __start_server_side(self):
+        cmd = self.getWeaveEchoLoadPath()
+        if not cmd:
+            return
+
+        cmd += self.__transport_option()
+
+        if self.tap:
+            cmd += " --tap-device " + self.tap
+
+        self.start_simple_weave_server(cmd, self.server_ip,
+             self.server, self.server_process_tag, use_persistent_storage = self.use_persistent_storage, env=self.plaid_server_env)
+
+    def __start_client_side(self):
+        cmd = self.getWeaveEchoLoadPath()
+        if not cmd:
+            return
+
+        cmd += self.__transport_option()
+        cmd += " --count " + str(self.count)
+        cmd += " --report-interval 0"
+
+        if self.concurrency != None:
+            cmd += " --concurrency " + str(self.concurrency)
+
+        if self.tap:
+            cmd += " --tap-device " + self.tap
+
+        self.start_simple_weave_client(cmd, self.client_ip,
+            self.server_ip, self.server_weave_id,
+            self.client, self.client_process_tag, use_persistent_storage=self.use_persistent_storage, env=self.plaid_client_env)
+
+    def __wait_for_client(self):
+        self.wait_for_test_to_end(self.client, self.client_process_tag, timeout=self.timeout)
+
+    def __stop_server_side(self):
+        self.stop_weave_process(self.server, self.server_process_tag)
+
+    def run(self):
+        self.logger.debug("[localhost] WeaveEchoLoad: Run.")
+
+        self.__pre_check()
+
+        self.__start_server_side()
+
+        emsg = "WeaveEchoLoad %s should be running." % (self.server_process_tag)
+        self.logger.debug("[%s] WeaveEchoLoad: %s" % (self.server, emsg))
+
+        self.__start_client_side()
+        self.__wait_for_client()
+
+        client_output_value, client_output_data = \
+            self.get_test_output(self.client, self.client_process_tag, True)
+        client_strace_value, client_strace_data = \
+            self.get_test_strace(self.client, self.client_process_tag, True)
+
+        self.__stop_server_side()
+        server_output_value, server_output_data = \
+            self.get_test_output(self.server, self.server_process_tag, True)
+        server_strace_value, server_strace_data = \
+            self.get_test_strace(self.server, self.server_process_tag, True)
+
+        missing = self.__process_results(client_output_data)
+
+        data = {}
+        data["client_output"] = client_output_data
+        data["server_output"] = server_output_data
+        if self.strace:
+            data["client_strace"] = client_strace_data
+            data["server_strace"] = server_strace_data
+
+        self.logger.debug("[localhost] WeaveEchoLoad: Done.")
+
+        return ReturnMsg(missing, data)
@@ -52,6 +52,8 @@ options["service"] = None
 options["tap"] = None
 options["test_tag"] = ""
 options["iterations"] = 1
+options["cache_lifetime"] = None
+options["iteration_interval"] = None
 options["client_faults"] = None
 options["service_faults"] = None
 options["plaid"] = False
@@ -166,6 +168,9 @@ class WeaveServiceDir(HappyNode, HappyNetwork, WeaveTest):
                 result["connection_completed"] = True
                 break
 
+        if self.cache_lifetime:
+            result["directory_refreshed"] = "Service directory refresh check passed" in client_output
+
         final_result = reduce((lambda x, y: x and y), list(result.values()))
 
         print("weave-service-dir test from client %s to service %s: " % (self.client, self.service))
@@ -211,6 +216,12 @@ class WeaveServiceDir(HappyNode, HappyNetwork, WeaveTest):
 
         cmd += " --iterations " + str(self.iterations)
 
+        if self.cache_lifetime:
+            cmd += " --cache-lifetime " + str(self.cache_lifetime)
+
+        if self.iteration_interval:
+            cmd += " --iteration-interval " + str(self.iteration_interval)
+
         # if device is tap device, we need to provide tap interface and ipv4 gateway 
         if self.use_lwip:
             cmd += " --tap-device " + self.client_tap
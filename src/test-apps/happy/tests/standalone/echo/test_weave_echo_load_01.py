@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+#
+#       Copyright (c) 2019 Google LLC.
+#       All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#       Runs weave-echo-load against weave-echo-load --listen on the same
+#       node, over UDP, WRMP and TCP.
+#
+
+from __future__ import absolute_import
+from __future__ import print_function
+import os
+import unittest
+import set_test_path
+
+from happy.Utils import *
+import WeaveStateLoad
+import WeaveStateUnload
+import WeaveEchoLoad
+import WeaveUtilities
+
+class test_weave_echo_load_01(unittest.TestCase):
+    def setUp(self):
+        self.topology_file = os.path.dirname(os.path.realpath(__file__)) + \
+            "/../../../topologies/standalone/three_nodes_on_thread_weave.json"
+
+        self.show_strace = False
+
+        # setting Mesh for thread test
+        options = WeaveStateLoad.option()
+        options["quiet"] = True
+        options["json_file"] = self.topology_file
+
+        setup_network = WeaveStateLoad.WeaveStateLoad(options)
+        ret = setup_network.run()
+
+
+    def tearDown(self):
+        # cleaning up
+        options = WeaveStateUnload.option()
+        options["quiet"] = True
+        options["json_file"] = self.topology_file
+
+        teardown_network = WeaveStateUnload.WeaveStateUnload(options)
+        teardown_network.run()
+
+
+    @unittest.skipIf("WEAVE_SYSTEM_CONFIG_USE_LWIP" in list(os.environ.keys()) and os.environ["WEAVE_SYSTEM_CONFIG_USE_LWIP"] == "1",
+                     "each LwIP process has its own stack, so there is no loopback between them")
+    def test_weave_echo_load(self):
+        for transport in ["udp", "wrmp", "tcp"]:
+            value, data = self.__run_echo_load_test(transport)
+            self.__process_result(transport, value, data)
+
+
+    def __process_result(self, transport, value, data):
+        print("weave-echo-load over " + transport + " ", end=' ')
+
+        if value > 0:
+            print(hred("Failed"))
+        else:
+            print(hgreen("Passed"))
+
+        try:
+            self.assertTrue(value == 0, "%s Echo Requests got no response" % (str(value)))
+        except AssertionError as e:
+            print(str(e))
+            print("Captured experiment result:")
+
+            print("Client Output: ")
+            for line in data["client_output"].split("\n"):
+               print("\t" + line)
+
+            print("Server Output: ")
+            for line in data["server_output"].split("\n"):
+                print("\t" + line)
+
+            if self.show_strace == True:
+                print("Server Strace: ")
+                for line in data["server_strace"].split("\n"):
+                    print("\t" + line)
+
+                print("Client Strace: ")
+                for line in data["client_strace"].split("\n"):
+                    print("\t" + line)
+
+        if value > 0:
+            raise ValueError("weave-echo-load Failed")
+
+
+    def __run_echo_load_test(self, transport):
+        options = WeaveEchoLoad.option()
+        options["quiet"] = False
+        options["client"] = "node01"
+        options["server"] = "node01"
+        options[transport] = True
+        options["count"] = "200"
+        options["concurrency"] = "8"
+
+        weave_echo_load = WeaveEchoLoad.WeaveEchoLoad(options)
+        ret = weave_echo_load.run()
+
+        value = ret.Value()
+        data = ret.Data()
+
+        return value, data
+
+
+if __name__ == "__main__":
+    WeaveUtilities.run_unittest()
+
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+
+#
+#    Copyright (c) 2016-2017 Nest Labs, Inc.
+#    All rights reserved.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License");
+#    you may not use this file except in compliance with the License.
+#    You may obtain a copy of the License at
+#
+#        http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS,
+#    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#    See the License for the specific language governing permissions and
+#    limitations under the License.
+#
+
+#
+#    @file
+#       Run Weave Service Directory Profile between a client and service
+#       with a limited directory lifetime, checking that the directory is
+#       refreshed in the background between connects.
+#
+
+from __future__ import absolute_import
+from __future__ import print_function
+import os
+import unittest
+import set_test_path
+import subprocess
+
+from happy.Utils import *
+import WeaveServiceDir
+import WeaveUtilities
+
+
+class test_service_directory_02(unittest.TestCase):
+    def setUp(self):
+        if "WEAVE_SYSTEM_CONFIG_USE_LWIP" in list(os.environ.keys()) and os.environ["WEAVE_SYSTEM_CONFIG_USE_LWIP"] == "1":
+            self.use_lwip = True
+            topology_shell_script = os.path.dirname(os.path.realpath(__file__)) + \
+                "/../../../topologies/standalone/thread_wifi_on_tap_ap_service.sh"
+            # tap interface, ipv4 gateway and node addr should be provided if device is tap device
+            # both BorderRouter and cloud node are tap devices here
+            self.BR_tap = "wlan0"
+            self.BR_ipv4_gateway = "10.0.1.2"
+            self.BR_node_addr = "10.0.1.3"
+            self.cloud_tap = "eth0"
+            self.cloud_ipv4_gateway = "192.168.100.2"
+            self.cloud_node_addr = "192.168.100.3"
+        else:
+            self.use_lwip = False
+            topology_shell_script = os.path.dirname(os.path.realpath(__file__)) + \
+                "/../../../topologies/standalone/thread_wifi_ap_service.sh"
+        output = subprocess.call([topology_shell_script])
+
+    def tearDown(self):
+        # cleaning up
+        subprocess.call(["happy-state-delete"])
+
+    def test_service_directory_refresh(self):
+        options = WeaveServiceDir.option()
+        options["quiet"] = False
+        options["client"] = "BorderRouter"
+        options["service"] = "cloud"
+        options["use_lwip"] = self.use_lwip
+        if self.use_lwip:
+            options["client_tap"] = self.BR_tap
+            options["client_ipv4_gateway"] = self.BR_ipv4_gateway
+            options["client_node_addr"] = self.BR_node_addr
+            options["service_tap"] = self.cloud_tap
+            options["service_ipv4_gateway"] = self.cloud_ipv4_gateway
+            options["service_node_addr"] = self.cloud_node_addr
+        options["plaid"] = "auto"
+
+        # Connect every second to a directory that lives for 4 seconds: the
+        # directory is refreshed every 3 seconds and never expires, so only
+        # the first connect waits for a directory query.
+        options["iterations"] = 8
+        options["iteration_interval"] = 1000
+        options["cache_lifetime"] = 4000
+
+        service_dir = WeaveServiceDir.WeaveServiceDir(options)
+        ret = service_dir.run()
+
+        self.assertTrue(ret.Value(), "Service directory refresh test failed")
+
+
+if __name__ == "__main__":
+    WeaveUtilities.run_unittest()
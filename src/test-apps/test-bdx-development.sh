@@ -29,8 +29,8 @@ if [ -z ${builddir}]; then
     builddir="$srcdir"
 fi
 
-client_program="${builddir}/weave-bdx-client"
-server_program="${builddir}/weave-bdx-server"
+client_program="${builddir}/weave-bdx-client-development"
+server_program="${builddir}/weave-bdx-server-development"
 
 test_file_name="test-file-development.txt"
 test_file="${srcdir}/${test_file_name}"
@@ -38,19 +38,26 @@ rcvd_dir="/tmp"
 sent_file="${rcvd_dir}/${test_file_name}"
 rcvd_file="${rcvd_dir}/${test_file_name}.2"
 
+# Resume tests transfer a file large enough to be interrupted part way through
+resume_file_name="test-bdx-resume.bin"
+resume_src_dir="/tmp/bdx-resume-src"
+resume_rcvd_dir="/tmp/bdx-resume-rcvd"
+resume_file="${resume_src_dir}/${resume_file_name}"
+resume_kill_after_blocks=20
+
 # Proactively remove the received files and set up the directory
 mkdir -p /tmp
 rm $sent_file 2> /dev/null
 rm $rcvd_file 2> /dev/null
 
 # Start up the server in the background, suppressing its output for readability
-server_cmd="${server_program} 127.0.0.1"
+server_cmd="${server_program} --node-id 1 --node-addr 127.0.0.1 --resume"
 echo $server_cmd
 ${server_cmd} & >/dev/null
 sleep 1 # give server a chance to start
 
 # send the file from the client
-client_send_cmd="${client_program} 1@127.0.0.1 -o ${test_file_name} --upload"
+client_send_cmd="${client_program} 1@127.0.0.1 -r ${test_file} --upload"
 echo $client_send_cmd
 ${client_send_cmd} 
 echo "Client finished running"
@@ -72,9 +79,9 @@ sleep 1
 
 # If the test was successful, run the client in the other direction and verify
 if [ $use_curl_to_download_requested_file -eq 1 ]; then
-client_recv_cmd="${client_program} 1@127.0.0.1 -o file://${sent_file}"
+client_recv_cmd="${client_program} 1@127.0.0.1 -r file://${sent_file}"
 else
-client_recv_cmd="${client_program} 1@127.0.0.1 -o ${sent_file}"
+client_recv_cmd="${client_program} 1@127.0.0.1 -r ${sent_file}"
 fi
 
 echo $client_recv_cmd
@@ -89,6 +96,61 @@ if [ ${result} -eq 0 ]; then
     echo "Client received file successfully!"
 else
     echo "Client failed file receive, error code=${result}"
+    kill -9 $!
+    exit ${result}
+fi
+echo ""
+sleep 1
+
+# Interrupt an upload part way through, then resume it from the persisted cursor
+rm -rf ${resume_src_dir} ${resume_rcvd_dir}
+mkdir -p ${resume_src_dir} ${resume_rcvd_dir}
+dd if=/dev/urandom of=${resume_file} bs=1024 count=64 2> /dev/null
+
+kill -9 $!
+server_cmd="${server_program} --node-id 1 --node-addr 127.0.0.1 --resume -R ${resume_rcvd_dir}"
+echo $server_cmd
+${server_cmd} & >/dev/null
+sleep 1
+
+client_resume_cmd="${client_program} 1@127.0.0.1 -r ${resume_file} --upload --resume -R ${resume_src_dir}"
+echo "${client_resume_cmd} --kill-after-blocks ${resume_kill_after_blocks}"
+${client_resume_cmd} --kill-after-blocks ${resume_kill_after_blocks}
+sleep 1
+echo $client_resume_cmd
+${client_resume_cmd}
+echo "Client finished running"
+echo ""
+
+diff ${resume_file} ${resume_rcvd_dir}/${resume_file_name} > /dev/null
+result=${?}
+if [ ${result} -eq 0 ]; then
+    echo "Client resumed file send successfully!"
+else
+    echo "Client failed resumed file send, error code=${result}"
+    kill -9 $!
+    exit ${result}
+fi
+echo ""
+sleep 1
+
+# Interrupt a download part way through, then resume it from the persisted cursor
+rm -f ${resume_rcvd_dir}/${resume_file_name}
+client_resume_cmd="${client_program} 1@127.0.0.1 -r file://${resume_file} --resume -R ${resume_rcvd_dir}"
+echo "${client_resume_cmd} --kill-after-blocks ${resume_kill_after_blocks}"
+${client_resume_cmd} --kill-after-blocks ${resume_kill_after_blocks}
+sleep 1
+echo $client_resume_cmd
+${client_resume_cmd}
+echo "Client finished running"
+echo ""
+
+diff ${resume_file} ${resume_rcvd_dir}/${resume_file_name} > /dev/null
+result=${?}
+if [ ${result} -eq 0 ]; then
+    echo "Client resumed file receive successfully!"
+else
+    echo "Client failed resumed file receive, error code=${result}"
 fi
 
 # kill server
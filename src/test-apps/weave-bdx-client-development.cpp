@@ -70,6 +70,8 @@ static void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr);
 static void HandleConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr);
 static void HandleTransferTimeout(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
 static WEAVE_ERROR PrepareBinding();
+static WEAVE_ERROR StartBdxSend(BDXTransfer *aXfer);
+static WEAVE_ERROR StartBdxReceive(BDXTransfer *aXfer);
 static void HandleBindingEvent(void *const ctx, const Binding::EventType event, const Binding::InEventParam &inParam, Binding::OutEventParam &outParam);
 
 BdxClient BDXClient;
@@ -99,6 +101,12 @@ WeaveConnection *Con = NULL;
 nl::Weave::Binding *TheBinding = NULL;
 
 
+enum
+{
+    kToolOpt_Resume                                 = 1000,
+    kToolOpt_KillAfterBlocks                        = 1001,
+};
+
 static OptionDef gToolOptionDefs[] =
 {
     { "requested-file", kArgumentRequired, 'r' },
@@ -112,6 +120,8 @@ static OptionDef gToolOptionDefs[] =
     { "tcp",            kNoArgument,       't' },
     { "udp",            kNoArgument,       'u' },
     { "pretest",        kNoArgument,       'T' },
+    { "resume",         kNoArgument,       kToolOpt_Resume },
+    { "kill-after-blocks", kArgumentRequired, kToolOpt_KillAfterBlocks },
     { }
 };
 
@@ -151,6 +161,13 @@ static const char *gToolOptionHelp =
     "\n"
     "  -d, --debug\n"
     "       Enable debug messages.\n"
+    "\n"
+    "  --resume\n"
+    "       Persist a resume cursor while transferring and, if one was left behind by an\n"
+    "       interrupted transfer of the same file, continue from it. Overrides -s.\n"
+    "\n"
+    "  --kill-after-blocks <num>\n"
+    "       Exit abruptly after <num> blocks to simulate a lost connection. Used with --resume.\n"
     "\n";
 
 static OptionSet gToolOptions =
@@ -465,7 +482,7 @@ void StartUDPUpload()
             xfer->mFileDesignator = refFileName;
         }
 
-        err = BDXClient.InitBdxSend(*xfer, true, false, false, NULL);
+        err = StartBdxSend(xfer);
 
         // Set it back to what it was before so we can grab it when we're sending
         xfer->mFileDesignator = refRequestedFileName;
@@ -519,7 +536,7 @@ void StartUDPDownload()
     xfer->mStartOffset = StartOffset;
     xfer->mLength = FileLength;
 
-    err = BDXClient.InitBdxReceive(*xfer, true, false, false, NULL);
+    err = StartBdxReceive(xfer);
 
     if (err == WEAVE_NO_ERROR)
     {
@@ -536,6 +553,84 @@ void StartUDPDownload()
 #endif // WEAVE_CONFIG_BDX_CLIENT_RECEIVE_SUPPORT
 }
 
+/**
+ * Sends the SendInit for an upload.  With --resume, picks up from the cursor left
+ * behind by an interrupted upload of the same file and proves to the receiver that
+ * it is resuming the same data by sending the cursor hash in the SendInit metadata.
+ */
+WEAVE_ERROR StartBdxSend(BDXTransfer *aXfer)
+{
+#if WEAVE_CONFIG_BDX_CLIENT_SEND_SUPPORT
+    if (IsResumeEnabled())
+    {
+        if (LoadResumeCursor(RequestedFileName, RequestedFileName, aXfer->mResumeCursor))
+        {
+            aXfer->mStartOffset = aXfer->mResumeCursor.mOffset;
+            if (FileLength != 0)
+            {
+                aXfer->mLength = (FileLength > aXfer->mStartOffset) ? (FileLength - aXfer->mStartOffset) : 0;
+            }
+
+            return BDXClient.InitBdxSend(*aXfer, true, false, false, BDXResumeCursor::WriteMetaData, &aXfer->mResumeCursor);
+        }
+
+        // Nothing to resume, so the cursor has to cover the file from the start
+        aXfer->mStartOffset = 0;
+    }
+
+    return BDXClient.InitBdxSend(*aXfer, true, false, false, NULL);
+#else
+    return WEAVE_ERROR_NOT_IMPLEMENTED;
+#endif // WEAVE_CONFIG_BDX_CLIENT_SEND_SUPPORT
+}
+
+/**
+ * Sends the ReceiveInit for a download.  With --resume, requests only the data past
+ * the cursor left behind by an interrupted download of the same file, along with the
+ * cursor hash so the sender can check it is serving the same file.
+ */
+WEAVE_ERROR StartBdxReceive(BDXTransfer *aXfer)
+{
+#if WEAVE_CONFIG_BDX_CLIENT_RECEIVE_SUPPORT
+    char receivedFilePath[FILENAME_MAX];
+    uint8_t metaDataBuf[WEAVE_CONFIG_BDX_SEND_INIT_MAX_METADATA_BYTES];
+    uint16_t metaDataLen;
+    ReferencedTLVData metaData;
+    WEAVE_ERROR err;
+
+    if (IsResumeEnabled())
+    {
+        GetReceivedFilePath(RequestedFileName, receivedFilePath, sizeof(receivedFilePath));
+
+        if (LoadResumeCursor(RequestedFileName, receivedFilePath, aXfer->mResumeCursor))
+        {
+            err = aXfer->mResumeCursor.Encode(metaDataBuf, sizeof(metaDataBuf), metaDataLen);
+            if (err != WEAVE_NO_ERROR)
+            {
+                return err;
+            }
+
+            metaData.init(metaDataLen, sizeof(metaDataBuf), metaDataBuf);
+
+            aXfer->mStartOffset = aXfer->mResumeCursor.mOffset;
+            if (FileLength != 0)
+            {
+                aXfer->mLength = (FileLength > aXfer->mStartOffset) ? (FileLength - aXfer->mStartOffset) : 0;
+            }
+
+            return BDXClient.InitBdxReceive(*aXfer, true, false, false, &metaData);
+        }
+
+        // Nothing to resume, so the cursor has to cover the file from the start
+        aXfer->mStartOffset = 0;
+    }
+
+    return BDXClient.InitBdxReceive(*aXfer, true, false, false, NULL);
+#else
+    return WEAVE_ERROR_NOT_IMPLEMENTED;
+#endif // WEAVE_CONFIG_BDX_CLIENT_RECEIVE_SUPPORT
+}
+
 bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
 {
     switch (id)
@@ -583,6 +678,20 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
     case 'D':
         DestIPAddrStr = arg;
         break;
+    case kToolOpt_Resume:
+        SetResumeEnabled(true);
+        break;
+    case kToolOpt_KillAfterBlocks:
+    {
+        uint32_t numBlocks;
+        if (!ParseInt(arg, numBlocks) || numBlocks == 0)
+        {
+            PrintArgError("%s: Invalid value specified for kill after blocks: %s\n", progName, arg);
+            return false;
+        }
+        SetKillAfterBlocks(numBlocks);
+        break;
+    }
     default:
         PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
         return false;
@@ -721,7 +830,7 @@ void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr)
                     xfer->mFileDesignator = refFileName;
                 }
 
-                err = BDXClient.InitBdxSend(*xfer, true, false, false, NULL);
+                err = StartBdxSend(xfer);
 
                 // Set it back to what it was before so we can grab it when we're sending
                 xfer->mFileDesignator = refRequestedFileName;
@@ -748,7 +857,7 @@ void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr)
 
             if (err == WEAVE_NO_ERROR)
             {
-                err = BDXClient.InitBdxReceive(*xfer, true, false, false, NULL);
+                err = StartBdxReceive(xfer);
             }
 #endif // WEAVE_CONFIG_BDX_CLIENT_RECEIVE_SUPPORT
         }
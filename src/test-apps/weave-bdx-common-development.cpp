@@ -25,6 +25,7 @@
  * FILE API.
  */
 
+#define __STDC_FORMAT_MACROS
 
 #include <inttypes.h>
 #include <unistd.h>
@@ -71,6 +72,14 @@ char TempFileLocation[FILENAME_MAX] = "/tmp/";
 // bdx-received files go here
 char ReceivedFileLocation[FILENAME_MAX] = "/tmp/";
 
+// accept and persist resume cursors
+static bool ResumeEnabled = false;
+// simulate a lost connection after this many blocks (0 disables)
+static uint32_t KillAfterBlocks = 0;
+static uint32_t BlocksHandled = 0;
+
+#define BDX_RESUME_CURSOR_SUFFIX ".bdxcursor"
+
 BdxAppState *NewAppState()
 {
     BdxAppState *appState;
@@ -125,6 +134,178 @@ void SetTempLocation(const char *path)
     TempFileLocation[sizeof(TempFileLocation) - 1] = '\0';
 }
 
+void SetResumeEnabled(bool aEnabled)
+{
+    ResumeEnabled = aEnabled;
+}
+
+bool IsResumeEnabled(void)
+{
+    return ResumeEnabled;
+}
+
+void SetKillAfterBlocks(uint32_t aNumBlocks)
+{
+    KillAfterBlocks = aNumBlocks;
+    BlocksHandled = 0;
+}
+
+/** Builds the path under ReceivedFileLocation where a file requested with
+ * aFileDesignator is saved.  Only the last component of the designator is used.
+ */
+void GetReceivedFilePath(const char *aFileDesignator, char *aPath, size_t aPathSize)
+{
+    const char *filename = strrchr(aFileDesignator, '/');
+
+    if (filename == NULL)
+    {
+        filename = aFileDesignator;
+    }
+    else
+    {
+        filename++; //skip over '/'
+    }
+
+    snprintf(aPath, aPathSize, "%s%s", ReceivedFileLocation, filename);
+}
+
+static void GetResumeCursorPath(const char *aFileDesignator, char *aPath, size_t aPathSize)
+{
+    char receivedPath[FILENAME_MAX];
+
+    GetReceivedFilePath(aFileDesignator, receivedPath, sizeof(receivedPath));
+    snprintf(aPath, aPathSize, "%s" BDX_RESUME_CURSOR_SUFFIX, receivedPath);
+}
+
+/** Loads the cursor persisted by an interrupted transfer of aFileDesignator and
+ * checks it against the local copy of the data at aDataPath.  Returns false if
+ * there is nothing to resume or the local data no longer matches the cursor.
+ */
+bool LoadResumeCursor(const char *aFileDesignator, const char *aDataPath, BDXResumeCursor &aCursor)
+{
+    char cursorPath[FILENAME_MAX];
+    FILE *cursorFile = NULL;
+    FILE *dataFile = NULL;
+    bool retval = false;
+
+    GetResumeCursorPath(aFileDesignator, cursorPath, sizeof(cursorPath));
+
+    cursorFile = fopen(cursorPath, "r");
+    VerifyOrExit(cursorFile != NULL, );
+
+    VerifyOrExit(fscanf(cursorFile, "%" SCNu64 " %" SCNx32, &aCursor.mOffset, &aCursor.mHash) == 2,
+                 WeaveLogError(BDX, "Malformed resume cursor %s", cursorPath));
+    VerifyOrExit(aCursor.mOffset > 0, );
+
+    dataFile = fopen(aDataPath, "r");
+    VerifyOrExit(dataFile != NULL, WeaveLogError(BDX, "Cannot resume, %s is missing", aDataPath));
+
+    VerifyOrExit(VerifyResumeCursor(dataFile, aCursor),
+                 WeaveLogError(BDX, "Cannot resume, %s does not match its cursor", aDataPath));
+
+    WeaveLogProgress(BDX, "Resuming transfer of %s at offset %" PRIu64, aFileDesignator, aCursor.mOffset);
+    retval = true;
+
+exit:
+    if (cursorFile != NULL)
+    {
+        fclose(cursorFile);
+    }
+
+    if (dataFile != NULL)
+    {
+        fclose(dataFile);
+    }
+
+    if (!retval)
+    {
+        aCursor.Reset();
+    }
+
+    return retval;
+}
+
+/** Persists the cursor of an in-progress transfer.  The data the cursor covers must
+ * already be flushed to disk so that the cursor never runs ahead of the file.
+ */
+void StoreResumeCursor(const char *aFileDesignator, const BDXResumeCursor &aCursor)
+{
+    char cursorPath[FILENAME_MAX];
+    char tempPath[FILENAME_MAX + 4];
+    FILE *cursorFile;
+
+    GetResumeCursorPath(aFileDesignator, cursorPath, sizeof(cursorPath));
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", cursorPath);
+
+    // Write a temporary file and rename it over the cursor so that an
+    // interruption never leaves a truncated cursor behind.
+    cursorFile = fopen(tempPath, "w");
+    if (cursorFile == NULL)
+    {
+        WeaveLogError(BDX, "Error opening resume cursor %s", tempPath);
+        return;
+    }
+
+    fprintf(cursorFile, "%" PRIu64 " %08" PRIx32 "\n", aCursor.mOffset, aCursor.mHash);
+
+    if (fclose(cursorFile) != 0 || rename(tempPath, cursorPath) != 0)
+    {
+        WeaveLogError(BDX, "Error saving resume cursor %s", cursorPath);
+    }
+}
+
+void ClearResumeCursor(const char *aFileDesignator)
+{
+    char cursorPath[FILENAME_MAX];
+
+    GetResumeCursorPath(aFileDesignator, cursorPath, sizeof(cursorPath));
+    remove(cursorPath);
+}
+
+/** Recomputes the cursor over the beginning of aFile and compares it to aCursor.
+ * On success the file is left positioned at the cursor offset.
+ */
+bool VerifyResumeCursor(FILE *aFile, const BDXResumeCursor &aCursor)
+{
+    BDXResumeCursor computed;
+    uint8_t buffer[1024];
+    uint64_t remaining = aCursor.mOffset;
+    size_t nread;
+
+    computed.Reset();
+
+    if (fseek(aFile, 0, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    while (remaining > 0)
+    {
+        nread = fread(buffer, 1, (remaining < sizeof(buffer)) ? static_cast<size_t>(remaining) : sizeof(buffer), aFile);
+        if (nread == 0)
+        {
+            break;
+        }
+
+        computed.Update(buffer, nread);
+        remaining -= nread;
+    }
+
+    return (computed == aCursor) && (fseek(aFile, aCursor.mOffset, SEEK_SET) == 0);
+}
+
+/** Counts a block handled by the initiator of a transfer and, once --kill-after-blocks
+ * is reached, exits without finishing the transfer to simulate a lost connection.
+ */
+static void CheckKillAfterBlocks(void)
+{
+    if (KillAfterBlocks != 0 && ++BlocksHandled >= KillAfterBlocks)
+    {
+        printf("Simulating connection loss after %u blocks\n", BlocksHandled);
+        exit(EXIT_FAILURE);
+    }
+}
+
 /** Helper function for use by libcurl. */
 size_t WriteData(void *aPtr, size_t aSize, size_t aNmemb, FILE *aStream)
 {
@@ -281,10 +462,38 @@ uint16_t BdxSendInitHandler(BDXTransfer *aXfer, SendInit *aSendInitMsg)
     VerifyOrExit(mAppState != NULL, err = kStatus_ServerBadState);
     aXfer->mAppState = mAppState;
 
-    // The client already handles Setting transfer mode, max block size, and start sending
-    // We just need to open the file and allocate a buffer for reading blocks
-    mAppState->mFile = fopen(fileDesignator, "w");
-    VerifyOrExit(mAppState->mFile != NULL, err = kStatus_ServerBadState);
+    if (ResumeEnabled && aSendInitMsg->mStartOffset > 0)
+    {
+        // The sender is resuming an interrupted upload, so keep what we received so far
+        // provided it matches the data the sender has had acknowledged.
+        BDXResumeCursor cursor;
+
+        VerifyOrExit(cursor.Decode(aSendInitMsg->mMetaData, aSendInitMsg->mStartOffset) == WEAVE_NO_ERROR,
+                     err = kStatus_StartOffsetNotSupported);
+
+        mAppState->mFile = fopen(fileDesignator, "r+");
+        VerifyOrExit(mAppState->mFile != NULL, err = kStatus_StartOffsetNotSupported);
+
+        VerifyOrExit(VerifyResumeCursor(mAppState->mFile, cursor),
+                     err = kStatus_StartOffsetNotSupported;
+                     WeaveLogError(BDX, "Resume hash mismatch for %s", fileDesignator));
+
+        // Drop anything received past the acknowledged data
+        VerifyOrExit(ftruncate(fileno(mAppState->mFile), cursor.mOffset) == 0 &&
+                     fseek(mAppState->mFile, cursor.mOffset, SEEK_SET) == 0,
+                     err = kStatus_ServerBadState);
+
+        aXfer->mResumeCursor = cursor;
+
+        WeaveLogProgress(BDX, "Resuming upload of %s at offset %" PRIu64, fileDesignator, cursor.mOffset);
+    }
+    else
+    {
+        // The client already handles Setting transfer mode, max block size, and start sending
+        // We just need to open the file and allocate a buffer for reading blocks
+        mAppState->mFile = fopen(fileDesignator, "w");
+        VerifyOrExit(mAppState->mFile != NULL, err = kStatus_ServerBadState);
+    }
 
     //TODO: shouldn't be using dynamic memory allocation, but how to do that with dynamically negotiated maxBlockSize???
     //perhaps just go ahead and allocate our maximum size since we know the transfer won't go above that?
@@ -381,6 +590,20 @@ uint16_t BdxReceiveInitHandler(BDXTransfer *aXfer, ReceiveInit *aReceiveInit)
     VerifyOrExit(fileSize >= 0, err = kStatus_Unknown);
     VerifyOrExit(static_cast<uint64_t>(fileSize) >= aReceiveInit->mStartOffset, err = kStatus_StartOffsetNotSupported);
 
+    if (ResumeEnabled && aReceiveInit->mStartOffset > 0)
+    {
+        // If the receiver is resuming an interrupted download, make sure the data it
+        // already has is a prefix of this file before sending it the remainder.
+        BDXResumeCursor cursor;
+
+        if (cursor.Decode(aReceiveInit->mMetaData, aReceiveInit->mStartOffset) == WEAVE_NO_ERROR)
+        {
+            VerifyOrExit(VerifyResumeCursor(targetFile, cursor),
+                         err = kStatus_StartOffsetNotSupported;
+                         WeaveLogError(BDX, "Resume hash mismatch for %s", fileDesignator));
+        }
+    }
+
     retval = fseek(targetFile, aReceiveInit->mStartOffset, SEEK_SET);
     VerifyOrExit(retval == 0, err = kStatus_StartOffsetNotSupported);
 
@@ -441,6 +664,12 @@ WEAVE_ERROR BdxSendAcceptHandler(BDXTransfer *aXfer, SendAccept *aSendAcceptMsg)
         exit(-1);
     }
 
+    if (aXfer->mStartOffset > 0 && fseek(bdxState->mFile, aXfer->mStartOffset, SEEK_SET) != 0)
+    {
+        printf("Error seeking to offset %" PRIu64 " in file %s\n", aXfer->mStartOffset, aXfer->mFileDesignator.theString);
+        exit(-1);
+    }
+
     //TODO: shouldn't be using dynamic memory allocation, but how to do that with dynamically negotiated maxBlockSize???
     //perhaps just go ahead and allocate our maximum size since we know the transfer won't go above that?
     bdxState->mBuffer = (uint8_t*)malloc(aSendAcceptMsg->mMaxBlockSize);
@@ -467,30 +696,33 @@ WEAVE_ERROR BdxReceiveAcceptHandler(BDXTransfer *aXfer, ReceiveAccept *aReceiveA
     // NOTE: we expect mFileDesignator to be a URI, so need to chop off the protocol.
     // We store the file in the ReceivedFileLocation with a different name so that running
     // both client and server on the same machine won't overwrite the source file.
-    char * filename = strrchr(aXfer->mFileDesignator.theString, '/');
-    if (filename == NULL)
-    {
-        filename = aXfer->mFileDesignator.theString;
-    }
-    else
-    {
-        filename++; //skip over '/'
-    }
-
-    char fileDesignator[strlen(ReceivedFileLocation) + strlen(filename) + 1];
+    char fileDesignator[FILENAME_MAX];
 
-    memcpy(fileDesignator, ReceivedFileLocation, strlen(ReceivedFileLocation));
-    memcpy(fileDesignator + strlen(ReceivedFileLocation), filename, strlen(filename));
-
-    fileDesignator[strlen(ReceivedFileLocation) + strlen(filename)] = '\0';
+    GetReceivedFilePath(aXfer->mFileDesignator.theString, fileDesignator, sizeof(fileDesignator));
 
     WeaveLogDetail(BDX, "File being saved to: %s", fileDesignator);
 
-    bdxState->mFile = fopen(fileDesignator, "w");
-    if (!bdxState->mFile)
+    if (aXfer->mStartOffset > 0)
     {
-        WeaveLogDetail(BDX, "Error opening file %s\n", fileDesignator);
-        exit(-1);
+        // Resuming, so append to the data we already have.  Anything past the
+        // accepted start offset was never covered by the persisted cursor.
+        bdxState->mFile = fopen(fileDesignator, "r+");
+        if (!bdxState->mFile ||
+            ftruncate(fileno(bdxState->mFile), aXfer->mStartOffset) != 0 ||
+            fseek(bdxState->mFile, aXfer->mStartOffset, SEEK_SET) != 0)
+        {
+            WeaveLogDetail(BDX, "Error resuming file %s at offset %" PRIu64 "\n", fileDesignator, aXfer->mStartOffset);
+            exit(-1);
+        }
+    }
+    else
+    {
+        bdxState->mFile = fopen(fileDesignator, "w");
+        if (!bdxState->mFile)
+        {
+            WeaveLogDetail(BDX, "Error opening file %s\n", fileDesignator);
+            exit(-1);
+        }
     }
 
     return err;
@@ -527,10 +759,23 @@ void BdxGetBlockHandler(BDXTransfer *aXfer,
         blockSize = aXfer->mMaxBlockSize;
     }
 
+    if (ResumeEnabled && aXfer->mAmInitiator)
+    {
+        // BDX is lock-step, so every block sent so far has been acknowledged and
+        // the cursor covers exactly the data the receiver has.
+        StoreResumeCursor(aXfer->mFileDesignator.theString, aXfer->mResumeCursor);
+        CheckKillAfterBlocks();
+    }
+
     *aLength = fread(bdxState->mBuffer, 1, blockSize, bdxState->mFile);
     *aDataBlock = bdxState->mBuffer;
     aXfer->mBytesSent += blockSize;
 
+    if (ResumeEnabled && aXfer->mAmInitiator)
+    {
+        aXfer->mResumeCursor.Update(bdxState->mBuffer, *aLength);
+    }
+
     *aIsLastBlock = (*aLength < aXfer->mMaxBlockSize) ? true : false;
 }
 
@@ -548,6 +793,14 @@ void BdxPutBlockHandler(BDXTransfer *aXfer, uint64_t aLength, uint8_t *aDataBloc
         // Write bulk data to disk.
         int wtd = fwrite(aDataBlock, 1, aLength, bdxState->mFile);
         WeaveLogDetail(BDX, "PutBlockHandler wrote %d bytes to disk", wtd);
+
+        if (ResumeEnabled && aXfer->mAmInitiator)
+        {
+            // The protocol has already advanced mResumeCursor over this block
+            fflush(bdxState->mFile);
+            StoreResumeCursor(aXfer->mFileDesignator.theString, aXfer->mResumeCursor);
+            CheckKillAfterBlocks();
+        }
     }
 }
 
@@ -593,6 +846,12 @@ void BdxXferDoneHandler(BDXTransfer *aXfer)
 {
     WeaveLogDetail(BDX, "Transfer complete!");
     BdxAppState *appState = (BdxAppState *)(aXfer->mAppState);
+
+    if (ResumeEnabled && aXfer->mAmInitiator)
+    {
+        ClearResumeCursor(aXfer->mFileDesignator.theString);
+    }
+
     if (appState->mFile)
     {
         if (fclose(appState->mFile))
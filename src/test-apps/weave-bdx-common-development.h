@@ -58,6 +58,18 @@ void ResetAppStates();
 void SetReceivedFileLocation(const char *path);
 void SetTempLocation(const char *path);
 
+// Helpers for resuming interrupted transfers from a persisted BDXResumeCursor.
+// The cursor for a transfer is kept next to the received file, named after the
+// requested file with a ".bdxcursor" suffix.
+void SetResumeEnabled(bool aEnabled);
+bool IsResumeEnabled(void);
+void SetKillAfterBlocks(uint32_t aNumBlocks);
+void GetReceivedFilePath(const char *aFileDesignator, char *aPath, size_t aPathSize);
+bool LoadResumeCursor(const char *aFileDesignator, const char *aDataPath, BDXResumeCursor &aCursor);
+void StoreResumeCursor(const char *aFileDesignator, const BDXResumeCursor &aCursor);
+void ClearResumeCursor(const char *aFileDesignator);
+bool VerifyResumeCursor(FILE *aFile, const BDXResumeCursor &aCursor);
+
 // Helper functions
 size_t WriteData(void *aPtr, size_t aSize, size_t aNmemb, FILE *aStream);
 size_t ReadData(char *aPtr, size_t aSize, size_t aNemb, FILE *aStream);
@@ -74,10 +74,16 @@ BdxServer BDXServer;
 const char *SaveFileLocation = NULL;
 const char *TempFileLocation = NULL;
 
+enum
+{
+    kToolOpt_Resume                                 = 1000,
+};
+
 static OptionDef gToolOptionDefs[] =
 {
     { "received-loc", kArgumentRequired, 'R' },
     { "temp-loc",     kArgumentRequired, 'T' },
+    { "resume",       kNoArgument,       kToolOpt_Resume },
     { }
 };
 
@@ -87,6 +93,10 @@ static const char *gToolOptionHelp =
     "\n"
     "  -T, --temp-loc <path>\n"
     "       Location to keep temporary files.\n"
+    "\n"
+    "  --resume\n"
+    "       Accept requests to resume an interrupted transfer at a non-zero start offset.\n"
+    "       The data already transferred is checked against the resume hash in the request.\n"
     "\n";
 
 static OptionSet gToolOptions =
@@ -219,6 +229,9 @@ bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *n
         TempFileLocation = arg;
         SetTempLocation(TempFileLocation);
         break;
+    case kToolOpt_Resume:
+        SetResumeEnabled(true);
+        break;
     default:
         PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
         return false;
@@ -0,0 +1,1114 @@
+/*
+ *
+ *    Copyright (c) 2019 Google LLC.
+ *    All rights reserved.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/**
+ *    @file
+ *      This file implements a command line tool, weave-echo-load, that
+ *      generates load using the Weave Echo Profile.
+ *
+ *      Unlike weave-ping, which sends one Echo Request at a time, the
+ *      weave-echo-load tool keeps a configurable number of Echo exchanges
+ *      outstanding at once, optionally paced at a fixed request rate, over
+ *      UDP, WRMP or one or more TCP connections, with or without a secure
+ *      session. Response latencies are recorded in a LatencyHistogram, and
+ *      the tool periodically reports the throughput and the latency
+ *      percentiles seen in the last interval, followed by a summary for the
+ *      whole run.
+ *
+ *      When rate limited, latencies are measured from the time at which a
+ *      request was scheduled to be sent rather than the time at which it was
+ *      actually sent, so that requests held back because the maximum number
+ *      of exchanges are already outstanding are not left out of the
+ *      percentiles.
+ *
+ *      The tool can also act as a responder (--listen) that answers Echo
+ *      Requests without printing each one, and periodically reports the
+ *      rate at which it is serving them.
+ *
+ */
+
+#define __STDC_FORMAT_MACROS
+#define __STDC_LIMIT_MACROS
+
+#include <inttypes.h>
+#include <limits.h>
+#include <signal.h>
+
+#include "ToolCommon.h"
+#include "LatencyHistogram.h"
+#include <Weave/WeaveVersion.h>
+#include <Weave/Core/WeaveSecurityMgr.h>
+#include <Weave/Profiles/echo/WeaveEcho.h>
+#include <Weave/Profiles/security/WeaveSecurity.h>
+#include <Weave/Support/TimeUtils.h>
+#include <Weave/Support/WeaveFaultInjection.h>
+
+using nl::StatusReportStr;
+using namespace nl::Weave::Profiles::Security;
+
+#define TOOL_NAME "weave-echo-load"
+
+#define DEFAULT_ECHO_LENGTH             (32)
+#define DEFAULT_RESPONSE_TIMEOUT_MS     (5000)
+#define DEFAULT_REPORT_INTERVAL_SEC     (1)
+
+/**
+ *  The state of an outstanding Echo Request.
+ */
+struct EchoRequest
+{
+    ExchangeContext *ExchangeCtx;
+    uint64_t ScheduledTime;                     /**< The time at which the request was due to be sent, in microseconds. */
+};
+
+/**
+ *  The state of one of the TCP connections over which requests are sent.
+ */
+struct ClientConnection
+{
+    WeaveConnection *Con;
+    bool InProgress;
+    bool Established;
+};
+
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+static bool HandleNonOptionArgs(const char *progName, int argc, char *argv[]);
+static void DriveSending(void);
+static bool SendingComplete(uint64_t now);
+static WEAVE_ERROR SendEchoRequest(uint64_t scheduledTime);
+static void CompleteRequest(ExchangeContext *ec, bool success);
+static void HandleEchoResponse(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo, uint32_t profileId,
+                               uint8_t msgType, PacketBuffer *payload);
+static void HandleResponseTimeout(ExchangeContext *ec);
+static void HandleExchangeConnectionClosed(ExchangeContext *ec, WeaveConnection *con, WEAVE_ERROR conErr);
+static void HandleKeyError(ExchangeContext *ec, WEAVE_ERROR keyErr);
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+static void HandleSendError(ExchangeContext *ec, WEAVE_ERROR sendErr, void *msgCtxt);
+#endif
+static void HandleEchoRequestReceived(uint64_t nodeId, IPAddress nodeAddr, PacketBuffer *payload);
+static void HandleConnectionReceived(WeaveMessageLayer *msgLayer, WeaveConnection *con);
+static void StartClientConnections(void);
+static ClientConnection *GetNextConnection(void);
+static void StartSecureSession(void);
+static void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr);
+static void HandleConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr);
+static void HandleSecureSessionEstablished(WeaveSecurityManager *sm, WeaveConnection *con, void *reqState, uint16_t sessionKeyId, uint64_t peerNodeId, uint8_t encType);
+static void HandleSecureSessionError(WeaveSecurityManager *sm, WeaveConnection *con, void *reqState, WEAVE_ERROR localErr, uint64_t peerNodeId, StatusReport *statusReport);
+static void ParseDestAddress(void);
+static void PrintIntervalReport(uint64_t now);
+static void PrintSummary(uint64_t now);
+
+bool Listening = false;
+int32_t MaxRequestCount = -1;
+uint32_t DurationSec = 0;
+uint32_t Concurrency = 1;
+uint32_t RequestRate = 0;
+uint32_t ConnectionCount = 1;
+int32_t EchoLength = DEFAULT_ECHO_LENGTH;
+uint32_t ResponseTimeoutMs = DEFAULT_RESPONSE_TIMEOUT_MS;
+uint32_t ReportIntervalSec = DEFAULT_REPORT_INTERVAL_SEC;
+bool UseTCP = true;
+uint64_t DestNodeId;
+const char *DestAddr = NULL;
+IPAddress DestIPAddr; // only used for UDP
+uint16_t DestPort; // only used for UDP
+InterfaceId DestIntf = INET_NULL_INTERFACEID; // only used for UDP
+WeaveAuthMode AuthMode = kWeaveAuthMode_Unauthenticated;
+WeaveEchoServer EchoServer;
+
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+bool UseWRMP = false;
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+
+// Outstanding requests, and the TCP connections they are spread over.
+EchoRequest Requests[WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS];
+uint32_t OutstandingCount = 0;
+ClientConnection Connections[WEAVE_CONFIG_MAX_CONNECTIONS];
+uint32_t EstablishedConnectionCount = 0;
+uint32_t NextConnection = 0;
+
+// Security parameters used when sending over UDP.
+bool SecureSessionInProgress = false;
+bool SecureSessionEstablished = false;
+uint8_t EncryptionType = kWeaveEncryptionType_None;
+uint16_t KeyId = WeaveKeyId::kNone;
+
+// Timing.
+uint64_t StartTime = 0;
+uint64_t NextSendTime = 0;
+uint64_t LastReportTime = 0;
+bool LoadStarted = false;
+
+// Statistics.
+uint64_t RequestCount = 0;
+uint64_t ResponseCount = 0;
+uint64_t TimeoutCount = 0;
+uint64_t ErrorCount = 0;
+uint64_t IntervalResponseCount = 0;
+uint64_t ServedCount = 0;
+uint64_t IntervalServedCount = 0;
+LatencyHistogram TotalLatency;
+LatencyHistogram IntervalLatency;
+
+enum
+{
+    kToolOpt_Duration                               = 1000,
+    kToolOpt_Concurrency                            = 1001,
+    kToolOpt_Rate                                   = 1002,
+    kToolOpt_Connections                            = 1003,
+    kToolOpt_Timeout                                = 1004,
+    kToolOpt_ReportInterval                         = 1005,
+};
+
+static OptionDef gToolOptionDefs[] =
+{
+    { "listen",          kNoArgument,       'L' },
+    { "dest-addr",       kArgumentRequired, 'D' },
+    { "count",           kArgumentRequired, 'c' },
+    { "duration",        kArgumentRequired, kToolOpt_Duration },
+    { "concurrency",     kArgumentRequired, kToolOpt_Concurrency },
+    { "rate",            kArgumentRequired, kToolOpt_Rate },
+    { "connections",     kArgumentRequired, kToolOpt_Connections },
+    { "length",          kArgumentRequired, 'l' },
+    { "timeout",         kArgumentRequired, kToolOpt_Timeout },
+    { "report-interval", kArgumentRequired, kToolOpt_ReportInterval },
+    { "tcp",             kNoArgument,       't' },
+    { "udp",             kNoArgument,       'u' },
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    { "wrmp",            kNoArgument,       'w' },
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    { }
+};
+
+static const char *const gToolOptionHelp =
+    "  -D, --dest-addr <host>[:<port>][%<interface>]\n"
+    "       Send Echo Requests to a specific address rather than one\n"
+    "       derived from the destination node id. <host> can be a hostname,\n"
+    "       an IPv4 address or an IPv6 address. If <port> is specified, Echo\n"
+    "       requests will be sent to the specified port. If <interface> is\n"
+    "       specified, Echo Requests will be sent over the specified local\n"
+    "       interface.\n"
+    "\n"
+    "       NOTE: When specifying a port with an IPv6 address, the IPv6 address\n"
+    "       must be enclosed in brackets, e.g. [fd00:0:1:1::1]:11095.\n"
+    "\n"
+    "  -L, --listen\n"
+    "       Listen and respond to Echo Requests sent from another node.\n"
+    "\n"
+    "  -c, --count <num>\n"
+    "       Send the specified number of Echo Requests and exit once they have\n"
+    "       all completed.\n"
+    "\n"
+    "  --duration <sec>\n"
+    "       Send Echo Requests for the specified number of seconds and exit once\n"
+    "       they have all completed. If neither --count nor --duration is given,\n"
+    "       requests are sent until the tool is interrupted.\n"
+    "\n"
+    "  --concurrency <num>\n"
+    "       Maximum number of Echo Requests outstanding at once. Defaults to 1.\n"
+    "       Limited by the number of exchange contexts available.\n"
+    "\n"
+    "  --rate <num>\n"
+    "       Send the specified number of Echo Requests per second. If 0, which is\n"
+    "       the default, a new request is sent as soon as one completes.\n"
+    "\n"
+    "  --connections <num>\n"
+    "       Spread the Echo Requests over the specified number of TCP connections.\n"
+    "       Defaults to 1.\n"
+    "\n"
+    "  -l, --length <num>\n"
+    "       Send Echo Requests with the specified number of bytes in the payload.\n"
+    "       Defaults to 32.\n"
+    "\n"
+    "  --timeout <ms>\n"
+    "       Time to wait for an Echo Response before counting the request as\n"
+    "       failed. Defaults to 5000.\n"
+    "\n"
+    "  --report-interval <sec>\n"
+    "       Print the throughput and latencies every <sec> seconds. 0 disables\n"
+    "       the periodic reports. Defaults to 1.\n"
+    "\n"
+    "  -t, --tcp\n"
+    "       Use TCP to send Echo Requests. This is the default.\n"
+    "\n"
+    "  -u, --udp\n"
+    "       Use UDP to send Echo Requests.\n"
+    "\n"
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    "  -w, --wrmp\n"
+    "       Use UDP with Weave reliable messaging to send Echo requests.\n"
+    "\n"
+#endif
+    ;
+
+static OptionSet gToolOptions =
+{
+    HandleOption,
+    gToolOptionDefs,
+    "GENERAL OPTIONS",
+    gToolOptionHelp
+};
+
+static HelpOptions gHelpOptions(
+    TOOL_NAME,
+    "Usage: " TOOL_NAME " [<options...>] <dest-node-id>[@<dest-host>[:<dest-port>][%<interface>]]\n"
+    "       " TOOL_NAME " [<options...>] --listen\n",
+    WEAVE_VERSION_STRING "\n" WEAVE_TOOL_COPYRIGHT,
+    "Generate load using Weave Echo profile messages and report latencies.\n"
+    "Send SIGUSR1 to stop sending and print the summary for the run so far.\n"
+);
+
+static OptionSet *gToolOptionSets[] =
+{
+    &gToolOptions,
+    &gNetworkOptions,
+    &gWeaveNodeOptions,
+    &gWRMPOptions,
+    &gWeaveSecurityMode,
+    &gCASEOptions,
+    &gTAKEOptions,
+    &gGroupKeyEncOptions,
+    &gDeviceDescOptions,
+    &gFaultInjectionOptions,
+    &gHelpOptions,
+    &gGeneralSecurityOptions,
+    NULL
+};
+
+int main(int argc, char *argv[])
+{
+    WEAVE_ERROR err;
+
+    InitToolCommon();
+
+    SetupFaultInjectionContext(argc, argv);
+    SetSignalHandler(DoneOnHandleSIGUSR1);
+
+    if (argc == 1)
+    {
+        gHelpOptions.PrintBriefUsage(stderr);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!ParseArgsFromEnvVar(TOOL_NAME, TOOL_OPTIONS_ENV_VAR_NAME, gToolOptionSets, NULL, true) ||
+        !ParseArgs(TOOL_NAME, argc, argv, gToolOptionSets, HandleNonOptionArgs) ||
+        !ResolveWeaveNetworkOptions(TOOL_NAME, gWeaveNodeOptions, gNetworkOptions))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (WeaveSecurityMode::kGroupEnc == gWeaveSecurityMode.SecurityMode && gGroupKeyEncOptions.GetEncKeyId() == WeaveKeyId::kNone)
+    {
+        PrintArgError("%s: Please specify a group encryption key id using the --group-enc-... options.\n", TOOL_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!UseTCP && ConnectionCount != 1)
+    {
+        PrintArgError("%s: The --connections option can only be used with TCP.\n", TOOL_NAME);
+        exit(EXIT_FAILURE);
+    }
+
+    InitSystemLayer();
+
+    InitNetwork();
+
+    InitWeaveStack(Listening || !UseTCP, true);
+
+    // Arrange to get called for various activities in the message layer.
+    MessageLayer.OnConnectionReceived = HandleConnectionReceived;
+    MessageLayer.OnReceiveError = HandleMessageReceiveError;
+    MessageLayer.OnAcceptError = HandleAcceptConnectionError;
+
+    if (!Listening)
+    {
+        if (!UseTCP && (WeaveSecurityMode::kPASE == gWeaveSecurityMode.SecurityMode || WeaveSecurityMode::kTAKE == gWeaveSecurityMode.SecurityMode))
+        {
+            printf("PASE/TAKE not supported for UDP.\n");
+            exit(EXIT_FAILURE);
+        }
+
+#if !WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+        if (!UseTCP && WeaveSecurityMode::kCASE == gWeaveSecurityMode.SecurityMode)
+        {
+            printf("CASE not supported for UDP without WRMP support.\n");
+            exit(EXIT_FAILURE);
+        }
+#endif
+
+        if (WeaveSecurityMode::kPASE == gWeaveSecurityMode.SecurityMode)
+            AuthMode = kWeaveAuthMode_PASE_PairingCode;
+        else if (WeaveSecurityMode::kCASE == gWeaveSecurityMode.SecurityMode)
+            AuthMode = kWeaveAuthMode_CASE_AnyCert;
+        else if (WeaveSecurityMode::kTAKE == gWeaveSecurityMode.SecurityMode)
+            AuthMode = kWeaveAuthMode_TAKE_IdentificationKey;
+        else
+            AuthMode = kWeaveAuthMode_Unauthenticated;
+
+        if (WeaveSecurityMode::kGroupEnc == gWeaveSecurityMode.SecurityMode)
+        {
+            EncryptionType = kWeaveEncryptionType_AES128CTRSHA1;
+            KeyId = gGroupKeyEncOptions.GetEncKeyId();
+        }
+    }
+    else
+    {
+        // Initialize the EchoServer application.
+        err = EchoServer.Init(&ExchangeMgr);
+        if (err)
+        {
+            printf("WeaveEchoServer.Init failed: %s\n", ErrorStr(err));
+            exit(EXIT_FAILURE);
+        }
+
+        // Arrange to get a callback whenever an Echo Request is received.
+        EchoServer.OnEchoRequestReceived = HandleEchoRequestReceived;
+
+        SecurityMgr.OnSessionEstablished = HandleSecureSessionEstablished;
+        SecurityMgr.OnSessionError = HandleSecureSessionError;
+    }
+
+    PrintNodeConfig();
+
+    if (!Listening)
+    {
+        if (!UseTCP && DestAddr != NULL)
+            ParseDestAddress();
+
+        if (!UseTCP && DestIPAddr == IPAddress::Any)
+            DestIPAddr = FabricState.SelectNodeAddress(DestNodeId);
+
+        if (DestAddr == NULL)
+            printf("Sending Echo requests to node %" PRIX64 "\n", DestNodeId);
+        else
+            printf("Sending Echo requests to node %" PRIX64 " at %s\n", DestNodeId, DestAddr);
+
+        if (RequestRate != 0)
+            printf("Concurrency %" PRIu32 ", rate %" PRIu32 " requests/s, length %" PRIi32 "\n", Concurrency, RequestRate, EchoLength);
+        else
+            printf("Concurrency %" PRIu32 ", rate unlimited, length %" PRIi32 "\n", Concurrency, EchoLength);
+    }
+    else
+    {
+        printf("Listening for Echo requests...\n");
+    }
+
+    LastReportTime = Now();
+
+    while (!Done)
+    {
+        struct timeval sleepTime;
+        uint64_t now;
+
+        sleepTime.tv_sec = 0;
+        sleepTime.tv_usec = 100000;
+
+        // When rate limited, wake up in time to send the next request.
+        if (!Listening && LoadStarted && RequestRate != 0)
+        {
+            now = Now();
+            if (NextSendTime <= now)
+                sleepTime.tv_usec = 0;
+            else if (NextSendTime - now < (uint64_t) sleepTime.tv_usec)
+                sleepTime.tv_usec = (suseconds_t) (NextSendTime - now);
+        }
+
+        ServiceNetwork(sleepTime);
+
+        if (!Listening && !Done)
+            DriveSending();
+
+        now = Now();
+        if (ReportIntervalSec != 0 && now - LastReportTime >= (uint64_t) ReportIntervalSec * nl::kMicrosecondsPerSecond)
+            PrintIntervalReport(now);
+
+        fflush(stdout);
+    }
+
+    if (!Listening)
+    {
+        // Abort any exchanges still outstanding if the tool was interrupted.
+        for (uint32_t i = 0; i < Concurrency; i++)
+        {
+            if (Requests[i].ExchangeCtx != NULL)
+            {
+                Requests[i].ExchangeCtx->Abort();
+                Requests[i].ExchangeCtx = NULL;
+            }
+        }
+
+        for (uint32_t i = 0; i < ConnectionCount; i++)
+        {
+            if (Connections[i].Con != NULL)
+            {
+                Connections[i].Con->Close();
+                Connections[i].Con = NULL;
+            }
+        }
+    }
+
+    PrintSummary(Now());
+
+    EchoServer.Shutdown();
+
+    ShutdownWeaveStack();
+    ShutdownNetwork();
+    ShutdownSystemLayer();
+
+    return (!Listening && (TimeoutCount != 0 || ErrorCount != 0)) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    switch (id)
+    {
+    case 't':
+        UseTCP = true;
+        break;
+    case 'u':
+        UseTCP = false;
+        break;
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    case 'w':
+        UseTCP = false;
+        UseWRMP = true;
+        break;
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    case 'L':
+        Listening = true;
+        break;
+    case 'c':
+        if (!ParseInt(arg, MaxRequestCount) || MaxRequestCount < 0)
+        {
+            PrintArgError("%s: Invalid value specified for send count: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_Duration:
+        if (!ParseInt(arg, DurationSec))
+        {
+            PrintArgError("%s: Invalid value specified for duration: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_Concurrency:
+        if (!ParseInt(arg, Concurrency) || Concurrency == 0 || Concurrency > WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS)
+        {
+            PrintArgError("%s: Invalid value specified for concurrency (max %d): %s\n", progName,
+                          WEAVE_CONFIG_MAX_EXCHANGE_CONTEXTS, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_Rate:
+        if (!ParseInt(arg, RequestRate) || RequestRate > nl::kMicrosecondsPerSecond)
+        {
+            PrintArgError("%s: Invalid value specified for request rate: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_Connections:
+        if (!ParseInt(arg, ConnectionCount) || ConnectionCount == 0 || ConnectionCount > WEAVE_CONFIG_MAX_CONNECTIONS)
+        {
+            PrintArgError("%s: Invalid value specified for connection count (max %d): %s\n", progName,
+                          WEAVE_CONFIG_MAX_CONNECTIONS, arg);
+            return false;
+        }
+        break;
+    case 'l':
+        if (!ParseInt(arg, EchoLength) || EchoLength < 0 || EchoLength > UINT16_MAX)
+        {
+            PrintArgError("%s: Invalid value specified for data length: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_Timeout:
+        if (!ParseInt(arg, ResponseTimeoutMs) || ResponseTimeoutMs == 0)
+        {
+            PrintArgError("%s: Invalid value specified for response timeout: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_ReportInterval:
+        if (!ParseInt(arg, ReportIntervalSec))
+        {
+            PrintArgError("%s: Invalid value specified for report interval: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case 'D':
+        DestAddr = arg;
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}
+
+bool HandleNonOptionArgs(const char *progName, int argc, char *argv[])
+{
+    if (argc > 0)
+    {
+        if (argc > 1)
+        {
+            PrintArgError("%s: Unexpected argument: %s\n", progName, argv[1]);
+            return false;
+        }
+
+        if (Listening)
+        {
+            PrintArgError("%s: Please specify either a node id or --listen\n", progName);
+            return false;
+        }
+
+        const char *nodeId = argv[0];
+        char *p = (char *)strchr(nodeId, '@');
+        if (p != NULL)
+        {
+            *p = 0;
+            DestAddr = p+1;
+        }
+
+        if (!ParseNodeId(nodeId, DestNodeId))
+        {
+            PrintArgError("%s: Invalid value specified for destination node-id: %s\n", progName, nodeId);
+            return false;
+        }
+    }
+
+    else
+    {
+        if (!Listening)
+        {
+            PrintArgError("%s: Please specify either a node id or --listen\n", progName);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SendingComplete(uint64_t now)
+{
+    if (MaxRequestCount != -1 && RequestCount >= (uint64_t) MaxRequestCount)
+        return true;
+
+    if (DurationSec != 0 && LoadStarted && now >= StartTime + (uint64_t) DurationSec * nl::kMicrosecondsPerSecond)
+        return true;
+
+    return false;
+}
+
+void DriveSending(void)
+{
+    WEAVE_ERROR err;
+    uint64_t now = Now();
+
+    if (SendingComplete(now))
+    {
+        if (OutstandingCount == 0)
+            Done = true;
+        return;
+    }
+
+    // Establish all the connections or the secure session before starting the clock. Once started,
+    // keep sending over the remaining connections while any that closed are re-established.
+    if (UseTCP)
+    {
+        StartClientConnections();
+        if (EstablishedConnectionCount == 0 || (!LoadStarted && EstablishedConnectionCount < ConnectionCount))
+            return;
+    }
+    else if (WeaveSecurityMode::kCASE == gWeaveSecurityMode.SecurityMode)
+    {
+        if (!SecureSessionEstablished)
+        {
+            StartSecureSession();
+            return;
+        }
+    }
+
+    if (!LoadStarted)
+    {
+        LoadStarted = true;
+        StartTime = NextSendTime = LastReportTime = now;
+    }
+
+    while (OutstandingCount < Concurrency && !SendingComplete(now))
+    {
+        uint64_t scheduledTime = now;
+
+        if (RequestRate != 0)
+        {
+            if (NextSendTime > now)
+                break;
+
+            scheduledTime = NextSendTime;
+            NextSendTime += nl::kMicrosecondsPerSecond / RequestRate;
+        }
+
+        err = SendEchoRequest(scheduledTime);
+        if (err != WEAVE_NO_ERROR)
+        {
+            printf("Failed to send Echo Request: %s\n", ErrorStr(err));
+            ErrorCount++;
+
+            if (err == WEAVE_ERROR_KEY_NOT_FOUND)
+                SecureSessionEstablished = false;
+
+            // Let the network be serviced before trying again.
+            break;
+        }
+    }
+}
+
+WEAVE_ERROR SendEchoRequest(uint64_t scheduledTime)
+{
+    WEAVE_ERROR err = WEAVE_NO_ERROR;
+    EchoRequest *req = NULL;
+    ExchangeContext *ec = NULL;
+    PacketBuffer *payloadBuf = NULL;
+    uint16_t sendFlags = ExchangeContext::kSendFlag_ExpectResponse;
+    char *p;
+    int32_t len;
+
+    for (uint32_t i = 0; i < Concurrency; i++)
+    {
+        if (Requests[i].ExchangeCtx == NULL)
+        {
+            req = &Requests[i];
+            break;
+        }
+    }
+    VerifyOrExit(req != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    payloadBuf = PacketBuffer::New();
+    VerifyOrExit(payloadBuf != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+    p = (char *) payloadBuf->Start();
+    len = sprintf(p, "Echo Message %" PRIu64 "\n", RequestCount);
+
+    if (EchoLength > payloadBuf->MaxDataLength())
+        EchoLength = payloadBuf->MaxDataLength();
+
+    if (len > EchoLength)
+        len = EchoLength;
+    else
+        while (len < EchoLength)
+        {
+            int32_t copyLen = EchoLength - len;
+            if (copyLen > len)
+                copyLen = len;
+            memcpy(p + len, p, copyLen);
+            len += copyLen;
+        }
+    payloadBuf->SetDataLength((uint16_t) len);
+
+    if (UseTCP)
+    {
+        ClientConnection *clientCon = GetNextConnection();
+        VerifyOrExit(clientCon != NULL, err = WEAVE_ERROR_INCORRECT_STATE);
+
+        ec = ExchangeMgr.NewContext(clientCon->Con, req);
+        VerifyOrExit(ec != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        ec->EncryptionType = clientCon->Con->DefaultEncryptionType;
+        ec->KeyId = clientCon->Con->DefaultKeyId;
+    }
+    else
+    {
+        ec = ExchangeMgr.NewContext(DestNodeId, DestIPAddr, DestPort, DestIntf, req);
+        VerifyOrExit(ec != NULL, err = WEAVE_ERROR_NO_MEMORY);
+
+        ec->EncryptionType = EncryptionType;
+        ec->KeyId = KeyId;
+
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+        if (UseWRMP)
+        {
+            ec->mWRMPConfig = gWRMPOptions.GetWRMPConfig();
+            ec->OnSendError = HandleSendError;
+            sendFlags |= ExchangeContext::kSendFlag_RequestAck;
+        }
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+    }
+
+    ec->ResponseTimeout = ResponseTimeoutMs;
+    ec->OnMessageReceived = HandleEchoResponse;
+    ec->OnResponseTimeout = HandleResponseTimeout;
+    ec->OnConnectionClosed = HandleExchangeConnectionClosed;
+    ec->OnKeyError = HandleKeyError;
+
+    req->ExchangeCtx = ec;
+    req->ScheduledTime = scheduledTime;
+    OutstandingCount++;
+    RequestCount++;
+
+    err = ec->SendMessage(kWeaveProfile_Echo, kEchoMessageType_EchoRequest, payloadBuf, sendFlags);
+    payloadBuf = NULL;
+    if (err != WEAVE_NO_ERROR)
+    {
+        // The request is counted as failed by the caller.
+        req->ExchangeCtx = NULL;
+        OutstandingCount--;
+        ec->Abort();
+        ec = NULL;
+    }
+
+exit:
+    if (payloadBuf != NULL)
+        PacketBuffer::Free(payloadBuf);
+    if (err != WEAVE_NO_ERROR && ec != NULL)
+        ec->Abort();
+    return err;
+}
+
+void CompleteRequest(ExchangeContext *ec, bool success)
+{
+    EchoRequest *req = (EchoRequest *) ec->AppState;
+
+    VerifyOrDie(req != NULL && req->ExchangeCtx == ec);
+
+    if (success)
+    {
+        uint64_t latency = Now() - req->ScheduledTime;
+
+        if (latency > UINT32_MAX)
+            latency = UINT32_MAX;
+
+        TotalLatency.Record((uint32_t) latency);
+        IntervalLatency.Record((uint32_t) latency);
+        ResponseCount++;
+        IntervalResponseCount++;
+    }
+
+    // Abort rather than close; whether the request was acknowledged no longer matters.
+    ec->Abort();
+    req->ExchangeCtx = NULL;
+    OutstandingCount--;
+}
+
+void HandleEchoResponse(ExchangeContext *ec, const IPPacketInfo *pktInfo, const WeaveMessageInfo *msgInfo, uint32_t profileId,
+                        uint8_t msgType, PacketBuffer *payload)
+{
+    bool success = (profileId == kWeaveProfile_Echo && msgType == kEchoMessageType_EchoResponse);
+
+    PacketBuffer::Free(payload);
+
+    if (!success)
+        ErrorCount++;
+
+    CompleteRequest(ec, success);
+
+    // When not rate limited, replace the completed request straight away.
+    if (RequestRate == 0 && !Done)
+        DriveSending();
+}
+
+void HandleResponseTimeout(ExchangeContext *ec)
+{
+    TimeoutCount++;
+    CompleteRequest(ec, false);
+}
+
+void HandleExchangeConnectionClosed(ExchangeContext *ec, WeaveConnection *con, WEAVE_ERROR conErr)
+{
+    ErrorCount++;
+    CompleteRequest(ec, false);
+}
+
+void HandleKeyError(ExchangeContext *ec, WEAVE_ERROR keyErr)
+{
+    printf("Key error: %s\n", ErrorStr(keyErr));
+    ErrorCount++;
+    SecureSessionEstablished = false;
+    CompleteRequest(ec, false);
+}
+
+#if WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+void HandleSendError(ExchangeContext *ec, WEAVE_ERROR sendErr, void *msgCtxt)
+{
+    ErrorCount++;
+    CompleteRequest(ec, false);
+}
+#endif // WEAVE_CONFIG_ENABLE_RELIABLE_MESSAGING
+
+void HandleEchoRequestReceived(uint64_t nodeId, IPAddress nodeAddr, PacketBuffer *payload)
+{
+    ServedCount++;
+    IntervalServedCount++;
+}
+
+void HandleConnectionReceived(WeaveMessageLayer *msgLayer, WeaveConnection *con)
+{
+    char ipAddrStr[64];
+    con->PeerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+
+    printf("Connection received from node %" PRIX64 " (%s)\n", con->PeerNodeId, ipAddrStr);
+
+    con->OnConnectionClosed = HandleConnectionClosed;
+}
+
+void StartClientConnections(void)
+{
+    WEAVE_ERROR err;
+
+    for (uint32_t i = 0; i < ConnectionCount; i++)
+    {
+        ClientConnection &clientCon = Connections[i];
+
+        if (clientCon.InProgress || clientCon.Established)
+            continue;
+
+        clientCon.Con = MessageLayer.NewConnection();
+        if (clientCon.Con == NULL)
+        {
+            printf("WeaveConnection.Connect failed: %s\n", ErrorStr(WEAVE_ERROR_NO_MEMORY));
+            Done = true;
+            return;
+        }
+        clientCon.Con->AppState = &clientCon;
+        clientCon.Con->OnConnectionComplete = HandleConnectionComplete;
+        clientCon.Con->OnConnectionClosed = HandleConnectionClosed;
+
+        err = clientCon.Con->Connect(DestNodeId, AuthMode, DestAddr);
+        if (err != WEAVE_NO_ERROR)
+        {
+            printf("WeaveConnection.Connect failed: %s\n", ErrorStr(err));
+            clientCon.Con->Close();
+            clientCon.Con = NULL;
+            Done = true;
+            return;
+        }
+
+        clientCon.InProgress = true;
+    }
+}
+
+/**
+ *  Get the next established connection, so that requests are spread evenly over the connections.
+ */
+ClientConnection *GetNextConnection(void)
+{
+    for (uint32_t i = 0; i < ConnectionCount; i++)
+    {
+        ClientConnection *clientCon = &Connections[NextConnection];
+
+        NextConnection = (NextConnection + 1) % ConnectionCount;
+
+        if (clientCon->Established)
+            return clientCon;
+    }
+
+    return NULL;
+}
+
+void StartSecureSession(void)
+{
+    WEAVE_ERROR err;
+
+    // Do nothing if a secure session attempt is already in progress.
+    if (SecureSessionInProgress)
+        return;
+
+    // Set the InProgress flag to true now, because StartCASESession can invoke
+    // HandleSecureSessionError, which clears the InProgress flag.
+    SecureSessionInProgress = true;
+
+    err = SecurityMgr.StartCASESession(NULL, DestNodeId, DestIPAddr, WEAVE_PORT, AuthMode,
+                                       NULL, HandleSecureSessionEstablished, HandleSecureSessionError);
+    if (err != WEAVE_NO_ERROR)
+    {
+        printf("SecurityMgr.StartCASESession() failed: %s\n", ErrorStr(err));
+        SecureSessionInProgress = false;
+        Done = true;
+    }
+}
+
+void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr)
+{
+    ClientConnection *clientCon = (ClientConnection *) con->AppState;
+    char ipAddrStr[64];
+    con->PeerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+
+    clientCon->InProgress = false;
+
+    if (conErr != WEAVE_NO_ERROR)
+    {
+        printf("Connection FAILED to node %" PRIX64 " (%s): %s\n", con->PeerNodeId, ipAddrStr, ErrorStr(conErr));
+        con->Close();
+        clientCon->Con = NULL;
+        Done = true;
+        return;
+    }
+
+    printf("Connection established to node %" PRIX64 " (%s)\n", con->PeerNodeId, ipAddrStr);
+
+    clientCon->Established = true;
+    EstablishedConnectionCount++;
+}
+
+void HandleConnectionClosed(WeaveConnection *con, WEAVE_ERROR conErr)
+{
+    char ipAddrStr[64];
+    con->PeerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+
+    if (conErr == WEAVE_NO_ERROR)
+        printf("Connection closed to node %" PRIX64 " (%s)\n", con->PeerNodeId, ipAddrStr);
+    else
+        printf("Connection ABORTED to node %" PRIX64 " (%s): %s\n", con->PeerNodeId, ipAddrStr, ErrorStr(conErr));
+
+    if (!Listening)
+    {
+        ClientConnection *clientCon = (ClientConnection *) con->AppState;
+
+        // The connection is re-established the next time requests are sent.
+        if (clientCon->Established)
+            EstablishedConnectionCount--;
+        clientCon->Con = NULL;
+        clientCon->InProgress = false;
+        clientCon->Established = false;
+    }
+
+    con->Close();
+}
+
+void HandleSecureSessionEstablished(WeaveSecurityManager *sm, WeaveConnection *con, void *reqState, uint16_t sessionKeyId, uint64_t peerNodeId, uint8_t encType)
+{
+    char ipAddrStr[64];
+
+    if (con != NULL)
+    {
+        con->PeerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+    }
+    else
+    {
+        DestIPAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+
+        EncryptionType = encType;
+        KeyId = sessionKeyId;
+
+        SecureSessionEstablished = true;
+        SecureSessionInProgress = false;
+    }
+
+    printf("Secure session established with node %" PRIX64 " (%s)\n", peerNodeId, ipAddrStr);
+}
+
+void HandleSecureSessionError(WeaveSecurityManager *sm, WeaveConnection *con, void *reqState, WEAVE_ERROR localErr, uint64_t peerNodeId, StatusReport *statusReport)
+{
+    char ipAddrStr[64];
+
+    if (con != NULL)
+    {
+        con->PeerAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+    }
+    else
+    {
+        DestIPAddr.ToString(ipAddrStr, sizeof(ipAddrStr));
+
+        SecureSessionInProgress = false;
+        SecureSessionEstablished = false;
+    }
+
+    if (localErr == WEAVE_ERROR_STATUS_REPORT_RECEIVED && statusReport != NULL)
+        printf("FAILED to establish secure session to node %" PRIX64 " (%s): %s\n", peerNodeId, ipAddrStr, StatusReportStr(statusReport->mProfileId, statusReport->mStatusCode));
+    else
+        printf("FAILED to establish secure session to node %" PRIX64 " (%s): %s\n", peerNodeId, ipAddrStr, ErrorStr(localErr));
+
+    if (!Listening)
+        Done = true;
+}
+
+void ParseDestAddress(void)
+{
+    // NOTE: This function is only used when communicating over UDP.  Code in the WeaveConnection object handles
+    // parsing the destination node address for TCP connections.
+
+    WEAVE_ERROR err;
+    const char *addr;
+    uint16_t addrLen = 0;
+    const char *intfName;
+    uint16_t intfNameLen;
+
+    err = ParseHostPortAndInterface(DestAddr, strlen(DestAddr), addr, addrLen, DestPort, intfName, intfNameLen);
+    if (err != INET_NO_ERROR)
+    {
+        printf("Invalid destination address: %s\n", DestAddr);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!IPAddress::FromString(addr, addrLen, DestIPAddr))
+    {
+        printf("Invalid destination address: %s\n", DestAddr);
+        exit(EXIT_FAILURE);
+    }
+
+    if (intfName != NULL)
+    {
+        err = InterfaceNameToId(intfName, DestIntf);
+        if (err != INET_NO_ERROR)
+        {
+            printf("Invalid interface name: %s\n", intfName);
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+void PrintIntervalReport(uint64_t now)
+{
+    double elapsedSec = ((double) (now - LastReportTime)) / nl::kMicrosecondsPerSecond;
+    char title[64];
+
+    if (Listening)
+    {
+        printf("Served %" PRIu64 " Echo Requests (%.1f/s), %" PRIu64 " total\n", IntervalServedCount,
+               IntervalServedCount / elapsedSec, ServedCount);
+        IntervalServedCount = 0;
+    }
+    else if (LoadStarted)
+    {
+        snprintf(title, sizeof(title), "[%6.1fs] %.1f resp/s, %" PRIu32 " outstanding",
+                 ((double) (now - StartTime)) / nl::kMicrosecondsPerSecond, IntervalResponseCount / elapsedSec, OutstandingCount);
+        IntervalLatency.Print(stdout, title);
+        IntervalLatency.Reset();
+        IntervalResponseCount = 0;
+    }
+
+    LastReportTime = now;
+}
+
+void PrintSummary(uint64_t now)
+{
+    double elapsedSec;
+
+    if (Listening)
+    {
+        printf("Served %" PRIu64 " Echo Requests\n", ServedCount);
+        return;
+    }
+
+    elapsedSec = LoadStarted ? ((double) (now - StartTime)) / nl::kMicrosecondsPerSecond : 0;
+
+    printf("Sent %" PRIu64 " Echo Requests in %.3fs: %" PRIu64 " responses, %" PRIu64 " timeouts, %" PRIu64 " errors\n",
+           RequestCount, elapsedSec, ResponseCount, TimeoutCount, ErrorCount);
+    if (elapsedSec > 0)
+        printf("Throughput: %.1f responses/s\n", ResponseCount / elapsedSec);
+    TotalLatency.Print(stdout, "Latency");
+}
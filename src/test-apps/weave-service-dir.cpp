@@ -36,6 +36,8 @@
 static void HandleConnectionComplete(WeaveConnection *con, WEAVE_ERROR conErr);
 static void HandleServiceMgrStatus(void *appState, WEAVE_ERROR anError, StatusReport *aReport);
 static void HandleTestTimeout(System::Layer* aSystemLayer, void* aAppState, System::Error aError);
+static bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg);
+static bool CheckDirectoryStats(void);
 
 enum
 {
@@ -51,6 +53,39 @@ WeaveAuthMode AuthMode = kWeaveAuthMode_Unauthenticated;
 MockServiceDirServer MockSDServer;
 static bool sLastIterationFailed = false;
 static bool sTimerRunning = false;
+static uint32_t sCacheLifetime = 0;
+static uint32_t sIterationInterval = 0;
+
+enum
+{
+    kToolOpt_CacheLifetime          = 1000,
+    kToolOpt_IterationInterval,
+};
+
+static OptionDef gToolOptionDefs[] =
+{
+    { "cache-lifetime",     kArgumentRequired, kToolOpt_CacheLifetime },
+    { "iteration-interval", kArgumentRequired, kToolOpt_IterationInterval },
+    { }
+};
+
+static const char *gToolOptionHelp =
+    "  --cache-lifetime <ms>\n"
+    "       Expire the resolved service directory after <ms> milliseconds and\n"
+    "       refresh it in the background before then. Once all iterations are\n"
+    "       done, check that only the first connect waited for a directory query.\n"
+    "\n"
+    "  --iteration-interval <ms>\n"
+    "       Wait <ms> milliseconds between iterations.\n"
+    "\n";
+
+static OptionSet gToolOptions =
+{
+    HandleOption,
+    gToolOptionDefs,
+    "GENERAL OPTIONS",
+    gToolOptionHelp
+};
 
 static HelpOptions gHelpOptions(
     TOOL_NAME,
@@ -61,6 +96,7 @@ static HelpOptions gHelpOptions(
 
 static OptionSet *gToolOptionSets[] =
 {
+    &gToolOptions,
     &gNetworkOptions,
     &gWeaveNodeOptions,
     &gServiceDirClientOptions,
@@ -142,6 +178,10 @@ int main(int argc, char *argv[])
             exit(EXIT_FAILURE);
         }
 
+        if (sCacheLifetime != 0)
+        {
+            ServiceMgr.SetCacheLifetime(sCacheLifetime);
+        }
     }
 
     for (uint32_t iteration = 1; iteration <= gFaultInjectionOptions.TestIterations; iteration++)
@@ -185,10 +225,22 @@ int main(int argc, char *argv[])
 
             ServiceNetworkUntil(NULL, &waitTimeMs);
         }
+        else if (sIterationInterval != 0 && iteration < gFaultInjectionOptions.TestIterations)
+        {
+            // Keep servicing the network so background directory refreshes can run
+            uint32_t waitTimeMs = sIterationInterval;
+
+            ServiceNetworkUntil(NULL, &waitTimeMs);
+        }
 
         Done = false;
     }
 
+    if (Role == kRole_ServiceDirClient && !CheckDirectoryStats())
+    {
+        exit(EXIT_FAILURE);
+    }
+
     ServiceMgr.relocate(WEAVE_NO_ERROR);
     ServiceMgr.reset(WEAVE_NO_ERROR);
     ServiceMgr.unresolve(WEAVE_NO_ERROR);
@@ -245,3 +297,59 @@ void HandleServiceMgrStatus(void* anAppState, WEAVE_ERROR anError, StatusReport
 
     Done = true;
 }
+
+bool CheckDirectoryStats(void)
+{
+    ServiceDirectory::WeaveServiceManager::DirectoryStats stats;
+    bool ok = true;
+
+    ServiceMgr.GetDirectoryStats(stats);
+
+    printf("Service directory stats: lookups %" PRIu32 " indexed / %" PRIu32 " scanned, queries %" PRIu32
+           ", deferred connects %" PRIu32 ", refreshes %" PRIu32 " started / %" PRIu32 " completed / %" PRIu32
+           " failed, expirations %" PRIu32 "\n",
+           stats.IndexedLookups, stats.ScannedLookups, stats.DirectoryQueries, stats.DeferredConnects,
+           stats.RefreshesStarted, stats.RefreshesCompleted, stats.RefreshesFailed, stats.CacheExpirations);
+
+    // With background refresh, connects after the first one should never wait for the directory
+    if (sCacheLifetime != 0 && sIterationInterval != 0 && gFaultInjectionOptions.TestIterations > 1)
+    {
+        if (stats.DeferredConnects != 1 || stats.RefreshesCompleted == 0)
+        {
+            printf("Service directory refresh check FAILED\n");
+            ok = false;
+        }
+        else
+        {
+            printf("Service directory refresh check passed\n");
+        }
+    }
+
+    return ok;
+}
+
+bool HandleOption(const char *progName, OptionSet *optSet, int id, const char *name, const char *arg)
+{
+    switch (id)
+    {
+    case kToolOpt_CacheLifetime:
+        if (!ParseInt(arg, sCacheLifetime))
+        {
+            PrintArgError("%s: Invalid value specified for cache lifetime: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    case kToolOpt_IterationInterval:
+        if (!ParseInt(arg, sIterationInterval))
+        {
+            PrintArgError("%s: Invalid value specified for iteration interval: %s\n", progName, arg);
+            return false;
+        }
+        break;
+    default:
+        PrintArgError("%s: INTERNAL ERROR: Unhandled option: %s\n", progName, name);
+        return false;
+    }
+
+    return true;
+}